@@ -199,6 +199,10 @@ class Settings(CiBuildSettingsManager, UpdateSettingsManager, SetupSettingsManag
             "MdePkg/Library/BaseFdtLib/libfdt", False))
         rs.append(RequiredSubmodule(
             "MdePkg/Library/MipiSysTLib/mipisyst", False))
+        rs.append(RequiredSubmodule(
+            "MdeModulePkg/Library/ZstdCustomDecompressLib/zstd", False))
+        rs.append(RequiredSubmodule(
+            "BaseTools/Source/C/ZstdCompress/zstd", False))
         return rs
 
     def GetName(self):
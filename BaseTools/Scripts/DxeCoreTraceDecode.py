@@ -0,0 +1,233 @@
+##
+# Decode the DXE Core boot service trace table.
+#
+# The input is a raw copy of the gEdkiiDxeCoreTraceTableGuid configuration
+# table (DXE_CORE_TRACE_HEADER followed by the ring of DXE_CORE_TRACE_ENTRY
+# records, see MdeModulePkg/Include/Guid/DxeCoreTrace.h). The output is
+# either a per service summary or folded stacks that can be fed directly to
+# flamegraph.pl or speedscope.
+#
+# Callers are attributed to images using the "Loading driver at ..." lines of
+# a DEBUG build serial log when one is given.
+#
+# Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+##
+
+import argparse
+import bisect
+import re
+import struct
+import sys
+
+__prog__        = 'DxeCoreTraceDecode'
+__version__     = '%s Version %s' % (__prog__, '0.1')
+__copyright__   = 'Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.'
+__description__ = 'Decode the DXE Core boot service trace table.\n'
+
+TRACE_SIGNATURE = 0x52544344  # 'DCTR'
+TRACE_REVISION  = 1
+HEADER_FORMAT   = '<IHHIIQQQQ'
+ENTRY_FORMAT    = '<QQQQQQII'
+IN_PROGRESS     = 0xFFFFFFFFFFFFFFFF
+
+SERVICES = [
+    None,
+    'AllocatePages',
+    'FreePages',
+    'AllocatePool',
+    'FreePool',
+    'CreateEvent',
+    'SignalEvent',
+    'InstallProtocolInterface',
+    'ReinstallProtocolInterface',
+    'UninstallProtocolInterface',
+    'HandleProtocol',
+    'LocateHandle',
+    'LocateDevicePath',
+    'LoadImage',
+    'StartImage',
+    'ConnectController',
+    'DisconnectController',
+    'OpenProtocol',
+    'CloseProtocol',
+    'LocateHandleBuffer',
+    'LocateProtocol',
+    'CreateEventEx',
+]
+
+PROTOCOL_SERVICES = set([
+    'InstallProtocolInterface',
+    'ReinstallProtocolInterface',
+    'UninstallProtocolInterface',
+    'HandleProtocol',
+    'LocateHandle',
+    'LocateDevicePath',
+    'OpenProtocol',
+    'CloseProtocol',
+    'LocateHandleBuffer',
+    'LocateProtocol',
+])
+
+class TraceEntry:
+    def __init__(self, Fields):
+        (self.Sequence, self.Timestamp, self.Duration, self.Caller,
+         self.Argument, self.Status, self.Service, self.Depth) = Fields
+
+    @property
+    def ServiceName(self):
+        if self.Service < len(SERVICES) and SERVICES[self.Service] is not None:
+            return SERVICES[self.Service]
+        return 'Service%d' % self.Service
+
+class TraceTable:
+    def __init__(self, Data):
+        if len(Data) < struct.calcsize(HEADER_FORMAT):
+            raise ValueError('file is too small for a trace header')
+        (Signature, Revision, HeaderSize, EntrySize, EntryCount, self.Head,
+         self.Frequency, self.CounterStart, self.CounterEnd) = struct.unpack_from(HEADER_FORMAT, Data)
+        if Signature != TRACE_SIGNATURE:
+            raise ValueError('bad signature 0x%08x' % Signature)
+        if Revision != TRACE_REVISION:
+            raise ValueError('unsupported revision %d' % Revision)
+        if EntrySize < struct.calcsize(ENTRY_FORMAT):
+            raise ValueError('bad entry size %d' % EntrySize)
+        if len(Data) < HeaderSize + EntryCount * EntrySize:
+            raise ValueError('file holds fewer than %d records' % EntryCount)
+
+        self.EntryCount = EntryCount
+        self.Entries = []
+        for Index in range(min(EntryCount, self.Head)):
+            Entry = TraceEntry(struct.unpack_from(ENTRY_FORMAT, Data, HeaderSize + Index * EntrySize))
+            if Entry.Service != 0:
+                self.Entries.append(Entry)
+        self.Entries.sort(key=lambda Entry: Entry.Sequence)
+
+    @property
+    def Lost(self):
+        return max(0, self.Head - self.EntryCount)
+
+    def Microseconds(self, Ticks):
+        if self.Frequency == 0:
+            return 0
+        return Ticks * 1000000 // self.Frequency
+
+class ImageMap:
+    LOAD_PATTERN = re.compile(r'Loading (?:driver|PEIM) at 0x([0-9A-Fa-f]+) EntryPoint=0x[0-9A-Fa-f]+ (\S+?)(?:\.efi)?\s*$')
+
+    def __init__(self):
+        self.Bases = []
+        self.Names = []
+
+    def Load(self, LogFile):
+        Images = {}
+        with open(LogFile, 'r', errors='replace') as Log:
+            for Line in Log:
+                Match = self.LOAD_PATTERN.search(Line)
+                if Match is not None:
+                    Images[int(Match.group(1), 16)] = Match.group(2)
+        self.Bases = sorted(Images)
+        self.Names = [Images[Base] for Base in self.Bases]
+
+    def Symbolize(self, Address, Offsets):
+        Index = bisect.bisect_right(self.Bases, Address) - 1
+        if Index < 0:
+            return '0x%x' % Address
+        if Offsets:
+            return '%s+0x%x' % (self.Names[Index], Address - self.Bases[Index])
+        return self.Names[Index]
+
+def FormatGuidPrefix(Argument):
+    Data1, Data2, Data3 = struct.unpack('<IHH', struct.pack('<Q', Argument))
+    return '%08x-%04x-%04x' % (Data1, Data2, Data3)
+
+def FrameName(Entry, Images, Options):
+    Name = '%s:%s' % (Images.Symbolize(Entry.Caller, Options.offsets), Entry.ServiceName)
+    if Options.guids and Entry.ServiceName in PROTOCOL_SERVICES and Entry.Argument != 0:
+        Name += '(%s)' % FormatGuidPrefix(Entry.Argument)
+    return Name
+
+def FoldStacks(Table, Images, Options):
+    #
+    # Rebuild the call tree from the sequence order and the nesting depth. A
+    # call's self time is its duration minus the durations of the calls it
+    # made, which are the following records one level deeper.
+    #
+    Folded = {}
+    Stack = []
+    for Entry in Table.Entries:
+        del Stack[Entry.Depth:]
+        while len(Stack) < Entry.Depth:
+            Stack.append(['[lost]', None])
+        Frame = [FrameName(Entry, Images, Options), None]
+        if Entry.Duration != IN_PROGRESS:
+            Frame[1] = Entry.Duration
+        if Stack and Stack[-1][1] is not None and Frame[1] is not None:
+            Stack[-1][1] = max(0, Stack[-1][1] - Frame[1])
+        Stack.append(Frame)
+        Entry.Path = tuple(Name for Name, _ in Stack)
+        Entry.Frame = Frame
+
+    for Entry in Table.Entries:
+        if Entry.Frame[1] is not None:
+            Folded[Entry.Path] = Folded.get(Entry.Path, 0) + Entry.Frame[1]
+
+    for Path in sorted(Folded):
+        Micro = Table.Microseconds(Folded[Path])
+        if Micro > 0:
+            print('%s %d' % (';'.join(Path), Micro))
+
+def Summarize(Table, Images, Options):
+    Services = {}
+    Callers = {}
+    for Entry in Table.Entries:
+        if Entry.Duration == IN_PROGRESS:
+            continue
+        Count, Ticks = Services.get(Entry.ServiceName, (0, 0))
+        Services[Entry.ServiceName] = (Count + 1, Ticks + Entry.Duration)
+        Key = (Images.Symbolize(Entry.Caller, Options.offsets), Entry.ServiceName)
+        Count, Ticks = Callers.get(Key, (0, 0))
+        Callers[Key] = (Count + 1, Ticks + Entry.Duration)
+
+    print('%d calls recorded, %d decoded, %d overwritten, counter %d Hz' % (Table.Head, len(Table.Entries), Table.Lost, Table.Frequency))
+    print('')
+    print('%-28s %10s %14s' % ('Service', 'Calls', 'Time(us)'))
+    for Name, (Count, Ticks) in sorted(Services.items(), key=lambda Item: -Item[1][1]):
+        print('%-28s %10d %14d' % (Name, Count, Table.Microseconds(Ticks)))
+    print('')
+    print('%-40s %-28s %10s %14s' % ('Caller', 'Service', 'Calls', 'Time(us)'))
+    for (Caller, Name), (Count, Ticks) in sorted(Callers.items(), key=lambda Item: -Item[1][1])[:Options.top]:
+        print('%-40s %-28s %10d %14d' % (Caller, Name, Count, Table.Microseconds(Ticks)))
+
+def Main():
+    Parser = argparse.ArgumentParser(prog=__prog__, description=__description__ + __copyright__)
+    Parser.add_argument('--version', action='version', version=__version__)
+    Parser.add_argument('Input', help='raw copy of the DXE Core trace configuration table')
+    Parser.add_argument('-l', '--log', help='DEBUG serial log used to attribute callers to images')
+    Parser.add_argument('-s', '--summary', action='store_true', help='print per service and per caller totals instead of folded stacks')
+    Parser.add_argument('-o', '--offsets', action='store_true', help='keep the offset of the caller inside its image')
+    Parser.add_argument('-g', '--guids', action='store_true', help='append the protocol GUID prefix to protocol services')
+    Parser.add_argument('-t', '--top', type=int, default=30, help='number of callers listed by --summary (default 30)')
+    Options = Parser.parse_args()
+
+    with open(Options.Input, 'rb') as File:
+        Data = File.read()
+    try:
+        Table = TraceTable(Data)
+    except ValueError as Error:
+        print('%s: %s: %s' % (__prog__, Options.Input, Error), file=sys.stderr)
+        return 1
+
+    Images = ImageMap()
+    if Options.log:
+        Images.Load(Options.log)
+
+    if Options.summary:
+        Summarize(Table, Images, Options)
+    else:
+        FoldStacks(Table, Images, Options)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(Main())
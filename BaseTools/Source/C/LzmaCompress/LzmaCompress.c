@@ -24,9 +24,30 @@
 #include "Sdk/C/Bra.h"
 #include "CommonLib.h"
 #include "ParseInf.h"
+#include <Common/PiFirmwareFile.h>
 
 #define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
 
+//
+// Multi-stream output, see LZMA_MULTI_STREAM_HEADER in
+// MdeModulePkg/Include/Guid/LzmaDecompress.h. Each stream is a LZMA GUIDed
+// section, so the streams are kept small enough for EFI_GUID_DEFINED_SECTION.
+//
+#define LZMA_MULTI_STREAM_SIGNATURE ('L' | ('Z' << 8) | ('M' << 16) | ((UInt32)'S' << 24))
+#define LZMA_MULTI_STREAM_MAX_STREAM_SIZE 0x800000
+#define LZMA_MULTI_STREAM_ALIGN(Size) (((Size) + 3) & ~(size_t)3)
+
+typedef struct {
+  UInt32 Signature;
+  UInt32 StreamCount;
+  UInt32 StreamSize;
+  UInt32 DecodedSize;
+} LZMA_MULTI_STREAM_HEADER;
+
+static const EFI_GUID mLzmaCustomDecompressGuid = {
+  0xEE4E5898, 0x3914, 0x4259, { 0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF }
+};
+
 typedef enum {
   NoConverter,
   X86Converter,
@@ -44,10 +65,11 @@ static CONVERTER_TYPE mConType = NoConverter;
 
 UINT64 mDictionarySize = 28;
 UINT64 mCompressionMode = 2;
+UINT64 mStreamSize = 0;
 
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 2
+#define UTILITY_MINOR_VERSION 3
 #define INTEL_COPYRIGHT \
   "Copyright (c) 2009-2018, Intel Corporation. All rights reserved."
 void PrintHelp(char *buffer)
@@ -60,6 +82,8 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
+             "  --multi-stream StreamSize: split the data into independent LZMA streams\n"
+             "    of StreamSize bytes that can be decoded in parallel, maximum 0x800000\n"
              "  -v, --verbose: increase output messages\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
@@ -94,6 +118,95 @@ void PrintVersion(char *buffer)
   sprintf (buffer, "%s Version %d.%d %s ", UTILITY_NAME, UTILITY_MAJOR_VERSION, UTILITY_MINOR_VERSION, __BUILD_VERSION);
 }
 
+static SRes EncodeMultiStream(ISeqOutStream *outStream, const Byte *inBuffer, size_t inSize, CLzmaEncProps *props)
+{
+  SRes res = SZ_OK;
+  UInt32 streamCount;
+  UInt32 *streamOffset;
+  LZMA_MULTI_STREAM_HEADER *header;
+  EFI_GUID_DEFINED_SECTION *section;
+  Byte *outBuffer;
+  size_t outSize;
+  size_t outPos;
+  size_t outEnd;
+  size_t inPos;
+  size_t streamSize;
+  size_t sectionSize;
+  UInt32 i;
+  int j;
+
+  if (inSize > 0xFFFFFFFF)
+    return SZ_ERROR_PARAM;
+
+  streamCount = (UInt32)((inSize + mStreamSize - 1) / mStreamSize);
+  outPos = LZMA_MULTI_STREAM_ALIGN(sizeof(LZMA_MULTI_STREAM_HEADER) + streamCount * sizeof(UInt32));
+
+  // we allocate 105% of original size + 64KB and the section headers for each stream
+  outSize = outPos + inSize / 20 * 21 +
+            streamCount * LZMA_MULTI_STREAM_ALIGN(sizeof(EFI_GUID_DEFINED_SECTION) + LZMA_HEADER_SIZE + (1 << 16));
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (outBuffer == 0)
+    return SZ_ERROR_MEM;
+  memset(outBuffer, 0, outSize);
+
+  header = (LZMA_MULTI_STREAM_HEADER *)outBuffer;
+  header->Signature = LZMA_MULTI_STREAM_SIGNATURE;
+  header->StreamCount = streamCount;
+  header->StreamSize = (UInt32)mStreamSize;
+  header->DecodedSize = (UInt32)inSize;
+  streamOffset = (UInt32 *)(header + 1);
+
+  outEnd = outPos;
+  for (i = 0, inPos = 0; i < streamCount; i++, inPos += streamSize) {
+    size_t outSizeProcessed;
+    size_t outPropsSize = LZMA_PROPS_SIZE;
+    Byte *lzmaHeader;
+
+    streamSize = inSize - inPos;
+    if (streamSize > mStreamSize)
+      streamSize = (size_t)mStreamSize;
+
+    streamOffset[i] = (UInt32)outPos;
+    section = (EFI_GUID_DEFINED_SECTION *)(outBuffer + outPos);
+    lzmaHeader = (Byte *)(section + 1);
+    for (j = 0; j < 8; j++)
+      lzmaHeader[j + LZMA_PROPS_SIZE] = (Byte)((UInt64)streamSize >> (8 * j));
+
+    outSizeProcessed = outSize - outPos - sizeof(EFI_GUID_DEFINED_SECTION) - LZMA_HEADER_SIZE;
+    res = LzmaEncode(lzmaHeader + LZMA_HEADER_SIZE, &outSizeProcessed,
+        inBuffer + inPos, streamSize,
+        props, lzmaHeader, &outPropsSize, 0,
+        NULL, &g_Alloc, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    sectionSize = sizeof(EFI_GUID_DEFINED_SECTION) + LZMA_HEADER_SIZE + outSizeProcessed;
+    if (sectionSize > 0xFFFFFF) {
+      res = SZ_ERROR_PARAM;
+      goto Done;
+    }
+
+    section->CommonHeader.Size[0] = (UINT8)sectionSize;
+    section->CommonHeader.Size[1] = (UINT8)(sectionSize >> 8);
+    section->CommonHeader.Size[2] = (UINT8)(sectionSize >> 16);
+    section->CommonHeader.Type = EFI_SECTION_GUID_DEFINED;
+    memcpy(&section->SectionDefinitionGuid, &mLzmaCustomDecompressGuid, sizeof(EFI_GUID));
+    section->DataOffset = sizeof(EFI_GUID_DEFINED_SECTION);
+    section->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+
+    outEnd = outPos + sectionSize;
+    outPos = LZMA_MULTI_STREAM_ALIGN(outEnd);
+  }
+
+  if (outStream->Write(outStream, outBuffer, outEnd) != outEnd)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+
+  return res;
+}
+
 static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize, CLzmaEncProps *props)
 {
   SRes res;
@@ -116,6 +229,11 @@ static SRes Encode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
     goto Done;
   }
 
+  if (mStreamSize != 0) {
+    res = EncodeMultiStream(outStream, inBuffer, inSize, props);
+    goto Done;
+  }
+
   // we allocate 105% of original size + 64KB for output buffer
   outSize = (size_t)fileSize / 20 * 21 + (1 << 16);
   outBuffer = (Byte *)MyAlloc(outSize);
@@ -174,6 +292,76 @@ Done:
   return res;
 }
 
+static SRes DecodeMultiStream(ISeqOutStream *outStream, const Byte *inBuffer, size_t inSize)
+{
+  SRes res = SZ_OK;
+  const LZMA_MULTI_STREAM_HEADER *header;
+  const UInt32 *streamOffset;
+  const EFI_GUID_DEFINED_SECTION *section;
+  Byte *outBuffer = 0;
+  size_t outPos;
+  size_t sectionSize;
+  size_t streamSize;
+  size_t inSizePure;
+  ELzmaStatus status;
+  UInt32 i;
+
+  header = (const LZMA_MULTI_STREAM_HEADER *)inBuffer;
+  if (inSize < sizeof(LZMA_MULTI_STREAM_HEADER) ||
+      header->Signature != LZMA_MULTI_STREAM_SIGNATURE ||
+      header->StreamCount == 0 || header->StreamSize == 0 ||
+      header->StreamCount > (inSize - sizeof(LZMA_MULTI_STREAM_HEADER)) / sizeof(UInt32) ||
+      (UInt64)header->StreamSize * header->StreamCount < header->DecodedSize)
+    return SZ_ERROR_DATA;
+  streamOffset = (const UInt32 *)(header + 1);
+
+  outBuffer = (Byte *)MyAlloc(header->DecodedSize);
+  if (outBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  for (i = 0, outPos = 0; i < header->StreamCount; i++, outPos += streamSize) {
+    if (outPos >= header->DecodedSize ||
+        streamOffset[i] > inSize - sizeof(EFI_GUID_DEFINED_SECTION)) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+
+    section = (const EFI_GUID_DEFINED_SECTION *)(inBuffer + streamOffset[i]);
+    sectionSize = section->CommonHeader.Size[0] |
+                  (section->CommonHeader.Size[1] << 8) |
+                  (section->CommonHeader.Size[2] << 16);
+    if (sectionSize > inSize - streamOffset[i] ||
+        section->DataOffset + LZMA_HEADER_SIZE > sectionSize ||
+        memcmp(&section->SectionDefinitionGuid, &mLzmaCustomDecompressGuid, sizeof(EFI_GUID)) != 0) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+
+    streamSize = header->DecodedSize - outPos;
+    if (streamSize > header->StreamSize)
+      streamSize = header->StreamSize;
+    inSizePure = sectionSize - section->DataOffset - LZMA_HEADER_SIZE;
+    res = LzmaDecode(outBuffer + outPos, &streamSize,
+        (const Byte *)section + section->DataOffset + LZMA_HEADER_SIZE, &inSizePure,
+        (const Byte *)section + section->DataOffset, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+  }
+
+  if (outPos != header->DecodedSize) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  if (outStream->Write(outStream, outBuffer, outPos) != outPos)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+
+  return res;
+}
+
 static SRes Decode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
 {
   SRes res;
@@ -199,6 +387,11 @@ static SRes Decode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 file
     goto Done;
   }
 
+  if (mStreamSize != 0) {
+    res = DecodeMultiStream(outStream, inBuffer, inSize);
+    goto Done;
+  }
+
   for (i = 0; i < 8; i++)
     outSize64 += ((UInt64)inBuffer[LZMA_PROPS_SIZE + i]) << (i * 8);
 
@@ -272,6 +465,14 @@ int main2(int numArgs, const char *args[], char *rs)
       modeWasSet = True;
     } else if (strcmp(args[param], "--f86") == 0) {
       mConType = X86Converter;
+    } else if (strcmp(args[param], "--multi-stream") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      AsciiStringToUint64(args[++param], FALSE, &mStreamSize);
+      if ((mStreamSize == 0) || (mStreamSize > LZMA_MULTI_STREAM_MAX_STREAM_SIZE)) {
+        return PrintError(rs, kInvalidParamValMessage);
+      }
     } else if (strcmp(args[param], "-o") == 0 ||
                strcmp(args[param], "--output") == 0) {
       if (numArgs < (param + 2)) {
@@ -342,6 +543,10 @@ int main2(int numArgs, const char *args[], char *rs)
     return PrintUserError(rs);
   }
 
+  if ((mStreamSize != 0) && (mConType != NoConverter)) {
+    return PrintError(rs, "--f86 can not be used with --multi-stream");
+  }
+
   {
     size_t t4 = sizeof(UInt32);
     size_t t8 = sizeof(UInt64);
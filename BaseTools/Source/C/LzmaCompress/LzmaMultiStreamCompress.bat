@@ -0,0 +1,26 @@
+@REM @file
+@REM This script will exec LzmaCompress tool with --multi-stream option that splits
+@REM the data into independent LZMA streams which can be decompressed in parallel.
+@REM
+@REM Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+@REM SPDX-License-Identifier: BSD-2-Clause-Patent
+@REM
+
+@echo off
+@setlocal
+
+:Begin
+if "%1"=="" goto End
+if "%1"=="-e" (
+  set FLAG=--multi-stream 0x100000
+)
+if "%1"=="-d" (
+  set FLAG=--multi-stream 0x100000
+)
+set ARGS=%ARGS% %1
+shift
+goto Begin
+
+:End
+LzmaCompress %ARGS% %FLAG%
+@echo on
@@ -0,0 +1,389 @@
+/** @file
+  Zstandard Compress/Decompress tool (ZstdCompress)
+
+  The whole input file is compressed into a single Zstandard frame that stores
+  the content size, the firmware decoder needs it to size its output buffer,
+  and a content checksum the firmware decoder verifies.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ParseInf.h"
+#include "EfiUtilityMsgs.h"
+#include "CommonLib.h"
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+
+#define UTILITY_NAME            "ZstdCompress"
+#define UTILITY_MAJOR_VERSION   0
+#define UTILITY_MINOR_VERSION   1
+
+#define ZSTD_NULL               0
+#define ZSTD_ENCODE             1
+#define ZSTD_DECODE             2
+
+#define DEFAULT_COMPRESSION_LEVEL  19
+
+VOID
+Version (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Displays the standard utility information to SDTOUT
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  fprintf (stdout, "%s Version %d.%d (zstd %s) %s \n", UTILITY_NAME, UTILITY_MAJOR_VERSION, UTILITY_MINOR_VERSION, ZSTD_versionString (), __BUILD_VERSION);
+}
+
+VOID
+Usage (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Displays the utility usage syntax to STDOUT
+
+Arguments:
+
+  None
+
+Returns:
+
+  None
+
+--*/
+{
+  //
+  // Summary usage
+  //
+  fprintf (stdout, "Usage: ZstdCompress -e|-d [options] <input_file>\n\n");
+
+  //
+  // Copyright declaration
+  //
+  fprintf (stdout, "Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.\n\n");
+
+  //
+  // Details Option
+  //
+  fprintf (stdout, "optional arguments:\n");
+  fprintf (stdout, "  -h, --help            Show this help message and exit\n");
+  fprintf (stdout, "  --version             Show program's version number and exit\n");
+  fprintf (stdout, "  --debug [DEBUG]       Output DEBUG statements, where DEBUG_LEVEL is 0 (min)\n\
+                        - 9 (max)\n");
+  fprintf (stdout, "  -v, --verbose         Print informational statements\n");
+  fprintf (stdout, "  -e, --encode          Compress the input file\n");
+  fprintf (stdout, "  -d, --decode          Decompress the input file\n");
+  fprintf (stdout, "  -q LEVEL, --quality LEVEL\n\
+                        Compression level (1-%d), the default is %d\n", ZSTD_maxCLevel (), DEFAULT_COMPRESSION_LEVEL);
+  fprintf (stdout, "  -o OUTPUT_FILENAME, --output OUTPUT_FILENAME\n\
+                        Output file name\n");
+}
+
+int
+main (
+  int   argc,
+  CHAR8 *argv[]
+  )
+/*++
+
+Routine Description:
+
+  Main function.
+
+Arguments:
+
+  argc - Number of command line parameters.
+  argv - Array of pointers to parameter strings.
+
+Returns:
+  STATUS_SUCCESS - Utility exits successfully.
+  STATUS_ERROR   - Some error occurred during execution.
+
+--*/
+{
+  EFI_STATUS              Status;
+  CHAR8                   *OutputFileName;
+  CHAR8                   *InputFileName;
+  UINT8                   *FileBuffer;
+  UINT32                  FileSize;
+  UINT8                   *OutputBuffer;
+  size_t                  OutputSize;
+  unsigned long long      ContentSize;
+  UINT64                  LogLevel;
+  UINT64                  Level;
+  UINT8                   FileAction;
+  FILE                    *InFile;
+  FILE                    *OutFile;
+  ZSTD_CCtx               *Context;
+
+  //
+  // Init local variables
+  //
+  LogLevel       = 0;
+  Level          = DEFAULT_COMPRESSION_LEVEL;
+  InputFileName  = NULL;
+  OutputFileName = NULL;
+  FileAction     = ZSTD_NULL;
+  InFile         = NULL;
+  OutFile        = NULL;
+  FileBuffer     = NULL;
+  OutputBuffer   = NULL;
+  OutputSize     = 0;
+  Context        = NULL;
+
+  SetUtilityName (UTILITY_NAME);
+
+  if (argc == 1) {
+    Error (NULL, 0, 1001, "Missing options", "no options input");
+    Usage ();
+    return STATUS_ERROR;
+  }
+
+  //
+  // Parse command line
+  //
+  argc --;
+  argv ++;
+
+  if ((stricmp (argv[0], "-h") == 0) || (stricmp (argv[0], "--help") == 0)) {
+    Usage ();
+    return STATUS_SUCCESS;
+  }
+
+  if (stricmp (argv[0], "--version") == 0) {
+    Version ();
+    return STATUS_SUCCESS;
+  }
+
+  while (argc > 0) {
+    if ((stricmp (argv[0], "-o") == 0) || (stricmp (argv[0], "--output") == 0)) {
+      if (argv[1] == NULL || argv[1][0] == '-') {
+        Error (NULL, 0, 1003, "Invalid option value", "Output File name is missing for -o option");
+        goto Finish;
+      }
+      OutputFileName = argv[1];
+      argc -= 2;
+      argv += 2;
+      continue;
+    }
+
+    if ((stricmp (argv[0], "-e") == 0) || (stricmp (argv[0], "--encode") == 0)) {
+      FileAction     = ZSTD_ENCODE;
+      argc --;
+      argv ++;
+      continue;
+    }
+
+    if ((stricmp (argv[0], "-d") == 0) || (stricmp (argv[0], "--decode") == 0)) {
+      FileAction     = ZSTD_DECODE;
+      argc --;
+      argv ++;
+      continue;
+    }
+
+    if ((stricmp (argv[0], "-q") == 0) || (stricmp (argv[0], "--quality") == 0)) {
+      Status = AsciiStringToUint64 (argv[1], FALSE, &Level);
+      if (EFI_ERROR (Status) || (Level < 1) || (Level > (UINT64) ZSTD_maxCLevel ())) {
+        Error (NULL, 0, 1003, "Invalid option value", "%s = %s", argv[0], argv[1]);
+        goto Finish;
+      }
+      argc -= 2;
+      argv += 2;
+      continue;
+    }
+
+    if ((stricmp (argv[0], "-v") == 0) || (stricmp (argv[0], "--verbose") == 0)) {
+      SetPrintLevel (VERBOSE_LOG_LEVEL);
+      VerboseMsg ("Verbose output Mode Set!");
+      argc --;
+      argv ++;
+      continue;
+    }
+
+    if (stricmp (argv[0], "--debug") == 0) {
+      Status = AsciiStringToUint64 (argv[1], FALSE, &LogLevel);
+      if (EFI_ERROR (Status)) {
+        Error (NULL, 0, 1003, "Invalid option value", "%s = %s", argv[0], argv[1]);
+        goto Finish;
+      }
+      if (LogLevel > 9) {
+        Error (NULL, 0, 1003, "Invalid option value", "Debug Level range is 0-9, current input level is %d", (int) LogLevel);
+        goto Finish;
+      }
+      SetPrintLevel (LogLevel);
+      DebugMsg (NULL, 0, 9, "Debug Mode Set", "Debug Output Mode Level %s is set!", argv[1]);
+      argc -= 2;
+      argv += 2;
+      continue;
+    }
+
+    if (argv[0][0] == '-') {
+      Error (NULL, 0, 1000, "Unknown option", argv[0]);
+      goto Finish;
+    }
+
+    //
+    // Get Input file file name.
+    //
+    InputFileName = argv[0];
+    argc --;
+    argv ++;
+  }
+
+  VerboseMsg ("%s tool start.", UTILITY_NAME);
+
+  //
+  // Check Input parameters
+  //
+  if (FileAction == ZSTD_NULL) {
+    Error (NULL, 0, 1001, "Missing option", "either the encode or the decode option must be specified!");
+    return STATUS_ERROR;
+  }
+
+  if (InputFileName == NULL) {
+    Error (NULL, 0, 1001, "Missing option", "Input files are not specified");
+    goto Finish;
+  } else {
+    VerboseMsg ("Input file name is %s", InputFileName);
+  }
+
+  if (OutputFileName == NULL) {
+    Error (NULL, 0, 1001, "Missing option", "Output file are not specified");
+    goto Finish;
+  } else {
+    VerboseMsg ("Output file name is %s", OutputFileName);
+  }
+
+  //
+  // Open Input file and read file data.
+  //
+  InFile = fopen (LongFilePath (InputFileName), "rb");
+  if (InFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening file", InputFileName);
+    return STATUS_ERROR;
+  }
+
+  fseek (InFile, 0, SEEK_END);
+  FileSize = ftell (InFile);
+  fseek (InFile, 0, SEEK_SET);
+
+  FileBuffer = (UINT8 *) malloc (FileSize + 1);
+  if (FileBuffer == NULL) {
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+    fclose (InFile);
+    goto Finish;
+  }
+
+  if (fread (FileBuffer, 1, FileSize, InFile) != FileSize) {
+    Error (NULL, 0, 0004, "Error reading file", InputFileName);
+    fclose (InFile);
+    goto Finish;
+  }
+  fclose (InFile);
+  VerboseMsg ("the size of the input file is %u bytes", (unsigned) FileSize);
+
+  if (FileAction == ZSTD_ENCODE) {
+    //
+    // The firmware decoder sizes its output buffer from the content size in
+    // the frame header, and verifies the content checksum.
+    //
+    Context = ZSTD_createCCtx ();
+    if (Context == NULL) {
+      Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+      goto Finish;
+    }
+
+    OutputSize = ZSTD_compressBound (FileSize);
+    OutputBuffer = (UINT8 *) malloc (OutputSize);
+    if (OutputBuffer == NULL) {
+      Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+      goto Finish;
+    }
+
+    ZSTD_CCtx_setParameter (Context, ZSTD_c_compressionLevel, (int) Level);
+    ZSTD_CCtx_setParameter (Context, ZSTD_c_contentSizeFlag, 1);
+    ZSTD_CCtx_setParameter (Context, ZSTD_c_checksumFlag, 1);
+    OutputSize = ZSTD_compress2 (Context, OutputBuffer, OutputSize, FileBuffer, FileSize);
+    if (ZSTD_isError (OutputSize)) {
+      Error (NULL, 0, 3000, "Invalid", "compression failed, %s", ZSTD_getErrorName (OutputSize));
+      goto Finish;
+    }
+    VerboseMsg ("the size of the encoded file is %u bytes", (unsigned) OutputSize);
+  } else {
+    ContentSize = ZSTD_findDecompressedSize (FileBuffer, FileSize);
+    if ((ContentSize == ZSTD_CONTENTSIZE_ERROR) || (ContentSize == ZSTD_CONTENTSIZE_UNKNOWN) || (ContentSize > MAX_UINT32)) {
+      Error (NULL, 0, 3000, "Invalid", "Input file is not a Zstandard frame with a content size!");
+      goto Finish;
+    }
+
+    OutputBuffer = (UINT8 *) malloc ((size_t) ContentSize + 1);
+    if (OutputBuffer == NULL) {
+      Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+      goto Finish;
+    }
+
+    OutputSize = ZSTD_decompress (OutputBuffer, (size_t) ContentSize, FileBuffer, FileSize);
+    if (ZSTD_isError (OutputSize) || (OutputSize != ContentSize)) {
+      Error (NULL, 0, 3000, "Invalid", "decompression failed, %s", ZSTD_getErrorName (OutputSize));
+      goto Finish;
+    }
+    VerboseMsg ("the size of the decoded file is %u bytes", (unsigned) OutputSize);
+  }
+
+  //
+  // Done, write output file.
+  //
+  OutFile = fopen (LongFilePath (OutputFileName), "wb");
+  if (OutFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening file", OutputFileName);
+    goto Finish;
+  }
+
+  if (fwrite (OutputBuffer, 1, OutputSize, OutFile) != OutputSize) {
+    Error (NULL, 0, 0002, "Error writing file", OutputFileName);
+    goto Finish;
+  }
+
+Finish:
+  if (Context != NULL) {
+    ZSTD_freeCCtx (Context);
+  }
+
+  if (FileBuffer != NULL) {
+    free (FileBuffer);
+  }
+
+  if (OutputBuffer != NULL) {
+    free (OutputBuffer);
+  }
+
+  if (OutFile != NULL) {
+    fclose (OutFile);
+  }
+
+  VerboseMsg ("%s tool done with return code is 0x%x.", UTILITY_NAME, GetUtilityStatus ());
+
+  return GetUtilityStatus ();
+}
@@ -10,73 +10,89 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 /**
 
-  This function is used by the Data Cache.
+  Get the address of the cache page described by a cache tag.
 
-  When this function is called by write command, all entries in this range
-  are older than the contents in disk, so they are invalid; just mark them invalid.
+  @param  DiskCache             - The disk cache.
+  @param  CacheTag              - The Cache Tag of the cache page.
 
-  When this function is called by read command, if any entry in this range
-  is dirty, it means that the relative info directly read from media is older than
-  than the info in the cache; So need to update the relative info in the Buffer.
-
-  @param  Volume                - FAT file system volume.
-  @param  IoMode                - This function is called by read command or write command
-  @param  StartPageNo           - First PageNo to be checked in the cache.
-  @param  EndPageNo             - Last PageNo to be checked in the cache.
-  @param  Buffer                - The user buffer need to update. Only when doing the read command
-                          and there is dirty cache in the cache range, this parameter will be used.
+  @return The address of the cache page.
 
 **/
 STATIC
-VOID
-FatFlushDataCacheRange (
-  IN  FAT_VOLUME  *Volume,
-  IN  IO_MODE     IoMode,
-  IN  UINTN       StartPageNo,
-  IN  UINTN       EndPageNo,
-  OUT UINT8       *Buffer
+UINT8 *
+FatGetCachePageAddress (
+  IN DISK_CACHE  *DiskCache,
+  IN CACHE_TAG   *CacheTag
   )
 {
-  UINTN       PageNo;
-  UINTN       GroupNo;
-  UINTN       GroupMask;
-  UINTN       PageSize;
-  UINT8       PageAlignment;
-  DISK_CACHE  *DiskCache;
-  CACHE_TAG   *CacheTag;
-  UINT8       *BaseAddress;
+  return DiskCache->CacheBase + ((UINTN)(CacheTag - DiskCache->CacheTag) << DiskCache->PageAlignment);
+}
 
-  DiskCache     = &Volume->DiskCache[CacheData];
-  BaseAddress   = DiskCache->CacheBase;
-  GroupMask     = DiskCache->GroupMask;
-  PageAlignment = DiskCache->PageAlignment;
-  PageSize      = (UINTN)1 << PageAlignment;
+/**
+
+  Find the cache page holding PageNo in its cache group.
+
+  @param  DiskCache             - The disk cache.
+  @param  PageNo                - PageNo to match with the cache.
+
+  @return The Cache Tag of the cache page, or NULL if PageNo is not in the cache.
+
+**/
+STATIC
+CACHE_TAG *
+FatFindCacheTag (
+  IN DISK_CACHE  *DiskCache,
+  IN UINTN       PageNo
+  )
+{
+  CACHE_TAG  *CacheTag;
+  UINTN      Way;
 
-  for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
-    GroupNo  = PageNo & GroupMask;
-    CacheTag = &DiskCache->CacheTag[GroupNo];
+  CacheTag = &DiskCache->CacheTag[(PageNo & DiskCache->GroupMask) * DiskCache->GroupWays];
+  for (Way = 0; Way < DiskCache->GroupWays; Way++, CacheTag++) {
     if ((CacheTag->RealSize > 0) && (CacheTag->PageNo == PageNo)) {
-      //
-      // When reading data form disk directly, if some dirty data
-      // in cache is in this rang, this data in the Buffer need to
-      // be updated with the cache's dirty data.
-      //
-      if (IoMode == ReadDisk) {
-        if (CacheTag->Dirty) {
-          CopyMem (
-            Buffer + ((PageNo - StartPageNo) << PageAlignment),
-            BaseAddress + (GroupNo << PageAlignment),
-            PageSize
-            );
-        }
-      } else {
-        //
-        // Make all valid entries in this range invalid.
-        //
-        CacheTag->RealSize = 0;
-      }
+      return CacheTag;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+
+  Select the cache page to be replaced by PageNo: an unused cache page
+  of its cache group if any, otherwise the least recently used one.
+
+  @param  DiskCache             - The disk cache.
+  @param  PageNo                - PageNo to be loaded into the cache.
+
+  @return The Cache Tag of the cache page to be replaced.
+
+**/
+STATIC
+CACHE_TAG *
+FatSelectCacheTag (
+  IN DISK_CACHE  *DiskCache,
+  IN UINTN       PageNo
+  )
+{
+  CACHE_TAG  *CacheTag;
+  CACHE_TAG  *Victim;
+  UINTN      Way;
+
+  CacheTag = &DiskCache->CacheTag[(PageNo & DiskCache->GroupMask) * DiskCache->GroupWays];
+  Victim   = CacheTag;
+  for (Way = 0; Way < DiskCache->GroupWays; Way++, CacheTag++) {
+    if (CacheTag->RealSize == 0) {
+      return CacheTag;
+    }
+
+    if (CacheTag->LastAccess < Victim->LastAccess) {
+      Victim = CacheTag;
     }
   }
+
+  return Victim;
 }
 
 /**
@@ -104,7 +120,6 @@ FatExchangeCachePage (
   )
 {
   EFI_STATUS  Status;
-  UINTN       GroupNo;
   UINTN       PageNo;
   UINTN       WriteCount;
   UINTN       RealSize;
@@ -116,9 +131,8 @@ FatExchangeCachePage (
 
   DiskCache     = &Volume->DiskCache[DataType];
   PageNo        = CacheTag->PageNo;
-  GroupNo       = PageNo & DiskCache->GroupMask;
   PageAlignment = DiskCache->PageAlignment;
-  PageAddress   = DiskCache->CacheBase + (GroupNo << PageAlignment);
+  PageAddress   = FatGetCachePageAddress (DiskCache, CacheTag);
   EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
   RealSize      = CacheTag->RealSize;
   if (IoMode == ReadDisk) {
@@ -152,12 +166,202 @@ FatExchangeCachePage (
   return EFI_SUCCESS;
 }
 
+/**
+
+  This function is used by the Data Cache, before the data in a range of the
+  data region is accessed on the disk directly.
+
+  When this function is called by read command, the dirty cache pages in this
+  range are written back first, so the data read from the disk is up to date.
+
+  When this function is called by write command, the cache pages fully covered
+  by this range are older than the contents to be written, so they are marked
+  invalid; the cache pages partially covered by this range are updated with
+  the data to be written.
+
+  @param  Volume                - FAT file system volume.
+  @param  IoMode                - This function is called by read command or write command
+  @param  Offset                - The offset of the range in the data region.
+  @param  Length                - The length of the range.
+  @param  Buffer                - The data to be written. Only used by write command.
+
+  @retval EFI_SUCCESS           - The cache pages in the range were synchronized.
+  @return Others                - An error occurred when writing back a dirty cache page.
+
+**/
+STATIC
+EFI_STATUS
+FatSyncDataCacheRange (
+  IN FAT_VOLUME  *Volume,
+  IN IO_MODE     IoMode,
+  IN UINT64      Offset,
+  IN UINTN       Length,
+  IN UINT8       *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       PageNo;
+  UINTN       EndPageNo;
+  UINTN       PageSize;
+  UINT64      PageStart;
+  UINT64      Start;
+  UINT64      End;
+  UINT8       PageAlignment;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+
+  DiskCache     = &Volume->DiskCache[CacheData];
+  PageAlignment = DiskCache->PageAlignment;
+  PageSize      = (UINTN)1 << PageAlignment;
+  PageNo        = (UINTN)RShiftU64 (Offset, PageAlignment);
+  EndPageNo     = (UINTN)RShiftU64 (Offset + Length - 1, PageAlignment);
+
+  for ( ; PageNo <= EndPageNo; PageNo++) {
+    CacheTag = FatFindCacheTag (DiskCache, PageNo);
+    if (CacheTag == NULL) {
+      continue;
+    }
+
+    if (IoMode == ReadDisk) {
+      if (CacheTag->Dirty) {
+        Status = FatExchangeCachePage (Volume, CacheData, WriteDisk, CacheTag, NULL);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+
+      continue;
+    }
+
+    PageStart = LShiftU64 (PageNo, PageAlignment);
+    Start     = MAX (PageStart, Offset);
+    End       = MIN (PageStart + PageSize, Offset + Length);
+    if ((Start == PageStart) && (End == PageStart + PageSize)) {
+      CacheTag->RealSize = 0;
+    } else {
+      CopyMem (
+        FatGetCachePageAddress (DiskCache, CacheTag) + (UINTN)(Start - PageStart),
+        Buffer + (UINTN)(Start - Offset),
+        (UINTN)(End - Start)
+        );
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Load a data cache page from the disk, together with the pages following it
+  when the data is read sequentially.
+
+  Each miss on the page following the last page read from the disk doubles the
+  read ahead window, up to MaxReadAheadCount pages, and any other miss closes it.
+  The pages read ahead are loaded into their cache groups with the same disk
+  access as the requested page. Read ahead stops at a page that is already cached,
+  a page whose replacement is dirty or the end of the data region.
+
+  @param  Volume                - FAT file system volume.
+  @param  CacheTag              - The Cache Tag of the cache page to be loaded,
+                                  its PageNo is the requested page.
+
+  @retval EFI_SUCCESS           - The cache page was loaded successfully.
+  @return Others                - An error occurred when reading the disk.
+
+**/
+STATIC
+EFI_STATUS
+FatReadAheadCachePages (
+  IN FAT_VOLUME  *Volume,
+  IN CACHE_TAG   *CacheTag
+  )
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *Victim;
+  UINTN       PageNo;
+  UINTN       Count;
+  UINTN       Index;
+  UINTN       PageSize;
+  UINTN       ReadSize;
+  UINT64      EntryPos;
+  UINT8       PageAlignment;
+
+  DiskCache     = &Volume->DiskCache[CacheData];
+  PageNo        = CacheTag->PageNo;
+  PageAlignment = DiskCache->PageAlignment;
+  PageSize      = (UINTN)1 << PageAlignment;
+  EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
+
+  if (PageNo == DiskCache->NextPageNo) {
+    DiskCache->ReadAheadCount = MIN (MAX (DiskCache->ReadAheadCount * 2, 1), DiskCache->MaxReadAheadCount);
+  } else {
+    DiskCache->ReadAheadCount = 0;
+  }
+
+  //
+  // MaxReadAheadCount is less than the number of cache groups, so the pages
+  // read together never compete for the same cache group
+  //
+  for (Count = 0; Count < DiskCache->ReadAheadCount; Count++) {
+    if (EntryPos + LShiftU64 (Count + 1, PageAlignment) >= DiskCache->LimitAddress) {
+      break;
+    }
+
+    if (FatFindCacheTag (DiskCache, PageNo + Count + 1) != NULL) {
+      break;
+    }
+
+    Victim = FatSelectCacheTag (DiskCache, PageNo + Count + 1);
+    if ((Victim->RealSize > 0) && Victim->Dirty) {
+      break;
+    }
+  }
+
+  if (Count == 0) {
+    DiskCache->NextPageNo = PageNo + 1;
+    return FatExchangeCachePage (Volume, CacheData, ReadDisk, CacheTag, NULL);
+  }
+
+  ReadSize = (Count + 1) << PageAlignment;
+  if (DiskCache->LimitAddress - EntryPos < ReadSize) {
+    ReadSize = (UINTN)(DiskCache->LimitAddress - EntryPos);
+  }
+
+  Status = FatDiskIo (Volume, ReadDisk, EntryPos, ReadSize, DiskCache->ReadAheadBuffer, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index <= Count; Index++) {
+    Victim = CacheTag;
+    if (Index > 0) {
+      Victim             = FatSelectCacheTag (DiskCache, PageNo + Index);
+      Victim->PageNo     = PageNo + Index;
+      Victim->LastAccess = DiskCache->AccessCount;
+    }
+
+    Victim->RealSize = MIN (PageSize, ReadSize - (Index << PageAlignment));
+    Victim->Dirty    = FALSE;
+    CopyMem (
+      FatGetCachePageAddress (DiskCache, Victim),
+      DiskCache->ReadAheadBuffer + (Index << PageAlignment),
+      Victim->RealSize
+      );
+  }
+
+  DiskCache->ReadAheadPageCount += Count;
+  DiskCache->NextPageNo          = PageNo + Count + 1;
+  return EFI_SUCCESS;
+}
+
 /**
 
   Get one cache page by specified PageNo.
 
   @param  Volume                - FAT file system volume.
   @param  CacheDataType         - The cache type: CACHE_FAT or CACHE_DATA.
+  @param  IoMode                - Indicate whether the cache page is read or written.
   @param  PageNo                - PageNo to match with the cache.
   @param  CacheTag              - The Cache Tag for the current cache page.
 
@@ -168,39 +372,57 @@ FatExchangeCachePage (
 STATIC
 EFI_STATUS
 FatGetCachePage (
-  IN FAT_VOLUME       *Volume,
-  IN CACHE_DATA_TYPE  CacheDataType,
-  IN UINTN            PageNo,
-  IN CACHE_TAG        *CacheTag
+  IN  FAT_VOLUME       *Volume,
+  IN  CACHE_DATA_TYPE  CacheDataType,
+  IN  IO_MODE          IoMode,
+  IN  UINTN            PageNo,
+  OUT CACHE_TAG        **CacheTag
   )
 {
   EFI_STATUS  Status;
-  UINTN       OldPageNo;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *Tag;
 
-  OldPageNo = CacheTag->PageNo;
-  if ((CacheTag->RealSize > 0) && (OldPageNo == PageNo)) {
+  DiskCache = &Volume->DiskCache[CacheDataType];
+  DiskCache->AccessCount++;
+
+  Tag = FatFindCacheTag (DiskCache, PageNo);
+  if (Tag != NULL) {
     //
     // Cache Hit occurred
     //
+    DiskCache->HitCount++;
+    Tag->LastAccess = DiskCache->AccessCount;
+    *CacheTag       = Tag;
     return EFI_SUCCESS;
   }
 
+  DiskCache->MissCount++;
+  Tag = FatSelectCacheTag (DiskCache, PageNo);
+
   //
   // Write dirty cache page back to disk
   //
-  if ((CacheTag->RealSize > 0) && CacheTag->Dirty) {
-    Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, NULL);
+  if ((Tag->RealSize > 0) && Tag->Dirty) {
+    Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, Tag, NULL);
     if (EFI_ERROR (Status)) {
       return Status;
     }
   }
 
   //
-  // Load new data from disk;
+  // Load new data from disk; the cache page stays invalid if the load fails
   //
-  CacheTag->PageNo = PageNo;
-  Status           = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, CacheTag, NULL);
+  Tag->PageNo     = PageNo;
+  Tag->RealSize   = 0;
+  Tag->LastAccess = DiskCache->AccessCount;
+  if ((CacheDataType == CacheData) && (IoMode == ReadDisk) && (DiskCache->MaxReadAheadCount > 0)) {
+    Status = FatReadAheadCachePages (Volume, Tag);
+  } else {
+    Status = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, Tag, NULL);
+  }
 
+  *CacheTag = Tag;
   return Status;
 }
 
@@ -238,14 +460,11 @@ FatAccessUnalignedCachePage (
   VOID        *Destination;
   DISK_CACHE  *DiskCache;
   CACHE_TAG   *CacheTag;
-  UINTN       GroupNo;
 
   DiskCache = &Volume->DiskCache[CacheDataType];
-  GroupNo   = PageNo & DiskCache->GroupMask;
-  CacheTag  = &DiskCache->CacheTag[GroupNo];
-  Status    = FatGetCachePage (Volume, CacheDataType, PageNo, CacheTag);
+  Status    = FatGetCachePage (Volume, CacheDataType, RAW_ACCESS (IoMode), PageNo, &CacheTag);
   if (!EFI_ERROR (Status)) {
-    Source      = DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment) + Offset;
+    Source      = FatGetCachePageAddress (DiskCache, CacheTag) + Offset;
     Destination = Buffer;
     if (IoMode != ReadDisk) {
       CacheTag->Dirty  = TRUE;
@@ -271,8 +490,12 @@ FatAccessUnalignedCachePage (
   1. Access of FAT cache (CACHE_FAT): Access the data in the FAT cache, if there is cache
      page hit, just return the cache page; else update the related cache page and return
      the right cache page.
+     An access of several FAT cache pages is split into accesses of each page.
   2. Access of Data cache (CACHE_DATA):
-     The access data will be divided into UnderRun data, Aligned data and OverRun data;
+     An access of at least one cache page is divided at the media block boundaries;
+     the blocks are accessed with disk directly in a single request, and the data
+     before and after them is accessed by the Data cache.
+     Otherwise the access data will be divided into UnderRun data, Aligned data and OverRun data;
      The UnderRun data and OverRun data will be accessed by the Data cache,
      but the Aligned data will be accessed with disk directly.
 
@@ -312,6 +535,8 @@ FatAccessCache (
   DISK_CACHE  *DiskCache;
   UINT64      EntryPos;
   UINT8       PageAlignment;
+  UINT32      BlockSize;
+  UINT32      Remainder;
 
   ASSERT (Volume->CacheBuffer != NULL);
 
@@ -323,6 +548,45 @@ FatAccessCache (
   PageNo        = (UINTN)RShiftU64 (EntryPos, PageAlignment);
   UnderRun      = ((UINTN)EntryPos) & (PageSize - 1);
 
+  if ((CacheDataType == CacheData) && (BufferSize >= PageSize)) {
+    //
+    // Access the media blocks covered by the data with disk directly, whatever
+    // their alignment to the cache pages, so a large access is not copied through
+    // the cache and does not read a whole cache page for its first and last bytes
+    //
+    BlockSize = Volume->BlockIo->Media->BlockSize;
+    DivU64x32Remainder (Offset, BlockSize, &Remainder);
+    UnderRun = (Remainder == 0) ? 0 : BlockSize - Remainder;
+    if ((UnderRun < BufferSize) && ((BufferSize - UnderRun) / BlockSize * BlockSize >= PageSize)) {
+      AlignedSize = (BufferSize - UnderRun) / BlockSize * BlockSize;
+      OverRun     = BufferSize - UnderRun - AlignedSize;
+      if (UnderRun > 0) {
+        Status = FatAccessCache (Volume, CacheDataType, IoMode, Offset, UnderRun, Buffer, Task);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+
+      //
+      // If these access data over laps the relative cache range, these cache pages need
+      // to be updated.
+      //
+      Status = FatSyncDataCacheRange (Volume, IoMode, EntryPos + UnderRun, AlignedSize, Buffer + UnderRun);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      Status = FatDiskIo (Volume, IoMode, Offset + UnderRun, AlignedSize, Buffer + UnderRun, Task);
+      if (EFI_ERROR (Status) || (OverRun == 0)) {
+        return Status;
+      }
+
+      return FatAccessCache (Volume, CacheDataType, IoMode, Offset + UnderRun + AlignedSize, OverRun, Buffer + UnderRun + AlignedSize, Task);
+    }
+
+    UnderRun = ((UINTN)EntryPos) & (PageSize - 1);
+  }
+
   if (UnderRun > 0) {
     Length = PageSize - UnderRun;
     if (Length > BufferSize) {
@@ -344,24 +608,37 @@ FatAccessCache (
   //
   // The access of the Aligned data
   //
-  if (AlignedPageCount > 0) {
+  if ((AlignedPageCount > 0) && (CacheDataType == CacheFat)) {
     //
-    // Accessing fat table cannot have alignment data
+    // Accessing fat table always goes through the cache, so that all the fats
+    // are kept in sync when the cache pages are written back
     //
-    ASSERT (CacheDataType == CacheData);
+    for ( ; PageNo < OverRunPageNo; PageNo++) {
+      Status = FatAccessUnalignedCachePage (Volume, CacheDataType, IoMode, PageNo, 0, PageSize, Buffer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
 
-    EntryPos    = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
-    AlignedSize = AlignedPageCount << PageAlignment;
-    Status      = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
-    if (EFI_ERROR (Status)) {
-      return Status;
+      Buffer     += PageSize;
+      BufferSize -= PageSize;
     }
-
+  } else if (AlignedPageCount > 0) {
+    AlignedSize = AlignedPageCount << PageAlignment;
     //
     // If these access data over laps the relative cache range, these cache pages need
     // to be updated.
     //
-    FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
+    Status = FatSyncDataCacheRange (Volume, IoMode, LShiftU64 (PageNo, PageAlignment), AlignedSize, Buffer);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    EntryPos = Volume->RootPos + LShiftU64 (PageNo, PageAlignment);
+    Status   = FatDiskIo (Volume, IoMode, EntryPos, AlignedSize, Buffer, Task);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
     Buffer     += AlignedSize;
     BufferSize -= AlignedSize;
   }
@@ -399,8 +676,8 @@ FatVolumeFlushCache (
 {
   EFI_STATUS       Status;
   CACHE_DATA_TYPE  CacheDataType;
-  UINTN            GroupIndex;
-  UINTN            GroupMask;
+  UINTN            TagIndex;
+  UINTN            TagCount;
   DISK_CACHE       *DiskCache;
   CACHE_TAG        *CacheTag;
 
@@ -410,9 +687,9 @@ FatVolumeFlushCache (
       //
       // Data cache or fat cache is dirty, write the dirty data back
       //
-      GroupMask = DiskCache->GroupMask;
-      for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex++) {
-        CacheTag = &DiskCache->CacheTag[GroupIndex];
+      TagCount = (DiskCache->GroupMask + 1) * DiskCache->GroupWays;
+      for (TagIndex = 0; TagIndex < TagCount; TagIndex++) {
+        CacheTag = &DiskCache->CacheTag[TagIndex];
         if ((CacheTag->RealSize > 0) && CacheTag->Dirty) {
           //
           // Write back all Dirty Data Cache Page to disk
@@ -452,8 +729,10 @@ FatInitializeDiskCache (
 {
   DISK_CACHE  *DiskCache;
   UINTN       FatCacheGroupCount;
+  UINTN       DataCacheGroupCount;
   UINTN       DataCacheSize;
   UINTN       FatCacheSize;
+  UINTN       ReadAheadSize;
   UINT8       *CacheBuffer;
 
   DiskCache = Volume->DiskCache;
@@ -470,24 +749,47 @@ FatInitializeDiskCache (
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MAX_ALIGNMENT;
   }
 
-  DiskCache[CacheData].GroupMask    = FAT_DATACACHE_GROUP_COUNT - 1;
-  DiskCache[CacheData].BaseAddress  = Volume->RootPos;
-  DiskCache[CacheData].LimitAddress = Volume->VolumeSize;
-  DiskCache[CacheFat].GroupMask     = FatCacheGroupCount - 1;
-  DiskCache[CacheFat].BaseAddress   = Volume->FatPos;
-  DiskCache[CacheFat].LimitAddress  = Volume->FatPos + Volume->FatSize;
-  FatCacheSize                      = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
-  DataCacheSize                     = FAT_DATACACHE_GROUP_COUNT << DiskCache[CacheData].PageAlignment;
   //
-  // Allocate the Fat Cache buffer
+  // The data cache holds a power of two number of pages, at least one full group
+  // and one more group for the pages read ahead
+  //
+  DataCacheGroupCount = GetPowerOfTwo32 (PcdGet32 (PcdFatDataCachePageCount));
+  DataCacheGroupCount = MAX (DataCacheGroupCount / FAT_CACHE_GROUP_WAYS, 2);
+
+  DiskCache[CacheData].GroupWays         = FAT_CACHE_GROUP_WAYS;
+  DiskCache[CacheData].GroupMask         = DataCacheGroupCount - 1;
+  DiskCache[CacheData].BaseAddress       = Volume->RootPos;
+  DiskCache[CacheData].LimitAddress      = Volume->VolumeSize;
+  DiskCache[CacheData].MaxReadAheadCount = MIN (PcdGet32 (PcdFatReadAheadPageCount), DataCacheGroupCount - 1);
+  DiskCache[CacheFat].GroupWays          = MIN (FatCacheGroupCount, FAT_CACHE_GROUP_WAYS);
+  DiskCache[CacheFat].GroupMask          = FatCacheGroupCount / DiskCache[CacheFat].GroupWays - 1;
+  DiskCache[CacheFat].BaseAddress        = Volume->FatPos;
+  DiskCache[CacheFat].LimitAddress       = Volume->FatPos + Volume->FatSize;
+  FatCacheSize                           = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
+  DataCacheSize                          = (DataCacheGroupCount * FAT_CACHE_GROUP_WAYS) << DiskCache[CacheData].PageAlignment;
+  ReadAheadSize                          = 0;
+  if (DiskCache[CacheData].MaxReadAheadCount > 0) {
+    ReadAheadSize = (DiskCache[CacheData].MaxReadAheadCount + 1) << DiskCache[CacheData].PageAlignment;
+  }
+
+  //
+  // Allocate the cache buffer, holding the Fat Cache pages, the Data Cache pages,
+  // the read ahead buffer and the tags of all the cache pages
   //
-  CacheBuffer = AllocateZeroPool (FatCacheSize + DataCacheSize);
+  CacheBuffer = AllocateZeroPool (
+                  FatCacheSize + DataCacheSize + ReadAheadSize +
+                  (FatCacheGroupCount + DataCacheGroupCount * FAT_CACHE_GROUP_WAYS) * sizeof (CACHE_TAG)
+                  );
   if (CacheBuffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Volume->CacheBuffer            = CacheBuffer;
-  DiskCache[CacheFat].CacheBase  = CacheBuffer;
-  DiskCache[CacheData].CacheBase = CacheBuffer + FatCacheSize;
+  Volume->CacheBuffer                  = CacheBuffer;
+  DiskCache[CacheFat].CacheBase        = CacheBuffer;
+  DiskCache[CacheData].CacheBase       = CacheBuffer + FatCacheSize;
+  DiskCache[CacheData].ReadAheadBuffer = DiskCache[CacheData].CacheBase + DataCacheSize;
+  DiskCache[CacheFat].CacheTag         = (CACHE_TAG *)(DiskCache[CacheData].ReadAheadBuffer + ReadAheadSize);
+  DiskCache[CacheData].CacheTag        = DiskCache[CacheFat].CacheTag + FatCacheGroupCount;
+  DiskCache[CacheData].NextPageNo      = MAX_UINTN;
   return EFI_SUCCESS;
 }
@@ -80,10 +80,33 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FAT_FATCACHE_PAGE_MAX_ALIGNMENT   15
 #define FAT_DATACACHE_PAGE_MIN_ALIGNMENT  13
 #define FAT_DATACACHE_PAGE_MAX_ALIGNMENT  16
-#define FAT_DATACACHE_GROUP_COUNT         64
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// A cache page can be held by any of the FAT_CACHE_GROUP_WAYS cache pages of
+// its group, the least recently used one of them is replaced on a miss
+//
+#define FAT_CACHE_GROUP_WAYS  4
+
+//
+// Number of FAT entries that are read or written together when the free
+// cluster bitmap is built or a run of clusters is allocated
+//
+#define FAT_ENTRY_BATCH_COUNT  1024
+
+//
+// Initial number of extents in the extent map of an OFile
+//
+#define FAT_EXTENT_MIN_COUNT  8
+
+//
+// The free cluster bitmap has one bit per cluster, set if the cluster is free
+//
+#define FAT_FREE_BITMAP_TEST(Bitmap, Index)   (((Bitmap)[(Index) >> 3] & (1 << ((Index) & 7))) != 0)
+#define FAT_FREE_BITMAP_SET(Bitmap, Index)    ((Bitmap)[(Index) >> 3] |= (UINT8)(1 << ((Index) & 7)))
+#define FAT_FREE_BITMAP_CLEAR(Bitmap, Index)  ((Bitmap)[(Index) >> 3] &= (UINT8)~(1 << ((Index) & 7)))
+
 //
 // Used in 8.3 generation algorithm
 //
@@ -146,6 +169,7 @@ typedef struct {
   UINTN      PageNo;
   UINTN      RealSize;
   BOOLEAN    Dirty;
+  UINTN      LastAccess;                // The access count of the cache when this page was last accessed
 } CACHE_TAG;
 
 typedef struct {
@@ -155,7 +179,22 @@ typedef struct {
   BOOLEAN      Dirty;
   UINT8        PageAlignment;
   UINTN        GroupMask;
-  CACHE_TAG    CacheTag[FAT_DATACACHE_GROUP_COUNT];
+  UINTN        GroupWays;               // The number of cache pages in a group
+  CACHE_TAG    *CacheTag;               // The tags of the cache pages, group by group
+  UINTN        AccessCount;
+  //
+  // Read ahead of the data cache
+  //
+  UINT8        *ReadAheadBuffer;
+  UINTN        MaxReadAheadCount;       // 0 if read ahead is disabled
+  UINTN        ReadAheadCount;          // The number of pages read ahead on the next sequential miss
+  UINTN        NextPageNo;              // The page following the last page read from disk
+  //
+  // Statistics
+  //
+  UINTN        HitCount;
+  UINTN        MissCount;
+  UINTN        ReadAheadPageCount;
 } DISK_CACHE;
 
 //
@@ -228,6 +267,15 @@ typedef struct {
   LIST_ENTRY            Link;
 } FAT_SUBTASK;
 
+//
+// A run of consecutive clusters in the cluster chain of an OFile
+//
+typedef struct {
+  UINTN    FirstIndex;                        // Index of the first cluster of the run in the file
+  UINTN    Cluster;                           // The first cluster of the run on the disk
+  UINTN    Count;                             // Number of clusters in the run
+} FAT_EXTENT;
+
 //
 // FAT_OFILE - Each opened file
 //
@@ -271,6 +319,14 @@ struct _FAT_OFILE {
   UINT64        PosDisk;        // on the disk
   UINTN         PosRem;         // remaining in this disk run
   //
+  // The extent map of the first ExtentClusters clusters of the
+  // cluster chain, built when the file is accessed
+  //
+  FAT_EXTENT    *Extents;
+  UINTN         ExtentCount;
+  UINTN         ExtentMaxCount;
+  UINTN         ExtentClusters;
+  //
   // The opened parent, full path length and currently opened child files
   //
   FAT_OFILE     *Parent;
@@ -334,6 +390,8 @@ struct _FAT_VOLUME {
   FAT_INFO_SECTOR                    FatInfoSector;  // Free cluster info
   UINTN                              FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                            FreeInfoValid;  // If free cluster info is valid
+  UINT8                              *FreeBitmap;    // Free cluster bitmap, built on the first allocation
+  UINT32                             *FatEntryBatch; // FAT_ENTRY_BATCH_COUNT fat entries accessed together
   //
   // Unpacked Fat BPB info
   //
@@ -948,6 +1006,18 @@ FatOFilePosition (
   IN UINTN      PosLimit
   );
 
+/**
+
+  Free the extent map of the open file.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatFreeExtents (
+  IN FAT_OFILE  *OFile
+  );
+
 /**
 
   Update the free cluster info of FatInfoSector of the volume.
@@ -122,6 +122,68 @@ FatGetFatEntry (
   return Accum;
 }
 
+/**
+
+  Update the free cluster info and the free cluster bitmap of the volume for
+  the change of a FAT entry value.
+
+  @param  Volume                - FAT file system volume.
+  @param  Index                 - The index of the FAT entry of the volume.
+  @param  OriginalValue         - The current value of the FAT entry.
+  @param  Value                 - The new value of the FAT entry.
+
+**/
+STATIC
+VOID
+FatUpdateFreeInfo (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Index,
+  IN UINTN       OriginalValue,
+  IN UINTN       Value
+  )
+{
+  if ((Value == FAT_CLUSTER_FREE) && (OriginalValue != FAT_CLUSTER_FREE)) {
+    Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+    if (Index < Volume->FatInfoSector.FreeInfo.NextCluster) {
+      Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)Index;
+    }
+  } else if ((Value != FAT_CLUSTER_FREE) && (OriginalValue == FAT_CLUSTER_FREE)) {
+    if (Volume->FatInfoSector.FreeInfo.ClusterCount != 0) {
+      Volume->FatInfoSector.FreeInfo.ClusterCount -= 1;
+    }
+  }
+
+  if ((Volume->FreeBitmap != NULL) && (Index <= Volume->MaxCluster + 1)) {
+    if (Value == FAT_CLUSTER_FREE) {
+      FAT_FREE_BITMAP_SET (Volume->FreeBitmap, Index);
+    } else {
+      FAT_FREE_BITMAP_CLEAR (Volume->FreeBitmap, Index);
+    }
+  }
+}
+
+/**
+
+  Set the dirty bit of the volume before the first FAT entry is updated.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+STATIC
+VOID
+FatMarkFatDirty (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  //
+  // If the volume's dirty bit is not set, set it now
+  //
+  if (!Volume->FatDirty && (Volume->FatType != Fat12)) {
+    Volume->FatDirty = TRUE;
+    FatAccessVolumeDirty (Volume, WriteFat, &Volume->DirtyValue);
+  }
+}
+
 /**
 
   Set the FAT entry value of the volume, which is identified with the Index.
@@ -156,16 +218,7 @@ FatSetFatEntry (
   }
 
   OriginalVal = FatGetFatEntry (Volume, Index);
-  if ((Value == FAT_CLUSTER_FREE) && (OriginalVal != FAT_CLUSTER_FREE)) {
-    Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
-    if (Index < Volume->FatInfoSector.FreeInfo.NextCluster) {
-      Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)Index;
-    }
-  } else if ((Value != FAT_CLUSTER_FREE) && (OriginalVal == FAT_CLUSTER_FREE)) {
-    if (Volume->FatInfoSector.FreeInfo.ClusterCount != 0) {
-      Volume->FatInfoSector.FreeInfo.ClusterCount -= 1;
-    }
-  }
+  FatUpdateFreeInfo (Volume, Index, OriginalVal, Value);
 
   //
   // Make sure the entry is in memory
@@ -201,13 +254,7 @@ FatSetFatEntry (
       *En32 = (*En32 & FAT_CLUSTER_UNMASK_FAT32) | (UINT32)(Value & FAT_CLUSTER_MASK_FAT32);
   }
 
-  //
-  // If the volume's dirty bit is not set, set it now
-  //
-  if (!Volume->FatDirty && (Volume->FatType != Fat12)) {
-    Volume->FatDirty = TRUE;
-    FatAccessVolumeDirty (Volume, WriteFat, &Volume->DirtyValue);
-  }
+  FatMarkFatDirty (Volume);
 
   //
   // Write the updated fat entry value to the volume
@@ -225,6 +272,269 @@ FatSetFatEntry (
   return Status;
 }
 
+/**
+
+  Get the buffer of FAT_ENTRY_BATCH_COUNT fat entries of the volume, and allocate
+  it on the first use. It is too large for the stack of the callers.
+
+  @param  Volume                - FAT file system volume.
+
+  @return The buffer, or NULL if it can not be allocated.
+
+**/
+STATIC
+UINT32 *
+FatGetFatEntryBatch (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  if (Volume->FatEntryBatch == NULL) {
+    Volume->FatEntryBatch = AllocatePool (FAT_ENTRY_BATCH_COUNT * sizeof (UINT32));
+  }
+
+  return Volume->FatEntryBatch;
+}
+
+/**
+
+  Link a run of consecutive clusters into a cluster chain terminated by the last
+  cluster of the run. The FAT entries are updated in batches, each with a single
+  access of the FAT cache.
+
+  @param  Volume                - FAT file system volume.
+  @param  Cluster               - The first cluster of the run.
+  @param  Count                 - The number of clusters in the run.
+
+  @retval EFI_SUCCESS           - The cluster chain is set successfully.
+  @retval EFI_VOLUME_CORRUPTED  - The run is out of the range of the FAT.
+  @return other                 - An error occurred when operation the FAT entries.
+
+**/
+STATIC
+EFI_STATUS
+FatSetFatEntryRun (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Cluster,
+  IN UINTN       Count
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      *Buffer;
+  UINT16      *En16;
+  UINT32      *En32;
+  UINTN       Index;
+  UINTN       BatchCount;
+  UINTN       OriginalVal;
+  UINTN       Value;
+  UINTN       LastCluster;
+
+  if ((Cluster < FAT_MIN_CLUSTER) || (Count == 0) || (Cluster + Count - 1 > Volume->MaxCluster + 1)) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  LastCluster = Cluster + Count - 1;
+
+  Buffer = NULL;
+  if (Volume->FatType != Fat12) {
+    Buffer = FatGetFatEntryBatch (Volume);
+  }
+
+  if (Buffer == NULL) {
+    //
+    // Fat12 entries share bytes, and a fat12 fat is small. Without the
+    // batch buffer, the entries are set one by one as well.
+    //
+    for ( ; Cluster < LastCluster; Cluster++) {
+      Status = FatSetFatEntry (Volume, Cluster, Cluster + 1);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    return FatSetFatEntry (Volume, LastCluster, (UINTN)FAT_CLUSTER_LAST);
+  }
+
+  FatMarkFatDirty (Volume);
+
+  En16 = (UINT16 *)Buffer;
+  En32 = Buffer;
+  for ( ; Cluster <= LastCluster; Cluster += BatchCount) {
+    BatchCount = MIN (LastCluster - Cluster + 1, FAT_ENTRY_BATCH_COUNT);
+    Status     = FatDiskIo (
+                   Volume,
+                   ReadFat,
+                   Volume->FatPos + Cluster * Volume->FatEntrySize,
+                   BatchCount * Volume->FatEntrySize,
+                   Buffer,
+                   NULL
+                   );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    for (Index = 0; Index < BatchCount; Index++) {
+      Value = (Cluster + Index == LastCluster) ? (UINTN)FAT_CLUSTER_LAST : Cluster + Index + 1;
+      if (Volume->FatType == Fat16) {
+        OriginalVal = En16[Index];
+        En16[Index] = (UINT16)Value;
+      } else {
+        OriginalVal = En32[Index] & FAT_CLUSTER_MASK_FAT32;
+        En32[Index] = (En32[Index] & FAT_CLUSTER_UNMASK_FAT32) | (UINT32)(Value & FAT_CLUSTER_MASK_FAT32);
+      }
+
+      FatUpdateFreeInfo (Volume, Cluster + Index, OriginalVal, Value);
+    }
+
+    //
+    // The fat is the first fat, and other fat will be in sync
+    // when the FAT cache flush back.
+    //
+    Status = FatDiskIo (
+               Volume,
+               WriteFat,
+               Volume->FatPos + Cluster * Volume->FatEntrySize,
+               BatchCount * Volume->FatEntrySize,
+               Buffer,
+               NULL
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Build the free cluster bitmap of the volume from the FAT. Fat16 and fat32
+  entries are read in batches rather than one by one.
+
+  @param  Volume                - FAT file system volume.
+
+  @retval EFI_SUCCESS           - The bitmap is built successfully.
+  @retval EFI_OUT_OF_RESOURCES  - Can not allocate the bitmap.
+  @return other                 - An error occurred when reading the FAT entries.
+
+**/
+STATIC
+EFI_STATUS
+FatBuildFreeBitmap (
+  IN FAT_VOLUME  *Volume
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Bitmap;
+  UINT32      *Buffer;
+  UINT16      *En16;
+  UINT32      *En32;
+  UINTN       Cluster;
+  UINTN       ClusterLimit;
+  UINTN       Index;
+  UINTN       BatchCount;
+  UINTN       Value;
+
+  ASSERT (Volume->FreeBitmap == NULL);
+
+  Buffer = NULL;
+  if (Volume->FatType != Fat12) {
+    Buffer = FatGetFatEntryBatch (Volume);
+    if (Buffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  ClusterLimit = Volume->MaxCluster + 2;
+  Bitmap       = AllocateZeroPool ((ClusterLimit + 7) / 8);
+  if (Bitmap == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_SUCCESS;
+  if (Volume->FatType == Fat12) {
+    for (Cluster = FAT_MIN_CLUSTER; Cluster < ClusterLimit; Cluster++) {
+      if (FatGetFatEntry (Volume, Cluster) == FAT_CLUSTER_FREE) {
+        FAT_FREE_BITMAP_SET (Bitmap, Cluster);
+      }
+    }
+
+    if (Volume->DiskError) {
+      Status = EFI_DEVICE_ERROR;
+    }
+  } else {
+    En16 = (UINT16 *)Buffer;
+    En32 = Buffer;
+    for (Cluster = 0; Cluster < ClusterLimit; Cluster += BatchCount) {
+      BatchCount = MIN (ClusterLimit - Cluster, FAT_ENTRY_BATCH_COUNT);
+      Status     = FatDiskIo (
+                     Volume,
+                     ReadFat,
+                     Volume->FatPos + Cluster * Volume->FatEntrySize,
+                     BatchCount * Volume->FatEntrySize,
+                     Buffer,
+                     NULL
+                     );
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      for (Index = 0; Index < BatchCount; Index++) {
+        Value = (Volume->FatType == Fat16) ? En16[Index] : (En32[Index] & FAT_CLUSTER_MASK_FAT32);
+        if ((Value == FAT_CLUSTER_FREE) && (Cluster + Index >= FAT_MIN_CLUSTER)) {
+          FAT_FREE_BITMAP_SET (Bitmap, Cluster + Index);
+        }
+      }
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Bitmap);
+    return Status;
+  }
+
+  Volume->FreeBitmap = Bitmap;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Find the first free cluster at or after the Cluster in the free cluster bitmap.
+
+  @param  Volume                - FAT file system volume.
+  @param  Cluster               - The first cluster to check.
+
+  @return The index of the free cluster, or Volume->MaxCluster + 2 if there is no free cluster.
+
+**/
+STATIC
+UINTN
+FatFindFreeCluster (
+  IN FAT_VOLUME  *Volume,
+  IN UINTN       Cluster
+  )
+{
+  UINTN  ClusterLimit;
+
+  ClusterLimit = Volume->MaxCluster + 2;
+  while (Cluster < ClusterLimit) {
+    //
+    // Skip eight allocated clusters at once
+    //
+    if (((Cluster & 7) == 0) && (Volume->FreeBitmap[Cluster >> 3] == 0)) {
+      Cluster += 8;
+      continue;
+    }
+
+    if (FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Cluster)) {
+      return Cluster;
+    }
+
+    Cluster++;
+  }
+
+  return ClusterLimit;
+}
+
 /**
 
   Free the cluster chain.
@@ -261,20 +571,32 @@ FatFreeClusters (
 
 /**
 
-  Allocate a free cluster and return the cluster index.
+  Allocate a run of consecutive free clusters and return the index of the first one.
+  The clusters are not marked as allocated until their FAT entries are set.
+
+  With the free cluster bitmap, the run starts at the first free cluster after the
+  last allocation, wrapping around to the start of the volume, and is as long as
+  the clusters following it are free. Without the bitmap, the run is one cluster.
 
   @param  Volume                - FAT file system volume.
+  @param  MaxCount              - The maximum number of clusters to allocate.
+  @param  Count                 - The number of clusters allocated.
 
-  @return The index of the free cluster
+  @return The index of the first free cluster, or FAT_CLUSTER_LAST if there is no free cluster.
 
 **/
 STATIC
 UINTN
-FatAllocateCluster (
-  IN FAT_VOLUME  *Volume
+FatAllocateClusters (
+  IN  FAT_VOLUME  *Volume,
+  IN  UINTN       MaxCount,
+  OUT UINTN       *Count
   )
 {
   UINTN  Cluster;
+  UINTN  ClusterLimit;
+
+  *Count = 0;
 
   //
   // Start looking at FatFreePos for the next unallocated cluster
@@ -283,6 +605,31 @@ FatAllocateCluster (
     return (UINTN)FAT_CLUSTER_LAST;
   }
 
+  if (Volume->FreeBitmap == NULL) {
+    FatBuildFreeBitmap (Volume);
+  }
+
+  if (Volume->FreeBitmap != NULL) {
+    ClusterLimit = Volume->MaxCluster + 2;
+    Cluster      = FatFindFreeCluster (Volume, Volume->FatInfoSector.FreeInfo.NextCluster);
+    if (Cluster >= ClusterLimit) {
+      Cluster = FatFindFreeCluster (Volume, FAT_MIN_CLUSTER);
+      if (Cluster >= ClusterLimit) {
+        return (UINTN)FAT_CLUSTER_LAST;
+      }
+    }
+
+    *Count = 1;
+    while ((*Count < MaxCount) && (Cluster + *Count < ClusterLimit) &&
+           FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Cluster + *Count))
+    {
+      *Count += 1;
+    }
+
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32)(Cluster + *Count);
+    return Cluster;
+  }
+
   for ( ; ;) {
     //
     // If the end of the list, return no available cluster
@@ -311,6 +658,7 @@ FatAllocateCluster (
 
   Cluster                                     = Volume->FatInfoSector.FreeInfo.NextCluster;
   Volume->FatInfoSector.FreeInfo.NextCluster += 1;
+  *Count                                      = 1;
   return Cluster;
 }
 
@@ -341,6 +689,171 @@ FatSizeToClusters (
   return Clusters;
 }
 
+/**
+
+  Append a run of consecutive clusters to the extent map of the open file.
+  The run is merged into the last extent if it follows that extent on the disk.
+
+  @param  OFile                 - The open file.
+  @param  Cluster               - The first cluster of the run.
+  @param  Count                 - The number of clusters in the run.
+
+  @retval EFI_SUCCESS           - The run is appended successfully.
+  @retval EFI_OUT_OF_RESOURCES  - Can not grow the extent map.
+
+**/
+STATIC
+EFI_STATUS
+FatAppendExtent (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      Cluster,
+  IN UINTN      Count
+  )
+{
+  FAT_EXTENT  *Extent;
+  UINTN       MaxCount;
+
+  if (OFile->ExtentCount != 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->Cluster + Extent->Count == Cluster) {
+      Extent->Count         += Count;
+      OFile->ExtentClusters += Count;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (OFile->ExtentCount == OFile->ExtentMaxCount) {
+    MaxCount = MAX (OFile->ExtentMaxCount * 2, FAT_EXTENT_MIN_COUNT);
+    Extent   = ReallocatePool (
+                 OFile->ExtentMaxCount * sizeof (FAT_EXTENT),
+                 MaxCount * sizeof (FAT_EXTENT),
+                 OFile->Extents
+                 );
+    if (Extent == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    OFile->Extents        = Extent;
+    OFile->ExtentMaxCount = MaxCount;
+  }
+
+  Extent                 = &OFile->Extents[OFile->ExtentCount];
+  Extent->FirstIndex     = OFile->ExtentClusters;
+  Extent->Cluster        = Cluster;
+  Extent->Count          = Count;
+  OFile->ExtentCount    += 1;
+  OFile->ExtentClusters += Count;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Truncate the extent map of the open file to the first clusters of the file.
+
+  @param  OFile                 - The open file.
+  @param  ClusterCount          - The number of clusters left in the extent map.
+
+**/
+STATIC
+VOID
+FatTruncateExtents (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      ClusterCount
+  )
+{
+  FAT_EXTENT  *Extent;
+
+  while ((OFile->ExtentCount != 0) && (OFile->Extents[OFile->ExtentCount - 1].FirstIndex >= ClusterCount)) {
+    OFile->ExtentCount -= 1;
+  }
+
+  if (OFile->ExtentCount != 0) {
+    Extent        = &OFile->Extents[OFile->ExtentCount - 1];
+    Extent->Count = MIN (Extent->Count, ClusterCount - Extent->FirstIndex);
+  }
+
+  OFile->ExtentClusters = MIN (OFile->ExtentClusters, ClusterCount);
+}
+
+/**
+
+  Extend the extent map of the open file by following the cluster chain, until
+  it maps the first ClusterCount clusters of the file or the end of the chain.
+
+  @param  OFile                 - The open file.
+  @param  ClusterCount          - The number of clusters to map.
+
+  @retval EFI_SUCCESS           - The extent map is extended successfully.
+  @retval EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  @retval EFI_OUT_OF_RESOURCES  - Can not grow the extent map.
+
+**/
+STATIC
+EFI_STATUS
+FatMapClusters (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      ClusterCount
+  )
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  UINTN       Cluster;
+  EFI_STATUS  Status;
+
+  Volume = OFile->Volume;
+
+  //
+  // Never map past the file size, a corrupt cluster chain may be a loop
+  //
+  ClusterCount = MIN (ClusterCount, FatSizeToClusters (Volume, OFile->FileSize));
+  while (OFile->ExtentClusters < ClusterCount) {
+    if (OFile->ExtentCount == 0) {
+      Cluster = OFile->FileCluster;
+    } else {
+      Extent  = &OFile->Extents[OFile->ExtentCount - 1];
+      Cluster = FatGetFatEntry (Volume, Extent->Cluster + Extent->Count - 1);
+    }
+
+    if (FAT_END_OF_FAT_CHAIN (Cluster)) {
+      break;
+    }
+
+    if ((Cluster < FAT_MIN_CLUSTER) || (Cluster > Volume->MaxCluster + 1)) {
+      DEBUG ((DEBUG_INIT | DEBUG_ERROR, "FatMapClusters: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Status = FatAppendExtent (OFile, Cluster, 1);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Free the extent map of the open file.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatFreeExtents (
+  IN FAT_OFILE  *OFile
+  )
+{
+  if (OFile->Extents != NULL) {
+    FreePool (OFile->Extents);
+  }
+
+  OFile->Extents        = NULL;
+  OFile->ExtentCount    = 0;
+  OFile->ExtentMaxCount = 0;
+  OFile->ExtentClusters = 0;
+}
+
 /**
 
   Shrink the end of the open file base on the file size.
@@ -399,6 +912,8 @@ FatShrinkEof (
     OFile->FileCluster = FAT_CLUSTER_FREE;
   }
 
+  FatTruncateExtents (OFile, NewSize);
+
   //
   // Set CurrentCluster == FileCluster
   // to force a recalculation of Position related stuffs
@@ -439,6 +954,8 @@ FatGrowEof (
   UINTN       LastCluster;
   UINTN       NewCluster;
   UINTN       ClusterCount;
+  UINTN       RunLength;
+  UINTN       Index;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -494,7 +1011,7 @@ FatGrowEof (
     LastCluster = OFile->FileLastCluster;
 
     while (CurSize < NewSize) {
-      NewCluster = FatAllocateCluster (Volume);
+      NewCluster = FatAllocateClusters (Volume, NewSize - CurSize, &RunLength);
       if (FAT_END_OF_FAT_CHAIN (NewCluster)) {
         if (LastCluster != FAT_CLUSTER_FREE) {
           FatSetFatEntry (Volume, LastCluster, (UINTN)FAT_CLUSTER_LAST);
@@ -505,8 +1022,28 @@ FatGrowEof (
         goto Done;
       }
 
-      if ((NewCluster < FAT_MIN_CLUSTER) || (NewCluster > Volume->MaxCluster + 1)) {
-        Status = EFI_VOLUME_CORRUPTED;
+      //
+      // Link the clusters of the run and terminate the cluster list before
+      // the run is appended to the file.
+      //
+      // Note that we must terminate the run EVERY time we allocate clusters,
+      // because FatAllocateClusters looks for free clusters and the run is
+      // no longer free once its FAT entries are set.
+      //
+      Status = FatSetFatEntryRun (Volume, NewCluster, RunLength);
+      if (EFI_ERROR (Status)) {
+        //
+        // The run is not on the cluster chain of the file yet, so free the
+        // part of it that was linked before the error. The free cluster count
+        // already took the failed batch as allocated, so count it again.
+        //
+        for (Index = 0; Index < RunLength; Index++) {
+          FatSetFatEntry (Volume, NewCluster + Index, FAT_CLUSTER_FREE);
+        }
+
+        Volume->FreeInfoValid = FALSE;
+        FatComputeFreeInfo (Volume);
+
         goto Done;
       }
 
@@ -517,21 +1054,15 @@ FatGrowEof (
         OFile->FileCurrentCluster = NewCluster;
       }
 
-      LastCluster = NewCluster;
-      CurSize    += 1;
-
-      //
-      // Terminate the cluster list
       //
-      // Note that we must do this EVERY time we allocate a cluster, because
-      // FatAllocateCluster scans the FAT looking for a free cluster and
-      // "LastCluster" is no longer free!  Usually, FatAllocateCluster will
-      // start looking with the cluster after "LastCluster"; however, when
-      // there is only one free cluster left, it will find "LastCluster"
-      // a second time.  There are other, less predictable scenarios
-      // where this could happen, as well.
+      // Keep the extent map up to date if it maps the whole cluster chain
       //
-      FatSetFatEntry (Volume, LastCluster, (UINTN)FAT_CLUSTER_LAST);
+      if (OFile->ExtentClusters == CurSize) {
+        FatAppendExtent (OFile, NewCluster, RunLength);
+      }
+
+      LastCluster            = NewCluster + RunLength - 1;
+      CurSize               += RunLength;
       OFile->FileLastCluster = LastCluster;
     }
   }
@@ -570,6 +1101,12 @@ FatOFilePosition (
   UINTN       Cluster;
   UINTN       StartPos;
   UINTN       Run;
+  EFI_STATUS  Status;
+  UINTN       ClusterIndex;
+  FAT_EXTENT  *Extent;
+  UINTN       Low;
+  UINTN       High;
+  UINTN       Middle;
 
   Volume      = OFile->Volume;
   ClusterSize = Volume->ClusterSize;
@@ -585,6 +1122,45 @@ FatOFilePosition (
     Run            = OFile->FileSize - Position;
   } else {
     //
+    // Map the clusters up to the end of the access, and find the position
+    // in the extent map with a binary search
+    //
+    ClusterIndex = Position >> Volume->ClusterAlignment;
+    Status       = FatMapClusters (OFile, FatSizeToClusters (Volume, Position + PosLimit));
+    if (Status == EFI_VOLUME_CORRUPTED) {
+      return Status;
+    }
+
+    if (ClusterIndex < OFile->ExtentClusters) {
+      Low  = 0;
+      High = OFile->ExtentCount - 1;
+      while (Low < High) {
+        Middle = (Low + High + 1) / 2;
+        if (OFile->Extents[Middle].FirstIndex <= ClusterIndex) {
+          Low = Middle;
+        } else {
+          High = Middle - 1;
+        }
+      }
+
+      Extent   = &OFile->Extents[Low];
+      Cluster  = Extent->Cluster + ClusterIndex - Extent->FirstIndex;
+      StartPos = ClusterIndex << Volume->ClusterAlignment;
+
+      OFile->PosDisk = Volume->FirstClusterPos +
+                       LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
+                       Position - StartPos;
+      OFile->FileCurrentCluster = Cluster;
+      OFile->Position           = StartPos;
+      OFile->PosRem             = (UINTN)MIN (
+                                           LShiftU64 (Extent->FirstIndex + Extent->Count, Volume->ClusterAlignment) - Position,
+                                           MAX_UINTN
+                                           );
+      return EFI_SUCCESS;
+    }
+
+    //
+    // The extent map can not be extended to the position.
     // Run the file's cluster chain to find the current position
     // If possible, run from the current cluster rather than
     // start from beginning
@@ -729,15 +1305,23 @@ FatComputeFreeInfo (
   if (!Volume->FreeInfoValid) {
     Volume->FreeInfoValid                       = TRUE;
     Volume->FatInfoSector.FreeInfo.ClusterCount = 0;
+    if ((Volume->FreeBitmap == NULL) && !Volume->DiskError) {
+      FatBuildFreeBitmap (Volume);
+    }
+
     for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
-      if (Volume->DiskError) {
+      if (Volume->FreeBitmap != NULL) {
+        if (!FAT_FREE_BITMAP_TEST (Volume->FreeBitmap, Index)) {
+          continue;
+        }
+      } else if (Volume->DiskError) {
         break;
+      } else if (FatGetFatEntry (Volume, Index) != FAT_CLUSTER_FREE) {
+        continue;
       }
 
-      if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
-        Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
-        Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32)Index;
-      }
+      Volume->FatInfoSector.FreeInfo.ClusterCount += 1;
+      Volume->FatInfoSector.FreeInfo.NextCluster   = (UINT32)Index;
     }
 
     Volume->FatInfoSector.Signature          = FAT_INFO_SIGNATURE;
@@ -465,9 +465,29 @@ FatFreeVolume (
   // Free disk cache
   //
   if (Volume->CacheBuffer != NULL) {
+    DEBUG ((
+      DEBUG_INFO,
+      "FatFreeVolume: fat cache %ld hits %ld misses, data cache %ld hits %ld misses %ld pages read ahead\n",
+      (UINT64)Volume->DiskCache[CacheFat].HitCount,
+      (UINT64)Volume->DiskCache[CacheFat].MissCount,
+      (UINT64)Volume->DiskCache[CacheData].HitCount,
+      (UINT64)Volume->DiskCache[CacheData].MissCount,
+      (UINT64)Volume->DiskCache[CacheData].ReadAheadPageCount
+      ));
     FreePool (Volume->CacheBuffer);
   }
 
+  //
+  // Free the free cluster bitmap
+  //
+  if (Volume->FreeBitmap != NULL) {
+    FreePool (Volume->FreeBitmap);
+  }
+
+  if (Volume->FatEntryBatch != NULL) {
+    FreePool (Volume->FatEntryBatch);
+  }
+
   //
   // Free directory cache
   //
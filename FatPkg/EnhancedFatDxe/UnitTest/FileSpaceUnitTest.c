@@ -0,0 +1,1571 @@
+/** @file
+  This is a host-based unit test for the cluster allocation, the extent map
+  and the disk cache of the FAT driver.
+
+  The FAT of the volume lives in a simulated disk accessed through the FAT
+  cache of the driver. After the cluster chains of the test files are grown
+  and shrunk, each cluster must either be free or be on the chain of exactly
+  one file, and the free cluster bitmap and the free cluster count must match
+  the FAT. Seeking a file must give the position on the disk its cluster chain
+  gives.
+
+  The disk cache tests also put the data area of the volume on the simulated
+  disk, and keep an image of what the volume should hold. Whichever way the
+  data cache accesses the disk, reading the volume must give the image, and
+  the disk must hold the image once the cache is flushed.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "../Fat.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "FAT File Space Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_FILE_COUNT            32
+#define TEST_CLUSTER_ALIGNMENT     9
+#define TEST_RANDOM_OPERATIONS     3000
+#define TEST_SEEKS_PER_FILE        4
+#define TEST_BENCHMARK_GROW_COUNT  40
+
+///
+/// The volume a test runs on.
+///
+typedef struct {
+  FAT_VOLUME_TYPE    FatType;
+  UINTN              ClusterCount;
+  BOOLEAN            DataArea;        // TRUE if the data area is on the simulated disk
+} TEST_VOLUME_CONTEXT;
+
+/// === TEST DATA ==================================================================================
+
+TEST_VOLUME_CONTEXT  mFat16Volume = { Fat16, 60000, FALSE };
+TEST_VOLUME_CONTEXT  mFat32Volume = { Fat32, 300000, FALSE };
+TEST_VOLUME_CONTEXT  mCacheVolume = { Fat32, 16384, TRUE };
+
+//
+// The tests run with the lock of the driver held.
+//
+EFI_LOCK  FatFsLock = { TPL_CALLBACK, TPL_CALLBACK, EfiLockAcquired };
+
+//
+// The volume, the files on it, the simulated disk holding its FAT and the
+// image of the data the volume should hold.
+//
+FAT_VOLUME             mVolume;
+FAT_OFILE              mFiles[TEST_FILE_COUNT];
+UINT8                  *mDisk;
+UINT8                  *mImage;
+UINTN                  mDiskSize;
+EFI_BLOCK_IO_MEDIA     mMedia;
+EFI_BLOCK_IO_PROTOCOL  mBlockIo;
+
+//
+// The FAT accesses of the driver, and the number of batch FAT writes to go
+// before one fails. No batch FAT write fails if it is 0.
+//
+UINTN    mFatAccessCount;
+UINTN    mBatchWritesUntilFailure;
+BOOLEAN  mUnexpectedDiskAccess;
+
+//
+// The reads and writes of the data area on the simulated disk.
+//
+UINTN  mDataReadCount;
+UINTN  mDataWriteCount;
+
+UINT32  mRandomSeed;
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Stub of the driver FatAccessVolumeDirty(). The dirty bit is not simulated.
+
+  @param[in] Volume      FAT file system volume.
+  @param[in] IoMode      The access mode.
+  @param[in] DirtyValue  The dirty value.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+FatAccessVolumeDirty (
+  IN FAT_VOLUME  *Volume,
+  IN IO_MODE     IoMode,
+  IN VOID        *DirtyValue
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the driver FatDiskIo(). The cached accesses go to the disk cache of
+  the driver, which accesses the simulated disk with raw accesses.
+
+  @param[in]      Volume      FAT file system volume.
+  @param[in]      IoMode      The access mode.
+  @param[in]      Offset      The starting byte offset to read from.
+  @param[in]      BufferSize  Size of Buffer.
+  @param[in, out] Buffer      Buffer containing read data.
+  @param[in]      Task        Point to task instance.
+
+  @retval EFI_SUCCESS       The access is done.
+  @retval EFI_DEVICE_ERROR  The access is out of the simulated disk, or it is
+                            the batch FAT write set to fail.
+
+**/
+EFI_STATUS
+FatDiskIo (
+  IN FAT_VOLUME  *Volume,
+  IN IO_MODE     IoMode,
+  IN UINT64      Offset,
+  IN UINTN       BufferSize,
+  IN OUT VOID    *Buffer,
+  IN FAT_TASK    *Task
+  )
+{
+  if (CACHE_ENABLED (IoMode)) {
+    mFatAccessCount++;
+    if ((IoMode == WriteFat) && (BufferSize > Volume->FatEntrySize) && (mBatchWritesUntilFailure != 0)) {
+      mBatchWritesUntilFailure--;
+      if (mBatchWritesUntilFailure == 0) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
+
+    return FatAccessCache (Volume, CACHE_TYPE (IoMode), RAW_ACCESS (IoMode), Offset, BufferSize, Buffer, Task);
+  }
+
+  if (Offset + BufferSize > mDiskSize) {
+    mUnexpectedDiskAccess = TRUE;
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (IoMode == ReadDisk) {
+    mDataReadCount += (Offset >= Volume->FirstClusterPos) ? 1 : 0;
+    CopyMem (Buffer, mDisk + Offset, BufferSize);
+  } else {
+    mDataWriteCount += (Offset >= Volume->FirstClusterPos) ? 1 : 0;
+    CopyMem (mDisk + Offset, Buffer, BufferSize);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the FlushBlocks() service of the simulated disk.
+
+  @param[in] This  The Block I/O protocol instance.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+FlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Get a pseudo random number, the same sequence on every run.
+
+  @return A number from 0 to 0x7FFF.
+
+**/
+UINTN
+GetRandom (
+  VOID
+  )
+{
+  mRandomSeed = mRandomSeed * 1103515245 + 12345;
+  return (mRandomSeed >> 16) & 0x7FFF;
+}
+
+/**
+  Read a FAT entry of the volume through the FAT cache.
+
+  @param[in] Cluster  The index of the FAT entry.
+
+  @return The value of the FAT entry, or FAT_CLUSTER_LAST if it can not be read.
+
+**/
+UINTN
+GetFatEntry (
+  IN UINTN  Cluster
+  )
+{
+  UINT32  Entry;
+
+  Entry = 0;
+  if (EFI_ERROR (FatDiskIo (&mVolume, ReadFat, mVolume.FatPos + Cluster * mVolume.FatEntrySize, mVolume.FatEntrySize, &Entry, NULL))) {
+    return (UINTN)FAT_CLUSTER_LAST;
+  }
+
+  if (mVolume.FatType == Fat16) {
+    return (Entry >= FAT_CLUSTER_SPECIAL_FAT16) ? (UINTN)(Entry | FAT_CLUSTER_SPECIAL_EXT) : Entry;
+  }
+
+  Entry &= FAT_CLUSTER_MASK_FAT32;
+  return (Entry >= FAT_CLUSTER_SPECIAL_FAT32) ? (UINTN)(Entry | FAT_CLUSTER_SPECIAL_EXT) : Entry;
+}
+
+/**
+  Get the number of clusters of a file.
+
+  @param[in] OFile  The file.
+
+  @return The number of clusters the size of the file takes.
+
+**/
+UINTN
+FileClusters (
+  IN FAT_OFILE  *OFile
+  )
+{
+  return (OFile->FileSize + mVolume.ClusterSize - 1) >> mVolume.ClusterAlignment;
+}
+
+/**
+  Check that each cluster of the volume is either free or on the cluster chain
+  of exactly one file, and that the free cluster bitmap and the free cluster
+  count match the FAT.
+
+  @retval TRUE   The volume is consistent.
+  @retval FALSE  The volume is not consistent.
+
+**/
+BOOLEAN
+VolumeIsConsistent (
+  VOID
+  )
+{
+  BOOLEAN  Consistent;
+  UINT8    *Owned;
+  UINTN    ClusterLimit;
+  UINTN    FileIndex;
+  UINTN    Cluster;
+  UINTN    ClusterCount;
+  UINTN    Entry;
+  UINTN    FreeCount;
+
+  ClusterLimit = mVolume.MaxCluster + 2;
+  Owned        = AllocateZeroPool (ClusterLimit);
+  if (Owned == NULL) {
+    return FALSE;
+  }
+
+  Consistent = !mUnexpectedDiskAccess;
+  for (FileIndex = 0; FileIndex < TEST_FILE_COUNT; FileIndex++) {
+    ClusterCount = 0;
+    Cluster      = mFiles[FileIndex].FileCluster;
+    while ((Cluster != FAT_CLUSTER_FREE) && !FAT_END_OF_FAT_CHAIN (Cluster)) {
+      if ((Cluster < FAT_MIN_CLUSTER) || (Cluster >= ClusterLimit) || Owned[Cluster]) {
+        UT_LOG_ERROR ("File %d: bad cluster 0x%x on the chain\n", (INT32)FileIndex, (UINT32)Cluster);
+        Consistent = FALSE;
+        break;
+      }
+
+      Owned[Cluster] = 1;
+      ClusterCount++;
+      Cluster = GetFatEntry (Cluster);
+    }
+
+    if (ClusterCount != FileClusters (&mFiles[FileIndex])) {
+      UT_LOG_ERROR ("File %d: %d clusters on the chain for %d\n", (INT32)FileIndex, (INT32)ClusterCount, (INT32)FileClusters (&mFiles[FileIndex]));
+      Consistent = FALSE;
+    }
+  }
+
+  FreeCount = 0;
+  for (Cluster = FAT_MIN_CLUSTER; Cluster < ClusterLimit; Cluster++) {
+    Entry = GetFatEntry (Cluster);
+    if (Entry == FAT_CLUSTER_FREE) {
+      FreeCount++;
+    }
+
+    if ((Entry != FAT_CLUSTER_FREE) != (Owned[Cluster] != 0)) {
+      UT_LOG_ERROR ("Cluster 0x%x does not match the chains of the files\n", (UINT32)Cluster);
+      Consistent = FALSE;
+    }
+
+    if ((mVolume.FreeBitmap != NULL) && (FAT_FREE_BITMAP_TEST (mVolume.FreeBitmap, Cluster) != (Entry == FAT_CLUSTER_FREE))) {
+      UT_LOG_ERROR ("Cluster 0x%x does not match the free cluster bitmap\n", (UINT32)Cluster);
+      Consistent = FALSE;
+    }
+  }
+
+  if (mVolume.FreeInfoValid && (mVolume.FatInfoSector.FreeInfo.ClusterCount != FreeCount)) {
+    UT_LOG_ERROR ("%d free clusters counted for %d\n", (INT32)mVolume.FatInfoSector.FreeInfo.ClusterCount, (INT32)FreeCount);
+    Consistent = FALSE;
+  }
+
+  FreePool (Owned);
+  return Consistent;
+}
+
+/**
+  Fragment the volume: grow the files in turn, then delete every other one.
+
+  @retval TRUE   The volume is fragmented.
+  @retval FALSE  A file can not be grown.
+
+**/
+BOOLEAN
+FragmentVolume (
+  VOID
+  )
+{
+  UINTN  Round;
+  UINTN  FileIndex;
+
+  for (Round = 0; Round < 500; Round++) {
+    FileIndex = Round % TEST_FILE_COUNT;
+    if (EFI_ERROR (FatGrowEof (&mFiles[FileIndex], mFiles[FileIndex].FileSize + 200 * mVolume.ClusterSize))) {
+      return FALSE;
+    }
+  }
+
+  for (FileIndex = 0; FileIndex < TEST_FILE_COUNT; FileIndex += 2) {
+    mFiles[FileIndex].FileSize = 0;
+    FatShrinkEof (&mFiles[FileIndex]);
+  }
+
+  return TRUE;
+}
+
+/**
+  Check that seeking a file gives the position on the disk its cluster chain
+  gives, and a run that neither passes the consecutive clusters on the chain
+  nor stops before the end of the access.
+
+  @param[in] OFile     The file.
+  @param[in] Position  The position to seek.
+  @param[in] PosLimit  The length of the access.
+
+  @retval TRUE   The seek matches the cluster chain.
+  @retval FALSE  The seek does not match the cluster chain.
+
+**/
+BOOLEAN
+SeekMatchesTheClusterChain (
+  IN FAT_OFILE  *OFile,
+  IN UINTN      Position,
+  IN UINTN      PosLimit
+  )
+{
+  UINTN   Cluster;
+  UINTN   Index;
+  UINT64  PosDisk;
+  UINTN   Run;
+
+  if (EFI_ERROR (FatOFilePosition (OFile, Position, PosLimit))) {
+    UT_LOG_ERROR ("Can not seek to 0x%x\n", (UINT32)Position);
+    return FALSE;
+  }
+
+  Cluster = OFile->FileCluster;
+  for (Index = 0; Index < Position >> mVolume.ClusterAlignment; Index++) {
+    Cluster = GetFatEntry (Cluster);
+  }
+
+  PosDisk = mVolume.FirstClusterPos +
+            LShiftU64 (Cluster - FAT_MIN_CLUSTER, mVolume.ClusterAlignment) +
+            (Position & (mVolume.ClusterSize - 1));
+  Run = mVolume.ClusterSize - (Position & (mVolume.ClusterSize - 1));
+  while (GetFatEntry (Cluster) == Cluster + 1) {
+    Run += mVolume.ClusterSize;
+    Cluster++;
+  }
+
+  if ((OFile->PosDisk != PosDisk) || (OFile->PosRem == 0) || (OFile->PosRem > Run) || (OFile->PosRem < MIN (Run, PosLimit))) {
+    UT_LOG_ERROR (
+      "Seek to 0x%x: disk 0x%lx run 0x%x for disk 0x%lx run 0x%x\n",
+      (UINT32)Position,
+      OFile->PosDisk,
+      (UINT32)OFile->PosRem,
+      PosDisk,
+      (UINT32)Run
+      );
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Check that seeking the files to random positions matches their cluster
+  chains.
+
+  @retval TRUE   The seeks match the cluster chains.
+  @retval FALSE  A seek does not match the cluster chain.
+
+**/
+BOOLEAN
+RandomSeeksMatchTheClusterChains (
+  VOID
+  )
+{
+  UINTN  FileIndex;
+  UINTN  Seek;
+  UINTN  Position;
+  UINTN  PosLimit;
+
+  for (FileIndex = 0; FileIndex < TEST_FILE_COUNT; FileIndex++) {
+    if (mFiles[FileIndex].FileSize == 0) {
+      continue;
+    }
+
+    for (Seek = 0; Seek < TEST_SEEKS_PER_FILE; Seek++) {
+      Position = (GetRandom () * 7919) % mFiles[FileIndex].FileSize;
+      PosLimit = 1 + (GetRandom () * 31) % (mFiles[FileIndex].FileSize - Position);
+      if (!SeekMatchesTheClusterChain (&mFiles[FileIndex], Position, PosLimit)) {
+        return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Grow the first file in three steps, with the second file growing between
+  the second and the third step. The extent map of the first file maps two
+  runs of 30 and 10 clusters.
+
+  @retval TRUE   The files are grown.
+  @retval FALSE  A file can not be grown.
+
+**/
+BOOLEAN
+GrowTwoRuns (
+  VOID
+  )
+{
+  return !EFI_ERROR (FatGrowEof (&mFiles[0], 10 * mVolume.ClusterSize)) &&
+         !EFI_ERROR (FatGrowEof (&mFiles[0], 30 * mVolume.ClusterSize)) &&
+         !EFI_ERROR (FatGrowEof (&mFiles[1], 10 * mVolume.ClusterSize)) &&
+         !EFI_ERROR (FatGrowEof (&mFiles[0], 40 * mVolume.ClusterSize));
+}
+
+/**
+  Get the position on the disk of a data cache page.
+
+  @param[in] PageNo  The number of the data cache page.
+
+  @return The position on the disk of the data cache page.
+
+**/
+UINT64
+DataPagePos (
+  IN UINTN  PageNo
+  )
+{
+  return mVolume.DiskCache[CacheData].BaseAddress + LShiftU64 (PageNo, mVolume.DiskCache[CacheData].PageAlignment);
+}
+
+/**
+  Find the tag of a data cache page in the data cache.
+
+  @param[in] PageNo  The number of the data cache page.
+
+  @return The tag of the data cache page, or NULL if the page is not cached.
+
+**/
+CACHE_TAG *
+FindDataCachePage (
+  IN UINTN  PageNo
+  )
+{
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       Way;
+
+  DiskCache = &mVolume.DiskCache[CacheData];
+  CacheTag  = &DiskCache->CacheTag[(PageNo & DiskCache->GroupMask) * DiskCache->GroupWays];
+  for (Way = 0; Way < DiskCache->GroupWays; Way++, CacheTag++) {
+    if ((CacheTag->RealSize > 0) && (CacheTag->PageNo == PageNo)) {
+      return CacheTag;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Write data through the data cache, and into the image of the volume.
+
+  @param[in] Offset      The position on the disk to write.
+  @param[in] BufferSize  The number of bytes to write.
+  @param[in] Seed        The seed of the bytes to write.
+
+  @retval TRUE   The data is written.
+  @retval FALSE  The data can not be written.
+
+**/
+BOOLEAN
+WriteDataArea (
+  IN UINT64  Offset,
+  IN UINTN   BufferSize,
+  IN UINT8   Seed
+  )
+{
+  UINT8       *Buffer;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  Buffer = AllocatePool (BufferSize);
+  if (Buffer == NULL) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < BufferSize; Index++) {
+    Buffer[Index] = (UINT8)(Seed + Index * 13);
+  }
+
+  Status = FatAccessCache (&mVolume, CacheData, WriteDisk, Offset, BufferSize, Buffer, NULL);
+  CopyMem (mImage + (UINTN)Offset, Buffer, BufferSize);
+  FreePool (Buffer);
+  return !EFI_ERROR (Status);
+}
+
+/**
+  Check that reading data through the data cache gives the image of the volume.
+
+  @param[in] Offset      The position on the disk to read.
+  @param[in] BufferSize  The number of bytes to read.
+
+  @retval TRUE   The data read matches the image.
+  @retval FALSE  The data read does not match the image, or can not be read.
+
+**/
+BOOLEAN
+DataMatchesTheImage (
+  IN UINT64  Offset,
+  IN UINTN   BufferSize
+  )
+{
+  UINT8       *Buffer;
+  EFI_STATUS  Status;
+  BOOLEAN     Match;
+
+  Buffer = AllocatePool (BufferSize);
+  if (Buffer == NULL) {
+    return FALSE;
+  }
+
+  Status = FatAccessCache (&mVolume, CacheData, ReadDisk, Offset, BufferSize, Buffer, NULL);
+  Match  = !EFI_ERROR (Status) && (CompareMem (Buffer, mImage + (UINTN)Offset, BufferSize) == 0);
+  if (!Match) {
+    UT_LOG_ERROR ("Read of 0x%x bytes at 0x%lx does not match the image\n", (UINT32)BufferSize, Offset);
+  }
+
+  FreePool (Buffer);
+  return Match;
+}
+
+/**
+  Check that the disk holds the image of the volume once the cache is flushed.
+
+  @retval TRUE   The disk matches the image.
+  @retval FALSE  The disk does not match the image, or the cache can not be flushed.
+
+**/
+BOOLEAN
+DiskMatchesTheImage (
+  VOID
+  )
+{
+  if (EFI_ERROR (FatVolumeFlushCache (&mVolume, NULL))) {
+    return FALSE;
+  }
+
+  return CompareMem (mDisk, mImage, mDiskSize) == 0;
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  Set up an empty volume with an empty FAT.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED                      The volume is set up.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The volume can not be set up.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VolumeSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_VOLUME_CONTEXT  *VolumeContext;
+  UINTN                FileIndex;
+  UINTN                Index;
+
+  VolumeContext = (TEST_VOLUME_CONTEXT *)Context;
+
+  ZeroMem (&mVolume, sizeof (mVolume));
+  ZeroMem (mFiles, sizeof (mFiles));
+  mVolume.Signature        = FAT_VOLUME_SIGNATURE;
+  mVolume.FatType          = VolumeContext->FatType;
+  mVolume.FatEntrySize     = (VolumeContext->FatType == Fat16) ? sizeof (UINT16) : sizeof (UINT32);
+  mVolume.MaxCluster       = VolumeContext->ClusterCount;
+  mVolume.ClusterAlignment = TEST_CLUSTER_ALIGNMENT;
+  mVolume.ClusterSize      = 1 << TEST_CLUSTER_ALIGNMENT;
+  mVolume.NumFats          = 2;
+  mVolume.FatPos           = 32 * mVolume.ClusterSize;
+  mVolume.FatSize          = ALIGN_VALUE ((mVolume.MaxCluster + 2) * mVolume.FatEntrySize, mVolume.ClusterSize);
+  mVolume.RootPos          = mVolume.FatPos + mVolume.NumFats * mVolume.FatSize;
+  mVolume.FirstClusterPos  = mVolume.RootPos;
+  mVolume.VolumeSize       = mVolume.FirstClusterPos + LShiftU64 (mVolume.MaxCluster, mVolume.ClusterAlignment);
+
+  mVolume.FatInfoSector.FreeInfo.NextCluster = FAT_MIN_CLUSTER;
+
+  mMedia.BlockSize     = 1 << TEST_CLUSTER_ALIGNMENT;
+  mBlockIo.Media       = &mMedia;
+  mBlockIo.FlushBlocks = FlushBlocks;
+  mVolume.BlockIo      = &mBlockIo;
+
+  //
+  // The data area is only accessed by the disk cache tests, so it is left out
+  // of the disk of the other tests
+  //
+  mDiskSize = (UINTN)(VolumeContext->DataArea ? mVolume.VolumeSize : mVolume.FirstClusterPos);
+  mDisk     = AllocateZeroPool (mDiskSize);
+  if (mDisk == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  if (VolumeContext->DataArea) {
+    for (Index = (UINTN)mVolume.FirstClusterPos; Index < mDiskSize; Index++) {
+      mDisk[Index] = (UINT8)(Index ^ (Index >> 8) ^ (Index >> 16));
+    }
+
+    mImage = AllocateCopyPool (mDiskSize, mDisk);
+    if (mImage == NULL) {
+      return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+    }
+  }
+
+  if (EFI_ERROR (FatInitializeDiskCache (&mVolume))) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  for (FileIndex = 0; FileIndex < TEST_FILE_COUNT; FileIndex++) {
+    mFiles[FileIndex].Signature = FAT_OFILE_SIGNATURE;
+    mFiles[FileIndex].Volume    = &mVolume;
+  }
+
+  mFatAccessCount          = 0;
+  mBatchWritesUntilFailure = 0;
+  mUnexpectedDiskAccess    = FALSE;
+  mDataReadCount           = 0;
+  mDataWriteCount          = 0;
+  mRandomSeed              = 1;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the volume and the files on it.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+**/
+VOID
+EFIAPI
+VolumeCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  FileIndex;
+
+  for (FileIndex = 0; FileIndex < TEST_FILE_COUNT; FileIndex++) {
+    FatFreeExtents (&mFiles[FileIndex]);
+  }
+
+  if (mVolume.FreeBitmap != NULL) {
+    FreePool (mVolume.FreeBitmap);
+  }
+
+  if (mVolume.FatEntryBatch != NULL) {
+    FreePool (mVolume.FatEntryBatch);
+  }
+
+  if (mVolume.CacheBuffer != NULL) {
+    FreePool (mVolume.CacheBuffer);
+  }
+
+  if (mDisk != NULL) {
+    FreePool (mDisk);
+    mDisk = NULL;
+  }
+
+  if (mImage != NULL) {
+    FreePool (mImage);
+    mImage = NULL;
+  }
+}
+
+/**
+  Growing a file on an empty volume should link one run of clusters, with a
+  FAT access for each batch of FAT entries rather than for each cluster.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GrowShouldLinkOneRun (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  ClusterCount;
+  UINTN  Cluster;
+
+  ClusterCount = mVolume.MaxCluster / 2;
+  UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[0], ClusterCount * mVolume.ClusterSize));
+
+  //
+  // Building the free cluster bitmap reads the whole FAT, linking the run
+  // reads and writes its part of the FAT
+  //
+  UT_LOG_INFO ("%d FAT accesses for %d clusters\n", (INT32)mFatAccessCount, (INT32)ClusterCount);
+  UT_ASSERT_TRUE (mFatAccessCount <= (mVolume.MaxCluster + 2 + 2 * ClusterCount) / FAT_ENTRY_BATCH_COUNT + 8);
+
+  for (Cluster = FAT_MIN_CLUSTER; Cluster < FAT_MIN_CLUSTER + ClusterCount - 1; Cluster++) {
+    UT_ASSERT_EQUAL (GetFatEntry (Cluster), Cluster + 1);
+  }
+
+  UT_ASSERT_TRUE (FAT_END_OF_FAT_CHAIN (GetFatEntry (Cluster)));
+  UT_ASSERT_EQUAL (mFiles[0].FileCluster, FAT_MIN_CLUSTER);
+  UT_ASSERT_EQUAL (mFiles[0].FileLastCluster, Cluster);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Growing and shrinking the files in a random order should keep the volume
+  consistent.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomGrowAndShrinkShouldKeepTheVolumeConsistent (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Operation;
+  UINTN       FileIndex;
+  UINTN       NewSize;
+
+  FatComputeFreeInfo (&mVolume);
+  UT_ASSERT_TRUE (mVolume.FreeInfoValid);
+  UT_ASSERT_EQUAL (mVolume.FatInfoSector.FreeInfo.ClusterCount, mVolume.MaxCluster);
+
+  for (Operation = 0; Operation < TEST_RANDOM_OPERATIONS; Operation++) {
+    FileIndex = GetRandom () % TEST_FILE_COUNT;
+    if (GetRandom () % 3 != 0) {
+      NewSize = mFiles[FileIndex].FileSize + GetRandom () % 5000;
+      if (GetRandom () % 4 == 0) {
+        NewSize += (GetRandom () % 2000) * mVolume.ClusterSize;
+      }
+
+      Status = FatGrowEof (&mFiles[FileIndex], NewSize);
+      if (Status != EFI_VOLUME_FULL) {
+        UT_ASSERT_NOT_EFI_ERROR (Status);
+      }
+    } else {
+      mFiles[FileIndex].FileSize = (mFiles[FileIndex].FileSize == 0) ? 0 : GetRandom () % mFiles[FileIndex].FileSize;
+      FatShrinkEof (&mFiles[FileIndex]);
+    }
+
+    if (Operation % 500 == 0) {
+      UT_ASSERT_TRUE (VolumeIsConsistent ());
+    }
+  }
+
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A run of clusters that fails to be linked should be freed, and the free
+  cluster count should not change.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FailedRunShouldBeFreed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  FreeCount;
+  UINTN  FileSize;
+
+  FatComputeFreeInfo (&mVolume);
+  UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[0], 2 * mVolume.ClusterSize));
+  UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[1], 2 * mVolume.ClusterSize));
+  FreeCount = mVolume.FatInfoSector.FreeInfo.ClusterCount;
+  FileSize  = mFiles[0].FileSize;
+
+  //
+  // Fail the third batch of the run, after two batches are linked
+  //
+  mBatchWritesUntilFailure = 3;
+  UT_ASSERT_STATUS_EQUAL (FatGrowEof (&mFiles[0], 5 * FAT_ENTRY_BATCH_COUNT * mVolume.ClusterSize), EFI_DEVICE_ERROR);
+  UT_ASSERT_EQUAL (mBatchWritesUntilFailure, 0);
+  UT_ASSERT_EQUAL (mFiles[0].FileSize, FileSize);
+  UT_ASSERT_EQUAL (mVolume.FatInfoSector.FreeInfo.ClusterCount, FreeCount);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[0], 5 * FAT_ENTRY_BATCH_COUNT * mVolume.ClusterSize));
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Benchmark growing a file on a fragmented volume. The time and the FAT
+  accesses it takes are logged.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GrowOnFragmentedVolumeBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN    Round;
+  UINTN    ClusterCount;
+  clock_t  Start;
+  clock_t  Elapsed;
+
+  UT_ASSERT_TRUE (FragmentVolume ());
+
+  ClusterCount    = 0;
+  mFatAccessCount = 0;
+  Start           = clock ();
+  for (Round = 0; Round < TEST_BENCHMARK_GROW_COUNT; Round++) {
+    UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[1], mFiles[1].FileSize + 2000 * mVolume.ClusterSize));
+    ClusterCount += 2000;
+  }
+
+  Elapsed = clock () - Start;
+  UT_LOG_INFO (
+    "%d clusters grown in %d us with %d FAT accesses\n",
+    (INT32)ClusterCount,
+    (INT32)((UINT64)Elapsed * 1000000 / CLOCKS_PER_SEC),
+    (INT32)mFatAccessCount
+    );
+
+  UT_ASSERT_TRUE (mFatAccessCount < ClusterCount);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Growing a file should append the clusters to its extent map, merged into
+  the last extent if they follow it on the disk.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GrowShouldAppendToTheExtentMap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_TRUE (GrowTwoRuns ());
+
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 2);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 40);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[0].FirstIndex, 0);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[0].Cluster, mFiles[0].FileCluster);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[0].Count, 30);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[1].FirstIndex, 30);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[1].Cluster, mFiles[1].FileLastCluster + 1);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[1].Count, 10);
+
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 0, mFiles[0].FileSize));
+  UT_ASSERT_EQUAL (mFiles[0].PosRem, 30 * mVolume.ClusterSize);
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 35 * mVolume.ClusterSize + 1, 1));
+  UT_ASSERT_EQUAL (mFiles[0].PosRem, 5 * mVolume.ClusterSize - 1);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Shrinking a file should truncate its extent map to the clusters left.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ShrinkShouldTruncateTheExtentMap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_TRUE (GrowTwoRuns ());
+
+  mFiles[0].FileSize = 35 * mVolume.ClusterSize - 1;
+  UT_ASSERT_NOT_EFI_ERROR (FatShrinkEof (&mFiles[0]));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 2);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 35);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[1].Count, 5);
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 34 * mVolume.ClusterSize, 1));
+
+  mFiles[0].FileSize = 20 * mVolume.ClusterSize;
+  UT_ASSERT_NOT_EFI_ERROR (FatShrinkEof (&mFiles[0]));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 1);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 20);
+  UT_ASSERT_EQUAL (mFiles[0].Extents[0].Count, 20);
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 0, mFiles[0].FileSize));
+  UT_ASSERT_EQUAL (mFiles[0].PosRem, mFiles[0].FileSize);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  //
+  // The clusters freed follow the first run, so growing the file again
+  // merges them into it
+  //
+  UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[0], 25 * mVolume.ClusterSize));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 1);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 25);
+
+  mFiles[0].FileSize = 0;
+  UT_ASSERT_NOT_EFI_ERROR (FatShrinkEof (&mFiles[0]));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 0);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 0);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  When the extent map does not map the whole cluster chain, growing a file
+  should leave the map alone, and seeking should extend it by following the
+  cluster chain.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PartialMapShouldFollowTheClusterChain (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_TRUE (GrowTwoRuns ());
+
+  //
+  // Drop the extent map, as for a file just opened, and map the first
+  // cluster only
+  //
+  FatFreeExtents (&mFiles[0]);
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 1, 1));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 1);
+
+  UT_ASSERT_NOT_EFI_ERROR (FatGrowEof (&mFiles[0], 50 * mVolume.ClusterSize));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 1);
+
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 45 * mVolume.ClusterSize, mVolume.ClusterSize));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 46);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 2);
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 0, mFiles[0].FileSize));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 50);
+
+  mFiles[0].FileSize = 45 * mVolume.ClusterSize;
+  UT_ASSERT_NOT_EFI_ERROR (FatShrinkEof (&mFiles[0]));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 45);
+  UT_ASSERT_TRUE (RandomSeeksMatchTheClusterChains ());
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Seeking files grown and shrunk in a random order on a fragmented volume
+  should match their cluster chains.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomSeeksShouldMatchTheClusterChains (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Operation;
+  UINTN       FileIndex;
+
+  UT_ASSERT_TRUE (FragmentVolume ());
+
+  for (Operation = 0; Operation < TEST_RANDOM_OPERATIONS / 10; Operation++) {
+    FileIndex = GetRandom () % TEST_FILE_COUNT;
+    if (GetRandom () % 3 != 0) {
+      Status = FatGrowEof (&mFiles[FileIndex], mFiles[FileIndex].FileSize + (GetRandom () % 64) * mVolume.ClusterSize + GetRandom () % 1000);
+      if (Status != EFI_VOLUME_FULL) {
+        UT_ASSERT_NOT_EFI_ERROR (Status);
+      }
+    } else {
+      mFiles[FileIndex].FileSize = (mFiles[FileIndex].FileSize == 0) ? 0 : GetRandom () % mFiles[FileIndex].FileSize;
+      FatShrinkEof (&mFiles[FileIndex]);
+    }
+
+    UT_ASSERT_TRUE (RandomSeeksMatchTheClusterChains ());
+  }
+
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Freeing the extent map of a file, as closing the file does, should leave
+  the file with no extent map.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FreeShouldDropTheExtentMap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_TRUE (GrowTwoRuns ());
+  UT_ASSERT_NOT_NULL (mFiles[0].Extents);
+
+  FatFreeExtents (&mFiles[0]);
+  UT_ASSERT_TRUE (mFiles[0].Extents == NULL);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 0);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentMaxCount, 0);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 0);
+
+  //
+  // A file with no extent map is freed too
+  //
+  FatFreeExtents (&mFiles[2]);
+  UT_ASSERT_TRUE (mFiles[2].Extents == NULL);
+
+  UT_ASSERT_TRUE (SeekMatchesTheClusterChain (&mFiles[0], 0, mFiles[0].FileSize));
+  UT_ASSERT_EQUAL (mFiles[0].ExtentCount, 2);
+  UT_ASSERT_EQUAL (mFiles[0].ExtentClusters, 40);
+  UT_ASSERT_TRUE (VolumeIsConsistent ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A read of the data cache long enough to access the disk directly should
+  write back a dirty cache page it covers first, and read what was written.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DirectReadShouldWriteBackDirtyPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN      PageSize;
+  UINTN      ReadCount;
+  UINTN      WriteCount;
+  CACHE_TAG  *CacheTag;
+
+  PageSize = (UINTN)1 << mVolume.DiskCache[CacheData].PageAlignment;
+  UT_ASSERT_TRUE (WriteDataArea (DataPagePos (3) + 0x100, 100, 0x5A));
+  CacheTag = FindDataCachePage (3);
+  UT_ASSERT_NOT_NULL (CacheTag);
+  UT_ASSERT_TRUE (CacheTag->Dirty);
+
+  //
+  // Pages 2 to 4 are read from the disk at once, after page 3 is written back
+  //
+  ReadCount  = mDataReadCount;
+  WriteCount = mDataWriteCount;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (2), 3 * PageSize));
+  UT_ASSERT_EQUAL (mDataReadCount, ReadCount + 1);
+  UT_ASSERT_EQUAL (mDataWriteCount, WriteCount + 1);
+  UT_ASSERT_FALSE (CacheTag->Dirty);
+  UT_ASSERT_TRUE (DiskMatchesTheImage ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A write of the data cache long enough to access the disk directly should
+  drop the cache pages it fully covers, without writing back the dirty ones.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DirectWriteShouldDropCoveredPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  PageSize;
+  UINTN  WriteCount;
+  UINTN  MissCount;
+
+  PageSize = (UINTN)1 << mVolume.DiskCache[CacheData].PageAlignment;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (5), 100));
+  UT_ASSERT_TRUE (WriteDataArea (DataPagePos (6) + 0x200, 100, 0x11));
+  UT_ASSERT_NOT_NULL (FindDataCachePage (5));
+  UT_ASSERT_TRUE (FindDataCachePage (6)->Dirty);
+
+  //
+  // Pages 4 to 6 are written to the disk at once
+  //
+  WriteCount = mDataWriteCount;
+  UT_ASSERT_TRUE (WriteDataArea (DataPagePos (4), 3 * PageSize, 0x22));
+  UT_ASSERT_EQUAL (mDataWriteCount, WriteCount + 1);
+  UT_ASSERT_TRUE (FindDataCachePage (5) == NULL);
+  UT_ASSERT_TRUE (FindDataCachePage (6) == NULL);
+
+  //
+  // The pages are loaded again with the data written
+  //
+  MissCount = mVolume.DiskCache[CacheData].MissCount;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (5) + 0x200, 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (6) + 0x200, 100));
+  UT_ASSERT_EQUAL (mVolume.DiskCache[CacheData].MissCount, MissCount + 2);
+  UT_ASSERT_TRUE (DiskMatchesTheImage ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A write of the data cache long enough to access the disk directly should
+  update the cache pages it covers at its start and at its end, and keep the
+  data written to them before.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DirectWriteShouldUpdatePartlyCoveredPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  PageSize;
+  UINTN  WriteCount;
+  UINTN  HitCount;
+
+  PageSize = (UINTN)1 << mVolume.DiskCache[CacheData].PageAlignment;
+  UT_ASSERT_TRUE (WriteDataArea (DataPagePos (8) + 0x10, 100, 0x33));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (10) + PageSize - 100, 100));
+
+  //
+  // The second half of page 8, page 9 and the first half of page 10 are
+  // written to the disk at once
+  //
+  WriteCount = mDataWriteCount;
+  UT_ASSERT_TRUE (WriteDataArea (DataPagePos (8) + PageSize / 2, 2 * PageSize, 0x44));
+  UT_ASSERT_EQUAL (mDataWriteCount, WriteCount + 1);
+  UT_ASSERT_NOT_NULL (FindDataCachePage (8));
+  UT_ASSERT_NOT_NULL (FindDataCachePage (10));
+  UT_ASSERT_TRUE (FindDataCachePage (8)->Dirty);
+  UT_ASSERT_FALSE (FindDataCachePage (10)->Dirty);
+
+  //
+  // Both halves of the pages 8 and 10 are read from the cache
+  //
+  HitCount = mVolume.DiskCache[CacheData].HitCount;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (8), PageSize / 2));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (8) + PageSize / 2, PageSize / 2));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (10), PageSize / 2));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (10) + PageSize / 2, PageSize / 2));
+  UT_ASSERT_EQUAL (mVolume.DiskCache[CacheData].HitCount, HitCount + 4);
+  UT_ASSERT_TRUE (DiskMatchesTheImage ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A cache group should hold as many pages as it has ways, and one more page
+  of the group should replace one of them and no page of another group.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GroupShouldHoldOnePagePerWay (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DISK_CACHE  *DiskCache;
+  UINTN       GroupCount;
+  UINTN       Way;
+  UINTN       HitCount;
+  UINTN       CachedCount;
+
+  DiskCache  = &mVolume.DiskCache[CacheData];
+  GroupCount = DiskCache->GroupMask + 1;
+  UT_ASSERT_EQUAL (DiskCache->GroupWays, FAT_CACHE_GROUP_WAYS);
+
+  //
+  // Page 1 is in another group than the pages 0, GroupCount, 2 * GroupCount...
+  //
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (1), 100));
+  for (Way = 0; Way < DiskCache->GroupWays; Way++) {
+    UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (Way * GroupCount), 100));
+  }
+
+  HitCount = DiskCache->HitCount;
+  for (Way = 0; Way < DiskCache->GroupWays; Way++) {
+    UT_ASSERT_NOT_NULL (FindDataCachePage (Way * GroupCount));
+    UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (Way * GroupCount) + 0x200, 100));
+  }
+
+  UT_ASSERT_EQUAL (DiskCache->HitCount, HitCount + DiskCache->GroupWays);
+
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (DiskCache->GroupWays * GroupCount), 100));
+  CachedCount = 0;
+  for (Way = 0; Way <= DiskCache->GroupWays; Way++) {
+    if (FindDataCachePage (Way * GroupCount) != NULL) {
+      CachedCount++;
+    }
+  }
+
+  UT_ASSERT_EQUAL (CachedCount, DiskCache->GroupWays);
+  UT_ASSERT_NOT_NULL (FindDataCachePage (DiskCache->GroupWays * GroupCount));
+  UT_ASSERT_NOT_NULL (FindDataCachePage (1));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A page loaded into a full cache group should replace the least recently
+  used page of the group, after writing it back if it is dirty.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EvictionShouldReplaceTheLeastRecentlyUsedPage (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DISK_CACHE  *DiskCache;
+  UINTN       GroupCount;
+  UINTN       Way;
+  UINTN       WriteCount;
+
+  DiskCache  = &mVolume.DiskCache[CacheData];
+  GroupCount = DiskCache->GroupMask + 1;
+  for (Way = 0; Way < DiskCache->GroupWays; Way++) {
+    UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (Way * GroupCount), 100));
+  }
+
+  //
+  // Page 0 is used again, so page GroupCount is the least recently used one
+  //
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (0) + 0x200, 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (4 * GroupCount), 100));
+  UT_ASSERT_TRUE (FindDataCachePage (GroupCount) == NULL);
+  UT_ASSERT_NOT_NULL (FindDataCachePage (0));
+  UT_ASSERT_NOT_NULL (FindDataCachePage (2 * GroupCount));
+  UT_ASSERT_NOT_NULL (FindDataCachePage (3 * GroupCount));
+
+  //
+  // Page 2 * GroupCount is written, then the other pages are used again
+  //
+  UT_ASSERT_TRUE (WriteDataArea (DataPagePos (2 * GroupCount) + 0x300, 100, 0x66));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (0), 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (3 * GroupCount), 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (4 * GroupCount), 100));
+
+  WriteCount = mDataWriteCount;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (5 * GroupCount), 100));
+  UT_ASSERT_TRUE (FindDataCachePage (2 * GroupCount) == NULL);
+  UT_ASSERT_EQUAL (mDataWriteCount, WriteCount + 1);
+  UT_ASSERT_MEM_EQUAL (
+    mDisk + (UINTN)DataPagePos (2 * GroupCount),
+    mImage + (UINTN)DataPagePos (2 * GroupCount),
+    (UINTN)1 << DiskCache->PageAlignment
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reading the pages in turn should read ahead a window that doubles on each
+  cache miss up to PcdFatReadAheadPageCount pages, and a miss on another page
+  should close the window.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadAheadShouldGrowOnSequentialMisses (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DISK_CACHE  *DiskCache;
+  UINTN       PageNo;
+  UINTN       ReadCount;
+
+  DiskCache = &mVolume.DiskCache[CacheData];
+  UT_ASSERT_EQUAL (DiskCache->MaxReadAheadCount, 4);
+
+  //
+  // The pages 0, 1 to 2, 3 to 5, 6 to 10 and 11 to 15 are read at once
+  //
+  for (PageNo = 0; PageNo < 16; PageNo++) {
+    UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (PageNo) + 0x100, 100));
+  }
+
+  UT_ASSERT_EQUAL (mDataReadCount, 5);
+  UT_ASSERT_EQUAL (DiskCache->MissCount, 5);
+  UT_ASSERT_EQUAL (DiskCache->HitCount, 11);
+  UT_ASSERT_EQUAL (DiskCache->ReadAheadPageCount, 1 + 2 + 4 + 4);
+
+  ReadCount = mDataReadCount;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (40), 100));
+  UT_ASSERT_EQUAL (mDataReadCount, ReadCount + 1);
+  UT_ASSERT_EQUAL (DiskCache->ReadAheadCount, 0);
+  UT_ASSERT_TRUE (FindDataCachePage (41) == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Read ahead should stop at a page that is already cached, and at a page
+  whose replacement is dirty.
+
+  @param[in] Context  The TEST_VOLUME_CONTEXT of the volume.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReadAheadShouldStopAtCachedAndDirtyPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DISK_CACHE  *DiskCache;
+  UINTN       GroupCount;
+  UINTN       Way;
+  UINTN       WriteCount;
+
+  DiskCache  = &mVolume.DiskCache[CacheData];
+  GroupCount = DiskCache->GroupMask + 1;
+
+  //
+  // The miss on page 21 follows the miss on page 20, but page 22 is cached
+  //
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (22), 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (20), 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (21), 100));
+  UT_ASSERT_EQUAL (mDataReadCount, 3);
+  UT_ASSERT_EQUAL (DiskCache->ReadAheadPageCount, 0);
+
+  //
+  // The miss on page 4 * GroupCount follows the miss on the page before it,
+  // but the group of the page after it is full of dirty pages
+  //
+  for (Way = 0; Way < DiskCache->GroupWays; Way++) {
+    UT_ASSERT_TRUE (WriteDataArea (DataPagePos (Way * GroupCount + 1) + 0x100, 100, (UINT8)Way));
+  }
+
+  WriteCount = mDataWriteCount;
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (4 * GroupCount - 1), 100));
+  UT_ASSERT_TRUE (DataMatchesTheImage (DataPagePos (4 * GroupCount), 100));
+  UT_ASSERT_EQUAL (DiskCache->ReadAheadPageCount, 0);
+  UT_ASSERT_EQUAL (mDataWriteCount, WriteCount);
+  UT_ASSERT_TRUE (FindDataCachePage (4 * GroupCount + 1) == NULL);
+  UT_ASSERT_TRUE (DiskMatchesTheImage ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  cluster allocation, the extent map and the disk cache and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      AllocationTests;
+  UNIT_TEST_SUITE_HANDLE      ExtentMapTests;
+  UNIT_TEST_SUITE_HANDLE      DiskCacheTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&AllocationTests, Framework, "FAT Cluster Allocation Tests", "FatAllocation", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for AllocationTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (AllocationTests, "Grow should link one run on fat16", "OneRun16", GrowShouldLinkOneRun, VolumeSetup, VolumeCleanup, &mFat16Volume);
+  AddTestCase (AllocationTests, "Grow should link one run on fat32", "OneRun32", GrowShouldLinkOneRun, VolumeSetup, VolumeCleanup, &mFat32Volume);
+  AddTestCase (AllocationTests, "Random grow and shrink should keep a fat16 volume consistent", "Random16", RandomGrowAndShrinkShouldKeepTheVolumeConsistent, VolumeSetup, VolumeCleanup, &mFat16Volume);
+  AddTestCase (AllocationTests, "Random grow and shrink should keep a fat32 volume consistent", "Random32", RandomGrowAndShrinkShouldKeepTheVolumeConsistent, VolumeSetup, VolumeCleanup, &mFat32Volume);
+  AddTestCase (AllocationTests, "A failed run should be freed", "FailedRun", FailedRunShouldBeFreed, VolumeSetup, VolumeCleanup, &mFat32Volume);
+  AddTestCase (AllocationTests, "Grow on a fragmented volume benchmark", "Benchmark", GrowOnFragmentedVolumeBenchmark, VolumeSetup, VolumeCleanup, &mFat32Volume);
+
+  Status = CreateUnitTestSuite (&ExtentMapTests, Framework, "FAT Extent Map Tests", "FatExtentMap", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ExtentMapTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ExtentMapTests, "Grow should append to the extent map", "Append", GrowShouldAppendToTheExtentMap, VolumeSetup, VolumeCleanup, &mFat32Volume);
+  AddTestCase (ExtentMapTests, "Shrink should truncate the extent map", "Truncate", ShrinkShouldTruncateTheExtentMap, VolumeSetup, VolumeCleanup, &mFat32Volume);
+  AddTestCase (ExtentMapTests, "A partial extent map should follow the cluster chain", "PartialMap", PartialMapShouldFollowTheClusterChain, VolumeSetup, VolumeCleanup, &mFat16Volume);
+  AddTestCase (ExtentMapTests, "Random seeks should match the cluster chains", "RandomSeek", RandomSeeksShouldMatchTheClusterChains, VolumeSetup, VolumeCleanup, &mFat32Volume);
+  AddTestCase (ExtentMapTests, "Free should drop the extent map", "Free", FreeShouldDropTheExtentMap, VolumeSetup, VolumeCleanup, &mFat32Volume);
+
+  Status = CreateUnitTestSuite (&DiskCacheTests, Framework, "FAT Disk Cache Tests", "FatDiskCache", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DiskCacheTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (DiskCacheTests, "A direct read should write back the dirty pages", "DirectReadDirty", DirectReadShouldWriteBackDirtyPages, VolumeSetup, VolumeCleanup, &mCacheVolume);
+  AddTestCase (DiskCacheTests, "A direct write should drop the covered pages", "DirectWriteFull", DirectWriteShouldDropCoveredPages, VolumeSetup, VolumeCleanup, &mCacheVolume);
+  AddTestCase (DiskCacheTests, "A direct write should update the partly covered pages", "DirectWritePartial", DirectWriteShouldUpdatePartlyCoveredPages, VolumeSetup, VolumeCleanup, &mCacheVolume);
+  AddTestCase (DiskCacheTests, "A group should hold one page per way", "SetConflict", GroupShouldHoldOnePagePerWay, VolumeSetup, VolumeCleanup, &mCacheVolume);
+  AddTestCase (DiskCacheTests, "Eviction should replace the least recently used page", "Eviction", EvictionShouldReplaceTheLeastRecentlyUsedPage, VolumeSetup, VolumeCleanup, &mCacheVolume);
+  AddTestCase (DiskCacheTests, "Read ahead should grow on sequential misses", "ReadAhead", ReadAheadShouldGrowOnSequentialMisses, VolumeSetup, VolumeCleanup, &mCacheVolume);
+  AddTestCase (DiskCacheTests, "Read ahead should stop at cached and dirty pages", "ReadAheadStop", ReadAheadShouldStopAtCachedAndDirtyPages, VolumeSetup, VolumeCleanup, &mCacheVolume);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
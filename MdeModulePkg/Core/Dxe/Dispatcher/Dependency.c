@@ -5,6 +5,11 @@
   if a driver can be scheduled for execution.  The criteria for
   schedulability is that the dependency expression is satisfied.
 
+  The first evaluation of a dependency expression resolves the protocol entry
+  referenced by every PUSH opcode. Later evaluations test those entries
+  directly, and are skipped altogether while none of the referenced protocols
+  has been installed since the expression last evaluated to FALSE.
+
 Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -180,6 +185,136 @@ CorePreProcessDepex (
   return EFI_SUCCESS;
 }
 
+/**
+  Resolve the protocol entry referenced by every PUSH opcode of the dependency
+  expression, in the order the opcodes appear. The walk stops at the first
+  END or unknown opcode, exactly like the evaluator does.
+
+  @param  DriverEntry           DriverEntry element to update.
+
+**/
+STATIC
+VOID
+CoreCompileDepex (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  UINT8     *Iterator;
+  UINT8     *End;
+  UINTN     Count;
+  UINTN     Index;
+  VOID      **Protocols;
+  EFI_GUID  DriverGuid;
+
+  Iterator = DriverEntry->Depex;
+  End      = Iterator + DriverEntry->DepexSize;
+  Count    = 0;
+  while (Iterator < End) {
+    if ((*Iterator == EFI_DEP_PUSH) || (*Iterator == EFI_DEP_REPLACE_TRUE)) {
+      if ((UINTN)(End - Iterator) <= sizeof (EFI_GUID)) {
+        break;
+      }
+
+      Count++;
+      Iterator += sizeof (EFI_GUID);
+    } else if ((*Iterator == EFI_DEP_BEFORE) || (*Iterator == EFI_DEP_AFTER)) {
+      Iterator += sizeof (EFI_GUID);
+    } else if ((*Iterator == EFI_DEP_END) || (*Iterator > EFI_DEP_SOR)) {
+      break;
+    }
+
+    Iterator++;
+  }
+
+  Protocols = NULL;
+  if (Count != 0) {
+    Protocols = AllocatePool (Count * sizeof (VOID *));
+    if (Protocols == NULL) {
+      return;
+    }
+
+    Iterator = DriverEntry->Depex;
+    for (Index = 0; Index < Count; Iterator++) {
+      if ((*Iterator == EFI_DEP_PUSH) || (*Iterator == EFI_DEP_REPLACE_TRUE)) {
+        CopyMem (&DriverGuid, Iterator + 1, sizeof (EFI_GUID));
+        Protocols[Index] = CoreGetProtocolEntry (&DriverGuid);
+        if (Protocols[Index] == NULL) {
+          break;
+        }
+
+        Index++;
+        Iterator += sizeof (EFI_GUID);
+      } else if ((*Iterator == EFI_DEP_BEFORE) || (*Iterator == EFI_DEP_AFTER)) {
+        Iterator += sizeof (EFI_GUID);
+      }
+    }
+
+    if (Index != Count) {
+      FreePool (Protocols);
+      return;
+    }
+  }
+
+  DriverEntry->DepexProtocols     = Protocols;
+  DriverEntry->DepexProtocolCount = Count;
+  DriverEntry->DepexUnsatisfied   = FALSE;
+  DriverEntry->DepexCompiled      = TRUE;
+}
+
+/**
+  Check whether any protocol referenced by the dependency expression has been
+  installed since the expression was last evaluated.
+
+  @param  DriverEntry           DriverEntry element to check.
+
+  @retval TRUE                  The result of the dependency expression may have changed.
+  @retval FALSE                 The dependency expression still evaluates to the same result.
+
+**/
+STATIC
+BOOLEAN
+CoreDepexProtocolsChanged (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  return CoreProtocolEntriesInstalledSince (
+           DriverEntry->DepexProtocols,
+           DriverEntry->DepexProtocolCount,
+           DriverEntry->DepexEvaluationKey
+           );
+}
+
+/**
+  Test whether any interface of the protocol referenced by a PUSH opcode is
+  installed.
+
+  @param  DriverEntry           DriverEntry element being evaluated.
+  @param  PushIndex             Index of the PUSH opcode in the dependency expression.
+  @param  DriverGuid            The GUID following the PUSH opcode.
+
+  @retval TRUE                  The protocol is installed.
+  @retval FALSE                 The protocol is not installed.
+
+**/
+STATIC
+BOOLEAN
+CoreIsDepexProtocolInstalled (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry,
+  IN  UINTN                  PushIndex,
+  IN  EFI_GUID               *DriverGuid
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Interface;
+
+  if (!DriverEntry->DepexCompiled || (PushIndex >= DriverEntry->DepexProtocolCount)) {
+    Status = CoreLocateProtocol (DriverGuid, NULL, &Interface);
+    return (BOOLEAN)!EFI_ERROR (Status);
+  }
+
+  return CoreIsProtocolEntryInstalled (DriverEntry->DepexProtocols[PushIndex]);
+}
+
 /**
   This is the POSTFIX version of the dependency evaluator.  This code does
   not need to handle Before or After, as it is not valid to call this
@@ -193,8 +328,9 @@ CorePreProcessDepex (
                                 was found.
 
 **/
+STATIC
 BOOLEAN
-CoreIsSchedulable (
+CoreEvaluateDepex (
   IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
   )
 {
@@ -203,18 +339,11 @@ CoreIsSchedulable (
   BOOLEAN     Operator;
   BOOLEAN     Operator2;
   EFI_GUID    DriverGuid;
-  VOID        *Interface;
+  UINTN       PushIndex;
 
   Operator  = FALSE;
   Operator2 = FALSE;
-
-  if (DriverEntry->After || DriverEntry->Before) {
-    //
-    // If Before or After Depex skip as CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter ()
-    // processes them.
-    //
-    return FALSE;
-  }
+  PushIndex = 0;
 
   DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
 
@@ -289,9 +418,7 @@ CoreIsSchedulable (
         //
         CopyMem (&DriverGuid, Iterator + 1, sizeof (EFI_GUID));
 
-        Status = CoreLocateProtocol (&DriverGuid, NULL, &Interface);
-
-        if (EFI_ERROR (Status)) {
+        if (!CoreIsDepexProtocolInstalled (DriverEntry, PushIndex, &DriverGuid)) {
           DEBUG ((DEBUG_DISPATCH, "  PUSH GUID(%g) = FALSE\n", &DriverGuid));
           Status = PushBool (FALSE);
         } else {
@@ -305,6 +432,7 @@ CoreIsSchedulable (
           return FALSE;
         }
 
+        PushIndex++;
         Iterator += sizeof (EFI_GUID);
         break;
 
@@ -409,6 +537,7 @@ CoreIsSchedulable (
           return FALSE;
         }
 
+        PushIndex++;
         Iterator += sizeof (EFI_GUID);
         break;
 
@@ -431,3 +560,54 @@ CoreIsSchedulable (
 Done:
   return FALSE;
 }
+
+/**
+  Determine whether the dependency expression of a driver is satisfied. The
+  expression is only evaluated again when one of the protocols it references
+  has been installed since it last evaluated to FALSE.
+
+  @param  DriverEntry           DriverEntry element to update.
+
+  @retval TRUE                  If driver is ready to run.
+  @retval FALSE                 If driver is not ready to run or some fatal error
+                                was found.
+
+**/
+BOOLEAN
+CoreIsSchedulable (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  UINT64   EvaluationKey;
+  BOOLEAN  Result;
+
+  if (DriverEntry->After || DriverEntry->Before) {
+    //
+    // If Before or After Depex skip as CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter ()
+    // processes them.
+    //
+    return FALSE;
+  }
+
+  if (DriverEntry->Depex == NULL) {
+    return CoreEvaluateDepex (DriverEntry);
+  }
+
+  if (!DriverEntry->DepexCompiled) {
+    CoreCompileDepex (DriverEntry);
+  } else if (DriverEntry->DepexUnsatisfied && !CoreDepexProtocolsChanged (DriverEntry)) {
+    //
+    // A PUSH that found its protocol is rewritten to EFI_DEP_REPLACE_TRUE, so
+    // only an install of a referenced protocol can change the result.
+    //
+    return FALSE;
+  }
+
+  EvaluationKey = CoreGetProtocolInstallKey ();
+  Result        = CoreEvaluateDepex (DriverEntry);
+
+  DriverEntry->DepexUnsatisfied   = (BOOLEAN)!Result;
+  DriverEntry->DepexEvaluationKey = EvaluationKey;
+
+  return Result;
+}
@@ -26,6 +26,21 @@
   Depex - Dependency Expresion.
   SOR   - Schedule On Request - Don't schedule if this bit is set.
 
+  Critical Path:
+  The entry points run one after the other on the BSP, as they call boot
+  services, which cannot be called from an AP. When DEBUG_INFO messages are
+  printed or performance measurement is enabled, the run time of every entry
+  point is measured with the timer of the CPU Architectural Protocol, and the
+  protocols it installed are told by the protocol install key before and after
+  it. Entry points that run before the CPU Architectural Protocol is installed
+  are counted with a run time of 0. The producers of a driver are the drivers
+  that last installed the protocols its Depex references. The earliest finish
+  of a driver is its run time plus the latest earliest finish of its
+  producers, which is when the driver would end if every driver started as
+  soon as its producers ended. The latest earliest finish is the critical
+  path of the Depex graph. Protocols installed outside of a driver entry
+  point, and Before and After dependencies, are not taken into account.
+
 Copyright (c) 2006 - 2018, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -84,6 +99,26 @@ typedef struct {
 
 FV_FILEPATH_DEVICE_PATH  mFvDevicePath;
 
+//
+// Driver entry point statistics. Times are in nanoseconds.
+//
+typedef struct {
+  ///
+  /// Number of driver entry points measured
+  ///
+  UINTN     Drivers;
+  ///
+  /// Sum of all entry point run times
+  ///
+  UINT64    TotalTime;
+  ///
+  /// Latest earliest finish of the entry points
+  ///
+  UINT64    CriticalPath;
+} DISPATCH_STATISTICS;
+
+DISPATCH_STATISTICS  mDispatchStatistics;
+
 //
 // Function Prototypes
 //
@@ -381,6 +416,87 @@ CoreTrust (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Returns the driver whose entry point installed the interface that moved the
+  protocol install key to a given value.
+
+  @param  InstallKey      The value of the protocol install key.
+
+  @return The driver entry, or NULL if the interface was not installed by a
+          driver entry point started by the dispatcher.
+
+**/
+STATIC
+EFI_CORE_DRIVER_ENTRY *
+CoreFindInstallingDriver (
+  IN UINT64  InstallKey
+  )
+{
+  LIST_ENTRY             *Link;
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+
+  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if ((DriverEntry->StartInstallKey < InstallKey) && (InstallKey <= DriverEntry->EndInstallKey)) {
+      return DriverEntry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Records the run time of the entry point of a driver, and computes when it
+  would have ended if it had started as soon as its Depex producers ended.
+
+  @param  DriverEntry     The driver that was started.
+  @param  StartInstallKey The protocol install key before the entry point.
+  @param  StartTime       The value of CoreReadCpuTimer() before the entry point.
+
+**/
+STATIC
+VOID
+CoreRecordDriverStart (
+  IN EFI_CORE_DRIVER_ENTRY  *DriverEntry,
+  IN UINT64                 StartInstallKey,
+  IN UINT64                 StartTime
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *Producer;
+  UINT64                 ProducersFinish;
+  UINTN                  Index;
+
+  DriverEntry->StartDuration = CoreCpuTimerElapsedTime (StartTime);
+
+  //
+  // The producers are looked up before the driver is given its install key
+  // range, so that the driver is not its own producer
+  //
+  ProducersFinish = 0;
+  for (Index = 0; Index < DriverEntry->DepexProtocolCount; Index++) {
+    Producer = CoreFindInstallingDriver (CoreGetProtocolEntryInstallKey (DriverEntry->DepexProtocols[Index]));
+    if ((Producer != NULL) && (Producer->EarliestFinish > ProducersFinish)) {
+      ProducersFinish = Producer->EarliestFinish;
+    }
+  }
+
+  DriverEntry->StartInstallKey = StartInstallKey;
+  DriverEntry->EndInstallKey   = CoreGetProtocolInstallKey ();
+  DriverEntry->EarliestFinish  = ProducersFinish + DriverEntry->StartDuration;
+
+  mDispatchStatistics.Drivers++;
+  mDispatchStatistics.TotalTime   += DriverEntry->StartDuration;
+  mDispatchStatistics.CriticalPath = MAX (mDispatchStatistics.CriticalPath, DriverEntry->EarliestFinish);
+
+  DEBUG ((
+    DEBUG_DISPATCH,
+    "Driver %g: entry point %ld ns, earliest finish %ld ns\n",
+    &DriverEntry->FileName,
+    DriverEntry->StartDuration,
+    DriverEntry->EarliestFinish
+    ));
+}
+
 /**
   This is the main Dispatcher for DXE and it exits when there are no more
   drivers to run. Drain the mScheduledQueue and load and start a PE
@@ -407,6 +523,9 @@ CoreDispatcher (
   EFI_CORE_DRIVER_ENTRY  *DriverEntry;
   BOOLEAN                ReadyToRun;
   EFI_EVENT              DxeDispatchEvent;
+  BOOLEAN                MeasureDrivers;
+  UINT64                 StartInstallKey;
+  UINT64                 StartTime;
 
   PERF_FUNCTION_BEGIN ();
 
@@ -431,7 +550,12 @@ CoreDispatcher (
     return Status;
   }
 
-  ReturnStatus = EFI_NOT_FOUND;
+  MeasureDrivers = (BOOLEAN)((DebugPrintEnabled () && DebugPrintLevelEnabled (DEBUG_INFO)) ||
+                             PerformanceMeasurementEnabled ());
+
+  StartInstallKey = 0;
+  StartTime       = 0;
+  ReturnStatus    = EFI_NOT_FOUND;
   do {
     //
     // Drain the Scheduled Queue
@@ -501,6 +625,11 @@ CoreDispatcher (
 
       CoreReleaseDispatcherLock ();
 
+      if (MeasureDrivers) {
+        StartInstallKey = CoreGetProtocolInstallKey ();
+        StartTime       = CoreReadCpuTimer ();
+      }
+
       if (DriverEntry->IsFvImage) {
         //
         // Produce a firmware volume block protocol for FvImage so it gets dispatched from.
@@ -525,6 +654,10 @@ CoreDispatcher (
           );
       }
 
+      if (MeasureDrivers) {
+        CoreRecordDriverStart (DriverEntry, StartInstallKey, StartTime);
+      }
+
       ReturnStatus = EFI_SUCCESS;
     }
 
@@ -578,6 +711,29 @@ CoreDispatcher (
   return ReturnStatus;
 }
 
+/**
+  Reports the critical path of the driver entry points versus the total time
+  spent in driver entry points.
+
+**/
+VOID
+CoreDumpDispatchStatistics (
+  VOID
+  )
+{
+  if (mDispatchStatistics.Drivers == 0) {
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Dispatch statistics: %ld drivers, critical path %ld ns of %ld ns in entry points\n",
+    (UINT64)mDispatchStatistics.Drivers,
+    mDispatchStatistics.CriticalPath,
+    mDispatchStatistics.TotalTime
+    ));
+}
+
 /**
   Insert InsertedDriverEntry onto the mScheduledQueue. To do this you
   must add any driver with a before dependency on InsertedDriverEntry first.
@@ -0,0 +1,760 @@
+/** @file
+  Host-based unit tests of the dependency evaluator of the DXE Core. The
+  dependency expressions of drivers are evaluated as protocols are installed,
+  and checked against a fresh evaluation of the same expressions. Drivers
+  whose expressions reference none of the protocols installed since their
+  last evaluation are checked to be skipped.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Dependency Evaluator Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// The protocols of the tests. The dependency expressions only reference the
+// first TEST_DEPEX_GUIDS of them.
+//
+#define TEST_GUID_COUNT     64
+#define TEST_DEPEX_GUIDS    32
+#define TEST_DRIVER_COUNT   64
+#define TEST_DEPEX_DEPTH    3
+#define TEST_DEPEX_SIZE     512
+#define TEST_INSTALL_COUNT  256
+
+STATIC EFI_GUID  mGuids[TEST_GUID_COUNT];
+STATIC UINT8     mInterfaces[TEST_GUID_COUNT];
+STATIC UINT32    mSeed;
+
+//
+// The handles the tests installed a protocol on, and the protocol of each
+//
+STATIC EFI_HANDLE  mHandles[TEST_INSTALL_COUNT];
+STATIC UINTN       mHandleGuids[TEST_INSTALL_COUNT];
+STATIC UINTN       mHandleCount;
+
+/// === STUB FUNCTIONS ===
+
+EFI_HANDLE  gDxeCoreImageHandle = NULL;
+
+/**
+  Stub of the DXE Core CoreAcquireLock(). The locks are only checked, as the
+  tests run on one thread.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseLock().
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the DXE Core CoreRaiseTpl().
+
+**/
+EFI_TPL
+EFIAPI
+CoreRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+/**
+  Stub of the DXE Core CoreRestoreTpl().
+
+**/
+VOID
+EFIAPI
+CoreRestoreTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreLocateProtocol(). The dependency expressions of
+  the tests are always compiled, so their protocols are tested through their
+  protocol entries.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreLocateProtocol (
+  IN  EFI_GUID  *Protocol,
+  IN  VOID      *Registration  OPTIONAL,
+  OUT VOID      **Interface
+  )
+{
+  ASSERT (FALSE);
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of the DXE Core CoreLocateDevicePath(). The tests install no device
+  path.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreLocateDevicePath (
+  IN     EFI_GUID                  *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL  **DevicePath,
+  OUT    EFI_HANDLE                *Device
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of the DXE Core CoreAllEfiServicesAvailable(). Every driver of the
+  tests has a dependency expression.
+
+**/
+EFI_STATUS
+CoreAllEfiServicesAvailable (
+  VOID
+  )
+{
+  ASSERT (FALSE);
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of the DXE Core CoreFreePool(), the pool comes from the host heap.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreSignalEvent(). No protocol notify is registered
+  by the tests.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSignalEvent (
+  IN EFI_EVENT  UserEvent
+  )
+{
+  ASSERT (FALSE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreConnectController(). The tests install no driver.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreConnectController (
+  IN  EFI_HANDLE                ControllerHandle,
+  IN  EFI_HANDLE                *DriverImageHandle    OPTIONAL,
+  IN  EFI_DEVICE_PATH_PROTOCOL  *RemainingDevicePath  OPTIONAL,
+  IN  BOOLEAN                   Recursive
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreDisconnectController(). The tests open no
+  protocol by driver.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreDisconnectController (
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  EFI_HANDLE  DriverImageHandle  OPTIONAL,
+  IN  EFI_HANDLE  ChildHandle        OPTIONAL
+  )
+{
+  ASSERT (FALSE);
+  return EFI_SUCCESS;
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Installs a protocol of the tests on a new handle.
+
+  @param[in]  GuidIndex  The protocol in mGuids.
+
+  @retval TRUE   The protocol was installed.
+  @retval FALSE  The protocol could not be installed.
+
+**/
+STATIC
+BOOLEAN
+InstallProtocol (
+  IN UINTN  GuidIndex
+  )
+{
+  EFI_HANDLE  Handle;
+
+  if (mHandleCount == TEST_INSTALL_COUNT) {
+    return FALSE;
+  }
+
+  Handle = NULL;
+  if (EFI_ERROR (CoreInstallProtocolInterface (&Handle, &mGuids[GuidIndex], EFI_NATIVE_INTERFACE, &mInterfaces[GuidIndex]))) {
+    return FALSE;
+  }
+
+  mHandles[mHandleCount]     = Handle;
+  mHandleGuids[mHandleCount] = GuidIndex;
+  mHandleCount++;
+  return TRUE;
+}
+
+/**
+  Appends a PUSH opcode of a protocol of the tests to a dependency
+  expression.
+
+  @param[in]      GuidIndex  The protocol in mGuids.
+  @param[in, out] Depex      The dependency expression.
+  @param[in, out] Size       The size of the dependency expression.
+
+**/
+STATIC
+VOID
+AppendPush (
+  IN     UINTN  GuidIndex,
+  IN OUT UINT8  *Depex,
+  IN OUT UINTN  *Size
+  )
+{
+  Depex[(*Size)++] = EFI_DEP_PUSH;
+  CopyGuid ((EFI_GUID *)&Depex[*Size], &mGuids[GuidIndex]);
+  *Size += sizeof (EFI_GUID);
+}
+
+/**
+  Appends a random expression over the protocols of the dependency
+  expressions, in postfix order.
+
+  @param[in]      Depth  The depth of operators left.
+  @param[in, out] Depex  The dependency expression.
+  @param[in, out] Size   The size of the dependency expression.
+
+**/
+STATIC
+VOID
+AppendRandomExpression (
+  IN     UINTN  Depth,
+  IN OUT UINT8  *Depex,
+  IN OUT UINTN  *Size
+  )
+{
+  UINT32  Choice;
+
+  Choice = (Depth == 0) ? 0 : GetRandom () % 4;
+  switch (Choice) {
+    case 0:
+      AppendPush (GetRandom () % TEST_DEPEX_GUIDS, Depex, Size);
+      break;
+
+    case 1:
+      AppendRandomExpression (Depth - 1, Depex, Size);
+      Depex[(*Size)++] = EFI_DEP_NOT;
+      break;
+
+    default:
+      AppendRandomExpression (Depth - 1, Depex, Size);
+      AppendRandomExpression (Depth - 1, Depex, Size);
+      Depex[(*Size)++] = (Choice == 2) ? EFI_DEP_AND : EFI_DEP_OR;
+      break;
+  }
+}
+
+/**
+  Creates the entry of a driver with a dependency expression, as the
+  dispatcher does for a driver it discovers.
+
+  @param[in]  Depex  The dependency expression.
+  @param[in]  Size   The size of the dependency expression.
+
+  @return The driver entry, NULL if it could not be allocated.
+
+**/
+STATIC
+EFI_CORE_DRIVER_ENTRY *
+CreateDriver (
+  IN CONST UINT8  *Depex,
+  IN UINTN        Size
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+
+  DriverEntry = AllocateZeroPool (sizeof (EFI_CORE_DRIVER_ENTRY));
+  if (DriverEntry == NULL) {
+    return NULL;
+  }
+
+  DriverEntry->Signature = EFI_CORE_DRIVER_ENTRY_SIGNATURE;
+  DriverEntry->Depex     = AllocateCopyPool (Size, Depex);
+  DriverEntry->DepexSize = Size;
+  if (DriverEntry->Depex == NULL) {
+    FreePool (DriverEntry);
+    return NULL;
+  }
+
+  CorePreProcessDepex (DriverEntry);
+  return DriverEntry;
+}
+
+/**
+  Frees the entry of a driver created by CreateDriver().
+
+  @param[in]  DriverEntry  The driver entry.
+
+**/
+STATIC
+VOID
+FreeDriver (
+  IN EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  if (DriverEntry->DepexProtocols != NULL) {
+    FreePool (DriverEntry->DepexProtocols);
+  }
+
+  FreePool (DriverEntry->Depex);
+  FreePool (DriverEntry);
+}
+
+/**
+  Evaluates a dependency expression for a new driver, which has no result
+  of an earlier evaluation to reuse.
+
+  @param[in]  Depex  The dependency expression.
+  @param[in]  Size   The size of the dependency expression.
+
+  @retval TRUE   The dependency expression is satisfied.
+  @retval FALSE  The dependency expression is not satisfied.
+
+**/
+STATIC
+BOOLEAN
+EvaluateFresh (
+  IN CONST UINT8  *Depex,
+  IN UINTN        Size
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+  BOOLEAN                Result;
+
+  DriverEntry = CreateDriver (Depex, Size);
+  ASSERT (DriverEntry != NULL);
+  Result = CoreIsSchedulable (DriverEntry);
+  FreeDriver (DriverEntry);
+  return Result;
+}
+
+/**
+  Resets the random sequence.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED  The setup succeeded.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DependencySetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mSeed        = 0x5eed;
+  mHandleCount = 0;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Uninstalls the protocols the test installed. The protocol entries stay in
+  the database, as the DXE Core never removes them.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+DependencyCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+
+  while (mHandleCount > 0) {
+    mHandleCount--;
+    Status = CoreUninstallProtocolInterface (
+               mHandles[mHandleCount],
+               &mGuids[mHandleGuids[mHandleCount]],
+               &mInterfaces[mHandleGuids[mHandleCount]]
+               );
+    ASSERT_EFI_ERROR (Status);
+  }
+}
+
+/// === TEST CASES ===
+
+/**
+  A driver whose dependency expression is not satisfied should be evaluated
+  again when a protocol its expression references is installed, and skipped
+  when only other protocols are installed.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InstallShouldReevaluateReferencingDrivers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+  UINT8                  Depex[TEST_DEPEX_SIZE];
+  UINTN                  Size;
+  UINT64                 EvaluationKey;
+
+  //
+  // PUSH 0 PUSH 1 AND END
+  //
+  Size = 0;
+  AppendPush (0, Depex, &Size);
+  AppendPush (1, Depex, &Size);
+  Depex[Size++] = EFI_DEP_AND;
+  Depex[Size++] = EFI_DEP_END;
+  DriverEntry   = CreateDriver (Depex, Size);
+  UT_ASSERT_NOT_NULL (DriverEntry);
+
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_TRUE (DriverEntry->DepexCompiled);
+  UT_ASSERT_EQUAL (DriverEntry->DepexProtocolCount, 2);
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, CoreGetProtocolInstallKey ());
+
+  //
+  // A protocol the expression does not reference
+  //
+  EvaluationKey = DriverEntry->DepexEvaluationKey;
+  UT_ASSERT_TRUE (InstallProtocol (TEST_DEPEX_GUIDS));
+  UT_ASSERT_NOT_EQUAL (CoreGetProtocolInstallKey (), EvaluationKey);
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, EvaluationKey);
+
+  //
+  // The first protocol it references
+  //
+  UT_ASSERT_TRUE (InstallProtocol (0));
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, CoreGetProtocolInstallKey ());
+  UT_ASSERT_EQUAL (((UINT8 *)DriverEntry->Depex)[0], EFI_DEP_REPLACE_TRUE);
+
+  EvaluationKey = DriverEntry->DepexEvaluationKey;
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, EvaluationKey);
+
+  //
+  // The second one satisfies the expression, which is then evaluated every
+  // time
+  //
+  UT_ASSERT_TRUE (InstallProtocol (1));
+  UT_ASSERT_TRUE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_FALSE (DriverEntry->DepexUnsatisfied);
+
+  UT_ASSERT_TRUE (InstallProtocol (TEST_DEPEX_GUIDS + 1));
+  UT_ASSERT_TRUE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, CoreGetProtocolInstallKey ());
+
+  FreeDriver (DriverEntry);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A protocol installed again on another handle should make the drivers that
+  reference it be evaluated again, even though it was already installed.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ReinstallShouldReevaluateReferencingDrivers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+  UINT8                  Depex[TEST_DEPEX_SIZE];
+  UINTN                  Size;
+  UINT64                 EvaluationKey;
+
+  //
+  // PUSH 2 NOT PUSH 3 AND END
+  //
+  Size = 0;
+  AppendPush (2, Depex, &Size);
+  Depex[Size++] = EFI_DEP_NOT;
+  AppendPush (3, Depex, &Size);
+  Depex[Size++] = EFI_DEP_AND;
+  Depex[Size++] = EFI_DEP_END;
+  DriverEntry   = CreateDriver (Depex, Size);
+  UT_ASSERT_NOT_NULL (DriverEntry);
+
+  UT_ASSERT_TRUE (InstallProtocol (2));
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  EvaluationKey = DriverEntry->DepexEvaluationKey;
+
+  UT_ASSERT_TRUE (InstallProtocol (2));
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_NOT_EQUAL (DriverEntry->DepexEvaluationKey, EvaluationKey);
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, CoreGetProtocolInstallKey ());
+
+  //
+  // The expression stays FALSE once the protocol under the NOT was found
+  //
+  UT_ASSERT_TRUE (InstallProtocol (3));
+  UT_ASSERT_FALSE (CoreIsSchedulable (DriverEntry));
+  UT_ASSERT_EQUAL (DriverEntry->DepexEvaluationKey, CoreGetProtocolInstallKey ());
+
+  FreeDriver (DriverEntry);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Drivers with random dependency expressions should be found schedulable
+  exactly when a fresh evaluation of their expression is satisfied, while
+  random protocols are installed, and be skipped when none of the protocols
+  they reference was installed.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SkippedDriversShouldMatchFreshEvaluation (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *Drivers[TEST_DRIVER_COUNT];
+  UINT8                  Depex[TEST_DRIVER_COUNT][TEST_DEPEX_SIZE];
+  UINTN                  Size[TEST_DRIVER_COUNT];
+  UINT64                 EvaluationKey;
+  UINTN                  Index;
+  UINTN                  Evaluated;
+  UINTN                  Skipped;
+  UINTN                  Schedulable;
+  BOOLEAN                Result;
+
+  for (Index = 0; Index < TEST_DRIVER_COUNT; Index++) {
+    Size[Index] = 0;
+    AppendRandomExpression (TEST_DEPEX_DEPTH, Depex[Index], &Size[Index]);
+    Depex[Index][Size[Index]++] = EFI_DEP_END;
+    Drivers[Index]              = CreateDriver (Depex[Index], Size[Index]);
+    UT_ASSERT_NOT_NULL (Drivers[Index]);
+  }
+
+  Evaluated   = 0;
+  Skipped     = 0;
+  Schedulable = 0;
+  while (mHandleCount < TEST_INSTALL_COUNT) {
+    for (Index = 0; Index < TEST_DRIVER_COUNT; Index++) {
+      EvaluationKey = Drivers[Index]->DepexEvaluationKey;
+      Result        = CoreIsSchedulable (Drivers[Index]);
+      UT_ASSERT_EQUAL (Result, EvaluateFresh (Depex[Index], Size[Index]));
+      if (Drivers[Index]->DepexEvaluationKey == CoreGetProtocolInstallKey ()) {
+        Evaluated++;
+      } else {
+        UT_ASSERT_EQUAL (Drivers[Index]->DepexEvaluationKey, EvaluationKey);
+        Skipped++;
+      }
+
+      if (Result) {
+        Schedulable++;
+      }
+    }
+
+    UT_ASSERT_TRUE (InstallProtocol (GetRandom () % TEST_GUID_COUNT));
+  }
+
+  for (Index = 0; Index < TEST_DRIVER_COUNT; Index++) {
+    FreeDriver (Drivers[Index]);
+  }
+
+  UT_ASSERT_NOT_EQUAL (Skipped, 0);
+  UT_ASSERT_NOT_EQUAL (Schedulable, 0);
+  UT_LOG_INFO (
+    "%d evaluations, %d skipped, %d schedulable\n",
+    (INT32)Evaluated,
+    (INT32)Skipped,
+    (INT32)Schedulable
+    );
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  dependency evaluator of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      DependencyTests;
+  UINTN                       Index;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // The protocols are random GUIDs, like the ones of real protocols
+  //
+  mSeed = 0x5eed;
+  for (Index = 0; Index < TEST_GUID_COUNT; Index++) {
+    mGuids[Index].Data1 = GetRandom () ^ (GetRandom () << 16);
+    mGuids[Index].Data2 = (UINT16)GetRandom ();
+    mGuids[Index].Data3 = (UINT16)GetRandom ();
+    WriteUnaligned32 ((UINT32 *)&mGuids[Index].Data4[0], GetRandom () ^ (GetRandom () << 16));
+    WriteUnaligned32 ((UINT32 *)&mGuids[Index].Data4[4], GetRandom () ^ (GetRandom () << 16));
+  }
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core Dependency Evaluator Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&DependencyTests, Framework, "DXE Core Dependency Evaluator Tests", "DxeCore.Dispatcher.Depex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Dependency Evaluator Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite--------------Description-----------------------------------------------------Name---------Function------------------------------------Pre--------------Post---------------Context-----------
+  //
+  AddTestCase (DependencyTests, "Installing a referenced protocol re-evaluates the depex", "Install", InstallShouldReevaluateReferencingDrivers, DependencySetup, DependencyCleanup, NULL);
+  AddTestCase (DependencyTests, "Reinstalling a referenced protocol re-evaluates the depex", "Reinstall", ReinstallShouldReevaluateReferencingDrivers, DependencySetup, DependencyCleanup, NULL);
+  AddTestCase (DependencyTests, "Skipped drivers match a fresh evaluation", "Skip", SkippedDriversShouldMatchFreshEvaluation, DependencySetup, DependencyCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCoreDependencyUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCoreDependencyUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
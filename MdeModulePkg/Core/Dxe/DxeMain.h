@@ -45,6 +45,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
 #include <Protocol/PeCoffImageEmulator.h>
+#include <Protocol/MemorySpaceAttributesBatch.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -62,6 +63,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/VectorHandoffTable.h>
 #include <Ppi/VectorHandoffInfo.h>
 #include <Guid/MemoryProfile.h>
+#include <Guid/ExtendedFirmwarePerformance.h>
 
 #include <Library/DxeCoreEntryPoint.h>
 #include <Library/DebugLib.h>
@@ -69,6 +71,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseLib.h>
 #include <Library/HobLib.h>
 #include <Library/PerformanceLib.h>
+#include <Library/PrintLib.h>
 #include <Library/UefiDecompressLib.h>
 #include <Library/ExtractGuidedSectionLib.h>
 #include <Library/CacheMaintenanceLib.h>
@@ -160,23 +163,42 @@ typedef struct {
 
   EFI_HANDLE                       ImageHandle;
   BOOLEAN                          IsFvImage;
+
+  BOOLEAN                          DepexCompiled;
+  BOOLEAN                          DepexUnsatisfied;
+  VOID                             **DepexProtocols; // PROTOCOL_ENTRY of each PUSH opcode in Depex
+  UINTN                            DepexProtocolCount;
+  UINT64                           DepexEvaluationKey; // gProtocolInstallKey at the last evaluation
+
+  UINT64                           StartInstallKey;  // gProtocolInstallKey before the entry point
+  UINT64                           EndInstallKey;    // gProtocolInstallKey after the entry point
+  UINT64                           StartDuration;    // Entry point run time in nanoseconds
+  UINT64                           EarliestFinish;   // Critical path to the end of the entry point in nanoseconds
 } EFI_CORE_DRIVER_ENTRY;
 
 //
 // The data structure of GCD memory map entry
 //
 #define EFI_GCD_MAP_SIGNATURE  SIGNATURE_32('g','c','d','m')
-typedef struct {
-  UINTN                   Signature;
-  LIST_ENTRY              Link;
-  EFI_PHYSICAL_ADDRESS    BaseAddress;
-  UINT64                  EndAddress;
-  UINT64                  Capabilities;
-  UINT64                  Attributes;
-  EFI_GCD_MEMORY_TYPE     GcdMemoryType;
-  EFI_GCD_IO_TYPE         GcdIoType;
-  EFI_HANDLE              ImageHandle;
-  EFI_HANDLE              DeviceHandle;
+typedef struct _EFI_GCD_MAP_ENTRY {
+  UINTN                        Signature;
+  LIST_ENTRY                   Link;
+  EFI_PHYSICAL_ADDRESS         BaseAddress;
+  UINT64                       EndAddress;
+  UINT64                       Capabilities;
+  UINT64                       Attributes;
+  EFI_GCD_MEMORY_TYPE          GcdMemoryType;
+  EFI_GCD_IO_TYPE              GcdIoType;
+  EFI_HANDLE                   ImageHandle;
+  EFI_HANDLE                   DeviceHandle;
+
+  //
+  // Node of the tree of the GCD map. The tree is an AVL tree ordered by
+  // BaseAddress, and TreeHeight is the height of the subtree of the entry.
+  //
+  struct _EFI_GCD_MAP_ENTRY    *TreeLeft;
+  struct _EFI_GCD_MAP_ENTRY    *TreeRight;
+  UINTN                        TreeHeight;
 } EFI_GCD_MAP_ENTRY;
 
 #define LOADED_IMAGE_PRIVATE_DATA_SIGNATURE  SIGNATURE_32('l','d','r','i')
@@ -260,6 +282,8 @@ extern BOOLEAN  gMemoryMapTerminated;
 
 extern EFI_DECOMPRESS_PROTOCOL  gEfiDecompress;
 
+extern EDKII_MEMORY_SPACE_ATTRIBUTES_BATCH_PROTOCOL  gMemorySpaceAttributesBatch;
+
 extern EFI_RUNTIME_ARCH_PROTOCOL         *gRuntime;
 extern EFI_CPU_ARCH_PROTOCOL             *gCpu;
 extern EFI_WATCHDOG_TIMER_ARCH_PROTOCOL  *gWatchdogTimer;
@@ -439,6 +463,72 @@ CalculateEfiHdrCrc (
   IN  OUT EFI_TABLE_HEADER  *Hdr
   );
 
+/**
+  Reports the timer database statistics collected during boot services.
+
+**/
+VOID
+CoreDumpTimerStatistics (
+  VOID
+  );
+
+/**
+  Reports the event notification statistics collected during boot services.
+
+**/
+VOID
+CoreDumpEventStatistics (
+  VOID
+  );
+
+/**
+  Reports the protocol index statistics collected during boot services, in
+  the debug log and as PERF_EVENT records.
+
+**/
+VOID
+CoreDumpProtocolIndexStatistics (
+  VOID
+  );
+
+/**
+  Reports the critical path of the driver entry points versus the total time
+  spent in driver entry points.
+
+**/
+VOID
+CoreDumpDispatchStatistics (
+  VOID
+  );
+
+/**
+  Reads the timer of the CPU Architectural Protocol.
+
+  @return The value of the timer, or 0 if the CPU Architectural Protocol is
+          not installed yet or its timer can not be read.
+
+**/
+UINT64
+CoreReadCpuTimer (
+  VOID
+  );
+
+/**
+  Returns the time elapsed since an earlier value of the timer of the CPU
+  Architectural Protocol.
+
+  @param  StartValue             The value returned by CoreReadCpuTimer() at
+                                 the start of the interval.
+
+  @return The elapsed time in nanoseconds, or 0 if the timer could not be
+          read at the start or at the end of the interval.
+
+**/
+UINT64
+CoreCpuTimerElapsedTime (
+  IN UINT64  StartValue
+  );
+
 /**
   Called by the platform code to process a tick.
 
@@ -1069,6 +1159,81 @@ CoreGetHandleDatabaseKey (
   VOID
   );
 
+/**
+  Returns the protocol entry of a protocol, creating the entry when no
+  interface of the protocol has been installed yet. The entry stays valid
+  for the life of the protocol database.
+
+  @param  Protocol               The ID of the protocol
+
+  @return Protocol entry, or NULL if it could not be created
+
+**/
+VOID *
+CoreGetProtocolEntry (
+  IN EFI_GUID  *Protocol
+  );
+
+/**
+  Check whether any interface of the protocol of a protocol entry is installed.
+
+  @param  ProtocolEntry          Protocol entry returned by CoreGetProtocolEntry()
+
+  @retval TRUE                   An interface of the protocol is installed.
+  @retval FALSE                  No interface of the protocol is installed.
+
+**/
+BOOLEAN
+CoreIsProtocolEntryInstalled (
+  IN VOID  *ProtocolEntry
+  );
+
+/**
+  Returns the protocol install key of the last install of an interface of the
+  protocol of a protocol entry.
+
+  @param  ProtocolEntry          Protocol entry returned by CoreGetProtocolEntry()
+
+  @return The value of the protocol install key after the last install, or 0
+          if no interface of the protocol is installed.
+
+**/
+UINT64
+CoreGetProtocolEntryInstallKey (
+  IN VOID  *ProtocolEntry
+  );
+
+/**
+  Check whether an interface of the protocol of any of the protocol entries
+  has been installed since the protocol install key had a given value.
+
+  @param  ProtocolEntries        Protocol entries returned by CoreGetProtocolEntry()
+  @param  Count                  Number of entries in ProtocolEntries
+  @param  InstallKey             Value returned by CoreGetProtocolInstallKey()
+
+  @retval TRUE                   An interface has been installed since InstallKey.
+  @retval FALSE                  No interface has been installed since InstallKey.
+
+**/
+BOOLEAN
+CoreProtocolEntriesInstalledSince (
+  IN VOID    **ProtocolEntries,
+  IN UINTN   Count,
+  IN UINT64  InstallKey
+  );
+
+/**
+  return protocol install key, it is increased on every protocol interface
+  install and reinstall.
+
+  @return Protocol install key.
+
+**/
+UINT64
+CoreGetProtocolInstallKey (
+  VOID
+  );
+
 /**
   Go connect any handles that were created or modified while a image executed.
 
@@ -1749,6 +1914,37 @@ CoreSetMemorySpaceAttributes (
   IN UINT64                Attributes
   );
 
+/**
+  Set the attributes of a list of memory space ranges.
+
+  The ranges are sorted by address and must not overlap. All of them are
+  checked against the GCD memory space map before any attribute is changed.
+  Contiguous ranges that map to the same CPU arch attributes are then set with
+  a single CPU Architectural Protocol call, even when their GCD attributes
+  differ, and contiguous ranges with the same attributes are updated in the
+  GCD memory space map at once.
+
+  @param  RangeCount            The number of entries in Ranges.
+  @param  Ranges                The memory space ranges and their attributes.
+  @param  FailedIndex           On error, the index in Ranges of the range
+                                that failed. Optional.
+
+  @retval EFI_SUCCESS           The attributes were set for all ranges.
+  @retval EFI_INVALID_PARAMETER RangeCount is 0, Ranges is NULL, a range is
+                                empty or two ranges overlap.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to sort the ranges.
+  @retval Others                The status CoreSetMemorySpaceAttributes()
+                                would return for the range that failed.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSetMemorySpaceAttributesBatch (
+  IN  UINTN                                      RangeCount,
+  IN  CONST EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE  *Ranges,
+  OUT UINTN                                      *FailedIndex  OPTIONAL
+  );
+
 /**
   Modifies the capabilities for a memory region in the global coherency domain of the
   processor.
@@ -498,6 +498,17 @@ DxeMain (
              );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Publish the memory space attributes batch protocol on the DXE Core image handle
+  //
+  Status = CoreInstallMultipleProtocolInterfaces (
+             &gDxeCoreImageHandle,
+             &gEdkiiMemorySpaceAttributesBatchProtocolGuid,
+             &gMemorySpaceAttributesBatch,
+             NULL
+             );
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Register for the GUIDs of the Architectural Protocols, so the rest of the
   // EFI Boot Services and EFI Runtime Services tables can be filled in.
@@ -788,6 +799,14 @@ CoreExitBootServices (
 
   gMemoryMapTerminated = TRUE;
 
+  //
+  // Dump the statistics once, ExitBootServices() can no longer fail and be retried
+  //
+  CoreDumpTimerStatistics ();
+  CoreDumpEventStatistics ();
+  CoreDumpProtocolIndexStatistics ();
+  CoreDumpDispatchStatistics ();
+
   //
   // Notify other drivers that we are exiting boot services.
   //
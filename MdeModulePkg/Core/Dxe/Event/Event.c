@@ -30,10 +30,36 @@ LIST_ENTRY  gEventQueue[TPL_HIGH_LEVEL + 1];
 ///
 UINTN  gEventPending = 0;
 
+//
+// Static initializers of empty buckets of mEventGroupBuckets
+//
+#define EVENT_GROUP_BUCKET(Index)  { &mEventGroupBuckets[Index], &mEventGroupBuckets[Index] }
+#define EVENT_GROUP_BUCKETS_4(Index)                                  \
+  EVENT_GROUP_BUCKET (Index),       EVENT_GROUP_BUCKET ((Index) + 1), \
+  EVENT_GROUP_BUCKET ((Index) + 2), EVENT_GROUP_BUCKET ((Index) + 3)
+#define EVENT_GROUP_BUCKETS_16(Index)                                       \
+  EVENT_GROUP_BUCKETS_4 (Index),       EVENT_GROUP_BUCKETS_4 ((Index) + 4), \
+  EVENT_GROUP_BUCKETS_4 ((Index) + 8), EVENT_GROUP_BUCKETS_4 ((Index) + 12)
+
+///
+/// mEventGroupBuckets - The EVENT_GROUPs holding the events to signal based
+/// on EventGroup type, hashed by their GUID. The buckets are initialized
+/// statically, as DxeMain() installs configuration tables, which signals
+/// their event groups, before the event services are initialized.
+///
+LIST_ENTRY  mEventGroupBuckets[EVENT_GROUP_BUCKET_COUNT] = {
+  EVENT_GROUP_BUCKETS_16 (0),
+  EVENT_GROUP_BUCKETS_16 (16),
+  EVENT_GROUP_BUCKETS_16 (32),
+  EVENT_GROUP_BUCKETS_16 (48)
+};
+
+STATIC_ASSERT (EVENT_GROUP_BUCKET_COUNT == 64, "mEventGroupBuckets initializes 64 buckets");
+
 ///
-/// gEventSignalQueue - A list of events to signal based on EventGroup type
+/// mEventStatistics - Event notification counters
 ///
-LIST_ENTRY  gEventSignalQueue = INITIALIZE_LIST_HEAD_VARIABLE (gEventSignalQueue);
+EVENT_STATISTICS  mEventStatistics;
 
 ///
 /// Enumerate the valid types
@@ -177,6 +203,7 @@ CoreDispatchEventNotifies (
       Event->SignalCount = 0;
     }
 
+    mEventStatistics.Dispatched[Priority]++;
     CoreReleaseEventLock ();
 
     //
@@ -228,6 +255,60 @@ CoreNotifyEvent (
   gEventPending |= (UINTN)(1 << Event->NotifyTpl);
 }
 
+/**
+  Returns the bucket of mEventGroupBuckets an event group GUID hashes to.
+
+  @param  EventGroup             The GUID of the event group
+
+  @return The head of the bucket
+
+**/
+STATIC
+LIST_ENTRY *
+CoreGetEventGroupBucket (
+  IN CONST EFI_GUID  *EventGroup
+  )
+{
+  UINT64  Hash;
+
+  Hash  = ReadUnaligned64 ((CONST UINT64 *)EventGroup) ^
+          ReadUnaligned64 ((CONST UINT64 *)EventGroup + 1);
+  Hash ^= RShiftU64 (Hash, 32);
+  return &mEventGroupBuckets[(UINTN)Hash & (EVENT_GROUP_BUCKET_COUNT - 1)];
+}
+
+/**
+  Finds the record of an event group.
+  The gEventQueueLock must be owned
+
+  @param  EventGroup             The GUID of the event group
+
+  @return The event group record, or NULL if no event of the group exists
+
+**/
+STATIC
+EVENT_GROUP *
+CoreFindEventGroup (
+  IN CONST EFI_GUID  *EventGroup
+  )
+{
+  LIST_ENTRY   *Head;
+  LIST_ENTRY   *Link;
+  EVENT_GROUP  *Group;
+
+  ASSERT_LOCKED (&gEventQueueLock);
+
+  Head = CoreGetEventGroupBucket (EventGroup);
+  for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+    Group = CR (Link, EVENT_GROUP, Link, EVENT_GROUP_SIGNATURE);
+    if (CompareGuid (&Group->EventGroup, EventGroup)) {
+      return Group;
+    }
+  }
+
+  return NULL;
+}
+
 /**
   Signals all events in the EventGroup.
 
@@ -239,23 +320,52 @@ CoreNotifySignalList (
   IN EFI_GUID  *EventGroup
   )
 {
-  LIST_ENTRY  *Link;
-  LIST_ENTRY  *Head;
-  IEVENT      *Event;
+  LIST_ENTRY   *Link;
+  LIST_ENTRY   *Head;
+  IEVENT       *Event;
+  EVENT_GROUP  *Group;
 
   CoreAcquireEventLock ();
 
-  Head = &gEventSignalQueue;
-  for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
-    Event = CR (Link, IEVENT, SignalLink, EVENT_SIGNATURE);
-    if (CompareGuid (&Event->EventGroup, EventGroup)) {
+  mEventStatistics.GroupSignals++;
+  Group = CoreFindEventGroup (EventGroup);
+  if (Group != NULL) {
+    Head = &Group->Events;
+    for (Link = Head->ForwardLink; Link != Head; Link = Link->ForwardLink) {
+      Event = CR (Link, IEVENT, SignalLink, EVENT_SIGNATURE);
       CoreNotifyEvent (Event);
+      mEventStatistics.GroupMembers++;
     }
   }
 
   CoreReleaseEventLock ();
 }
 
+/**
+  Reports the event notification statistics collected during boot services.
+
+**/
+VOID
+CoreDumpEventStatistics (
+  VOID
+  )
+{
+  EFI_TPL  Tpl;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Event statistics: %ld group signals, %ld group members queued\n",
+    mEventStatistics.GroupSignals,
+    mEventStatistics.GroupMembers
+    ));
+
+  for (Tpl = 0; Tpl <= TPL_HIGH_LEVEL; Tpl++) {
+    if (mEventStatistics.Dispatched[Tpl] != 0) {
+      DEBUG ((DEBUG_INFO, "  TPL %ld: %ld notifications dispatched\n", (UINT64)Tpl, mEventStatistics.Dispatched[Tpl]));
+    }
+  }
+}
+
 /**
   Creates an event.
 
@@ -364,9 +474,11 @@ CoreCreateEventInternal (
   OUT EFI_EVENT        *Event
   )
 {
-  EFI_STATUS  Status;
-  IEVENT      *IEvent;
-  INTN        Index;
+  EFI_STATUS   Status;
+  IEVENT       *IEvent;
+  INTN         Index;
+  EVENT_GROUP  *Group;
+  EVENT_GROUP  *NewGroup;
 
   if (Event == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -437,6 +549,16 @@ CoreCreateEventInternal (
     NotifyContext  = NULL;
   }
 
+  //
+  // Make room for the event in the timer database.
+  //
+  if ((Type & EVT_TIMER) != 0) {
+    Status = CoreReserveEventTimer ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
   //
   // Allocate and initialize a new event structure.
   //
@@ -447,6 +569,10 @@ CoreCreateEventInternal (
   }
 
   if (IEvent == NULL) {
+    if ((Type & EVT_TIMER) != 0) {
+      CoreReleaseEventTimer ();
+    }
+
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -461,6 +587,37 @@ CoreCreateEventInternal (
     IEvent->ExFlag |= EVT_EXFLAG_EVENT_GROUP;
   }
 
+  NewGroup = NULL;
+  CoreAcquireEventLock ();
+
+  if ((Type & EVT_NOTIFY_SIGNAL) != 0x00000000) {
+    //
+    // Pool cannot be allocated while holding the event lock, so the record of
+    // a group seen for the first time is allocated with the lock released.
+    // A notification function may create or free the group meanwhile, so
+    // look it up again once the lock is taken back.
+    //
+    while ((CoreFindEventGroup (&IEvent->EventGroup) == NULL) && (NewGroup == NULL)) {
+      CoreReleaseEventLock ();
+
+      NewGroup = AllocatePool (sizeof (EVENT_GROUP));
+      if (NewGroup == NULL) {
+        if ((Type & EVT_TIMER) != 0) {
+          CoreReleaseEventTimer ();
+        }
+
+        CoreFreePool (IEvent);
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      NewGroup->Signature = EVENT_GROUP_SIGNATURE;
+      CopyGuid (&NewGroup->EventGroup, &IEvent->EventGroup);
+      InitializeListHead (&NewGroup->Events);
+
+      CoreAcquireEventLock ();
+    }
+  }
+
   *Event = IEvent;
 
   if ((Type & EVT_RUNTIME) != 0) {
@@ -483,17 +640,26 @@ CoreCreateEventInternal (
     InsertTailList (&gRuntime->EventHead, &IEvent->RuntimeData.Link);
   }
 
-  CoreAcquireEventLock ();
-
   if ((Type & EVT_NOTIFY_SIGNAL) != 0x00000000) {
     //
     // The Event's NotifyFunction must be queued whenever the event is signaled
     //
-    InsertHeadList (&gEventSignalQueue, &IEvent->SignalLink);
+    Group = CoreFindEventGroup (&IEvent->EventGroup);
+    if (Group == NULL) {
+      Group    = NewGroup;
+      NewGroup = NULL;
+      InsertTailList (CoreGetEventGroupBucket (&Group->EventGroup), &Group->Link);
+    }
+
+    InsertHeadList (&Group->Events, &IEvent->SignalLink);
   }
 
   CoreReleaseEventLock ();
 
+  if (NewGroup != NULL) {
+    CoreFreePool (NewGroup);
+  }
+
   //
   // Done
   //
@@ -701,8 +867,9 @@ CoreCloseEvent (
   IN EFI_EVENT  UserEvent
   )
 {
-  EFI_STATUS  Status;
-  IEVENT      *Event;
+  EFI_STATUS   Status;
+  IEVENT       *Event;
+  EVENT_GROUP  *Group;
 
   Event = UserEvent;
 
@@ -719,6 +886,7 @@ CoreCloseEvent (
   //
   if ((Event->Type & EVT_TIMER) != 0) {
     CoreSetTimer (Event, TimerCancel, 0);
+    CoreReleaseEventTimer ();
   }
 
   CoreAcquireEventLock ();
@@ -735,12 +903,27 @@ CoreCloseEvent (
     RemoveEntryList (&Event->NotifyLink);
   }
 
+  Group = NULL;
   if (Event->SignalLink.ForwardLink != NULL) {
     RemoveEntryList (&Event->SignalLink);
+
+    //
+    // Take the group record off its bucket along with the last event of the group
+    //
+    Group = CoreFindEventGroup (&Event->EventGroup);
+    if ((Group != NULL) && IsListEmpty (&Group->Events)) {
+      RemoveEntryList (&Group->Link);
+    } else {
+      Group = NULL;
+    }
   }
 
   CoreReleaseEventLock ();
 
+  if (Group != NULL) {
+    CoreFreePool (Group);
+  }
+
   //
   // If the event is registered on a protocol notify, then remove it from the protocol database
   //
@@ -30,11 +30,96 @@ extern  UINTN  gEventPending;
 /// Timer event information
 ///
 typedef struct {
-  LIST_ENTRY    Link;
-  UINT64        TriggerTime;
-  UINT64        Period;
+  ///
+  /// 1-based position in the timer database heap, 0 if not queued
+  ///
+  UINTN     HeapIndex;
+  ///
+  /// Insertion order, to keep timers with equal trigger times in FIFO order
+  ///
+  UINT64    Sequence;
+  UINT64    TriggerTime;
+  UINT64    Period;
 } TIMER_EVENT_INFO;
 
+///
+/// Timer database statistics
+///
+typedef struct {
+  ///
+  /// Number of CoreTimerTick() calls
+  ///
+  UINT64    TickCount;
+  ///
+  /// Number of CoreCheckTimers() runs
+  ///
+  UINT64    CheckCount;
+  ///
+  /// Number of timers that expired
+  ///
+  UINT64    ExpiredCount;
+  ///
+  /// Number of heap levels traversed by insert and remove operations
+  ///
+  UINT64    HeapSteps;
+  ///
+  /// Largest number of timers queued at once
+  ///
+  UINTN     MaxQueued;
+  ///
+  /// Time spent in CoreTimerTick() in nanoseconds
+  ///
+  UINT64    TickTime;
+  ///
+  /// Time spent in CoreCheckTimers() in nanoseconds, not counting the notify
+  /// functions of the timers it signaled
+  ///
+  UINT64    CheckTime;
+} TIMER_STATISTICS;
+
+///
+/// Event notification statistics
+///
+typedef struct {
+  ///
+  /// Number of notification functions dispatched at each TPL
+  ///
+  UINT64    Dispatched[TPL_HIGH_LEVEL + 1];
+  ///
+  /// Number of CoreNotifySignalList() calls
+  ///
+  UINT64    GroupSignals;
+  ///
+  /// Number of event group members queued by CoreNotifySignalList()
+  ///
+  UINT64    GroupMembers;
+} EVENT_STATISTICS;
+
+#define EVENT_GROUP_SIGNATURE  SIGNATURE_32('e','v','g','p')
+
+//
+// Number of hash buckets of the event groups, must be a power of two
+//
+#define EVENT_GROUP_BUCKET_COUNT  64
+
+///
+/// All EVT_NOTIFY_SIGNAL events sharing an EventGroup GUID. Events that
+/// are not part of a group are kept in the group with the zero GUID. The
+/// record is freed when the last event of the group is closed.
+///
+typedef struct {
+  UINTN         Signature;
+  ///
+  /// Link on the bucket of mEventGroupBuckets the GUID hashes to
+  ///
+  LIST_ENTRY    Link;
+  EFI_GUID      EventGroup;
+  ///
+  /// List of IEVENT.SignalLink
+  ///
+  LIST_ENTRY    Events;
+} EVENT_GROUP;
+
 #define EVENT_SIGNATURE  SIGNATURE_32('e','v','n','t')
 typedef struct {
   UINTN                      Signature;
@@ -85,4 +170,28 @@ CoreInitializeTimer (
   VOID
   );
 
+/**
+  Reserves an entry in the timer database for a new timer event. The
+  database is grown here, outside of the timer lock, so that arming a timer
+  never allocates memory.
+
+  @retval EFI_SUCCESS            An entry was reserved.
+  @retval EFI_OUT_OF_RESOURCES   The timer database could not be grown.
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  );
+
+/**
+  Releases the timer database entry reserved by CoreReserveEventTimer().
+  The timer event must not be queued.
+
+**/
+VOID
+CoreReleaseEventTimer (
+  VOID
+  );
+
 #endif
@@ -9,21 +9,158 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "DxeMain.h"
 #include "Event.h"
 
+//
+// Initial number of entries of the timer database
+//
+#define TIMER_HEAP_INITIAL_CAPACITY  32
+
 //
 // Internal data
 //
 
-LIST_ENTRY  mEfiTimerList       = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
-EFI_LOCK    mEfiTimerLock       = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
-EFI_EVENT   mEfiCheckTimerEvent = NULL;
+//
+// The timer database is a binary min-heap of timer events ordered by
+// Timer.TriggerTime, and by insertion order for equal trigger times. The
+// heap is 1-based: mEfiTimerHeap[1] is the next timer to expire, and a
+// Timer.HeapIndex of 0 means the event is not queued.
+//
+// The heap is sized to hold every timer event in existence, so queuing a
+// timer never needs to allocate memory while mEfiTimerLock is held.
+//
+IEVENT            **mEfiTimerHeap       = NULL;
+UINTN             mEfiTimerHeapCount    = 0;
+UINTN             mEfiTimerHeapCapacity = 0;
+UINTN             mEfiTimerEventCount   = 0;
+UINT64            mEfiTimerSequence     = 0;
+EFI_LOCK          mEfiTimerLock         = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
+EFI_EVENT         mEfiCheckTimerEvent   = NULL;
+TIMER_STATISTICS  mEfiTimerStatistics;
 
 EFI_LOCK  mEfiSystemTimeLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 UINT64    mEfiSystemTime     = 0;
 
+//
+// Period of the timer of the CPU Architectural Protocol in femtoseconds, 0
+// until it has been read
+//
+UINT64  mCpuTimerPeriod = 0;
+
 //
 // Timer functions
 //
 
+/**
+  Check whether a timer event expires before another one.
+
+  @param  Event1                 The first timer event.
+  @param  Event2                 The second timer event.
+
+  @retval TRUE                   Event1 expires before Event2.
+  @retval FALSE                  Event1 does not expire before Event2.
+
+**/
+STATIC
+BOOLEAN
+TimerExpiresBefore (
+  IN IEVENT  *Event1,
+  IN IEVENT  *Event2
+  )
+{
+  if (Event1->Timer.TriggerTime != Event2->Timer.TriggerTime) {
+    return (BOOLEAN)(Event1->Timer.TriggerTime < Event2->Timer.TriggerTime);
+  }
+
+  return (BOOLEAN)(Event1->Timer.Sequence < Event2->Timer.Sequence);
+}
+
+/**
+  Store a timer event at the specified position of the timer database.
+
+  @param  Index                  The 1-based position in the heap.
+  @param  Event                  The timer event.
+
+**/
+STATIC
+VOID
+TimerHeapSet (
+  IN UINTN   Index,
+  IN IEVENT  *Event
+  )
+{
+  mEfiTimerHeap[Index]   = Event;
+  Event->Timer.HeapIndex = Index;
+}
+
+/**
+  Restore the heap order by moving a timer event towards the root.
+
+  @param  Index                  The 1-based position of the timer event.
+
+**/
+STATIC
+VOID
+TimerHeapSiftUp (
+  IN UINTN  Index
+  )
+{
+  IEVENT  *Event;
+  UINTN   Parent;
+
+  Event = mEfiTimerHeap[Index];
+  while (Index > 1) {
+    Parent = Index / 2;
+    if (!TimerExpiresBefore (Event, mEfiTimerHeap[Parent])) {
+      break;
+    }
+
+    TimerHeapSet (Index, mEfiTimerHeap[Parent]);
+    Index = Parent;
+    mEfiTimerStatistics.HeapSteps++;
+  }
+
+  TimerHeapSet (Index, Event);
+}
+
+/**
+  Restore the heap order by moving a timer event towards the leaves.
+
+  @param  Index                  The 1-based position of the timer event.
+
+**/
+STATIC
+VOID
+TimerHeapSiftDown (
+  IN UINTN  Index
+  )
+{
+  IEVENT  *Event;
+  UINTN   Child;
+
+  Event = mEfiTimerHeap[Index];
+  for ( ; ;) {
+    Child = Index * 2;
+    if (Child > mEfiTimerHeapCount) {
+      break;
+    }
+
+    if ((Child < mEfiTimerHeapCount) &&
+        TimerExpiresBefore (mEfiTimerHeap[Child + 1], mEfiTimerHeap[Child]))
+    {
+      Child++;
+    }
+
+    if (!TimerExpiresBefore (mEfiTimerHeap[Child], Event)) {
+      break;
+    }
+
+    TimerHeapSet (Index, mEfiTimerHeap[Child]);
+    Index = Child;
+    mEfiTimerStatistics.HeapSteps++;
+  }
+
+  TimerHeapSet (Index, Event);
+}
+
 /**
   Inserts the timer event.
 
@@ -36,29 +173,139 @@ CoreInsertEventTimer (
   IN IEVENT  *Event
   )
 {
-  UINT64      TriggerTime;
-  LIST_ENTRY  *Link;
-  IEVENT      *Event2;
-
   ASSERT_LOCKED (&mEfiTimerLock);
+  ASSERT (Event->Timer.HeapIndex == 0);
+  ASSERT (mEfiTimerHeapCount < mEfiTimerHeapCapacity);
 
   //
-  // Get the timer's trigger time
+  // Append the timer to the heap and move it to its sorted position
   //
-  TriggerTime = Event->Timer.TriggerTime;
+  Event->Timer.Sequence = mEfiTimerSequence++;
+  mEfiTimerHeapCount++;
+  TimerHeapSet (mEfiTimerHeapCount, Event);
+  TimerHeapSiftUp (mEfiTimerHeapCount);
+
+  if (mEfiTimerHeapCount > mEfiTimerStatistics.MaxQueued) {
+    mEfiTimerStatistics.MaxQueued = mEfiTimerHeapCount;
+  }
+}
+
+/**
+  Removes the timer event from the timer database.
+
+  @param  Event                  Points to the internal structure of timer event
+                                 to be removed
+
+**/
+STATIC
+VOID
+CoreRemoveEventTimer (
+  IN IEVENT  *Event
+  )
+{
+  UINTN   Index;
+  IEVENT  *Last;
+
+  ASSERT_LOCKED (&mEfiTimerLock);
+
+  Index = Event->Timer.HeapIndex;
+  ASSERT (Index != 0 && Index <= mEfiTimerHeapCount);
+  ASSERT (mEfiTimerHeap[Index] == Event);
+
+  Event->Timer.HeapIndex = 0;
+
+  Last                              = mEfiTimerHeap[mEfiTimerHeapCount];
+  mEfiTimerHeap[mEfiTimerHeapCount] = NULL;
+  mEfiTimerHeapCount--;
+
+  if (Last == Event) {
+    return;
+  }
 
   //
-  // Insert the timer into the timer database in assending sorted order
+  // Move the last timer into the hole and restore the heap order in
+  // whichever direction it is violated
   //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  TimerHeapSet (Index, Last);
+  if ((Index > 1) && TimerExpiresBefore (Last, mEfiTimerHeap[Index / 2])) {
+    TimerHeapSiftUp (Index);
+  } else {
+    TimerHeapSiftDown (Index);
+  }
+}
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
-      break;
+/**
+  Reserves an entry in the timer database for a new timer event. The
+  database is grown here, outside of the timer lock, so that arming a timer
+  never allocates memory.
+
+  @retval EFI_SUCCESS            An entry was reserved.
+  @retval EFI_OUT_OF_RESOURCES   The timer database could not be grown.
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  )
+{
+  IEVENT  **NewHeap;
+  IEVENT  **OldHeap;
+  UINTN   NewCapacity;
+
+  for ( ; ;) {
+    CoreAcquireLock (&mEfiTimerLock);
+    if (mEfiTimerEventCount < mEfiTimerHeapCapacity) {
+      mEfiTimerEventCount++;
+      CoreReleaseLock (&mEfiTimerLock);
+      return EFI_SUCCESS;
+    }
+
+    NewCapacity = MAX (mEfiTimerHeapCapacity * 2, TIMER_HEAP_INITIAL_CAPACITY);
+    CoreReleaseLock (&mEfiTimerLock);
+
+    NewHeap = AllocateZeroPool ((NewCapacity + 1) * sizeof (IEVENT *));
+    if (NewHeap == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    CoreAcquireLock (&mEfiTimerLock);
+    if (NewCapacity > mEfiTimerHeapCapacity) {
+      if (mEfiTimerHeap != NULL) {
+        CopyMem (NewHeap, mEfiTimerHeap, (mEfiTimerHeapCount + 1) * sizeof (IEVENT *));
+      }
+
+      OldHeap               = mEfiTimerHeap;
+      mEfiTimerHeap         = NewHeap;
+      mEfiTimerHeapCapacity = NewCapacity;
+    } else {
+      //
+      // The database was grown meanwhile by a higher TPL caller
+      //
+      OldHeap = NewHeap;
+    }
+
+    CoreReleaseLock (&mEfiTimerLock);
+
+    if (OldHeap != NULL) {
+      FreePool (OldHeap);
     }
   }
+}
 
-  InsertTailList (Link, &Event->Timer.Link);
+/**
+  Releases the timer database entry reserved by CoreReserveEventTimer().
+  The timer event must not be queued.
+
+**/
+VOID
+CoreReleaseEventTimer (
+  VOID
+  )
+{
+  CoreAcquireLock (&mEfiTimerLock);
+  ASSERT (mEfiTimerEventCount > 0);
+  mEfiTimerEventCount--;
+  CoreReleaseLock (&mEfiTimerLock);
 }
 
 /**
@@ -81,6 +328,78 @@ CoreCurrentSystemTime (
   return SystemTime;
 }
 
+/**
+  Reads the timer of the CPU Architectural Protocol.
+
+  The DXE core measures short intervals with this timer rather than with
+  TimerLib, so that platforms do not have to provide a TimerLib instance for
+  it.
+
+  @return The value of the timer, or 0 if the CPU Architectural Protocol is
+          not installed yet or its timer can not be read.
+
+**/
+UINT64
+CoreReadCpuTimer (
+  VOID
+  )
+{
+  UINT64  TimerValue;
+  UINT64  TimerPeriod;
+
+  if (gCpu == NULL) {
+    return 0;
+  }
+
+  //
+  // Reading the period may take a calibration delay, so it is only read once
+  //
+  if (mCpuTimerPeriod == 0) {
+    if (EFI_ERROR (gCpu->GetTimerValue (gCpu, 0, &TimerValue, &TimerPeriod)) || (TimerPeriod == 0)) {
+      return 0;
+    }
+
+    mCpuTimerPeriod = TimerPeriod;
+    return TimerValue;
+  }
+
+  if (EFI_ERROR (gCpu->GetTimerValue (gCpu, 0, &TimerValue, NULL))) {
+    return 0;
+  }
+
+  return TimerValue;
+}
+
+/**
+  Returns the time elapsed since an earlier value of the timer of the CPU
+  Architectural Protocol.
+
+  @param  StartValue             The value returned by CoreReadCpuTimer() at
+                                 the start of the interval.
+
+  @return The elapsed time in nanoseconds, or 0 if the timer could not be
+          read at the start or at the end of the interval.
+
+**/
+UINT64
+CoreCpuTimerElapsedTime (
+  IN UINT64  StartValue
+  )
+{
+  UINT64  EndValue;
+
+  if (StartValue == 0) {
+    return 0;
+  }
+
+  EndValue = CoreReadCpuTimer ();
+  if (EndValue <= StartValue) {
+    return 0;
+  }
+
+  return DivU64x32 (MultU64x64 (EndValue - StartValue, mCpuTimerPeriod), 1000000);
+}
+
 /**
   Checks the sorted timer list against the current system time.
   Signals any expired event timer.
@@ -96,17 +415,21 @@ CoreCheckTimers (
   IN VOID       *Context
   )
 {
+  UINT64  StartTime;
   UINT64  SystemTime;
   IEVENT  *Event;
 
+  StartTime = CoreReadCpuTimer ();
+
   //
   // Check the timer database for expired timers
   //
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
+  mEfiTimerStatistics.CheckCount++;
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  while (mEfiTimerHeapCount != 0) {
+    Event = mEfiTimerHeap[1];
 
     //
     // If this timer is not expired, then we're done
@@ -119,8 +442,8 @@ CoreCheckTimers (
     // Remove this timer from the timer queue
     //
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreRemoveEventTimer (Event);
+    mEfiTimerStatistics.ExpiredCount++;
 
     //
     // Signal it
@@ -151,6 +474,7 @@ CoreCheckTimers (
     }
   }
 
+  mEfiTimerStatistics.CheckTime += CoreCpuTimerElapsedTime (StartTime);
   CoreReleaseLock (&mEfiTimerLock);
 }
 
@@ -189,8 +513,11 @@ CoreTimerTick (
   IN UINT64  Duration
   )
 {
+  UINT64  StartTime;
   IEVENT  *Event;
 
+  StartTime = CoreReadCpuTimer ();
+
   //
   // Check runtiem flag in case there are ticks while exiting boot services
   //
@@ -200,19 +527,21 @@ CoreTimerTick (
   // Update the system time
   //
   mEfiSystemTime += Duration;
+  mEfiTimerStatistics.TickCount++;
 
   //
-  // If the head of the list is expired, fire the timer event
+  // If the head of the heap is expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  if (mEfiTimerHeapCount != 0) {
+    Event = mEfiTimerHeap[1];
 
     if (Event->Timer.TriggerTime <= mEfiSystemTime) {
       CoreSignalEvent (mEfiCheckTimerEvent);
     }
   }
 
+  mEfiTimerStatistics.TickTime += CoreCpuTimerElapsedTime (StartTime);
   CoreReleaseLock (&mEfiSystemTimeLock);
 }
 
@@ -260,9 +589,8 @@ CoreSetTimer (
   //
   // If the timer is queued to the timer database, remove it
   //
-  if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+  if (Event->Timer.HeapIndex != 0) {
+    CoreRemoveEventTimer (Event);
   }
 
   Event->Timer.TriggerTime = 0;
@@ -289,3 +617,29 @@ CoreSetTimer (
 
   return EFI_SUCCESS;
 }
+
+/**
+  Reports the timer database statistics collected during boot services.
+
+**/
+VOID
+CoreDumpTimerStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "Timer statistics: %ld ticks, %ld checks, %ld expired, %ld heap steps, %ld max queued\n",
+    mEfiTimerStatistics.TickCount,
+    mEfiTimerStatistics.CheckCount,
+    mEfiTimerStatistics.ExpiredCount,
+    mEfiTimerStatistics.HeapSteps,
+    (UINT64)mEfiTimerStatistics.MaxQueued
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "Timer statistics: %ld ns in CoreTimerTick(), %ld ns in CoreCheckTimers()\n",
+    mEfiTimerStatistics.TickTime,
+    mEfiTimerStatistics.CheckTime
+    ));
+}
@@ -0,0 +1,633 @@
+/** @file
+  Host-based unit tests of the event groups of the DXE Core. Events are
+  created in random groups, signaled and closed, and the notifications and
+  the group records are checked against a model of the open events.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+#include "../Event.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Event Group Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// More groups than buckets, so that groups share buckets. The last event
+// slot of the model is for events created without a group.
+//
+#define TEST_GROUP_COUNT   200
+#define TEST_EVENT_COUNT   1000
+#define TEST_TRACE_STEPS   20000
+#define TEST_NO_GROUP      TEST_GROUP_COUNT
+#define TEST_SELF_CLOSING  8
+
+//
+// The groups of the tests, and the group, the event and the number of
+// notifications of each event slot of the model. The event is NULL while
+// the slot is free.
+//
+STATIC EFI_GUID   mGroups[TEST_GROUP_COUNT];
+STATIC UINTN      mEventGroups[TEST_EVENT_COUNT];
+STATIC EFI_EVENT  mEvents[TEST_EVENT_COUNT];
+STATIC UINTN      mNotified[TEST_EVENT_COUNT];
+STATIC UINT32     mSeed;
+
+//
+// The number of group records before the tests create any event: the
+// idle loop event group of CoreInitializeEventServices()
+//
+STATIC UINTN  mBaseGroupCount;
+
+//
+// The event group buckets of Event.c
+//
+extern LIST_ENTRY  mEventGroupBuckets[EVENT_GROUP_BUCKET_COUNT];
+
+/// === STUB FUNCTIONS ===
+
+EFI_CPU_ARCH_PROTOCOL      *gCpu      = NULL;
+EFI_RUNTIME_ARCH_PROTOCOL  *gRuntime  = NULL;
+EFI_SMM_BASE2_PROTOCOL     *gSmmBase2 = NULL;
+
+/**
+  Stub of the DXE Core CoreFreePool(), the pool comes from the host heap.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreInitializeTimer(). The tests create no timer
+  event.
+
+**/
+VOID
+CoreInitializeTimer (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreReserveEventTimer().
+
+**/
+EFI_STATUS
+CoreReserveEventTimer (
+  VOID
+  )
+{
+  ASSERT (FALSE);
+  return EFI_OUT_OF_RESOURCES;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseEventTimer().
+
+**/
+VOID
+CoreReleaseEventTimer (
+  VOID
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Stub of the DXE Core CoreSetTimer().
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSetTimer (
+  IN EFI_EVENT        UserEvent,
+  IN EFI_TIMER_DELAY  Type,
+  IN UINT64           TriggerTime
+  )
+{
+  ASSERT (FALSE);
+  return EFI_INVALID_PARAMETER;
+}
+
+/**
+  Stub of the DXE Core CoreUnregisterProtocolNotify(). The tests register
+  no protocol notify.
+
+**/
+EFI_STATUS
+CoreUnregisterProtocolNotify (
+  IN EFI_EVENT  Event
+  )
+{
+  ASSERT (FALSE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of UefiLib EfiEventEmptyFunction(), the notification function of the
+  idle loop event group.
+
+**/
+VOID
+EFIAPI
+EfiEventEmptyFunction (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Notification function of the events of the tests. Counts the
+  notifications of the event slot in Context.
+
+  @param[in]  Event    The event.
+  @param[in]  Context  The event slot.
+
+**/
+STATIC
+VOID
+EFIAPI
+CountNotification (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  mNotified[(UINTN)Context]++;
+}
+
+/**
+  Notification function of events that close themselves, as handlers of
+  one-shot groups like ReadyToBoot do.
+
+  @param[in]  Event    The event.
+  @param[in]  Context  The event slot.
+
+**/
+STATIC
+VOID
+EFIAPI
+CountNotificationAndClose (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  mNotified[(UINTN)Context]++;
+  mEvents[(UINTN)Context] = NULL;
+  CoreCloseEvent (Event);
+}
+
+/**
+  Creates an event in a slot of the model.
+
+  @param[in]  Slot            The event slot.
+  @param[in]  Group           The group in mGroups, or TEST_NO_GROUP.
+  @param[in]  NotifyFunction  The notification function.
+
+  @retval TRUE   The event was created.
+  @retval FALSE  The event could not be created.
+
+**/
+STATIC
+BOOLEAN
+CreateEvent (
+  IN UINTN             Slot,
+  IN UINTN             Group,
+  IN EFI_EVENT_NOTIFY  NotifyFunction
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = CoreCreateEventEx (
+             EVT_NOTIFY_SIGNAL,
+             TPL_CALLBACK,
+             NotifyFunction,
+             (VOID *)Slot,
+             (Group == TEST_NO_GROUP) ? NULL : &mGroups[Group],
+             &mEvents[Slot]
+             );
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  mEventGroups[Slot] = Group;
+  return TRUE;
+}
+
+/**
+  Returns the number of group records in the buckets. Checks that every
+  record holds at least one event. A record the lookup misses would show as
+  a second record of its group.
+
+  @return The number of group records, MAX_UINTN if a record is empty.
+
+**/
+STATIC
+UINTN
+CountGroups (
+  VOID
+  )
+{
+  LIST_ENTRY   *Link;
+  EVENT_GROUP  *Group;
+  UINTN        Bucket;
+  UINTN        Count;
+
+  Count = 0;
+  for (Bucket = 0; Bucket < EVENT_GROUP_BUCKET_COUNT; Bucket++) {
+    for (Link = mEventGroupBuckets[Bucket].ForwardLink; Link != &mEventGroupBuckets[Bucket]; Link = Link->ForwardLink) {
+      Group = CR (Link, EVENT_GROUP, Link, EVENT_GROUP_SIGNATURE);
+      if (IsListEmpty (&Group->Events)) {
+        return MAX_UINTN;
+      }
+
+      Count++;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Returns the number of group records the model expects: one per group with
+  an open event, including the group of the events without one.
+
+  @return The number of group records.
+
+**/
+STATIC
+UINTN
+ModelGroupCount (
+  VOID
+  )
+{
+  BOOLEAN  Open[TEST_GROUP_COUNT + 1];
+  UINTN    Slot;
+  UINTN    Count;
+
+  ZeroMem (Open, sizeof (Open));
+  Count = mBaseGroupCount;
+  for (Slot = 0; Slot < TEST_EVENT_COUNT; Slot++) {
+    if ((mEvents[Slot] != NULL) && !Open[mEventGroups[Slot]]) {
+      Open[mEventGroups[Slot]] = TRUE;
+      Count++;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Signals an event and checks that the open events of its group, or the
+  event alone if it has no group, were notified once, and no other event.
+
+  @param[in]  Slot  The event slot.
+
+  @retval TRUE   The notifications match the model.
+  @retval FALSE  The notifications do not match the model.
+
+**/
+STATIC
+BOOLEAN
+SignalMatchesModel (
+  IN UINTN  Slot
+  )
+{
+  UINTN    Group;
+  UINTN    Other;
+  UINTN    Expected;
+  BOOLEAN  Open[TEST_EVENT_COUNT];
+
+  for (Other = 0; Other < TEST_EVENT_COUNT; Other++) {
+    Open[Other] = (BOOLEAN)(mEvents[Other] != NULL);
+  }
+
+  Group = mEventGroups[Slot];
+  ZeroMem (mNotified, sizeof (mNotified));
+  if (EFI_ERROR (CoreSignalEvent (mEvents[Slot]))) {
+    return FALSE;
+  }
+
+  for (Other = 0; Other < TEST_EVENT_COUNT; Other++) {
+    if (Group == TEST_NO_GROUP) {
+      Expected = (Other == Slot) ? 1 : 0;
+    } else {
+      Expected = (Open[Other] && (mEventGroups[Other] == Group)) ? 1 : 0;
+    }
+
+    if (mNotified[Other] != Expected) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Resets the model and the random sequence.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED  The setup succeeded.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+EventGroupSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mSeed = 0x5eed;
+  ZeroMem (mEvents, sizeof (mEvents));
+  ZeroMem (mNotified, sizeof (mNotified));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Closes the events the test left open.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+EventGroupCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Slot;
+
+  for (Slot = 0; Slot < TEST_EVENT_COUNT; Slot++) {
+    if (mEvents[Slot] != NULL) {
+      CoreCloseEvent (mEvents[Slot]);
+      mEvents[Slot] = NULL;
+    }
+  }
+}
+
+/// === TEST CASES ===
+
+/**
+  A group signaled before the event services are initialized, as DxeMain()
+  does when it installs configuration tables, should find no event to
+  notify.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SignalBeforeInitializationShouldNotifyNothing (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Group;
+
+  UT_ASSERT_EQUAL (CountGroups (), 0);
+  for (Group = 0; Group < TEST_GROUP_COUNT; Group++) {
+    CoreNotifySignalList (&mGroups[Group]);
+  }
+
+  UT_ASSERT_EQUAL (CountGroups (), 0);
+
+  UT_ASSERT_NOT_EFI_ERROR (CoreInitializeEventServices ());
+  mBaseGroupCount = CountGroups ();
+  UT_ASSERT_EQUAL (mBaseGroupCount, 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Signaling an event should notify every open event of its group once, and
+  the group record should be freed with the last event of the group, while
+  events are created, signaled and closed at random.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RandomSignalCloseShouldMatchModel (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Step;
+  UINTN  Slot;
+  UINTN  Group;
+  UINTN  Signals;
+  UINTN  MaxGroups;
+
+  Signals   = 0;
+  MaxGroups = 0;
+  for (Step = 0; Step < TEST_TRACE_STEPS; Step++) {
+    Slot = GetRandom () % TEST_EVENT_COUNT;
+    if (mEvents[Slot] == NULL) {
+      Group = GetRandom () % (TEST_GROUP_COUNT + 1);
+      UT_ASSERT_TRUE (CreateEvent (Slot, Group, CountNotification));
+    } else if (GetRandom () % 3 == 0) {
+      UT_ASSERT_TRUE (SignalMatchesModel (Slot));
+      Signals++;
+    } else {
+      UT_ASSERT_NOT_EFI_ERROR (CoreCloseEvent (mEvents[Slot]));
+      mEvents[Slot] = NULL;
+    }
+
+    UT_ASSERT_EQUAL (CountGroups (), ModelGroupCount ());
+    MaxGroups = MAX (MaxGroups, ModelGroupCount ());
+  }
+
+  UT_ASSERT_NOT_EQUAL (Signals, 0);
+  UT_LOG_INFO ("%d signals, up to %d groups\n", (INT32)Signals, (INT32)MaxGroups);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Events that close themselves from their notification function should all
+  be notified when their group is signaled, and the group record should be
+  freed with them.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SelfClosingGroupShouldBeFreed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Slot;
+
+  for (Slot = 0; Slot < TEST_SELF_CLOSING; Slot++) {
+    UT_ASSERT_TRUE (CreateEvent (Slot, 0, CountNotificationAndClose));
+  }
+
+  UT_ASSERT_TRUE (CreateEvent (TEST_SELF_CLOSING, 1, CountNotification));
+  UT_ASSERT_EQUAL (CountGroups (), mBaseGroupCount + 2);
+
+  UT_ASSERT_NOT_EFI_ERROR (CoreSignalEvent (mEvents[0]));
+  for (Slot = 0; Slot < TEST_SELF_CLOSING; Slot++) {
+    UT_ASSERT_EQUAL (mNotified[Slot], 1);
+    UT_ASSERT_TRUE (mEvents[Slot] == NULL);
+  }
+
+  UT_ASSERT_EQUAL (mNotified[TEST_SELF_CLOSING], 0);
+  UT_ASSERT_EQUAL (CountGroups (), mBaseGroupCount + 1);
+
+  //
+  // The group can be created again
+  //
+  UT_ASSERT_TRUE (CreateEvent (0, 0, CountNotification));
+  UT_ASSERT_EQUAL (CountGroups (), mBaseGroupCount + 2);
+  UT_ASSERT_TRUE (SignalMatchesModel (0));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  event groups of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      EventGroupTests;
+  UINTN                       Index;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // The groups are random GUIDs, like the ones of real event groups
+  //
+  mSeed = 0x5eed;
+  for (Index = 0; Index < TEST_GROUP_COUNT; Index++) {
+    mGroups[Index].Data1 = GetRandom () ^ (GetRandom () << 16);
+    mGroups[Index].Data2 = (UINT16)GetRandom ();
+    mGroups[Index].Data3 = (UINT16)GetRandom ();
+    WriteUnaligned32 ((UINT32 *)&mGroups[Index].Data4[0], GetRandom () ^ (GetRandom () << 16));
+    WriteUnaligned32 ((UINT32 *)&mGroups[Index].Data4[4], GetRandom () ^ (GetRandom () << 16));
+  }
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core Event Group Unit Test Suite. The first test
+  // initializes the event services, so the tests run in order.
+  //
+  Status = CreateUnitTestSuite (&EventGroupTests, Framework, "DXE Core Event Group Tests", "DxeCore.Event.Group", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Event Group Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite--------------Description-----------------------------------------Name------------Function---------------------------------------Pre---------------Post----------------Context-----------
+  //
+  AddTestCase (EventGroupTests, "Signal a group before event services are initialized", "EarlySignal", SignalBeforeInitializationShouldNotifyNothing, NULL, NULL, NULL);
+  AddTestCase (EventGroupTests, "Random signals and closes match the model", "Stress", RandomSignalCloseShouldMatchModel, EventGroupSetup, EventGroupCleanup, NULL);
+  AddTestCase (EventGroupTests, "A group closing itself on signal is freed", "SelfClose", SelfClosingGroupShouldBeFreed, EventGroupSetup, EventGroupCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCoreEventGroupUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCoreEventGroupUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
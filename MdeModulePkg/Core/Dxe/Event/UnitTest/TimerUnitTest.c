@@ -0,0 +1,839 @@
+/** @file
+  Host-based unit tests of the timer database of the DXE Core. The timers
+  are checked against a model that keeps them in an unsorted array. The time
+  spent in timer ticks is checked against a stub CPU timer.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+#include "../Event.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Timer Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// More timers than TIMER_HEAP_INITIAL_CAPACITY, so that the database grows
+//
+#define TEST_TIMER_COUNT     100
+#define TEST_STRESS_ROUNDS   20000
+#define TEST_MAX_DELAY       64
+#define TEST_TIMER_PERIOD    10
+#define TEST_MAX_FIRED       (4 * TEST_TIMER_COUNT)
+#define TEST_CPU_TIMER_STEP  1000
+
+///
+/// A timer event of the tests and what the model expects of it
+///
+typedef struct {
+  IEVENT     Event;
+  BOOLEAN    Armed;
+  UINT64     TriggerTime;
+  UINT64     Period;
+  ///
+  /// Arming order, which breaks the ties between equal trigger times
+  ///
+  UINT64     Order;
+} TEST_TIMER;
+
+STATIC TEST_TIMER  mTimers[TEST_TIMER_COUNT];
+STATIC UINT64      mOrder;
+STATIC UINT32      mSeed;
+
+//
+// The events CoreSignalEvent() was called with, in order
+//
+STATIC IEVENT   *mFired[TEST_MAX_FIRED];
+STATIC UINTN    mFiredCount;
+STATIC IEVENT   mCheckEvent;
+STATIC BOOLEAN  mCheckSignaled;
+
+//
+// Value of the timer of the stub CPU architectural protocol
+//
+STATIC UINT64  mCpuTimerValue;
+
+//
+// The timer database of Timer.c
+//
+extern IEVENT            **mEfiTimerHeap;
+extern UINTN             mEfiTimerHeapCount;
+extern UINTN             mEfiTimerHeapCapacity;
+extern UINTN             mEfiTimerEventCount;
+extern UINT64            mEfiSystemTime;
+extern EFI_EVENT         mEfiCheckTimerEvent;
+extern TIMER_STATISTICS  mEfiTimerStatistics;
+
+/**
+  Checks the timer database against the current system time, and signals
+  the expired timers. Defined in Timer.c.
+
+  @param  CheckEvent             Not used
+  @param  Context                Not used
+
+**/
+VOID
+EFIAPI
+CoreCheckTimers (
+  IN EFI_EVENT  CheckEvent,
+  IN VOID       *Context
+  );
+
+/// === STUB FUNCTIONS ===
+
+/**
+  Stub of the timer architectural protocol GetTimerPeriod(). The periodic
+  timers armed with a period of 0 take TEST_TIMER_PERIOD.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StubGetTimerPeriod (
+  IN  EFI_TIMER_ARCH_PROTOCOL  *This,
+  OUT UINT64                   *TimerPeriod
+  )
+{
+  *TimerPeriod = TEST_TIMER_PERIOD;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_TIMER_ARCH_PROTOCOL  mTimerArch = {
+  NULL,
+  NULL,
+  StubGetTimerPeriod,
+  NULL
+};
+
+EFI_TIMER_ARCH_PROTOCOL  *gTimer = &mTimerArch;
+
+/**
+  Stub of the CPU architectural protocol GetTimerValue(). The timer advances
+  by TEST_CPU_TIMER_STEP on every read, and has a period of 1ns.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StubGetTimerValue (
+  IN  EFI_CPU_ARCH_PROTOCOL  *This,
+  IN  UINT32                 TimerIndex,
+  OUT UINT64                 *TimerValue,
+  OUT UINT64                 *TimerPeriod OPTIONAL
+  )
+{
+  mCpuTimerValue += TEST_CPU_TIMER_STEP;
+  *TimerValue     = mCpuTimerValue;
+  if (TimerPeriod != NULL) {
+    *TimerPeriod = 1000000;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_CPU_ARCH_PROTOCOL  mCpuArch = {
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  StubGetTimerValue,
+  NULL,
+  1,
+  0
+};
+
+//
+// Only the tests of the tick cost install the CPU architectural protocol,
+// CoreReadCpuTimer() returns 0 for the others.
+//
+EFI_CPU_ARCH_PROTOCOL  *gCpu = NULL;
+
+/**
+  Stub of the DXE Core CoreAcquireLock(). The locks are only checked, as the
+  tests run on one thread.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseLock().
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the DXE Core CoreCreateEventInternal(). Only creates the event of
+  CoreCheckTimers().
+
+**/
+EFI_STATUS
+EFIAPI
+CoreCreateEventInternal (
+  IN UINT32            Type,
+  IN EFI_TPL           NotifyTpl,
+  IN EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN CONST VOID        *NotifyContext  OPTIONAL,
+  IN CONST EFI_GUID    *EventGroup     OPTIONAL,
+  OUT EFI_EVENT        *Event
+  )
+{
+  ASSERT (NotifyFunction == CoreCheckTimers);
+  mCheckEvent.Signature = EVENT_SIGNATURE;
+  *Event                = &mCheckEvent;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreSignalEvent(). Records the timers that fire, and
+  whether CoreCheckTimers() is due to run.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSignalEvent (
+  IN EFI_EVENT  UserEvent
+  )
+{
+  if (UserEvent == mEfiCheckTimerEvent) {
+    mCheckSignaled = TRUE;
+  } else {
+    ASSERT (mFiredCount < TEST_MAX_FIRED);
+    mFired[mFiredCount++] = UserEvent;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Arms a timer through CoreSetTimer() and in the model.
+
+  @param[in]  Timer        The timer to arm.
+  @param[in]  Type         TimerPeriodic or TimerRelative.
+  @param[in]  TriggerTime  The delay of the timer, and its period if it is
+                           periodic.
+
+  @retval TRUE   CoreSetTimer() succeeded.
+  @retval FALSE  CoreSetTimer() failed.
+
+**/
+STATIC
+BOOLEAN
+ArmTimer (
+  IN TEST_TIMER       *Timer,
+  IN EFI_TIMER_DELAY  Type,
+  IN UINT64           TriggerTime
+  )
+{
+  if (EFI_ERROR (CoreSetTimer (&Timer->Event, Type, TriggerTime))) {
+    return FALSE;
+  }
+
+  if ((Type == TimerPeriodic) && (TriggerTime == 0)) {
+    TriggerTime = TEST_TIMER_PERIOD;
+  }
+
+  Timer->Armed       = TRUE;
+  Timer->TriggerTime = mEfiSystemTime + TriggerTime;
+  Timer->Period      = (Type == TimerPeriodic) ? TriggerTime : 0;
+  Timer->Order       = mOrder++;
+  return TRUE;
+}
+
+/**
+  Cancels a timer through CoreSetTimer() and in the model.
+
+  @param[in]  Timer  The timer to cancel.
+
+  @retval TRUE   CoreSetTimer() succeeded.
+  @retval FALSE  CoreSetTimer() failed.
+
+**/
+STATIC
+BOOLEAN
+CancelTimer (
+  IN TEST_TIMER  *Timer
+  )
+{
+  if (EFI_ERROR (CoreSetTimer (&Timer->Event, TimerCancel, 0))) {
+    return FALSE;
+  }
+
+  Timer->Armed = FALSE;
+  return TRUE;
+}
+
+/**
+  Returns the armed timer of the model that expires first.
+
+  @return The timer, or NULL if none is armed.
+
+**/
+STATIC
+TEST_TIMER *
+ModelNextTimer (
+  VOID
+  )
+{
+  TEST_TIMER  *Next;
+  UINTN       Index;
+
+  Next = NULL;
+  for (Index = 0; Index < TEST_TIMER_COUNT; Index++) {
+    if (!mTimers[Index].Armed) {
+      continue;
+    }
+
+    if ((Next == NULL) ||
+        (mTimers[Index].TriggerTime < Next->TriggerTime) ||
+        ((mTimers[Index].TriggerTime == Next->TriggerTime) && (mTimers[Index].Order < Next->Order)))
+    {
+      Next = &mTimers[Index];
+    }
+  }
+
+  return Next;
+}
+
+/**
+  Runs CoreCheckTimers() and checks that the timers fired are the ones the
+  model expires, in the same order.
+
+  @retval TRUE   The timers fired as expected.
+  @retval FALSE  A timer fired out of order, or did not fire.
+
+**/
+STATIC
+BOOLEAN
+CheckTimers (
+  VOID
+  )
+{
+  TEST_TIMER  *Timer;
+  UINTN       Index;
+
+  mFiredCount    = 0;
+  mCheckSignaled = FALSE;
+  CoreCheckTimers (mEfiCheckTimerEvent, NULL);
+
+  Index = 0;
+  for ( ; ;) {
+    Timer = ModelNextTimer ();
+    if ((Timer == NULL) || (Timer->TriggerTime > mEfiSystemTime)) {
+      break;
+    }
+
+    if ((Index >= mFiredCount) || (mFired[Index] != &Timer->Event)) {
+      return FALSE;
+    }
+
+    Index++;
+    Timer->Armed = FALSE;
+    if (Timer->Period != 0) {
+      Timer->TriggerTime += Timer->Period;
+      if (Timer->TriggerTime <= mEfiSystemTime) {
+        Timer->TriggerTime = mEfiSystemTime;
+      }
+
+      Timer->Armed = TRUE;
+      Timer->Order = mOrder++;
+    }
+  }
+
+  return (BOOLEAN)(Index == mFiredCount);
+}
+
+/**
+  Advances the system time through CoreTimerTick(), and runs
+  CoreCheckTimers() if the tick signaled it.
+
+  @param[in]  Duration  The time elapsed.
+
+  @retval TRUE   The tick signaled CoreCheckTimers() exactly when a timer
+                 expired, and the timers fired as expected.
+  @retval FALSE  Otherwise.
+
+**/
+STATIC
+BOOLEAN
+TickTimers (
+  IN UINT64  Duration
+  )
+{
+  TEST_TIMER  *Timer;
+  BOOLEAN     Expired;
+
+  mFiredCount    = 0;
+  mCheckSignaled = FALSE;
+  CoreTimerTick (Duration);
+
+  Timer   = ModelNextTimer ();
+  Expired = (BOOLEAN)((Timer != NULL) && (Timer->TriggerTime <= mEfiSystemTime));
+  if (mCheckSignaled != Expired) {
+    return FALSE;
+  }
+
+  return !mCheckSignaled || CheckTimers ();
+}
+
+/**
+  Checks that the timer database is a heap holding the timers armed in the
+  model, and that every timer knows its position in it.
+
+  @retval TRUE   The timer database is consistent.
+  @retval FALSE  The heap order or a HeapIndex is broken.
+
+**/
+STATIC
+BOOLEAN
+TimerHeapIsConsistent (
+  VOID
+  )
+{
+  IEVENT  *Event;
+  IEVENT  *Parent;
+  UINTN   Armed;
+  UINTN   Index;
+
+  if ((mEfiTimerHeapCount > mEfiTimerHeapCapacity) || (mEfiTimerEventCount > mEfiTimerHeapCapacity)) {
+    return FALSE;
+  }
+
+  for (Index = 1; Index <= mEfiTimerHeapCount; Index++) {
+    Event = mEfiTimerHeap[Index];
+    if (Event->Timer.HeapIndex != Index) {
+      return FALSE;
+    }
+
+    if (Index > 1) {
+      Parent = mEfiTimerHeap[Index / 2];
+      if ((Event->Timer.TriggerTime < Parent->Timer.TriggerTime) ||
+          ((Event->Timer.TriggerTime == Parent->Timer.TriggerTime) && (Event->Timer.Sequence < Parent->Timer.Sequence)))
+      {
+        return FALSE;
+      }
+    }
+  }
+
+  Armed = 0;
+  for (Index = 0; Index < TEST_TIMER_COUNT; Index++) {
+    Event = &mTimers[Index].Event;
+    if (mTimers[Index].Armed) {
+      Armed++;
+      if ((Event->Timer.HeapIndex == 0) || (Event->Timer.HeapIndex > mEfiTimerHeapCount) ||
+          (mEfiTimerHeap[Event->Timer.HeapIndex] != Event) ||
+          (Event->Timer.TriggerTime != mTimers[Index].TriggerTime))
+      {
+        return FALSE;
+      }
+    } else if (Event->Timer.HeapIndex != 0) {
+      return FALSE;
+    }
+  }
+
+  return (BOOLEAN)(Armed == mEfiTimerHeapCount);
+}
+
+/**
+  Creates the timer events of the tests, reserving their entries in the
+  timer database.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED                      The timers were created.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The timer database could not
+                                                be grown.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TimerSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  if (mEfiCheckTimerEvent == NULL) {
+    CoreInitializeTimer ();
+  }
+
+  ZeroMem (mTimers, sizeof (mTimers));
+  for (Index = 0; Index < TEST_TIMER_COUNT; Index++) {
+    mTimers[Index].Event.Signature = EVENT_SIGNATURE;
+    mTimers[Index].Event.Type      = EVT_TIMER | EVT_NOTIFY_SIGNAL;
+    if (EFI_ERROR (CoreReserveEventTimer ())) {
+      return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+    }
+  }
+
+  mSeed          = 0x5eed;
+  mOrder         = 0;
+  mFiredCount    = 0;
+  mCheckSignaled = FALSE;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Cancels the timers of the tests and releases their database entries.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+TimerCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < TEST_TIMER_COUNT; Index++) {
+    CoreSetTimer (&mTimers[Index].Event, TimerCancel, 0);
+    CoreReleaseEventTimer ();
+  }
+}
+
+/// === TEST CASES ===
+
+/**
+  One-shot timers armed in random order, many of them with the same trigger
+  time, should fire by trigger time and then in the order they were armed.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+OneShotTimersShouldFireInOrder (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+  UINTN  Fired;
+
+  UT_ASSERT_TRUE (mEfiTimerHeapCapacity >= TEST_TIMER_COUNT);
+
+  for (Index = 0; Index < TEST_TIMER_COUNT; Index++) {
+    UT_ASSERT_TRUE (ArmTimer (&mTimers[GetRandom () % TEST_TIMER_COUNT], TimerRelative, 1 + GetRandom () % 8));
+    UT_ASSERT_TRUE (TimerHeapIsConsistent ());
+  }
+
+  Fired = 0;
+  while (mEfiTimerHeapCount != 0) {
+    UT_ASSERT_TRUE (TickTimers (1));
+    UT_ASSERT_TRUE (TimerHeapIsConsistent ());
+    Fired += mFiredCount;
+  }
+
+  UT_ASSERT_NOT_EQUAL (Fired, 0);
+  UT_ASSERT_TRUE (ModelNextTimer () == NULL);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Timers that are armed, re-armed, cancelled and fired at random, periodic
+  ones included, should fire in the order of the model. The heap should stay
+  consistent after each operation.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RandomTimerOperationsShouldKeepHeapOrder (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_TIMER  *Timer;
+  UINTN       Round;
+  UINT64      Fired;
+  UINT64      Steps;
+
+  Fired = mEfiTimerStatistics.ExpiredCount;
+  Steps = mEfiTimerStatistics.HeapSteps;
+
+  for (Round = 0; Round < TEST_STRESS_ROUNDS; Round++) {
+    Timer = &mTimers[GetRandom () % TEST_TIMER_COUNT];
+    switch (GetRandom () % 5) {
+      case 0:
+      case 1:
+        //
+        // Arm or re-arm a one-shot timer. A delay of 0 signals
+        // CoreCheckTimers() right away.
+        //
+        mCheckSignaled = FALSE;
+        UT_ASSERT_TRUE (ArmTimer (Timer, TimerRelative, GetRandom () % TEST_MAX_DELAY));
+        if (mCheckSignaled) {
+          UT_ASSERT_TRUE (CheckTimers ());
+        }
+
+        break;
+
+      case 2:
+        //
+        // Arm or re-arm a periodic timer, with the default period at times
+        //
+        UT_ASSERT_TRUE (ArmTimer (Timer, TimerPeriodic, GetRandom () % TEST_MAX_DELAY));
+        break;
+
+      case 3:
+        UT_ASSERT_TRUE (CancelTimer (Timer));
+        break;
+
+      default:
+        //
+        // Let time pass, sometimes more than a period so that periodic
+        // timers fall behind
+        //
+        UT_ASSERT_TRUE (TickTimers (GetRandom () % (2 * TEST_MAX_DELAY)));
+        break;
+    }
+
+    UT_ASSERT_TRUE (TimerHeapIsConsistent ());
+  }
+
+  UT_LOG_INFO (
+    "%d operations: %d timers fired, %d heap steps\n",
+    TEST_STRESS_ROUNDS,
+    (INT32)(mEfiTimerStatistics.ExpiredCount - Fired),
+    (INT32)(mEfiTimerStatistics.HeapSteps - Steps)
+    );
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A periodic timer that falls behind should fire once for the period that
+  expired, once more to catch up, and then expire a period after the
+  current time.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+LatePeriodicTimerShouldCatchUp (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_TIMER  *Timer;
+
+  Timer = &mTimers[0];
+  UT_ASSERT_TRUE (ArmTimer (Timer, TimerPeriodic, 0));
+  UT_ASSERT_EQUAL (Timer->Event.Timer.Period, TEST_TIMER_PERIOD);
+
+  UT_ASSERT_TRUE (TickTimers (5 * TEST_TIMER_PERIOD));
+  UT_ASSERT_EQUAL (mFiredCount, 2);
+  UT_ASSERT_TRUE (mCheckSignaled);
+  UT_ASSERT_EQUAL (Timer->Event.Timer.TriggerTime, mEfiSystemTime + TEST_TIMER_PERIOD);
+  UT_ASSERT_TRUE (TimerHeapIsConsistent ());
+
+  UT_ASSERT_TRUE (TickTimers (TEST_TIMER_PERIOD - 1));
+  UT_ASSERT_EQUAL (mFiredCount, 0);
+  UT_ASSERT_TRUE (TickTimers (1));
+  UT_ASSERT_EQUAL (mFiredCount, 1);
+
+  UT_ASSERT_TRUE (CancelTimer (Timer));
+  UT_ASSERT_TRUE (TickTimers (2 * TEST_TIMER_PERIOD));
+  UT_ASSERT_TRUE (TimerHeapIsConsistent ());
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The time spent in CoreTimerTick() and CoreCheckTimers() should be read from
+  the timer of the CPU architectural protocol and added up.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TickCostShouldBeMeasured (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  TickCount;
+  UINT64  CheckCount;
+  UINTN   Index;
+
+  gCpu                          = &mCpuArch;
+  mEfiTimerStatistics.TickTime  = 0;
+  mEfiTimerStatistics.CheckTime = 0;
+  TickCount                     = mEfiTimerStatistics.TickCount;
+  CheckCount                    = mEfiTimerStatistics.CheckCount;
+
+  for (Index = 0; Index < TEST_TIMER_COUNT; Index++) {
+    UT_ASSERT_TRUE (ArmTimer (&mTimers[Index], TimerRelative, GetRandom () % TEST_MAX_DELAY));
+  }
+
+  for (Index = 0; Index < TEST_MAX_DELAY; Index++) {
+    UT_ASSERT_TRUE (TickTimers (1));
+  }
+
+  UT_ASSERT_EQUAL (mEfiTimerHeapCount, 0);
+
+  //
+  // Every call reads the timer once at its start and once at its end
+  //
+  TickCount  = mEfiTimerStatistics.TickCount - TickCount;
+  CheckCount = mEfiTimerStatistics.CheckCount - CheckCount;
+  UT_ASSERT_NOT_EQUAL (CheckCount, 0);
+  UT_ASSERT_EQUAL (mEfiTimerStatistics.TickTime, TickCount * TEST_CPU_TIMER_STEP);
+  UT_ASSERT_EQUAL (mEfiTimerStatistics.CheckTime, CheckCount * TEST_CPU_TIMER_STEP);
+
+  //
+  // Nothing is added up while the CPU architectural protocol is missing
+  //
+  gCpu = NULL;
+  UT_ASSERT_TRUE (TickTimers (1));
+  UT_ASSERT_EQUAL (mEfiTimerStatistics.TickTime, TickCount * TEST_CPU_TIMER_STEP);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  timer database of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      TimerTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core Timer Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&TimerTests, Framework, "DXE Core Timer Heap Tests", "DxeCore.Timer.Heap", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Timer Heap Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite---------Description------------------------------------------Name-------Function-----------------------------------Pre---------Post----------Context-----------
+  //
+  AddTestCase (TimerTests, "Fire one-shot timers by trigger time and arming order", "Order", OneShotTimersShouldFireInOrder, TimerSetup, TimerCleanup, NULL);
+  AddTestCase (TimerTests, "Random timer operations keep the heap order", "Stress", RandomTimerOperationsShouldKeepHeapOrder, TimerSetup, TimerCleanup, NULL);
+  AddTestCase (TimerTests, "A late periodic timer catches up", "Periodic", LatePeriodicTimerShouldCatchUp, TimerSetup, TimerCleanup, NULL);
+  AddTestCase (TimerTests, "The time spent in timer ticks is measured", "TickCost", TickCostShouldBeMeasured, TimerSetup, TimerCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCoreTimerUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCoreTimerUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -45,6 +45,29 @@ EFI_LOCK    mGcdIoSpaceLock     = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 LIST_ENTRY  mGcdMemorySpaceMap  = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
 LIST_ENTRY  mGcdIoSpaceMap      = INITIALIZE_LIST_HEAD_VARIABLE (mGcdIoSpaceMap);
 
+//
+// The roots of the trees of the GCD maps. Every entry of a map is also a
+// node of its tree, so CoreSearchGcdMapEntry() finds a range without
+// walking the map.
+//
+EFI_GCD_MAP_ENTRY  *mGcdMemorySpaceTree = NULL;
+EFI_GCD_MAP_ENTRY  *mGcdIoSpaceTree     = NULL;
+
+EDKII_MEMORY_SPACE_ATTRIBUTES_BATCH_PROTOCOL  gMemorySpaceAttributesBatch = {
+  CoreSetMemorySpaceAttributesBatch
+};
+
+//
+// A range of CoreSetMemorySpaceAttributesBatch() with its index in the
+// caller's list, so the ranges can be sorted by address.
+//
+typedef struct {
+  EFI_PHYSICAL_ADDRESS    BaseAddress;
+  UINT64                  Length;
+  UINT64                  Attributes;
+  UINTN                   Index;
+} GCD_ATTRIBUTES_BATCH_RANGE;
+
 EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate = {
   EFI_GCD_MAP_SIGNATURE,
   {
@@ -58,7 +81,10 @@ EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate = {
   EfiGcdMemoryTypeNonExistent,
   (EFI_GCD_IO_TYPE)0,
   NULL,
-  NULL
+  NULL,
+  NULL,
+  NULL,
+  0
 };
 
 EFI_GCD_MAP_ENTRY  mGcdIoSpaceMapEntryTemplate = {
@@ -74,7 +100,10 @@ EFI_GCD_MAP_ENTRY  mGcdIoSpaceMapEntryTemplate = {
   (EFI_GCD_MEMORY_TYPE)0,
   EfiGcdIoTypeNonExistent,
   NULL,
-  NULL
+  NULL,
+  NULL,
+  NULL,
+  0
 };
 
 GCD_ATTRIBUTE_CONVERSION_ENTRY  mAttributeConversionTable[] = {
@@ -413,9 +442,330 @@ CoreAllocateGcdMapEntry (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the root of the tree of a GCD map.
+
+  @param  Map                    The GCD map.
+
+  @return A pointer to the root of the tree of the map.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY **
+CoreGetGcdMapTree (
+  IN LIST_ENTRY  *Map
+  )
+{
+  if (Map == &mGcdIoSpaceMap) {
+    return &mGcdIoSpaceTree;
+  }
+
+  ASSERT (Map == &mGcdMemorySpaceMap);
+  return &mGcdMemorySpaceTree;
+}
+
+/**
+  Returns the height of a GCD map subtree.
+
+  @param  Node                   The root of the subtree, or NULL.
+
+  @return The height of the subtree, 0 if it is empty.
+
+**/
+STATIC
+UINTN
+GcdMapTreeHeight (
+  IN EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  return (Node == NULL) ? 0 : Node->TreeHeight;
+}
+
+/**
+  Recomputes the height of a GCD map subtree from the ones of its children.
+
+  @param  Node                   The root of the subtree.
+
+**/
+STATIC
+VOID
+GcdMapTreeUpdate (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  Node->TreeHeight = 1 + MAX (GcdMapTreeHeight (Node->TreeLeft), GcdMapTreeHeight (Node->TreeRight));
+}
+
+/**
+  Rotates a GCD map subtree to the right, so that its left child becomes
+  its root.
+
+  @param  Node                   The root of the subtree.
+
+  @return The new root of the subtree.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+GcdMapTreeRotateRight (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Child;
+
+  Child            = Node->TreeLeft;
+  Node->TreeLeft   = Child->TreeRight;
+  Child->TreeRight = Node;
+  GcdMapTreeUpdate (Node);
+  GcdMapTreeUpdate (Child);
+  return Child;
+}
+
+/**
+  Rotates a GCD map subtree to the left, so that its right child becomes
+  its root.
+
+  @param  Node                   The root of the subtree.
+
+  @return The new root of the subtree.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+GcdMapTreeRotateLeft (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Child;
+
+  Child           = Node->TreeRight;
+  Node->TreeRight = Child->TreeLeft;
+  Child->TreeLeft = Node;
+  GcdMapTreeUpdate (Node);
+  GcdMapTreeUpdate (Child);
+  return Child;
+}
+
+/**
+  Restores the AVL balance of a GCD map subtree whose children are balanced
+  and differ in height by 2 at most.
+
+  @param  Node                   The root of the subtree.
+
+  @return The new root of the subtree.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+GcdMapTreeBalance (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node
+  )
+{
+  INTN  Balance;
+
+  Balance = (INTN)GcdMapTreeHeight (Node->TreeLeft) - (INTN)GcdMapTreeHeight (Node->TreeRight);
+
+  if (Balance > 1) {
+    if (GcdMapTreeHeight (Node->TreeLeft->TreeLeft) < GcdMapTreeHeight (Node->TreeLeft->TreeRight)) {
+      Node->TreeLeft = GcdMapTreeRotateLeft (Node->TreeLeft);
+    }
+
+    return GcdMapTreeRotateRight (Node);
+  }
+
+  if (Balance < -1) {
+    if (GcdMapTreeHeight (Node->TreeRight->TreeRight) < GcdMapTreeHeight (Node->TreeRight->TreeLeft)) {
+      Node->TreeRight = GcdMapTreeRotateRight (Node->TreeRight);
+    }
+
+    return GcdMapTreeRotateLeft (Node);
+  }
+
+  GcdMapTreeUpdate (Node);
+  return Node;
+}
+
+/**
+  Inserts an entry into a GCD map subtree.
+
+  @param  Node                   The root of the subtree, or NULL.
+  @param  Entry                  The entry to insert.
+
+  @return The new root of the subtree.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+GcdMapTreeInsert (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node,
+  IN OUT EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  if (Node == NULL) {
+    return Entry;
+  }
+
+  ASSERT (Entry->BaseAddress != Node->BaseAddress);
+  if (Entry->BaseAddress < Node->BaseAddress) {
+    Node->TreeLeft = GcdMapTreeInsert (Node->TreeLeft, Entry);
+  } else {
+    Node->TreeRight = GcdMapTreeInsert (Node->TreeRight, Entry);
+  }
+
+  return GcdMapTreeBalance (Node);
+}
+
+/**
+  Detaches the entry with the lowest BaseAddress from a GCD map subtree.
+
+  @param  Node                   The root of the subtree.
+  @param  Lowest                 Returns the entry detached.
+
+  @return The new root of the subtree.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+GcdMapTreeRemoveLowest (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node,
+  OUT EFI_GCD_MAP_ENTRY     **Lowest
+  )
+{
+  if (Node->TreeLeft == NULL) {
+    *Lowest = Node;
+    return Node->TreeRight;
+  }
+
+  Node->TreeLeft = GcdMapTreeRemoveLowest (Node->TreeLeft, Lowest);
+  return GcdMapTreeBalance (Node);
+}
+
+/**
+  Removes an entry from a GCD map subtree.
+
+  @param  Node                   The root of the subtree.
+  @param  Entry                  The entry to remove.
+
+  @return The new root of the subtree.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+GcdMapTreeRemove (
+  IN OUT EFI_GCD_MAP_ENTRY  *Node,
+  IN OUT EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Successor;
+  EFI_GCD_MAP_ENTRY  *Right;
+
+  ASSERT (Node != NULL);
+
+  if (Entry->BaseAddress < Node->BaseAddress) {
+    Node->TreeLeft = GcdMapTreeRemove (Node->TreeLeft, Entry);
+    return GcdMapTreeBalance (Node);
+  }
+
+  if (Entry->BaseAddress > Node->BaseAddress) {
+    Node->TreeRight = GcdMapTreeRemove (Node->TreeRight, Entry);
+    return GcdMapTreeBalance (Node);
+  }
+
+  ASSERT (Node == Entry);
+  if (Node->TreeRight == NULL) {
+    return Node->TreeLeft;
+  }
+
+  //
+  // Put the next entry in the place of the one removed
+  //
+  Right                = GcdMapTreeRemoveLowest (Node->TreeRight, &Successor);
+  Successor->TreeRight = Right;
+  Successor->TreeLeft  = Node->TreeLeft;
+  return GcdMapTreeBalance (Successor);
+}
+
+/**
+  Internal function.  Inserts an entry of a GCD map into the tree of the map.
+  The entry must not overlap any entry of the tree.
+
+  @param  Map                    The GCD map.
+  @param  Entry                  The entry to insert.
+
+**/
+VOID
+CoreInsertGcdMapTreeEntry (
+  IN LIST_ENTRY             *Map,
+  IN OUT EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  EFI_GCD_MAP_ENTRY  **Tree;
+
+  Entry->TreeLeft   = NULL;
+  Entry->TreeRight  = NULL;
+  Entry->TreeHeight = 1;
+
+  Tree  = CoreGetGcdMapTree (Map);
+  *Tree = GcdMapTreeInsert (*Tree, Entry);
+}
+
+/**
+  Removes an entry of a GCD map from the tree of the map. The BaseAddress of
+  the entry must not have changed since it was inserted.
+
+  @param  Map                    The GCD map.
+  @param  Entry                  The entry to remove.
+
+**/
+STATIC
+VOID
+CoreRemoveGcdMapTreeEntry (
+  IN LIST_ENTRY             *Map,
+  IN OUT EFI_GCD_MAP_ENTRY  *Entry
+  )
+{
+  EFI_GCD_MAP_ENTRY  **Tree;
+
+  Tree  = CoreGetGcdMapTree (Map);
+  *Tree = GcdMapTreeRemove (*Tree, Entry);
+}
+
+/**
+  Finds the entry of a GCD map that covers an address.
+
+  @param  Map                    The GCD map.
+  @param  Address                The address to look up.
+
+  @return The entry covering Address, or NULL if no entry covers it.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreFindGcdMapTreeEntry (
+  IN LIST_ENTRY            *Map,
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Node;
+
+  Node = *CoreGetGcdMapTree (Map);
+  while (Node != NULL) {
+    if (Address < Node->BaseAddress) {
+      Node = Node->TreeLeft;
+    } else if (Address > Node->EndAddress) {
+      Node = Node->TreeRight;
+    } else {
+      break;
+    }
+  }
+
+  return Node;
+}
+
 /**
   Internal function.  Inserts a new descriptor into a sorted list
 
+  @param  Map                    The GCD map
   @param  Link                   The linked list to insert the range BaseAddress
                                  and Length into
   @param  Entry                  A pointer to the entry that is inserted
@@ -429,6 +779,7 @@ CoreAllocateGcdMapEntry (
 **/
 EFI_STATUS
 CoreInsertGcdMapEntry (
+  IN LIST_ENTRY            *Map,
   IN LIST_ENTRY            *Link,
   IN EFI_GCD_MAP_ENTRY     *Entry,
   IN EFI_PHYSICAL_ADDRESS  BaseAddress,
@@ -446,6 +797,12 @@ CoreInsertGcdMapEntry (
     Entry->BaseAddress      = BaseAddress;
     BottomEntry->EndAddress = BaseAddress - 1;
     InsertTailList (Link, &BottomEntry->Link);
+
+    //
+    // Entry keeps its place in the tree, as no entry lies between the
+    // bottom part and its new base address
+    //
+    CoreInsertGcdMapTreeEntry (Map, BottomEntry);
   }
 
   if ((BaseAddress + Length - 1) < Entry->EndAddress) {
@@ -455,6 +812,7 @@ CoreInsertGcdMapEntry (
     TopEntry->BaseAddress = BaseAddress + Length;
     Entry->EndAddress     = BaseAddress + Length - 1;
     InsertHeadList (Link, &TopEntry->Link);
+    CoreInsertGcdMapTreeEntry (Map, TopEntry);
   }
 
   return EFI_SUCCESS;
@@ -526,6 +884,13 @@ CoreMergeGcdMapEntry (
     return EFI_UNSUPPORTED;
   }
 
+  //
+  // Remove the adjacent entry from the tree before Entry takes its base
+  // address. Entry keeps its place in the tree, as the adjacent entry was
+  // the only one between the old and the new base address.
+  //
+  CoreRemoveGcdMapTreeEntry (Map, AdjacentEntry);
+
   if (Forward) {
     Entry->EndAddress = AdjacentEntry->EndAddress;
   } else {
@@ -604,34 +969,31 @@ CoreSearchGcdMapEntry (
   IN  LIST_ENTRY            *Map
   )
 {
-  LIST_ENTRY         *Link;
-  EFI_GCD_MAP_ENTRY  *Entry;
+  EFI_GCD_MAP_ENTRY  *StartEntry;
+  EFI_GCD_MAP_ENTRY  *EndEntry;
 
   ASSERT (Length != 0);
 
   *StartLink = NULL;
   *EndLink   = NULL;
 
-  Link = Map->ForwardLink;
-  while (Link != Map) {
-    Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    if ((BaseAddress >= Entry->BaseAddress) && (BaseAddress <= Entry->EndAddress)) {
-      *StartLink = Link;
-    }
-
-    if (*StartLink != NULL) {
-      if (((BaseAddress + Length - 1) >= Entry->BaseAddress) &&
-          ((BaseAddress + Length - 1) <= Entry->EndAddress))
-      {
-        *EndLink = Link;
-        return EFI_SUCCESS;
-      }
-    }
+  //
+  // Look up the entries that cover the first and the last byte of the
+  // segment in the tree of the map
+  //
+  StartEntry = CoreFindGcdMapTreeEntry (Map, BaseAddress);
+  if (StartEntry == NULL) {
+    return EFI_NOT_FOUND;
+  }
 
-    Link = Link->ForwardLink;
+  EndEntry = CoreFindGcdMapTreeEntry (Map, BaseAddress + Length - 1);
+  if ((EndEntry == NULL) || (EndEntry->BaseAddress < StartEntry->BaseAddress)) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  *StartLink = &StartEntry->Link;
+  *EndLink   = &EndEntry->Link;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -837,6 +1199,7 @@ CoreConvertSpace (
       // Set attributes operation
       //
       case GCD_SET_ATTRIBUTES_MEMORY_OPERATION:
+      case GCD_MAP_ATTRIBUTES_MEMORY_OPERATION:
         if ((Attributes & EFI_MEMORY_RUNTIME) != 0) {
           if (((BaseAddress & EFI_PAGE_MASK) != 0) || ((Length & EFI_PAGE_MASK) != 0)) {
             Status = EFI_INVALID_PARAMETER;
@@ -889,7 +1252,12 @@ CoreConvertSpace (
   // Initialize CpuArchAttributes to suppress incorrect compiler/analyzer warnings.
   //
   CpuArchAttributes = 0;
-  if (Operation == GCD_SET_ATTRIBUTES_MEMORY_OPERATION) {
+  if (Operation == GCD_MAP_ATTRIBUTES_MEMORY_OPERATION) {
+    //
+    // The caller already set the attributes with the CPU Arch Protocol
+    //
+    CpuArchAttributes = ConverToCpuArchAttributes (Attributes);
+  } else if (Operation == GCD_SET_ATTRIBUTES_MEMORY_OPERATION) {
     //
     // Call CPU Arch Protocol to attempt to set attributes on the range
     //
@@ -934,7 +1302,7 @@ CoreConvertSpace (
   Link = StartLink;
   while (Link != EndLink->ForwardLink) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    CoreInsertGcdMapEntry (Link, Entry, BaseAddress, Length, TopEntry, BottomEntry);
+    CoreInsertGcdMapEntry (Map, Link, Entry, BaseAddress, Length, TopEntry, BottomEntry);
     switch (Operation) {
       //
       // Add operations
@@ -973,6 +1341,7 @@ CoreConvertSpace (
       // Set attributes operation
       //
       case GCD_SET_ATTRIBUTES_MEMORY_OPERATION:
+      case GCD_MAP_ATTRIBUTES_MEMORY_OPERATION:
         if (CpuArchAttributes == 0) {
           //
           // Keep original CPU arch attributes when caller just calls
@@ -1322,7 +1691,7 @@ CoreAllocateSpace (
   Link = StartLink;
   while (Link != EndLink->ForwardLink) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    CoreInsertGcdMapEntry (Link, Entry, *BaseAddress, Length, TopEntry, BottomEntry);
+    CoreInsertGcdMapEntry (Map, Link, Entry, *BaseAddress, Length, TopEntry, BottomEntry);
     Entry->ImageHandle  = ImageHandle;
     Entry->DeviceHandle = DeviceHandle;
     Link                = Link->ForwardLink;
@@ -1674,6 +2043,262 @@ CoreSetMemorySpaceAttributes (
   return CoreConvertSpace (GCD_SET_ATTRIBUTES_MEMORY_OPERATION, (EFI_GCD_MEMORY_TYPE)0, (EFI_GCD_IO_TYPE)0, BaseAddress, Length, 0, Attributes);
 }
 
+/**
+  Checks that the attributes of a memory region can be set, as
+  CoreConvertSpace() does for GCD_SET_ATTRIBUTES_MEMORY_OPERATION.
+
+  @param  BaseAddress           Specified start address
+  @param  Length                Specified length
+  @param  Attributes            Specified attributes
+
+  @retval EFI_SUCCESS           The attributes can be set for the memory region.
+  @retval EFI_INVALID_PARAMETER EFI_MEMORY_RUNTIME is set for a region that is not page aligned.
+  @retval EFI_UNSUPPORTED       The region is not in the memory space map, or does not support
+                                the attributes.
+
+**/
+STATIC
+EFI_STATUS
+CoreVerifyMemorySpaceAttributes (
+  IN EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN UINT64                Length,
+  IN UINT64                Attributes
+  )
+{
+  EFI_STATUS         Status;
+  LIST_ENTRY         *Link;
+  LIST_ENTRY         *StartLink;
+  LIST_ENTRY         *EndLink;
+  EFI_GCD_MAP_ENTRY  *Entry;
+
+  if ((Attributes & EFI_MEMORY_RUNTIME) != 0) {
+    if (((BaseAddress & EFI_PAGE_MASK) != 0) || ((Length & EFI_PAGE_MASK) != 0)) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  CoreAcquireGcdMemoryLock ();
+
+  Status = CoreSearchGcdMapEntry (BaseAddress, Length, &StartLink, &EndLink, &mGcdMemorySpaceMap);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_UNSUPPORTED;
+  } else {
+    for (Link = StartLink; Link != EndLink->ForwardLink; Link = Link->ForwardLink) {
+      Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
+      if ((Entry->Capabilities & Attributes) != Attributes) {
+        Status = EFI_UNSUPPORTED;
+        break;
+      }
+    }
+  }
+
+  CoreReleaseGcdMemoryLock ();
+  return Status;
+}
+
+/**
+  Compares two ranges of CoreSetMemorySpaceAttributesBatch() by address.
+
+  @param  Buffer1               The first GCD_ATTRIBUTES_BATCH_RANGE.
+  @param  Buffer2               The second GCD_ATTRIBUTES_BATCH_RANGE.
+
+  @retval <0                    The first range is below the second one.
+  @retval 0                     The ranges are the same entry.
+  @retval >0                    The first range is above the second one.
+
+**/
+STATIC
+INTN
+EFIAPI
+CoreCompareAttributesBatchRange (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST GCD_ATTRIBUTES_BATCH_RANGE  *Range1;
+  CONST GCD_ATTRIBUTES_BATCH_RANGE  *Range2;
+
+  Range1 = (CONST GCD_ATTRIBUTES_BATCH_RANGE *)Buffer1;
+  Range2 = (CONST GCD_ATTRIBUTES_BATCH_RANGE *)Buffer2;
+  if (Range1->BaseAddress != Range2->BaseAddress) {
+    return (Range1->BaseAddress < Range2->BaseAddress) ? -1 : 1;
+  }
+
+  if (Range1->Index != Range2->Index) {
+    return (Range1->Index < Range2->Index) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+/**
+  Set the attributes of a list of memory space ranges.
+
+  The ranges are sorted by address and must not overlap. All of them are
+  checked against the GCD memory space map before any attribute is changed.
+  Contiguous ranges that map to the same CPU arch attributes are then set with
+  a single CPU Architectural Protocol call, even when their GCD attributes
+  differ, and contiguous ranges with the same attributes are updated in the
+  GCD memory space map at once.
+
+  @param  RangeCount            The number of entries in Ranges.
+  @param  Ranges                The memory space ranges and their attributes.
+  @param  FailedIndex           On error, the index in Ranges of the range
+                                that failed. Optional.
+
+  @retval EFI_SUCCESS           The attributes were set for all ranges.
+  @retval EFI_INVALID_PARAMETER RangeCount is 0, Ranges is NULL, a range is
+                                empty or two ranges overlap.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to sort the ranges.
+  @retval Others                The status CoreSetMemorySpaceAttributes()
+                                would return for the range that failed.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSetMemorySpaceAttributesBatch (
+  IN  UINTN                                      RangeCount,
+  IN  CONST EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE  *Ranges,
+  OUT UINTN                                      *FailedIndex  OPTIONAL
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_STATUS                  GcdStatus;
+  GCD_ATTRIBUTES_BATCH_RANGE  *Sorted;
+  GCD_ATTRIBUTES_BATCH_RANGE  SwapBuffer;
+  GCD_ATTRIBUTES_BATCH_RANGE  *Failed;
+  UINTN                       Index;
+  UINTN                       RunStart;
+  UINTN                       Applied;
+  UINTN                       CpuArchCalls;
+  UINT64                      CpuArchAttributes;
+  UINT64                      Length;
+
+  if ((RangeCount == 0) || (Ranges == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  DEBUG ((DEBUG_GCD, "GCD:SetMemorySpaceAttributesBatch(RangeCount=%ld)\n", (UINT64)RangeCount));
+
+  Sorted = AllocatePool (RangeCount * sizeof (GCD_ATTRIBUTES_BATCH_RANGE));
+  if (Sorted == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < RangeCount; Index++) {
+    Sorted[Index].BaseAddress = Ranges[Index].BaseAddress;
+    Sorted[Index].Length      = Ranges[Index].Length;
+    Sorted[Index].Attributes  = Ranges[Index].Attributes;
+    Sorted[Index].Index       = Index;
+  }
+
+  QuickSort (Sorted, RangeCount, sizeof (GCD_ATTRIBUTES_BATCH_RANGE), CoreCompareAttributesBatchRange, &SwapBuffer);
+
+  Status       = EFI_SUCCESS;
+  Failed       = NULL;
+  CpuArchCalls = 0;
+
+  //
+  // Check every range before any attribute is changed
+  //
+  for (Index = 0; Index < RangeCount; Index++) {
+    if ((Sorted[Index].Length == 0) ||
+        (Sorted[Index].Length - 1 > MAX_UINT64 - Sorted[Index].BaseAddress) ||
+        ((Index > 0) && (Sorted[Index].BaseAddress - Sorted[Index - 1].BaseAddress < Sorted[Index - 1].Length)))
+    {
+      Status = EFI_INVALID_PARAMETER;
+    } else {
+      Status = CoreVerifyMemorySpaceAttributes (Sorted[Index].BaseAddress, Sorted[Index].Length, Sorted[Index].Attributes);
+    }
+
+    if (EFI_ERROR (Status)) {
+      Failed = &Sorted[Index];
+      goto Done;
+    }
+  }
+
+  //
+  // Set the CPU arch attributes of each run of contiguous ranges at once.
+  // Ranges without CPU arch attributes keep the current ones, as in
+  // CoreConvertSpace().
+  //
+  Applied = RangeCount;
+  for (RunStart = 0; RunStart < RangeCount; RunStart = Index) {
+    CpuArchAttributes = ConverToCpuArchAttributes (Sorted[RunStart].Attributes);
+    Length            = Sorted[RunStart].Length;
+    for (Index = RunStart + 1; Index < RangeCount; Index++) {
+      if ((ConverToCpuArchAttributes (Sorted[Index].Attributes) != CpuArchAttributes) ||
+          (Sorted[Index].BaseAddress != Sorted[RunStart].BaseAddress + Length) ||
+          (Sorted[Index].Length > MAX_UINT64 - Length))
+      {
+        break;
+      }
+
+      Length += Sorted[Index].Length;
+    }
+
+    if (CpuArchAttributes == 0) {
+      continue;
+    }
+
+    if (gCpu == NULL) {
+      Status = EFI_NOT_AVAILABLE_YET;
+    } else {
+      Status = gCpu->SetMemoryAttributes (gCpu, Sorted[RunStart].BaseAddress, Length, CpuArchAttributes);
+      CpuArchCalls++;
+    }
+
+    if (EFI_ERROR (Status)) {
+      Failed  = &Sorted[RunStart];
+      Applied = RunStart;
+      break;
+    }
+  }
+
+  //
+  // Record the attributes in the GCD memory space map for the ranges the CPU
+  // Architectural Protocol accepted
+  //
+  for (RunStart = 0; RunStart < Applied; RunStart = Index) {
+    Length = Sorted[RunStart].Length;
+    for (Index = RunStart + 1; Index < Applied; Index++) {
+      if ((Sorted[Index].Attributes != Sorted[RunStart].Attributes) ||
+          (Sorted[Index].BaseAddress != Sorted[RunStart].BaseAddress + Length) ||
+          (Sorted[Index].Length > MAX_UINT64 - Length))
+      {
+        break;
+      }
+
+      Length += Sorted[Index].Length;
+    }
+
+    GcdStatus = CoreConvertSpace (
+                  GCD_MAP_ATTRIBUTES_MEMORY_OPERATION,
+                  (EFI_GCD_MEMORY_TYPE)0,
+                  (EFI_GCD_IO_TYPE)0,
+                  Sorted[RunStart].BaseAddress,
+                  Length,
+                  0,
+                  Sorted[RunStart].Attributes
+                  );
+    if (EFI_ERROR (GcdStatus)) {
+      Status = GcdStatus;
+      Failed = &Sorted[RunStart];
+      break;
+    }
+  }
+
+Done:
+  DEBUG ((DEBUG_GCD, "  CpuArchCalls = %ld, Status = %r\n", (UINT64)CpuArchCalls, Status));
+
+  if ((Failed != NULL) && (FailedIndex != NULL)) {
+    *FailedIndex = Failed->Index;
+  }
+
+  FreePool (Sorted);
+  return Status;
+}
+
 /**
   Modifies the capabilities for a memory region in the global coherency domain of the
   processor.
@@ -2547,6 +3172,7 @@ CoreInitializeGcdServices (
   Entry->EndAddress = LShiftU64 (1, SizeOfMemorySpace) - 1;
 
   InsertHeadList (&mGcdMemorySpaceMap, &Entry->Link);
+  CoreInsertGcdMapTreeEntry (&mGcdMemorySpaceMap, Entry);
 
   CoreDumpGcdMemorySpaceMap (TRUE);
 
@@ -2559,6 +3185,7 @@ CoreInitializeGcdServices (
   Entry->EndAddress = LShiftU64 (1, SizeOfIoSpace) - 1;
 
   InsertHeadList (&mGcdIoSpaceMap, &Entry->Link);
+  CoreInsertGcdMapTreeEntry (&mGcdIoSpaceMap, Entry);
 
   CoreDumpGcdIoSpaceMap (TRUE);
 
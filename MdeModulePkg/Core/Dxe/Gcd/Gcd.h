@@ -22,6 +22,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define GCD_REMOVE_MEMORY_OPERATION            (GCD_MEMORY_SPACE_OPERATION | 3)
 #define GCD_SET_ATTRIBUTES_MEMORY_OPERATION    (GCD_MEMORY_SPACE_OPERATION | 4)
 #define GCD_SET_CAPABILITIES_MEMORY_OPERATION  (GCD_MEMORY_SPACE_OPERATION | 5)
+#define GCD_MAP_ATTRIBUTES_MEMORY_OPERATION    (GCD_MEMORY_SPACE_OPERATION | 6)
 
 #define GCD_ADD_IO_OPERATION       (GCD_IO_SPACE_OPERATION | 0)
 #define GCD_ALLOCATE_IO_OPERATION  (GCD_IO_SPACE_OPERATION | 1)
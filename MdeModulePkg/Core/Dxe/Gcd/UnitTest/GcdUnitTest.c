@@ -0,0 +1,1116 @@
+/** @file
+  Host-based unit tests of the GCD memory space map of the DXE Core. The
+  tree of the map is checked against the map after each operation, and its
+  range search against a walk of the map. The attributes set by a batch are
+  checked against the ones set one range at a time.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+#include "../Gcd.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core GCD Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_MEMORY_SPACE_BITS  36
+#define TEST_SPACE_PAGES        4096
+#define TEST_MAX_PAGES          48
+#define TEST_TRACE_STEPS        5000
+#define TEST_SEARCHES           16
+#define TEST_BATCH_RANGES       64
+#define TEST_BATCH_ROUNDS       200
+#define TEST_CHUNK_PAGES        512
+
+#define TEST_CAPABILITIES  (EFI_MEMORY_UC | EFI_MEMORY_WC | EFI_MEMORY_WB | EFI_MEMORY_XP | EFI_MEMORY_RO | EFI_MEMORY_RUNTIME)
+
+//
+// The image handle the trace allocates memory space for
+//
+#define TEST_IMAGE_HANDLE  ((EFI_HANDLE)(UINTN)0x1000)
+
+//
+// The attributes the trace and the batches set
+//
+STATIC CONST UINT64  mTestAttributes[] = {
+  EFI_MEMORY_UC,
+  EFI_MEMORY_WB,
+  EFI_MEMORY_WB | EFI_MEMORY_XP,
+  EFI_MEMORY_WB | EFI_MEMORY_RO,
+  EFI_MEMORY_UC | EFI_MEMORY_XP,
+  EFI_MEMORY_WC,
+  EFI_MEMORY_RUNTIME
+};
+
+//
+// The capabilities the trace adds memory space with
+//
+STATIC CONST UINT64  mTestCapabilities[] = {
+  TEST_CAPABILITIES,
+  EFI_MEMORY_UC | EFI_MEMORY_RUNTIME,
+  EFI_MEMORY_WB | EFI_MEMORY_XP
+};
+
+STATIC UINT32  mSeed;
+
+//
+// What the stub CPU architectural protocol was asked to do: the number of
+// calls, the attributes of each page of the test space, and a page that
+// makes it fail, TEST_SPACE_PAGES if none
+//
+STATIC UINTN   mCpuCalls;
+STATIC UINT64  mCpuPageAttributes[TEST_SPACE_PAGES];
+STATIC UINTN   mCpuFailPage;
+
+//
+// The GCD memory space map of Gcd.c
+//
+extern LIST_ENTRY         mGcdMemorySpaceMap;
+extern EFI_GCD_MAP_ENTRY  *mGcdMemorySpaceTree;
+extern EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate;
+
+/**
+  Internal function.  Inserts an entry of a GCD map into the tree of the map.
+  Defined in Gcd.c.
+
+  @param  Map                    The GCD map.
+  @param  Entry                  The entry to insert.
+
+**/
+VOID
+CoreInsertGcdMapTreeEntry (
+  IN LIST_ENTRY             *Map,
+  IN OUT EFI_GCD_MAP_ENTRY  *Entry
+  );
+
+/**
+  Search a segment of memory space in GCD map. Defined in Gcd.c.
+
+  @param  BaseAddress            The start address of the segment.
+  @param  Length                 The length of the segment.
+  @param  StartLink              The first GCD entry involves this segment of
+                                 memory space.
+  @param  EndLink                The first GCD entry involves this segment of
+                                 memory space.
+  @param  Map                    Points to the start entry to search.
+
+  @retval EFI_SUCCESS            Successfully found the entry.
+  @retval EFI_NOT_FOUND          Not found.
+
+**/
+EFI_STATUS
+CoreSearchGcdMapEntry (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINT64                Length,
+  OUT LIST_ENTRY            **StartLink,
+  OUT LIST_ENTRY            **EndLink,
+  IN  LIST_ENTRY            *Map
+  );
+
+/**
+  Count the amount of GCD map entries. Defined in Gcd.c.
+
+  @param  Map                    Points to the start entry to do the count loop.
+
+  @return The count.
+
+**/
+UINTN
+CoreCountGcdMapEntry (
+  IN LIST_ENTRY  *Map
+  );
+
+/**
+  Add a segment of memory to GCD map. Defined in Gcd.c.
+
+  @param  GcdMemoryType          Memory type of the segment.
+  @param  BaseAddress            Base address of the segment.
+  @param  Length                 Length of the segment.
+  @param  Capabilities           alterable attributes of the segment.
+
+  @retval EFI_SUCCESS            Successfully add a segment.
+  @retval Others                 The segment could not be added.
+
+**/
+EFI_STATUS
+CoreInternalAddMemorySpace (
+  IN EFI_GCD_MEMORY_TYPE   GcdMemoryType,
+  IN EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN UINT64                Length,
+  IN UINT64                Capabilities
+  );
+
+/// === STUB FUNCTIONS ===
+
+BOOLEAN                                     mOnGuarding         = FALSE;
+EFI_HANDLE                                  gDxeCoreImageHandle = NULL;
+VOID                                        *gHobList           = NULL;
+EFI_MEMORY_TYPE_INFORMATION                 gMemoryTypeInformation[EfiMaxMemoryType + 1];
+EFI_LOAD_FIXED_ADDRESS_CONFIGURATION_TABLE  gLoadModuleAtFixAddressConfigurationTable = { 0, 0 };
+
+/**
+  Stub of the CPU architectural protocol SetMemoryAttributes(). Records the
+  attributes of the pages of the test space.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StubSetMemoryAttributes (
+  IN EFI_CPU_ARCH_PROTOCOL  *This,
+  IN EFI_PHYSICAL_ADDRESS   BaseAddress,
+  IN UINT64                 Length,
+  IN UINT64                 Attributes
+  )
+{
+  UINTN  Page;
+
+  mCpuCalls++;
+  for (Page = (UINTN)(BaseAddress / EFI_PAGE_SIZE); Page < TEST_SPACE_PAGES; Page++) {
+    if ((UINT64)Page * EFI_PAGE_SIZE >= BaseAddress + Length) {
+      break;
+    }
+
+    if (Page == mCpuFailPage) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  for (Page = (UINTN)(BaseAddress / EFI_PAGE_SIZE); Page < TEST_SPACE_PAGES; Page++) {
+    if ((UINT64)Page * EFI_PAGE_SIZE >= BaseAddress + Length) {
+      break;
+    }
+
+    mCpuPageAttributes[Page] = Attributes;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_CPU_ARCH_PROTOCOL  mCpuArch = {
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  StubSetMemoryAttributes,
+  1,
+  0
+};
+
+EFI_CPU_ARCH_PROTOCOL  *gCpu = &mCpuArch;
+
+/**
+  Stub of the DXE Core CoreAcquireLock(). The locks are only checked, as the
+  tests run on one thread.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseLock().
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the DXE Core CoreFreePool(), the pool comes from the host heap.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreInitializePool(), the pool comes from the host heap.
+
+**/
+VOID
+CoreInitializePool (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreAddMemoryDescriptor(). The tests do not use the
+  UEFI memory map.
+
+**/
+VOID
+CoreAddMemoryDescriptor (
+  IN EFI_MEMORY_TYPE       Type,
+  IN EFI_PHYSICAL_ADDRESS  Start,
+  IN UINT64                NumberOfPages,
+  IN UINT64                Attribute
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreUpdateMemoryAttributes(). The tests do not use the
+  UEFI memory map.
+
+**/
+VOID
+CoreUpdateMemoryAttributes (
+  IN EFI_PHYSICAL_ADDRESS  Start,
+  IN UINT64                NumberOfPages,
+  IN UINT64                NewAttributes
+  )
+{
+}
+
+/**
+  Stub of HobLib GetNextHob(), the tests have no HOB list.
+
+**/
+VOID *
+EFIAPI
+GetNextHob (
+  IN UINT16      Type,
+  IN CONST VOID  *HobStart
+  )
+{
+  return NULL;
+}
+
+/**
+  Stub of HobLib GetFirstHob(), the tests have no HOB list.
+
+**/
+VOID *
+EFIAPI
+GetFirstHob (
+  IN UINT16  Type
+  )
+{
+  return NULL;
+}
+
+/**
+  Stub of HobLib GetFirstGuidHob(), the tests have no HOB list.
+
+**/
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return NULL;
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Frees the entries of a GCD map.
+
+  @param[in]  Map  The GCD map.
+
+**/
+STATIC
+VOID
+FreeGcdMap (
+  IN LIST_ENTRY  *Map
+  )
+{
+  LIST_ENTRY  *Link;
+
+  while (!IsListEmpty (Map)) {
+    Link = GetFirstNode (Map);
+    RemoveEntryList (Link);
+    FreePool (CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE));
+  }
+}
+
+/**
+  Resets the GCD memory space map to a single non-existent entry that covers
+  the memory space, as CoreInitializeGcdServices() does.
+
+**/
+STATIC
+VOID
+ResetGcdMemorySpaceMap (
+  VOID
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Entry;
+
+  FreeGcdMap (&mGcdMemorySpaceMap);
+  mGcdMemorySpaceTree = NULL;
+
+  Entry = AllocateCopyPool (sizeof (EFI_GCD_MAP_ENTRY), &mGcdMemorySpaceMapEntryTemplate);
+  ASSERT (Entry != NULL);
+
+  Entry->EndAddress = LShiftU64 (1, TEST_MEMORY_SPACE_BITS) - 1;
+  InsertHeadList (&mGcdMemorySpaceMap, &Entry->Link);
+  CoreInsertGcdMapTreeEntry (&mGcdMemorySpaceMap, Entry);
+}
+
+/**
+  Checks a subtree of the GCD memory space map: its entries must be the ones
+  of the map from Link on, in order, and it must be balanced with the right
+  heights.
+
+  @param[in]      Node    The root of the subtree.
+  @param[in, out] Link    The map entry expected first in the subtree. On
+                          return, the one after the subtree.
+  @param[out]     Height  The height of the subtree.
+
+  @retval TRUE   The subtree is consistent.
+  @retval FALSE  The subtree is not consistent.
+
+**/
+STATIC
+BOOLEAN
+GcdTreeIsConsistent (
+  IN     EFI_GCD_MAP_ENTRY  *Node,
+  IN OUT LIST_ENTRY         **Link,
+  OUT    UINTN              *Height
+  )
+{
+  UINTN  LeftHeight;
+  UINTN  RightHeight;
+
+  if (Node == NULL) {
+    *Height = 0;
+    return TRUE;
+  }
+
+  if (!GcdTreeIsConsistent (Node->TreeLeft, Link, &LeftHeight)) {
+    return FALSE;
+  }
+
+  if (*Link != &Node->Link) {
+    return FALSE;
+  }
+
+  *Link = (*Link)->ForwardLink;
+
+  if (!GcdTreeIsConsistent (Node->TreeRight, Link, &RightHeight)) {
+    return FALSE;
+  }
+
+  if ((Node->TreeHeight != 1 + MAX (LeftHeight, RightHeight)) ||
+      (LeftHeight > RightHeight + 1) || (RightHeight > LeftHeight + 1))
+  {
+    return FALSE;
+  }
+
+  *Height = Node->TreeHeight;
+  return TRUE;
+}
+
+/**
+  Checks that the GCD memory space map covers the memory space without gaps
+  and that its tree holds exactly its entries.
+
+  @retval TRUE   The map is consistent.
+  @retval FALSE  The map is not consistent.
+
+**/
+STATIC
+BOOLEAN
+GcdMapIsConsistent (
+  VOID
+  )
+{
+  LIST_ENTRY         *Link;
+  EFI_GCD_MAP_ENTRY  *Entry;
+  UINT64             Next;
+  UINTN              Height;
+
+  Next = 0;
+  for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
+    if ((Entry->BaseAddress != Next) || (Entry->EndAddress < Entry->BaseAddress)) {
+      return FALSE;
+    }
+
+    Next = Entry->EndAddress + 1;
+  }
+
+  if (Next != LShiftU64 (1, TEST_MEMORY_SPACE_BITS)) {
+    return FALSE;
+  }
+
+  Link = mGcdMemorySpaceMap.ForwardLink;
+  if (!GcdTreeIsConsistent (mGcdMemorySpaceTree, &Link, &Height)) {
+    return FALSE;
+  }
+
+  return Link == &mGcdMemorySpaceMap;
+}
+
+/**
+  Searches a segment of the GCD memory space map by walking the map, as
+  CoreSearchGcdMapEntry() did before the map had a tree.
+
+  @param[in]  BaseAddress  The start address of the segment.
+  @param[in]  Length       The length of the segment.
+  @param[out] StartLink    The entry of the first byte of the segment.
+  @param[out] EndLink      The entry of the last byte of the segment.
+
+  @retval EFI_SUCCESS    Both entries were found.
+  @retval EFI_NOT_FOUND  The segment is not covered by the map.
+
+**/
+STATIC
+EFI_STATUS
+WalkGcdMap (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINT64                Length,
+  OUT LIST_ENTRY            **StartLink,
+  OUT LIST_ENTRY            **EndLink
+  )
+{
+  LIST_ENTRY         *Link;
+  EFI_GCD_MAP_ENTRY  *Entry;
+
+  *StartLink = NULL;
+  *EndLink   = NULL;
+  for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
+    if ((BaseAddress >= Entry->BaseAddress) && (BaseAddress <= Entry->EndAddress)) {
+      *StartLink = Link;
+    }
+
+    if (*StartLink != NULL) {
+      if (((BaseAddress + Length - 1) >= Entry->BaseAddress) &&
+          ((BaseAddress + Length - 1) <= Entry->EndAddress))
+      {
+        *EndLink = Link;
+        return EFI_SUCCESS;
+      }
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Checks CoreSearchGcdMapEntry() against a walk of the map for a segment.
+
+  @param[in]  BaseAddress  The start address of the segment.
+  @param[in]  Length       The length of the segment.
+
+  @retval TRUE   Both searches found the same entries.
+  @retval FALSE  The searches differ.
+
+**/
+STATIC
+BOOLEAN
+SearchMatchesWalk (
+  IN EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN UINT64                Length
+  )
+{
+  EFI_STATUS  Status;
+  EFI_STATUS  WalkStatus;
+  LIST_ENTRY  *StartLink;
+  LIST_ENTRY  *EndLink;
+  LIST_ENTRY  *WalkStartLink;
+  LIST_ENTRY  *WalkEndLink;
+
+  Status     = CoreSearchGcdMapEntry (BaseAddress, Length, &StartLink, &EndLink, &mGcdMemorySpaceMap);
+  WalkStatus = WalkGcdMap (BaseAddress, Length, &WalkStartLink, &WalkEndLink);
+  if (Status != WalkStatus) {
+    return FALSE;
+  }
+
+  return EFI_ERROR (Status) || ((StartLink == WalkStartLink) && (EndLink == WalkEndLink));
+}
+
+/**
+  Returns a random segment of whole pages of the test space.
+
+  @param[out] BaseAddress  The start address of the segment.
+  @param[out] Length       The length of the segment.
+
+**/
+STATIC
+VOID
+GetRandomSegment (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  *BaseAddress = EFI_PAGES_TO_SIZE ((UINTN)(GetRandom () % TEST_SPACE_PAGES));
+  *Length      = EFI_PAGES_TO_SIZE ((UINTN)(1 + GetRandom () % TEST_MAX_PAGES));
+}
+
+/**
+  Adds the test space to the GCD memory space map as memory mapped I/O, in
+  chunks of alternating capabilities so that the map has several entries.
+
+**/
+STATIC
+VOID
+AddTestSpace (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Page;
+
+  for (Page = 0; Page < TEST_SPACE_PAGES; Page += TEST_CHUNK_PAGES) {
+    Status = CoreInternalAddMemorySpace (
+               EfiGcdMemoryTypeMemoryMappedIo,
+               EFI_PAGES_TO_SIZE (Page),
+               EFI_PAGES_TO_SIZE (TEST_CHUNK_PAGES),
+               ((Page / TEST_CHUNK_PAGES) % 2 == 0) ? TEST_CAPABILITIES : TEST_CAPABILITIES | EFI_MEMORY_WT
+               );
+    ASSERT_EFI_ERROR (Status);
+  }
+}
+
+/**
+  Returns a copy of the GCD memory space map.
+
+  @param[out] Count  The number of descriptors.
+
+  @return The descriptors, to be freed by the caller.
+
+**/
+STATIC
+EFI_GCD_MEMORY_SPACE_DESCRIPTOR *
+GetMemorySpaceMap (
+  OUT UINTN  *Count
+  )
+{
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Map;
+
+  if (EFI_ERROR (CoreGetMemorySpaceMap (Count, &Map))) {
+    return NULL;
+  }
+
+  return Map;
+}
+
+/**
+  Compares two copies of the GCD memory space map field by field, as the
+  descriptors have padding.
+
+  @param[in]  Map1   The first copy.
+  @param[in]  Map2   The second copy.
+  @param[in]  Count  The number of descriptors of each copy.
+
+  @retval TRUE   The copies match.
+  @retval FALSE  The copies differ.
+
+**/
+STATIC
+BOOLEAN
+MemorySpaceMapsMatch (
+  IN CONST EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Map1,
+  IN CONST EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Map2,
+  IN UINTN                                  Count
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Count; Index++) {
+    if ((Map1[Index].BaseAddress != Map2[Index].BaseAddress) ||
+        (Map1[Index].Length != Map2[Index].Length) ||
+        (Map1[Index].Capabilities != Map2[Index].Capabilities) ||
+        (Map1[Index].Attributes != Map2[Index].Attributes) ||
+        (Map1[Index].GcdMemoryType != Map2[Index].GcdMemoryType) ||
+        (Map1[Index].ImageHandle != Map2[Index].ImageHandle) ||
+        (Map1[Index].DeviceHandle != Map2[Index].DeviceHandle))
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Resets the random sequence, the stub CPU architectural protocol and the
+  GCD memory space map.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED  The setup succeeded.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+GcdSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mSeed        = 0x5eed;
+  gCpu         = &mCpuArch;
+  mCpuCalls    = 0;
+  mCpuFailPage = TEST_SPACE_PAGES;
+  ZeroMem (mCpuPageAttributes, sizeof (mCpuPageAttributes));
+  ResetGcdMemorySpaceMap ();
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the GCD memory space map.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+GcdCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FreeGcdMap (&mGcdMemorySpaceMap);
+  mGcdMemorySpaceTree = NULL;
+}
+
+/// === TEST CASES ===
+
+/**
+  Memory space that is added, removed, allocated, freed and given new
+  attributes and capabilities at random should keep the tree of the map
+  consistent, and searches through the tree should find the entries a walk
+  of the map finds.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SearchShouldMatchMapWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PHYSICAL_ADDRESS  BaseAddress;
+  UINT64                Length;
+  UINTN                 Step;
+  UINTN                 Search;
+  UINTN                 Entries;
+  UINTN                 MaxEntries;
+  UINTN                 Succeeded;
+  EFI_STATUS            Status;
+
+  MaxEntries = 0;
+  Succeeded  = 0;
+  for (Step = 0; Step < TEST_TRACE_STEPS; Step++) {
+    GetRandomSegment (&BaseAddress, &Length);
+    switch (GetRandom () % 6) {
+      case 0:
+        Status = CoreInternalAddMemorySpace (
+                   (GetRandom () % 2 == 0) ? EfiGcdMemoryTypeMemoryMappedIo : EfiGcdMemoryTypeReserved,
+                   BaseAddress,
+                   Length,
+                   mTestCapabilities[GetRandom () % ARRAY_SIZE (mTestCapabilities)]
+                   );
+        break;
+
+      case 1:
+        Status = CoreRemoveMemorySpace (BaseAddress, Length);
+        break;
+
+      case 2:
+        Status = CoreAllocateMemorySpace (
+                   EfiGcdAllocateAddress,
+                   EfiGcdMemoryTypeMemoryMappedIo,
+                   0,
+                   Length,
+                   &BaseAddress,
+                   TEST_IMAGE_HANDLE,
+                   NULL
+                   );
+        break;
+
+      case 3:
+        Status = CoreFreeMemorySpace (BaseAddress, Length);
+        break;
+
+      case 4:
+        Status = CoreSetMemorySpaceAttributes (BaseAddress, Length, mTestAttributes[GetRandom () % ARRAY_SIZE (mTestAttributes)]);
+        break;
+
+      default:
+        Status = CoreSetMemorySpaceCapabilities (BaseAddress, Length, mTestCapabilities[GetRandom () % ARRAY_SIZE (mTestCapabilities)]);
+        break;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Succeeded++;
+    }
+
+    UT_ASSERT_TRUE (GcdMapIsConsistent ());
+
+    for (Search = 0; Search < TEST_SEARCHES; Search++) {
+      GetRandomSegment (&BaseAddress, &Length);
+      BaseAddress += GetRandom () % EFI_PAGE_SIZE;
+      UT_ASSERT_TRUE (SearchMatchesWalk (BaseAddress, Length));
+    }
+
+    Entries    = CoreCountGcdMapEntry (&mGcdMemorySpaceMap);
+    MaxEntries = MAX (MaxEntries, Entries);
+  }
+
+  //
+  // Segments at the ends of the memory space, and past its end
+  //
+  UT_ASSERT_TRUE (SearchMatchesWalk (0, 1));
+  UT_ASSERT_TRUE (SearchMatchesWalk (LShiftU64 (1, TEST_MEMORY_SPACE_BITS) - 1, 1));
+  UT_ASSERT_TRUE (SearchMatchesWalk (LShiftU64 (1, TEST_MEMORY_SPACE_BITS) - 1, 2));
+  UT_ASSERT_TRUE (SearchMatchesWalk (LShiftU64 (1, TEST_MEMORY_SPACE_BITS), 1));
+  UT_ASSERT_TRUE (SearchMatchesWalk (0, LShiftU64 (1, TEST_MEMORY_SPACE_BITS)));
+
+  UT_ASSERT_NOT_EQUAL (Succeeded, 0);
+  UT_LOG_INFO (
+    "%d operations, %d succeeded, up to %d map entries\n",
+    TEST_TRACE_STEPS,
+    (INT32)Succeeded,
+    (INT32)MaxEntries
+    );
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A batch of ranges, listed in any order, should leave the GCD memory space
+  map and the CPU attributes as setting the ranges one at a time does, with
+  no more calls to the CPU architectural protocol.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BatchShouldMatchSingleRanges (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE  Ranges[TEST_BATCH_RANGES];
+  EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE  Swap;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR      *BatchMap;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR      *SingleMap;
+  UINT64                               *BatchPages;
+  UINTN                                BatchCount;
+  UINTN                                SingleCount;
+  UINTN                                BatchCalls;
+  UINTN                                SingleCalls;
+  UINTN                                Round;
+  UINTN                                Count;
+  UINTN                                Index;
+  UINTN                                Other;
+  UINTN                                Page;
+  UINTN                                FailedIndex;
+
+  BatchPages = AllocatePool (sizeof (mCpuPageAttributes));
+  UT_ASSERT_NOT_NULL (BatchPages);
+
+  BatchCalls  = 0;
+  SingleCalls = 0;
+  for (Round = 0; Round < TEST_BATCH_ROUNDS; Round++) {
+    //
+    // Ranges of whole pages that do not overlap, adjacent at times
+    //
+    Page  = 0;
+    Count = 0;
+    while (Count < TEST_BATCH_RANGES) {
+      Page += GetRandom () % 3;
+      Ranges[Count].BaseAddress = EFI_PAGES_TO_SIZE (Page);
+      Ranges[Count].Length      = EFI_PAGES_TO_SIZE ((UINTN)(1 + GetRandom () % 8));
+      Ranges[Count].Attributes  = mTestAttributes[GetRandom () % ARRAY_SIZE (mTestAttributes)];
+      Page                     += (UINTN)EFI_SIZE_TO_PAGES (Ranges[Count].Length);
+      if (Page > TEST_SPACE_PAGES) {
+        break;
+      }
+
+      Count++;
+    }
+
+    for (Index = Count; Index > 1; Index--) {
+      Other = GetRandom () % Index;
+      CopyMem (&Swap, &Ranges[Index - 1], sizeof (Swap));
+      CopyMem (&Ranges[Index - 1], &Ranges[Other], sizeof (Swap));
+      CopyMem (&Ranges[Other], &Swap, sizeof (Swap));
+    }
+
+    ResetGcdMemorySpaceMap ();
+    AddTestSpace ();
+    mCpuCalls = 0;
+    ZeroMem (mCpuPageAttributes, sizeof (mCpuPageAttributes));
+    UT_ASSERT_NOT_EFI_ERROR (CoreSetMemorySpaceAttributesBatch (Count, Ranges, &FailedIndex));
+    UT_ASSERT_TRUE (GcdMapIsConsistent ());
+    BatchCalls += mCpuCalls;
+    BatchMap    = GetMemorySpaceMap (&BatchCount);
+    UT_ASSERT_NOT_NULL (BatchMap);
+    CopyMem (BatchPages, mCpuPageAttributes, sizeof (mCpuPageAttributes));
+
+    ResetGcdMemorySpaceMap ();
+    AddTestSpace ();
+    mCpuCalls = 0;
+    ZeroMem (mCpuPageAttributes, sizeof (mCpuPageAttributes));
+    for (Index = 0; Index < Count; Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (CoreSetMemorySpaceAttributes (Ranges[Index].BaseAddress, Ranges[Index].Length, Ranges[Index].Attributes));
+    }
+
+    SingleCalls += mCpuCalls;
+    SingleMap    = GetMemorySpaceMap (&SingleCount);
+    UT_ASSERT_NOT_NULL (SingleMap);
+
+    UT_ASSERT_EQUAL (BatchCount, SingleCount);
+    UT_ASSERT_TRUE (MemorySpaceMapsMatch (BatchMap, SingleMap, BatchCount));
+    UT_ASSERT_MEM_EQUAL (BatchPages, mCpuPageAttributes, sizeof (mCpuPageAttributes));
+    FreePool (BatchMap);
+    FreePool (SingleMap);
+  }
+
+  UT_ASSERT_TRUE (BatchCalls < SingleCalls);
+  UT_LOG_INFO (
+    "%d batches: %d CPU calls, %d one range at a time\n",
+    TEST_BATCH_ROUNDS,
+    (INT32)BatchCalls,
+    (INT32)SingleCalls
+    );
+
+  FreePool (BatchPages);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A batch should be refused as a whole, and report the range at fault, when
+  ranges overlap or a range does not support its attributes. When the CPU
+  architectural protocol fails, the ranges below the failure keep their new
+  attributes and the others are left unchanged.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BatchShouldReportFailedRange (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE  Ranges[3];
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR      *Before;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR      *After;
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR      Descriptor;
+  UINTN                                BeforeCount;
+  UINTN                                AfterCount;
+  UINTN                                FailedIndex;
+
+  AddTestSpace ();
+  Before = GetMemorySpaceMap (&BeforeCount);
+  UT_ASSERT_NOT_NULL (Before);
+
+  //
+  // The last two ranges overlap
+  //
+  Ranges[0].BaseAddress = EFI_PAGES_TO_SIZE (16);
+  Ranges[0].Length      = EFI_PAGES_TO_SIZE (4);
+  Ranges[0].Attributes  = EFI_MEMORY_UC;
+  Ranges[1].BaseAddress = EFI_PAGES_TO_SIZE (8);
+  Ranges[1].Length      = EFI_PAGES_TO_SIZE (4);
+  Ranges[1].Attributes  = EFI_MEMORY_WB;
+  Ranges[2].BaseAddress = EFI_PAGES_TO_SIZE (10);
+  Ranges[2].Length      = EFI_PAGES_TO_SIZE (1);
+  Ranges[2].Attributes  = EFI_MEMORY_WB;
+  FailedIndex           = MAX_UINTN;
+  UT_ASSERT_STATUS_EQUAL (CoreSetMemorySpaceAttributesBatch (3, Ranges, &FailedIndex), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (FailedIndex, 2);
+
+  //
+  // The second range is beyond the test space, where no attribute is
+  // supported
+  //
+  Ranges[1].BaseAddress = EFI_PAGES_TO_SIZE (TEST_SPACE_PAGES);
+  Ranges[2].BaseAddress = EFI_PAGES_TO_SIZE (32);
+  FailedIndex           = MAX_UINTN;
+  UT_ASSERT_STATUS_EQUAL (CoreSetMemorySpaceAttributesBatch (3, Ranges, &FailedIndex), EFI_UNSUPPORTED);
+  UT_ASSERT_EQUAL (FailedIndex, 1);
+
+  //
+  // Nothing changed
+  //
+  UT_ASSERT_EQUAL (mCpuCalls, 0);
+  After = GetMemorySpaceMap (&AfterCount);
+  UT_ASSERT_NOT_NULL (After);
+  UT_ASSERT_EQUAL (AfterCount, BeforeCount);
+  UT_ASSERT_TRUE (MemorySpaceMapsMatch (After, Before, BeforeCount));
+  FreePool (After);
+  FreePool (Before);
+
+  //
+  // The CPU architectural protocol fails on the range in the middle
+  //
+  Ranges[1].BaseAddress = EFI_PAGES_TO_SIZE (24);
+  mCpuFailPage          = 24;
+  FailedIndex           = MAX_UINTN;
+  UT_ASSERT_STATUS_EQUAL (CoreSetMemorySpaceAttributesBatch (3, Ranges, &FailedIndex), EFI_DEVICE_ERROR);
+  UT_ASSERT_EQUAL (FailedIndex, 1);
+  UT_ASSERT_TRUE (GcdMapIsConsistent ());
+
+  UT_ASSERT_NOT_EFI_ERROR (CoreGetMemorySpaceDescriptor (Ranges[0].BaseAddress, &Descriptor));
+  UT_ASSERT_EQUAL (Descriptor.Attributes, EFI_MEMORY_UC);
+  UT_ASSERT_NOT_EFI_ERROR (CoreGetMemorySpaceDescriptor (Ranges[1].BaseAddress, &Descriptor));
+  UT_ASSERT_EQUAL (Descriptor.Attributes, 0);
+  UT_ASSERT_NOT_EFI_ERROR (CoreGetMemorySpaceDescriptor (Ranges[2].BaseAddress, &Descriptor));
+  UT_ASSERT_EQUAL (Descriptor.Attributes, 0);
+
+  //
+  // Nothing is set before the CPU architectural protocol is installed
+  //
+  gCpu        = NULL;
+  FailedIndex = MAX_UINTN;
+  UT_ASSERT_STATUS_EQUAL (CoreSetMemorySpaceAttributesBatch (3, Ranges, &FailedIndex), EFI_NOT_AVAILABLE_YET);
+  UT_ASSERT_EQUAL (FailedIndex, 0);
+  UT_ASSERT_NOT_EFI_ERROR (CoreGetMemorySpaceDescriptor (Ranges[2].BaseAddress, &Descriptor));
+  UT_ASSERT_EQUAL (Descriptor.Attributes, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  GCD memory space map of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      GcdTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core GCD Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&GcdTests, Framework, "DXE Core GCD Memory Space Map Tests", "DxeCore.Gcd.MemorySpace", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core GCD Memory Space Map Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite------Description------------------------------------------------Name------Function-----------------------Pre-------Post--------Context-----------
+  //
+  AddTestCase (GcdTests, "Tree searches match a walk of the map", "Search", SearchShouldMatchMapWalk, GcdSetup, GcdCleanup, NULL);
+  AddTestCase (GcdTests, "A batch matches ranges set one at a time", "Batch", BatchShouldMatchSingleRanges, GcdSetup, GcdCleanup, NULL);
+  AddTestCase (GcdTests, "A failed batch reports the range at fault", "BatchError", BatchShouldReportFailedRange, GcdSetup, GcdCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCoreGcdUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCoreGcdUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -9,16 +9,34 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "DxeMain.h"
 #include "Handle.h"
 
+//
+// Initial number of slots of the protocol entry hash index, must be a power of 2
+//
+#define PROTOCOL_INDEX_INITIAL_SIZE  256
+
 //
 // mProtocolDatabase     - A list of all protocols in the system.  (simple list for now)
+// mProtocolIndex        - Open-addressed hash index of mProtocolDatabase keyed by GUID
 // gHandleList           - A list of all the handles in the system
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
+// gProtocolInstallKey   -  The Key to show that a protocol interface has been installed
 //
 LIST_ENTRY  mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
 LIST_ENTRY  gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK    gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64      gHandleDatabaseKey    = 0;
+UINT64      gProtocolInstallKey   = 0;
+
+//
+// Protocol entries are never removed from the protocol database, so the
+// index only ever needs insertion and lookup.
+//
+PROTOCOL_ENTRY             **mProtocolIndex    = NULL;
+UINTN                      mProtocolIndexSize  = 0;
+UINTN                      mProtocolIndexCount = 0;
+BOOLEAN                    mProtocolIndexValid = TRUE;
+PROTOCOL_INDEX_STATISTICS  mProtocolIndexStatistics;
 
 /**
   Acquire lock on gProtocolDatabaseLock.
@@ -78,6 +96,113 @@ CoreValidateHandle (
   return EFI_INVALID_PARAMETER;
 }
 
+/**
+  Compute the protocol index hash of a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return The hash value
+
+**/
+STATIC
+UINTN
+CoreHashProtocolGuid (
+  IN CONST EFI_GUID  *Protocol
+  )
+{
+  UINT64  Hash;
+
+  //
+  // GUIDs are random enough that folding the two halves together
+  // distributes them well over the index.
+  //
+  Hash  = ReadUnaligned64 ((CONST UINT64 *)Protocol) ^
+          ReadUnaligned64 ((CONST UINT64 *)Protocol + 1);
+  Hash ^= RShiftU64 (Hash, 32);
+  return (UINTN)Hash;
+}
+
+/**
+  Insert a protocol entry into the protocol index slot table without
+  checking for duplicates or growing the table.
+
+  @param  Index                  The slot table
+  @param  IndexSize              The number of slots, a power of 2
+  @param  ProtEntry              The protocol entry to insert
+
+**/
+STATIC
+VOID
+CoreInsertProtocolIndexSlot (
+  IN PROTOCOL_ENTRY  **Index,
+  IN UINTN           IndexSize,
+  IN PROTOCOL_ENTRY  *ProtEntry
+  )
+{
+  UINTN  Slot;
+
+  Slot = CoreHashProtocolGuid (&ProtEntry->ProtocolID) & (IndexSize - 1);
+  while (Index[Slot] != NULL) {
+    Slot = (Slot + 1) & (IndexSize - 1);
+  }
+
+  Index[Slot] = ProtEntry;
+}
+
+/**
+  Add a protocol entry to the protocol index, growing the index when it
+  becomes half full. If the entry cannot be indexed, the index is marked
+  invalid and lookups fall back to the linear search of mProtocolDatabase.
+
+  @param  ProtEntry              The protocol entry to add
+
+**/
+STATIC
+VOID
+CoreAddProtocolIndexEntry (
+  IN PROTOCOL_ENTRY  *ProtEntry
+  )
+{
+  PROTOCOL_ENTRY  **NewIndex;
+  UINTN           NewSize;
+  UINTN           Slot;
+
+  if (!mProtocolIndexValid) {
+    return;
+  }
+
+  if ((mProtocolIndexCount + 1) * 2 > mProtocolIndexSize) {
+    NewSize  = MAX (mProtocolIndexSize * 2, PROTOCOL_INDEX_INITIAL_SIZE);
+    NewIndex = AllocateZeroPool (NewSize * sizeof (PROTOCOL_ENTRY *));
+    if (NewIndex == NULL) {
+      //
+      // Keep using the current index as long as it has an empty slot left
+      // to terminate the probe sequence.
+      //
+      if (mProtocolIndexCount + 1 >= mProtocolIndexSize) {
+        mProtocolIndexValid = FALSE;
+        return;
+      }
+    } else {
+      for (Slot = 0; Slot < mProtocolIndexSize; Slot++) {
+        if (mProtocolIndex[Slot] != NULL) {
+          CoreInsertProtocolIndexSlot (NewIndex, NewSize, mProtocolIndex[Slot]);
+        }
+      }
+
+      if (mProtocolIndex != NULL) {
+        CoreFreePool (mProtocolIndex);
+      }
+
+      mProtocolIndex     = NewIndex;
+      mProtocolIndexSize = NewSize;
+    }
+  }
+
+  CoreInsertProtocolIndexSlot (mProtocolIndex, mProtocolIndexSize, ProtEntry);
+  mProtocolIndexCount++;
+}
+
 /**
   Finds the protocol entry for the requested protocol.
   The gProtocolDatabaseLock must be owned
@@ -97,6 +222,8 @@ CoreFindProtocolEntry (
   LIST_ENTRY      *Link;
   PROTOCOL_ENTRY  *Item;
   PROTOCOL_ENTRY  *ProtEntry;
+  UINTN           Slot;
+  UINTN           Depth;
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
 
@@ -105,18 +232,48 @@ CoreFindProtocolEntry (
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
-       Link = Link->ForwardLink)
-  {
-    Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
-    if (CompareGuid (&Item->ProtocolID, Protocol)) {
-      //
-      // This is the protocol entry
-      //
+  mProtocolIndexStatistics.Lookups++;
+  if (mProtocolIndexValid) {
+    //
+    // Every protocol entry is indexed: probe the hash index until the
+    // matching entry or an empty slot is found.
+    //
+    Depth = 0;
+    if (mProtocolIndexSize != 0) {
+      Slot = CoreHashProtocolGuid (Protocol) & (mProtocolIndexSize - 1);
+      while (mProtocolIndex[Slot] != NULL) {
+        Depth++;
+        if (CompareGuid (&mProtocolIndex[Slot]->ProtocolID, Protocol)) {
+          ProtEntry = mProtocolIndex[Slot];
+          break;
+        }
 
-      ProtEntry = Item;
-      break;
+        Slot = (Slot + 1) & (mProtocolIndexSize - 1);
+      }
+    }
+
+    mProtocolIndexStatistics.Probes += Depth;
+    if (Depth > mProtocolIndexStatistics.MaxDepth) {
+      mProtocolIndexStatistics.MaxDepth = Depth;
+    }
+
+    if (ProtEntry != NULL) {
+      mProtocolIndexStatistics.Hits++;
+    }
+  } else {
+    for (Link = mProtocolDatabase.ForwardLink;
+         Link != &mProtocolDatabase;
+         Link = Link->ForwardLink)
+    {
+      Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+      if (CompareGuid (&Item->ProtocolID, Protocol)) {
+        //
+        // This is the protocol entry
+        //
+
+        ProtEntry = Item;
+        break;
+      }
     }
   }
 
@@ -131,7 +288,8 @@ CoreFindProtocolEntry (
       //
       // Initialize new protocol entry structure
       //
-      ProtEntry->Signature = PROTOCOL_ENTRY_SIGNATURE;
+      ProtEntry->Signature  = PROTOCOL_ENTRY_SIGNATURE;
+      ProtEntry->InstallKey = 0;
       CopyGuid ((VOID *)&ProtEntry->ProtocolID, Protocol);
       InitializeListHead (&ProtEntry->Protocols);
       InitializeListHead (&ProtEntry->Notify);
@@ -140,6 +298,7 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      CoreAddProtocolIndexEntry (ProtEntry);
     }
   }
 
@@ -447,6 +606,8 @@ CoreInstallProtocolInterfaceNotify (
   // protocol entry
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
+  gProtocolInstallKey++;
+  ProtEntry->InstallKey = gProtocolInstallKey;
 
   //
   // Notify the notification list for this protocol
@@ -887,13 +1048,21 @@ CoreGetProtocolInterface (
 
   Handle = (IHANDLE *)UserHandle;
 
+  //
+  // Resolve the GUID once through the protocol index. A protocol that was
+  // never installed cannot be on the handle.
+  //
+  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
+  if (ProtEntry == NULL) {
+    return NULL;
+  }
+
   //
   // Look at each protocol interface for a match
   //
   for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-    Prot      = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
+    Prot = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+    if (Prot->Protocol == ProtEntry) {
       return Prot;
     }
   }
@@ -1504,6 +1673,129 @@ CoreGetHandleDatabaseKey (
   return gHandleDatabaseKey;
 }
 
+/**
+  Returns the protocol entry of a protocol, creating the entry when no
+  interface of the protocol has been installed yet. The entry stays valid
+  for the life of the protocol database.
+
+  @param  Protocol               The ID of the protocol
+
+  @return Protocol entry, or NULL if it could not be created
+
+**/
+VOID *
+CoreGetProtocolEntry (
+  IN EFI_GUID  *Protocol
+  )
+{
+  PROTOCOL_ENTRY  *ProtEntry;
+
+  CoreAcquireProtocolLock ();
+  ProtEntry = CoreFindProtocolEntry (Protocol, TRUE);
+  CoreReleaseProtocolLock ();
+
+  return ProtEntry;
+}
+
+/**
+  Check whether any interface of the protocol of a protocol entry is installed.
+
+  @param  ProtocolEntry          Protocol entry returned by CoreGetProtocolEntry()
+
+  @retval TRUE                   An interface of the protocol is installed.
+  @retval FALSE                  No interface of the protocol is installed.
+
+**/
+BOOLEAN
+CoreIsProtocolEntryInstalled (
+  IN VOID  *ProtocolEntry
+  )
+{
+  BOOLEAN  Installed;
+
+  CoreAcquireProtocolLock ();
+  Installed = (BOOLEAN)!IsListEmpty (&((PROTOCOL_ENTRY *)ProtocolEntry)->Protocols);
+  CoreReleaseProtocolLock ();
+
+  return Installed;
+}
+
+/**
+  Returns the protocol install key of the last install of an interface of the
+  protocol of a protocol entry.
+
+  @param  ProtocolEntry          Protocol entry returned by CoreGetProtocolEntry()
+
+  @return The value of the protocol install key after the last install, or 0
+          if no interface of the protocol is installed.
+
+**/
+UINT64
+CoreGetProtocolEntryInstallKey (
+  IN VOID  *ProtocolEntry
+  )
+{
+  UINT64  InstallKey;
+
+  CoreAcquireProtocolLock ();
+  InstallKey = ((PROTOCOL_ENTRY *)ProtocolEntry)->InstallKey;
+  CoreReleaseProtocolLock ();
+
+  return InstallKey;
+}
+
+/**
+  Check whether an interface of the protocol of any of the protocol entries
+  has been installed since the protocol install key had a given value.
+
+  @param  ProtocolEntries        Protocol entries returned by CoreGetProtocolEntry()
+  @param  Count                  Number of entries in ProtocolEntries
+  @param  InstallKey             Value returned by CoreGetProtocolInstallKey()
+
+  @retval TRUE                   An interface has been installed since InstallKey.
+  @retval FALSE                  No interface has been installed since InstallKey.
+
+**/
+BOOLEAN
+CoreProtocolEntriesInstalledSince (
+  IN VOID    **ProtocolEntries,
+  IN UINTN   Count,
+  IN UINT64  InstallKey
+  )
+{
+  UINTN    Index;
+  BOOLEAN  Installed;
+
+  Installed = FALSE;
+
+  CoreAcquireProtocolLock ();
+  for (Index = 0; Index < Count; Index++) {
+    if (((PROTOCOL_ENTRY *)ProtocolEntries[Index])->InstallKey > InstallKey) {
+      Installed = TRUE;
+      break;
+    }
+  }
+
+  CoreReleaseProtocolLock ();
+
+  return Installed;
+}
+
+/**
+  return protocol install key, it is increased on every protocol interface
+  install and reinstall.
+
+  @return Protocol install key.
+
+**/
+UINT64
+CoreGetProtocolInstallKey (
+  VOID
+  )
+{
+  return gProtocolInstallKey;
+}
+
 /**
   Go connect any handles that were created or modified while a image executed.
 
@@ -1561,3 +1853,54 @@ CoreConnectHandlesByKey (
 
   CoreFreePool (HandleBuffer);
 }
+
+/**
+  Logs a protocol index counter as a PERF_EVENT record. FPDT records only
+  carry a timestamp and a name, so the value is part of the name.
+
+  @param  Format                 The format of the record name, with a %ld
+                                 for the value
+  @param  Value                  The value of the counter
+
+**/
+STATIC
+VOID
+CoreLogProtocolIndexCounter (
+  IN CONST CHAR8  *Format,
+  IN UINT64       Value
+  )
+{
+  CHAR8  Name[FPDT_STRING_EVENT_RECORD_NAME_LENGTH];
+
+  AsciiSPrint (Name, sizeof (Name), Format, Value);
+  PERF_EVENT (Name);
+}
+
+/**
+  Reports the protocol index statistics collected during boot services, in
+  the debug log and as PERF_EVENT records.
+
+**/
+VOID
+CoreDumpProtocolIndexStatistics (
+  VOID
+  )
+{
+  if (LogPerformanceMeasurementEnabled (PERF_GENERAL_TYPE)) {
+    CoreLogProtocolIndexCounter ("ProtIdx Entries %ld", (UINT64)mProtocolIndexCount);
+    CoreLogProtocolIndexCounter ("ProtIdx Lookups %ld", mProtocolIndexStatistics.Lookups);
+    CoreLogProtocolIndexCounter ("ProtIdx Hits %ld", mProtocolIndexStatistics.Hits);
+    CoreLogProtocolIndexCounter ("ProtIdx Probes %ld", mProtocolIndexStatistics.Probes);
+    CoreLogProtocolIndexCounter ("ProtIdx MaxDepth %ld", (UINT64)mProtocolIndexStatistics.MaxDepth);
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Protocol index statistics: %ld entries, %ld lookups, %ld hits, %ld probes, %ld max depth\n",
+    (UINT64)mProtocolIndexCount,
+    mProtocolIndexStatistics.Lookups,
+    mProtocolIndexStatistics.Hits,
+    mProtocolIndexStatistics.Probes,
+    (UINT64)mProtocolIndexStatistics.MaxDepth
+    ));
+}
@@ -44,8 +44,24 @@ typedef struct {
   LIST_ENTRY    Protocols;
   /// Registerd notification handlers
   LIST_ENTRY    Notify;
+  /// The gProtocolInstallKey value when an interface was last installed
+  UINT64        InstallKey;
 } PROTOCOL_ENTRY;
 
+///
+/// PROTOCOL_INDEX_STATISTICS - protocol entry hash index counters
+///
+typedef struct {
+  /// Number of CoreFindProtocolEntry() calls served by the index
+  UINT64    Lookups;
+  /// Number of lookups that found an entry
+  UINT64    Hits;
+  /// Number of index slots compared over all lookups
+  UINT64    Probes;
+  /// Largest number of slots compared by a single lookup
+  UINTN     MaxDepth;
+} PROTOCOL_INDEX_STATISTICS;
+
 #define PROTOCOL_INTERFACE_SIGNATURE  SIGNATURE_32('p','i','f','c')
 
 ///
@@ -248,5 +264,6 @@ CoreValidateHandle (
 extern EFI_LOCK    gProtocolDatabaseLock;
 extern LIST_ENTRY  gHandleList;
 extern UINT64      gHandleDatabaseKey;
+extern UINT64      gProtocolInstallKey;
 
 #endif
@@ -242,6 +242,8 @@ CoreReinstallProtocolInterface (
   // protocol entry
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
+  gProtocolInstallKey++;
+  ProtEntry->InstallKey = gProtocolInstallKey;
 
   //
   // Update the Key to show that the handle has been created/modified
@@ -0,0 +1,730 @@
+/** @file
+  Host-based unit tests of the protocol database of the DXE Core. Protocol
+  interfaces are installed and uninstalled on handles, and checked against a
+  model that records which interface each handle carries for each protocol.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+#include "../Handle.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Protocol Database Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// Enough protocols for the index to grow several times past its initial
+// 256 slots
+//
+#define TEST_GUID_COUNT     1000
+#define TEST_CHECK_PERIOD   64
+#define TEST_HANDLE_COUNT   32
+#define TEST_TRACE_GUIDS    64
+#define TEST_TRACE_STEPS    20000
+#define TEST_MISSING_GUIDS  100
+
+//
+// The protocols of the tests, and an interface for each of them
+//
+STATIC EFI_GUID  mGuids[TEST_GUID_COUNT];
+STATIC UINT8     mInterfaces[TEST_GUID_COUNT];
+STATIC UINT32    mSeed;
+
+//
+// The handles of the tests, NULL once the last interface was removed, and
+// the interface the model expects on each of them for each protocol of the
+// trace
+//
+STATIC EFI_HANDLE  mHandles[TEST_HANDLE_COUNT];
+STATIC VOID        *mInstalled[TEST_HANDLE_COUNT][TEST_TRACE_GUIDS];
+
+//
+// The protocol database of Handle.c
+//
+extern LIST_ENTRY                 mProtocolDatabase;
+extern PROTOCOL_ENTRY             **mProtocolIndex;
+extern UINTN                      mProtocolIndexSize;
+extern UINTN                      mProtocolIndexCount;
+extern BOOLEAN                    mProtocolIndexValid;
+extern PROTOCOL_INDEX_STATISTICS  mProtocolIndexStatistics;
+
+/// === STUB FUNCTIONS ===
+
+EFI_HANDLE  gDxeCoreImageHandle = NULL;
+
+/**
+  Stub of the DXE Core CoreAcquireLock(). The locks are only checked, as the
+  tests run on one thread.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseLock().
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the DXE Core CoreRaiseTpl().
+
+**/
+EFI_TPL
+EFIAPI
+CoreRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+/**
+  Stub of the DXE Core CoreRestoreTpl().
+
+**/
+VOID
+EFIAPI
+CoreRestoreTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreLocateDevicePath(). The tests install no device
+  path.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreLocateDevicePath (
+  IN     EFI_GUID                  *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL  **DevicePath,
+  OUT    EFI_HANDLE                *Device
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of the DXE Core CoreFreePool(), the pool comes from the host heap.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreSignalEvent(). No protocol notify is registered
+  by the tests.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSignalEvent (
+  IN EFI_EVENT  UserEvent
+  )
+{
+  ASSERT (FALSE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreConnectController(). The tests install no driver.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreConnectController (
+  IN  EFI_HANDLE                ControllerHandle,
+  IN  EFI_HANDLE                *DriverImageHandle    OPTIONAL,
+  IN  EFI_DEVICE_PATH_PROTOCOL  *RemainingDevicePath  OPTIONAL,
+  IN  BOOLEAN                   Recursive
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreDisconnectController(). The tests open no
+  protocol by driver.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreDisconnectController (
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  EFI_HANDLE  DriverImageHandle  OPTIONAL,
+  IN  EFI_HANDLE  ChildHandle        OPTIONAL
+  )
+{
+  ASSERT (FALSE);
+  return EFI_SUCCESS;
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Checks that the protocol index holds every protocol entry of the database
+  once, that it is at most half full, and that a lookup of each entry
+  through the index finds it.
+
+  @retval TRUE   The index is consistent.
+  @retval FALSE  The index is not consistent.
+
+**/
+STATIC
+BOOLEAN
+ProtocolIndexIsConsistent (
+  VOID
+  )
+{
+  LIST_ENTRY      *Link;
+  PROTOCOL_ENTRY  *ProtEntry;
+  UINTN           Entries;
+  UINTN           Slots;
+  UINTN           Slot;
+  BOOLEAN         Consistent;
+
+  if (!mProtocolIndexValid || ((mProtocolIndexSize & (mProtocolIndexSize - 1)) != 0)) {
+    return FALSE;
+  }
+
+  if (mProtocolIndexCount * 2 > mProtocolIndexSize) {
+    return FALSE;
+  }
+
+  Slots = 0;
+  for (Slot = 0; Slot < mProtocolIndexSize; Slot++) {
+    if (mProtocolIndex[Slot] != NULL) {
+      Slots++;
+    }
+  }
+
+  Consistent = TRUE;
+  Entries    = 0;
+  CoreAcquireProtocolLock ();
+  for (Link = mProtocolDatabase.ForwardLink; Link != &mProtocolDatabase; Link = Link->ForwardLink) {
+    ProtEntry = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    if (CoreFindProtocolEntry (&ProtEntry->ProtocolID, FALSE) != ProtEntry) {
+      Consistent = FALSE;
+    }
+
+    Entries++;
+  }
+
+  CoreReleaseProtocolLock ();
+
+  return Consistent && (Entries == mProtocolIndexCount) && (Slots == mProtocolIndexCount);
+}
+
+/**
+  Returns the number of interfaces of a protocol installed on all handles.
+
+  @param[in]  Guid  The protocol.
+
+  @return The number of interfaces, 0 if the protocol has no entry.
+
+**/
+STATIC
+UINTN
+CountProtocolInterfaces (
+  IN EFI_GUID  *Guid
+  )
+{
+  PROTOCOL_ENTRY  *ProtEntry;
+  LIST_ENTRY      *Link;
+  UINTN           Count;
+
+  Count = 0;
+  CoreAcquireProtocolLock ();
+  ProtEntry = CoreFindProtocolEntry (Guid, FALSE);
+  if (ProtEntry != NULL) {
+    for (Link = ProtEntry->Protocols.ForwardLink; Link != &ProtEntry->Protocols; Link = Link->ForwardLink) {
+      Count++;
+    }
+  }
+
+  CoreReleaseProtocolLock ();
+  return Count;
+}
+
+/**
+  Checks every protocol of the trace on a handle against the model.
+
+  @param[in]  HandleIndex  The handle in mHandles.
+
+  @retval TRUE   The handle carries the interfaces of the model.
+  @retval FALSE  The handle does not carry the interfaces of the model.
+
+**/
+STATIC
+BOOLEAN
+HandleMatchesModel (
+  IN UINTN  HandleIndex
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Interface;
+  UINTN       GuidIndex;
+
+  if (mHandles[HandleIndex] == NULL) {
+    for (GuidIndex = 0; GuidIndex < TEST_TRACE_GUIDS; GuidIndex++) {
+      if (mInstalled[HandleIndex][GuidIndex] != NULL) {
+        return FALSE;
+      }
+    }
+
+    return TRUE;
+  }
+
+  for (GuidIndex = 0; GuidIndex < TEST_TRACE_GUIDS; GuidIndex++) {
+    Interface = NULL;
+    Status    = CoreHandleProtocol (mHandles[HandleIndex], &mGuids[GuidIndex], &Interface);
+    if (mInstalled[HandleIndex][GuidIndex] == NULL) {
+      if (Status != EFI_UNSUPPORTED) {
+        return FALSE;
+      }
+    } else if (EFI_ERROR (Status) || (Interface != mInstalled[HandleIndex][GuidIndex])) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Uninstalls every interface of the model, which frees its handles.
+
+  @retval TRUE   Every interface was uninstalled.
+  @retval FALSE  An uninstall failed.
+
+**/
+STATIC
+BOOLEAN
+UninstallAll (
+  VOID
+  )
+{
+  UINTN  HandleIndex;
+  UINTN  GuidIndex;
+
+  for (HandleIndex = 0; HandleIndex < TEST_HANDLE_COUNT; HandleIndex++) {
+    for (GuidIndex = 0; GuidIndex < TEST_TRACE_GUIDS; GuidIndex++) {
+      if (mInstalled[HandleIndex][GuidIndex] == NULL) {
+        continue;
+      }
+
+      if (EFI_ERROR (CoreUninstallProtocolInterface (mHandles[HandleIndex], &mGuids[GuidIndex], mInstalled[HandleIndex][GuidIndex]))) {
+        return FALSE;
+      }
+
+      mInstalled[HandleIndex][GuidIndex] = NULL;
+    }
+
+    mHandles[HandleIndex] = NULL;
+  }
+
+  return IsListEmpty (&gHandleList);
+}
+
+/**
+  Resets the model and the random sequence. The protocol entries stay in
+  the database, as the DXE Core never removes them.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED  The setup succeeded.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+HandleSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mSeed = 0x5eed;
+  ZeroMem (mHandles, sizeof (mHandles));
+  ZeroMem (mInstalled, sizeof (mInstalled));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Uninstalls what the test left installed.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+HandleCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UninstallAll ();
+}
+
+/// === TEST CASES ===
+
+/**
+  Every protocol installed should be found through the index while it grows,
+  and the index should stay at most half full.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+IndexShouldFindProtocolsWhileGrowing (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_HANDLE  Handle;
+  VOID        *Interface;
+  UINTN       Index;
+  UINTN       Checked;
+  UINTN       Rehashes;
+  UINTN       Size;
+  UINT64      Lookups;
+  UINT64      Hits;
+
+  Handle   = NULL;
+  Rehashes = 0;
+  Size     = mProtocolIndexSize;
+  for (Index = 0; Index < TEST_GUID_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreInstallProtocolInterface (&Handle, &mGuids[Index], EFI_NATIVE_INTERFACE, &mInterfaces[Index]));
+    if (mProtocolIndexSize != Size) {
+      Rehashes++;
+      Size = mProtocolIndexSize;
+    }
+
+    if ((Index % TEST_CHECK_PERIOD) == 0) {
+      UT_ASSERT_TRUE (ProtocolIndexIsConsistent ());
+      for (Checked = 0; Checked <= Index; Checked++) {
+        UT_ASSERT_NOT_EFI_ERROR (CoreHandleProtocol (Handle, &mGuids[Checked], &Interface));
+        UT_ASSERT_TRUE (Interface == &mInterfaces[Checked]);
+      }
+    }
+  }
+
+  UT_ASSERT_TRUE (ProtocolIndexIsConsistent ());
+  UT_ASSERT_TRUE (Rehashes >= 3);
+
+  //
+  // Every lookup of an installed protocol is a hit of the index
+  //
+  Lookups = mProtocolIndexStatistics.Lookups;
+  Hits    = mProtocolIndexStatistics.Hits;
+  for (Index = 0; Index < TEST_GUID_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreHandleProtocol (Handle, &mGuids[Index], &Interface));
+    UT_ASSERT_TRUE (Interface == &mInterfaces[Index]);
+  }
+
+  UT_ASSERT_EQUAL (mProtocolIndexStatistics.Lookups - Lookups, TEST_GUID_COUNT);
+  UT_ASSERT_EQUAL (mProtocolIndexStatistics.Hits - Hits, TEST_GUID_COUNT);
+  UT_ASSERT_TRUE (mProtocolIndexStatistics.MaxDepth <= mProtocolIndexCount);
+
+  UT_LOG_INFO (
+    "%d entries in %d slots, %d rehashes, max depth %d\n",
+    (INT32)mProtocolIndexCount,
+    (INT32)mProtocolIndexSize,
+    (INT32)Rehashes,
+    (INT32)mProtocolIndexStatistics.MaxDepth
+    );
+
+  for (Index = 0; Index < TEST_GUID_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreUninstallProtocolInterface (Handle, &mGuids[Index], &mInterfaces[Index]));
+  }
+
+  UT_ASSERT_TRUE (IsListEmpty (&gHandleList));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A protocol that was never installed should not be found, and looking it up
+  should not add it to the database.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+MissingProtocolShouldNotBeFound (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_GUID  Missing;
+  VOID      *Interface;
+  UINTN     Count;
+  UINTN     Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (CoreInstallProtocolInterface (&mHandles[0], &mGuids[0], EFI_NATIVE_INTERFACE, &mInterfaces[0]));
+  mInstalled[0][0] = &mInterfaces[0];
+
+  Count = mProtocolIndexCount;
+  for (Index = 0; Index < TEST_MISSING_GUIDS; Index++) {
+    CopyGuid (&Missing, &mGuids[Index]);
+    Missing.Data4[7] ^= 0xFF;
+    UT_ASSERT_STATUS_EQUAL (CoreHandleProtocol (mHandles[0], &Missing, &Interface), EFI_UNSUPPORTED);
+    UT_ASSERT_EQUAL (CountProtocolInterfaces (&Missing), 0);
+  }
+
+  UT_ASSERT_EQUAL (mProtocolIndexCount, Count);
+  UT_ASSERT_TRUE (ProtocolIndexIsConsistent ());
+
+  //
+  // Installing the same interface twice on a handle is refused
+  //
+  UT_ASSERT_STATUS_EQUAL (
+    CoreInstallProtocolInterface (&mHandles[0], &mGuids[0], EFI_NATIVE_INTERFACE, &mInterfaces[0]),
+    EFI_INVALID_PARAMETER
+    );
+  UT_ASSERT_TRUE (HandleMatchesModel (0));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Interfaces installed and uninstalled at random on a set of handles should
+  be found where the model expects them. Uninstalling the last interface of
+  a handle frees it, while the protocol entries stay in the index.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RandomInstallUninstallShouldMatchModel (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Step;
+  UINTN  HandleIndex;
+  UINTN  GuidIndex;
+  UINTN  Index;
+  UINTN  Installed;
+  UINTN  Installs;
+  UINTN  Uninstalls;
+  UINTN  Count;
+
+  Installs   = 0;
+  Uninstalls = 0;
+  Count      = mProtocolIndexCount;
+  for (Step = 0; Step < TEST_TRACE_STEPS; Step++) {
+    HandleIndex = GetRandom () % TEST_HANDLE_COUNT;
+    GuidIndex   = GetRandom () % TEST_TRACE_GUIDS;
+    if (mInstalled[HandleIndex][GuidIndex] == NULL) {
+      UT_ASSERT_NOT_EFI_ERROR (
+        CoreInstallProtocolInterface (&mHandles[HandleIndex], &mGuids[GuidIndex], EFI_NATIVE_INTERFACE, &mInterfaces[GuidIndex])
+        );
+      mInstalled[HandleIndex][GuidIndex] = &mInterfaces[GuidIndex];
+      Installs++;
+    } else {
+      UT_ASSERT_NOT_EFI_ERROR (
+        CoreUninstallProtocolInterface (mHandles[HandleIndex], &mGuids[GuidIndex], mInstalled[HandleIndex][GuidIndex])
+        );
+      mInstalled[HandleIndex][GuidIndex] = NULL;
+      Uninstalls++;
+
+      Installed = 0;
+      for (Index = 0; Index < TEST_TRACE_GUIDS; Index++) {
+        if (mInstalled[HandleIndex][Index] != NULL) {
+          Installed++;
+        }
+      }
+
+      if (Installed == 0) {
+        mHandles[HandleIndex] = NULL;
+      }
+    }
+
+    UT_ASSERT_TRUE (HandleMatchesModel (HandleIndex));
+
+    Installed = 0;
+    for (Index = 0; Index < TEST_HANDLE_COUNT; Index++) {
+      if (mInstalled[Index][GuidIndex] != NULL) {
+        Installed++;
+      }
+    }
+
+    UT_ASSERT_EQUAL (CountProtocolInterfaces (&mGuids[GuidIndex]), Installed);
+  }
+
+  for (HandleIndex = 0; HandleIndex < TEST_HANDLE_COUNT; HandleIndex++) {
+    UT_ASSERT_TRUE (HandleMatchesModel (HandleIndex));
+  }
+
+  //
+  // The protocols of the trace were all installed by the earlier tests
+  //
+  UT_ASSERT_EQUAL (mProtocolIndexCount, Count);
+  UT_ASSERT_TRUE (ProtocolIndexIsConsistent ());
+
+  UT_LOG_INFO ("%d installs, %d uninstalls\n", (INT32)Installs, (INT32)Uninstalls);
+
+  UT_ASSERT_TRUE (UninstallAll ());
+  for (GuidIndex = 0; GuidIndex < TEST_TRACE_GUIDS; GuidIndex++) {
+    UT_ASSERT_EQUAL (CountProtocolInterfaces (&mGuids[GuidIndex]), 0);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  protocol database of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      HandleTests;
+  UINTN                       Index;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // The protocols are random GUIDs, like the ones of real protocols
+  //
+  mSeed = 0x5eed;
+  for (Index = 0; Index < TEST_GUID_COUNT; Index++) {
+    mGuids[Index].Data1 = GetRandom () ^ (GetRandom () << 16);
+    mGuids[Index].Data2 = (UINT16)GetRandom ();
+    mGuids[Index].Data3 = (UINT16)GetRandom ();
+    WriteUnaligned32 ((UINT32 *)&mGuids[Index].Data4[0], GetRandom () ^ (GetRandom () << 16));
+    WriteUnaligned32 ((UINT32 *)&mGuids[Index].Data4[4], GetRandom () ^ (GetRandom () << 16));
+  }
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core Protocol Database Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&HandleTests, Framework, "DXE Core Protocol Index Tests", "DxeCore.Handle.Index", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Protocol Index Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite----------Description----------------------------------------------Name-------Function-----------------------------------Pre----------Post-----------Context-----------
+  //
+  AddTestCase (HandleTests, "Find every protocol while the index grows", "Rehash", IndexShouldFindProtocolsWhileGrowing, HandleSetup, HandleCleanup, NULL);
+  AddTestCase (HandleTests, "A protocol never installed is not found", "Missing", MissingProtocolShouldNotBeFound, HandleSetup, HandleCleanup, NULL);
+  AddTestCase (HandleTests, "Random installs and uninstalls match the model", "Stress", RandomInstallUninstallShouldMatchModel, HandleSetup, HandleCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCoreHandleUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCoreHandleUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
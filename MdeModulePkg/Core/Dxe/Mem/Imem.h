@@ -30,17 +30,28 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 
 #define MEMORY_MAP_SIGNATURE  SIGNATURE_32('m','m','a','p')
-typedef struct {
-  UINTN              Signature;
-  LIST_ENTRY         Link;
-  BOOLEAN            FromPages;
-
-  EFI_MEMORY_TYPE    Type;
-  UINT64             Start;
-  UINT64             End;
-
-  UINT64             VirtualStart;
-  UINT64             Attribute;
+typedef struct _MEMORY_MAP {
+  UINTN                 Signature;
+  LIST_ENTRY            Link;
+  BOOLEAN               FromPages;
+
+  EFI_MEMORY_TYPE       Type;
+  UINT64                Start;
+  UINT64                End;
+
+  UINT64                VirtualStart;
+  UINT64                Attribute;
+
+  //
+  // Node of the free memory tree if Type is EfiConventionalMemory. The tree
+  // is an AVL tree ordered by Start. FreeMaxSize is the size of the largest
+  // entry of the subtree, and FreeHeight is the height of the subtree, or 0
+  // if the entry is not in the tree.
+  //
+  struct _MEMORY_MAP    *FreeLeft;
+  struct _MEMORY_MAP    *FreeRight;
+  UINT64                FreeMaxSize;
+  UINTN                 FreeHeight;
 } MEMORY_MAP;
 
 //
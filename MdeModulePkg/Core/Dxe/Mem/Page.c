@@ -45,6 +45,13 @@ UINTN       mFreeMapStack = 0;
 ///
 LIST_ENTRY  mFreeMemoryMapEntryList           = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMemoryMapEntryList);
 BOOLEAN     mMemoryTypeInformationInitialized = FALSE;
+///
+/// mFreeMemoryTree - The root of the tree of the EfiConventionalMemory entries
+/// of gMemoryMap, so that free page searches do not have to walk the
+/// allocated entries. The tree nodes are embedded in the entries, so that
+/// updating the tree never allocates memory.
+///
+MEMORY_MAP  *mFreeMemoryTree = NULL;
 
 EFI_MEMORY_TYPE_STATISTICS  mMemoryTypeStatistics[EfiMaxMemoryType + 1] = {
   { 0, MAX_ALLOC_ADDRESS, 0, 0, EfiMaxMemoryType, TRUE,  FALSE },  // EfiReservedMemoryType
@@ -119,6 +126,344 @@ CoreReleaseMemoryLock (
   CoreReleaseLock (&gMemoryLock);
 }
 
+/**
+  Internal function.  Returns the height of a free memory subtree.
+
+  @param  Node                   The root of the subtree, or NULL
+
+  @return The height of the subtree, 0 if it is empty
+
+**/
+STATIC
+UINTN
+FreeMemoryTreeHeight (
+  IN MEMORY_MAP  *Node
+  )
+{
+  return (Node == NULL) ? 0 : Node->FreeHeight;
+}
+
+/**
+  Internal function.  Returns the size of the largest entry of a free
+  memory subtree.
+
+  @param  Node                   The root of the subtree, or NULL
+
+  @return The size in bytes of the largest entry, 0 if the subtree is empty
+
+**/
+STATIC
+UINT64
+FreeMemoryTreeMaxSize (
+  IN MEMORY_MAP  *Node
+  )
+{
+  return (Node == NULL) ? 0 : Node->FreeMaxSize;
+}
+
+/**
+  Internal function.  Recomputes the height and the largest entry size of a
+  free memory subtree from the ones of its children.
+
+  @param  Node                   The root of the subtree
+
+**/
+STATIC
+VOID
+FreeMemoryTreeUpdate (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  Node->FreeHeight  = 1 + MAX (FreeMemoryTreeHeight (Node->FreeLeft), FreeMemoryTreeHeight (Node->FreeRight));
+  Node->FreeMaxSize = MAX (Node->End - Node->Start + 1, MAX (FreeMemoryTreeMaxSize (Node->FreeLeft), FreeMemoryTreeMaxSize (Node->FreeRight)));
+}
+
+/**
+  Internal function.  Rotates a free memory subtree to the right, so that
+  its left child becomes its root.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+FreeMemoryTreeRotateRight (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  MEMORY_MAP  *Child;
+
+  Child            = Node->FreeLeft;
+  Node->FreeLeft   = Child->FreeRight;
+  Child->FreeRight = Node;
+  FreeMemoryTreeUpdate (Node);
+  FreeMemoryTreeUpdate (Child);
+  return Child;
+}
+
+/**
+  Internal function.  Rotates a free memory subtree to the left, so that
+  its right child becomes its root.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+FreeMemoryTreeRotateLeft (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  MEMORY_MAP  *Child;
+
+  Child           = Node->FreeRight;
+  Node->FreeRight = Child->FreeLeft;
+  Child->FreeLeft = Node;
+  FreeMemoryTreeUpdate (Node);
+  FreeMemoryTreeUpdate (Child);
+  return Child;
+}
+
+/**
+  Internal function.  Restores the AVL balance of a free memory subtree
+  whose children are balanced and differ in height by 2 at most.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+FreeMemoryTreeBalance (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  INTN  Balance;
+
+  Balance = (INTN)FreeMemoryTreeHeight (Node->FreeLeft) - (INTN)FreeMemoryTreeHeight (Node->FreeRight);
+
+  if (Balance > 1) {
+    if (FreeMemoryTreeHeight (Node->FreeLeft->FreeLeft) < FreeMemoryTreeHeight (Node->FreeLeft->FreeRight)) {
+      Node->FreeLeft = FreeMemoryTreeRotateLeft (Node->FreeLeft);
+    }
+
+    return FreeMemoryTreeRotateRight (Node);
+  }
+
+  if (Balance < -1) {
+    if (FreeMemoryTreeHeight (Node->FreeRight->FreeRight) < FreeMemoryTreeHeight (Node->FreeRight->FreeLeft)) {
+      Node->FreeRight = FreeMemoryTreeRotateRight (Node->FreeRight);
+    }
+
+    return FreeMemoryTreeRotateLeft (Node);
+  }
+
+  FreeMemoryTreeUpdate (Node);
+  return Node;
+}
+
+/**
+  Internal function.  Inserts an entry into a free memory subtree.
+
+  @param  Node                   The root of the subtree, or NULL
+  @param  Entry                  The entry to insert
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+FreeMemoryTreeInsert (
+  IN OUT MEMORY_MAP  *Node,
+  IN OUT MEMORY_MAP  *Entry
+  )
+{
+  if (Node == NULL) {
+    return Entry;
+  }
+
+  ASSERT (Entry->Start != Node->Start);
+  if (Entry->Start < Node->Start) {
+    Node->FreeLeft = FreeMemoryTreeInsert (Node->FreeLeft, Entry);
+  } else {
+    Node->FreeRight = FreeMemoryTreeInsert (Node->FreeRight, Entry);
+  }
+
+  return FreeMemoryTreeBalance (Node);
+}
+
+/**
+  Internal function.  Detaches the entry with the lowest Start from a free
+  memory subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Lowest                 Returns the entry detached
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+FreeMemoryTreeRemoveLowest (
+  IN OUT MEMORY_MAP  *Node,
+  OUT MEMORY_MAP     **Lowest
+  )
+{
+  if (Node->FreeLeft == NULL) {
+    *Lowest = Node;
+    return Node->FreeRight;
+  }
+
+  Node->FreeLeft = FreeMemoryTreeRemoveLowest (Node->FreeLeft, Lowest);
+  return FreeMemoryTreeBalance (Node);
+}
+
+/**
+  Internal function.  Removes an entry from a free memory subtree.
+
+  @param  Node                   The root of the subtree
+  @param  Entry                  The entry to remove
+
+  @return The new root of the subtree
+
+**/
+STATIC
+MEMORY_MAP *
+FreeMemoryTreeRemove (
+  IN OUT MEMORY_MAP  *Node,
+  IN OUT MEMORY_MAP  *Entry
+  )
+{
+  MEMORY_MAP  *Successor;
+  MEMORY_MAP  *Right;
+
+  ASSERT (Node != NULL);
+
+  if (Entry->Start < Node->Start) {
+    Node->FreeLeft = FreeMemoryTreeRemove (Node->FreeLeft, Entry);
+    return FreeMemoryTreeBalance (Node);
+  }
+
+  if (Entry->Start > Node->Start) {
+    Node->FreeRight = FreeMemoryTreeRemove (Node->FreeRight, Entry);
+    return FreeMemoryTreeBalance (Node);
+  }
+
+  ASSERT (Node == Entry);
+  if (Node->FreeRight == NULL) {
+    return Node->FreeLeft;
+  }
+
+  //
+  // Put the next entry in the place of the one removed
+  //
+  Right                = FreeMemoryTreeRemoveLowest (Node->FreeRight, &Successor);
+  Successor->FreeRight = Right;
+  Successor->FreeLeft  = Node->FreeLeft;
+  return FreeMemoryTreeBalance (Successor);
+}
+
+/**
+  Internal function.  Inserts a free entry into the free memory tree.
+
+  @param  Entry                  The entry to insert
+
+**/
+STATIC
+VOID
+InsertFreeMemoryEntry (
+  IN OUT MEMORY_MAP  *Entry
+  )
+{
+  ASSERT (Entry->Type == EfiConventionalMemory);
+  ASSERT (Entry->Start <= Entry->End);
+
+  Entry->FreeLeft    = NULL;
+  Entry->FreeRight   = NULL;
+  Entry->FreeHeight  = 1;
+  Entry->FreeMaxSize = Entry->End - Entry->Start + 1;
+  mFreeMemoryTree    = FreeMemoryTreeInsert (mFreeMemoryTree, Entry);
+}
+
+/**
+  Internal function.  Removes a free entry from the free memory tree. The
+  Start of the entry must not have changed since it was inserted.
+
+  @param  Entry                  The entry to remove
+
+**/
+STATIC
+VOID
+RemoveFreeMemoryEntry (
+  IN OUT MEMORY_MAP  *Entry
+  )
+{
+  ASSERT (Entry->FreeHeight != 0);
+
+  mFreeMemoryTree   = FreeMemoryTreeRemove (mFreeMemoryTree, Entry);
+  Entry->FreeHeight = 0;
+}
+
+/**
+  Internal function.  Finds the free entry that covers an address.
+
+  @param  Address                The address to look up
+
+  @return The free entry covering Address, or NULL if Address is not free
+
+**/
+STATIC
+MEMORY_MAP *
+FindFreeMemoryEntry (
+  IN UINT64  Address
+  )
+{
+  MEMORY_MAP  *Node;
+
+  Node = mFreeMemoryTree;
+  while (Node != NULL) {
+    if (Address < Node->Start) {
+      Node = Node->FreeLeft;
+    } else if (Address > Node->End) {
+      Node = Node->FreeRight;
+    } else {
+      break;
+    }
+  }
+
+  return Node;
+}
+
+/**
+  Internal function.  Inserts a descriptor entry into the memory map, and
+  into the free memory tree if it describes free memory.
+
+  @param  ListEntry              The gMemoryMap entry to insert the descriptor
+                                 in front of
+  @param  Entry                  The entry to insert
+
+**/
+STATIC
+VOID
+InsertMemoryMapEntry (
+  IN LIST_ENTRY      *ListEntry,
+  IN OUT MEMORY_MAP  *Entry
+  )
+{
+  InsertTailList (ListEntry, &Entry->Link);
+
+  if (Entry->Type == EfiConventionalMemory) {
+    InsertFreeMemoryEntry (Entry);
+  } else {
+    Entry->FreeHeight = 0;
+  }
+}
+
 /**
   Internal function.  Removes a descriptor entry.
 
@@ -133,6 +478,10 @@ RemoveMemoryMapEntry (
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
 
+  if (Entry->FreeHeight != 0) {
+    RemoveFreeMemoryEntry (Entry);
+  }
+
   if (Entry->FromPages) {
     //
     // Insert the free memory map descriptor to the end of mFreeMemoryMapEntryList
@@ -207,28 +556,49 @@ CoreAddRange (
   //
 
   // Two memory descriptors can only be merged if they have the same Type
-  // and the same Attribute
+  // and the same Attribute, so free memory only needs to be checked against
+  // the free entries right before and after it
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
+  if (Type == EfiConventionalMemory) {
+    if (Start != 0) {
+      Entry = FindFreeMemoryEntry (Start - 1);
+      if ((Entry != NULL) && (Entry->Attribute == Attribute)) {
+        ASSERT (Entry->End + 1 == Start);
+        Start = Entry->Start;
+        RemoveMemoryMapEntry (Entry);
+      }
     }
 
-    if (Entry->Attribute != Attribute) {
-      continue;
+    if (End != MAX_UINT64) {
+      Entry = FindFreeMemoryEntry (End + 1);
+      if ((Entry != NULL) && (Entry->Attribute == Attribute)) {
+        ASSERT (Entry->Start == End + 1);
+        End = Entry->End;
+        RemoveMemoryMapEntry (Entry);
+      }
     }
+  } else {
+    Link = gMemoryMap.ForwardLink;
+    while (Link != &gMemoryMap) {
+      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+      Link  = Link->ForwardLink;
 
-    if (Entry->End + 1 == Start) {
-      Start = Entry->Start;
-      RemoveMemoryMapEntry (Entry);
-    } else if (Entry->Start == End + 1) {
-      End = Entry->End;
-      RemoveMemoryMapEntry (Entry);
+      if (Entry->Type != Type) {
+        continue;
+      }
+
+      if (Entry->Attribute != Attribute) {
+        continue;
+      }
+
+      if (Entry->End + 1 == Start) {
+        Start = Entry->Start;
+        RemoveMemoryMapEntry (Entry);
+      } else if (Entry->Start == End + 1) {
+        End = Entry->End;
+        RemoveMemoryMapEntry (Entry);
+      }
     }
   }
 
@@ -243,7 +613,7 @@ CoreAddRange (
   mMapStack[mMapDepth].End          = End;
   mMapStack[mMapDepth].VirtualStart = 0;
   mMapStack[mMapDepth].Attribute    = Attribute;
-  InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  InsertMemoryMapEntry (&gMemoryMap, &mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -350,8 +720,7 @@ CoreFreeMemoryMapStack (
       //
       // Move this entry to general memory
       //
-      RemoveEntryList (&mMapStack[mMapDepth].Link);
-      mMapStack[mMapDepth].Link.ForwardLink = NULL;
+      RemoveMemoryMapEntry (&mMapStack[mMapDepth]);
 
       CopyMem (Entry, &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
       Entry->FromPages = TRUE;
@@ -366,7 +735,7 @@ CoreFreeMemoryMapStack (
         }
       }
 
-      InsertTailList (Link2, &Entry->Link);
+      InsertMemoryMapEntry (Link2, Entry);
     } else {
       //
       // This item of mMapStack[mMapDepth] has already been dequeued from gMemoryMap list,
@@ -743,6 +1112,8 @@ CoreConvertPagesEx (
   EFI_MEMORY_TYPE  MemType;
   LIST_ENTRY       *Link;
   MEMORY_MAP       *Entry;
+  MEMORY_MAP       *FreeEntry;
+  BOOLEAN          Found;
 
   Entry         = NULL;
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
@@ -764,17 +1135,27 @@ CoreConvertPagesEx (
 
   while (Start < End) {
     //
-    // Find the entry that the covers the range
+    // Find the entry that the covers the range. Pages being allocated
+    // must be free, so only the free entries need to be searched then.
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    Found = FALSE;
+    if (ChangingType && (NewType != EfiConventionalMemory)) {
+      Entry = FindFreeMemoryEntry (Start);
+      Found = (BOOLEAN)((Entry != NULL) && (Entry->End > Start));
+    }
+
+    if (!Found) {
+      for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+        Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
 
-      if ((Entry->Start <= Start) && (Entry->End > Start)) {
-        break;
+        if ((Entry->Start <= Start) && (Entry->End > Start)) {
+          Found = TRUE;
+          break;
+        }
       }
     }
 
-    if (Link == &gMemoryMap) {
+    if (!Found) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -853,8 +1234,15 @@ CoreConvertPagesEx (
     }
 
     //
-    // Pull range out of descriptor
+    // Pull range out of descriptor. A free entry leaves the free memory tree
+    // while its range changes.
     //
+    FreeEntry = NULL;
+    if (Entry->FreeHeight != 0) {
+      FreeEntry = Entry;
+      RemoveFreeMemoryEntry (FreeEntry);
+    }
+
     if (Entry->Start == Start) {
       //
       // Clip start
@@ -888,12 +1276,16 @@ CoreConvertPagesEx (
       ASSERT (Entry->Start < Entry->End);
 
       Entry = &mMapStack[mMapDepth];
-      InsertTailList (&gMemoryMap, &Entry->Link);
+      InsertMemoryMapEntry (&gMemoryMap, Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
     }
 
+    if ((FreeEntry != NULL) && (FreeEntry->Start != FreeEntry->End + 1)) {
+      InsertFreeMemoryEntry (FreeEntry);
+    }
+
     //
     // The new range inherits the same Attribute as the Entry
     // it is being cut out of unless attributes are being changed
@@ -1010,6 +1402,103 @@ CoreUpdateMemoryAttributes (
   CoreReleaseMemoryLock ();
 }
 
+/**
+  Internal function. Finds the highest free range of a free memory subtree
+  that can hold a page allocation. The subtrees whose entries are all too
+  small, or all outside of MinAddress..MaxAddress, are skipped.
+
+  @param  Node                   The root of the subtree, or NULL
+  @param  MaxAddress             The last address the range may use, the end
+                                 of a page
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+  @param  NeedGuard              Flag to indicate Guard page is needed or not
+
+  @return The last address of the range, or 0 if the range was not found
+
+**/
+STATIC
+UINT64
+FreeMemoryTreeFindTopDown (
+  IN MEMORY_MAP  *Node,
+  IN UINT64      MaxAddress,
+  IN UINT64      MinAddress,
+  IN UINT64      NumberOfBytes,
+  IN UINTN       Alignment,
+  IN BOOLEAN     NeedGuard
+  )
+{
+  UINT64  Target;
+  UINT64  DescStart;
+  UINT64  DescEnd;
+  UINT64  DescNumberOfBytes;
+
+  if ((Node == NULL) || (Node->FreeMaxSize < NumberOfBytes)) {
+    return 0;
+  }
+
+  //
+  // The entries on the right start above this one, so they are only
+  // candidates if this one starts below MaxAddress
+  //
+  if (Node->Start < MaxAddress) {
+    Target = FreeMemoryTreeFindTopDown (Node->FreeRight, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+    if (Target != 0) {
+      return Target;
+    }
+  }
+
+  DescStart = Node->Start;
+  DescEnd   = Node->End;
+
+  //
+  // If desc is past max allowed address or below min allowed address, skip it
+  //
+  if ((DescStart < MaxAddress) && (DescEnd >= MinAddress)) {
+    //
+    // If desc ends past max allowed address, clip the end
+    //
+    if (DescEnd >= MaxAddress) {
+      DescEnd = MaxAddress;
+    }
+
+    DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
+
+    //
+    // Compute the number of bytes we can used from this descriptor, and see
+    // it's enough to satisfy the request. The start of the allocated range
+    // must not be below the min address allowed.
+    //
+    if (DescEnd >= DescStart) {
+      DescNumberOfBytes = DescEnd - DescStart + 1;
+      if ((DescNumberOfBytes >= NumberOfBytes) && ((DescEnd - NumberOfBytes + 1) >= MinAddress)) {
+        if (NeedGuard) {
+          DescEnd = AdjustMemoryS (
+                      DescEnd + 1 - DescNumberOfBytes,
+                      DescNumberOfBytes,
+                      NumberOfBytes
+                      );
+        }
+
+        if (DescEnd != 0) {
+          return DescEnd;
+        }
+      }
+    }
+  }
+
+  //
+  // The entries on the left end below this one, so they are only candidates
+  // if this one starts above MinAddress
+  //
+  if (Node->Start > MinAddress) {
+    return FreeMemoryTreeFindTopDown (Node->FreeLeft, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+  }
+
+  return 0;
+}
+
 /**
   Internal function. Finds a consecutive free page range below
   the requested address.
@@ -1035,13 +1524,8 @@ CoreFindFreePagesI (
   IN BOOLEAN          NeedGuard
   )
 {
-  UINT64      NumberOfBytes;
-  UINT64      Target;
-  UINT64      DescStart;
-  UINT64      DescEnd;
-  UINT64      DescNumberOfBytes;
-  LIST_ENTRY  *Link;
-  MEMORY_MAP  *Entry;
+  UINT64  NumberOfBytes;
+  UINT64  Target;
 
   if ((MaxAddress < EFI_PAGE_MASK) || (NumberOfPages == 0)) {
     return 0;
@@ -1069,75 +1553,11 @@ CoreFindFreePagesI (
   }
 
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
-  Target        = 0;
-
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd   = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
-
-    // Skip if DescEnd is less than DescStart after alignment clipping
-    if (DescEnd < DescStart) {
-      continue;
-    }
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
 
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        if (NeedGuard) {
-          DescEnd = AdjustMemoryS (
-                      DescEnd + 1 - DescNumberOfBytes,
-                      DescNumberOfBytes,
-                      NumberOfBytes
-                      );
-          if (DescEnd == 0) {
-            continue;
-          }
-        }
-
-        Target = DescEnd;
-      }
-    }
-  }
+  //
+  // Only the free entries are candidates, and the highest range found wins
+  //
+  Target = FreeMemoryTreeFindTopDown (mFreeMemoryTree, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
 
   //
   // If this is a grow down, adjust target to be the allocation base
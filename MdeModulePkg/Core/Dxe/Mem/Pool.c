@@ -21,6 +21,7 @@ typedef struct {
 
 #define POOL_HEAD_SIGNATURE      SIGNATURE_32('p','h','d','0')
 #define POOLPAGE_HEAD_SIGNATURE  SIGNATURE_32('p','h','d','1')
+#define POOLSLAB_HEAD_SIGNATURE  SIGNATURE_32('p','h','d','2')
 typedef struct {
   UINT32             Signature;
   UINT32             Reserved;
@@ -59,6 +60,43 @@ STATIC CONST UINT16  mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE  (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Maps the index of the highest bit set in a request size to the first
+// pool list whose block size is not smaller than that power of 2. Since
+// the pool sizes grow by a factor of ~1.6, at most two lists share a power
+// of 2, so the size-to-list lookup never needs more than a couple of compares.
+//
+#define POOL_SIZE_BITS  16
+
+STATIC UINT8  mPoolIndexFromHighBit[POOL_SIZE_BITS];
+
+//
+// Small blocks are served from slabs: pages split into slots of a single
+// size, with a bitmap of the free slots in the page header. The slot sizes
+// include the pool overhead, and go in steps of 2^n and 1.5 * 2^n so that
+// the slab of a size is found from the two highest bits of the size.
+//
+#define POOL_SLAB_SIGNATURE  SIGNATURE_32('p','s','l','b')
+#define SLAB_MAP_WORDS       2
+typedef struct {
+  UINT32        Signature;
+  UINT16        Index;
+  UINT16        FreeCount;
+  LIST_ENTRY    Link;
+  UINT64        FreeMap[SLAB_MAP_WORDS];
+} POOL_SLAB;
+
+#define SLAB_HEAD_SIZE  ALIGN_VARIABLE (sizeof (POOL_SLAB))
+
+STATIC CONST UINT16  mPoolSlabSizeTable[] = {
+  48, 64, 96, 128, 192, 256, 384, 512
+};
+
+#define MAX_SLAB_LIST  (ARRAY_SIZE (mPoolSlabSizeTable))
+#define MAX_SLAB_SIZE  (mPoolSlabSizeTable[MAX_SLAB_LIST - 1])
+
+#define SLAB_SLOT_COUNT(a)  ((EFI_PAGE_SIZE - SLAB_HEAD_SIZE) / mPoolSlabSizeTable[a])
+
 //
 // Globals
 //
@@ -68,7 +106,9 @@ typedef struct {
   INTN               Signature;
   UINTN              Used;
   EFI_MEMORY_TYPE    MemoryType;
+  UINT32             FreeListBitmap;
   LIST_ENTRY         FreeList[MAX_POOL_LIST];
+  LIST_ENTRY         SlabList[MAX_SLAB_LIST];
   LIST_ENTRY         Link;
 } POOL;
 
@@ -98,13 +138,177 @@ GetPoolIndexFromSize (
 {
   UINTN  Index;
 
-  for (Index = 0; Index < MAX_POOL_LIST; Index++) {
-    if (mPoolSizeTable[Index] >= Size) {
-      return Index;
+  if (Size > mPoolSizeTable[MAX_POOL_LIST - 1]) {
+    return MAX_POOL_LIST;
+  }
+
+  if (Size == 0) {
+    return 0;
+  }
+
+  Index = mPoolIndexFromHighBit[HighBitSet32 ((UINT32)Size)];
+  while (mPoolSizeTable[Index] < Size) {
+    Index++;
+  }
+
+  ASSERT (Index < MAX_POOL_LIST);
+  return Index;
+}
+
+/**
+  Insert a block onto the free list of the specified pool size table index,
+  and mark that free list as not empty.
+
+  @param  Pool          The pool that owns the free list.
+  @param  Free          The free block.
+  @param  Index         The index of the free list.
+
+**/
+STATIC
+VOID
+InsertPoolFreeBlock (
+  IN POOL       *Pool,
+  IN POOL_FREE  *Free,
+  IN UINTN      Index
+  )
+{
+  Free->Signature = POOL_FREE_SIGNATURE;
+  Free->Index     = (UINT32)Index;
+  InsertHeadList (&Pool->FreeList[Index], &Free->Link);
+  Pool->FreeListBitmap |= (UINT32)BIT0 << Index;
+}
+
+/**
+  Remove a block from its free list, and mark that free list as empty if
+  no block is left on it.
+
+  @param  Pool          The pool that owns the free list.
+  @param  Free          The free block.
+
+**/
+STATIC
+VOID
+RemovePoolFreeBlock (
+  IN POOL       *Pool,
+  IN POOL_FREE  *Free
+  )
+{
+  RemoveEntryList (&Free->Link);
+  if (IsListEmpty (&Pool->FreeList[Free->Index])) {
+    Pool->FreeListBitmap &= ~((UINT32)BIT0 << Free->Index);
+  }
+}
+
+/**
+  Get the index of the slab serving blocks of the specified size.
+
+  @param  Size          The size of the block, including the pool overhead.
+
+  @return               The index of the slab size table, or MAX_SLAB_LIST if
+                        the size is too large for a slab.
+
+**/
+STATIC
+UINTN
+GetSlabIndexFromSize (
+  IN UINTN  Size
+  )
+{
+  INTN  Bit;
+
+  if (Size > MAX_SLAB_SIZE) {
+    return MAX_SLAB_LIST;
+  }
+
+  if (Size <= mPoolSlabSizeTable[0]) {
+    return 0;
+  }
+
+  //
+  // Sizes in (2^n, 1.5 * 2^n] go to the slab of 1.5 * 2^n, and sizes in
+  // (1.5 * 2^n, 2^(n+1)] go to the slab of 2^(n+1). The table starts
+  // with 1.5 * 2^5.
+  //
+  Bit = HighBitSet32 ((UINT32)(Size - 1));
+  return (UINTN)(Bit - 5) * 2 + (((Size - 1) >> (Bit - 1)) & 1);
+}
+
+/**
+  Set up a new slab page and put it onto the slab list of its size.
+
+  @param  Pool          The pool that owns the slab.
+  @param  Slab          The page of the slab.
+  @param  Index         The index of the slab size table.
+
+**/
+STATIC
+VOID
+InitializePoolSlab (
+  IN POOL       *Pool,
+  IN POOL_SLAB  *Slab,
+  IN UINTN      Index
+  )
+{
+  UINTN  Count;
+  UINTN  Word;
+
+  Count = SLAB_SLOT_COUNT (Index);
+  ASSERT (Count <= SLAB_MAP_WORDS * 64);
+
+  Slab->Signature = POOL_SLAB_SIGNATURE;
+  Slab->Index     = (UINT16)Index;
+  Slab->FreeCount = (UINT16)Count;
+  for (Word = 0; Word < SLAB_MAP_WORDS; Word++) {
+    if (Count >= 64) {
+      Slab->FreeMap[Word] = MAX_UINT64;
+      Count              -= 64;
+    } else {
+      Slab->FreeMap[Word] = LShiftU64 (1, Count) - 1;
+      Count               = 0;
     }
   }
 
-  return MAX_POOL_LIST;
+  InsertHeadList (&Pool->SlabList[Index], &Slab->Link);
+}
+
+/**
+  Take a free slot from the first slab on the slab list of the specified size.
+  The slab is removed from the list once its last slot is taken.
+
+  @param  Pool          The pool that owns the slab.
+  @param  Index         The index of the slab size table.
+
+  @return               The slot.
+
+**/
+STATIC
+POOL_HEAD *
+AllocatePoolSlabSlot (
+  IN POOL   *Pool,
+  IN UINTN  Index
+  )
+{
+  POOL_SLAB  *Slab;
+  UINTN      Word;
+  UINTN      Slot;
+
+  ASSERT (!IsListEmpty (&Pool->SlabList[Index]));
+  Slab = CR (Pool->SlabList[Index].ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  ASSERT (Slab->FreeCount > 0);
+
+  for (Word = 0; Slab->FreeMap[Word] == 0; Word++) {
+    ASSERT (Word < SLAB_MAP_WORDS - 1);
+  }
+
+  Slot                 = (UINTN)LowBitSet64 (Slab->FreeMap[Word]);
+  Slab->FreeMap[Word] &= ~LShiftU64 (1, Slot);
+  Slab->FreeCount--;
+  if (Slab->FreeCount == 0) {
+    RemoveEntryList (&Slab->Link);
+  }
+
+  Slot += Word * 64;
+  return (POOL_HEAD *)((UINT8 *)Slab + SLAB_HEAD_SIZE + Slot * mPoolSlabSizeTable[Index]);
 }
 
 /**
@@ -118,14 +322,32 @@ CoreInitializePool (
 {
   UINTN  Type;
   UINTN  Index;
+  UINTN  Bit;
+
+  ASSERT (MAX_POOL_LIST <= 32);
+  ASSERT (mPoolSizeTable[MAX_POOL_LIST - 1] < (1U << POOL_SIZE_BITS));
+
+  Index = 0;
+  for (Bit = 0; Bit < POOL_SIZE_BITS; Bit++) {
+    while ((Index < MAX_POOL_LIST - 1) && (mPoolSizeTable[Index] < (1U << Bit))) {
+      Index++;
+    }
+
+    mPoolIndexFromHighBit[Bit] = (UINT8)Index;
+  }
 
   for (Type = 0; Type < EfiMaxMemoryType; Type++) {
-    mPoolHead[Type].Signature  = 0;
-    mPoolHead[Type].Used       = 0;
-    mPoolHead[Type].MemoryType = (EFI_MEMORY_TYPE)Type;
+    mPoolHead[Type].Signature      = 0;
+    mPoolHead[Type].Used           = 0;
+    mPoolHead[Type].MemoryType     = (EFI_MEMORY_TYPE)Type;
+    mPoolHead[Type].FreeListBitmap = 0;
     for (Index = 0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+
+    for (Index = 0; Index < MAX_SLAB_LIST; Index++) {
+      InitializeListHead (&mPoolHead[Type].SlabList[Index]);
+    }
   }
 }
 
@@ -168,13 +390,18 @@ LookupPoolHead (
       return NULL;
     }
 
-    Pool->Signature  = POOL_SIGNATURE;
-    Pool->Used       = 0;
-    Pool->MemoryType = MemoryType;
+    Pool->Signature      = POOL_SIGNATURE;
+    Pool->Used           = 0;
+    Pool->MemoryType     = MemoryType;
+    Pool->FreeListBitmap = 0;
     for (Index = 0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&Pool->FreeList[Index]);
     }
 
+    for (Index = 0; Index < MAX_SLAB_LIST; Index++) {
+      InitializeListHead (&Pool->SlabList[Index]);
+    }
+
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
     return Pool;
@@ -363,10 +590,12 @@ CoreAllocatePoolI (
   UINTN      Index;
   UINTN      FSize;
   UINTN      Offset, MaxOffset;
+  UINT32     LargerBins;
   UINTN      NoPages;
   UINTN      Granularity;
   BOOLEAN    HasPoolTail;
   BOOLEAN    PageAsPool;
+  BOOLEAN    InSlab;
 
   ASSERT_LOCKED (&mPoolMemoryLock);
 
@@ -402,7 +631,30 @@ CoreAllocatePoolI (
     return NULL;
   }
 
-  Head = NULL;
+  Head   = NULL;
+  InSlab = FALSE;
+
+  //
+  // Small blocks come from the slab of their size, unless the pages of the
+  // pool type are allocated in units larger than a slab
+  //
+  if (PcdGetBool (PcdDxeCorePoolSlab) && (Size <= MAX_SLAB_SIZE) &&
+      (Granularity == EFI_PAGE_SIZE) && !NeedGuard && !PageAsPool)
+  {
+    Index = GetSlabIndexFromSize (Size);
+    if (IsListEmpty (&Pool->SlabList[Index])) {
+      NewPage = CoreAllocatePoolPagesI (PoolType, 1, Granularity, FALSE);
+      if (NewPage == NULL) {
+        goto Done;
+      }
+
+      InitializePoolSlab (Pool, (POOL_SLAB *)NewPage, Index);
+    }
+
+    Head   = AllocatePoolSlabSlot (Pool, Index);
+    InSlab = TRUE;
+    goto Done;
+  }
 
   //
   // If allocation is over max size, just allocate pages for the request
@@ -426,23 +678,29 @@ CoreAllocatePoolI (
   //
   // If there's no free pool in the proper list size, go get some more pages
   //
-  if (IsListEmpty (&Pool->FreeList[Index])) {
+  if ((Pool->FreeListBitmap & ((UINT32)BIT0 << Index)) == 0) {
+    ASSERT (IsListEmpty (&Pool->FreeList[Index]));
     Offset    = LIST_TO_SIZE (Index);
     MaxOffset = Granularity;
 
     //
-    // Check the bins holding larger blocks, and carve one up if needed
+    // Check the bins holding larger blocks, and carve one up if needed.
+    // The smallest non-empty bin is found with a single bit scan.
     //
-    while (++Index < SIZE_TO_LIST (Granularity)) {
-      if (!IsListEmpty (&Pool->FreeList[Index])) {
-        Free = CR (Pool->FreeList[Index].ForwardLink, POOL_FREE, Link, POOL_FREE_SIGNATURE);
-        RemoveEntryList (&Free->Link);
-        NewPage   = (VOID *)Free;
-        MaxOffset = LIST_TO_SIZE (Index);
-        goto Carve;
-      }
+    LargerBins = Pool->FreeListBitmap &
+                 ~(((UINT32)BIT0 << (Index + 1)) - 1) &
+                 (((UINT32)BIT0 << SIZE_TO_LIST (Granularity)) - 1);
+    if (LargerBins != 0) {
+      Index = (UINTN)LowBitSet32 (LargerBins);
+      Free  = CR (Pool->FreeList[Index].ForwardLink, POOL_FREE, Link, POOL_FREE_SIGNATURE);
+      RemovePoolFreeBlock (Pool, Free);
+      NewPage   = (VOID *)Free;
+      MaxOffset = LIST_TO_SIZE (Index);
+      goto Carve;
     }
 
+    Index = SIZE_TO_LIST (Granularity);
+
     //
     // Get another page
     //
@@ -471,10 +729,8 @@ Carve:
       FSize = LIST_TO_SIZE (Index);
 
       while (Offset + FSize <= MaxOffset) {
-        Free            = (POOL_FREE *)&NewPage[Offset];
-        Free->Signature = POOL_FREE_SIGNATURE;
-        Free->Index     = (UINT32)Index;
-        InsertHeadList (&Pool->FreeList[Index], &Free->Link);
+        Free = (POOL_FREE *)&NewPage[Offset];
+        InsertPoolFreeBlock (Pool, Free, Index);
         Offset += FSize;
       }
 
@@ -489,7 +745,7 @@ Carve:
   // Remove entry from free pool list
   //
   Free = CR (Pool->FreeList[Index].ForwardLink, POOL_FREE, Link, POOL_FREE_SIGNATURE);
-  RemoveEntryList (&Free->Link);
+  RemovePoolFreeBlock (Pool, Free);
 
   Head = (POOL_HEAD *)Free;
 
@@ -505,7 +761,14 @@ Done:
     //
     // If we have a pool buffer, fill in the header & tail info
     //
-    Head->Signature = (PageAsPool) ? POOLPAGE_HEAD_SIGNATURE : POOL_HEAD_SIGNATURE;
+    if (PageAsPool) {
+      Head->Signature = POOLPAGE_HEAD_SIGNATURE;
+    } else if (InSlab) {
+      Head->Signature = POOLSLAB_HEAD_SIGNATURE;
+    } else {
+      Head->Signature = POOL_HEAD_SIGNATURE;
+    }
+
     Head->Size      = Size;
     Head->Type      = (EFI_MEMORY_TYPE)PoolType;
     Buffer          = Head->Data;
@@ -665,6 +928,60 @@ CoreFreePoolPagesWithGuard (
   }
 }
 
+/**
+  Internal function.  Returns a slot to its slab. The page of a slab whose
+  slots are all free is returned to free memory, unless it is the only slab
+  of its size left with free slots.
+
+  @param  Pool                   The pool that owns the slab
+  @param  Head                   The slot to free
+
+**/
+STATIC
+VOID
+FreePoolSlabSlot (
+  IN POOL       *Pool,
+  IN POOL_HEAD  *Head
+  )
+{
+  POOL_SLAB  *Slab;
+  UINTN      Slot;
+  UINT64     Mask;
+
+  Slab = (POOL_SLAB *)((UINTN)Head & ~(UINTN)EFI_PAGE_MASK);
+  ASSERT (Slab->Signature == POOL_SLAB_SIGNATURE);
+  ASSERT (Slab->Index < MAX_SLAB_LIST);
+
+  Slot = ((UINTN)Head - (UINTN)Slab - SLAB_HEAD_SIZE) / mPoolSlabSizeTable[Slab->Index];
+  Mask = LShiftU64 (1, Slot % 64);
+  ASSERT ((Slab->FreeMap[Slot / 64] & Mask) == 0);
+
+  if (Slab->FreeCount == 0) {
+    InsertHeadList (&Pool->SlabList[Slab->Index], &Slab->Link);
+  }
+
+  Slab->FreeMap[Slot / 64] |= Mask;
+  Slab->FreeCount++;
+
+  //
+  // Keep one empty slab around so that a block allocated and freed over and
+  // over does not allocate and free a page each time. The pool of an OS/OEM
+  // memory type is freed with its last block, so its slabs are not kept.
+  //
+  if ((Slab->FreeCount == SLAB_SLOT_COUNT (Slab->Index)) &&
+      (((UINT32)Pool->MemoryType >= MEMORY_TYPE_OEM_RESERVED_MIN) ||
+       (Pool->SlabList[Slab->Index].ForwardLink != Pool->SlabList[Slab->Index].BackLink)))
+  {
+    RemoveEntryList (&Slab->Link);
+    Slab->Signature = 0;
+    CoreFreePoolPagesI (
+      Pool->MemoryType,
+      (EFI_PHYSICAL_ADDRESS)(UINTN)Slab,
+      1
+      );
+  }
+}
+
 /**
   Internal function to free a pool entry.
   Caller must have the memory lock held
@@ -696,6 +1013,7 @@ CoreFreePoolI (
   BOOLEAN    IsGuarded;
   BOOLEAN    HasPoolTail;
   BOOLEAN    PageAsPool;
+  BOOLEAN    InSlab;
 
   ASSERT (Buffer != NULL);
   //
@@ -705,11 +1023,13 @@ CoreFreePoolI (
   ASSERT (Head != NULL);
 
   if ((Head->Signature != POOL_HEAD_SIGNATURE) &&
-      (Head->Signature != POOLPAGE_HEAD_SIGNATURE))
+      (Head->Signature != POOLPAGE_HEAD_SIGNATURE) &&
+      (Head->Signature != POOLSLAB_HEAD_SIGNATURE))
   {
     ASSERT (
       Head->Signature == POOL_HEAD_SIGNATURE ||
-      Head->Signature == POOLPAGE_HEAD_SIGNATURE
+      Head->Signature == POOLPAGE_HEAD_SIGNATURE ||
+      Head->Signature == POOLSLAB_HEAD_SIGNATURE
       );
     return EFI_INVALID_PARAMETER;
   }
@@ -719,6 +1039,7 @@ CoreFreePoolI (
   HasPoolTail = !(IsGuarded &&
                   ((PcdGet8 (PcdHeapGuardPropertyMask) & BIT7) == 0));
   PageAsPool = (Head->Signature == POOLPAGE_HEAD_SIGNATURE);
+  InSlab     = (Head->Signature == POOLSLAB_HEAD_SIGNATURE);
 
   if (HasPoolTail) {
     Tail = HEAD_TO_TAIL (Head);
@@ -774,9 +1095,12 @@ CoreFreePoolI (
   DEBUG_CLEAR_MEMORY (Head, Size);
 
   //
-  // If it's not on the list, it must be pool pages
+  // Slab slots go back to their slab. Otherwise, if it's not on the list, it
+  // must be pool pages
   //
-  if ((Index >= SIZE_TO_LIST (Granularity)) || IsGuarded || PageAsPool) {
+  if (InSlab) {
+    FreePoolSlabSlot (Pool, Head);
+  } else if ((Index >= SIZE_TO_LIST (Granularity)) || IsGuarded || PageAsPool) {
     //
     // Return the memory pages back to free memory
     //
@@ -802,9 +1126,7 @@ CoreFreePoolI (
     //
     Free = (POOL_FREE *)Head;
     ASSERT (Free != NULL);
-    Free->Signature = POOL_FREE_SIGNATURE;
-    Free->Index     = (UINT32)Index;
-    InsertHeadList (&Pool->FreeList[Index], &Free->Link);
+    InsertPoolFreeBlock (Pool, Free, Index);
 
     //
     // See if all the pool entries in the same page as Free are freed pool
@@ -841,7 +1163,7 @@ CoreFreePoolI (
         while (Offset < Granularity) {
           Free = (POOL_FREE *)&NewPage[Offset];
           ASSERT (Free != NULL);
-          RemoveEntryList (&Free->Link);
+          RemovePoolFreeBlock (Pool, Free);
           Offset += LIST_TO_SIZE (Free->Index);
         }
 
@@ -0,0 +1,1134 @@
+/** @file
+  Host-based unit tests of the page management of the DXE Core. The memory
+  map describes an arena taken from the host heap, so the descriptors the
+  DXE Core allocates for itself also come from the arena.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+#include "../Imem.h"
+#include "../HeapGuard.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Page Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_ARENA_PAGES      4096
+#define TEST_ARENA_ALIGNMENT  SIZE_2MB
+#define TEST_ARENA_REGIONS    4
+#define TEST_TRACE_STEPS      20000
+#define TEST_MAX_PAGES        48
+#define TEST_QUERY_ROUNDS     20000
+
+//
+// The memory types the trace allocates
+//
+STATIC CONST EFI_MEMORY_TYPE  mTestMemoryTypes[] = {
+  EfiBootServicesData,
+  EfiBootServicesCode,
+  EfiLoaderData,
+  EfiRuntimeServicesData,
+  EfiACPIReclaimMemory
+};
+
+//
+// The attributes the trace converts ranges to
+//
+STATIC CONST UINT64  mTestAttributes[] = {
+  EFI_MEMORY_WB,
+  EFI_MEMORY_WB | EFI_MEMORY_XP,
+  EFI_MEMORY_UC
+};
+
+//
+// The arena, and for each of its pages the allocation of the trace that
+// holds it, 0 if the trace did not allocate it
+//
+STATIC UINT8   *mArena;
+STATIC UINT64  mArenaStart;
+STATIC UINT64  mArenaEnd;
+STATIC UINT32  mPageOwner[TEST_ARENA_PAGES];
+STATIC UINT8   mPageType[TEST_ARENA_PAGES];
+STATIC UINT32  mNextOwner;
+STATIC UINT32  mSeed;
+
+//
+// Counts of what the trace did
+//
+STATIC UINTN  mAllocations;
+STATIC UINTN  mFailedAllocations;
+STATIC UINTN  mFrees;
+STATIC UINTN  mConversions;
+
+//
+// The memory map of Page.c
+//
+extern MEMORY_MAP  *mFreeMemoryTree;
+extern LIST_ENTRY  mFreeMemoryMapEntryList;
+extern UINTN       mMapDepth;
+
+/**
+  Internal function. Finds a consecutive free page range below
+  the requested address. Defined in Page.c.
+
+  @param  MaxAddress             The address that the range must be below
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfPages          Number of pages needed
+  @param  NewType                The type of memory the range is going to be
+                                 turned into
+  @param  Alignment              Bits to align with
+  @param  NeedGuard              Flag to indicate Guard page is needed or not
+
+  @return The base address of the range, or 0 if the range was not found
+
+**/
+UINT64
+CoreFindFreePagesI (
+  IN UINT64           MaxAddress,
+  IN UINT64           MinAddress,
+  IN UINT64           NumberOfPages,
+  IN EFI_MEMORY_TYPE  NewType,
+  IN UINTN            Alignment,
+  IN BOOLEAN          NeedGuard
+  );
+
+/**
+  Internal function.  Adds a ranges to the memory map.
+  The range must not already exist in the map. Defined in Page.c.
+
+  @param  Type                   The type of memory range to add
+  @param  Start                  The starting address in the memory range Must be
+                                 paged aligned
+  @param  End                    The last address in the range Must be the last
+                                 byte of a page
+  @param  Attribute              The attributes of the memory range to add
+
+**/
+VOID
+CoreAddRange (
+  IN EFI_MEMORY_TYPE       Type,
+  IN EFI_PHYSICAL_ADDRESS  Start,
+  IN EFI_PHYSICAL_ADDRESS  End,
+  IN UINT64                Attribute
+  );
+
+/**
+  Internal function.  Moves any memory descriptors that are on the
+  temporary descriptor stack to heap. Defined in Page.c.
+
+**/
+VOID
+CoreFreeMemoryMapStack (
+  VOID
+  );
+
+/// === STUB FUNCTIONS ===
+
+EFI_LOCK    gMemoryLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+LIST_ENTRY  gMemoryMap  = INITIALIZE_LIST_HEAD_VARIABLE (gMemoryMap);
+BOOLEAN     mOnGuarding = FALSE;
+LIST_ENTRY  mGcdMemorySpaceMap = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
+EFI_HANDLE  gDxeCoreImageHandle = NULL;
+
+EFI_LOAD_FIXED_ADDRESS_CONFIGURATION_TABLE  gLoadModuleAtFixAddressConfigurationTable = { 0, 0 };
+
+/**
+  Stub of the DXE Core CoreAcquireLock(). The locks are only checked, as the
+  tests run on one thread.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseLock().
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the DXE Core CoreAcquireGcdMemoryLock(). The GCD map is empty.
+
+**/
+VOID
+CoreAcquireGcdMemoryLock (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreReleaseGcdMemoryLock(). The GCD map is empty.
+
+**/
+VOID
+CoreReleaseGcdMemoryLock (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreGetMemorySpaceDescriptor(). The GCD map is empty.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreGetMemorySpaceDescriptor (
+  IN  EFI_PHYSICAL_ADDRESS             BaseAddress,
+  OUT EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Descriptor
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of the DXE Core MergeMemoryMap(). The memory map is not merged.
+
+**/
+VOID
+MergeMemoryMap (
+  IN OUT EFI_MEMORY_DESCRIPTOR  *MemoryMap,
+  IN OUT UINTN                  *MemoryMapSize,
+  IN UINTN                      DescriptorSize
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreNotifySignalList(). No event is signaled.
+
+**/
+VOID
+CoreNotifySignalList (
+  IN EFI_GUID  *EventGroup
+  )
+{
+}
+
+/**
+  Stub of the DXE Core IsPageTypeToGuard(). The heap guard is not simulated.
+
+**/
+BOOLEAN
+IsPageTypeToGuard (
+  IN EFI_MEMORY_TYPE    MemoryType,
+  IN EFI_ALLOCATE_TYPE  AllocateType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core IsHeapGuardEnabled(). The heap guard is not simulated.
+
+**/
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8  GuardType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core IsMemoryGuarded(). The heap guard is not simulated.
+
+**/
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core AdjustMemoryS(). The heap guard is not simulated.
+
+**/
+UINT64
+AdjustMemoryS (
+  IN UINT64  Start,
+  IN UINT64  Size,
+  IN UINT64  SizeRequested
+  )
+{
+  return Start + Size - 1;
+}
+
+/**
+  Stub of the DXE Core SetGuardForMemory(). The heap guard is not simulated.
+
+**/
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the DXE Core CoreConvertPagesWithGuard(). The heap guard is not
+  simulated.
+
+**/
+EFI_STATUS
+CoreConvertPagesWithGuard (
+  IN UINT64           Start,
+  IN UINTN            NumberOfPages,
+  IN EFI_MEMORY_TYPE  NewType
+  )
+{
+  return CoreConvertPages (Start, NumberOfPages, NewType);
+}
+
+/**
+  Stub of the DXE Core PromoteGuardedFreePages(). The heap guard is not
+  simulated.
+
+**/
+BOOLEAN
+PromoteGuardedFreePages (
+  OUT EFI_PHYSICAL_ADDRESS  *StartAddress,
+  OUT EFI_PHYSICAL_ADDRESS  *EndAddress
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core DumpGuardedMemoryBitmap(). The heap guard is not
+  simulated.
+
+**/
+VOID
+EFIAPI
+DumpGuardedMemoryBitmap (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of the DXE Core GuardFreedPagesChecked(). The heap guard is not
+  simulated.
+
+**/
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINTN                 Pages
+  )
+{
+}
+
+/**
+  Stub of the DXE Core ApplyMemoryProtectionPolicy(). The memory protection
+  is not simulated.
+
+**/
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreUpdateProfile(). The memory profile is not recorded.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core InstallMemoryAttributesTableOnMemoryAllocation(). The
+  memory attributes table is not installed.
+
+**/
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Returns the arena page of an address.
+
+  @param[in]  Address  An address in the arena.
+
+  @return The index of the page.
+
+**/
+STATIC
+UINTN
+ArenaPage (
+  IN UINT64  Address
+  )
+{
+  return (UINTN)RShiftU64 (Address - mArenaStart, EFI_PAGE_SHIFT);
+}
+
+/**
+  The free page search Page.c did before the free memory tree: walk all the
+  entries of the memory map, and keep the highest range found.
+
+  @param  MaxAddress             The last address the range may use, the end
+                                 of a page.
+  @param  MinAddress             The address that the range must be above.
+  @param  NumberOfPages          Number of pages needed.
+  @param  Alignment              Bits to align with.
+
+  @return The base address of the range, or 0 if the range was not found.
+
+**/
+STATIC
+UINT64
+FindFreePagesLinear (
+  IN UINT64  MaxAddress,
+  IN UINT64  MinAddress,
+  IN UINT64  NumberOfPages,
+  IN UINTN   Alignment
+  )
+{
+  UINT64      NumberOfBytes;
+  UINT64      Target;
+  UINT64      DescStart;
+  UINT64      DescEnd;
+  LIST_ENTRY  *Link;
+  MEMORY_MAP  *Entry;
+
+  NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
+  Target        = 0;
+
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if (Entry->Type != EfiConventionalMemory) {
+      continue;
+    }
+
+    DescStart = Entry->Start;
+    DescEnd   = MIN (Entry->End, MaxAddress);
+    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
+      continue;
+    }
+
+    DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
+    if ((DescEnd < DescStart) || (DescEnd - DescStart + 1 < NumberOfBytes) ||
+        (DescEnd - NumberOfBytes + 1 < MinAddress))
+    {
+      continue;
+    }
+
+    Target = MAX (Target, DescEnd);
+  }
+
+  if (Target == 0) {
+    return 0;
+  }
+
+  return Target - NumberOfBytes + 1;
+}
+
+/**
+  Checks a subtree of the free memory tree: the entries are free entries of
+  gMemoryMap in address order, and the heights, balances and largest sizes
+  kept in the nodes are right.
+
+  @param[in]      Node      The root of the subtree, or NULL.
+  @param[in, out] Previous  The entry before the subtree, updated to the last
+                            entry of the subtree.
+  @param[in, out] Count     Incremented by the number of entries.
+  @param[out]     Height    The height of the subtree.
+  @param[out]     MaxSize   The size of the largest entry of the subtree.
+
+  @retval TRUE   The subtree is consistent.
+  @retval FALSE  The subtree is broken.
+
+**/
+STATIC
+BOOLEAN
+FreeMemorySubtreeIsConsistent (
+  IN     MEMORY_MAP  *Node,
+  IN OUT MEMORY_MAP  **Previous,
+  IN OUT UINTN       *Count,
+  OUT    UINTN       *Height,
+  OUT    UINT64      *MaxSize
+  )
+{
+  UINTN   LeftHeight;
+  UINTN   RightHeight;
+  UINT64  LeftMaxSize;
+  UINT64  RightMaxSize;
+
+  if (Node == NULL) {
+    *Height  = 0;
+    *MaxSize = 0;
+    return TRUE;
+  }
+
+  if (!FreeMemorySubtreeIsConsistent (Node->FreeLeft, Previous, Count, &LeftHeight, &LeftMaxSize)) {
+    return FALSE;
+  }
+
+  //
+  // The entry must be a free entry linked on gMemoryMap, after the previous
+  // one without overlapping it
+  //
+  if ((Node->Signature != MEMORY_MAP_SIGNATURE) || (Node->Type != EfiConventionalMemory) ||
+      (Node->Start > Node->End) || (Node->Link.ForwardLink == NULL) ||
+      (Node->Link.ForwardLink->BackLink != &Node->Link) || (Node->Link.BackLink->ForwardLink != &Node->Link))
+  {
+    return FALSE;
+  }
+
+  if ((*Previous != NULL) && ((*Previous)->End >= Node->Start)) {
+    return FALSE;
+  }
+
+  *Previous = Node;
+  (*Count)++;
+
+  if (!FreeMemorySubtreeIsConsistent (Node->FreeRight, Previous, Count, &RightHeight, &RightMaxSize)) {
+    return FALSE;
+  }
+
+  *Height  = 1 + MAX (LeftHeight, RightHeight);
+  *MaxSize = MAX (Node->End - Node->Start + 1, MAX (LeftMaxSize, RightMaxSize));
+
+  return (BOOLEAN)((Node->FreeHeight == *Height) && (Node->FreeMaxSize == *MaxSize) &&
+                   (LeftHeight <= RightHeight + 1) && (RightHeight <= LeftHeight + 1));
+}
+
+/**
+  Checks the memory map and the free memory tree against each other. The
+  entries of gMemoryMap must cover the arena without overlapping. The free
+  ones, and only those, must be in the tree. The pages the trace allocated
+  must have the type the trace allocated them with.
+
+  @retval TRUE   The memory map is consistent.
+  @retval FALSE  The memory map is broken.
+
+**/
+STATIC
+BOOLEAN
+MemoryMapIsConsistent (
+  VOID
+  )
+{
+  LIST_ENTRY  *Link;
+  MEMORY_MAP  *Entry;
+  MEMORY_MAP  *Previous;
+  UINTN       FreeEntries;
+  UINTN       TreeEntries;
+  UINTN       Height;
+  UINT64      MaxSize;
+  UINT64      Covered;
+  UINT64      Address;
+
+  FreeEntries = 0;
+  Covered     = 0;
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if ((Entry->Start < mArenaStart) || (Entry->End > mArenaEnd) || (Entry->Start > Entry->End)) {
+      return FALSE;
+    }
+
+    if (Entry->Type == EfiConventionalMemory) {
+      if (Entry->FreeHeight == 0) {
+        return FALSE;
+      }
+
+      FreeEntries++;
+    } else if (Entry->FreeHeight != 0) {
+      return FALSE;
+    }
+
+    for (Address = Entry->Start; Address < Entry->End; Address += EFI_PAGE_SIZE) {
+      if ((mPageOwner[ArenaPage (Address)] != 0) && (mPageType[ArenaPage (Address)] != Entry->Type)) {
+        return FALSE;
+      }
+    }
+
+    Covered += Entry->End - Entry->Start + 1;
+  }
+
+  //
+  // As the entries do not overlap, they cover the arena if their sizes add
+  // up to it
+  //
+  if (Covered != mArenaEnd - mArenaStart + 1) {
+    return FALSE;
+  }
+
+  Previous    = NULL;
+  TreeEntries = 0;
+  if (!FreeMemorySubtreeIsConsistent (mFreeMemoryTree, &Previous, &TreeEntries, &Height, &MaxSize)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(TreeEntries == FreeEntries);
+}
+
+/**
+  Checks that a range of the arena is within one free entry of gMemoryMap,
+  as pages can only be allocated from one entry.
+
+  @param[in]  Address        The start of the range.
+  @param[in]  NumberOfPages  The number of pages of the range.
+
+  @retval TRUE   A free entry holds all the pages of the range.
+  @retval FALSE  Otherwise.
+
+**/
+STATIC
+BOOLEAN
+RangeIsInFreeEntry (
+  IN UINT64  Address,
+  IN UINTN   NumberOfPages
+  )
+{
+  LIST_ENTRY  *Link;
+  MEMORY_MAP  *Entry;
+  UINT64      End;
+
+  End = Address + EFI_PAGES_TO_SIZE (NumberOfPages) - 1;
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if ((Entry->Type == EfiConventionalMemory) && (Entry->Start <= Address) && (Entry->End >= End)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Allocates pages as the trace does, and checks that they come from the
+  top of the free memory below the maximum address.
+
+  @param[in]  Type           The type of allocation to perform.
+  @param[in]  MemoryType     The type of memory to allocate.
+  @param[in]  NumberOfPages  The number of pages to allocate.
+  @param[in]  Address        The address to allocate at, or the maximum
+                             address of the allocation.
+
+  @retval TRUE   The allocation succeeded where it should, or failed when no
+                 free range could hold it.
+  @retval FALSE  Otherwise.
+
+**/
+STATIC
+BOOLEAN
+AllocateTracePages (
+  IN EFI_ALLOCATE_TYPE  Type,
+  IN EFI_MEMORY_TYPE    MemoryType,
+  IN UINTN              NumberOfPages,
+  IN UINT64             Address
+  )
+{
+  EFI_PHYSICAL_ADDRESS  Memory;
+  EFI_STATUS            Status;
+  UINT64                Expected;
+  UINTN                 Page;
+
+  if (Type == AllocateAddress) {
+    Expected = Address;
+  } else {
+    Expected = FindFreePagesLinear (
+                 (Type == AllocateMaxAddress) ? Address : MAX_ALLOC_ADDRESS,
+                 0,
+                 NumberOfPages,
+                 DEFAULT_PAGE_ALLOCATION_GRANULARITY
+                 );
+  }
+
+  Memory = Address;
+  Status = CoreAllocatePages (Type, MemoryType, NumberOfPages, &Memory);
+  if (EFI_ERROR (Status)) {
+    mFailedAllocations++;
+
+    //
+    // The search found nothing, or the range asked for is not free
+    //
+    if (Type != AllocateAddress) {
+      return (BOOLEAN)(Expected == 0);
+    }
+
+    return (BOOLEAN)!RangeIsInFreeEntry (Address, NumberOfPages);
+  }
+
+  if (Memory != Expected) {
+    return FALSE;
+  }
+
+  mAllocations++;
+  mNextOwner++;
+  for (Page = ArenaPage (Memory); Page < ArenaPage (Memory) + NumberOfPages; Page++) {
+    if (mPageOwner[Page] != 0) {
+      return FALSE;
+    }
+
+    mPageOwner[Page] = mNextOwner;
+    mPageType[Page]  = (UINT8)MemoryType;
+  }
+
+  return TRUE;
+}
+
+/**
+  Frees a random part of a random allocation of the trace.
+
+  @retval TRUE   The pages were freed, or the trace holds no page.
+  @retval FALSE  The pages could not be freed.
+
+**/
+STATIC
+BOOLEAN
+FreeTracePages (
+  VOID
+  )
+{
+  UINTN   Page;
+  UINTN   First;
+  UINTN   Last;
+  UINTN   Index;
+  UINT32  Owner;
+
+  //
+  // Look for an allocated page from a random one on
+  //
+  Page = GetRandom () % TEST_ARENA_PAGES;
+  for (Index = 0; Index < TEST_ARENA_PAGES; Index++) {
+    if (mPageOwner[(Page + Index) % TEST_ARENA_PAGES] != 0) {
+      break;
+    }
+  }
+
+  if (Index == TEST_ARENA_PAGES) {
+    return TRUE;
+  }
+
+  Page  = (Page + Index) % TEST_ARENA_PAGES;
+  Owner = mPageOwner[Page];
+  First = Page;
+  Last  = Page;
+  while ((First > 0) && (mPageOwner[First - 1] == Owner)) {
+    First--;
+  }
+
+  while ((Last + 1 < TEST_ARENA_PAGES) && (mPageOwner[Last + 1] == Owner)) {
+    Last++;
+  }
+
+  //
+  // Free the whole allocation most of the times, else a part of it
+  //
+  if ((GetRandom () % 4) == 0) {
+    First = First + GetRandom () % (Last - First + 1);
+    Last  = First + GetRandom () % (Last - First + 1);
+  }
+
+  if (EFI_ERROR (CoreFreePages (mArenaStart + EFI_PAGES_TO_SIZE (First), Last - First + 1))) {
+    return FALSE;
+  }
+
+  mFrees++;
+  for (Page = First; Page <= Last; Page++) {
+    mPageOwner[Page] = 0;
+  }
+
+  return TRUE;
+}
+
+/**
+  Runs one random step of the allocate/free/convert trace.
+
+  @retval TRUE   The step did what was expected.
+  @retval FALSE  The step failed.
+
+**/
+STATIC
+BOOLEAN
+RunTraceStep (
+  VOID
+  )
+{
+  EFI_MEMORY_TYPE  MemoryType;
+  UINTN            NumberOfPages;
+  UINTN            Page;
+
+  MemoryType    = mTestMemoryTypes[GetRandom () % ARRAY_SIZE (mTestMemoryTypes)];
+  NumberOfPages = 1 + GetRandom () % TEST_MAX_PAGES;
+  Page          = GetRandom () % (TEST_ARENA_PAGES - NumberOfPages);
+
+  switch (GetRandom () % 8) {
+    case 0:
+    case 1:
+      return AllocateTracePages (AllocateAnyPages, MemoryType, NumberOfPages, 0);
+
+    case 2:
+      return AllocateTracePages (AllocateMaxAddress, MemoryType, NumberOfPages, mArenaStart + EFI_PAGES_TO_SIZE (Page) - 1);
+
+    case 3:
+      return AllocateTracePages (AllocateAddress, MemoryType, NumberOfPages, mArenaStart + EFI_PAGES_TO_SIZE (Page));
+
+    case 4:
+      //
+      // Convert the attributes of a range, which splits the entries it
+      // covers, free or not
+      //
+      CoreUpdateMemoryAttributes (
+        mArenaStart + EFI_PAGES_TO_SIZE (Page),
+        NumberOfPages,
+        mTestAttributes[GetRandom () % ARRAY_SIZE (mTestAttributes)]
+        );
+      mConversions++;
+      return TRUE;
+
+    default:
+      return FreeTracePages ();
+  }
+}
+
+/**
+  Resets the memory map to the arena. The arena is split into regions of
+  different attributes, so that some free entries stay next to each other.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED                      The memory map was reset.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The arena could not be
+                                                allocated.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+PageSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  RegionSize;
+  UINTN   Region;
+
+  if (mArena == NULL) {
+    mArena = AllocateAlignedPages (TEST_ARENA_PAGES, TEST_ARENA_ALIGNMENT);
+    if (mArena == NULL) {
+      return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+    }
+  }
+
+  mArenaStart = (UINT64)(UINTN)mArena;
+  mArenaEnd   = mArenaStart + EFI_PAGES_TO_SIZE (TEST_ARENA_PAGES) - 1;
+
+  InitializeListHead (&gMemoryMap);
+  InitializeListHead (&mFreeMemoryMapEntryList);
+  mFreeMemoryTree = NULL;
+  mMapDepth       = 0;
+
+  RegionSize = EFI_PAGES_TO_SIZE (TEST_ARENA_PAGES) / TEST_ARENA_REGIONS;
+  CoreAcquireMemoryLock ();
+  for (Region = 0; Region < TEST_ARENA_REGIONS; Region++) {
+    CoreAddRange (
+      EfiConventionalMemory,
+      mArenaStart + Region * RegionSize,
+      mArenaStart + (Region + 1) * RegionSize - 1,
+      mTestAttributes[Region % 2]
+      );
+  }
+
+  CoreFreeMemoryMapStack ();
+  CoreReleaseMemoryLock ();
+
+  ZeroMem (mPageOwner, sizeof (mPageOwner));
+  ZeroMem (mPageType, sizeof (mPageType));
+  mNextOwner         = 0;
+  mSeed              = 0x5eed;
+  mAllocations       = 0;
+  mFailedAllocations = 0;
+  mFrees             = 0;
+  mConversions       = 0;
+
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST CASES ===
+
+/**
+  A random trace of page allocations, frees and attribute conversions
+  should keep the free memory tree in step with gMemoryMap after each step,
+  and the allocations should come from the top of the free memory.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TraceShouldKeepFreeTreeInStep (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Step;
+
+  UT_ASSERT_TRUE (MemoryMapIsConsistent ());
+  UT_ASSERT_EQUAL (mFreeMemoryTree->FreeMaxSize, EFI_PAGES_TO_SIZE (TEST_ARENA_PAGES) / TEST_ARENA_REGIONS);
+
+  for (Step = 0; Step < TEST_TRACE_STEPS; Step++) {
+    UT_ASSERT_TRUE (RunTraceStep ());
+    UT_ASSERT_TRUE (MemoryMapIsConsistent ());
+  }
+
+  UT_LOG_INFO (
+    "%d allocations, %d failed, %d frees, %d conversions, tree height %d\n",
+    (INT32)mAllocations,
+    (INT32)mFailedAllocations,
+    (INT32)mFrees,
+    (INT32)mConversions,
+    (INT32)mFreeMemoryTree->FreeHeight
+    );
+  UT_ASSERT_NOT_EQUAL (mAllocations, 0);
+  UT_ASSERT_NOT_EQUAL (mFrees, 0);
+
+  //
+  // Free all that the trace holds
+  //
+  for (Step = 0; Step < TEST_ARENA_PAGES; Step++) {
+    while (mPageOwner[Step] != 0) {
+      UT_ASSERT_TRUE (FreeTracePages ());
+      UT_ASSERT_TRUE (MemoryMapIsConsistent ());
+    }
+  }
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  On a fragmented memory map, the free memory tree search should find the
+  range the walk of all the entries finds, for any bounds and alignment.
+  The time both searches take is logged.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+TreeSearchShouldMatchLinearSearch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINTN  Alignments[] = { SIZE_4KB, SIZE_64KB, SIZE_2MB };
+  UINT64              MaxAddress;
+  UINT64              MinAddress;
+  UINT64              NumberOfPages;
+  UINTN               Alignment;
+  UINTN               Round;
+  UINTN               Page;
+  UINTN               Run;
+  clock_t             Start;
+  UINT64              TreeTime;
+  UINT64              LinearTime;
+
+  //
+  // Fragment the map: allocate the arena page by page, then free runs of
+  // growing length between allocated pages
+  //
+  for (Page = 0; Page < TEST_ARENA_PAGES; Page++) {
+    if (!AllocateTracePages (AllocateAnyPages, EfiBootServicesData, 1, 0)) {
+      break;
+    }
+  }
+
+  for (Page = 0; Page < TEST_ARENA_PAGES; Page += 2 + Page % 7) {
+    for (Run = 0; (Run < 1 + Page % 5) && (Page + Run < TEST_ARENA_PAGES) && (mPageOwner[Page + Run] != 0); Run++) {
+    }
+
+    if (Run != 0) {
+      UT_ASSERT_NOT_EFI_ERROR (CoreFreePages (mArenaStart + EFI_PAGES_TO_SIZE (Page), Run));
+      ZeroMem (&mPageOwner[Page], sizeof (mPageOwner[0]) * Run);
+    }
+  }
+
+  UT_ASSERT_TRUE (MemoryMapIsConsistent ());
+
+  TreeTime   = 0;
+  LinearTime = 0;
+  for (Round = 0; Round < TEST_QUERY_ROUNDS; Round++) {
+    MaxAddress = ((GetRandom () % 4) == 0) ? MAX_ALLOC_ADDRESS : mArenaStart + EFI_PAGES_TO_SIZE (GetRandom () % TEST_ARENA_PAGES) - 1;
+    MinAddress = ((GetRandom () % 2) == 0) ? 0 : mArenaStart + EFI_PAGES_TO_SIZE (GetRandom () % TEST_ARENA_PAGES);
+    NumberOfPages = 1 + GetRandom () % 6;
+    Alignment     = Alignments[GetRandom () % ARRAY_SIZE (Alignments)];
+
+    Start       = clock ();
+    Page        = (UINTN)FindFreePagesLinear (MaxAddress, MinAddress, NumberOfPages, Alignment);
+    LinearTime += clock () - Start;
+
+    Start     = clock ();
+    UT_ASSERT_EQUAL (CoreFindFreePagesI (MaxAddress, MinAddress, NumberOfPages, EfiBootServicesData, Alignment, FALSE), Page);
+    TreeTime += clock () - Start;
+  }
+
+  UT_LOG_INFO (
+    "%d searches: %d us walking gMemoryMap, %d us with the free memory tree\n",
+    TEST_QUERY_ROUNDS,
+    (INT32)(LinearTime * 1000000 / CLOCKS_PER_SEC),
+    (INT32)(TreeTime * 1000000 / CLOCKS_PER_SEC)
+    );
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  page management of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PageTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core Page Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&PageTests, Framework, "DXE Core Free Memory Tree Tests", "DxeCore.Page.FreeTree", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Free Memory Tree Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite--------Description--------------------------------------------Name------Function-------------------------------Pre--------Post---Context-----------
+  //
+  AddTestCase (PageTests, "Replay an allocate, free and convert trace", "Trace", TraceShouldKeepFreeTreeInStep, PageSetup, NULL, NULL);
+  AddTestCase (PageTests, "Search a fragmented map like the linear walk", "Search", TreeSearchShouldMatchLinearSearch, PageSetup, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCorePageUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCorePageUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -0,0 +1,830 @@
+/** @file
+  Host-based unit tests of the pool management of the DXE Core. The pages
+  backing the pools come from the host heap.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "../../DxeMain.h"
+#include "../Imem.h"
+#include "../HeapGuard.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Pool Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_BLOCK_COUNT        1024
+#define TEST_LIVE_COUNT         512
+#define TEST_STRESS_ROUNDS      50000
+#define TEST_BENCHMARK_ROUNDS   1000000
+#define TEST_OEM_MEMORY_TYPE    ((EFI_MEMORY_TYPE)(MEMORY_TYPE_OEM_RESERVED_MIN + 1))
+
+///
+/// A live allocation made by the tests
+///
+typedef struct {
+  UINT8    *Buffer;
+  UINTN    Size;
+  UINT8    Tag;
+} TEST_ALLOCATION;
+
+//
+// The data sizes that fill the slots of each slab, the largest one with
+// the pool overhead of X64
+//
+STATIC CONST UINTN  mSlabDataSizes[] = {
+  8, 24, 56, 88, 152, 216, 344, 472
+};
+
+STATIC TEST_ALLOCATION  mAllocations[TEST_BLOCK_COUNT];
+STATIC UINT32           mSeed;
+STATIC UINTN            mPagesInUse;
+STATIC UINTN            mPagesPeak;
+
+/// === STUB FUNCTIONS ===
+
+EFI_LOCK  gMemoryLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+BOOLEAN   mOnGuarding = FALSE;
+
+/**
+  Stub of the DXE Core CoreAcquireLock(). The locks are only checked, as the
+  tests run on one thread.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core CoreAcquireLockOrFail(). Fails if the lock is already
+  held.
+
+**/
+EFI_STATUS
+CoreAcquireLockOrFail (
+  IN EFI_LOCK  *Lock
+  )
+{
+  if (Lock->Lock == EfiLockAcquired) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  Lock->Lock = EfiLockAcquired;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreReleaseLock().
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the DXE Core CoreAcquireMemoryLock().
+
+**/
+VOID
+CoreAcquireMemoryLock (
+  VOID
+  )
+{
+  CoreAcquireLock (&gMemoryLock);
+}
+
+/**
+  Stub of the DXE Core CoreReleaseMemoryLock().
+
+**/
+VOID
+CoreReleaseMemoryLock (
+  VOID
+  )
+{
+  CoreReleaseLock (&gMemoryLock);
+}
+
+/**
+  Stub of the DXE Core CoreAllocatePoolPages(). The pages come from the host
+  heap, and are counted.
+
+**/
+VOID *
+CoreAllocatePoolPages (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            NumberOfPages,
+  IN UINTN            Alignment,
+  IN BOOLEAN          NeedGuard
+  )
+{
+  VOID  *Buffer;
+
+  Buffer = AllocateAlignedPages (NumberOfPages, Alignment);
+  if (Buffer != NULL) {
+    mPagesInUse += NumberOfPages;
+    mPagesPeak   = MAX (mPagesPeak, mPagesInUse);
+  }
+
+  return Buffer;
+}
+
+/**
+  Stub of the DXE Core CoreFreePoolPages(). The pages go back to the host heap.
+
+**/
+VOID
+CoreFreePoolPages (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+  ASSERT (mPagesInUse >= NumberOfPages);
+  mPagesInUse -= NumberOfPages;
+  FreeAlignedPages ((VOID *)(UINTN)Memory, NumberOfPages);
+}
+
+/**
+  Stub of the DXE Core SetGuardForMemory(). The heap guard is not simulated.
+
+**/
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the DXE Core UnsetGuardForMemory(). The heap guard is not simulated.
+
+**/
+VOID
+UnsetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the DXE Core AdjustMemoryF(). The heap guard is not simulated.
+
+**/
+VOID
+AdjustMemoryF (
+  IN OUT EFI_PHYSICAL_ADDRESS  *Memory,
+  IN OUT UINTN                 *NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the DXE Core IsPoolTypeToGuard(). The heap guard is not simulated.
+
+**/
+BOOLEAN
+IsPoolTypeToGuard (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core IsMemoryGuarded(). The heap guard is not simulated.
+
+**/
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core IsHeapGuardEnabled(). The heap guard is not simulated.
+
+**/
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8  GuardType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the DXE Core AdjustPoolHeadA(). The heap guard is not simulated.
+
+**/
+VOID *
+AdjustPoolHeadA (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NoPages,
+  IN UINTN                 Size
+  )
+{
+  return (VOID *)(UINTN)Memory;
+}
+
+/**
+  Stub of the DXE Core AdjustPoolHeadF(). The heap guard is not simulated.
+
+**/
+VOID *
+AdjustPoolHeadF (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NoPages,
+  IN UINTN                 Size
+  )
+{
+  return (VOID *)(UINTN)Memory;
+}
+
+/**
+  Stub of the DXE Core GuardFreedPagesChecked(). The heap guard is not
+  simulated.
+
+**/
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINTN                 Pages
+  )
+{
+}
+
+/**
+  Stub of the DXE Core ApplyMemoryProtectionPolicy(). The memory protection
+  is not simulated.
+
+**/
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core CoreUpdateProfile(). The memory profile is not recorded.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core InstallMemoryAttributesTableOnMemoryAllocation(). The
+  memory attributes table is not installed.
+
+**/
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+}
+
+/// === HELPER FUNCTIONS ===
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the tests performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+GetRandom (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245 + 12345;
+  return mSeed >> 8;
+}
+
+/**
+  Allocates a block and fills it with a tag.
+
+  @param[in]  Allocation  The allocation to make.
+  @param[in]  PoolType    The type of the pool.
+  @param[in]  Size        The size of the block.
+
+  @retval TRUE   The block was allocated.
+  @retval FALSE  The allocation failed.
+
+**/
+STATIC
+BOOLEAN
+AllocateTagged (
+  IN TEST_ALLOCATION  *Allocation,
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            Size
+  )
+{
+  if (EFI_ERROR (CoreAllocatePool (PoolType, Size, (VOID **)&Allocation->Buffer))) {
+    return FALSE;
+  }
+
+  Allocation->Size = Size;
+  Allocation->Tag  = (UINT8)GetRandom ();
+  SetMem (Allocation->Buffer, Size, Allocation->Tag);
+  return TRUE;
+}
+
+/**
+  Checks the tag of a block and frees it.
+
+  @param[in]  Allocation  The allocation to free.
+
+  @retval TRUE   The block kept its tag and was freed.
+  @retval FALSE  The block was corrupted, or could not be freed.
+
+**/
+STATIC
+BOOLEAN
+FreeTagged (
+  IN TEST_ALLOCATION  *Allocation
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Allocation->Size; Index++) {
+    if (Allocation->Buffer[Index] != Allocation->Tag) {
+      return FALSE;
+    }
+  }
+
+  if (EFI_ERROR (CoreFreePool (Allocation->Buffer))) {
+    return FALSE;
+  }
+
+  Allocation->Buffer = NULL;
+  return TRUE;
+}
+
+/**
+  Resets the pools and the page accounting before each test.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED  The pools were reset.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+PoolSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CoreInitializePool ();
+  ZeroMem (mAllocations, sizeof (mAllocations));
+  mSeed       = 0x5eed;
+  mPagesInUse = 0;
+  mPagesPeak  = 0;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Restores the slabs, which some tests disable.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+PoolCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PatchPcdSetBool (PcdDxeCorePoolSlab, TRUE);
+}
+
+/// === TEST CASES ===
+
+/**
+  Small blocks should be packed into slab pages, and the pages should be
+  returned once the blocks are freed, except one kept for reuse.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SmallBlocksShouldShareSlabPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT; Index++) {
+    UT_ASSERT_TRUE (AllocateTagged (&mAllocations[Index], EfiBootServicesData, 8));
+    UT_ASSERT_EQUAL ((UINTN)mAllocations[Index].Buffer & 0x7, 0);
+  }
+
+  //
+  // The 8 byte blocks take a 64 byte slot at most with their overhead
+  //
+  UT_LOG_INFO ("%d blocks of 8 bytes in %d pages\n", TEST_BLOCK_COUNT, (INT32)mPagesInUse);
+  UT_ASSERT_TRUE (mPagesInUse <= TEST_BLOCK_COUNT * 64 / EFI_PAGE_SIZE + 1);
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT; Index += 2) {
+    UT_ASSERT_TRUE (FreeTagged (&mAllocations[Index]));
+  }
+
+  for (Index = 1; Index < TEST_BLOCK_COUNT; Index += 2) {
+    UT_ASSERT_TRUE (FreeTagged (&mAllocations[Index]));
+  }
+
+  UT_ASSERT_EQUAL (mPagesInUse, 1);
+
+  //
+  // The page kept should serve the next allocation
+  //
+  UT_ASSERT_TRUE (AllocateTagged (&mAllocations[0], EfiBootServicesData, 8));
+  UT_ASSERT_EQUAL (mPagesInUse, 1);
+  UT_ASSERT_TRUE (FreeTagged (&mAllocations[0]));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  With the slabs disabled, small blocks should come from the free lists,
+  which use more pages for them.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SmallBlocksShouldUseListsWithoutSlabs (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  PatchPcdSetBool (PcdDxeCorePoolSlab, FALSE);
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT; Index++) {
+    UT_ASSERT_TRUE (AllocateTagged (&mAllocations[Index], EfiBootServicesData, 8));
+  }
+
+  UT_LOG_INFO ("%d blocks of 8 bytes in %d pages\n", TEST_BLOCK_COUNT, (INT32)mPagesInUse);
+  UT_ASSERT_TRUE (mPagesInUse > TEST_BLOCK_COUNT * 64 / EFI_PAGE_SIZE + 1);
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT; Index++) {
+    UT_ASSERT_TRUE (FreeTagged (&mAllocations[Index]));
+  }
+
+  UT_ASSERT_EQUAL (mPagesInUse, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every slab size should hand out blocks usable over their full size, and
+  give back all its pages but one once they are freed.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+EverySlabShouldReturnEmptyPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+  UINTN  Size;
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT; Index++) {
+    Size = mSlabDataSizes[Index % ARRAY_SIZE (mSlabDataSizes)] - (GetRandom () % 8);
+    UT_ASSERT_TRUE (AllocateTagged (&mAllocations[Index], EfiBootServicesData, Size));
+  }
+
+  for (Index = TEST_BLOCK_COUNT; Index > 0; Index--) {
+    UT_ASSERT_TRUE (FreeTagged (&mAllocations[(Index * 7) % TEST_BLOCK_COUNT]));
+  }
+
+  UT_ASSERT_TRUE (mPagesInUse <= ARRAY_SIZE (mSlabDataSizes));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The slabs of an OEM memory type should all be freed with its last block.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+OemPoolShouldFreeAllSlabs (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+  UINTN  PagesInUse;
+
+  //
+  // Create the slabs the pool head of the OEM memory type is allocated from
+  //
+  for (Index = 0; Index < ARRAY_SIZE (mSlabDataSizes); Index++) {
+    UT_ASSERT_TRUE (AllocateTagged (&mAllocations[Index], EfiBootServicesData, mSlabDataSizes[Index]));
+  }
+
+  PagesInUse = mPagesInUse;
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT / 2; Index++) {
+    UT_ASSERT_TRUE (AllocateTagged (&mAllocations[TEST_BLOCK_COUNT / 2 + Index], TEST_OEM_MEMORY_TYPE, 8 + Index % 400));
+  }
+
+  UT_ASSERT_TRUE (mPagesInUse > PagesInUse);
+
+  for (Index = 0; Index < TEST_BLOCK_COUNT / 2; Index++) {
+    UT_ASSERT_TRUE (FreeTagged (&mAllocations[TEST_BLOCK_COUNT / 2 + Index]));
+  }
+
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse);
+
+  for (Index = 0; Index < ARRAY_SIZE (mSlabDataSizes); Index++) {
+    UT_ASSERT_TRUE (FreeTagged (&mAllocations[Index]));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Random allocations and frees of blocks of all sizes, of two memory types,
+  should not corrupt any block.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RandomAllocationsShouldNotCorruptBlocks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN            Round;
+  UINTN            Index;
+  EFI_MEMORY_TYPE  PoolType;
+
+  for (Round = 0; Round < TEST_STRESS_ROUNDS; Round++) {
+    Index = GetRandom () % TEST_LIVE_COUNT;
+    if (mAllocations[Index].Buffer != NULL) {
+      UT_ASSERT_TRUE (FreeTagged (&mAllocations[Index]));
+    } else {
+      PoolType = ((Round & 1) == 0) ? EfiBootServicesData : EfiLoaderData;
+      UT_ASSERT_TRUE (AllocateTagged (&mAllocations[Index], PoolType, GetRandom () % 1200));
+    }
+  }
+
+  for (Index = 0; Index < TEST_LIVE_COUNT; Index++) {
+    if (mAllocations[Index].Buffer != NULL) {
+      UT_ASSERT_TRUE (FreeTagged (&mAllocations[Index]));
+    }
+  }
+
+  UT_ASSERT_TRUE (mPagesInUse <= 2 * ARRAY_SIZE (mSlabDataSizes));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs the allocations of the benchmark.
+
+  @return The time it took, in microseconds.
+
+**/
+STATIC
+UINT64
+RunBenchmark (
+  VOID
+  )
+{
+  UINTN    Round;
+  UINTN    Index;
+  clock_t  Start;
+
+  mSeed       = 0x5eed;
+  mPagesInUse = 0;
+  mPagesPeak  = 0;
+
+  Start = clock ();
+  for (Round = 0; Round < TEST_BENCHMARK_ROUNDS; Round++) {
+    Index = GetRandom () % TEST_LIVE_COUNT;
+    if (mAllocations[Index].Buffer != NULL) {
+      CoreFreePool (mAllocations[Index].Buffer);
+      mAllocations[Index].Buffer = NULL;
+    } else {
+      CoreAllocatePool (EfiBootServicesData, 1 + GetRandom () % 472, (VOID **)&mAllocations[Index].Buffer);
+    }
+  }
+
+  for (Index = 0; Index < TEST_LIVE_COUNT; Index++) {
+    if (mAllocations[Index].Buffer != NULL) {
+      CoreFreePool (mAllocations[Index].Buffer);
+      mAllocations[Index].Buffer = NULL;
+    }
+  }
+
+  return (UINT64)(clock () - Start) * 1000000 / CLOCKS_PER_SEC;
+}
+
+/**
+  Benchmark the small allocations with and without the slabs. The time and
+  the peak number of pages they take are logged.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SmallAllocationBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  Elapsed;
+
+  PatchPcdSetBool (PcdDxeCorePoolSlab, FALSE);
+  Elapsed = RunBenchmark ();
+  UT_LOG_INFO (
+    "Free lists: %d allocations and frees in %d us, %d pages at most\n",
+    TEST_BENCHMARK_ROUNDS,
+    (INT32)Elapsed,
+    (INT32)mPagesPeak
+    );
+  UT_ASSERT_EQUAL (mPagesInUse, 0);
+
+  PatchPcdSetBool (PcdDxeCorePoolSlab, TRUE);
+  Elapsed = RunBenchmark ();
+  UT_LOG_INFO (
+    "Slabs: %d allocations and frees in %d us, %d pages at most\n",
+    TEST_BENCHMARK_ROUNDS,
+    (INT32)Elapsed,
+    (INT32)mPagesPeak
+    );
+  UT_ASSERT_TRUE (mPagesInUse <= ARRAY_SIZE (mSlabDataSizes));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  pool management of the DXE Core and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PoolTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the DXE Core Pool Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&PoolTests, Framework, "DXE Core Pool Slab Tests", "DxeCore.Pool.Slab", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Pool Slab Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite--------Description------------------------------------Name---------Function-----------------------------------Pre--------Post---------Context-----------
+  //
+  AddTestCase (PoolTests, "Pack small blocks into slab pages", "Pack", SmallBlocksShouldShareSlabPages, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Use the free lists without slabs", "NoSlab", SmallBlocksShouldUseListsWithoutSlabs, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Return the empty pages of every slab", "Return", EverySlabShouldReturnEmptyPages, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Free all the slabs of an OEM pool", "Oem", OemPoolShouldFreeAllSlabs, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Random allocations keep blocks intact", "Stress", RandomAllocationsShouldNotCorruptBlocks, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Benchmark small allocations", "Benchmark", SmallAllocationBenchmark, PoolSetup, PoolCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DxeCorePoolUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DxeCorePoolUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -23,10 +23,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Ppi/RecoveryModule.h>
 #include <Ppi/CapsuleOnDisk.h>
 #include <Ppi/VectorHandoffInfo.h>
+#include <Ppi/MpServices.h>
+#include <Ppi/ExtractGuidedSectionStream.h>
 
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/MemoryAllocationHob.h>
 #include <Guid/FirmwareFileSystem2.h>
+#include <Guid/LzmaDecompress.h>
 
 #include <Library/DebugLib.h>
 #include <Library/PeimEntryPoint.h>
@@ -42,6 +45,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugAgentLib.h>
 #include <Library/PeiServicesTablePointerLib.h>
 #include <Library/PerformanceLib.h>
+#include <Library/SynchronizationLib.h>
 
 #define STACK_SIZE      0x20000
 #define BSP_STORE_SIZE  0x4000
@@ -227,4 +231,53 @@ Decompress (
   OUT       UINTN                    *OutputSize
   );
 
+/**
+   Decodes a LZMA multi-stream GUIDed section with its streams spread over the APs.
+
+   @param  InputSection          Points to the LZMA multi-stream GUIDed section.
+   @param  OutputBuffer          Points to the buffer that receives the decoded data.
+   @param  OutputBufferSize      Size, in bytes, of the decoded data.
+   @param  AuthenticationStatus  Holds the returned authentication status.
+
+   @retval EFI_SUCCESS           The section was decoded into OutputBuffer.
+   @retval EFI_UNSUPPORTED       The section can not be decoded on the APs, it
+                                 has to be decoded sequentially.
+   @retval Others                The streams could not be decoded on the APs.
+
+**/
+EFI_STATUS
+DecodeMultiStreamSectionOnAps (
+  IN  CONST VOID  *InputSection,
+  IN  VOID        *OutputBuffer,
+  IN  UINT32      OutputBufferSize,
+  OUT UINT32      *AuthenticationStatus
+  );
+
+/**
+   Decodes a GUIDed section on an AP while another AP reads the section data.
+
+   @param  InputSection          Points to the GUIDed section.
+   @param  OutputBuffer          Points to the buffer that receives the decoded data.
+   @param  OutputBufferSize      Size, in bytes, of the decoded data.
+   @param  ScratchBuffer         Points to the scratch buffer of the section, as
+                                 sized by ExtractGuidedSectionGetInfo().
+   @param  ScratchBufferSize     Size, in bytes, of ScratchBuffer.
+   @param  AuthenticationStatus  Holds the returned authentication status.
+
+   @retval EFI_SUCCESS           The section was decoded into OutputBuffer.
+   @retval EFI_UNSUPPORTED       The section can not be decoded on the APs, it
+                                 has to be decoded by the registered handler.
+   @retval Others                The section could not be decoded on the APs.
+
+**/
+EFI_STATUS
+DecodeStreamSectionOnAps (
+  IN  CONST VOID  *InputSection,
+  IN  VOID        *OutputBuffer,
+  IN  UINT32      OutputBufferSize,
+  IN  VOID        *ScratchBuffer,
+  IN  UINT32      ScratchBufferSize,
+  OUT UINT32      *AuthenticationStatus
+  );
+
 #endif
@@ -601,16 +601,6 @@ CustomGuidedSectionExtract (
     return Status;
   }
 
-  if (ScratchBufferSize != 0) {
-    //
-    // Allocate scratch buffer
-    //
-    ScratchBuffer = AllocatePages (EFI_SIZE_TO_PAGES (ScratchBufferSize));
-    if (ScratchBuffer == NULL) {
-      return EFI_OUT_OF_RESOURCES;
-    }
-  }
-
   if (((SectionAttribute & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) != 0) && (OutputBufferSize > 0)) {
     //
     // Allocate output buffer
@@ -621,6 +611,57 @@ CustomGuidedSectionExtract (
     }
 
     DEBUG ((DEBUG_INFO, "Customized Guided section Memory Size required is 0x%x and address is 0x%p\n", OutputBufferSize, *OutputBuffer));
+
+    //
+    // The streams of a LZMA multi-stream section are decoded on the APs when
+    // there are any, and sequentially by the registered handler otherwise.
+    //
+    Status = DecodeMultiStreamSectionOnAps (
+               InputSection,
+               *OutputBuffer,
+               OutputBufferSize,
+               AuthenticationStatus
+               );
+    if (!EFI_ERROR (Status)) {
+      *OutputSize = (UINTN)OutputBufferSize;
+      return EFI_SUCCESS;
+    }
+
+    if (ScratchBufferSize != 0) {
+      ScratchBuffer = AllocatePages (EFI_SIZE_TO_PAGES (ScratchBufferSize));
+      if (ScratchBuffer == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+
+    //
+    // Sections with a stream decode handler are decoded on an AP while another
+    // AP reads the next chunks of the section data. The handler decodes into the
+    // output buffer with the same scratch buffer as the registered handler, so
+    // that one is kept for the fallback.
+    //
+    Status = DecodeStreamSectionOnAps (
+               InputSection,
+               *OutputBuffer,
+               OutputBufferSize,
+               ScratchBuffer,
+               ScratchBufferSize,
+               AuthenticationStatus
+               );
+    if (!EFI_ERROR (Status)) {
+      *OutputSize = (UINTN)OutputBufferSize;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if ((ScratchBufferSize != 0) && (ScratchBuffer == NULL)) {
+    //
+    // Allocate scratch buffer
+    //
+    ScratchBuffer = AllocatePages (EFI_SIZE_TO_PAGES (ScratchBufferSize));
+    if (ScratchBuffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
 
   Status = ExtractGuidedSectionDecode (
@@ -0,0 +1,267 @@
+/** @file
+  Decodes the streams of LZMA multi-stream GUIDed sections on the APs.
+
+  The streams of a multi-stream section are independent LZMA GUIDed sections,
+  so the handler registered for LZMA_CUSTOM_DECOMPRESS_GUID can decode them on
+  several processors at once. The APs take the streams one after the other
+  from a shared counter, so a slow stream does not hold back the others.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeIpl.h"
+
+typedef struct {
+  CONST LZMA_MULTI_STREAM_HEADER           *Header;
+  UINT8                                    *OutputBuffer;
+  UINT8                                    *ScratchBuffer;
+  UINT32                                   ScratchBufferSize;
+  EXTRACT_GUIDED_SECTION_DECODE_HANDLER    DecodeHandler;
+  volatile UINT32                          NextStream;
+  volatile UINT32                          WorkerCount;
+  volatile UINT32                          FailedCount;
+} MULTI_STREAM_DECODE_CONTEXT;
+
+/**
+   Gets a stream of a LZMA multi-stream section and checks its bounds.
+
+   @param  Header      Points to the header of the multi-stream data.
+   @param  DataSize    Size, in bytes, of the multi-stream data.
+   @param  Index       Index of the stream.
+
+   @return The LZMA GUIDed section of the stream, or NULL if it is not within
+           the multi-stream data.
+
+**/
+STATIC
+CONST VOID *
+GetMultiStreamSectionStream (
+  IN CONST LZMA_MULTI_STREAM_HEADER  *Header,
+  IN UINT32                          DataSize,
+  IN UINT32                          Index
+  )
+{
+  UINT32      Offset;
+  CONST VOID  *Stream;
+  UINT32      StreamSize;
+
+  Offset = ((UINT32 *)(Header + 1))[Index];
+  if (((Offset & 0x3) != 0) ||
+      (DataSize < sizeof (EFI_GUID_DEFINED_SECTION2)) ||
+      (Offset > DataSize - sizeof (EFI_GUID_DEFINED_SECTION2)))
+  {
+    return NULL;
+  }
+
+  Stream = (UINT8 *)Header + Offset;
+  if (IS_SECTION2 (Stream)) {
+    StreamSize = SECTION2_SIZE (Stream);
+  } else {
+    StreamSize = SECTION_SIZE (Stream);
+  }
+
+  if (StreamSize > DataSize - Offset) {
+    return NULL;
+  }
+
+  return Stream;
+}
+
+/**
+   Decodes streams of a LZMA multi-stream section until none is left.
+
+   This function runs on the APs, so it must not use any PEI service.
+
+   @param  Buffer  Points to the MULTI_STREAM_DECODE_CONTEXT.
+
+**/
+STATIC
+VOID
+EFIAPI
+DecodeStreamsOnAp (
+  IN OUT VOID  *Buffer
+  )
+{
+  MULTI_STREAM_DECODE_CONTEXT  *Context;
+  CONST UINT32                 *StreamOffset;
+  UINT32                       Index;
+  UINT8                        *ScratchBuffer;
+  VOID                         *Output;
+  UINT32                       AuthenticationStatus;
+  RETURN_STATUS                Status;
+
+  Context      = (MULTI_STREAM_DECODE_CONTEXT *)Buffer;
+  StreamOffset = (CONST UINT32 *)(Context->Header + 1);
+
+  Index = InterlockedIncrement (&Context->NextStream) - 1;
+  if (Index >= Context->Header->StreamCount) {
+    return;
+  }
+
+  //
+  // Only the APs that get a stream take a scratch buffer, so there are never
+  // more workers than streams.
+  //
+  ScratchBuffer = Context->ScratchBuffer +
+                  (UINTN)(InterlockedIncrement (&Context->WorkerCount) - 1) * Context->ScratchBufferSize;
+
+  do {
+    Output = Context->OutputBuffer + (UINTN)Index * Context->Header->StreamSize;
+    Status = Context->DecodeHandler (
+                        (UINT8 *)Context->Header + StreamOffset[Index],
+                        &Output,
+                        ScratchBuffer,
+                        &AuthenticationStatus
+                        );
+    if (RETURN_ERROR (Status)) {
+      InterlockedIncrement (&Context->FailedCount);
+    }
+
+    Index = InterlockedIncrement (&Context->NextStream) - 1;
+  } while (Index < Context->Header->StreamCount);
+}
+
+/**
+   Decodes a LZMA multi-stream GUIDed section with its streams spread over the APs.
+
+   @param  InputSection          Points to the LZMA multi-stream GUIDed section.
+   @param  OutputBuffer          Points to the buffer that receives the decoded data.
+   @param  OutputBufferSize      Size, in bytes, of the decoded data.
+   @param  AuthenticationStatus  Holds the returned authentication status.
+
+   @retval EFI_SUCCESS           The section was decoded into OutputBuffer.
+   @retval EFI_UNSUPPORTED       The section can not be decoded on the APs, it
+                                 has to be decoded sequentially.
+   @retval Others                The streams could not be decoded on the APs.
+
+**/
+EFI_STATUS
+DecodeMultiStreamSectionOnAps (
+  IN  CONST VOID  *InputSection,
+  IN  VOID        *OutputBuffer,
+  IN  UINT32      OutputBufferSize,
+  OUT UINT32      *AuthenticationStatus
+  )
+{
+  EFI_STATUS                               Status;
+  CONST EFI_PEI_SERVICES                   **PeiServices;
+  EFI_PEI_MP_SERVICES_PPI                  *MpServices;
+  UINTN                                    NumberOfProcessors;
+  UINTN                                    NumberOfEnabledProcessors;
+  EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER  GetInfoHandler;
+  CONST LZMA_MULTI_STREAM_HEADER           *Header;
+  UINT32                                   DataSize;
+  UINT32                                   Index;
+  CONST VOID                               *Stream;
+  UINT32                                   StreamOutputSize;
+  UINT32                                   StreamScratchSize;
+  UINT16                                   StreamAttribute;
+  UINTN                                    WorkerCount;
+  MULTI_STREAM_DECODE_CONTEXT              Context;
+
+  if (IS_SECTION2 (InputSection)) {
+    if (!CompareGuid (&gLzmaMultiStreamCustomDecompressGuid, &((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid)) {
+      return EFI_UNSUPPORTED;
+    }
+
+    Header   = (LZMA_MULTI_STREAM_HEADER *)((UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset);
+    DataSize = SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset;
+  } else {
+    if (!CompareGuid (&gLzmaMultiStreamCustomDecompressGuid, &((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid)) {
+      return EFI_UNSUPPORTED;
+    }
+
+    Header   = (LZMA_MULTI_STREAM_HEADER *)((UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset);
+    DataSize = SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset;
+  }
+
+  //
+  // The multi-stream handler validated the header when it returned the size of
+  // the section, here it only matters that there is something to spread.
+  //
+  if ((Header->StreamCount < 2) || (Header->DecodedSize != OutputBufferSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  PeiServices = GetPeiServicesTablePointer ();
+  Status      = PeiServicesLocatePpi (&gEfiPeiMpServicesPpiGuid, 0, NULL, (VOID **)&MpServices);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = MpServices->GetNumberOfProcessors (PeiServices, MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status) || (NumberOfEnabledProcessors < 2)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = ExtractGuidedSectionGetHandlers (&gLzmaCustomDecompressGuid, &GetInfoHandler, &Context.DecodeHandler);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Check all the streams on the BSP, the APs only decode them.
+  //
+  Context.ScratchBufferSize = 0;
+  for (Index = 0; Index < Header->StreamCount; Index++) {
+    Stream = GetMultiStreamSectionStream (Header, DataSize, Index);
+    if (Stream == NULL) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Status = GetInfoHandler (Stream, &StreamOutputSize, &StreamScratchSize, &StreamAttribute);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (StreamOutputSize != MIN (Header->StreamSize, Header->DecodedSize - Index * Header->StreamSize)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Context.ScratchBufferSize = MAX (Context.ScratchBufferSize, ALIGN_VALUE (StreamScratchSize, sizeof (UINT64)));
+  }
+
+  WorkerCount           = MIN (NumberOfEnabledProcessors - 1, Header->StreamCount);
+  Context.ScratchBuffer = AllocatePages (EFI_SIZE_TO_PAGES (WorkerCount * Context.ScratchBufferSize));
+  if (Context.ScratchBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Context.Header       = Header;
+  Context.OutputBuffer = OutputBuffer;
+  Context.NextStream   = 0;
+  Context.WorkerCount  = 0;
+  Context.FailedCount  = 0;
+
+  //
+  // StartupAllAPs() of EFI_PEI_MP_SERVICES_PPI blocks the BSP until the APs
+  // are done, so the BSP does not decode any stream. Running the procedure on
+  // the BSP too needs StartupAllCPUs() of EDKII_PEI_MP_SERVICES2_PPI, which is
+  // only defined by UefiCpuPkg.
+  //
+  PERF_INMODULE_BEGIN ("LzmaMultiStreamDecode");
+  Status = MpServices->StartupAllAPs (PeiServices, MpServices, DecodeStreamsOnAp, FALSE, 0, &Context);
+  PERF_INMODULE_END ("LzmaMultiStreamDecode");
+
+  FreePages (Context.ScratchBuffer, EFI_SIZE_TO_PAGES (WorkerCount * Context.ScratchBufferSize));
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Decoding LZMA streams on the APs failed - %r\n", Status));
+    return Status;
+  }
+
+  if ((Context.NextStream < Header->StreamCount) || (Context.FailedCount != 0)) {
+    DEBUG ((DEBUG_ERROR, "%d of %d LZMA streams failed to decode\n", Context.FailedCount, Header->StreamCount));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  DEBUG ((DEBUG_INFO, "Decoded %d LZMA streams on %d APs\n", Header->StreamCount, Context.WorkerCount));
+
+  //
+  // Authentication is set to Zero, which may be ignored.
+  //
+  *AuthenticationStatus = 0;
+  return EFI_SUCCESS;
+}
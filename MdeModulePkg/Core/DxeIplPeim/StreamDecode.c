@@ -0,0 +1,347 @@
+/** @file
+  Decodes GUIDed sections on an AP while another AP reads the section data.
+
+  The compressed data of a GUIDed section is usually read from flash, which is
+  much slower than memory. When a stream decode handler is registered for the
+  section GUID, one AP copies the section data into a small ring of pages while
+  another AP decodes the pages that are already there, so the reads overlap
+  with the decode instead of the decoder waiting on every flash access. The
+  handler decodes straight into the output buffer, so it only needs the scratch
+  buffer of the regular handler and the decoded data is never copied.
+
+  The stream decode handlers are registered by the opt-in stream instances of the
+  custom decompress libraries, such as LzmaStreamCustomDecompressLib, and found
+  through EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeIpl.h"
+
+#define STREAM_DECODE_CHUNK_SIZE   SIZE_64KB
+#define STREAM_DECODE_CHUNK_COUNT  4
+
+#define STREAM_DECODE_ROLE_READ    0
+#define STREAM_DECODE_ROLE_DECODE  1
+
+typedef struct {
+  CONST UINT8                                     *Data;
+  UINT32                                          DataSize;
+  UINT32                                          ChunkCount;
+  UINT8                                           *Ring;
+  CONST VOID                                      *InputSection;
+  VOID                                            *OutputBuffer;
+  VOID                                            *ScratchBuffer;
+  UINT32                                          ScratchBufferSize;
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler;
+  RETURN_STATUS                                   DecodeStatus;
+  UINT32                                          AuthenticationStatus;
+  UINT32                                          NextChunk;
+  volatile UINT32                                 NextRole;
+  volatile UINT32                                 ChunksRead;
+  volatile UINT32                                 ChunksReleased;
+  volatile UINT32                                 DecodeDone;
+} STREAM_DECODE_CONTEXT;
+
+/**
+   Copies the section data into the ring, one chunk after the other.
+
+   A chunk is only overwritten once the decoder has released it, and the copy
+   stops as soon as the decoder is done.
+
+   @param  Context     Points to the STREAM_DECODE_CONTEXT.
+
+**/
+STATIC
+VOID
+ReadChunks (
+  IN OUT STREAM_DECODE_CONTEXT  *Context
+  )
+{
+  UINT32  Index;
+  UINT32  Offset;
+
+  for (Index = 0; Index < Context->ChunkCount; Index++) {
+    while ((Index - Context->ChunksReleased >= STREAM_DECODE_CHUNK_COUNT) && (Context->DecodeDone == 0)) {
+      CpuPause ();
+    }
+
+    if (Context->DecodeDone != 0) {
+      return;
+    }
+
+    Offset = Index * STREAM_DECODE_CHUNK_SIZE;
+    CopyMem (
+      Context->Ring + (Index % STREAM_DECODE_CHUNK_COUNT) * STREAM_DECODE_CHUNK_SIZE,
+      Context->Data + Offset,
+      MIN (STREAM_DECODE_CHUNK_SIZE, Context->DataSize - Offset)
+      );
+    InterlockedIncrement (&Context->ChunksRead);
+  }
+}
+
+/**
+   Gets the next chunk of the section data for the stream decode handler.
+
+   Asking for the next chunk releases the previous one, as the decoder does
+   not use it anymore.
+
+   @param  Context     Points to the STREAM_DECODE_CONTEXT.
+   @param  Buffer      Holds the returned pointer to the next chunk.
+   @param  Size        Holds the returned size of the next chunk, 0 after the last one.
+
+   @retval RETURN_SUCCESS  The next chunk was returned.
+
+**/
+STATIC
+RETURN_STATUS
+EFIAPI
+GetNextChunk (
+  IN  VOID        *Context,
+  OUT CONST VOID  **Buffer,
+  OUT UINTN       *Size
+  )
+{
+  STREAM_DECODE_CONTEXT  *StreamContext;
+  UINT32                 Index;
+  UINT32                 Offset;
+
+  StreamContext = (STREAM_DECODE_CONTEXT *)Context;
+  Index         = StreamContext->NextChunk;
+
+  if ((Index > 0) && (Index <= StreamContext->ChunkCount)) {
+    InterlockedIncrement (&StreamContext->ChunksReleased);
+  }
+
+  if (Index >= StreamContext->ChunkCount) {
+    StreamContext->NextChunk = StreamContext->ChunkCount + 1;
+    *Buffer                  = NULL;
+    *Size                    = 0;
+    return RETURN_SUCCESS;
+  }
+
+  while (StreamContext->ChunksRead <= Index) {
+    CpuPause ();
+  }
+
+  MemoryFence ();
+
+  Offset                   = Index * STREAM_DECODE_CHUNK_SIZE;
+  StreamContext->NextChunk = Index + 1;
+  *Buffer                  = StreamContext->Ring + (Index % STREAM_DECODE_CHUNK_COUNT) * STREAM_DECODE_CHUNK_SIZE;
+  *Size                    = MIN (STREAM_DECODE_CHUNK_SIZE, StreamContext->DataSize - Offset);
+  return RETURN_SUCCESS;
+}
+
+/**
+   Reads or decodes the section data, depending on the order the APs start in.
+
+   The first AP reads the section data and the second one decodes it, the
+   other APs return at once. This function runs on the APs, so it must not use
+   any PEI service.
+
+   @param  Buffer  Points to the STREAM_DECODE_CONTEXT.
+
+**/
+STATIC
+VOID
+EFIAPI
+StreamDecodeOnAp (
+  IN OUT VOID  *Buffer
+  )
+{
+  STREAM_DECODE_CONTEXT  *Context;
+  UINT32                 Role;
+
+  Context = (STREAM_DECODE_CONTEXT *)Buffer;
+  Role    = InterlockedIncrement (&Context->NextRole) - 1;
+
+  if (Role == STREAM_DECODE_ROLE_READ) {
+    ReadChunks (Context);
+  } else if (Role == STREAM_DECODE_ROLE_DECODE) {
+    Context->DecodeStatus = Context->StreamDecodeHandler (
+                                       Context->InputSection,
+                                       GetNextChunk,
+                                       NULL,
+                                       Context,
+                                       Context->OutputBuffer,
+                                       Context->ScratchBuffer,
+                                       Context->ScratchBufferSize,
+                                       &Context->AuthenticationStatus
+                                       );
+    InterlockedIncrement (&Context->DecodeDone);
+  }
+}
+
+/**
+   Retrieves the stream decode handlers of a GUIDed section type from the
+   EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI instances.
+
+   @param  SectionGuid           Points to the GUID of the GUIDed section type.
+   @param  StreamGetInfoHandler  Returns the handler that examines a section of the type.
+   @param  StreamDecodeHandler   Returns the handler that decodes a section of the type.
+
+   @retval EFI_SUCCESS           The handlers were retrieved.
+   @retval EFI_NOT_FOUND         No stream decode handler is registered for SectionGuid.
+
+**/
+STATIC
+EFI_STATUS
+GetStreamHandler (
+  IN  CONST GUID                                      *SectionGuid,
+  OUT EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  *StreamGetInfoHandler,
+  OUT EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    *StreamDecodeHandler
+  )
+{
+  EFI_STATUS                                   Status;
+  UINTN                                        Instance;
+  EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI  *StreamPpi;
+
+  //
+  // Every PEIM that registers stream decode handlers installs an instance.
+  //
+  for (Instance = 0; ; Instance++) {
+    Status = PeiServicesLocatePpi (&gEdkiiPeiExtractGuidedSectionStreamPpiGuid, Instance, NULL, (VOID **)&StreamPpi);
+    if (EFI_ERROR (Status)) {
+      return EFI_NOT_FOUND;
+    }
+
+    Status = StreamPpi->GetStreamHandler (SectionGuid, StreamGetInfoHandler, StreamDecodeHandler);
+    if (!EFI_ERROR (Status)) {
+      return EFI_SUCCESS;
+    }
+  }
+}
+
+/**
+   Decodes a GUIDed section on an AP while another AP reads the section data.
+
+   @param  InputSection          Points to the GUIDed section.
+   @param  OutputBuffer          Points to the buffer that receives the decoded data.
+   @param  OutputBufferSize      Size, in bytes, of the decoded data.
+   @param  ScratchBuffer         Points to the scratch buffer of the section, as
+                                 sized by ExtractGuidedSectionGetInfo().
+   @param  ScratchBufferSize     Size, in bytes, of ScratchBuffer.
+   @param  AuthenticationStatus  Holds the returned authentication status.
+
+   @retval EFI_SUCCESS           The section was decoded into OutputBuffer.
+   @retval EFI_UNSUPPORTED       The section can not be decoded on the APs, it
+                                 has to be decoded by the registered handler.
+   @retval Others                The section could not be decoded on the APs.
+
+**/
+EFI_STATUS
+DecodeStreamSectionOnAps (
+  IN  CONST VOID  *InputSection,
+  IN  VOID        *OutputBuffer,
+  IN  UINT32      OutputBufferSize,
+  IN  VOID        *ScratchBuffer,
+  IN  UINT32      ScratchBufferSize,
+  OUT UINT32      *AuthenticationStatus
+  )
+{
+  EFI_STATUS                                      Status;
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler;
+  UINT32                                          DecodedSize;
+  UINT32                                          WindowBufferSize;
+  UINT16                                          SectionAttribute;
+  CONST EFI_PEI_SERVICES                          **PeiServices;
+  EFI_PEI_MP_SERVICES_PPI                         *MpServices;
+  UINTN                                           NumberOfProcessors;
+  UINTN                                           NumberOfEnabledProcessors;
+  CONST GUID                                      *SectionDefinitionGuid;
+  UINT32                                          SectionSize;
+  UINT32                                          DataOffset;
+  STREAM_DECODE_CONTEXT                           Context;
+
+  if (IS_SECTION2 (InputSection)) {
+    SectionDefinitionGuid = &((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid;
+    SectionSize           = SECTION2_SIZE (InputSection);
+    DataOffset            = ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset;
+  } else {
+    SectionDefinitionGuid = &((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid;
+    SectionSize           = SECTION_SIZE (InputSection);
+    DataOffset            = ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset;
+  }
+
+  //
+  // The reads can only overlap with the decode when there is more than one chunk.
+  //
+  if ((DataOffset > SectionSize) || (SectionSize - DataOffset <= STREAM_DECODE_CHUNK_SIZE)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (ScratchBuffer == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = GetStreamHandler (SectionDefinitionGuid, &StreamGetInfoHandler, &Context.StreamDecodeHandler);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // The window buffer is only needed to decode without an output buffer.
+  //
+  Status = StreamGetInfoHandler (InputSection, &DecodedSize, &WindowBufferSize, &SectionAttribute);
+  if (EFI_ERROR (Status) || (DecodedSize != OutputBufferSize)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  PeiServices = GetPeiServicesTablePointer ();
+  Status      = PeiServicesLocatePpi (&gEfiPeiMpServicesPpiGuid, 0, NULL, (VOID **)&MpServices);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // The BSP waits for the APs, so it takes two of them to read and decode at once.
+  //
+  Status = MpServices->GetNumberOfProcessors (PeiServices, MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status) || (NumberOfEnabledProcessors < 3)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Context.Ring = AllocatePages (EFI_SIZE_TO_PAGES (STREAM_DECODE_CHUNK_SIZE * STREAM_DECODE_CHUNK_COUNT));
+  if (Context.Ring == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Context.Data                 = (CONST UINT8 *)InputSection + DataOffset;
+  Context.DataSize             = SectionSize - DataOffset;
+  Context.ChunkCount           = (Context.DataSize + STREAM_DECODE_CHUNK_SIZE - 1) / STREAM_DECODE_CHUNK_SIZE;
+  Context.InputSection         = InputSection;
+  Context.OutputBuffer         = OutputBuffer;
+  Context.ScratchBuffer        = ScratchBuffer;
+  Context.ScratchBufferSize    = ScratchBufferSize;
+  Context.DecodeStatus         = RETURN_ABORTED;
+  Context.AuthenticationStatus = 0;
+  Context.NextChunk            = 0;
+  Context.NextRole             = 0;
+  Context.ChunksRead           = 0;
+  Context.ChunksReleased       = 0;
+  Context.DecodeDone           = 0;
+
+  PERF_INMODULE_BEGIN ("StreamDecode");
+  Status = MpServices->StartupAllAPs (PeiServices, MpServices, StreamDecodeOnAp, FALSE, 0, &Context);
+  PERF_INMODULE_END ("StreamDecode");
+
+  FreePages (Context.Ring, EFI_SIZE_TO_PAGES (STREAM_DECODE_CHUNK_SIZE * STREAM_DECODE_CHUNK_COUNT));
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "Decoding the section on the APs failed - %r\n", Status));
+    return Status;
+  }
+
+  if (RETURN_ERROR (Context.DecodeStatus)) {
+    DEBUG ((DEBUG_ERROR, "Stream decode of %g section failed - %r\n", SectionDefinitionGuid, Context.DecodeStatus));
+    return Context.DecodeStatus;
+  }
+
+  DEBUG ((DEBUG_INFO, "Decoded %g section while reading its %d chunks on the APs\n", SectionDefinitionGuid, Context.ChunkCount));
+
+  *AuthenticationStatus = Context.AuthenticationStatus;
+  return EFI_SUCCESS;
+}
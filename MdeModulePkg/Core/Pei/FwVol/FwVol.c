@@ -243,10 +243,110 @@ FileHandleToVolume (
   return NULL;
 }
 
+/**
+  Search the file index of a FV for the first matching file, as FindFileEx()
+  searches the FV itself.
+
+  @param FileIndex       The file index of the FV.
+  @param FwVolHeader     Pointer to the FV header of the volume to search
+  @param FileName        File name
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHeader      The file to start the search after, or NULL to start
+                         from the first file. Updated to the file found.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has
+
+  @return EFI_NOT_FOUND  No files matching the search criteria were found
+  @retval EFI_SUCCESS    Success to search given file
+
+**/
+STATIC
+EFI_STATUS
+FindFileInIndex (
+  IN        PEI_CORE_FV_FILE_INDEX      *FileIndex,
+  IN        EFI_FIRMWARE_VOLUME_HEADER  *FwVolHeader,
+  IN  CONST EFI_GUID                    *FileName    OPTIONAL,
+  IN        EFI_FV_FILETYPE             SearchType,
+  IN OUT    EFI_FFS_FILE_HEADER         **FileHeader,
+  IN OUT    EFI_PEI_FILE_HANDLE         *AprioriFile  OPTIONAL
+  )
+{
+  PEI_CORE_FV_FILE_INDEX_ENTRY  *Entries;
+  UINTN                         Index;
+  UINTN                         High;
+  UINTN                         Middle;
+  UINT32                        Offset;
+  EFI_FV_FILETYPE               Type;
+
+  Entries = (PEI_CORE_FV_FILE_INDEX_ENTRY *)(FileIndex + 1);
+
+  if (FileName != NULL) {
+    for (Index = 0; Index < FileIndex->FileCount; Index++) {
+      if (CompareGuid (&Entries[Index].Name, FileName)) {
+        *FileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FwVolHeader + Entries[Index].Offset);
+        return EFI_SUCCESS;
+      }
+    }
+
+    *FileHeader = NULL;
+    return EFI_NOT_FOUND;
+  }
+
+  if ((SearchType != EFI_FV_FILETYPE_ALL) &&
+      (SearchType != PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE) &&
+      ((FileIndex->TypeBitmap[SearchType / 32] & (1u << (SearchType % 32))) == 0))
+  {
+    *FileHeader = NULL;
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Start with the first file after FileHeader
+  //
+  Index = 0;
+  if (*FileHeader != NULL) {
+    Offset = (UINT32)((UINTN)*FileHeader - (UINTN)FwVolHeader);
+    High   = FileIndex->FileCount;
+    while (Index < High) {
+      Middle = (Index + High) / 2;
+      if (Entries[Middle].Offset <= Offset) {
+        Index = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+  }
+
+  for ( ; Index < FileIndex->FileCount; Index++) {
+    Type = Entries[Index].Type;
+    if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE) {
+      if ((Type == EFI_FV_FILETYPE_PEIM) ||
+          (Type == EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER) ||
+          (Type == EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE))
+      {
+        *FileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FwVolHeader + Entries[Index].Offset);
+        return EFI_SUCCESS;
+      } else if ((AprioriFile != NULL) && (Type == EFI_FV_FILETYPE_FREEFORM)) {
+        if (CompareGuid (&Entries[Index].Name, &gPeiAprioriFileNameGuid)) {
+          *AprioriFile = (EFI_PEI_FILE_HANDLE)((UINT8 *)FwVolHeader + Entries[Index].Offset);
+        }
+      }
+    } else if (((SearchType == Type) || (SearchType == EFI_FV_FILETYPE_ALL)) &&
+               (Type != EFI_FV_FILETYPE_FFS_PAD))
+    {
+      *FileHeader = (EFI_FFS_FILE_HEADER *)((UINT8 *)FwVolHeader + Entries[Index].Offset);
+      return EFI_SUCCESS;
+    }
+  }
+
+  *FileHeader = NULL;
+  return EFI_NOT_FOUND;
+}
+
 /**
   Given the input file pointer, search for the first matching file in the
-  FFS volume as defined by SearchType. The search starts from FileHeader inside
-  the Firmware Volume defined by FwVolHeader.
+  FFS volume as defined by SearchType, by walking the FFS file headers. The
+  search starts from FileHeader inside the Firmware Volume defined by FwVolHeader.
   If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
   If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
   the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
@@ -255,6 +355,7 @@ FileHandleToVolume (
   @param FileName        File name
   @param SearchType      Filter to find only files of this type.
                          Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param IncludePadFiles TRUE to also return pad files when SearchType is EFI_FV_FILETYPE_ALL.
   @param FileHandle      This parameter must point to a valid FFS volume.
   @param AprioriFile     Pointer to AprioriFile image in this FV if has
 
@@ -262,11 +363,13 @@ FileHandleToVolume (
   @retval EFI_SUCCESS    Success to search given file
 
 **/
+STATIC
 EFI_STATUS
-FindFileEx (
+FindFileInFv (
   IN  CONST EFI_PEI_FV_HANDLE    FvHandle,
   IN  CONST EFI_GUID             *FileName    OPTIONAL,
   IN        EFI_FV_FILETYPE      SearchType,
+  IN        BOOLEAN              IncludePadFiles,
   IN OUT    EFI_PEI_FILE_HANDLE  *FileHandle,
   IN OUT    EFI_PEI_FILE_HANDLE  *AprioriFile  OPTIONAL
   )
@@ -418,7 +521,7 @@ FindFileEx (
             }
           }
         } else if (((SearchType == FfsFileHeader->Type) || (SearchType == EFI_FV_FILETYPE_ALL)) &&
-                   (FfsFileHeader->Type != EFI_FV_FILETYPE_FFS_PAD))
+                   ((FfsFileHeader->Type != EFI_FV_FILETYPE_FFS_PAD) || IncludePadFiles))
         {
           *FileHeader = FfsFileHeader;
           return EFI_SUCCESS;
@@ -455,6 +558,110 @@ FindFileEx (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Given the input file pointer, search for the first matching file in the
+  FFS volume as defined by SearchType. The search starts from FileHeader inside
+  the Firmware Volume defined by FwVolHeader.
+  If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
+  If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
+  the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
+  If the FV has a file index, the index is searched instead of the FV.
+
+  @param FvHandle        Pointer to the FV header of the volume to search
+  @param FileName        File name
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      This parameter must point to a valid FFS volume.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has
+
+  @return EFI_NOT_FOUND  No files matching the search criteria were found
+  @retval EFI_SUCCESS    Success to search given file
+
+**/
+EFI_STATUS
+FindFileEx (
+  IN  CONST EFI_PEI_FV_HANDLE    FvHandle,
+  IN  CONST EFI_GUID             *FileName    OPTIONAL,
+  IN        EFI_FV_FILETYPE      SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE  *FileHandle,
+  IN OUT    EFI_PEI_FILE_HANDLE  *AprioriFile  OPTIONAL
+  )
+{
+  PEI_CORE_FV_HANDLE  *CoreFvHandle;
+
+  CoreFvHandle = FvHandleToCoreHandle (FvHandle);
+  if ((CoreFvHandle != NULL) && (CoreFvHandle->FileIndex != NULL)) {
+    return FindFileInIndex (
+             CoreFvHandle->FileIndex,
+             (EFI_FIRMWARE_VOLUME_HEADER *)FvHandle,
+             FileName,
+             SearchType,
+             (EFI_FFS_FILE_HEADER **)FileHandle,
+             AprioriFile
+             );
+  }
+
+  return FindFileInFv (FvHandle, FileName, SearchType, FALSE, FileHandle, AprioriFile);
+}
+
+/**
+  Build the index of the files of a FV handled by the build-in FV_PPI, so that
+  FindFileEx() searches the index instead of walking the FFS file headers.
+
+  The index is allocated from the PEI core heap and is private to the PEI core.
+  The FV is walked twice: to count its files and to record them. Nothing is
+  built if the FV is handled by another FV_PPI or if the index cannot be
+  allocated.
+
+  @param CoreFvHandle    The PEI_CORE_FV_HANDLE of the FV.
+
+**/
+VOID
+PeiBuildFvFileIndex (
+  IN OUT PEI_CORE_FV_HANDLE  *CoreFvHandle
+  )
+{
+  PEI_CORE_FV_FILE_INDEX        *FileIndex;
+  PEI_CORE_FV_FILE_INDEX_ENTRY  *Entry;
+  EFI_PEI_FILE_HANDLE           FileHandle;
+  EFI_FFS_FILE_HEADER           *FfsFileHeader;
+  UINTN                         FileCount;
+
+  if ((CoreFvHandle->FileIndex != NULL) ||
+      ((CoreFvHandle->FvPpi != &mPeiFfs2FwVol.Fv) && (CoreFvHandle->FvPpi != &mPeiFfs3FwVol.Fv)))
+  {
+    return;
+  }
+
+  FileCount  = 0;
+  FileHandle = NULL;
+  while (!EFI_ERROR (FindFileInFv (CoreFvHandle->FvHandle, NULL, EFI_FV_FILETYPE_ALL, TRUE, &FileHandle, NULL))) {
+    FileCount++;
+  }
+
+  FileIndex = AllocateZeroPool (sizeof (PEI_CORE_FV_FILE_INDEX) + FileCount * sizeof (PEI_CORE_FV_FILE_INDEX_ENTRY));
+  if (FileIndex == NULL) {
+    return;
+  }
+
+  Entry      = (PEI_CORE_FV_FILE_INDEX_ENTRY *)(FileIndex + 1);
+  FileHandle = NULL;
+  while ((FileIndex->FileCount < FileCount) &&
+         !EFI_ERROR (FindFileInFv (CoreFvHandle->FvHandle, NULL, EFI_FV_FILETYPE_ALL, TRUE, &FileHandle, NULL)))
+  {
+    FfsFileHeader = (EFI_FFS_FILE_HEADER *)FileHandle;
+    CopyGuid (&Entry->Name, &FfsFileHeader->Name);
+    Entry->Offset = (UINT32)((UINTN)FfsFileHeader - (UINTN)CoreFvHandle->FvHeader);
+    Entry->Type   = FfsFileHeader->Type;
+
+    FileIndex->TypeBitmap[Entry->Type / 32] |= 1u << (Entry->Type % 32);
+    FileIndex->FileCount++;
+    Entry++;
+  }
+
+  CoreFvHandle->FileIndex = FileIndex;
+}
+
 /**
   Initialize PeiCore FV List.
 
@@ -525,6 +732,7 @@ PeiInitializeFv (
     (UINT32)BfvHeader->FvLength,
     FvHandle
     ));
+  PeiBuildFvFileIndex (&PrivateData->Fv[PrivateData->FvCount]);
   PrivateData->FvCount++;
 
   //
@@ -667,6 +875,7 @@ FirmwareVolumeInfoPpiNotifyCallback (
       FvInfo2Ppi.FvInfoSize,
       FvHandle
       ));
+    PeiBuildFvFileIndex (&PrivateData->Fv[CurFvCount]);
     PrivateData->FvCount++;
 
     //
@@ -274,6 +274,23 @@ FvHandleToCoreHandle (
   IN EFI_PEI_FV_HANDLE  FvHandle
   );
 
+/**
+  Build the index of the files of a FV handled by the build-in FV_PPI, so that
+  FindFileEx() searches the index instead of walking the FFS file headers.
+
+  The index is allocated from the PEI core heap and is private to the PEI core.
+  The FV is walked twice: to count its files and to record them. Nothing is
+  built if the FV is handled by another FV_PPI or if the index cannot be
+  allocated.
+
+  @param CoreFvHandle    The PEI_CORE_FV_HANDLE of the FV.
+
+**/
+VOID
+PeiBuildFvFileIndex (
+  IN OUT PEI_CORE_FV_HANDLE  *CoreFvHandle
+  );
+
 /**
   Given the input file pointer, search for the next matching file in the
   FFS volume as defined by SearchType. The search starts from FileHeader inside
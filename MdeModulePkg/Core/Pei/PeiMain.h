@@ -68,6 +68,33 @@ typedef union {
 #define CALLBACK_NOTIFY_GROWTH_STEP  32
 #define DISPATCH_NOTIFY_GROWTH_STEP  8
 
+///
+/// Number of buckets in the GUID hash index of a PPI or notify list.
+/// It must be a power of two.
+///
+#define PPI_HASH_BUCKET_COUNT  32
+///
+/// Number of list entries, starting from the first one, that the GUID hash
+/// index covers. Entries beyond it are searched linearly.
+///
+#define PPI_HASH_INDEX_CAPACITY  255
+
+///
+/// Fixed-capacity GUID hash index of a PPI or notify list.
+/// The chains hold list indexes plus one, so that a zeroed index is empty and
+/// the index stays valid when the list and its descriptors are migrated.
+/// Each chain is kept in ascending list order.
+///
+typedef struct {
+  ///
+  /// Number of list entries linked into the index.
+  ///
+  UINTN    Count;
+  UINT8    Head[PPI_HASH_BUCKET_COUNT];
+  UINT8    Tail[PPI_HASH_BUCKET_COUNT];
+  UINT8    Next[PPI_HASH_INDEX_CAPACITY];
+} PEI_PPI_HASH_INDEX;
+
 typedef struct {
   UINTN                    CurrentCount;
   UINTN                    MaxCount;
@@ -76,6 +103,7 @@ typedef struct {
   /// MaxCount number of entries.
   ///
   PEI_PPI_LIST_POINTERS    *PpiPtrs;
+  PEI_PPI_HASH_INDEX       HashIndex;
 } PEI_PPI_LIST;
 
 typedef struct {
@@ -85,6 +113,7 @@ typedef struct {
   /// MaxCount number of entries.
   ///
   PEI_PPI_LIST_POINTERS    *NotifyPtrs;
+  PEI_PPI_HASH_INDEX       HashIndex;
 } PEI_CALLBACK_NOTIFY_LIST;
 
 typedef struct {
@@ -95,6 +124,7 @@ typedef struct {
   /// MaxCount number of entries.
   ///
   PEI_PPI_LIST_POINTERS    *NotifyPtrs;
+  PEI_PPI_HASH_INDEX       HashIndex;
 } PEI_DISPATCH_NOTIFY_LIST;
 
 ///
@@ -114,6 +144,14 @@ typedef struct {
   /// Notify List at callback level.
   ///
   PEI_DISPATCH_NOTIFY_LIST    DispatchNotifyList;
+  ///
+  /// Number of PeiLocatePpi() calls.
+  ///
+  UINTN                       LocateCount;
+  ///
+  /// Number of PPI GUIDs compared by PeiLocatePpi().
+  ///
+  UINTN                       LocateCompareCount;
 } PEI_PPI_DATABASE;
 
 //
@@ -131,6 +169,31 @@ typedef struct {
 //
 #define FV_GROWTH_STEP  8
 
+///
+/// One valid, not deleted FFS file of a FV, pad files included.
+///
+typedef struct {
+  EFI_GUID           Name;
+  //
+  // Offset of the FFS file header from the FV header.
+  //
+  UINT32             Offset;
+  EFI_FV_FILETYPE    Type;
+} PEI_CORE_FV_FILE_INDEX_ENTRY;
+
+///
+/// Index of the FFS files of a FV, followed by FileCount entries in the order
+/// of the files in the FV.
+///
+typedef struct {
+  //
+  // Bit (Type % 32) of TypeBitmap[Type / 32] is set if the FV holds a file of
+  // that type.
+  //
+  UINT32    TypeBitmap[8];
+  UINTN     FileCount;
+} PEI_CORE_FV_FILE_INDEX;
+
 typedef struct {
   EFI_FIRMWARE_VOLUME_HEADER     *FvHeader;
   EFI_PEI_FIRMWARE_VOLUME_PPI    *FvPpi;
@@ -146,6 +209,10 @@ typedef struct {
   EFI_PEI_FILE_HANDLE            *FvFileHandles;
   BOOLEAN                        ScanFv;
   UINT32                         AuthenticationStatus;
+  //
+  // Pointer to the index of the files of the FV, or NULL.
+  //
+  PEI_CORE_FV_FILE_INDEX         *FileIndex;
 } PEI_CORE_FV_HANDLE;
 
 typedef struct {
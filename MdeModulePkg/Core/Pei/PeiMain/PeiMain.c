@@ -236,6 +236,10 @@ PeiCore (
           if (OldCoreData->Fv[Index].FvFileHandles != NULL) {
             OldCoreData->Fv[Index].FvFileHandles = (EFI_PEI_FILE_HANDLE *)((UINT8 *)OldCoreData->Fv[Index].FvFileHandles + OldCoreData->HeapOffset);
           }
+
+          if (OldCoreData->Fv[Index].FileIndex != NULL) {
+            OldCoreData->Fv[Index].FileIndex = (PEI_CORE_FV_FILE_INDEX *)((UINT8 *)OldCoreData->Fv[Index].FileIndex + OldCoreData->HeapOffset);
+          }
         }
 
         OldCoreData->TempFileGuid    = (EFI_GUID *)((UINT8 *)OldCoreData->TempFileGuid + OldCoreData->HeapOffset);
@@ -271,6 +275,10 @@ PeiCore (
           if (OldCoreData->Fv[Index].FvFileHandles != NULL) {
             OldCoreData->Fv[Index].FvFileHandles = (EFI_PEI_FILE_HANDLE *)((UINT8 *)OldCoreData->Fv[Index].FvFileHandles - OldCoreData->HeapOffset);
           }
+
+          if (OldCoreData->Fv[Index].FileIndex != NULL) {
+            OldCoreData->Fv[Index].FileIndex = (PEI_CORE_FV_FILE_INDEX *)((UINT8 *)OldCoreData->Fv[Index].FileIndex - OldCoreData->HeapOffset);
+          }
         }
 
         OldCoreData->TempFileGuid    = (EFI_GUID *)((UINT8 *)OldCoreData->TempFileGuid - OldCoreData->HeapOffset);
@@ -525,6 +533,13 @@ PeiCore (
   //
   // Enter DxeIpl to load Dxe core.
   //
+  DEBUG ((
+    DEBUG_INFO,
+    "PPI database: %Lu PPIs, %Lu locates, %Lu GUID compares\n",
+    (UINT64)PrivateData.PpiData.PpiList.CurrentCount,
+    (UINT64)PrivateData.PpiData.LocateCount,
+    (UINT64)PrivateData.PpiData.LocateCompareCount
+    ));
   DEBUG ((DEBUG_INFO, "DXE IPL Entry\n"));
   Status = TempPtr.DxeIpl->Entry (
                              TempPtr.DxeIpl,
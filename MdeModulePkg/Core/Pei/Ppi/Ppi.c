@@ -427,6 +427,140 @@ DumpPpiList (
   DEBUG_CODE_END ();
 }
 
+/**
+  Compute the GUID hash index bucket of a GUID.
+
+  @param Guid  Pointer to the GUID.
+
+  @return The bucket of the GUID.
+
+**/
+STATIC
+UINTN
+PpiGuidHash (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32  Value;
+
+  Value  = ((UINT32 *)Guid)[0] ^ ((UINT32 *)Guid)[1] ^ ((UINT32 *)Guid)[2] ^ ((UINT32 *)Guid)[3];
+  Value ^= Value >> 16;
+  Value ^= Value >> 8;
+  return Value & (PPI_HASH_BUCKET_COUNT - 1);
+}
+
+/**
+  Link a list entry into the GUID hash index of the list.
+  Entries must be added in list order. Entries beyond the capacity of the
+  index are not linked and are searched linearly.
+
+  @param HashIndex  Pointer to the GUID hash index.
+  @param ListIndex  Index of the entry in the list.
+  @param Guid       GUID of the entry.
+
+**/
+STATIC
+VOID
+PpiHashIndexAdd (
+  IN OUT PEI_PPI_HASH_INDEX  *HashIndex,
+  IN     UINTN               ListIndex,
+  IN     CONST EFI_GUID      *Guid
+  )
+{
+  UINTN  Bucket;
+
+  if (ListIndex >= PPI_HASH_INDEX_CAPACITY) {
+    return;
+  }
+
+  ASSERT (ListIndex == HashIndex->Count);
+
+  Bucket                     = PpiGuidHash (Guid);
+  HashIndex->Next[ListIndex] = 0;
+  if (HashIndex->Head[Bucket] == 0) {
+    HashIndex->Head[Bucket] = (UINT8)(ListIndex + 1);
+  } else {
+    HashIndex->Next[HashIndex->Tail[Bucket] - 1] = (UINT8)(ListIndex + 1);
+  }
+
+  HashIndex->Tail[Bucket] = (UINT8)(ListIndex + 1);
+  HashIndex->Count        = ListIndex + 1;
+}
+
+/**
+  Rebuild the GUID hash index of the PPI list.
+
+  @param PpiList  Pointer to the PPI list.
+
+**/
+STATIC
+VOID
+PpiHashIndexRebuild (
+  IN OUT PEI_PPI_LIST  *PpiList
+  )
+{
+  UINTN  Index;
+
+  ZeroMem (&PpiList->HashIndex, sizeof (PpiList->HashIndex));
+  for (Index = 0; Index < MIN (PpiList->CurrentCount, PPI_HASH_INDEX_CAPACITY); Index++) {
+    PpiHashIndexAdd (&PpiList->HashIndex, Index, PpiList->PpiPtrs[Index].Ppi->Guid);
+  }
+}
+
+/**
+  Get the first list entry that may have a given GUID.
+
+  @param HashIndex  Pointer to the GUID hash index of the list.
+  @param Guid       Pointer to the GUID.
+
+  @return Index of the first candidate entry in the list.
+
+**/
+STATIC
+UINTN
+PpiHashIndexFirst (
+  IN CONST PEI_PPI_HASH_INDEX  *HashIndex,
+  IN CONST EFI_GUID            *Guid
+  )
+{
+  UINTN  Head;
+
+  Head = HashIndex->Head[PpiGuidHash (Guid)];
+  if (Head == 0) {
+    return HashIndex->Count;
+  }
+
+  return Head - 1;
+}
+
+/**
+  Get the next list entry that may have the same GUID as a given entry.
+  Candidates are returned in ascending list order.
+
+  @param HashIndex  Pointer to the GUID hash index of the list.
+  @param ListIndex  Index of the current candidate entry in the list.
+
+  @return Index of the next candidate entry in the list.
+
+**/
+STATIC
+UINTN
+PpiHashIndexNext (
+  IN CONST PEI_PPI_HASH_INDEX  *HashIndex,
+  IN UINTN                     ListIndex
+  )
+{
+  if (ListIndex >= HashIndex->Count) {
+    return ListIndex + 1;
+  }
+
+  if (HashIndex->Next[ListIndex] == 0) {
+    return HashIndex->Count;
+  }
+
+  return HashIndex->Next[ListIndex] - 1;
+}
+
 /**
 
   This function installs an interface in the PEI PPI database by GUID.
@@ -528,6 +662,10 @@ InternalPeiInstallPpi (
     PpiList++;
   }
 
+  for (Index = LastCount; Index < PpiListPointer->CurrentCount; Index++) {
+    PpiHashIndexAdd (&PpiListPointer->HashIndex, Index, PpiListPointer->PpiPtrs[Index].Ppi->Guid);
+  }
+
   //
   // Process any callback level notifies for newly installed PPIs.
   //
@@ -626,6 +764,16 @@ PeiReInstallPpi (
   DEBUG ((DEBUG_INFO, "Reinstall PPI: %g\n", NewPpi->Guid));
   PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi = (EFI_PEI_PPI_DESCRIPTOR *)NewPpi;
 
+  //
+  // The GUID hash index only has to be rebuilt if the new PPI moves to
+  // another bucket.
+  //
+  if ((Index < PrivateData->PpiData.PpiList.HashIndex.Count) &&
+      (PpiGuidHash (OldPpi->Guid) != PpiGuidHash (NewPpi->Guid)))
+  {
+    PpiHashIndexRebuild (&PrivateData->PpiData.PpiList);
+  }
+
   //
   // Process any callback level notifies for the newly installed PPI.
   //
@@ -668,18 +816,27 @@ PeiLocatePpi (
   )
 {
   PEI_CORE_INSTANCE       *PrivateData;
+  PEI_PPI_LIST            *PpiListPointer;
   UINTN                   Index;
   EFI_GUID                *CheckGuid;
   EFI_PEI_PPI_DESCRIPTOR  *TempPtr;
 
-  PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS (PeiServices);
+  PrivateData    = PEI_CORE_INSTANCE_FROM_PS_THIS (PeiServices);
+  PpiListPointer = &PrivateData->PpiData.PpiList;
+  PrivateData->PpiData.LocateCount++;
 
   //
   // Search the data base for the matching instance of the GUIDed PPI.
+  // The GUID hash index returns the candidates in list order, so the
+  // instance numbering is the same as for a linear search.
   //
-  for (Index = 0; Index < PrivateData->PpiData.PpiList.CurrentCount; Index++) {
-    TempPtr   = PrivateData->PpiData.PpiList.PpiPtrs[Index].Ppi;
+  for (Index = PpiHashIndexFirst (&PpiListPointer->HashIndex, Guid);
+       Index < PpiListPointer->CurrentCount;
+       Index = PpiHashIndexNext (&PpiListPointer->HashIndex, Index))
+  {
+    TempPtr   = PpiListPointer->PpiPtrs[Index].Ppi;
     CheckGuid = TempPtr->Guid;
+    PrivateData->PpiData.LocateCompareCount++;
 
     //
     // Don't use CompareGuid function here for performance reasons.
@@ -840,6 +997,22 @@ InternalPeiNotifyPpi (
     NotifyList++;
   }
 
+  for (CallbackNotifyIndex = LastCallbackNotifyCount; CallbackNotifyIndex < CallbackNotifyListPointer->CurrentCount; CallbackNotifyIndex++) {
+    PpiHashIndexAdd (
+      &CallbackNotifyListPointer->HashIndex,
+      CallbackNotifyIndex,
+      CallbackNotifyListPointer->NotifyPtrs[CallbackNotifyIndex].Notify->Guid
+      );
+  }
+
+  for (DispatchNotifyIndex = LastDispatchNotifyCount; DispatchNotifyIndex < DispatchNotifyListPointer->CurrentCount; DispatchNotifyIndex++) {
+    PpiHashIndexAdd (
+      &DispatchNotifyListPointer->HashIndex,
+      DispatchNotifyIndex,
+      DispatchNotifyListPointer->NotifyPtrs[DispatchNotifyIndex].Notify->Guid
+      );
+  }
+
   //
   // Process any callback level notifies for all previously installed PPIs.
   //
@@ -944,10 +1117,59 @@ ProcessDispatchNotifyList (
   return;
 }
 
+/**
+
+  Call a notify if a PPI has the GUID it is registered for.
+
+  @param PrivateData       PeiCore's private data structure
+  @param NotifyDescriptor  Pointer to the notify descriptor.
+  @param PpiIndex          Index of the PPI in the PPI list.
+
+**/
+STATIC
+VOID
+ProcessNotifyForPpi (
+  IN PEI_CORE_INSTANCE          *PrivateData,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN INTN                       PpiIndex
+  )
+{
+  EFI_GUID  *SearchGuid;
+  EFI_GUID  *CheckGuid;
+
+  CheckGuid  = NotifyDescriptor->Guid;
+  SearchGuid = PrivateData->PpiData.PpiList.PpiPtrs[PpiIndex].Ppi->Guid;
+  //
+  // Don't use CompareGuid function here for performance reasons.
+  // Instead we compare the GUID as INT32 at a time and branch
+  // on the first failed comparison.
+  //
+  if ((((INT32 *)SearchGuid)[0] == ((INT32 *)CheckGuid)[0]) &&
+      (((INT32 *)SearchGuid)[1] == ((INT32 *)CheckGuid)[1]) &&
+      (((INT32 *)SearchGuid)[2] == ((INT32 *)CheckGuid)[2]) &&
+      (((INT32 *)SearchGuid)[3] == ((INT32 *)CheckGuid)[3]))
+  {
+    DEBUG ((
+      DEBUG_INFO,
+      "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
+      SearchGuid,
+      NotifyDescriptor->Notify
+      ));
+    NotifyDescriptor->Notify (
+                        (EFI_PEI_SERVICES **)GetPeiServicesTablePointer (),
+                        NotifyDescriptor,
+                        (PrivateData->PpiData.PpiList.PpiPtrs[PpiIndex].Ppi)->Ppi
+                        );
+  }
+}
+
 /**
 
   Process notifications.
 
+  The notifies are called in notify list order, and for each notify in PPI
+  list order. The GUID hash indexes only skip the entries that cannot match.
+
   @param PrivateData        PeiCore's private data structure
   @param NotifyType         Type of notify to fire.
   @param InstallStartIndex  Install Beginning index.
@@ -968,10 +1190,41 @@ ProcessNotify (
 {
   INTN                       Index1;
   INTN                       Index2;
-  EFI_GUID                   *SearchGuid;
-  EFI_GUID                   *CheckGuid;
+  PEI_PPI_HASH_INDEX         *PpiHashIndex;
+  PEI_PPI_HASH_INDEX         *NotifyHashIndex;
   EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor;
 
+  PpiHashIndex = &PrivateData->PpiData.PpiList.HashIndex;
+  if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
+    NotifyHashIndex = &PrivateData->PpiData.CallbackNotifyList.HashIndex;
+  } else {
+    NotifyHashIndex = &PrivateData->PpiData.DispatchNotifyList.HashIndex;
+  }
+
+  if (InstallStopIndex - InstallStartIndex == 1) {
+    //
+    // A single PPI was (re)installed, only visit the notifies for its GUID.
+    //
+    for (Index1 = (INTN)PpiHashIndexFirst (NotifyHashIndex, PrivateData->PpiData.PpiList.PpiPtrs[InstallStartIndex].Ppi->Guid);
+         Index1 < NotifyStopIndex;
+         Index1 = (INTN)PpiHashIndexNext (NotifyHashIndex, (UINTN)Index1))
+    {
+      if (Index1 < NotifyStartIndex) {
+        continue;
+      }
+
+      if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
+        NotifyDescriptor = PrivateData->PpiData.CallbackNotifyList.NotifyPtrs[Index1].Notify;
+      } else {
+        NotifyDescriptor = PrivateData->PpiData.DispatchNotifyList.NotifyPtrs[Index1].Notify;
+      }
+
+      ProcessNotifyForPpi (PrivateData, NotifyDescriptor, InstallStartIndex);
+    }
+
+    return;
+  }
+
   for (Index1 = NotifyStartIndex; Index1 < NotifyStopIndex; Index1++) {
     if (NotifyType == EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK) {
       NotifyDescriptor = PrivateData->PpiData.CallbackNotifyList.NotifyPtrs[Index1].Notify;
@@ -979,31 +1232,12 @@ ProcessNotify (
       NotifyDescriptor = PrivateData->PpiData.DispatchNotifyList.NotifyPtrs[Index1].Notify;
     }
 
-    CheckGuid = NotifyDescriptor->Guid;
-
-    for (Index2 = InstallStartIndex; Index2 < InstallStopIndex; Index2++) {
-      SearchGuid = PrivateData->PpiData.PpiList.PpiPtrs[Index2].Ppi->Guid;
-      //
-      // Don't use CompareGuid function here for performance reasons.
-      // Instead we compare the GUID as INT32 at a time and branch
-      // on the first failed comparison.
-      //
-      if ((((INT32 *)SearchGuid)[0] == ((INT32 *)CheckGuid)[0]) &&
-          (((INT32 *)SearchGuid)[1] == ((INT32 *)CheckGuid)[1]) &&
-          (((INT32 *)SearchGuid)[2] == ((INT32 *)CheckGuid)[2]) &&
-          (((INT32 *)SearchGuid)[3] == ((INT32 *)CheckGuid)[3]))
-      {
-        DEBUG ((
-          DEBUG_INFO,
-          "Notify: PPI Guid: %g, Peim notify entry point: %p\n",
-          SearchGuid,
-          NotifyDescriptor->Notify
-          ));
-        NotifyDescriptor->Notify (
-                            (EFI_PEI_SERVICES **)GetPeiServicesTablePointer (),
-                            NotifyDescriptor,
-                            (PrivateData->PpiData.PpiList.PpiPtrs[Index2].Ppi)->Ppi
-                            );
+    for (Index2 = (INTN)PpiHashIndexFirst (PpiHashIndex, NotifyDescriptor->Guid);
+         Index2 < InstallStopIndex;
+         Index2 = (INTN)PpiHashIndexNext (PpiHashIndex, (UINTN)Index2))
+    {
+      if (Index2 >= InstallStartIndex) {
+        ProcessNotifyForPpi (PrivateData, NotifyDescriptor, Index2);
       }
     }
   }
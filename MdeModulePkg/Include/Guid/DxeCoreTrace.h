@@ -0,0 +1,133 @@
+/** @file
+  DXE Core boot service trace table.
+
+  When DxeCoreTraceLib is linked into the DXE Core, it routes the most
+  frequently used boot services through thin wrappers that log every
+  call into a fixed-size ring of DXE_CORE_TRACE_ENTRY records. The ring is
+  published as a configuration table with this GUID so it can be saved by
+  a UEFI application and decoded on the host with
+  BaseTools/Scripts/DxeCoreTraceDecode.py.
+
+  The variadic InstallMultipleProtocolInterfaces() and
+  UninstallMultipleProtocolInterfaces() services are not traced.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef DXE_CORE_TRACE_H_
+#define DXE_CORE_TRACE_H_
+
+#define EDKII_DXE_CORE_TRACE_TABLE_GUID \
+  { \
+    0x944a3a4f, 0x651f, 0x44d1, { 0xa0, 0x76, 0x3e, 0xbd, 0xb5, 0x00, 0x76, 0xe6 } \
+  }
+
+#define DXE_CORE_TRACE_SIGNATURE  SIGNATURE_32 ('D','C','T','R')
+#define DXE_CORE_TRACE_REVISION   0x0001
+
+///
+/// Boot services recorded in DXE_CORE_TRACE_ENTRY.Service
+///
+typedef enum {
+  DxeCoreTraceAllocatePages = 1,
+  DxeCoreTraceFreePages,
+  DxeCoreTraceAllocatePool,
+  DxeCoreTraceFreePool,
+  DxeCoreTraceCreateEvent,
+  DxeCoreTraceSignalEvent,
+  DxeCoreTraceInstallProtocolInterface,
+  DxeCoreTraceReinstallProtocolInterface,
+  DxeCoreTraceUninstallProtocolInterface,
+  DxeCoreTraceHandleProtocol,
+  DxeCoreTraceLocateHandle,
+  DxeCoreTraceLocateDevicePath,
+  DxeCoreTraceLoadImage,
+  DxeCoreTraceStartImage,
+  DxeCoreTraceConnectController,
+  DxeCoreTraceDisconnectController,
+  DxeCoreTraceOpenProtocol,
+  DxeCoreTraceCloseProtocol,
+  DxeCoreTraceLocateHandleBuffer,
+  DxeCoreTraceLocateProtocol,
+  DxeCoreTraceCreateEventEx,
+  DxeCoreTraceServiceMax
+} DXE_CORE_TRACE_SERVICE;
+
+///
+/// One boot service call. Timestamps and durations are in ticks of the
+/// performance counter described by DXE_CORE_TRACE_HEADER.
+///
+typedef struct {
+  ///
+  /// Number of calls recorded before this one
+  ///
+  UINT64    Sequence;
+  ///
+  /// Performance counter value when the service was entered
+  ///
+  UINT64    Timestamp;
+  ///
+  /// Counter ticks spent in the service, MAX_UINT64 while the call is in progress
+  ///
+  UINT64    Duration;
+  ///
+  /// Return address into the code that called the service
+  ///
+  UINT64    Caller;
+  ///
+  /// Service specific argument: the number of bytes for memory services and
+  /// LoadImage(), the first 8 bytes of the protocol GUID for protocol
+  /// services, the notification function for CreateEvent() and
+  /// CreateEventEx(), and the event, image or controller handle otherwise
+  ///
+  UINT64    Argument;
+  ///
+  /// Status returned by the service, 0 while the call is in progress
+  ///
+  UINT64    Status;
+  ///
+  /// DXE_CORE_TRACE_SERVICE
+  ///
+  UINT32    Service;
+  ///
+  /// Number of traced calls in progress when the service was entered
+  ///
+  UINT32    Depth;
+} DXE_CORE_TRACE_ENTRY;
+
+///
+/// The configuration table. EntryCount records follow the header.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT16    Revision;
+  UINT16    HeaderSize;
+  UINT32    EntrySize;
+  ///
+  /// Number of records in the ring, a power of two
+  ///
+  UINT32    EntryCount;
+  ///
+  /// Total number of calls recorded. The next record is written to slot
+  /// (Head % EntryCount), so once Head exceeds EntryCount the ring holds the
+  /// EntryCount most recent calls.
+  ///
+  UINT64    Head;
+  ///
+  /// Performance counter frequency in Hz
+  ///
+  UINT64    Frequency;
+  ///
+  /// Performance counter start and end values, as returned by
+  /// GetPerformanceCounterProperties(). The counter counts down when
+  /// CounterStart is greater than CounterEnd.
+  ///
+  UINT64    CounterStart;
+  UINT64    CounterEnd;
+} DXE_CORE_TRACE_HEADER;
+
+extern EFI_GUID  gEdkiiDxeCoreTraceTableGuid;
+
+#endif
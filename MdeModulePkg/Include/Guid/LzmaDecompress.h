@@ -23,7 +23,32 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define LZMAF86_CUSTOM_DECOMPRESS_GUID  \
   { 0xD42AE6BD, 0x1352, 0x4bfb, { 0x90, 0x9A, 0xCA, 0x72, 0xA6, 0xEA, 0xE8, 0x89 } }
 
+///
+/// The Global ID used to identify a section of an FFS file of type
+/// EFI_SECTION_GUID_DEFINED, whose contents have been compressed using LZMA
+/// as several independent streams that can be decompressed in parallel.
+///
+#define LZMA_MULTI_STREAM_CUSTOM_DECOMPRESS_GUID  \
+  { 0x7B19B07F, 0x375C, 0x43BD, { 0xB2, 0x14, 0x7F, 0x96, 0xF4, 0x9B, 0x42, 0x3B } }
+
+#define LZMA_MULTI_STREAM_SIGNATURE  SIGNATURE_32 ('L', 'Z', 'M', 'S')
+
+///
+/// The data of a LZMA multi-stream section starts with this header, followed by
+/// StreamCount UINT32 offsets of the streams from the start of the header.
+/// Each stream is a 4-byte aligned EFI_SECTION_GUID_DEFINED section compressed
+/// with LZMA_CUSTOM_DECOMPRESS_GUID. All the streams but the last one decompress
+/// to StreamSize bytes; the last one decompresses to the rest of DecodedSize.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    StreamCount;
+  UINT32    StreamSize;
+  UINT32    DecodedSize;
+} LZMA_MULTI_STREAM_HEADER;
+
 extern GUID  gLzmaCustomDecompressGuid;
 extern GUID  gLzmaF86CustomDecompressGuid;
+extern GUID  gLzmaMultiStreamCustomDecompressGuid;
 
 #endif
@@ -77,6 +77,11 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO  14
+//
+// No extra payload for these functions.
+//
+#define SMM_VARIABLE_FUNCTION_BEGIN_WRITE_BATCH   15
+#define SMM_VARIABLE_FUNCTION_COMMIT_WRITE_BATCH  16
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -138,6 +143,10 @@ typedef struct {
   VARIABLE_STORE_HEADER    *RuntimeHobCache;
   VARIABLE_STORE_HEADER    *RuntimeNvCache;
   VARIABLE_STORE_HEADER    *RuntimeVolatileCache;
+  ///
+  /// Optional. Incremented each time a reclaim has moved the variables of a runtime cache.
+  ///
+  UINT32                   *ReclaimCount;
 } SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT;
 
 typedef struct {
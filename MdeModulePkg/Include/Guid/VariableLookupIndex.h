@@ -0,0 +1,64 @@
+/** @file
+  Lookup index of the variables of the non-volatile variable store.
+
+  The PEI variable driver builds this HOB once permanent memory is available.
+  Unlike VARIABLE_INDEX_TABLE, it covers every variable of the store, so a
+  variable is found with a binary search instead of a walk of the store.
+
+  The index is private to the PEI variable driver, which frees its arrays at
+  the end of PEI. The DXE variable drivers index their own copy of the store.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __VARIABLE_LOOKUP_INDEX_H__
+#define __VARIABLE_LOOKUP_INDEX_H__
+
+#define EDKII_VARIABLE_LOOKUP_INDEX_GUID \
+  { 0x46299f38, 0x55f8, 0x4486, { 0x99, 0xce, 0x59, 0x20, 0x96, 0xa7, 0xf7, 0xe8 } }
+
+extern EFI_GUID  gEdkiiVariableLookupIndexGuid;
+
+///
+/// One VAR_ADDED or VAR_IN_DELETED_TRANSITION variable of the store.
+///
+typedef struct {
+  ///
+  /// GetVariableHash() of the variable name and vendor GUID.
+  ///
+  UINT32    Hash;
+  ///
+  /// Offset of the variable header from the first variable of the store.
+  ///
+  UINT32    Offset;
+} VARIABLE_LOOKUP_INDEX_ENTRY;
+
+typedef struct {
+  ///
+  /// Address of the VARIABLE_STORE_HEADER the index describes, 0 once the
+  /// index is freed.
+  ///
+  EFI_PHYSICAL_ADDRESS    StoreBase;
+  ///
+  /// Number of VARIABLE_LOOKUP_INDEX_ENTRY at Entries, sorted by Hash and
+  /// then by Offset.
+  ///
+  UINT32                  EntryCount;
+  ///
+  /// Number of UINT32 offsets at Visible: the variables GetNextVariableName()
+  /// returns, in store order.
+  ///
+  UINT32                  VisibleCount;
+  EFI_PHYSICAL_ADDRESS    Entries;
+  EFI_PHYSICAL_ADDRESS    Visible;
+  ///
+  /// Position in Visible of the variable last returned by GetNextVariableName(),
+  /// so that an enumeration does not have to search for it.
+  ///
+  UINT32                  Cursor;
+  UINT32                  Reserved;
+} VARIABLE_LOOKUP_INDEX;
+
+#endif // __VARIABLE_LOOKUP_INDEX_H__
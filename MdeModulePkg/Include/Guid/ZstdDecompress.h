@@ -0,0 +1,22 @@
+/** @file
+  Zstandard Custom decompress algorithm Guid definition.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __ZSTD_DECOMPRESS_GUID_H__
+#define __ZSTD_DECOMPRESS_GUID_H__
+
+///
+/// The Global ID used to identify a section of an FFS file of type
+/// EFI_SECTION_GUID_DEFINED, whose contents have been compressed using
+/// Zstandard (RFC 8878) frames.
+///
+#define ZSTD_CUSTOM_DECOMPRESS_GUID  \
+  { 0x587FE0C5, 0xBFF4, 0x4BAB, { 0xA3, 0xF3, 0x67, 0xD7, 0x12, 0xBE, 0x4B, 0xFD } }
+
+extern GUID  gZstdCustomDecompressGuid;
+
+#endif
@@ -0,0 +1,225 @@
+/** @file
+  This library registers and retrieves the stream decode handlers of GUIDed sections.
+
+  A stream decode handler decodes a GUIDed section whose data is read in parts, so
+  the reads of the section data may overlap with the decode operation. The decoded
+  data is produced straight in the output buffer of the caller, or, for a caller
+  that has no buffer for the whole decoded data, passed in parts through a window
+  buffer of bounded size. It is an optional companion of the handlers registered
+  through ExtractGuidedSectionLib for the same section GUID, a consumer falls back
+  to those when no stream decode handler is registered.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EXTRACT_GUIDED_SECTION_STREAM_LIB_H_
+#define EXTRACT_GUIDED_SECTION_STREAM_LIB_H_
+
+/**
+  Gets the next part of the data of a GUIDed section that is decoded by a
+  handler of type EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER.
+
+  The parts are returned in the order they are stored in the GUIDed section,
+  starting at the DataOffset field of the section header. A part stays valid
+  until this function is called again.
+
+  @param[in]  Context  The context passed to the stream decode handler.
+  @param[out] Buffer   A pointer to the next part of the section data.
+  @param[out] Size     A pointer to the size, in bytes, of the next part of the
+                       section data. 0 is returned after the last part.
+
+  @retval  RETURN_SUCCESS  The next part of the section data was returned.
+  @retval  Others          The section data can not be read. The decode operation is aborted.
+
+**/
+typedef
+RETURN_STATUS
+(EFIAPI *EXTRACT_GUIDED_SECTION_STREAM_READ)(
+  IN        VOID   *Context,
+  OUT CONST VOID   **Buffer,
+  OUT       UINTN  *Size
+  );
+
+/**
+  Receives the next part of the decoded data of a GUIDed section from a handler of
+  type EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER that decodes without an output
+  buffer.
+
+  The parts are passed in order and do not overlap. A part is only valid until this
+  function returns, the handler reuses its window buffer for the parts that follow.
+
+  @param[in]  Context  The context passed to the stream decode handler.
+  @param[in]  Buffer   A pointer to the decoded part.
+  @param[in]  Size     The size, in bytes, of the decoded part.
+
+  @retval  RETURN_SUCCESS  The decode operation may continue.
+  @retval  Others          The decode operation is aborted.
+
+**/
+typedef
+RETURN_STATUS
+(EFIAPI *EXTRACT_GUIDED_SECTION_STREAM_WRITE)(
+  IN        VOID   *Context,
+  IN  CONST VOID   *Buffer,
+  IN        UINTN  Size
+  );
+
+/**
+  Examines a GUIDed section and returns the size of its decoded data and the size of
+  the window buffer required to decode it in parts without an output buffer.
+
+  Only the headers of the GUIDed section specified by InputSection and the first bytes
+  of its section data are examined. The window buffer holds the state of the decoder
+  and the decoded data that later data may still refer to, so it is usually much
+  smaller than the decoded data. A decode into an output buffer only needs the
+  scratch buffer size returned by the EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER
+  registered for the same GUID.
+  If GUID for InputSection does not match the GUID that this handler supports, then RETURN_UNSUPPORTED is returned.
+  If the required information can not be retrieved from InputSection, then RETURN_INVALID_PARAMETER is returned.
+
+  If InputSection is NULL, then ASSERT().
+  If OutputBufferSize is NULL, then ASSERT().
+  If WindowBufferSize is NULL, then ASSERT().
+  If SectionAttribute is NULL, then ASSERT().
+
+  @param[in]  InputSection      A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize  A pointer to the size, in bytes, of the decoded data.
+  @param[out] WindowBufferSize  A pointer to the size, in bytes, of the window buffer
+                                required to decode the section data in parts.
+  @param[out] SectionAttribute  A pointer to the attributes of the GUIDed section. See the Attributes
+                                field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_UNSUPPORTED        The section specified by InputSection does not match the GUID this handler supports.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+typedef
+RETURN_STATUS
+(EFIAPI *EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER)(
+  IN  CONST VOID    *InputSection,
+  OUT       UINT32  *OutputBufferSize,
+  OUT       UINT32  *WindowBufferSize,
+  OUT       UINT16  *SectionAttribute
+  );
+
+/**
+  Decodes a GUIDed section whose data is read in parts.
+
+  The headers of the GUIDed section specified by InputSection are examined, and the section
+  data that follows them is read through ReadInput while it is decoded, so the reads of the
+  section data may overlap with the decode operation.
+
+  If OutputBuffer is not NULL, the decoded data is produced straight in OutputBuffer, which
+  holds the size of decoded data returned by the EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER
+  registered for the same GUID, and WriteOutput is not used. WorkBuffer then has the scratch
+  buffer size returned by the EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER registered for the same GUID.
+
+  If OutputBuffer is NULL, the decoded data is produced in WorkBuffer and passed to WriteOutput
+  as soon as it is final, so no buffer for the whole decoded data is required. WorkBuffer then
+  has the window buffer size returned by the EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER.
+
+  If GUID for InputSection does not match the GUID that this handler supports, then RETURN_UNSUPPORTED is returned.
+  If the section data can not be decoded, or it does not decode to the size returned by the
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER, then RETURN_INVALID_PARAMETER is returned.
+
+  If InputSection is NULL, then ASSERT().
+  If ReadInput is NULL, then ASSERT().
+  If OutputBuffer and WriteOutput are NULL, then ASSERT().
+  If WorkBuffer is NULL, then ASSERT().
+  If AuthenticationStatus is NULL, then ASSERT().
+
+  @param[in]  InputSection      A pointer to the headers of a GUIDed section of an FFS formatted file.
+  @param[in]  ReadInput         The function that returns the parts of the section data.
+  @param[in]  WriteOutput       The function that receives the parts of the decoded data when
+                                OutputBuffer is NULL. Optional.
+  @param[in]  Context           The context passed to ReadInput and WriteOutput.
+  @param[out] OutputBuffer      A caller allocated buffer that receives the whole decoded data. Optional.
+  @param[in]  WorkBuffer        A caller allocated buffer that is used by this function to
+                                perform the decode operation.
+  @param[in]  WorkBufferSize    The size, in bytes, of WorkBuffer.
+  @param[out] AuthenticationStatus
+                                A pointer to the authentication status of the decoded data.
+                                See the definition of authentication status in the EFI_PEI_GUIDED_SECTION_EXTRACTION_PPI
+                                section of the PI Specification. EFI_AUTH_STATUS_PLATFORM_OVERRIDE must
+                                never be set by this handler.
+
+  @retval  RETURN_SUCCESS            The section data was decoded into OutputBuffer, or passed to WriteOutput.
+  @retval  RETURN_UNSUPPORTED        The section specified by InputSection does not match the GUID this handler supports.
+  @retval  RETURN_INVALID_PARAMETER  The section data can not be decoded.
+  @retval  Others                    The return status from ReadInput or WriteOutput.
+
+**/
+typedef
+RETURN_STATUS
+(EFIAPI *EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER)(
+  IN CONST  VOID                                 *InputSection,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN        VOID                                 *Context,
+  OUT       VOID                                 *OutputBuffer OPTIONAL,
+  IN        VOID                                 *WorkBuffer,
+  IN        UINT32                               WorkBufferSize,
+  OUT       UINT32                               *AuthenticationStatus
+  );
+
+/**
+  Registers a handler of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and a handler
+  of type EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  Registering the handlers again for the same GUID replaces them.
+
+  If SectionGuid is NULL, then ASSERT().
+  If StreamGetInfoHandler is NULL, then ASSERT().
+  If StreamDecodeHandler is NULL, then ASSERT().
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being registered.
+  @param[in]  StreamGetInfoHandler  The pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[in]  StreamDecodeHandler   The pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval  RETURN_SUCCESS            The handlers were registered.
+  @retval  RETURN_UNSUPPORTED        This library instance does not support stream decode handlers.
+  @retval  RETURN_OUT_OF_RESOURCES   There are not enough resources available to register the handlers.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterStreamHandler (
+  IN CONST  GUID                                            *SectionGuid,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler
+  );
+
+/**
+  Retrieves the handlers of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  If SectionGuid is NULL, then ASSERT().
+  If StreamGetInfoHandler is NULL, then ASSERT().
+  If StreamDecodeHandler is NULL, then ASSERT().
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being retrieved.
+  @param[out] StreamGetInfoHandler  Pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[out] StreamDecodeHandler   Pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval  RETURN_SUCCESS     The handlers were retrieved.
+  @retval  RETURN_NOT_FOUND   No stream decode handler has been registered with the specified GUID.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionGetStreamHandler (
+  IN CONST   GUID                                            *SectionGuid,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  *StreamGetInfoHandler,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    *StreamDecodeHandler
+  );
+
+#endif
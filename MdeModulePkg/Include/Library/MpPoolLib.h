@@ -0,0 +1,101 @@
+/** @file
+  Provides a small block allocator that may be used from any processor.
+
+  The pool is carved out of a buffer the BSP allocates up front, typically
+  before handing work to the APs through the MP Services protocol. Every
+  processor owns a magazine of free blocks per size class and only takes
+  the pool spin lock when its magazine has to be refilled or flushed, so
+  the allocation fast path neither raises the TPL nor calls boot services.
+
+  A CpuIndex must only be used by one processor at a time. Passing the
+  processor number returned by EFI_MP_SERVICES_PROTOCOL.WhoAmI() satisfies
+  this. Blocks may be freed on a processor other than the one that
+  allocated them.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MP_POOL_LIB_H_
+#define MP_POOL_LIB_H_
+
+///
+/// Largest allocation size served by the pool
+///
+#define MP_POOL_MAX_ALLOCATION_SIZE  SIZE_4KB
+
+typedef struct _MP_POOL MP_POOL;
+
+/**
+  Returns the smallest buffer size that MpPoolInitialize() accepts for a
+  given number of processors. Any space beyond this is used for blocks.
+
+  @param[in]  CpuCount  Number of processors that will use the pool.
+
+  @return The size of the pool bookkeeping, in bytes.
+
+**/
+UINTN
+EFIAPI
+MpPoolGetOverheadSize (
+  IN UINTN  CpuCount
+  );
+
+/**
+  Initializes a pool inside a caller provided buffer.
+
+  @param[in]  Buffer      Memory to manage. Must stay allocated while the pool is used.
+  @param[in]  BufferSize  Size of Buffer in bytes.
+  @param[in]  CpuCount    Number of processors that will use the pool.
+  @param[out] Pool        The initialized pool.
+
+  @retval RETURN_SUCCESS            The pool was initialized.
+  @retval RETURN_INVALID_PARAMETER  Buffer or Pool is NULL, or CpuCount is 0.
+  @retval RETURN_BUFFER_TOO_SMALL   BufferSize cannot hold the bookkeeping and one block.
+
+**/
+RETURN_STATUS
+EFIAPI
+MpPoolInitialize (
+  IN  VOID     *Buffer,
+  IN  UINTN    BufferSize,
+  IN  UINTN    CpuCount,
+  OUT MP_POOL  **Pool
+  );
+
+/**
+  Allocates a buffer from the pool. The buffer is 16 byte aligned.
+
+  @param[in]  Pool      The pool to allocate from.
+  @param[in]  CpuIndex  Index of the calling processor, below the CpuCount of the pool.
+  @param[in]  Size      Number of bytes to allocate, at most MP_POOL_MAX_ALLOCATION_SIZE.
+
+  @return The allocated buffer, or NULL if the request cannot be satisfied.
+
+**/
+VOID *
+EFIAPI
+MpPoolAllocate (
+  IN MP_POOL  *Pool,
+  IN UINTN    CpuIndex,
+  IN UINTN    Size
+  );
+
+/**
+  Returns a buffer allocated with MpPoolAllocate() to the pool.
+
+  @param[in]  Pool      The pool the buffer was allocated from.
+  @param[in]  CpuIndex  Index of the calling processor, below the CpuCount of the pool.
+  @param[in]  Buffer    The buffer to free.
+
+**/
+VOID
+EFIAPI
+MpPoolFree (
+  IN MP_POOL  *Pool,
+  IN UINTN    CpuIndex,
+  IN VOID     *Buffer
+  );
+
+#endif
@@ -0,0 +1,64 @@
+/** @file
+  Define the PPI to retrieve the stream decode handlers of GUIDed sections.
+
+  The PPI is installed by the PEI instance of ExtractGuidedSectionStreamLib, so a
+  PEIM can use the stream decode handlers registered in its own module or in
+  another one without linking ExtractGuidedSectionStreamLib. A PEIM that registers
+  stream decode handlers installs an instance of its own.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EDKII_EXTRACT_GUIDED_SECTION_STREAM_PPI_H_
+#define EDKII_EXTRACT_GUIDED_SECTION_STREAM_PPI_H_
+
+#include <Library/ExtractGuidedSectionStreamLib.h>
+
+///
+/// Global ID for the EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI.
+///
+#define EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI_GUID \
+  { \
+    0xbf42b620, 0x5596, 0x4edb, { 0xb9, 0x15, 0xb9, 0x7e, 0x0f, 0x04, 0x59, 0x8d } \
+  }
+
+///
+/// Forward declaration for the EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI.
+///
+typedef struct _EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI;
+
+/**
+  Retrieves the handlers of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being retrieved.
+  @param[out] StreamGetInfoHandler  Pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[out] StreamDecodeHandler   Pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval EFI_SUCCESS               The handlers were retrieved.
+  @retval EFI_NOT_FOUND             No stream decode handler has been registered with the specified GUID.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_PEI_EXTRACT_GUIDED_SECTION_GET_STREAM_HANDLER)(
+  IN CONST  GUID                                            *SectionGuid,
+  OUT       EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  *StreamGetInfoHandler,
+  OUT       EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    *StreamDecodeHandler
+  );
+
+///
+/// This PPI retrieves the stream decode handlers registered by a PEIM.
+///
+struct _EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI {
+  EDKII_PEI_EXTRACT_GUIDED_SECTION_GET_STREAM_HANDLER    GetStreamHandler;
+};
+
+extern EFI_GUID  gEdkiiPeiExtractGuidedSectionStreamPpiGuid;
+
+#endif
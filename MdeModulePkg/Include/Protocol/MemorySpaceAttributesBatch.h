@@ -0,0 +1,73 @@
+/** @file
+  EDKII Memory Space Attributes Batch Protocol.
+
+  This protocol is produced by the DXE Core. It allows the attributes of many
+  memory space ranges to be set with a single call, so that adjacent ranges
+  are coalesced before they are applied to the CPU Architectural Protocol and
+  the GCD memory space map.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MEMORY_SPACE_ATTRIBUTES_BATCH_H_
+#define MEMORY_SPACE_ATTRIBUTES_BATCH_H_
+
+#define EDKII_MEMORY_SPACE_ATTRIBUTES_BATCH_PROTOCOL_GUID \
+  { 0x88f95cf2, 0x302b, 0x40cc, { 0x93, 0x49, 0x66, 0x99, 0xe2, 0xad, 0x3f, 0xdd } }
+
+typedef struct _EDKII_MEMORY_SPACE_ATTRIBUTES_BATCH_PROTOCOL EDKII_MEMORY_SPACE_ATTRIBUTES_BATCH_PROTOCOL;
+
+///
+/// One memory space range whose attributes are to be set.
+///
+typedef struct {
+  EFI_PHYSICAL_ADDRESS    BaseAddress;
+  UINT64                  Length;
+  UINT64                  Attributes;
+} EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE;
+
+/**
+  Set the attributes of a list of memory space ranges.
+
+  The ranges may be listed in any order but must not overlap. All of them are
+  checked before any attribute is changed. Contiguous ranges whose attributes
+  map to the same CPU arch attributes are set with a single CPU Architectural
+  Protocol call, and contiguous ranges with the same attributes are updated
+  in the GCD memory space map at once.
+
+  When the CPU Architectural Protocol fails on a run of ranges, the ranges
+  below that run keep their new attributes and the others are left unchanged.
+
+  @param[in]  RangeCount        The number of entries in Ranges.
+  @param[in]  Ranges            The memory space ranges and their attributes.
+  @param[out] FailedIndex       On error, the index in Ranges of the range
+                                that failed. Optional.
+
+  @retval EFI_SUCCESS           The attributes were set for all ranges.
+  @retval EFI_INVALID_PARAMETER RangeCount is 0, Ranges is NULL, a range is
+                                empty or two ranges overlap.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to sort the ranges.
+  @retval Others                The status gDS->SetMemorySpaceAttributes()
+                                would return for the range that failed.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_SET_MEMORY_SPACE_ATTRIBUTES_BATCH)(
+  IN  UINTN                                      RangeCount,
+  IN  CONST EDKII_MEMORY_SPACE_ATTRIBUTES_RANGE  *Ranges,
+  OUT UINTN                                      *FailedIndex  OPTIONAL
+  );
+
+///
+/// EDKII Memory Space Attributes Batch Protocol structure.
+///
+struct _EDKII_MEMORY_SPACE_ATTRIBUTES_BATCH_PROTOCOL {
+  EDKII_SET_MEMORY_SPACE_ATTRIBUTES_BATCH    SetMemorySpaceAttributes;
+};
+
+extern EFI_GUID  gEdkiiMemorySpaceAttributesBatchProtocolGuid;
+
+#endif
@@ -0,0 +1,74 @@
+/** @file
+  Variable Write Batch Protocol is related to EDK II-specific implementation of
+  variables and intended for use by code that updates many non-volatile
+  variables back to back, such as a setup browser saving its forms.
+
+  Between Begin() and Commit(), SetVariable() updates non-volatile variables in
+  the memory copy of the variable store only. GetVariable() and
+  GetNextVariableName() already return the updated content. Commit() then
+  writes all the updates to flash at once, using the same variable state
+  transitions as a single SetVariable(), so each variable is either fully
+  updated or left unchanged if the power fails during Commit(). The updates
+  that were not committed when the power fails are lost.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __VARIABLE_WRITE_BATCH_H__
+#define __VARIABLE_WRITE_BATCH_H__
+
+#define EDKII_VARIABLE_WRITE_BATCH_PROTOCOL_GUID \
+  { \
+    0x3796ce0b, 0x13ff, 0x44a5, { 0xbf, 0x97, 0xa4, 0xcc, 0xa4, 0x6d, 0x4e, 0xdb } \
+  }
+
+typedef struct _EDKII_VARIABLE_WRITE_BATCH_PROTOCOL EDKII_VARIABLE_WRITE_BATCH_PROTOCOL;
+
+/**
+  Start staging the updates of non-volatile variables in memory.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS          The batch was started.
+  @retval EFI_ALREADY_STARTED  A batch is already started.
+  @retval EFI_UNSUPPORTED      EFI_EVENT_GROUP_READY_TO_BOOT has already been signaled,
+                               or the non-volatile variables are not stored in flash.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_VARIABLE_WRITE_BATCH_BEGIN)(
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  );
+
+/**
+  Write the updates staged since Begin() to flash and end the batch.
+
+  The batch is also committed when EFI_EVENT_GROUP_READY_TO_BOOT is signaled.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS      The updates were written to flash.
+  @retval EFI_NOT_STARTED  No batch is started.
+  @retval Others           Writing to flash failed. The batch is ended and the
+                           variables hold the content of the flash.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_VARIABLE_WRITE_BATCH_COMMIT)(
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  );
+
+///
+/// Variable Write Batch Protocol coalesces the flash writes of the updates of
+/// many non-volatile variables.
+///
+struct _EDKII_VARIABLE_WRITE_BATCH_PROTOCOL {
+  EDKII_VARIABLE_WRITE_BATCH_BEGIN     Begin;
+  EDKII_VARIABLE_WRITE_BATCH_COMMIT    Commit;
+};
+
+extern EFI_GUID  gEdkiiVariableWriteBatchProtocolGuid;
+
+#endif
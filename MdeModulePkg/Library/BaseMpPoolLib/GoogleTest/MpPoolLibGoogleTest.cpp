@@ -0,0 +1,282 @@
+/** @file
+  Unit tests of BaseMpPoolLib running every processor of the pool on a host
+  thread of its own.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Library/GoogleTestLib.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include <Base.h>
+  #include <Library/MpPoolLib.h>
+}
+
+using namespace testing;
+
+#define THREAD_COUNT      8
+#define LIVE_BLOCKS       64
+#define ITERATIONS        20000
+#define POOL_BUFFER_SIZE  SIZE_32MB
+
+//
+// Each live block is filled with a byte identifying its owner and
+// allocation, so a block handed out twice is caught when it is checked
+// before being freed.
+//
+struct LiveBlock {
+  UINT8    *Buffer;
+  UINTN    Size;
+  UINT8    Fill;
+};
+
+static
+UINT32
+NextRandom (
+  UINT32  *State
+  )
+{
+  *State ^= *State << 13;
+  *State ^= *State >> 17;
+  *State ^= *State << 5;
+  return *State;
+}
+
+static
+bool
+IsFilled (
+  CONST LiveBlock  &Block
+  )
+{
+  for (UINTN Index = 0; Index < Block.Size; Index++) {
+    if (Block.Buffer[Index] != Block.Fill) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+class MpPoolThreadTest : public Test {
+  protected:
+    std::vector<UINT8>  Memory;
+    MP_POOL             *Pool;
+
+    void
+    SetUp (
+      ) override
+    {
+      Memory.resize (POOL_BUFFER_SIZE);
+      ASSERT_EQ (MpPoolInitialize (Memory.data (), Memory.size (), THREAD_COUNT, &Pool), RETURN_SUCCESS);
+    }
+
+    //
+    // Allocates and frees random sizes on one processor, keeping up to
+    // LIVE_BLOCKS blocks alive. Returns the number of failed checks.
+    //
+    UINTN
+    RunProcessor (
+      UINTN  CpuIndex,
+      UINTN  Iterations
+      )
+    {
+      std::vector<LiveBlock>  Live;
+      UINT32                  Seed;
+      UINTN                   Failures;
+      UINTN                   Victim;
+      LiveBlock               Block;
+
+      Seed     = 0x9E3779B9u ^ (UINT32)(CpuIndex + 1);
+      Failures = 0;
+      for (UINTN Index = 0; Index < Iterations; Index++) {
+        if ((Live.size () == LIVE_BLOCKS) || ((Live.size () != 0) && ((NextRandom (&Seed) & 3) == 0))) {
+          Victim = NextRandom (&Seed) % Live.size ();
+          if (!IsFilled (Live[Victim])) {
+            Failures++;
+          }
+
+          MpPoolFree (Pool, CpuIndex, Live[Victim].Buffer);
+          Live[Victim] = Live.back ();
+          Live.pop_back ();
+          continue;
+        }
+
+        Block.Size   = 1 + NextRandom (&Seed) % MP_POOL_MAX_ALLOCATION_SIZE;
+        Block.Fill   = (UINT8)((CpuIndex << 5) ^ Index);
+        Block.Buffer = (UINT8 *)MpPoolAllocate (Pool, CpuIndex, Block.Size);
+        if ((Block.Buffer == NULL) || (((UINTN)Block.Buffer & 0xF) != 0)) {
+          Failures++;
+          continue;
+        }
+
+        memset (Block.Buffer, Block.Fill, Block.Size);
+        Live.push_back (Block);
+      }
+
+      for (CONST LiveBlock &Remaining : Live) {
+        if (!IsFilled (Remaining)) {
+          Failures++;
+        }
+
+        MpPoolFree (Pool, CpuIndex, Remaining.Buffer);
+      }
+
+      return Failures;
+    }
+};
+
+// Run every processor of the pool on its own thread at the same time and
+// verify that no block is handed to two processors.
+TEST_F (MpPoolThreadTest, ConcurrentProcessorsKeepBlocksDisjoint) {
+  std::vector<std::thread>  Threads;
+  std::vector<UINTN>        Failures (THREAD_COUNT, 0);
+
+  for (UINTN CpuIndex = 0; CpuIndex < THREAD_COUNT; CpuIndex++) {
+    Threads.emplace_back (
+              [this, CpuIndex, &Failures]() {
+      Failures[CpuIndex] = RunProcessor (CpuIndex, ITERATIONS);
+    }
+              );
+  }
+
+  for (std::thread &Thread : Threads) {
+    Thread.join ();
+  }
+
+  for (UINTN CpuIndex = 0; CpuIndex < THREAD_COUNT; CpuIndex++) {
+    EXPECT_EQ (Failures[CpuIndex], 0u) << "processor " << CpuIndex;
+  }
+}
+
+// Allocate on some threads and free on others, so that blocks travel
+// between magazines through the depot while every thread is running.
+TEST_F (MpPoolThreadTest, CrossProcessorFreesKeepBlocksDisjoint) {
+  std::vector<std::thread>  Threads;
+  std::mutex                Lock;
+  std::condition_variable   Ready;
+  std::deque<LiveBlock>     Queue;
+  UINTN                     Producers;
+  UINTN                     Failures;
+
+  Producers = THREAD_COUNT / 2;
+  Failures  = 0;
+
+  for (UINTN CpuIndex = 0; CpuIndex < THREAD_COUNT; CpuIndex++) {
+    if (CpuIndex < THREAD_COUNT / 2) {
+      Threads.emplace_back (
+                [this, CpuIndex, &Lock, &Ready, &Queue, &Producers, &Failures]() {
+        UINT32     Seed;
+        LiveBlock  Block;
+
+        Seed = 0x2545F491u ^ (UINT32)(CpuIndex + 1);
+        for (UINTN Index = 0; Index < ITERATIONS; Index++) {
+          Block.Size   = 1 + NextRandom (&Seed) % MP_POOL_MAX_ALLOCATION_SIZE;
+          Block.Fill   = (UINT8)((CpuIndex << 5) ^ Index);
+          Block.Buffer = (UINT8 *)MpPoolAllocate (Pool, CpuIndex, Block.Size);
+          if (Block.Buffer == NULL) {
+            //
+            // The consumers have not caught up yet
+            //
+            std::this_thread::yield ();
+            continue;
+          }
+
+          memset (Block.Buffer, Block.Fill, Block.Size);
+          std::lock_guard<std::mutex>  Guard (Lock);
+          Queue.push_back (Block);
+          Ready.notify_one ();
+        }
+
+        std::lock_guard<std::mutex>  Guard (Lock);
+        Producers--;
+        Ready.notify_all ();
+      }
+                );
+    } else {
+      Threads.emplace_back (
+                [this, CpuIndex, &Lock, &Ready, &Queue, &Producers, &Failures]() {
+        LiveBlock  Block;
+
+        while (true) {
+          {
+            std::unique_lock<std::mutex>  Guard (Lock);
+            Ready.wait (Guard, [&Queue, &Producers]() {
+              return !Queue.empty () || (Producers == 0);
+            });
+            if (Queue.empty ()) {
+              return;
+            }
+
+            Block = Queue.front ();
+            Queue.pop_front ();
+            if (!IsFilled (Block)) {
+              Failures++;
+            }
+          }
+
+          MpPoolFree (Pool, CpuIndex, Block.Buffer);
+        }
+      }
+                );
+    }
+  }
+
+  for (std::thread &Thread : Threads) {
+    Thread.join ();
+  }
+
+  EXPECT_EQ (Failures, 0u);
+}
+
+// Measure allocate and free pairs per second with 1 to THREAD_COUNT threads.
+// Nothing is asserted about the speed, the numbers are only reported.
+TEST_F (MpPoolThreadTest, ReportScaling) {
+  for (UINTN Count = 1; Count <= THREAD_COUNT; Count *= 2) {
+    std::vector<std::thread>  Threads;
+    std::vector<UINTN>        Failures (Count, 0);
+
+    auto  Start = std::chrono::steady_clock::now ();
+
+    for (UINTN CpuIndex = 0; CpuIndex < Count; CpuIndex++) {
+      Threads.emplace_back (
+                [this, CpuIndex, &Failures]() {
+        Failures[CpuIndex] = RunProcessor (CpuIndex, ITERATIONS);
+      }
+                );
+    }
+
+    for (std::thread &Thread : Threads) {
+      Thread.join ();
+    }
+
+    auto  Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now () - Start).count ();
+
+    for (UINTN CpuIndex = 0; CpuIndex < Count; CpuIndex++) {
+      EXPECT_EQ (Failures[CpuIndex], 0u);
+    }
+
+    printf (
+      "[          ] %2u threads: %10.0f operations per second\n",
+      (unsigned)Count,
+      (double)(Count * ITERATIONS) / Elapsed
+      );
+  }
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  testing::InitGoogleTest (&argc, argv);
+  return RUN_ALL_TESTS ();
+}
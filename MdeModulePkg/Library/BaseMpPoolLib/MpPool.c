@@ -0,0 +1,364 @@
+/** @file
+  Small block allocator with per-processor magazines.
+
+  Blocks come in MP_POOL_CLASS_COUNT power of two size classes. Each
+  processor keeps up to MP_POOL_MAGAZINE_SIZE free blocks per class in its
+  own magazine, which is accessed without any lock. An empty magazine is
+  refilled with half a magazine from the shared depot, and a full one gives
+  half of its blocks back, so a processor that alternates between allocate
+  and free never touches the depot. The depot consists of a free list per
+  class plus the part of the buffer that has never been handed out, and is
+  protected by a spin lock.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MpPoolLib.h>
+#include <Library/SynchronizationLib.h>
+
+#define MP_POOL_SIGNATURE        SIGNATURE_32 ('m', 'p', 'p', 'l')
+#define MP_POOL_BLOCK_SIGNATURE  SIGNATURE_32 ('m', 'p', 'b', 'k')
+
+#define MP_POOL_MIN_SHIFT      5
+#define MP_POOL_CLASS_COUNT    8
+#define MP_POOL_MAGAZINE_SIZE  32
+#define MP_POOL_CACHE_LINE     64
+#define MP_POOL_ALIGNMENT      16
+
+//
+// The payload of the largest class must match MP_POOL_MAX_ALLOCATION_SIZE.
+//
+STATIC_ASSERT (
+  (1 << (MP_POOL_MIN_SHIFT + MP_POOL_CLASS_COUNT - 1)) == MP_POOL_MAX_ALLOCATION_SIZE,
+  "MP_POOL_CLASS_COUNT does not match MP_POOL_MAX_ALLOCATION_SIZE"
+  );
+
+///
+/// Header in front of every block. While a block sits in the depot, the
+/// first bytes of its payload link it to the next free block of its class.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    Class;
+  UINT64    Reserved;
+} MP_POOL_BLOCK;
+
+typedef struct {
+  UINTN            Count;
+  MP_POOL_BLOCK    *Blocks[MP_POOL_MAGAZINE_SIZE];
+} MP_POOL_MAGAZINE;
+
+typedef struct {
+  MP_POOL_MAGAZINE    Magazines[MP_POOL_CLASS_COUNT];
+} MP_POOL_CPU;
+
+struct _MP_POOL {
+  UINT32           Signature;
+  UINTN            CpuCount;
+  UINTN            CpuStride;
+  UINT8            *Cpus;
+  SPIN_LOCK        Lock;
+  MP_POOL_BLOCK    *FreeList[MP_POOL_CLASS_COUNT];
+  UINT8            *Unused;
+  UINT8            *End;
+};
+
+STATIC_ASSERT (sizeof (MP_POOL_BLOCK) == MP_POOL_ALIGNMENT, "MP_POOL_BLOCK must keep payloads aligned");
+
+/**
+  Returns the size class serving an allocation size.
+
+  @param[in]  Size  Allocation size, between 1 and MP_POOL_MAX_ALLOCATION_SIZE.
+
+  @return The size class.
+
+**/
+STATIC
+UINT32
+MpPoolGetClass (
+  IN UINTN  Size
+  )
+{
+  if (Size <= (1 << MP_POOL_MIN_SHIFT)) {
+    return 0;
+  }
+
+  return (UINT32)HighBitSet32 ((UINT32)Size - 1) + 1 - MP_POOL_MIN_SHIFT;
+}
+
+/**
+  Returns the magazine of a processor for a size class.
+
+  @param[in]  Pool      The pool.
+  @param[in]  CpuIndex  Index of the processor.
+  @param[in]  Class     The size class.
+
+  @return The magazine.
+
+**/
+STATIC
+MP_POOL_MAGAZINE *
+MpPoolGetMagazine (
+  IN MP_POOL  *Pool,
+  IN UINTN    CpuIndex,
+  IN UINT32   Class
+  )
+{
+  MP_POOL_CPU  *Cpu;
+
+  Cpu = (MP_POOL_CPU *)(Pool->Cpus + CpuIndex * Pool->CpuStride);
+  return &Cpu->Magazines[Class];
+}
+
+/**
+  Refills an empty magazine with half a magazine of blocks from the depot.
+
+  @param[in]  Pool      The pool.
+  @param[in]  Class     The size class of the magazine.
+  @param[in]  Magazine  The magazine to refill.
+
+**/
+STATIC
+VOID
+MpPoolRefill (
+  IN MP_POOL           *Pool,
+  IN UINT32            Class,
+  IN MP_POOL_MAGAZINE  *Magazine
+  )
+{
+  MP_POOL_BLOCK  *Block;
+  UINTN          BlockSize;
+
+  BlockSize = sizeof (MP_POOL_BLOCK) + ((UINTN)1 << (Class + MP_POOL_MIN_SHIFT));
+
+  AcquireSpinLock (&Pool->Lock);
+
+  while (Magazine->Count < MP_POOL_MAGAZINE_SIZE / 2) {
+    Block = Pool->FreeList[Class];
+    if (Block != NULL) {
+      Pool->FreeList[Class] = *(MP_POOL_BLOCK **)(Block + 1);
+    } else {
+      if ((UINTN)(Pool->End - Pool->Unused) < BlockSize) {
+        break;
+      }
+
+      Block            = (MP_POOL_BLOCK *)Pool->Unused;
+      Pool->Unused    += BlockSize;
+      Block->Signature = MP_POOL_BLOCK_SIGNATURE;
+      Block->Class     = Class;
+    }
+
+    Magazine->Blocks[Magazine->Count++] = Block;
+  }
+
+  ReleaseSpinLock (&Pool->Lock);
+}
+
+/**
+  Returns the oldest half of the blocks of a full magazine to the depot.
+
+  @param[in]  Pool      The pool.
+  @param[in]  Class     The size class of the magazine.
+  @param[in]  Magazine  The magazine to flush.
+
+**/
+STATIC
+VOID
+MpPoolFlush (
+  IN MP_POOL           *Pool,
+  IN UINT32            Class,
+  IN MP_POOL_MAGAZINE  *Magazine
+  )
+{
+  MP_POOL_BLOCK  *Block;
+  UINTN          Index;
+  UINTN          Half;
+
+  Half = MP_POOL_MAGAZINE_SIZE / 2;
+
+  AcquireSpinLock (&Pool->Lock);
+
+  for (Index = 0; Index < Half; Index++) {
+    Block                          = Magazine->Blocks[Index];
+    *(MP_POOL_BLOCK **)(Block + 1) = Pool->FreeList[Class];
+    Pool->FreeList[Class]          = Block;
+  }
+
+  ReleaseSpinLock (&Pool->Lock);
+
+  for (Index = Half; Index < Magazine->Count; Index++) {
+    Magazine->Blocks[Index - Half] = Magazine->Blocks[Index];
+  }
+
+  Magazine->Count -= Half;
+}
+
+/**
+  Returns the smallest buffer size that MpPoolInitialize() accepts for a
+  given number of processors. Any space beyond this is used for blocks.
+
+  @param[in]  CpuCount  Number of processors that will use the pool.
+
+  @return The size of the pool bookkeeping, in bytes.
+
+**/
+UINTN
+EFIAPI
+MpPoolGetOverheadSize (
+  IN UINTN  CpuCount
+  )
+{
+  return MP_POOL_CACHE_LINE +
+         ALIGN_VALUE (sizeof (MP_POOL), MP_POOL_CACHE_LINE) +
+         CpuCount * ALIGN_VALUE (sizeof (MP_POOL_CPU), MP_POOL_CACHE_LINE);
+}
+
+/**
+  Initializes a pool inside a caller provided buffer.
+
+  @param[in]  Buffer      Memory to manage. Must stay allocated while the pool is used.
+  @param[in]  BufferSize  Size of Buffer in bytes.
+  @param[in]  CpuCount    Number of processors that will use the pool.
+  @param[out] Pool        The initialized pool.
+
+  @retval RETURN_SUCCESS            The pool was initialized.
+  @retval RETURN_INVALID_PARAMETER  Buffer or Pool is NULL, or CpuCount is 0.
+  @retval RETURN_BUFFER_TOO_SMALL   BufferSize cannot hold the bookkeeping and one block.
+
+**/
+RETURN_STATUS
+EFIAPI
+MpPoolInitialize (
+  IN  VOID     *Buffer,
+  IN  UINTN    BufferSize,
+  IN  UINTN    CpuCount,
+  OUT MP_POOL  **Pool
+  )
+{
+  MP_POOL  *NewPool;
+  UINT8    *Start;
+  UINT8    *End;
+  UINTN    Index;
+
+  if ((Buffer == NULL) || (Pool == NULL) || (CpuCount == 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (BufferSize < MpPoolGetOverheadSize (CpuCount) + sizeof (MP_POOL_BLOCK) + (1 << MP_POOL_MIN_SHIFT)) {
+    return RETURN_BUFFER_TOO_SMALL;
+  }
+
+  Start   = (UINT8 *)ALIGN_POINTER (Buffer, MP_POOL_CACHE_LINE);
+  End     = (UINT8 *)Buffer + BufferSize;
+  NewPool = (MP_POOL *)Start;
+  ZeroMem (NewPool, sizeof (MP_POOL));
+
+  NewPool->Signature = MP_POOL_SIGNATURE;
+  NewPool->CpuCount  = CpuCount;
+  NewPool->CpuStride = ALIGN_VALUE (sizeof (MP_POOL_CPU), MP_POOL_CACHE_LINE);
+  NewPool->Cpus      = Start + ALIGN_VALUE (sizeof (MP_POOL), MP_POOL_CACHE_LINE);
+  NewPool->Unused    = NewPool->Cpus + CpuCount * NewPool->CpuStride;
+  NewPool->End       = End;
+  InitializeSpinLock (&NewPool->Lock);
+
+  for (Index = 0; Index < CpuCount; Index++) {
+    ZeroMem (NewPool->Cpus + Index * NewPool->CpuStride, sizeof (MP_POOL_CPU));
+  }
+
+  *Pool = NewPool;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Allocates a buffer from the pool. The buffer is 16 byte aligned.
+
+  @param[in]  Pool      The pool to allocate from.
+  @param[in]  CpuIndex  Index of the calling processor, below the CpuCount of the pool.
+  @param[in]  Size      Number of bytes to allocate, at most MP_POOL_MAX_ALLOCATION_SIZE.
+
+  @return The allocated buffer, or NULL if the request cannot be satisfied.
+
+**/
+VOID *
+EFIAPI
+MpPoolAllocate (
+  IN MP_POOL  *Pool,
+  IN UINTN    CpuIndex,
+  IN UINTN    Size
+  )
+{
+  MP_POOL_MAGAZINE  *Magazine;
+  UINT32            Class;
+
+  if ((Pool == NULL) || (Size == 0) || (Size > MP_POOL_MAX_ALLOCATION_SIZE)) {
+    return NULL;
+  }
+
+  ASSERT (Pool->Signature == MP_POOL_SIGNATURE);
+  ASSERT (CpuIndex < Pool->CpuCount);
+  if (CpuIndex >= Pool->CpuCount) {
+    return NULL;
+  }
+
+  Class    = MpPoolGetClass (Size);
+  Magazine = MpPoolGetMagazine (Pool, CpuIndex, Class);
+  if (Magazine->Count == 0) {
+    MpPoolRefill (Pool, Class, Magazine);
+    if (Magazine->Count == 0) {
+      return NULL;
+    }
+  }
+
+  Magazine->Count--;
+  return Magazine->Blocks[Magazine->Count] + 1;
+}
+
+/**
+  Returns a buffer allocated with MpPoolAllocate() to the pool.
+
+  @param[in]  Pool      The pool the buffer was allocated from.
+  @param[in]  CpuIndex  Index of the calling processor, below the CpuCount of the pool.
+  @param[in]  Buffer    The buffer to free.
+
+**/
+VOID
+EFIAPI
+MpPoolFree (
+  IN MP_POOL  *Pool,
+  IN UINTN    CpuIndex,
+  IN VOID     *Buffer
+  )
+{
+  MP_POOL_BLOCK     *Block;
+  MP_POOL_MAGAZINE  *Magazine;
+
+  if ((Pool == NULL) || (Buffer == NULL)) {
+    return;
+  }
+
+  ASSERT (Pool->Signature == MP_POOL_SIGNATURE);
+  ASSERT (CpuIndex < Pool->CpuCount);
+  if (CpuIndex >= Pool->CpuCount) {
+    return;
+  }
+
+  Block = (MP_POOL_BLOCK *)Buffer - 1;
+  ASSERT (Block->Signature == MP_POOL_BLOCK_SIGNATURE);
+  ASSERT (Block->Class < MP_POOL_CLASS_COUNT);
+  if ((Block->Signature != MP_POOL_BLOCK_SIGNATURE) || (Block->Class >= MP_POOL_CLASS_COUNT)) {
+    return;
+  }
+
+  Magazine = MpPoolGetMagazine (Pool, CpuIndex, Block->Class);
+  if (Magazine->Count == MP_POOL_MAGAZINE_SIZE) {
+    MpPoolFlush (Pool, Block->Class, Magazine);
+  }
+
+  Magazine->Blocks[Magazine->Count++] = Block;
+}
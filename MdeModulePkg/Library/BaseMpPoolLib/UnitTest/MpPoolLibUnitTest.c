@@ -0,0 +1,416 @@
+/** @file
+  Unit tests of the BaseMpPoolLib instance of the MpPoolLib class
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include <Library/UnitTestLib.h>
+#include <Library/MpPoolLib.h>
+
+#define UNIT_TEST_APP_NAME     "MpPoolLib Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_CPU_COUNT      8
+#define TEST_POOL_SIZE      SIZE_16MB
+#define TEST_SLOTS_PER_CPU  256
+#define TEST_STRESS_ROUNDS  200000
+
+///
+/// A live allocation made by the stress test
+///
+typedef struct {
+  UINT8    *Buffer;
+  UINTN    Size;
+  UINT8    Tag;
+} TEST_ALLOCATION;
+
+///
+/// Context of the tests, reset before each of them
+///
+typedef struct {
+  VOID               *Buffer;
+  MP_POOL            *Pool;
+  UINT32             Seed;
+  TEST_ALLOCATION    Slots[TEST_CPU_COUNT][TEST_SLOTS_PER_CPU];
+} TEST_CONTEXT;
+
+STATIC TEST_CONTEXT  mTestContext;
+
+/**
+  Returns the next value of a linear congruential generator, so that every
+  run of the stress test performs the same sequence of operations.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestContext.Seed = mTestContext.Seed * 1103515245 + 12345;
+  return mTestContext.Seed >> 8;
+}
+
+/**
+  Allocates the buffer of the pool under test and initializes the pool.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED                      The pool was initialized.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The pool could not be initialized.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+PoolSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+
+  ZeroMem (&mTestContext, sizeof (mTestContext));
+  mTestContext.Seed   = 0x5eed;
+  mTestContext.Buffer = AllocatePool (TEST_POOL_SIZE);
+  if (mTestContext.Buffer == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  Status = MpPoolInitialize (mTestContext.Buffer, TEST_POOL_SIZE, TEST_CPU_COUNT, &mTestContext.Pool);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the buffer of the pool under test.
+
+  @param[in]  Context    Unused.
+
+**/
+STATIC
+VOID
+EFIAPI
+PoolCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mTestContext.Buffer != NULL) {
+    FreePool (mTestContext.Buffer);
+    mTestContext.Buffer = NULL;
+  }
+}
+
+/**
+  Check that MpPoolInitialize() rejects invalid parameters.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InitializeShouldRejectBadParameters (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8    Buffer[SIZE_1KB];
+  MP_POOL  *Pool;
+
+  UT_ASSERT_STATUS_EQUAL (MpPoolInitialize (NULL, sizeof (Buffer), 1, &Pool), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MpPoolInitialize (Buffer, sizeof (Buffer), 0, &Pool), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MpPoolInitialize (Buffer, sizeof (Buffer), 1, NULL), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MpPoolInitialize (Buffer, sizeof (Buffer), TEST_CPU_COUNT, &Pool), EFI_BUFFER_TOO_SMALL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that allocations are aligned, usable over their full size and
+  limited to MP_POOL_MAX_ALLOCATION_SIZE.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+AllocateShouldHonorSizeAndAlignment (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Size;
+  UINT8  *Buffer;
+
+  UT_ASSERT_TRUE (MpPoolAllocate (mTestContext.Pool, 0, 0) == NULL);
+  UT_ASSERT_TRUE (MpPoolAllocate (mTestContext.Pool, 0, MP_POOL_MAX_ALLOCATION_SIZE + 1) == NULL);
+
+  for (Size = 1; Size <= MP_POOL_MAX_ALLOCATION_SIZE; Size = Size * 3 / 2 + 1) {
+    Buffer = MpPoolAllocate (mTestContext.Pool, Size % TEST_CPU_COUNT, Size);
+    UT_ASSERT_NOT_NULL (Buffer);
+    UT_ASSERT_EQUAL ((UINTN)Buffer & 0xF, 0);
+    SetMem (Buffer, Size, 0xA5);
+    MpPoolFree (mTestContext.Pool, Size % TEST_CPU_COUNT, Buffer);
+  }
+
+  Buffer = MpPoolAllocate (mTestContext.Pool, 0, MP_POOL_MAX_ALLOCATION_SIZE);
+  UT_ASSERT_NOT_NULL (Buffer);
+  SetMem (Buffer, MP_POOL_MAX_ALLOCATION_SIZE, 0x5A);
+  MpPoolFree (mTestContext.Pool, 0, Buffer);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that a freed block is handed out again by the magazine of the
+  processor that freed it.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FreeShouldRecycleOnSameCpu (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID  *First;
+  VOID  *Second;
+
+  First = MpPoolAllocate (mTestContext.Pool, 1, 100);
+  UT_ASSERT_NOT_NULL (First);
+  MpPoolFree (mTestContext.Pool, 3, First);
+
+  Second = MpPoolAllocate (mTestContext.Pool, 3, 120);
+  UT_ASSERT_TRUE (Second == First);
+  MpPoolFree (mTestContext.Pool, 3, Second);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that running out of memory fails cleanly, and that all the memory
+  can be allocated again once another processor freed it.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ExhaustedPoolShouldRecover (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8    Buffer[SIZE_64KB];
+  MP_POOL  *Pool;
+  VOID     *Blocks[SIZE_64KB / 64];
+  UINTN    Count;
+  UINTN    Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (MpPoolInitialize (Buffer, sizeof (Buffer), 2, &Pool));
+
+  for (Count = 0; Count < ARRAY_SIZE (Blocks); Count++) {
+    Blocks[Count] = MpPoolAllocate (Pool, 0, 48);
+    if (Blocks[Count] == NULL) {
+      break;
+    }
+  }
+
+  UT_ASSERT_TRUE (Count > 0);
+  UT_ASSERT_TRUE (Count < ARRAY_SIZE (Blocks));
+
+  for (Index = 0; Index < Count; Index++) {
+    MpPoolFree (Pool, 1, Blocks[Index]);
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Blocks[Index] = MpPoolAllocate (Pool, 1, 48);
+    UT_ASSERT_NOT_NULL (Blocks[Index]);
+  }
+
+  UT_ASSERT_TRUE (MpPoolAllocate (Pool, 1, 48) == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Interleave random allocations and frees of TEST_CPU_COUNT simulated
+  processors, including frees of blocks allocated by another processor.
+  Every live block carries a fill pattern that is verified before it is
+  freed, so two live blocks overlapping each other is detected.
+
+  @param[in]  Context    Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InterleavedCpusShouldNotCorruptBlocks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN            Round;
+  UINTN            Cpu;
+  UINTN            Index;
+  UINTN            Offset;
+  TEST_ALLOCATION  *Slot;
+
+  for (Round = 0; Round < TEST_STRESS_ROUNDS; Round++) {
+    Cpu  = TestRandom () % TEST_CPU_COUNT;
+    Slot = &mTestContext.Slots[TestRandom () % TEST_CPU_COUNT][TestRandom () % TEST_SLOTS_PER_CPU];
+
+    if (Slot->Buffer != NULL) {
+      for (Offset = 0; Offset < Slot->Size; Offset++) {
+        UT_ASSERT_EQUAL (Slot->Buffer[Offset], Slot->Tag);
+      }
+
+      MpPoolFree (mTestContext.Pool, Cpu, Slot->Buffer);
+      Slot->Buffer = NULL;
+    } else {
+      Slot->Size   = (TestRandom () % MP_POOL_MAX_ALLOCATION_SIZE) + 1;
+      Slot->Tag    = (UINT8)Round;
+      Slot->Buffer = MpPoolAllocate (mTestContext.Pool, Cpu, Slot->Size);
+      UT_ASSERT_NOT_NULL (Slot->Buffer);
+      SetMem (Slot->Buffer, Slot->Size, Slot->Tag);
+    }
+  }
+
+  for (Cpu = 0; Cpu < TEST_CPU_COUNT; Cpu++) {
+    for (Index = 0; Index < TEST_SLOTS_PER_CPU; Index++) {
+      Slot = &mTestContext.Slots[Cpu][Index];
+      if (Slot->Buffer != NULL) {
+        for (Offset = 0; Offset < Slot->Size; Offset++) {
+          UT_ASSERT_EQUAL (Slot->Buffer[Offset], Slot->Tag);
+        }
+
+        MpPoolFree (mTestContext.Pool, Cpu, Slot->Buffer);
+        Slot->Buffer = NULL;
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  MpPoolLib and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PoolTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the MpPoolLib Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&PoolTests, Framework, "MpPoolLib Allocation Tests", "MpPoolLib.Allocation", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MpPoolLib Allocation Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // --------------Suite--------Description-----------------------------Name-------------Function--------------------------------Pre--------Post---------Context-----------
+  //
+  AddTestCase (PoolTests, "Reject bad parameters", "Initialize", InitializeShouldRejectBadParameters, NULL, NULL, NULL);
+  AddTestCase (PoolTests, "Honor size and alignment", "Allocate", AllocateShouldHonorSizeAndAlignment, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Recycle freed blocks on the same CPU", "Recycle", FreeShouldRecycleOnSameCpu, PoolSetup, PoolCleanup, NULL);
+  AddTestCase (PoolTests, "Recover from an exhausted pool", "Exhaust", ExhaustedPoolShouldRecover, NULL, NULL, NULL);
+  AddTestCase (PoolTests, "Interleave many CPUs", "Stress", InterleavedCpusShouldNotCorruptBlocks, PoolSetup, PoolCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define MpPoolLibUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+MpPoolLibUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
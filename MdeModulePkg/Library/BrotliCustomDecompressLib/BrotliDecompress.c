@@ -298,3 +298,182 @@ BrotliUefiDecompress (
 
   return Status;
 }
+
+/**
+  Decompresses a Brotli compressed source that is read in parts.
+
+  The decoder reads directly from the parts of the source and keeps the data
+  that later data may refer to in its own ring buffer in the window buffer.
+  If Destination is not NULL, the decompressed data is produced straight in it.
+  Otherwise it is produced in a FILE_BUFFER_SIZE buffer of the window buffer
+  that is passed to WriteOutput each time the decoder returns, so the
+  uncompressed data never has to be held as a whole.
+
+  @param  ReadInput        The function that returns the parts of the compressed data.
+  @param  WriteOutput      The function that receives the parts of the decompressed
+                           data when Destination is NULL.
+  @param  Context          The context passed to ReadInput and WriteOutput.
+  @param  Destination      The buffer that receives the whole decompressed data, or NULL.
+  @param  Window           The window buffer that is used to perform the decompression.
+  @param  WindowSize       The size of the window buffer, as returned by
+                           BrotliUefiDecompressGetInfo() as the scratch size.
+
+  @retval EFI_SUCCESS     Decompression completed successfully, and all of the
+                          uncompressed data was returned in Destination or
+                          passed to WriteOutput.
+  @retval EFI_INVALID_PARAMETER
+                          The compressed data is corrupted, truncated, does not
+                          decompress to the size in its header, or needs a larger
+                          window buffer.
+  @retval Others          The return status from ReadInput or WriteOutput.
+**/
+EFI_STATUS
+EFIAPI
+BrotliUefiDecompressStream (
+  IN     EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN     EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN     VOID                                 *Context,
+  OUT    VOID                                 *Destination OPTIONAL,
+  IN OUT VOID                                 *Window,
+  IN     UINT32                               WindowSize
+  )
+{
+  EFI_STATUS           Status;
+  UINT8                Header[BROTLI_SCRATCH_MAX];
+  UINTN                HeaderSize;
+  CONST UINT8          *Input;
+  UINTN                InputSize;
+  UINTN                InputUsed;
+  UINT64               DestinationSize;
+  UINT64               Written;
+  UINT8                *Output;
+  UINT8                *OutputStart;
+  const UINT8          *NextIn;
+  UINT8                *NextOut;
+  size_t               AvailableIn;
+  size_t               AvailableOut;
+  BrotliDecoderResult  Result;
+  BrotliDecoderState   *BroState;
+  BROTLI_BUFF          BroBuff;
+
+  //
+  // The header may be split over several parts of the source.
+  //
+  InputSize = 0;
+  for (HeaderSize = 0; HeaderSize < BROTLI_SCRATCH_MAX; HeaderSize += InputUsed) {
+    Status = ReadInput (Context, (CONST VOID **)&Input, &InputSize);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (InputSize == 0) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    InputUsed = MIN (InputSize, BROTLI_SCRATCH_MAX - HeaderSize);
+    CopyMem (Header + HeaderSize, Input, InputUsed);
+    Input     += InputUsed;
+    InputSize -= InputUsed;
+  }
+
+  DestinationSize = BrGetDecodedSizeOfBuf (Header, BROTLI_DECODE_MAX - BROTLI_INFO_SIZE, BROTLI_DECODE_MAX);
+  if (BrGetDecodedSizeOfBuf (Header, BROTLI_SCRATCH_MAX - BROTLI_INFO_SIZE, BROTLI_SCRATCH_MAX) > WindowSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  BroBuff.Buff     = Window;
+  BroBuff.BuffSize = WindowSize;
+
+  BroState = BrotliDecoderCreateInstance (BrAlloc, BrFree, &BroBuff);
+  if (BroState == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Output = NULL;
+  if (Destination == NULL) {
+    Output = (UINT8 *)BrAlloc (&BroBuff, FILE_BUFFER_SIZE);
+    if (Output == NULL) {
+      BrotliDecoderDestroyInstance (BroState);
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  Status      = EFI_SUCCESS;
+  Written     = 0;
+  NextIn      = Input;
+  AvailableIn = InputSize;
+  while (TRUE) {
+    if (Destination != NULL) {
+      NextOut      = (UINT8 *)Destination + Written;
+      AvailableOut = (size_t)(DestinationSize - Written);
+    } else {
+      NextOut      = Output;
+      AvailableOut = FILE_BUFFER_SIZE;
+    }
+
+    OutputStart = NextOut;
+    Result      = BrotliDecoderDecompressStream (
+                    BroState,
+                    &AvailableIn,
+                    &NextIn,
+                    &AvailableOut,
+                    &NextOut,
+                    NULL
+                    );
+
+    if (NextOut != OutputStart) {
+      if ((UINT64)(NextOut - OutputStart) > DestinationSize - Written) {
+        Status = EFI_INVALID_PARAMETER;
+        break;
+      }
+
+      if (Destination == NULL) {
+        Status = WriteOutput (Context, OutputStart, (UINTN)(NextOut - OutputStart));
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+      }
+
+      Written += (UINT64)(NextOut - OutputStart);
+    }
+
+    if (Result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+      //
+      // Destination is full, so the data decodes to more than its header says.
+      //
+      if (Destination != NULL) {
+        Status = EFI_INVALID_PARAMETER;
+        break;
+      }
+
+      continue;
+    }
+
+    if (Result != BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+      break;
+    }
+
+    Status = ReadInput (Context, (CONST VOID **)&NextIn, &InputSize);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (InputSize == 0) {
+      break;
+    }
+
+    AvailableIn = InputSize;
+  }
+
+  BrotliDecoderDestroyInstance (BroState);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((Result != BROTLI_DECODER_RESULT_SUCCESS) || (Written != DestinationSize)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
@@ -13,6 +13,7 @@
 
 #include <PiPei.h>
 #include <Library/ExtractGuidedSectionLib.h>
+#include <Library/ExtractGuidedSectionStreamLib.h>
 #include <brotli/c/include/brotli/types.h>
 #include <brotli/c/include/brotli/decode.h>
 
@@ -44,4 +45,30 @@ BrotliUefiDecompress (
   IN OUT VOID    *Scratch
   );
 
+EFI_STATUS
+EFIAPI
+BrotliUefiDecompressStream (
+  IN     EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN     EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN     VOID                                 *Context,
+  OUT    VOID                                 *Destination OPTIONAL,
+  IN OUT VOID                                 *Window,
+  IN     UINT32                               WindowSize
+  );
+
+RETURN_STATUS
+EFIAPI
+BrotliGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  );
+
+EFI_STATUS
+EFIAPI
+BrotliDecompressLibConstructor (
+  VOID
+  );
+
 #endif
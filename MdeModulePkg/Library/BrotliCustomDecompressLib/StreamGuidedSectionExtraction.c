@@ -0,0 +1,111 @@
+/** @file
+  BROTLI Decompress GUIDed Section Extraction Library with stream decode handlers.
+  It wraps the Brotli stream decompress interface to a stream decode handler and
+  registers it, together with the regular GUIDed section handlers, into the
+  GUIDed handler tables.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <BrotliDecompressLibInternal.h>
+
+/**
+  Decompress a BROTLI compressed GUIDed section whose data is read in parts.
+
+  The data is decoded as it is read, so the caller may read the next part of the
+  section while the previous one is decoded. The decoded data is produced straight
+  in OutputBuffer if it is given, otherwise it is passed to WriteOutput in parts.
+
+  @param[in]  InputSection      A pointer to the headers of a GUIDed section of an FFS formatted file.
+  @param[in]  ReadInput         The function that returns the parts of the section data.
+  @param[in]  WriteOutput       The function that receives the parts of the decoded data
+                                when OutputBuffer is NULL.
+  @param[in]  Context           The context passed to ReadInput and WriteOutput.
+  @param[out] OutputBuffer      A caller allocated buffer that receives the whole decoded data, or NULL.
+  @param[in]  WorkBuffer        A caller allocated buffer that is used to perform the decode operation.
+  @param[in]  WorkBufferSize    The size, in bytes, of WorkBuffer.
+  @param[out] AuthenticationStatus
+                                A pointer to the authentication status of the decoded data.
+
+  @retval  RETURN_SUCCESS            The section data was decoded into OutputBuffer, or passed to WriteOutput.
+  @retval  RETURN_INVALID_PARAMETER  The section data can not be decoded.
+  @retval  Others                    The return status from ReadInput or WriteOutput.
+
+**/
+RETURN_STATUS
+EFIAPI
+BrotliGuidedSectionStreamExtraction (
+  IN CONST  VOID                                 *InputSection,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN        VOID                                 *Context,
+  OUT       VOID                                 *OutputBuffer OPTIONAL,
+  IN        VOID                                 *WorkBuffer,
+  IN        UINT32                               WorkBufferSize,
+  OUT       UINT32                               *AuthenticationStatus
+  )
+{
+  CONST GUID  *SectionDefinitionGuid;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (ReadInput != NULL);
+  ASSERT (OutputBuffer != NULL || WriteOutput != NULL);
+  ASSERT (WorkBuffer != NULL);
+
+  if (IS_SECTION2 (InputSection)) {
+    SectionDefinitionGuid = &(((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid);
+  } else {
+    SectionDefinitionGuid = &(((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid);
+  }
+
+  if (!CompareGuid (&gBrotliCustomDecompressGuid, SectionDefinitionGuid)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // Authentication is set to Zero, which may be ignored.
+  //
+  *AuthenticationStatus = 0;
+
+  return BrotliUefiDecompressStream (
+           ReadInput,
+           WriteOutput,
+           Context,
+           OutputBuffer,
+           WorkBuffer,
+           WorkBufferSize
+           );
+}
+
+/**
+  Register the handlers of BrotliDecompressLibConstructor(), and the stream handlers
+  with BrotliCustomerDecompressGuid.
+
+  The scratch buffer returned by BrotliGuidedSectionGetInfo() already holds the decoder
+  with its ring buffer and two FILE_BUFFER_SIZE buffers, so it serves as the window
+  buffer of the stream decode handler as well.
+
+  @retval  EFI_SUCCESS            Register successfully.
+  @retval  EFI_OUT_OF_RESOURCES   No enough memory to store this handler.
+**/
+EFI_STATUS
+EFIAPI
+BrotliStreamDecompressLibConstructor (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = BrotliDecompressLibConstructor ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return ExtractGuidedSectionRegisterStreamHandler (
+           &gBrotliCustomDecompressGuid,
+           BrotliGuidedSectionGetInfo,
+           BrotliGuidedSectionStreamExtraction
+           );
+}
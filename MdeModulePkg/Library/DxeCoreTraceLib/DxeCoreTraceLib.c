@@ -0,0 +1,918 @@
+/** @file
+  DXE Core boot service trace.
+
+  This library is linked into the DXE Core as a NULL library class instance.
+  Its constructor replaces the boot services listed in DXE_CORE_TRACE_SERVICE
+  in gBS with wrappers that record every call, its caller, its status and its
+  duration into a ring of DXE_CORE_TRACE_ENTRY records. The ring is published
+  as the gEdkiiDxeCoreTraceTableGuid configuration table. The constructor runs
+  before the boot services table of the DXE Core is complete, the DXE Core
+  computes its CRC once the Runtime Architectural Protocol is installed.
+
+  Boot services only run on the BSP, so calls made on another stack than the
+  one of the BSP are passed on without being recorded. The only concurrent
+  writer of the ring is then code that runs from a timer interrupt at a raised
+  TPL. A slot is claimed with interrupts disabled for a few instructions; the
+  trace never takes a lock or raises the TPL, so it does not change the TPL
+  rules of the services it observes.
+
+  InstallMultipleProtocolInterfaces() and UninstallMultipleProtocolInterfaces()
+  are not traced. They take a variable argument list, which a wrapper cannot
+  forward to the original service, and the DXE Core implements them by
+  calling its protocol services directly rather than through gBS, so the
+  protocols they install or uninstall do not show up in the ring either.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+#include <Guid/DxeCoreTrace.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+STATIC DXE_CORE_TRACE_HEADER  *mTraceHeader = NULL;
+STATIC DXE_CORE_TRACE_ENTRY   *mTraceEntries;
+STATIC UINT64                 mTraceMask;
+STATIC UINT32                 mTraceDepth;
+
+//
+// The stack of the BSP, the whole address space if it is not described by
+// a HOB
+//
+STATIC UINTN  mTraceBspStackBase  = 0;
+STATIC UINTN  mTraceBspStackLimit = MAX_UINTN;
+
+//
+// The boot services as they were before the trace wrappers were installed
+//
+STATIC EFI_BOOT_SERVICES  mTraceOriginalServices;
+
+/**
+  Returns the number of performance counter ticks between two counter values,
+  taking the direction and the wrap of the counter into account.
+
+  @param  Begin                 Counter value at the start of the interval.
+  @param  End                   Counter value at the end of the interval.
+
+  @return The number of ticks between Begin and End.
+
+**/
+STATIC
+UINT64
+CoreTraceElapsed (
+  IN UINT64  Begin,
+  IN UINT64  End
+  )
+{
+  UINT64  CounterStart;
+  UINT64  CounterEnd;
+
+  CounterStart = mTraceHeader->CounterStart;
+  CounterEnd   = mTraceHeader->CounterEnd;
+
+  if (CounterEnd >= CounterStart) {
+    if (End >= Begin) {
+      return End - Begin;
+    }
+
+    return (CounterEnd - Begin) + (End - CounterStart);
+  }
+
+  if (Begin >= End) {
+    return Begin - End;
+  }
+
+  return (Begin - CounterEnd) + (CounterStart - End);
+}
+
+/**
+  Claims the next record of the ring for a boot service call that is about to
+  be made.
+
+  @param  Service               DXE_CORE_TRACE_SERVICE of the call.
+  @param  Caller                Return address into the caller of the service.
+  @param  Argument              Service specific argument, see DXE_CORE_TRACE_ENTRY.
+  @param  Sequence              Returns the sequence number of the record.
+
+  @return The record describing the call, or NULL if the caller does not run
+          on the stack of the BSP.
+
+**/
+STATIC
+DXE_CORE_TRACE_ENTRY *
+CoreTraceBegin (
+  IN  UINT32  Service,
+  IN  VOID    *Caller,
+  IN  UINT64  Argument,
+  OUT UINT64  *Sequence
+  )
+{
+  BOOLEAN               InterruptState;
+  DXE_CORE_TRACE_ENTRY  *Entry;
+
+  if (((UINTN)&Entry < mTraceBspStackBase) || ((UINTN)&Entry >= mTraceBspStackLimit)) {
+    return NULL;
+  }
+
+  InterruptState = SaveAndDisableInterrupts ();
+
+  *Sequence        = mTraceHeader->Head++;
+  Entry            = &mTraceEntries[*Sequence & mTraceMask];
+  Entry->Sequence  = *Sequence;
+  Entry->Timestamp = GetPerformanceCounter ();
+  Entry->Duration  = MAX_UINT64;
+  Entry->Caller    = (UINT64)(UINTN)Caller;
+  Entry->Argument  = Argument;
+  Entry->Status    = 0;
+  Entry->Service   = Service;
+  Entry->Depth     = mTraceDepth++;
+
+  SetInterruptState (InterruptState);
+
+  return Entry;
+}
+
+/**
+  Completes the record of a boot service call. Nothing is recorded if the
+  ring wrapped around while the call was in progress.
+
+  @param  Entry                 The record returned by CoreTraceBegin(), or NULL.
+  @param  Sequence              The sequence number returned by CoreTraceBegin().
+  @param  Status                The status returned by the service.
+
+  @return Status.
+
+**/
+STATIC
+EFI_STATUS
+CoreTraceEnd (
+  IN DXE_CORE_TRACE_ENTRY  *Entry,
+  IN UINT64                Sequence,
+  IN EFI_STATUS            Status
+  )
+{
+  UINT64   Counter;
+  BOOLEAN  InterruptState;
+
+  if (Entry == NULL) {
+    return Status;
+  }
+
+  Counter        = GetPerformanceCounter ();
+  InterruptState = SaveAndDisableInterrupts ();
+
+  mTraceDepth--;
+  if (Entry->Sequence == Sequence) {
+    Entry->Duration = CoreTraceElapsed (Entry->Timestamp, Counter);
+    Entry->Status   = (UINT64)Status;
+  }
+
+  SetInterruptState (InterruptState);
+
+  return Status;
+}
+
+/**
+  Returns the first 8 bytes of a protocol GUID, which is how protocol services
+  identify the protocol in the trace.
+
+  @param  Protocol              The protocol GUID, or NULL.
+
+  @return The first 8 bytes of Protocol, or 0 if Protocol is NULL.
+
+**/
+STATIC
+UINT64
+CoreTraceGuidArgument (
+  IN CONST EFI_GUID  *Protocol
+  )
+{
+  if (Protocol == NULL) {
+    return 0;
+  }
+
+  return ReadUnaligned64 ((CONST UINT64 *)Protocol);
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.AllocatePages().
+
+  @param  Type                  The type of allocation to perform.
+  @param  MemoryType            The type of memory to allocate.
+  @param  NumberOfPages         The number of pages to allocate.
+  @param  Memory                A pointer to the allocated memory.
+
+  @return The status returned by AllocatePages().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceAllocatePages (
+  IN     EFI_ALLOCATE_TYPE     Type,
+  IN     EFI_MEMORY_TYPE       MemoryType,
+  IN     UINTN                 NumberOfPages,
+  IN OUT EFI_PHYSICAL_ADDRESS  *Memory
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceAllocatePages, RETURN_ADDRESS (0), EFI_PAGES_TO_SIZE ((UINT64)NumberOfPages), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.AllocatePages (Type, MemoryType, NumberOfPages, Memory));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.FreePages().
+
+  @param  Memory                Base address of memory being freed.
+  @param  NumberOfPages         The number of pages to free.
+
+  @return The status returned by FreePages().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceFreePages (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceFreePages, RETURN_ADDRESS (0), EFI_PAGES_TO_SIZE ((UINT64)NumberOfPages), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.FreePages (Memory, NumberOfPages));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.AllocatePool().
+
+  @param  PoolType              The type of pool to allocate.
+  @param  Size                  The number of bytes to allocate.
+  @param  Buffer                The address to return a pointer to the allocated pool.
+
+  @return The status returned by AllocatePool().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceAllocatePool (
+  IN  EFI_MEMORY_TYPE  PoolType,
+  IN  UINTN            Size,
+  OUT VOID             **Buffer
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceAllocatePool, RETURN_ADDRESS (0), Size, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.AllocatePool (PoolType, Size, Buffer));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.FreePool(). The size of the pool is not known, so
+  the buffer address is recorded as the argument.
+
+  @param  Buffer                The address of the pool to free.
+
+  @return The status returned by FreePool().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceFreePool (
+  IN VOID  *Buffer
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceFreePool, RETURN_ADDRESS (0), (UINT64)(UINTN)Buffer, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.FreePool (Buffer));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.CreateEvent().
+
+  @param  Type                  The type of event to create and its mode and attributes.
+  @param  NotifyTpl             The task priority level of event notifications.
+  @param  NotifyFunction        Pointer to the event's notification function.
+  @param  NotifyContext         Pointer to the notification function's context.
+  @param  Event                 Pointer to the newly created event.
+
+  @return The status returned by CreateEvent().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN  VOID              *NotifyContext  OPTIONAL,
+  OUT EFI_EVENT         *Event
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceCreateEvent, RETURN_ADDRESS (0), (UINT64)(UINTN)NotifyFunction, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.CreateEvent (Type, NotifyTpl, NotifyFunction, NotifyContext, Event));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.SignalEvent().
+
+  @param  UserEvent             The event to signal.
+
+  @return The status returned by SignalEvent().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceSignalEvent (
+  IN EFI_EVENT  UserEvent
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceSignalEvent, RETURN_ADDRESS (0), (UINT64)(UINTN)UserEvent, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.SignalEvent (UserEvent));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.InstallProtocolInterface().
+
+  @param  UserHandle            The handle to install the protocol handler on,
+                                or NULL if a new handle is to be allocated.
+  @param  Protocol              The protocol to add to the handle.
+  @param  InterfaceType         Indicates whether Interface is supplied in native form.
+  @param  Interface             The interface for the protocol being added.
+
+  @return The status returned by InstallProtocolInterface().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceInstallProtocolInterface (
+  IN OUT EFI_HANDLE      *UserHandle,
+  IN EFI_GUID            *Protocol,
+  IN EFI_INTERFACE_TYPE  InterfaceType,
+  IN VOID                *Interface
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceInstallProtocolInterface, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.InstallProtocolInterface (UserHandle, Protocol, InterfaceType, Interface));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.ReinstallProtocolInterface().
+
+  @param  UserHandle            Handle on which the interface is to be reinstalled.
+  @param  Protocol              The numeric ID of the interface.
+  @param  OldInterface          A pointer to the old interface.
+  @param  NewInterface          A pointer to the new interface.
+
+  @return The status returned by ReinstallProtocolInterface().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceReinstallProtocolInterface (
+  IN EFI_HANDLE  UserHandle,
+  IN EFI_GUID    *Protocol,
+  IN VOID        *OldInterface,
+  IN VOID        *NewInterface
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceReinstallProtocolInterface, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.ReinstallProtocolInterface (UserHandle, Protocol, OldInterface, NewInterface));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.UninstallProtocolInterface().
+
+  @param  UserHandle            The handle to remove the protocol handler from.
+  @param  Protocol              The protocol, of protocol:interface, to remove.
+  @param  Interface             The interface, of protocol:interface, to remove.
+
+  @return The status returned by UninstallProtocolInterface().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceUninstallProtocolInterface (
+  IN EFI_HANDLE  UserHandle,
+  IN EFI_GUID    *Protocol,
+  IN VOID        *Interface
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceUninstallProtocolInterface, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.UninstallProtocolInterface (UserHandle, Protocol, Interface));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.HandleProtocol().
+
+  @param  UserHandle            The handle being queried.
+  @param  Protocol              The published unique identifier of the protocol.
+  @param  Interface             Supplies the address where a pointer to the
+                                corresponding Protocol Interface is returned.
+
+  @return The status returned by HandleProtocol().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceHandleProtocol (
+  IN EFI_HANDLE  UserHandle,
+  IN EFI_GUID    *Protocol,
+  OUT VOID       **Interface
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceHandleProtocol, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.HandleProtocol (UserHandle, Protocol, Interface));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.LocateHandle().
+
+  @param  SearchType            The type of search to perform to locate the handles.
+  @param  Protocol              The protocol to search for.
+  @param  SearchKey             Dependent on SearchType.
+  @param  BufferSize            On input the size of Buffer. On output the
+                                size of data returned.
+  @param  Buffer                The buffer in which to return the results.
+
+  @return The status returned by LocateHandle().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceLocateHandle (
+  IN     EFI_LOCATE_SEARCH_TYPE  SearchType,
+  IN     EFI_GUID                *Protocol   OPTIONAL,
+  IN     VOID                    *SearchKey  OPTIONAL,
+  IN OUT UINTN                   *BufferSize,
+  OUT    EFI_HANDLE              *Buffer
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceLocateHandle, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.LocateHandle (SearchType, Protocol, SearchKey, BufferSize, Buffer));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.LocateDevicePath().
+
+  @param  Protocol              The protocol to search for.
+  @param  DevicePath            On input, a pointer to a pointer to the device
+                                path. On output, the device path pointer is
+                                modified to point to the remaining part of the
+                                device path.
+  @param  Device                A pointer to the returned device handle.
+
+  @return The status returned by LocateDevicePath().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceLocateDevicePath (
+  IN     EFI_GUID                  *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL  **DevicePath,
+  OUT    EFI_HANDLE                *Device
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceLocateDevicePath, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.LocateDevicePath (Protocol, DevicePath, Device));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.LoadImage().
+
+  @param  BootPolicy            If TRUE, indicates that the request originates
+                                from the boot manager.
+  @param  ParentImageHandle     The caller's image handle.
+  @param  FilePath              The specific file path from which the image is loaded.
+  @param  SourceBuffer          If not NULL, a pointer to the memory location
+                                containing a copy of the image to be loaded.
+  @param  SourceSize            The size in bytes of SourceBuffer.
+  @param  ImageHandle           Pointer to the returned image handle.
+
+  @return The status returned by LoadImage().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceLoadImage (
+  IN BOOLEAN                   BootPolicy,
+  IN EFI_HANDLE                ParentImageHandle,
+  IN EFI_DEVICE_PATH_PROTOCOL  *FilePath,
+  IN VOID                      *SourceBuffer   OPTIONAL,
+  IN UINTN                     SourceSize,
+  OUT EFI_HANDLE               *ImageHandle
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceLoadImage, RETURN_ADDRESS (0), SourceSize, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.LoadImage (BootPolicy, ParentImageHandle, FilePath, SourceBuffer, SourceSize, ImageHandle));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.StartImage().
+
+  @param  ImageHandle           Handle of image to be started.
+  @param  ExitDataSize          Pointer of the size to ExitData.
+  @param  ExitData              Pointer to a pointer to a data buffer that
+                                includes a Null-terminated string, optionally
+                                followed by additional binary data.
+
+  @return The status returned by StartImage().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceStartImage (
+  IN EFI_HANDLE  ImageHandle,
+  OUT UINTN      *ExitDataSize,
+  OUT CHAR16     **ExitData  OPTIONAL
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceStartImage, RETURN_ADDRESS (0), (UINT64)(UINTN)ImageHandle, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.StartImage (ImageHandle, ExitDataSize, ExitData));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.ConnectController().
+
+  @param  ControllerHandle      The handle of the controller to which driver(s) are to be connected.
+  @param  DriverImageHandle     A pointer to an ordered list handles that support the
+                                EFI_DRIVER_BINDING_PROTOCOL.
+  @param  RemainingDevicePath   A pointer to the device path that specifies a child of the
+                                controller specified by ControllerHandle.
+  @param  Recursive             If TRUE, then ConnectController() is called recursively
+                                until the entire tree of controllers below the controller
+                                specified by ControllerHandle have been created.
+
+  @return The status returned by ConnectController().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceConnectController (
+  IN  EFI_HANDLE                ControllerHandle,
+  IN  EFI_HANDLE                *DriverImageHandle    OPTIONAL,
+  IN  EFI_DEVICE_PATH_PROTOCOL  *RemainingDevicePath  OPTIONAL,
+  IN  BOOLEAN                   Recursive
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceConnectController, RETURN_ADDRESS (0), (UINT64)(UINTN)ControllerHandle, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.ConnectController (ControllerHandle, DriverImageHandle, RemainingDevicePath, Recursive));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.DisconnectController().
+
+  @param  ControllerHandle      The handle of the controller from which driver(s)
+                                are to be disconnected.
+  @param  DriverImageHandle     The driver to disconnect from ControllerHandle.
+  @param  ChildHandle           The handle of the child to destroy.
+
+  @return The status returned by DisconnectController().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceDisconnectController (
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  EFI_HANDLE  DriverImageHandle  OPTIONAL,
+  IN  EFI_HANDLE  ChildHandle        OPTIONAL
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceDisconnectController, RETURN_ADDRESS (0), (UINT64)(UINTN)ControllerHandle, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.DisconnectController (ControllerHandle, DriverImageHandle, ChildHandle));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.OpenProtocol().
+
+  @param  UserHandle            The handle to obtain the protocol interface on.
+  @param  Protocol              The ID of the protocol.
+  @param  Interface             The location to return the protocol interface.
+  @param  ImageHandle           The handle of the Image that is opening the
+                                protocol interface specified by Protocol and
+                                Interface.
+  @param  ControllerHandle      The controller handle that is requiring this
+                                interface.
+  @param  Attributes            The open mode of the protocol interface
+                                specified by Handle and Protocol.
+
+  @return The status returned by OpenProtocol().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceOpenProtocol (
+  IN  EFI_HANDLE  UserHandle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface OPTIONAL,
+  IN  EFI_HANDLE  ImageHandle,
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  UINT32      Attributes
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceOpenProtocol, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.OpenProtocol (UserHandle, Protocol, Interface, ImageHandle, ControllerHandle, Attributes));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.CloseProtocol().
+
+  @param  UserHandle            The handle for the protocol interface that was
+                                previously opened with OpenProtocol(), and is
+                                now being closed.
+  @param  Protocol              The published unique identifier of the protocol.
+  @param  AgentHandle           The handle of the agent that is closing the
+                                protocol interface.
+  @param  ControllerHandle      If the agent that opened a protocol is a driver
+                                that follows the EFI Driver Model, then this
+                                parameter is the controller handle that required
+                                the protocol interface.
+
+  @return The status returned by CloseProtocol().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceCloseProtocol (
+  IN  EFI_HANDLE  UserHandle,
+  IN  EFI_GUID    *Protocol,
+  IN  EFI_HANDLE  AgentHandle,
+  IN  EFI_HANDLE  ControllerHandle
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceCloseProtocol, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.CloseProtocol (UserHandle, Protocol, AgentHandle, ControllerHandle));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.LocateHandleBuffer().
+
+  @param  SearchType            Specifies which handle(s) are to be returned.
+  @param  Protocol              Provides the protocol to search by.
+  @param  SearchKey             Supplies the search key depending on the
+                                SearchType.
+  @param  NumberHandles         The number of handles returned in Buffer.
+  @param  Buffer                A pointer to the buffer to return the requested
+                                array of handles that support Protocol.
+
+  @return The status returned by LocateHandleBuffer().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceLocateHandleBuffer (
+  IN EFI_LOCATE_SEARCH_TYPE  SearchType,
+  IN EFI_GUID                *Protocol OPTIONAL,
+  IN VOID                    *SearchKey OPTIONAL,
+  IN OUT UINTN               *NumberHandles,
+  OUT EFI_HANDLE             **Buffer
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceLocateHandleBuffer, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.LocateHandleBuffer (SearchType, Protocol, SearchKey, NumberHandles, Buffer));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.LocateProtocol().
+
+  @param  Protocol              The protocol to search for
+  @param  Registration          Optional Registration Key returned from
+                                RegisterProtocolNotify()
+  @param  Interface             Return the Protocol interface (instance).
+
+  @return The status returned by LocateProtocol().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceLocateProtocol (
+  IN  EFI_GUID  *Protocol,
+  IN  VOID      *Registration OPTIONAL,
+  OUT VOID      **Interface
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceLocateProtocol, RETURN_ADDRESS (0), CoreTraceGuidArgument (Protocol), &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.LocateProtocol (Protocol, Registration, Interface));
+}
+
+/**
+  Traced EFI_BOOT_SERVICES.CreateEventEx().
+
+  @param  Type                  The type of event to create and its mode and attributes.
+  @param  NotifyTpl             The task priority level of event notifications.
+  @param  NotifyFunction        Pointer to the event's notification function.
+  @param  NotifyContext         Pointer to the notification function's context.
+  @param  EventGroup            GUID for EventGroup if NULL act the same as
+                                gBS->CreateEvent().
+  @param  Event                 Pointer to the newly created event.
+
+  @return The status returned by CreateEventEx().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+CoreTraceCreateEventEx (
+  IN       UINT32            Type,
+  IN       EFI_TPL           NotifyTpl,
+  IN       EFI_EVENT_NOTIFY  NotifyFunction  OPTIONAL,
+  IN CONST VOID              *NotifyContext  OPTIONAL,
+  IN CONST EFI_GUID          *EventGroup     OPTIONAL,
+  OUT      EFI_EVENT         *Event
+  )
+{
+  DXE_CORE_TRACE_ENTRY  *Entry;
+  UINT64                Sequence;
+
+  Entry = CoreTraceBegin (DxeCoreTraceCreateEventEx, RETURN_ADDRESS (0), (UINT64)(UINTN)NotifyFunction, &Sequence);
+  return CoreTraceEnd (Entry, Sequence, mTraceOriginalServices.CreateEventEx (Type, NotifyTpl, NotifyFunction, NotifyContext, EventGroup, Event));
+}
+
+/**
+  Finds the stack of the BSP in the memory allocation HOBs.
+
+**/
+STATIC
+VOID
+CoreTraceFindBspStack (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+
+  Hob.Raw = GetHobList ();
+  while ((Hob.Raw = GetNextHob (EFI_HOB_TYPE_MEMORY_ALLOCATION, Hob.Raw)) != NULL) {
+    if (CompareGuid (&gEfiHobMemoryAllocStackGuid, &Hob.MemoryAllocation->AllocDescriptor.Name)) {
+      mTraceBspStackBase  = (UINTN)Hob.MemoryAllocation->AllocDescriptor.MemoryBaseAddress;
+      mTraceBspStackLimit = mTraceBspStackBase + (UINTN)Hob.MemoryAllocation->AllocDescriptor.MemoryLength;
+      return;
+    }
+
+    Hob.Raw = GET_NEXT_HOB (Hob);
+  }
+}
+
+/**
+  Allocates the trace ring, routes the traced boot services through their
+  wrappers and publishes the ring as a configuration table. Does nothing when
+  PcdDxeCoreTraceBufferEntries is zero.
+
+  The ring is allocated from runtime services data so that it can still be
+  read from the OS after ExitBootServices().
+
+  @param  ImageHandle           The firmware allocated handle for the DXE Core image.
+  @param  SystemTable           A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS           The constructor always returns EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+DxeCoreTraceLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  UINT32      EntryCount;
+  UINT64      CounterStart;
+  UINT64      CounterEnd;
+  UINT64      Frequency;
+  EFI_STATUS  Status;
+
+  EntryCount = PcdGet32 (PcdDxeCoreTraceBufferEntries);
+  if (EntryCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  EntryCount   = GetPowerOfTwo32 (EntryCount);
+  mTraceHeader = AllocateRuntimeZeroPool (sizeof (DXE_CORE_TRACE_HEADER) + (UINTN)EntryCount * sizeof (DXE_CORE_TRACE_ENTRY));
+  if (mTraceHeader == NULL) {
+    DEBUG ((DEBUG_ERROR, "DXE Core trace: cannot allocate %d records\n", EntryCount));
+    return EFI_SUCCESS;
+  }
+
+  Frequency = GetPerformanceCounterProperties (&CounterStart, &CounterEnd);
+
+  mTraceHeader->Signature    = DXE_CORE_TRACE_SIGNATURE;
+  mTraceHeader->Revision     = DXE_CORE_TRACE_REVISION;
+  mTraceHeader->HeaderSize   = sizeof (DXE_CORE_TRACE_HEADER);
+  mTraceHeader->EntrySize    = sizeof (DXE_CORE_TRACE_ENTRY);
+  mTraceHeader->EntryCount   = EntryCount;
+  mTraceHeader->Frequency    = Frequency;
+  mTraceHeader->CounterStart = CounterStart;
+  mTraceHeader->CounterEnd   = CounterEnd;
+  mTraceEntries              = (DXE_CORE_TRACE_ENTRY *)(mTraceHeader + 1);
+  mTraceMask                 = EntryCount - 1;
+
+  CoreTraceFindBspStack ();
+
+  CopyMem (&mTraceOriginalServices, gBS, sizeof (EFI_BOOT_SERVICES));
+
+  gBS->AllocatePages              = CoreTraceAllocatePages;
+  gBS->FreePages                  = CoreTraceFreePages;
+  gBS->AllocatePool               = CoreTraceAllocatePool;
+  gBS->FreePool                   = CoreTraceFreePool;
+  gBS->CreateEvent                = CoreTraceCreateEvent;
+  gBS->SignalEvent                = CoreTraceSignalEvent;
+  gBS->InstallProtocolInterface   = CoreTraceInstallProtocolInterface;
+  gBS->ReinstallProtocolInterface = CoreTraceReinstallProtocolInterface;
+  gBS->UninstallProtocolInterface = CoreTraceUninstallProtocolInterface;
+  gBS->HandleProtocol             = CoreTraceHandleProtocol;
+  gBS->LocateHandle               = CoreTraceLocateHandle;
+  gBS->LocateDevicePath           = CoreTraceLocateDevicePath;
+  gBS->LoadImage                  = CoreTraceLoadImage;
+  gBS->StartImage                 = CoreTraceStartImage;
+  gBS->ConnectController          = CoreTraceConnectController;
+  gBS->DisconnectController       = CoreTraceDisconnectController;
+  gBS->OpenProtocol               = CoreTraceOpenProtocol;
+  gBS->CloseProtocol              = CoreTraceCloseProtocol;
+  gBS->LocateHandleBuffer         = CoreTraceLocateHandleBuffer;
+  gBS->LocateProtocol             = CoreTraceLocateProtocol;
+  gBS->CreateEventEx              = CoreTraceCreateEventEx;
+
+  Status = gBS->InstallConfigurationTable (&gEdkiiDxeCoreTraceTableGuid, mTraceHeader);
+  ASSERT_EFI_ERROR (Status);
+
+  DEBUG ((DEBUG_INFO, "DXE Core trace: %d records at %p, counter %ld Hz\n", EntryCount, mTraceHeader, Frequency));
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,73 @@
+/** @file
+  Null instance of ExtractGuidedSectionStream Library.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/DebugLib.h>
+#include <Library/ExtractGuidedSectionStreamLib.h>
+
+/**
+  Registers a handler of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and a handler
+  of type EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  Stream decode handlers are not supported by this library instance.
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being registered.
+  @param[in]  StreamGetInfoHandler  The pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[in]  StreamDecodeHandler   The pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval  RETURN_UNSUPPORTED  This library instance does not support stream decode handlers.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterStreamHandler (
+  IN CONST  GUID                                            *SectionGuid,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler
+  )
+{
+  ASSERT (SectionGuid != NULL);
+  ASSERT (StreamGetInfoHandler != NULL);
+  ASSERT (StreamDecodeHandler != NULL);
+
+  return RETURN_UNSUPPORTED;
+}
+
+/**
+  Retrieves the handlers of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  No stream decode handler is registered with this library instance.
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being retrieved.
+  @param[out] StreamGetInfoHandler  Pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[out] StreamDecodeHandler   Pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval  RETURN_NOT_FOUND   No stream decode handler has been registered with the specified GUID.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionGetStreamHandler (
+  IN CONST   GUID                                            *SectionGuid,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  *StreamGetInfoHandler,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    *StreamDecodeHandler
+  )
+{
+  ASSERT (SectionGuid != NULL);
+  ASSERT (StreamGetInfoHandler != NULL);
+  ASSERT (StreamDecodeHandler != NULL);
+
+  return RETURN_NOT_FOUND;
+}
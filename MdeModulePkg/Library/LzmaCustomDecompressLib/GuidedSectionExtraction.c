@@ -183,7 +183,264 @@ LzmaGuidedSectionExtraction (
 }
 
 /**
-  Register LzmaDecompress and LzmaDecompressGetInfo handlers with LzmaCustomerDecompressGuid.
+  Get the header of a LZMA multi-stream GUIDed section and validate it.
+
+  @param[in]  InputSection      A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] Header            The header of the multi-stream data in InputSection.
+  @param[out] DataSize          The size, in bytes, of the multi-stream data.
+  @param[out] SectionAttribute  The attributes of the GUIDed section.
+
+  @retval  RETURN_SUCCESS            The header was returned.
+  @retval  RETURN_INVALID_PARAMETER  InputSection is not a valid multi-stream section.
+
+**/
+STATIC
+RETURN_STATUS
+LzmaMultiStreamGetHeader (
+  IN  CONST VOID                 *InputSection,
+  OUT LZMA_MULTI_STREAM_HEADER   **Header,
+  OUT UINT32                     *DataSize,
+  OUT UINT16                     *SectionAttribute
+  )
+{
+  if (IS_SECTION2 (InputSection)) {
+    if (!CompareGuid (
+           &gLzmaMultiStreamCustomDecompressGuid,
+           &(((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid)
+           ))
+    {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->Attributes;
+    *Header           = (LZMA_MULTI_STREAM_HEADER *)((UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset);
+    *DataSize         = SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset;
+  } else {
+    if (!CompareGuid (
+           &gLzmaMultiStreamCustomDecompressGuid,
+           &(((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid)
+           ))
+    {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION *)InputSection)->Attributes;
+    *Header           = (LZMA_MULTI_STREAM_HEADER *)((UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset);
+    *DataSize         = SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset;
+  }
+
+  if ((*DataSize < sizeof (LZMA_MULTI_STREAM_HEADER)) ||
+      ((*Header)->Signature != LZMA_MULTI_STREAM_SIGNATURE) ||
+      ((*Header)->StreamCount == 0) ||
+      ((*Header)->StreamCount > (*DataSize - sizeof (LZMA_MULTI_STREAM_HEADER)) / sizeof (UINT32)) ||
+      ((*Header)->StreamSize == 0) ||
+      (MultU64x32 ((*Header)->StreamSize, (*Header)->StreamCount - 1) >= (*Header)->DecodedSize) ||
+      (MultU64x32 ((*Header)->StreamSize, (*Header)->StreamCount) < (*Header)->DecodedSize))
+  {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Get a stream of a LZMA multi-stream GUIDed section and validate its bounds.
+
+  @param[in]  Header    The header of the multi-stream data.
+  @param[in]  DataSize  The size, in bytes, of the multi-stream data.
+  @param[in]  Index     The index of the stream.
+  @param[out] Stream    The LZMA GUIDed section of the stream.
+
+  @retval  RETURN_SUCCESS            The stream was returned.
+  @retval  RETURN_INVALID_PARAMETER  The stream is not within the multi-stream data.
+
+**/
+STATIC
+RETURN_STATUS
+LzmaMultiStreamGetStream (
+  IN  CONST LZMA_MULTI_STREAM_HEADER  *Header,
+  IN  UINT32                          DataSize,
+  IN  UINT32                          Index,
+  OUT CONST VOID                      **Stream
+  )
+{
+  UINT32  Offset;
+  UINT32  StreamSize;
+
+  Offset = ((UINT32 *)(Header + 1))[Index];
+  if (((Offset & 0x3) != 0) ||
+      (DataSize < sizeof (EFI_GUID_DEFINED_SECTION2)) ||
+      (Offset > DataSize - sizeof (EFI_GUID_DEFINED_SECTION2)))
+  {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  *Stream = (UINT8 *)Header + Offset;
+  if (IS_SECTION2 (*Stream)) {
+    StreamSize = SECTION2_SIZE (*Stream);
+    if (((EFI_GUID_DEFINED_SECTION2 *)*Stream)->DataOffset > StreamSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+  } else {
+    StreamSize = SECTION_SIZE (*Stream);
+    if (((EFI_GUID_DEFINED_SECTION *)*Stream)->DataOffset > StreamSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+  }
+
+  if ((((EFI_COMMON_SECTION_HEADER *)*Stream)->Type != EFI_SECTION_GUID_DEFINED) ||
+      (StreamSize > DataSize - Offset))
+  {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Examines a LZMA multi-stream GUIDed section and returns the size of the decoded
+  buffer and the size of the scratch buffer required to decode it.
+
+  The streams are decoded one after the other, so the scratch buffer of the
+  first stream is used for all of them.
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output buffer required
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as scratch space
+                                 if the buffer specified by InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed section. See the Attributes
+                                 field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaMultiStreamGuidedSectionGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *ScratchBufferSize,
+  OUT UINT16      *SectionAttribute
+  )
+{
+  RETURN_STATUS             Status;
+  LZMA_MULTI_STREAM_HEADER  *Header;
+  UINT32                    DataSize;
+  CONST VOID                *Stream;
+  UINT32                    StreamOutputSize;
+  UINT16                    StreamAttribute;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (ScratchBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  Status = LzmaMultiStreamGetHeader (InputSection, &Header, &DataSize, SectionAttribute);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = LzmaMultiStreamGetStream (Header, DataSize, 0, &Stream);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = LzmaGuidedSectionGetInfo (Stream, &StreamOutputSize, ScratchBufferSize, &StreamAttribute);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *OutputBufferSize = Header->DecodedSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompress a LZMA multi-stream GUIDed section into a caller allocated output buffer.
+
+  The streams are decoded one after the other into consecutive parts of the
+  output buffer. Callers that can run code on several processors can decode
+  the streams in parallel with the LZMA_CUSTOM_DECOMPRESS_GUID handler instead.
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBuffer  A pointer to a buffer that contains the result of a decode operation.
+  @param[out] ScratchBuffer A caller allocated buffer that may be required by this function
+                            as a scratch buffer to perform the decode operation.
+  @param[out] AuthenticationStatus
+                            A pointer to the authentication status of the decoded output buffer.
+
+  @retval  RETURN_SUCCESS            The buffer specified by InputSection was decoded.
+  @retval  RETURN_INVALID_PARAMETER  The section specified by InputSection can not be decoded.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaMultiStreamGuidedSectionExtraction (
+  IN CONST  VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  OUT       VOID    *ScratchBuffer         OPTIONAL,
+  OUT       UINT32  *AuthenticationStatus
+  )
+{
+  RETURN_STATUS             Status;
+  LZMA_MULTI_STREAM_HEADER  *Header;
+  UINT32                    DataSize;
+  UINT16                    SectionAttribute;
+  UINT32                    Index;
+  CONST VOID                *Stream;
+  UINT32                    StreamOutputSize;
+  UINT32                    StreamScratchSize;
+  UINT16                    StreamAttribute;
+  UINT32                    StreamAuthenticationStatus;
+  UINT8                     *Output;
+  UINT32                    Remaining;
+
+  ASSERT (OutputBuffer != NULL);
+  ASSERT (InputSection != NULL);
+
+  Status = LzmaMultiStreamGetHeader (InputSection, &Header, &DataSize, &SectionAttribute);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Authentication is set to Zero, which may be ignored.
+  //
+  *AuthenticationStatus = 0;
+
+  Output    = *OutputBuffer;
+  Remaining = Header->DecodedSize;
+  for (Index = 0; Index < Header->StreamCount; Index++) {
+    Status = LzmaMultiStreamGetStream (Header, DataSize, Index, &Stream);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = LzmaGuidedSectionGetInfo (Stream, &StreamOutputSize, &StreamScratchSize, &StreamAttribute);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    if (StreamOutputSize != MIN (Header->StreamSize, Remaining)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Status = LzmaGuidedSectionExtraction (Stream, (VOID **)&Output, ScratchBuffer, &StreamAuthenticationStatus);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    Output    += StreamOutputSize;
+    Remaining -= StreamOutputSize;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Register LzmaDecompress and LzmaDecompressGetInfo handlers with LzmaCustomerDecompressGuid,
+  and the multi-stream handlers with LzmaMultiStreamCustomDecompressGuid.
 
   @retval  RETURN_SUCCESS            Register successfully.
   @retval  RETURN_OUT_OF_RESOURCES   No enough memory to store this handler.
@@ -194,9 +451,20 @@ LzmaDecompressLibConstructor (
   VOID
   )
 {
+  RETURN_STATUS  Status;
+
+  Status = ExtractGuidedSectionRegisterHandlers (
+             &gLzmaCustomDecompressGuid,
+             LzmaGuidedSectionGetInfo,
+             LzmaGuidedSectionExtraction
+             );
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
   return ExtractGuidedSectionRegisterHandlers (
-           &gLzmaCustomDecompressGuid,
-           LzmaGuidedSectionGetInfo,
-           LzmaGuidedSectionExtraction
+           &gLzmaMultiStreamCustomDecompressGuid,
+           LzmaMultiStreamGuidedSectionGetInfo,
+           LzmaMultiStreamGuidedSectionExtraction
            );
 }
@@ -94,6 +94,33 @@ GetDecodedSizeOfBuf (
   return DecodedSize;
 }
 
+/**
+  Get the size of the dictionary needed to decode EncodedData by parsing its
+  LZMA properties.
+
+  No match of the encoded data reaches further back than the dictionary size
+  of the properties, nor than the start of the data. The size is rounded up
+  to 4KB as the decoder never uses a dictionary smaller than that.
+
+  @param EncodedData  Pointer to the compressed data.
+  @param DecodedSize  The size of the uncompressed data.
+
+  @return The size of the dictionary.
+**/
+STATIC
+UINT32
+GetDictionarySize (
+  IN UINT8   *EncodedData,
+  IN UINT32  DecodedSize
+  )
+{
+  UINT64  DictionarySize;
+
+  DictionarySize = ReadUnaligned32 ((UINT32 *)(EncodedData + 1));
+  DictionarySize = ALIGN_VALUE (DictionarySize, SIZE_4KB);
+  return (UINT32)MIN (DictionarySize, DecodedSize);
+}
+
 //
 // LZMA functions and data as defined in local LzmaDecompressLibInternal.h
 //
@@ -218,3 +245,228 @@ LzmaUefiDecompress (
     return RETURN_INVALID_PARAMETER;
   }
 }
+
+/**
+  Given a Lzma compressed source buffer, this function retrieves the size of
+  the uncompressed buffer and the size of the window buffer required to
+  decompress the compressed source when it is read in parts.
+
+  The window buffer holds the LZMA probabilities and a dictionary of the
+  size given in the LZMA properties, rounded up to 4KB, or of the size of the
+  uncompressed data if that is smaller.
+
+  If SourceSize is less than LZMA_HEADER_SIZE, then ASSERT().
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed data.
+  @param  WindowSize      A pointer to the size, in bytes, of the window buffer that
+                          is required to decompress the compressed data in parts.
+
+  @retval  RETURN_SUCCESS The size of the uncompressed data was returned
+                          in DestinationSize and the size of the window
+                          buffer was returned in WindowSize.
+
+  @retval RETURN_UNSUPPORTED  DestinationSize cannot be output because the
+                              uncompressed buffer size (in bytes) does not fit
+                              in a UINT32. Output parameters have not been
+                              modified.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaUefiDecompressStreamGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *WindowSize
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         ScratchSize;
+
+  Status = LzmaUefiDecompressGetInfo (Source, SourceSize, DestinationSize, &ScratchSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *WindowSize = ScratchSize + GetDictionarySize ((UINT8 *)Source, *DestinationSize);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompresses a Lzma compressed source that is read in parts.
+
+  If Destination is not NULL, it is the dictionary of the decoder, so the
+  uncompressed data is decoded straight into it and the window buffer only
+  holds the LZMA probabilities.
+
+  Otherwise the decoder works on a dictionary in the window buffer that is
+  used as a ring, each part of the dictionary that is decoded is passed to
+  WriteOutput before the decoder wraps around and overwrites it. So neither
+  the source nor the uncompressed data have to be held as a whole.
+
+  @param  ReadInput        The function that returns the parts of the compressed data.
+  @param  WriteOutput      The function that receives the parts of the decompressed
+                           data when Destination is NULL.
+  @param  Context          The context passed to ReadInput and WriteOutput.
+  @param  Destination      The buffer that receives the whole decompressed data, or NULL.
+  @param  Window           The window buffer that is used to perform the decompression.
+  @param  WindowSize       The size of the window buffer, as returned by
+                           LzmaUefiDecompressStreamGetInfo(), or the scratch size
+                           returned by LzmaUefiDecompressGetInfo() if Destination
+                           is not NULL.
+
+  @retval  RETURN_SUCCESS Decompression completed successfully, and all of the
+                          uncompressed data was returned in Destination or
+                          passed to WriteOutput.
+  @retval  RETURN_INVALID_PARAMETER
+                          The compressed data is corrupted, truncated, or needs
+                          a larger window buffer.
+  @retval  Others         The return status from ReadInput or WriteOutput.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaUefiDecompressStream (
+  IN     EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN     EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN     VOID                                 *Context,
+  OUT    VOID                                 *Destination OPTIONAL,
+  IN OUT VOID                                 *Window,
+  IN     UINT32                               WindowSize
+  )
+{
+  RETURN_STATUS     Status;
+  UINT8             Header[LZMA_HEADER_SIZE];
+  UINTN             HeaderSize;
+  CONST UINT8       *Input;
+  UINTN             InputSize;
+  SizeT             InputUsed;
+  UINT32            DestinationSize;
+  UINT32            DictionarySize;
+  UINT32            Written;
+  SizeT             OutputStart;
+  SizeT             OutputLimit;
+  ELzmaFinishMode   FinishMode;
+  CLzmaDec          Decoder;
+  SRes              LzmaResult;
+  ELzmaStatus       LzmaStatus;
+  ISzAllocWithData  AllocFuncs;
+
+  AllocFuncs.Functions.Alloc = SzAlloc;
+  AllocFuncs.Functions.Free  = SzFree;
+  AllocFuncs.Buffer          = Window;
+  AllocFuncs.BufferSize      = SCRATCH_BUFFER_REQUEST_SIZE;
+
+  //
+  // The header may be split over several parts of the source.
+  //
+  InputSize = 0;
+  for (HeaderSize = 0; HeaderSize < LZMA_HEADER_SIZE; HeaderSize += InputUsed) {
+    Status = ReadInput (Context, (CONST VOID **)&Input, &InputSize);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    if (InputSize == 0) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    InputUsed = MIN (InputSize, LZMA_HEADER_SIZE - HeaderSize);
+    CopyMem (Header + HeaderSize, Input, InputUsed);
+    Input     += InputUsed;
+    InputSize -= InputUsed;
+  }
+
+  if (GetDecodedSizeOfBuf (Header) > MAX_UINT32) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  DestinationSize = (UINT32)GetDecodedSizeOfBuf (Header);
+  if (Destination != NULL) {
+    DictionarySize = DestinationSize;
+  } else {
+    DictionarySize = GetDictionarySize (Header, DestinationSize);
+  }
+
+  if (WindowSize < SCRATCH_BUFFER_REQUEST_SIZE) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if ((Destination == NULL) && (WindowSize - SCRATCH_BUFFER_REQUEST_SIZE < DictionarySize)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  LzmaDec_Construct (&Decoder);
+  LzmaResult = LzmaDec_AllocateProbs (&Decoder, Header, LZMA_PROPS_SIZE, &(AllocFuncs.Functions));
+  if (LzmaResult != SZ_OK) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Destination != NULL) {
+    Decoder.dic = Destination;
+  } else {
+    Decoder.dic = (UINT8 *)Window + SCRATCH_BUFFER_REQUEST_SIZE;
+  }
+
+  Decoder.dicBufSize = DictionarySize;
+  LzmaDec_Init (&Decoder);
+
+  Written = 0;
+  while (Written < DestinationSize) {
+    //
+    // Wrap around once the dictionary is full, its data was passed on already.
+    // A dictionary in Destination holds all of the data and is never full here.
+    //
+    if (Decoder.dicPos == DictionarySize) {
+      Decoder.dicPos = 0;
+    }
+
+    //
+    // Only the last part of the data must end the stream.
+    //
+    OutputStart = Decoder.dicPos;
+    OutputLimit = MIN (DictionarySize, OutputStart + (DestinationSize - Written));
+    FinishMode  = (OutputLimit - OutputStart == DestinationSize - Written) ? LZMA_FINISH_END : LZMA_FINISH_ANY;
+    InputUsed   = InputSize;
+    LzmaResult  = LzmaDec_DecodeToDic (&Decoder, OutputLimit, Input, &InputUsed, FinishMode, &LzmaStatus);
+    if (LzmaResult != SZ_OK) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Input     += InputUsed;
+    InputSize -= InputUsed;
+
+    if (Decoder.dicPos != OutputStart) {
+      if (Destination == NULL) {
+        Status = WriteOutput (Context, Decoder.dic + OutputStart, Decoder.dicPos - OutputStart);
+        if (RETURN_ERROR (Status)) {
+          return Status;
+        }
+      }
+
+      Written += (UINT32)(Decoder.dicPos - OutputStart);
+    }
+
+    //
+    // An end mark is only allowed right after the last byte.
+    //
+    if ((LzmaStatus == LZMA_STATUS_FINISHED_WITH_MARK) && (Written != DestinationSize)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if (LzmaStatus != LZMA_STATUS_NEEDS_MORE_INPUT) {
+      continue;
+    }
+
+    Status = ReadInput (Context, (CONST VOID **)&Input, &InputSize);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    if (InputSize == 0) {
+      return RETURN_INVALID_PARAMETER;
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
@@ -15,6 +15,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ExtractGuidedSectionLib.h>
+#include <Library/ExtractGuidedSectionStreamLib.h>
 #include <Guid/LzmaDecompress.h>
 
 /**
@@ -91,4 +92,81 @@ LzmaUefiDecompress (
   IN OUT VOID    *Scratch
   );
 
+/**
+  Given a Lzma compressed source buffer, this function retrieves the size of
+  the uncompressed buffer and the size of the window buffer required to
+  decompress the compressed source when it is read in parts.
+
+  If SourceSize is less than LZMA_HEADER_SIZE, then ASSERT().
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed data.
+  @param  WindowSize      A pointer to the size, in bytes, of the window buffer that
+                          is required to decompress the compressed data in parts.
+
+  @retval  RETURN_SUCCESS The size of the uncompressed data was returned
+                          in DestinationSize and the size of the window
+                          buffer was returned in WindowSize.
+
+  @retval RETURN_UNSUPPORTED  DestinationSize cannot be output because the
+                              uncompressed buffer size (in bytes) does not fit
+                              in a UINT32. Output parameters have not been
+                              modified.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaUefiDecompressStreamGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *WindowSize
+  );
+
+/**
+  Decompresses a Lzma compressed source that is read in parts.
+
+  @param  ReadInput        The function that returns the parts of the compressed data.
+  @param  WriteOutput      The function that receives the parts of the decompressed
+                           data when Destination is NULL.
+  @param  Context          The context passed to ReadInput and WriteOutput.
+  @param  Destination      The buffer that receives the whole decompressed data, or NULL.
+  @param  Window           The window buffer that is used to perform the decompression.
+  @param  WindowSize       The size of the window buffer, as returned by
+                           LzmaUefiDecompressStreamGetInfo(), or the scratch size
+                           returned by LzmaUefiDecompressGetInfo() if Destination
+                           is not NULL.
+
+  @retval  RETURN_SUCCESS Decompression completed successfully, and all of the
+                          uncompressed data was returned in Destination or
+                          passed to WriteOutput.
+  @retval  RETURN_INVALID_PARAMETER
+                          The compressed data is corrupted, truncated, or needs
+                          a larger window buffer.
+  @retval  Others         The return status from ReadInput or WriteOutput.
+**/
+RETURN_STATUS
+EFIAPI
+LzmaUefiDecompressStream (
+  IN     EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN     EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN     VOID                                 *Context,
+  OUT    VOID                                 *Destination OPTIONAL,
+  IN OUT VOID                                 *Window,
+  IN     UINT32                               WindowSize
+  );
+
+/**
+  Register LzmaDecompress and LzmaDecompressGetInfo handlers with LzmaCustomerDecompressGuid,
+  and the multi-stream handlers with LzmaMultiStreamCustomDecompressGuid.
+
+  @retval  RETURN_SUCCESS            Register successfully.
+  @retval  RETURN_OUT_OF_RESOURCES   No enough memory to store this handler.
+**/
+EFI_STATUS
+EFIAPI
+LzmaDecompressLibConstructor (
+  VOID
+  );
+
 #endif
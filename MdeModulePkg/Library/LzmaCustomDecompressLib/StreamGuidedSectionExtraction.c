@@ -0,0 +1,174 @@
+/** @file
+  LZMA Decompress GUIDed Section Extraction Library with stream decode handlers.
+  It wraps the Lzma stream decompress interfaces to stream decode handlers and
+  registers them, together with the regular GUIDed section handlers, into the
+  GUIDed handler tables.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+
+/**
+  Examines a LZMA compressed GUIDed section and returns the size of the decoded
+  buffer and the size of the window buffer required to decode its data in parts.
+
+  @param[in]  InputSection      A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize  A pointer to the size, in bytes, of the decoded data.
+  @param[out] WindowBufferSize  A pointer to the size, in bytes, of the window buffer
+                                required to decode the section data in parts.
+  @param[out] SectionAttribute  A pointer to the attributes of the GUIDed section. See the Attributes
+                                field of EFI_GUID_DEFINED_SECTION in the PI Specification.
+
+  @retval  RETURN_SUCCESS            The information about InputSection was returned.
+  @retval  RETURN_INVALID_PARAMETER  The information can not be retrieved from the section specified by InputSection.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaGuidedSectionStreamGetInfo (
+  IN  CONST VOID  *InputSection,
+  OUT UINT32      *OutputBufferSize,
+  OUT UINT32      *WindowBufferSize,
+  OUT UINT16      *SectionAttribute
+  )
+{
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (WindowBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  if (IS_SECTION2 (InputSection)) {
+    if (!CompareGuid (
+           &gLzmaCustomDecompressGuid,
+           &(((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid)
+           ))
+    {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->Attributes;
+
+    return LzmaUefiDecompressStreamGetInfo (
+             (UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset,
+             SECTION2_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION2 *)InputSection)->DataOffset,
+             OutputBufferSize,
+             WindowBufferSize
+             );
+  } else {
+    if (!CompareGuid (
+           &gLzmaCustomDecompressGuid,
+           &(((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid)
+           ))
+    {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    *SectionAttribute = ((EFI_GUID_DEFINED_SECTION *)InputSection)->Attributes;
+
+    return LzmaUefiDecompressStreamGetInfo (
+             (UINT8 *)InputSection + ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset,
+             SECTION_SIZE (InputSection) - ((EFI_GUID_DEFINED_SECTION *)InputSection)->DataOffset,
+             OutputBufferSize,
+             WindowBufferSize
+             );
+  }
+}
+
+/**
+  Decompress a LZMA compressed GUIDed section whose data is read in parts.
+
+  The data is decoded as it is read, so the caller may read the next part of the
+  section while the previous one is decoded. OutputBuffer is the dictionary of the
+  decoder if it is given, otherwise the decoded data only ever lives in the
+  dictionary of the work buffer and is passed to WriteOutput in parts.
+
+  @param[in]  InputSection      A pointer to the headers of a GUIDed section of an FFS formatted file.
+  @param[in]  ReadInput         The function that returns the parts of the section data.
+  @param[in]  WriteOutput       The function that receives the parts of the decoded data
+                                when OutputBuffer is NULL.
+  @param[in]  Context           The context passed to ReadInput and WriteOutput.
+  @param[out] OutputBuffer      A caller allocated buffer that receives the whole decoded data, or NULL.
+  @param[in]  WorkBuffer        A caller allocated buffer that is used to perform the decode operation.
+  @param[in]  WorkBufferSize    The size, in bytes, of WorkBuffer.
+  @param[out] AuthenticationStatus
+                                A pointer to the authentication status of the decoded data.
+
+  @retval  RETURN_SUCCESS            The section data was decoded into OutputBuffer, or passed to WriteOutput.
+  @retval  RETURN_INVALID_PARAMETER  The section data can not be decoded.
+  @retval  Others                    The return status from ReadInput or WriteOutput.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaGuidedSectionStreamExtraction (
+  IN CONST  VOID                                 *InputSection,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_READ   ReadInput,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_WRITE  WriteOutput OPTIONAL,
+  IN        VOID                                 *Context,
+  OUT       VOID                                 *OutputBuffer OPTIONAL,
+  IN        VOID                                 *WorkBuffer,
+  IN        UINT32                               WorkBufferSize,
+  OUT       UINT32                               *AuthenticationStatus
+  )
+{
+  CONST GUID  *SectionDefinitionGuid;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (ReadInput != NULL);
+  ASSERT (OutputBuffer != NULL || WriteOutput != NULL);
+  ASSERT (WorkBuffer != NULL);
+
+  if (IS_SECTION2 (InputSection)) {
+    SectionDefinitionGuid = &(((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid);
+  } else {
+    SectionDefinitionGuid = &(((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid);
+  }
+
+  if (!CompareGuid (&gLzmaCustomDecompressGuid, SectionDefinitionGuid)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // Authentication is set to Zero, which may be ignored.
+  //
+  *AuthenticationStatus = 0;
+
+  return LzmaUefiDecompressStream (
+           ReadInput,
+           WriteOutput,
+           Context,
+           OutputBuffer,
+           WorkBuffer,
+           WorkBufferSize
+           );
+}
+
+/**
+  Register the handlers of LzmaDecompressLibConstructor(), and the stream handlers
+  with LzmaCustomerDecompressGuid.
+
+  @retval  RETURN_SUCCESS            Register successfully.
+  @retval  RETURN_OUT_OF_RESOURCES   No enough memory to store this handler.
+**/
+EFI_STATUS
+EFIAPI
+LzmaStreamDecompressLibConstructor (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = LzmaDecompressLibConstructor ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return ExtractGuidedSectionRegisterStreamHandler (
+           &gLzmaCustomDecompressGuid,
+           LzmaGuidedSectionStreamGetInfo,
+           LzmaGuidedSectionStreamExtraction
+           );
+}
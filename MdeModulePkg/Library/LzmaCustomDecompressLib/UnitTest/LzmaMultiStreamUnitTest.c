@@ -0,0 +1,524 @@
+/** @file
+  This is a host-based unit test for the LZMA multi-stream guided section
+  extraction.
+
+  The multi-stream data below was produced by "LzmaCompress -e --multi-stream
+  4096", the decoder must return the data it was made of and reject any
+  truncation of it and any corruption of its header and stream table.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <PiPei.h>
+#include <Guid/LzmaDecompress.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "LZMA Multi-Stream Decode Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define MULTI_STREAM_TEST_DATA_SIZE    10000
+#define MULTI_STREAM_TEST_STREAM_SIZE  SIZE_4KB
+
+typedef struct {
+  CONST CHAR8    *Name;
+  UINTN          Offset;
+  UINT32         Value;
+} MULTI_STREAM_CORRUPTION;
+
+/**
+  Runs the constructors of the libraries linked in, the custom decompress
+  libraries register their handlers there.
+
+**/
+VOID
+EFIAPI
+ProcessLibraryConstructorList (
+  VOID
+  );
+
+/// === TEST DATA ==================================================================================
+
+//
+// MULTI_STREAM_TEST_DATA_SIZE bytes of text in three streams, the last one
+// short, see GenerateMultiStreamTestData().
+//
+STATIC CONST UINT8  mMultiStreamData[] = {
+  0x4C, 0x5A, 0x4D, 0x53, 0x03, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x10, 0x27, 0x00, 0x00,
+  0x1C, 0x00, 0x00, 0x00, 0x48, 0x02, 0x00, 0x00, 0x48, 0x04, 0x00, 0x00, 0x2C, 0x02, 0x00, 0x02,
+  0x98, 0x58, 0x4E, 0xEE, 0x14, 0x39, 0x59, 0x42, 0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF,
+  0x18, 0x00, 0x01, 0x00, 0x5D, 0x00, 0x00, 0x00, 0x01, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x29, 0x9D, 0x0A, 0x46, 0x66, 0xDD, 0xD2, 0x24, 0x2A, 0x50, 0x63, 0x9C, 0x88, 0xED,
+  0x20, 0xE1, 0x4D, 0xA4, 0xF7, 0xF5, 0xCF, 0x54, 0x62, 0x87, 0x9C, 0x88, 0x87, 0xDB, 0xDC, 0x6A,
+  0x56, 0x69, 0x67, 0x27, 0x00, 0x37, 0x28, 0x84, 0xE4, 0xAC, 0xFA, 0xEE, 0x8A, 0x18, 0x70, 0xF6,
+  0x58, 0xE0, 0x4A, 0x37, 0xE1, 0xC9, 0xC2, 0x94, 0x07, 0x25, 0x19, 0x14, 0x9D, 0x1E, 0xEF, 0xCC,
+  0x84, 0x81, 0x66, 0x2A, 0x08, 0xE3, 0xDA, 0xC4, 0xC9, 0x79, 0x5D, 0x7A, 0x64, 0xB0, 0x96, 0x3A,
+  0x37, 0xBD, 0x61, 0xD4, 0x54, 0xFA, 0x93, 0x24, 0x60, 0xB6, 0xDF, 0xFF, 0xF1, 0xBD, 0x04, 0xFC,
+  0x0D, 0x33, 0x4E, 0xB1, 0xC1, 0xF0, 0x1A, 0x36, 0x6C, 0x95, 0x60, 0xC8, 0xCE, 0xE2, 0x65, 0xE1,
+  0x90, 0xC8, 0xB7, 0x9C, 0x77, 0xBE, 0xB2, 0xAD, 0xB2, 0x04, 0x94, 0x91, 0xD0, 0x37, 0x28, 0x68,
+  0xEF, 0x0F, 0x32, 0x7F, 0x7A, 0x44, 0x82, 0x27, 0xEA, 0x11, 0x3B, 0xE1, 0x45, 0x4D, 0xC4, 0x25,
+  0x1B, 0x3C, 0xEA, 0x9A, 0x19, 0xCC, 0x51, 0x56, 0xD1, 0xAA, 0x79, 0xBC, 0xBF, 0xA9, 0x7B, 0x06,
+  0xB6, 0xC5, 0x12, 0xFD, 0x4E, 0x41, 0x21, 0xC6, 0xEE, 0x60, 0xD6, 0x1E, 0x32, 0x33, 0xC0, 0x44,
+  0xC0, 0x9E, 0x65, 0x03, 0x30, 0x7B, 0x88, 0xCF, 0x4E, 0xA1, 0x8A, 0x90, 0x3C, 0x05, 0xE4, 0xDE,
+  0xE8, 0x3D, 0x6E, 0xCB, 0x13, 0xA6, 0x6F, 0x95, 0x94, 0xC3, 0x10, 0x2D, 0xDE, 0x14, 0xC9, 0x89,
+  0x3A, 0x1C, 0x36, 0x73, 0x11, 0x11, 0xBB, 0x96, 0x28, 0x7B, 0xE6, 0x4C, 0x58, 0xE3, 0x1A, 0x9A,
+  0xFB, 0x40, 0x92, 0x2A, 0x91, 0x84, 0x7C, 0x78, 0x76, 0x33, 0x33, 0xEB, 0x71, 0x71, 0x61, 0x53,
+  0x54, 0xD4, 0xD2, 0x13, 0x48, 0x01, 0xA0, 0x3B, 0x0A, 0x99, 0x49, 0x7F, 0x66, 0x5F, 0xAB, 0x2F,
+  0x30, 0x20, 0xF5, 0x57, 0x38, 0xCA, 0x78, 0xE0, 0x35, 0xFC, 0x1B, 0xDB, 0x5D, 0x66, 0x96, 0xAB,
+  0x27, 0x2C, 0x55, 0x85, 0xDA, 0x52, 0x1F, 0x25, 0xD2, 0xCC, 0x09, 0x14, 0xAA, 0x8B, 0x70, 0x8F,
+  0x50, 0x3D, 0x5E, 0x7E, 0xE7, 0x2C, 0xD3, 0x45, 0x91, 0x1D, 0xC9, 0x7E, 0x02, 0xDE, 0xCA, 0xB7,
+  0x5B, 0xE3, 0x8F, 0xF7, 0xA8, 0x3F, 0x14, 0xDE, 0x5B, 0x0D, 0x11, 0x45, 0xE8, 0xFA, 0xEB, 0x94,
+  0x4C, 0xC2, 0x63, 0x8B, 0xE4, 0xC0, 0xC1, 0xDD, 0x6C, 0x5D, 0xDF, 0xE0, 0xFA, 0xC5, 0xCC, 0x14,
+  0x4A, 0x94, 0x96, 0x4F, 0x0B, 0xEE, 0x78, 0xE9, 0x12, 0x3F, 0xFE, 0xBE, 0xDC, 0xD2, 0x01, 0xA8,
+  0xE4, 0x5F, 0x95, 0xB1, 0xB5, 0x14, 0xFE, 0xC6, 0x76, 0x8F, 0x23, 0x53, 0x5E, 0xA2, 0xA8, 0x62,
+  0xD1, 0xF8, 0x5F, 0xEA, 0x6B, 0x67, 0x50, 0x99, 0xA1, 0xDB, 0x43, 0xB9, 0xCF, 0x25, 0x20, 0x90,
+  0xAA, 0x85, 0x51, 0x29, 0x11, 0xDF, 0xD3, 0x53, 0x89, 0xB7, 0x8D, 0xE7, 0xDF, 0x4D, 0x54, 0xAD,
+  0x52, 0xA0, 0x44, 0xD9, 0x5E, 0x5A, 0x1C, 0xB2, 0x22, 0xF0, 0xBF, 0x2E, 0x64, 0x39, 0xD2, 0x63,
+  0x48, 0x56, 0xA6, 0xE9, 0x98, 0x26, 0xF4, 0x5B, 0x1D, 0x12, 0x41, 0x9E, 0xC4, 0x84, 0x62, 0x42,
+  0xDB, 0x45, 0x12, 0xA0, 0xDA, 0xD4, 0xD6, 0x99, 0xC9, 0x8A, 0x89, 0x8A, 0x07, 0x21, 0x0E, 0x21,
+  0xA9, 0xAB, 0x80, 0xE1, 0xE0, 0xC2, 0xFC, 0xAC, 0xEB, 0x3F, 0x7F, 0xD5, 0xC7, 0x8C, 0xB3, 0x85,
+  0x78, 0x5F, 0x8B, 0xEF, 0x70, 0x91, 0x70, 0x13, 0xF9, 0xD6, 0xB0, 0xC4, 0x4D, 0xC2, 0xF7, 0x1E,
+  0x54, 0x36, 0x7B, 0x84, 0x27, 0x20, 0x9E, 0x10, 0x45, 0xB4, 0x5E, 0xA8, 0x81, 0xBE, 0xA0, 0x22,
+  0x97, 0x5E, 0xB7, 0x41, 0xAF, 0x33, 0xE9, 0xB5, 0xE2, 0x19, 0x8A, 0xEC, 0xD3, 0x04, 0xA8, 0xB4,
+  0xE5, 0xF3, 0x67, 0x74, 0x46, 0xE2, 0x11, 0x3B, 0x00, 0x02, 0x00, 0x02, 0x98, 0x58, 0x4E, 0xEE,
+  0x14, 0x39, 0x59, 0x42, 0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF, 0x18, 0x00, 0x01, 0x00,
+  0x5D, 0x00, 0x00, 0x00, 0x01, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x1D,
+  0x08, 0xA7, 0x67, 0x2C, 0xC8, 0x0B, 0x0C, 0x5A, 0xB7, 0x68, 0x46, 0x05, 0x10, 0xDA, 0xBC, 0x2F,
+  0xA7, 0xB6, 0xC4, 0x8D, 0x87, 0xA4, 0x18, 0x3A, 0x45, 0xEF, 0xE3, 0xA2, 0x17, 0x60, 0x9D, 0xB1,
+  0xF2, 0x54, 0x13, 0x3E, 0x26, 0xC8, 0x7F, 0xC3, 0x23, 0x45, 0x5E, 0xBE, 0x3F, 0xCF, 0x84, 0xD2,
+  0x55, 0xBC, 0xF2, 0xA2, 0x26, 0x51, 0x4A, 0x87, 0x55, 0xB9, 0x1C, 0x06, 0xAE, 0xDC, 0x75, 0x0E,
+  0xB2, 0xF9, 0x67, 0xB4, 0x55, 0xB6, 0x2F, 0x52, 0xCA, 0x16, 0xCD, 0xB6, 0xBB, 0x2B, 0x91, 0x47,
+  0x06, 0x07, 0xF7, 0x17, 0x67, 0x98, 0x74, 0xC0, 0x1B, 0xC1, 0x16, 0x24, 0x3B, 0xD0, 0xBD, 0x5F,
+  0xBE, 0x21, 0x55, 0x79, 0xF1, 0x45, 0x60, 0x12, 0x2B, 0x75, 0xDC, 0x43, 0xCA, 0x24, 0x22, 0x72,
+  0x26, 0xF9, 0xF1, 0x98, 0x05, 0x09, 0xBB, 0xC9, 0xEC, 0xB9, 0xDB, 0x38, 0x93, 0x1F, 0xC0, 0xC6,
+  0xF4, 0x59, 0x61, 0x7D, 0x46, 0x71, 0x45, 0xFF, 0x04, 0x80, 0x82, 0x37, 0xB4, 0x84, 0x1E, 0xAE,
+  0x7E, 0xB0, 0x8D, 0xFB, 0x3A, 0xC0, 0x5D, 0x0B, 0x91, 0x6C, 0x41, 0x91, 0x19, 0x39, 0xA5, 0xB9,
+  0x30, 0x43, 0x71, 0xA0, 0x3C, 0x50, 0xB2, 0x6D, 0x06, 0xD9, 0x16, 0x4A, 0x6A, 0x06, 0x54, 0x01,
+  0xE6, 0x1D, 0xF2, 0x1D, 0x25, 0xF1, 0x26, 0xE1, 0x2F, 0x23, 0x17, 0xE7, 0x07, 0x6C, 0xF9, 0x2A,
+  0xA5, 0x59, 0x59, 0xCC, 0x40, 0x5A, 0xBE, 0xD1, 0x2B, 0x79, 0x82, 0xB4, 0x60, 0x89, 0x0E, 0x96,
+  0xC3, 0xE4, 0x95, 0x0A, 0xAD, 0x53, 0xF1, 0xA2, 0x9C, 0xD4, 0xB3, 0x26, 0x67, 0xC9, 0x6A, 0x8A,
+  0xAA, 0xC0, 0x1A, 0x70, 0x7D, 0x6A, 0xAD, 0xEF, 0xB0, 0xA6, 0xB8, 0xD3, 0x6D, 0x21, 0xF8, 0xA3,
+  0x31, 0x3B, 0xE1, 0xAA, 0xE5, 0x73, 0xCC, 0xA8, 0xE4, 0x56, 0xC3, 0xE0, 0x58, 0xA3, 0x78, 0xE0,
+  0xD9, 0x3C, 0x39, 0x36, 0x65, 0xC0, 0xFF, 0x40, 0xF2, 0x8C, 0x5B, 0x4C, 0x26, 0x51, 0x2B, 0x99,
+  0x7E, 0xD8, 0x27, 0xC5, 0xA1, 0xC7, 0x6F, 0xEE, 0x7A, 0x7B, 0x16, 0xFC, 0xCC, 0xDB, 0xCD, 0xE0,
+  0xBF, 0x10, 0x42, 0x4C, 0x15, 0x5A, 0x4A, 0x89, 0xFA, 0xC4, 0xC7, 0x9D, 0x91, 0x49, 0xCB, 0x3A,
+  0xD8, 0xAB, 0xDD, 0xAD, 0x8B, 0xDB, 0x5F, 0x90, 0x32, 0x54, 0x36, 0xFB, 0xF0, 0xA3, 0xBD, 0xD6,
+  0x3C, 0x08, 0xB0, 0x88, 0xC7, 0xB2, 0x1E, 0x83, 0x37, 0x2C, 0xE6, 0x48, 0x02, 0x3F, 0x7D, 0xC5,
+  0x51, 0xE7, 0xBC, 0xEC, 0x53, 0x28, 0xAA, 0xB2, 0x54, 0x08, 0xB4, 0x5E, 0x27, 0x3D, 0xA2, 0xCC,
+  0x31, 0xB2, 0x8D, 0x0F, 0xC3, 0xA6, 0x68, 0x78, 0xF0, 0xA7, 0x56, 0x94, 0xD9, 0xA9, 0x80, 0x2C,
+  0x2A, 0x16, 0x0A, 0xF3, 0x53, 0x2D, 0x51, 0x34, 0xC8, 0x6C, 0x8C, 0x66, 0xDE, 0xD7, 0x86, 0x3D,
+  0xEA, 0xAD, 0x61, 0x08, 0x62, 0xF8, 0xA1, 0xFB, 0x48, 0xF4, 0x3B, 0x6B, 0x30, 0xF2, 0xEB, 0xA0,
+  0x67, 0x2A, 0xDD, 0x1C, 0xD4, 0x70, 0x73, 0xFE, 0x29, 0xE9, 0xC4, 0x75, 0x07, 0x79, 0xB2, 0x1D,
+  0x80, 0x3E, 0x95, 0xCF, 0x76, 0x06, 0x9F, 0x29, 0x58, 0x31, 0x36, 0xF6, 0xBD, 0x41, 0x74, 0xE7,
+  0x0B, 0x43, 0xB6, 0x1A, 0x94, 0x02, 0x6B, 0x2A, 0x28, 0x93, 0x3B, 0x8D, 0x87, 0x1B, 0x57, 0x87,
+  0xB6, 0x6D, 0x8D, 0x14, 0xC7, 0xA0, 0xEE, 0x23, 0x36, 0xB1, 0xB2, 0x4A, 0xE8, 0xB0, 0x95, 0xBE,
+  0xB8, 0x82, 0xB9, 0x54, 0xFB, 0xF8, 0x49, 0x00, 0x38, 0x01, 0x00, 0x02, 0x98, 0x58, 0x4E, 0xEE,
+  0x14, 0x39, 0x59, 0x42, 0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF, 0x18, 0x00, 0x01, 0x00,
+  0x5D, 0x00, 0x00, 0x00, 0x01, 0x10, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x9B,
+  0x0B, 0x10, 0xE1, 0xBA, 0x74, 0x4E, 0x04, 0x2E, 0xB9, 0xD7, 0x8D, 0x84, 0xD3, 0xE5, 0x40, 0xFE,
+  0x0F, 0x7D, 0xF2, 0xFA, 0xF1, 0x9F, 0x87, 0x7F, 0xF3, 0x5C, 0xF9, 0x8F, 0x1F, 0xA4, 0x58, 0xFA,
+  0x11, 0x45, 0xB4, 0xD0, 0xE9, 0x3D, 0xC5, 0x36, 0x42, 0xBC, 0xF3, 0x36, 0xF1, 0xFF, 0xB7, 0xC2,
+  0xCF, 0x24, 0x3B, 0x46, 0x62, 0x14, 0xBD, 0xD6, 0x3A, 0x7D, 0x36, 0x24, 0xC3, 0x97, 0xE6, 0xAD,
+  0xE7, 0x30, 0x6D, 0x5B, 0xDF, 0x83, 0xF5, 0x8E, 0xD0, 0x5D, 0xEF, 0x18, 0x07, 0xD0, 0xB1, 0xA4,
+  0x56, 0x98, 0x43, 0x42, 0xA1, 0x64, 0x08, 0xA1, 0x96, 0x53, 0x71, 0x59, 0x26, 0xA6, 0x83, 0x5E,
+  0xA4, 0x98, 0xB0, 0xB8, 0xC2, 0x41, 0x06, 0x7A, 0x35, 0x69, 0x34, 0x62, 0xE0, 0xD7, 0x60, 0xC1,
+  0xCA, 0x59, 0x08, 0xA7, 0x59, 0x2F, 0xA6, 0x36, 0x6F, 0xDC, 0xBD, 0xB6, 0x93, 0x4E, 0x4F, 0xB0,
+  0x84, 0x44, 0xB3, 0x6A, 0x74, 0x39, 0xA3, 0x51, 0x01, 0x1E, 0x99, 0x9F, 0x5F, 0xDB, 0x71, 0x39,
+  0x74, 0xBA, 0xF8, 0xC0, 0x77, 0x36, 0xEA, 0x51, 0x2F, 0xFA, 0x85, 0x93, 0xD8, 0x70, 0x19, 0x17,
+  0x40, 0x17, 0x68, 0xDF, 0xDA, 0xB2, 0x11, 0x84, 0xA1, 0xAC, 0x3B, 0x7B, 0x2E, 0x2C, 0xFB, 0x47,
+  0xDA, 0xD2, 0xE5, 0xE8, 0x9B, 0x9E, 0xA2, 0x8A, 0xD5, 0xC6, 0xC1, 0xF0, 0xBC, 0x84, 0x9C, 0x5A,
+  0x93, 0x99, 0x31, 0x34, 0xF2, 0xC5, 0x96, 0x56, 0x1C, 0x37, 0xA6, 0xAA, 0x11, 0x1C, 0xD4, 0x80,
+  0xF0, 0x9E, 0x61, 0xE8, 0x27, 0x2D, 0x91, 0xE0, 0xCF, 0x77, 0x6E, 0x08, 0x8E, 0x58, 0xE2, 0x39,
+  0xC6, 0x6D, 0x00, 0x50, 0x35, 0x1B, 0x6F, 0xB4, 0xAF, 0x3F, 0xB7, 0x1C, 0x54, 0x66, 0x27, 0xC1,
+  0x90, 0x4D, 0x45, 0x19, 0xAE, 0xB4, 0x2F, 0x0D, 0x52, 0xCA, 0x14, 0x8A, 0x08, 0x67, 0x86, 0xB2,
+  0xC3, 0xDF, 0x5A, 0xBA, 0xDD, 0x4D, 0xB2, 0x5E, 0x94, 0x1B, 0xE3, 0x76, 0xCC, 0x67, 0x29, 0x00,
+};
+
+//
+// Changes of a UINT32 of mMultiStreamData that the decoder must reject.
+//
+STATIC CONST MULTI_STREAM_CORRUPTION  mCorruptions[] = {
+  { "Signature",                    OFFSET_OF (LZMA_MULTI_STREAM_HEADER, Signature),   SIGNATURE_32 ('L', 'Z', 'M', 'A') },
+  { "No stream",                    OFFSET_OF (LZMA_MULTI_STREAM_HEADER, StreamCount), 0                                 },
+  { "Too few streams",              OFFSET_OF (LZMA_MULTI_STREAM_HEADER, StreamCount), 2                                 },
+  { "Stream table beyond the data", OFFSET_OF (LZMA_MULTI_STREAM_HEADER, StreamCount), 400                               },
+  { "Stream size too small",        OFFSET_OF (LZMA_MULTI_STREAM_HEADER, StreamSize),  SIZE_2KB                          },
+  { "Stream size too large",        OFFSET_OF (LZMA_MULTI_STREAM_HEADER, StreamSize),  SIZE_8KB                          },
+  { "Decoded size too small",       OFFSET_OF (LZMA_MULTI_STREAM_HEADER, DecodedSize), MULTI_STREAM_TEST_DATA_SIZE - 1   },
+  { "Decoded size too large",       OFFSET_OF (LZMA_MULTI_STREAM_HEADER, DecodedSize), MULTI_STREAM_TEST_DATA_SIZE + 1   },
+  { "Unaligned stream",             sizeof (LZMA_MULTI_STREAM_HEADER),                 0x1E                              },
+  { "Stream beyond the data",       sizeof (LZMA_MULTI_STREAM_HEADER),                 0x580                             },
+  { "Short stream first",           sizeof (LZMA_MULTI_STREAM_HEADER),                 0x448                             },
+  { "Stream larger than the data",  0x1C,                                              0x02FFFF00                        },
+  { "Stream of another codec",      0x20,                                              0                                 }
+};
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Generates the data mMultiStreamData was compressed from.
+
+  @param[out] Buffer  Receives MULTI_STREAM_TEST_DATA_SIZE bytes.
+
+**/
+STATIC
+VOID
+GenerateMultiStreamTestData (
+  OUT UINT8  *Buffer
+  )
+{
+  CHAR8  Line[64];
+  UINTN  Offset;
+  UINTN  Length;
+  UINTN  Index;
+
+  //
+  // The lines end with a bare '\n', which AsciiSPrint() would expand to "\r\n"
+  //
+  Offset = 0;
+  for (Index = 0; Offset < MULTI_STREAM_TEST_DATA_SIZE; Index++) {
+    Length         = AsciiSPrint (Line, sizeof (Line) - 1, "Stream test line %u value 0x%X", (UINT32)Index, (UINT32)((Index * 0x35) & 0xFFFF));
+    Line[Length++] = '\n';
+    Length         = MIN (Length, MULTI_STREAM_TEST_DATA_SIZE - Offset);
+    CopyMem (Buffer + Offset, Line, Length);
+    Offset += Length;
+  }
+}
+
+/**
+  Wraps data in a GUIDed section the way GenFds does.
+
+  @param[in] Guid      The section definition GUID.
+  @param[in] Data      The section data.
+  @param[in] DataSize  Size, in bytes, of the section data.
+
+  @return The allocated GUIDed section, or NULL if out of memory.
+
+**/
+STATIC
+VOID *
+BuildGuidedSection (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *Data,
+  IN UINTN           DataSize
+  )
+{
+  EFI_GUID_DEFINED_SECTION  *Section;
+
+  Section = AllocatePool (sizeof (EFI_GUID_DEFINED_SECTION) + DataSize);
+  if (Section == NULL) {
+    return NULL;
+  }
+
+  Section->CommonHeader.Type    = EFI_SECTION_GUID_DEFINED;
+  Section->CommonHeader.Size[0] = (UINT8)(sizeof (EFI_GUID_DEFINED_SECTION) + DataSize);
+  Section->CommonHeader.Size[1] = (UINT8)((sizeof (EFI_GUID_DEFINED_SECTION) + DataSize) >> 8);
+  Section->CommonHeader.Size[2] = (UINT8)((sizeof (EFI_GUID_DEFINED_SECTION) + DataSize) >> 16);
+  CopyGuid (&Section->SectionDefinitionGuid, Guid);
+  Section->DataOffset = (UINT16)sizeof (EFI_GUID_DEFINED_SECTION);
+  Section->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+
+  CopyMem (Section + 1, Data, DataSize);
+  return Section;
+}
+
+/**
+  Decodes a GUIDed section through the registered handler.
+
+  @param[in]  Section     The GUIDed section.
+  @param[out] Output      Receives the allocated decoded data.
+  @param[out] OutputSize  Receives the size, in bytes, of the decoded data.
+
+  @retval RETURN_SUCCESS  The section was decoded into Output.
+  @retval Others          The section could not be decoded, Output is NULL.
+
+**/
+STATIC
+RETURN_STATUS
+DecodeGuidedSection (
+  IN  CONST VOID  *Section,
+  OUT UINT8       **Output,
+  OUT UINT32      *OutputSize
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         ScratchSize;
+  UINT16         Attributes;
+  VOID           *Scratch;
+  VOID           *Buffer;
+  UINT32         AuthenticationStatus;
+
+  *Output = NULL;
+  Status  = ExtractGuidedSectionGetInfo (Section, OutputSize, &ScratchSize, &Attributes);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Buffer  = AllocatePool (MAX (*OutputSize, 1));
+  Scratch = AllocatePool (MAX (ScratchSize, 1));
+  if ((Buffer == NULL) || (Scratch == NULL)) {
+    Status = RETURN_OUT_OF_RESOURCES;
+  } else {
+    *Output = Buffer;
+    Status  = ExtractGuidedSectionDecode (Section, (VOID **)Output, Scratch, &AuthenticationStatus);
+  }
+
+  if (Scratch != NULL) {
+    FreePool (Scratch);
+  }
+
+  if (RETURN_ERROR (Status) && (Buffer != NULL)) {
+    FreePool (Buffer);
+    *Output = NULL;
+  }
+
+  return Status;
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  Decodes mMultiStreamData through the registered LZMA multi-stream handler.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The streams decoded to the data they were made of.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The streams did not decode.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MultiStreamShouldDecode (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID    *Section;
+  UINT8   *Expected;
+  UINT8   *Output;
+  UINT32  OutputSize;
+
+  Section  = BuildGuidedSection (&gLzmaMultiStreamCustomDecompressGuid, mMultiStreamData, sizeof (mMultiStreamData));
+  Expected = AllocatePool (MULTI_STREAM_TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Section);
+  UT_ASSERT_NOT_NULL (Expected);
+  GenerateMultiStreamTestData (Expected);
+
+  UT_ASSERT_NOT_EFI_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize));
+  UT_ASSERT_EQUAL (OutputSize, MULTI_STREAM_TEST_DATA_SIZE);
+  UT_ASSERT_MEM_EQUAL (Output, Expected, OutputSize);
+
+  FreePool (Output);
+  FreePool (Expected);
+  FreePool (Section);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that the LZMA multi-stream handler reports the decoded size of all
+  the streams and the scratch size of one of them.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The sizes and attributes were reported.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A size or the attributes were wrong.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MultiStreamGetInfoShouldReportSizes (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8                     *Section;
+  LZMA_MULTI_STREAM_HEADER  *Header;
+  UINT32                    *StreamOffsets;
+  UINT32                    OutputSize;
+  UINT32                    ScratchSize;
+  UINT16                    Attributes;
+  UINT32                    StreamOutputSize;
+  UINT32                    StreamScratchSize;
+  UINT16                    StreamAttributes;
+  UINT32                    Index;
+
+  Section = BuildGuidedSection (&gLzmaMultiStreamCustomDecompressGuid, mMultiStreamData, sizeof (mMultiStreamData));
+  UT_ASSERT_NOT_NULL (Section);
+
+  UT_ASSERT_NOT_EFI_ERROR (ExtractGuidedSectionGetInfo (Section, &OutputSize, &ScratchSize, &Attributes));
+  UT_ASSERT_EQUAL (OutputSize, MULTI_STREAM_TEST_DATA_SIZE);
+  UT_ASSERT_EQUAL (Attributes, EFI_GUIDED_SECTION_PROCESSING_REQUIRED);
+
+  //
+  // The streams are decoded one after the other in the same scratch buffer.
+  //
+  Header        = (LZMA_MULTI_STREAM_HEADER *)(Section + sizeof (EFI_GUID_DEFINED_SECTION));
+  StreamOffsets = (UINT32 *)(Header + 1);
+  UT_ASSERT_EQUAL (Header->StreamCount, 3);
+  for (Index = 0; Index < Header->StreamCount; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (ExtractGuidedSectionGetInfo ((UINT8 *)Header + StreamOffsets[Index], &StreamOutputSize, &StreamScratchSize, &StreamAttributes));
+    UT_ASSERT_EQUAL (StreamOutputSize, MIN (MULTI_STREAM_TEST_STREAM_SIZE, MULTI_STREAM_TEST_DATA_SIZE - Index * MULTI_STREAM_TEST_STREAM_SIZE));
+    UT_ASSERT_TRUE (StreamScratchSize <= ScratchSize);
+  }
+
+  FreePool (Section);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes every truncation of mMultiStreamData.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             All the truncated data was rejected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Truncated data was decoded.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TruncatedMultiStreamShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID    *Section;
+  UINT8   *Output;
+  UINT32  OutputSize;
+  UINTN   Length;
+
+  for (Length = 0; Length < sizeof (mMultiStreamData); Length++) {
+    Section = BuildGuidedSection (&gLzmaMultiStreamCustomDecompressGuid, mMultiStreamData, Length);
+    UT_ASSERT_NOT_NULL (Section);
+    UT_ASSERT_TRUE (RETURN_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize)));
+    FreePool (Section);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes mMultiStreamData with each change of mCorruptions.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             All the corrupted data was rejected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Corrupted data was decoded.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CorruptedMultiStreamShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   *Data;
+  VOID    *Section;
+  UINT8   *Output;
+  UINT32  OutputSize;
+  UINTN   Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mCorruptions); Index++) {
+    Data = AllocateCopyPool (sizeof (mMultiStreamData), mMultiStreamData);
+    UT_ASSERT_NOT_NULL (Data);
+    WriteUnaligned32 ((UINT32 *)(Data + mCorruptions[Index].Offset), mCorruptions[Index].Value);
+
+    Section = BuildGuidedSection (&gLzmaMultiStreamCustomDecompressGuid, Data, sizeof (mMultiStreamData));
+    UT_ASSERT_NOT_NULL (Section);
+    UT_LOG_INFO ("%a\n", mCorruptions[Index].Name);
+    UT_ASSERT_TRUE (RETURN_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize)));
+
+    FreePool (Section);
+    FreePool (Data);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  LZMA multi-stream guided section extraction and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      MultiStreamTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&MultiStreamTests, Framework, "LZMA Multi-Stream Decode Tests", "MultiStream", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MultiStreamTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (MultiStreamTests, "Multi-stream data should decode", "Decode", MultiStreamShouldDecode, NULL, NULL, NULL);
+  AddTestCase (MultiStreamTests, "Multi-stream info should report the sizes", "GetInfo", MultiStreamGetInfoShouldReportSizes, NULL, NULL, NULL);
+  AddTestCase (MultiStreamTests, "Truncated multi-stream data should fail", "Truncated", TruncatedMultiStreamShouldFail, NULL, NULL, NULL);
+  AddTestCase (MultiStreamTests, "Corrupted multi-stream data should fail", "Corrupted", CorruptedMultiStreamShouldFail, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  ProcessLibraryConstructorList ();
+  UnitTestMain ();
+  return 0;
+}
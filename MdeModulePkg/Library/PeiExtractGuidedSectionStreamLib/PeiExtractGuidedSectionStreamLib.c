@@ -0,0 +1,256 @@
+/** @file
+  Provide the registry of the stream decode handlers of GUIDed sections for PEI phase.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+
+#include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/HobLib.h>
+#include <Library/PeiServicesLib.h>
+#include <Library/ExtractGuidedSectionStreamLib.h>
+#include <Ppi/ExtractGuidedSectionStream.h>
+
+#define PEI_EXTRACT_STREAM_HANDLER_INFO_SIGNATURE  SIGNATURE_32 ('P', 'E', 'S', 'H')
+
+typedef struct {
+  GUID                                              SectionGuid;
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER    StreamGetInfoHandler;
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER      StreamDecodeHandler;
+} PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER;
+
+//
+// The handlers follow this structure in the GUIDed HOB. They are found from the
+// structure itself, and the PEI Core converts the pointers of the PPI descriptor
+// when the HOB list moves, so nothing needs to be updated by this library.
+//
+typedef struct {
+  UINT32                                         Signature;
+  UINT32                                         NumberOfStreamHandler;
+  EFI_PEI_PPI_DESCRIPTOR                         PpiList;
+  EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI    Ppi;
+} PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO;
+
+/**
+  Build guid hob for the global memory to store the registered guid and stream handler list.
+  If GuidHob exists, HandlerInfo will be directly got from Guid hob data.
+
+  The HOB is named by gEfiCallerIdGuid like the one of PeiExtractGuidedSectionLib,
+  the signature tells them apart. The EDKII_PEI_EXTRACT_GUIDED_SECTION_STREAM_PPI
+  of the module is kept in the HOB and installed when the HOB is built.
+
+  @param[out]  InfoPointer   The pointer to pei stream handler information structure.
+
+  @retval  RETURN_SUCCESS            Build Guid hob for the global memory space to store guid and function tables.
+  @retval  RETURN_OUT_OF_RESOURCES   No enough memory to allocated.
+**/
+STATIC
+RETURN_STATUS
+PeiGetExtractGuidedSectionStreamHandlerInfo (
+  OUT PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO  **InfoPointer
+  )
+{
+  EFI_STATUS                                      Status;
+  PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO  *HandlerInfo;
+  EFI_PEI_HOB_POINTERS                            Hob;
+
+  //
+  // First try to get handler information from guid hob specified by CallerId.
+  //
+  Hob.Raw = GetNextHob (EFI_HOB_TYPE_GUID_EXTENSION, GetHobList ());
+  while (Hob.Raw != NULL) {
+    if (CompareGuid (&(Hob.Guid->Name), &gEfiCallerIdGuid)) {
+      HandlerInfo = (PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO *)GET_GUID_HOB_DATA (Hob.Guid);
+      if (HandlerInfo->Signature == PEI_EXTRACT_STREAM_HANDLER_INFO_SIGNATURE) {
+        *InfoPointer = HandlerInfo;
+        return RETURN_SUCCESS;
+      }
+    }
+
+    Hob.Raw = GET_NEXT_HOB (Hob);
+    Hob.Raw = GetNextHob (EFI_HOB_TYPE_GUID_EXTENSION, Hob.Raw);
+  }
+
+  //
+  // If Guid Hob is not found, Build CallerId Guid hob to store Handler Info
+  //
+  HandlerInfo = BuildGuidHob (
+                  &gEfiCallerIdGuid,
+                  sizeof (PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO) +
+                  PcdGet32 (PcdMaximumGuidedExtractHandler) * sizeof (PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER)
+                  );
+  if (HandlerInfo == NULL) {
+    //
+    // No enough resource to build guid hob.
+    //
+    *InfoPointer = NULL;
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  HandlerInfo->NumberOfStreamHandler = 0;
+  HandlerInfo->PpiList.Flags         = EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+  HandlerInfo->PpiList.Guid          = &gEdkiiPeiExtractGuidedSectionStreamPpiGuid;
+  HandlerInfo->PpiList.Ppi           = &HandlerInfo->Ppi;
+  HandlerInfo->Ppi.GetStreamHandler  = ExtractGuidedSectionGetStreamHandler;
+
+  Status = PeiServicesInstallPpi (&HandlerInfo->PpiList);
+  if (EFI_ERROR (Status)) {
+    //
+    // The HOB is left without signature, so it is not found again.
+    //
+    *InfoPointer = NULL;
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  HandlerInfo->Signature = PEI_EXTRACT_STREAM_HANDLER_INFO_SIGNATURE;
+
+  *InfoPointer = HandlerInfo;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Registers a handler of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and a handler
+  of type EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  Registering the handlers again for the same GUID replaces them.
+
+  If SectionGuid is NULL, then ASSERT().
+  If StreamGetInfoHandler is NULL, then ASSERT().
+  If StreamDecodeHandler is NULL, then ASSERT().
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being registered.
+  @param[in]  StreamGetInfoHandler  The pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[in]  StreamDecodeHandler   The pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval  RETURN_SUCCESS            The handlers were registered.
+  @retval  RETURN_OUT_OF_RESOURCES   There are not enough resources available to register the handlers.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterStreamHandler (
+  IN CONST  GUID                                            *SectionGuid,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler
+  )
+{
+  RETURN_STATUS                                   Status;
+  UINT32                                          Index;
+  PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO  *HandlerInfo;
+  PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER       *Handlers;
+
+  //
+  // Check input parameter
+  //
+  ASSERT (SectionGuid != NULL);
+  ASSERT (StreamGetInfoHandler != NULL);
+  ASSERT (StreamDecodeHandler != NULL);
+
+  //
+  // Get the registered handler information
+  //
+  Status = PeiGetExtractGuidedSectionStreamHandlerInfo (&HandlerInfo);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The module may have been shadowed since the PPI was installed.
+  //
+  HandlerInfo->Ppi.GetStreamHandler = ExtractGuidedSectionGetStreamHandler;
+
+  //
+  // If the guided handler has been registered before, only update its handlers.
+  //
+  Handlers = (PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER *)(HandlerInfo + 1);
+  for (Index = 0; Index < HandlerInfo->NumberOfStreamHandler; Index++) {
+    if (CompareGuid (&Handlers[Index].SectionGuid, SectionGuid)) {
+      Handlers[Index].StreamGetInfoHandler = StreamGetInfoHandler;
+      Handlers[Index].StreamDecodeHandler  = StreamDecodeHandler;
+      return RETURN_SUCCESS;
+    }
+  }
+
+  //
+  // Check the global table is enough to contain new Handler.
+  //
+  if (HandlerInfo->NumberOfStreamHandler >= PcdGet32 (PcdMaximumGuidedExtractHandler)) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  CopyGuid (&Handlers[HandlerInfo->NumberOfStreamHandler].SectionGuid, SectionGuid);
+  Handlers[HandlerInfo->NumberOfStreamHandler].StreamGetInfoHandler  = StreamGetInfoHandler;
+  Handlers[HandlerInfo->NumberOfStreamHandler++].StreamDecodeHandler = StreamDecodeHandler;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Retrieves the handlers of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  If SectionGuid is NULL, then ASSERT().
+  If StreamGetInfoHandler is NULL, then ASSERT().
+  If StreamDecodeHandler is NULL, then ASSERT().
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being retrieved.
+  @param[out] StreamGetInfoHandler  Pointer to a function that examines a GUIDed section and returns
+                                    the size of the decoded data and the size of the window buffer.
+  @param[out] StreamDecodeHandler   Pointer to a function that decodes a GUIDed section
+                                    whose data is read in parts.
+
+  @retval  RETURN_SUCCESS     The handlers were retrieved.
+  @retval  RETURN_NOT_FOUND   No stream decode handler has been registered with the specified GUID.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionGetStreamHandler (
+  IN CONST   GUID                                            *SectionGuid,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  *StreamGetInfoHandler,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    *StreamDecodeHandler
+  )
+{
+  RETURN_STATUS                                   Status;
+  UINT32                                          Index;
+  PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER_INFO  *HandlerInfo;
+  PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER       *Handlers;
+
+  //
+  // Check input parameter
+  //
+  ASSERT (SectionGuid != NULL);
+  ASSERT (StreamGetInfoHandler != NULL);
+  ASSERT (StreamDecodeHandler != NULL);
+
+  //
+  // Get the registered handler information
+  //
+  Status = PeiGetExtractGuidedSectionStreamHandlerInfo (&HandlerInfo);
+  if (RETURN_ERROR (Status)) {
+    return RETURN_NOT_FOUND;
+  }
+
+  //
+  // Search the match registered handler for the input guided section.
+  //
+  Handlers = (PEI_EXTRACT_GUIDED_SECTION_STREAM_HANDLER *)(HandlerInfo + 1);
+  for (Index = 0; Index < HandlerInfo->NumberOfStreamHandler; Index++) {
+    if (CompareGuid (&Handlers[Index].SectionGuid, SectionGuid)) {
+      *StreamGetInfoHandler = Handlers[Index].StreamGetInfoHandler;
+      *StreamDecodeHandler  = Handlers[Index].StreamDecodeHandler;
+      return RETURN_SUCCESS;
+    }
+  }
+
+  return RETURN_NOT_FOUND;
+}
@@ -45,6 +45,9 @@ STATIC  UINT32  mCurrentTableSize  = 0;
 STATIC  UINT32  mCurrentTableUsage = 0;
 STATIC  UINT32  mCurrentTableCount = 0;
 
+// Index of the policy table, built when the interface is locked.
+UINT8  *mPolicyIndex = NULL;
+
 #define POLICY_TABLE_STEP_SIZE  0x1000
 
 // NOTE: DO NOT USE THESE MACROS on any structure that has not been validated.
@@ -56,6 +59,38 @@ STATIC  UINT32  mCurrentTableCount = 0;
 #define MATCH_PRIORITY_MAX    MATCH_PRIORITY_EXACT
 #define MATCH_PRIORITY_MIN    MAX_UINT8
 
+//
+// The policy index holds one entry per namespace, sorted by GUID, and a trie
+// of the policy names of each namespace. A policy is referenced by its offset
+// in mPolicyTable, which also gives the registration order. Nodes are
+// referenced by their position so the index can be relocated as a whole.
+//
+#define POLICY_INDEX_NO_POLICY  MAX_UINT32
+#define POLICY_INDEX_NO_NODE    0
+
+typedef struct {
+  UINT32    NamespaceCount;
+  UINT32    MaxNamespaceCount;
+  UINT32    NodeCount;
+} POLICY_INDEX_HEADER;
+
+typedef struct {
+  EFI_GUID    Namespace;
+  UINT32      NamespacePolicy; // Policy without a name, matching the whole namespace.
+  UINT32      Root;            // Node of the empty name.
+} POLICY_INDEX_NAMESPACE;
+
+typedef struct {
+  CHAR16    Char;               // Last character of the name of the node, may be '#'.
+  UINT32    Parent;
+  UINT32    FirstChild;
+  UINT32    NextSibling;
+  UINT32    Policy;             // Policy whose name ends at this node.
+} POLICY_INDEX_NODE;
+
+#define GET_INDEX_NAMESPACES(Index)  ((POLICY_INDEX_NAMESPACE *)((POLICY_INDEX_HEADER *)(Index) + 1))
+#define GET_INDEX_NODES(Index)       ((POLICY_INDEX_NODE *)(GET_INDEX_NAMESPACES (Index) + ((POLICY_INDEX_HEADER *)(Index))->MaxNamespaceCount))
+
 /**
   An extra init hook that enables the RuntimeDxe library instance to
   register VirtualAddress change callbacks. Among other things.
@@ -202,6 +237,27 @@ IsValidVariablePolicyStructure (
   return TRUE;
 }
 
+/**
+  This helper function determines whether a variable name character matches the
+  '#' wildcard of a policy name.
+
+  @param[in]  Char    Character of the variable name.
+
+  @retval     TRUE    Char is a hexadecimal digit.
+  @retval     FALSE   Char does not match the wildcard.
+
+**/
+STATIC
+BOOLEAN
+IsWildcardMatch (
+  IN CHAR16  Char
+  )
+{
+  return (BOOLEAN)(((L'0' <= Char) && (Char <= L'9')) ||
+                   ((L'A' <= Char) && (Char <= L'F')) ||
+                   ((L'a' <= Char) && (Char <= L'f')));
+}
+
 /**
   This helper function evaluates a policy and determines whether it matches the target
   variable. If matched, will also return a value corresponding to the priority of the match.
@@ -265,11 +321,7 @@ EvaluatePolicyMatch (
     if ((PolicyName[Index] != VariableName[Index]) || (PolicyName[Index] == '#')) {
       // If this is a numerical wildcard, we can consider
       // it a match if we alter the priority.
-      if ((PolicyName[Index] == L'#') &&
-          (((L'0' <= VariableName[Index]) && (VariableName[Index] <= L'9')) ||
-           ((L'A' <= VariableName[Index]) && (VariableName[Index] <= L'F')) ||
-           ((L'a' <= VariableName[Index]) && (VariableName[Index] <= L'f'))))
-      {
+      if ((PolicyName[Index] == L'#') && IsWildcardMatch (VariableName[Index])) {
         if (CalculatedPriority < MATCH_PRIORITY_MIN) {
           CalculatedPriority++;
         }
@@ -292,6 +344,316 @@ Exit:
   return Result;
 }
 
+/**
+  This helper function looks up a namespace in the policy index.
+
+  @param[in]  Index       Pointer to the policy index.
+  @param[in]  Namespace   The namespace GUID.
+  @param[out] Position    On return, the position of the namespace in the index,
+                          or the position where it should be inserted.
+
+  @retval     TRUE    The namespace is in the index.
+  @retval     FALSE   No policy of the index matches the namespace.
+
+**/
+STATIC
+BOOLEAN
+FindPolicyIndexNamespace (
+  IN CONST  UINT8     *Index,
+  IN CONST  EFI_GUID  *Namespace,
+  OUT       UINT32    *Position
+  )
+{
+  POLICY_INDEX_NAMESPACE  *Namespaces;
+  UINT32                  Low;
+  UINT32                  High;
+  UINT32                  Middle;
+  INTN                    Compare;
+
+  Namespaces = GET_INDEX_NAMESPACES (Index);
+  Low        = 0;
+  High       = ((POLICY_INDEX_HEADER *)Index)->NamespaceCount;
+  while (Low < High) {
+    Middle  = Low + (High - Low) / 2;
+    Compare = CompareMem (Namespace, &Namespaces[Middle].Namespace, sizeof (EFI_GUID));
+    if (Compare == 0) {
+      *Position = Middle;
+      return TRUE;
+    }
+
+    if (Compare < 0) {
+      High = Middle;
+    } else {
+      Low = Middle + 1;
+    }
+  }
+
+  *Position = Low;
+  return FALSE;
+}
+
+/**
+  This helper function finds the first node of a list of siblings in the policy
+  index whose character matches a variable name character.
+
+  @param[in]  Nodes   The nodes of the policy index.
+  @param[in]  Node    First node of the list.
+  @param[in]  Char    Character of the variable name, not CHAR_NULL.
+
+  @return     The matching node, or POLICY_INDEX_NO_NODE.
+
+**/
+STATIC
+UINT32
+FindMatchingPolicyIndexNode (
+  IN CONST  POLICY_INDEX_NODE  *Nodes,
+  IN        UINT32             Node,
+  IN        CHAR16             Char
+  )
+{
+  for ( ; Node != POLICY_INDEX_NO_NODE; Node = Nodes[Node].NextSibling) {
+    if (Nodes[Node].Char == L'#') {
+      if (IsWildcardMatch (Char)) {
+        return Node;
+      }
+    } else if (Nodes[Node].Char == Char) {
+      return Node;
+    }
+  }
+
+  return POLICY_INDEX_NO_NODE;
+}
+
+/**
+  This helper function builds the index of the policy table. The table must not
+  change as long as the index exists.
+
+  @retval     EFI_SUCCESS             The index was built.
+  @retval     EFI_ABORTED             A calculation error prevented building the index.
+  @retval     EFI_OUT_OF_RESOURCES    Not enough memory to build the index.
+
+**/
+STATIC
+EFI_STATUS
+BuildPolicyIndex (
+  VOID
+  )
+{
+  EFI_STATUS              Status;
+  VARIABLE_POLICY_ENTRY   *CurrentEntry;
+  POLICY_INDEX_HEADER     *Header;
+  POLICY_INDEX_NAMESPACE  *Namespaces;
+  POLICY_INDEX_NODE       *Nodes;
+  CHAR16                  *PolicyName;
+  UINT8                   *Index;
+  UINTN                   MaxNodeCount;
+  UINTN                   IndexSize;
+  UINTN                   NodesSize;
+  UINT32                  PolicyOffset;
+  UINT32                  Position;
+  UINT32                  Node;
+  UINT32                  Child;
+  UINTN                   Count;
+
+  // Each policy name needs at most one node per character, and each namespace a root node.
+  // Node 0 is never used, it stands for POLICY_INDEX_NO_NODE.
+  MaxNodeCount = 1 + mCurrentTableCount;
+  CurrentEntry = (VARIABLE_POLICY_ENTRY *)mPolicyTable;
+  for (Count = 0; Count < mCurrentTableCount; Count++) {
+    if (CurrentEntry->Size != CurrentEntry->OffsetToName) {
+      MaxNodeCount += (CurrentEntry->Size - CurrentEntry->OffsetToName) / sizeof (CHAR16);
+    }
+
+    CurrentEntry = GET_NEXT_POLICY (CurrentEntry);
+  }
+
+  Status = SafeUintnMult (MaxNodeCount, sizeof (POLICY_INDEX_NODE), &NodesSize);
+  if (!EFI_ERROR (Status)) {
+    Status = SafeUintnMult (mCurrentTableCount, sizeof (POLICY_INDEX_NAMESPACE), &IndexSize);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = SafeUintnAdd (IndexSize, sizeof (POLICY_INDEX_HEADER), &IndexSize);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = SafeUintnAdd (IndexSize, NodesSize, &IndexSize);
+  }
+
+  if (EFI_ERROR (Status)) {
+    return EFI_ABORTED;
+  }
+
+  Index = AllocateRuntimePool (IndexSize);
+  if (Index == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Header                    = (POLICY_INDEX_HEADER *)Index;
+  Header->NamespaceCount    = 0;
+  Header->MaxNamespaceCount = mCurrentTableCount;
+  Header->NodeCount         = 1;
+  Namespaces                = GET_INDEX_NAMESPACES (Index);
+  Nodes                     = GET_INDEX_NODES (Index);
+  ZeroMem (&Nodes[POLICY_INDEX_NO_NODE], sizeof (POLICY_INDEX_NODE));
+
+  // Add the policies in the table order, so the first one registered wins when
+  // two policies have the same name.
+  CurrentEntry = (VARIABLE_POLICY_ENTRY *)mPolicyTable;
+  for (Count = 0; Count < mCurrentTableCount; Count++) {
+    PolicyOffset = (UINT32)((UINTN)CurrentEntry - (UINTN)mPolicyTable);
+
+    if (!FindPolicyIndexNamespace (Index, &CurrentEntry->Namespace, &Position)) {
+      CopyMem (
+        &Namespaces[Position + 1],
+        &Namespaces[Position],
+        (Header->NamespaceCount - Position) * sizeof (POLICY_INDEX_NAMESPACE)
+        );
+      CopyGuid (&Namespaces[Position].Namespace, &CurrentEntry->Namespace);
+      Namespaces[Position].NamespacePolicy = POLICY_INDEX_NO_POLICY;
+      Namespaces[Position].Root            = Header->NodeCount++;
+      ZeroMem (&Nodes[Namespaces[Position].Root], sizeof (POLICY_INDEX_NODE));
+      Nodes[Namespaces[Position].Root].Policy = POLICY_INDEX_NO_POLICY;
+      Header->NamespaceCount++;
+    }
+
+    if (CurrentEntry->Size == CurrentEntry->OffsetToName) {
+      if (Namespaces[Position].NamespacePolicy == POLICY_INDEX_NO_POLICY) {
+        Namespaces[Position].NamespacePolicy = PolicyOffset;
+      }
+    } else {
+      // Walk down the trie along the policy name, adding the missing nodes.
+      Node = Namespaces[Position].Root;
+      for (PolicyName = GET_POLICY_NAME (CurrentEntry); *PolicyName != CHAR_NULL; PolicyName++) {
+        for (Child = Nodes[Node].FirstChild; Child != POLICY_INDEX_NO_NODE; Child = Nodes[Child].NextSibling) {
+          if (Nodes[Child].Char == *PolicyName) {
+            break;
+          }
+        }
+
+        if (Child == POLICY_INDEX_NO_NODE) {
+          Child                    = Header->NodeCount++;
+          Nodes[Child].Char        = *PolicyName;
+          Nodes[Child].Parent      = Node;
+          Nodes[Child].FirstChild  = POLICY_INDEX_NO_NODE;
+          Nodes[Child].NextSibling = Nodes[Node].FirstChild;
+          Nodes[Child].Policy      = POLICY_INDEX_NO_POLICY;
+          Nodes[Node].FirstChild   = Child;
+        }
+
+        Node = Child;
+      }
+
+      if (Nodes[Node].Policy == POLICY_INDEX_NO_POLICY) {
+        Nodes[Node].Policy = PolicyOffset;
+      }
+    }
+
+    CurrentEntry = GET_NEXT_POLICY (CurrentEntry);
+  }
+
+  ASSERT (Header->NodeCount <= MaxNodeCount);
+  mPolicyIndex = Index;
+  return EFI_SUCCESS;
+}
+
+/**
+  This helper function looks up the best match for a variable in the policy index.
+  It returns the same policy as a walk of the whole policy table.
+
+  @param[in]  VariableName       Same as EFI_SET_VARIABLE.
+  @param[in]  VendorGuid         Same as EFI_SET_VARIABLE.
+  @param[out] ReturnPriority     On finding a match, the priority of the match.
+                                 Same as EvaluatePolicyMatch().
+
+  @retval     VARIABLE_POLICY_ENTRY*    Best match that was found.
+  @retval     NULL                      No match was found.
+
+**/
+STATIC
+VARIABLE_POLICY_ENTRY *
+GetIndexedPolicyMatch (
+  IN CONST  CHAR16    *VariableName,
+  IN CONST  EFI_GUID  *VendorGuid,
+  OUT       UINT8     *ReturnPriority
+  )
+{
+  POLICY_INDEX_NAMESPACE  *Namespace;
+  POLICY_INDEX_NODE       *Nodes;
+  UINT32                  Position;
+  UINT32                  BestPolicy;
+  UINT8                   BestPriority;
+  UINT8                   Priority;
+  UINT32                  Root;
+  UINT32                  Node;
+  UINT32                  Next;
+  UINTN                   Depth;
+  UINTN                   WildcardCount;
+
+  if (!FindPolicyIndexNamespace (mPolicyIndex, VendorGuid, &Position)) {
+    return NULL;
+  }
+
+  Namespace    = &GET_INDEX_NAMESPACES (mPolicyIndex)[Position];
+  Nodes        = GET_INDEX_NODES (mPolicyIndex);
+  BestPolicy   = Namespace->NamespacePolicy;
+  BestPriority = MATCH_PRIORITY_MIN;
+
+  // Depth-first walk of the nodes matching the variable name. A node is only
+  // reached through its parent, so each node is visited at most once.
+  Root          = Namespace->Root;
+  Node          = Root;
+  Depth         = 0;
+  WildcardCount = 0;
+  while (TRUE) {
+    if (VariableName[Depth] == CHAR_NULL) {
+      // Both names end here. Keep the policy if it is a better match, or an
+      // equal match registered earlier.
+      if (Nodes[Node].Policy != POLICY_INDEX_NO_POLICY) {
+        Priority = (UINT8)MIN (WildcardCount, MATCH_PRIORITY_MIN);
+        if ((BestPolicy == POLICY_INDEX_NO_POLICY) || (Priority < BestPriority) ||
+            ((Priority == BestPriority) && (Nodes[Node].Policy < BestPolicy)))
+        {
+          BestPolicy   = Nodes[Node].Policy;
+          BestPriority = Priority;
+        }
+      }
+
+      Next = POLICY_INDEX_NO_NODE;
+    } else {
+      Next = FindMatchingPolicyIndexNode (Nodes, Nodes[Node].FirstChild, VariableName[Depth]);
+    }
+
+    // Go back up until a sibling matches the same variable name character.
+    while ((Next == POLICY_INDEX_NO_NODE) && (Node != Root)) {
+      Depth--;
+      if (Nodes[Node].Char == L'#') {
+        WildcardCount--;
+      }
+
+      Next = FindMatchingPolicyIndexNode (Nodes, Nodes[Node].NextSibling, VariableName[Depth]);
+      Node = Nodes[Node].Parent;
+    }
+
+    if (Next == POLICY_INDEX_NO_NODE) {
+      break;
+    }
+
+    Node = Next;
+    Depth++;
+    if (Nodes[Node].Char == L'#') {
+      WildcardCount++;
+    }
+  }
+
+  if (BestPolicy == POLICY_INDEX_NO_POLICY) {
+    return NULL;
+  }
+
+  *ReturnPriority = BestPriority;
+  return (VARIABLE_POLICY_ENTRY *)(mPolicyTable + BestPolicy);
+}
+
 /**
   This helper function walks the current policy table and returns a pointer
   to the best match, if any are found. Leverages EvaluatePolicyMatch() to
@@ -324,25 +686,30 @@ GetBestPolicyMatch (
   BestResult    = NULL;
   MatchPriority = MATCH_PRIORITY_EXACT;
 
-  // Walk all entries in the table, looking for matches.
-  CurrentEntry = (VARIABLE_POLICY_ENTRY *)mPolicyTable;
-  for (Index = 0; Index < mCurrentTableCount; Index++) {
-    // Check for a match.
-    if (EvaluatePolicyMatch (CurrentEntry, VariableName, VendorGuid, &CurrentPriority)) {
-      // If match is better, take it.
-      if ((BestResult == NULL) || (CurrentPriority < MatchPriority)) {
-        BestResult    = CurrentEntry;
-        MatchPriority = CurrentPriority;
-      }
+  // Once the interface is locked, the table is indexed.
+  if (mPolicyIndex != NULL) {
+    BestResult = GetIndexedPolicyMatch (VariableName, VendorGuid, &MatchPriority);
+  } else {
+    // Walk all entries in the table, looking for matches.
+    CurrentEntry = (VARIABLE_POLICY_ENTRY *)mPolicyTable;
+    for (Index = 0; Index < mCurrentTableCount; Index++) {
+      // Check for a match.
+      if (EvaluatePolicyMatch (CurrentEntry, VariableName, VendorGuid, &CurrentPriority)) {
+        // If match is better, take it.
+        if ((BestResult == NULL) || (CurrentPriority < MatchPriority)) {
+          BestResult    = CurrentEntry;
+          MatchPriority = CurrentPriority;
+        }
 
-      // If you've hit the highest-priority match, can exit now.
-      if (MatchPriority == 0) {
-        break;
+        // If you've hit the highest-priority match, can exit now.
+        if (MatchPriority == 0) {
+          break;
+        }
       }
-    }
 
-    // If we're still in the loop, move to the next entry.
-    CurrentEntry = GET_NEXT_POLICY (CurrentEntry);
+      // If we're still in the loop, move to the next entry.
+      CurrentEntry = GET_NEXT_POLICY (CurrentEntry);
+    }
   }
 
   // If a return priority was requested, return it.
@@ -394,8 +761,9 @@ RegisterVariablePolicy (
   }
 
   // Check to see whether an exact matching policy already exists.
+  // A policy for the whole namespace has no name to read.
   MatchPolicy = GetBestPolicyMatch (
-                  GET_POLICY_NAME (NewPolicy),
+                  (NewPolicy->Size == NewPolicy->OffsetToName) ? L"" : GET_POLICY_NAME (NewPolicy),
                   &NewPolicy->Namespace,
                   &MatchPriority
                   );
@@ -710,6 +1078,8 @@ IsVariablePolicyEnabled (
   This API function locks the interface so that no more policy updates
   can be performed or changes made to the enforcement until the next boot.
 
+  The policy table no longer changes, so it is indexed for ValidateSetVariable().
+
   @retval     EFI_SUCCESS
   @retval     EFI_NOT_READY   Library has not yet been initialized.
 
@@ -720,6 +1090,8 @@ LockVariablePolicy (
   VOID
   )
 {
+  EFI_STATUS  Status;
+
   if (!IsVariablePolicyLibInitialized ()) {
     return EFI_NOT_READY;
   }
@@ -729,6 +1101,15 @@ LockVariablePolicy (
   }
 
   mInterfaceLocked = TRUE;
+
+  // Without an index, the policies are still found by walking the table.
+  if (mCurrentTableCount > 0) {
+    Status = BuildPolicyIndex ();
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "%a - Policy table not indexed. %r\n", __func__, Status));
+    }
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -794,6 +1175,7 @@ InitVariablePolicyLib (
     mInterfaceLocked    = FALSE;
     mProtectionDisabled = FALSE;
     mPolicyTable        = NULL;
+    mPolicyIndex        = NULL;
     mCurrentTableSize   = 0;
     mCurrentTableUsage  = 0;
     mCurrentTableCount  = 0;
@@ -857,6 +1239,11 @@ DeinitVariablePolicyLib (
       FreePool (mPolicyTable);
       mPolicyTable = NULL;
     }
+
+    if (mPolicyIndex != NULL) {
+      FreePool (mPolicyIndex);
+      mPolicyIndex = NULL;
+    }
   }
 
   return Status;
@@ -0,0 +1,604 @@
+/** @file
+  This is a host-based unit test for the policy index of VariablePolicyLib.
+
+  The policy found by ValidateSetVariable() is identified by its size limits,
+  every policy accepting exactly one data size. Each lookup is checked against
+  the precedence rules of the Variable Policy spec, before the interface is
+  locked (walk of the policy table) and after (policy index).
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+#include <Library/VariablePolicyLib.h>
+#include <Library/VariablePolicyHelperLib.h>
+
+#define UNIT_TEST_NAME     "Variable Policy Index Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_NAME_LENGTH  8
+#define TEST_NO_POLICY    MAX_UINT32
+
+///
+/// A policy registered by the test. Its id is the only data size it accepts.
+///
+typedef struct {
+  EFI_GUID    *Namespace;
+  CHAR16      Name[2 * TEST_NAME_LENGTH];
+  BOOLEAN     HasName;
+  UINT32      Id;
+} TEST_POLICY;
+
+typedef struct {
+  UINTN    PolicyCount;
+  UINTN    LookUpCount;
+} POLICY_INDEX_TEST_CONTEXT;
+
+/// === TEST DATA ==================================================================================
+
+//
+// Test GUID 1 {8E2F3B61-7A4C-4D19-B0E5-2C6A91F04D37}
+//
+EFI_GUID  mTestGuid1 = {
+  0x8e2f3b61, 0x7a4c, 0x4d19, { 0xb0, 0xe5, 0x2c, 0x6a, 0x91, 0xf0, 0x4d, 0x37 }
+};
+
+//
+// Test GUID 2 {1C7D5A92-E36B-4F08-9A41-D85B27C3E6F0}
+//
+EFI_GUID  mTestGuid2 = {
+  0x1c7d5a92, 0xe36b, 0x4f08, { 0x9a, 0x41, 0xd8, 0x5b, 0x27, 0xc3, 0xe6, 0xf0 }
+};
+
+//
+// Test GUID 3 {5B94E0C3-2D87-4A6E-8F1B-73E0A5D9C284}
+//
+EFI_GUID  mTestGuid3 = {
+  0x5b94e0c3, 0x2d87, 0x4a6e, { 0x8f, 0x1b, 0x73, 0xe0, 0xa5, 0xd9, 0xc2, 0x84 }
+};
+
+//
+// Namespace without any policy.
+// Test GUID 4 {E0A3C6F5-41B8-4C2D-A7E9-6F15D3B08A42}
+//
+EFI_GUID  mTestGuid4 = {
+  0xe0a3c6f5, 0x41b8, 0x4c2d, { 0xa7, 0xe9, 0x6f, 0x15, 0xd3, 0xb0, 0x8a, 0x42 }
+};
+
+EFI_GUID  *mTestGuids[] = { &mTestGuid1, &mTestGuid2, &mTestGuid3, &mTestGuid4 };
+
+//
+// Few characters, so names collide often. 'G' and '#' do not match a wildcard.
+//
+CHAR16  mNameCharacters[] = L"01aFG#";
+
+POLICY_INDEX_TEST_CONTEXT  mSmallTableContext = { 200, 20000 };
+POLICY_INDEX_TEST_CONTEXT  mLargeTableContext = { 2000, 20000 };
+
+TEST_POLICY  *mPolicies;
+UINTN        mPolicyCount;
+UINT32       mRandomSeed;
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  GetVariable() helper of the library. No variable exists.
+
+  @retval EFI_NOT_FOUND  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+StubGetVariable (
+  IN     CHAR16    *VariableName,
+  IN     EFI_GUID  *VendorGuid,
+  OUT    UINT32    *Attributes     OPTIONAL,
+  IN OUT UINTN     *DataSize,
+  OUT    VOID      *Data           OPTIONAL
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Returns a pseudo-random number, the same sequence for every run.
+
+  @param[in] Limit  Upper bound.
+
+  @return A number below Limit.
+
+**/
+UINT32
+Random (
+  IN UINT32  Limit
+  )
+{
+  mRandomSeed = mRandomSeed * 1103515245 + 12345;
+  return (mRandomSeed >> 16) % Limit;
+}
+
+/**
+  Builds a random name from mNameCharacters.
+
+  @param[out] Name  Buffer of TEST_NAME_LENGTH + 1 characters.
+
+**/
+VOID
+RandomName (
+  OUT CHAR16  *Name
+  )
+{
+  UINTN  Length;
+  UINTN  Index;
+
+  Length = 1 + Random (TEST_NAME_LENGTH);
+  for (Index = 0; Index < Length; Index++) {
+    Name[Index] = mNameCharacters[Random (ARRAY_SIZE (mNameCharacters) - 1)];
+  }
+
+  Name[Length] = CHAR_NULL;
+}
+
+/**
+  Registers a policy accepting only a data size equal to its id.
+
+  @param[in] Namespace  The namespace GUID.
+  @param[in] Name       The policy name, or NULL for the whole namespace.
+
+  @return The status returned by RegisterVariablePolicy().
+
+**/
+EFI_STATUS
+AddPolicy (
+  IN EFI_GUID  *Namespace,
+  IN CHAR16    *Name       OPTIONAL
+  )
+{
+  VARIABLE_POLICY_ENTRY  *Entry;
+  TEST_POLICY            *Policy;
+  EFI_STATUS             Status;
+
+  Policy     = &mPolicies[mPolicyCount];
+  Policy->Id = (UINT32)mPolicyCount + 1;
+  Status     = CreateBasicVariablePolicy (Namespace, Name, Policy->Id, Policy->Id, 0, 0, VARIABLE_POLICY_TYPE_NO_LOCK, &Entry);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = RegisterVariablePolicy (Entry);
+  FreePool (Entry);
+  if (!EFI_ERROR (Status)) {
+    Policy->Namespace = Namespace;
+    Policy->HasName   = (BOOLEAN)(Name != NULL);
+    if (Name != NULL) {
+      StrCpyS (Policy->Name, ARRAY_SIZE (Policy->Name), Name);
+    }
+
+    mPolicyCount++;
+  }
+
+  return Status;
+}
+
+/**
+  Finds the policy that applies to a variable, following the precedence rules
+  of the Variable Policy spec.
+
+  @param[in] Name       The variable name.
+  @param[in] Namespace  The variable GUID.
+
+  @return Id of the policy, or TEST_NO_POLICY.
+
+**/
+UINT32
+ExpectedPolicy (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Namespace
+  )
+{
+  UINTN   Index;
+  UINTN   Char;
+  UINTN   Priority;
+  UINTN   BestPriority;
+  UINT32  BestId;
+
+  BestId       = TEST_NO_POLICY;
+  BestPriority = MAX_UINTN;
+  for (Index = 0; Index < mPolicyCount; Index++) {
+    if (!CompareGuid (mPolicies[Index].Namespace, Namespace)) {
+      continue;
+    }
+
+    if (!mPolicies[Index].HasName) {
+      Priority = MAX_UINT8;
+    } else if (StrLen (mPolicies[Index].Name) != StrLen (Name)) {
+      continue;
+    } else {
+      Priority = 0;
+      for (Char = 0; Name[Char] != CHAR_NULL; Char++) {
+        if (mPolicies[Index].Name[Char] == L'#') {
+          if (!(((L'0' <= Name[Char]) && (Name[Char] <= L'9')) ||
+                ((L'A' <= Name[Char]) && (Name[Char] <= L'F')) ||
+                ((L'a' <= Name[Char]) && (Name[Char] <= L'f'))))
+          {
+            break;
+          }
+
+          Priority++;
+        } else if (mPolicies[Index].Name[Char] != Name[Char]) {
+          break;
+        }
+      }
+
+      if (Name[Char] != CHAR_NULL) {
+        continue;
+      }
+    }
+
+    if (Priority < BestPriority) {
+      BestPriority = Priority;
+      BestId       = mPolicies[Index].Id;
+    }
+  }
+
+  return BestId;
+}
+
+/**
+  Checks that ValidateSetVariable() applies the expected policy to a variable.
+
+  @param[in] Name       The variable name.
+  @param[in] Namespace  The variable GUID.
+
+  @retval TRUE   The expected policy, or no policy, was applied.
+  @retval FALSE  Another policy was applied.
+
+**/
+BOOLEAN
+PolicyMatches (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Namespace
+  )
+{
+  UINT32      Expected;
+  EFI_STATUS  Status;
+
+  //
+  // A data size no policy accepts passes only if no policy applies.
+  //
+  Expected = ExpectedPolicy (Name, Namespace);
+  Status   = ValidateSetVariable (
+               Name,
+               Namespace,
+               EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+               (Expected == TEST_NO_POLICY) ? MAX_UINT32 : Expected,
+               Name
+               );
+  if (EFI_ERROR (Status)) {
+    UT_LOG_ERROR ("%s %g: expected policy %d, %r\n", Name, Namespace, (INT32)Expected, Status);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks random variable names against the policies.
+
+  @param[in] LookUpCount  Number of variable names.
+
+  @retval TRUE   All variables got the expected policy.
+  @retval FALSE  At least one variable got another policy.
+
+**/
+BOOLEAN
+AllPoliciesMatch (
+  IN UINTN  LookUpCount
+  )
+{
+  CHAR16  Name[TEST_NAME_LENGTH + 1];
+  UINTN   Count;
+
+  mRandomSeed = 1;
+  for (Count = 0; Count < LookUpCount; Count++) {
+    RandomName (Name);
+    if (!PolicyMatches (Name, mTestGuids[Random (ARRAY_SIZE (mTestGuids))])) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Registers random policies, some of them for a whole namespace.
+
+  @param[in] PolicyCount  Number of policies to try to register.
+
+**/
+VOID
+AddRandomPolicies (
+  IN UINTN  PolicyCount
+  )
+{
+  CHAR16  Name[TEST_NAME_LENGTH + 1];
+  UINTN   Count;
+
+  mRandomSeed = 2;
+  for (Count = 0; Count < PolicyCount; Count++) {
+    RandomName (Name);
+    //
+    // The last test GUID is left without policies.
+    //
+    AddPolicy (
+      mTestGuids[Random (ARRAY_SIZE (mTestGuids) - 1)],
+      (Random (100) == 0) ? NULL : Name
+      );
+  }
+}
+
+/**
+  Initializes the library.
+
+  @param[in] Context  The table size.
+
+  @retval UNIT_TEST_PASSED                      The library is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The library cannot be initialized.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LibInitSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  POLICY_INDEX_TEST_CONTEXT  *TestContext;
+
+  TestContext  = (POLICY_INDEX_TEST_CONTEXT *)Context;
+  mPolicyCount = 0;
+  mPolicies    = AllocateZeroPool ((TestContext->PolicyCount + 16) * sizeof (TEST_POLICY));
+  if ((mPolicies == NULL) || EFI_ERROR (InitVariablePolicyLib (StubGetVariable))) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Deinitializes the library, which frees the policy table and its index.
+
+  @param[in] Context  The table size.
+
+**/
+VOID
+EFIAPI
+LibCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DeinitVariablePolicyLib ();
+  if (mPolicies != NULL) {
+    FreePool (mPolicies);
+    mPolicies = NULL;
+  }
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  The examples of the Variable Policy ReadMe must select the same policy
+  before and after the policies are indexed.
+
+  @param[in] Context  The table size.
+
+  @retval UNIT_TEST_PASSED             The expected policies were applied.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Another policy was applied.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexShouldFollowPrecedenceRules (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16   *Names[] = {
+    L"Boot0001", L"Boot0002", L"Boot1001", L"BootFFFF", L"Boot00G1", L"Boot00#1", L"Boot001", L"Boot00011", L"BootOrder", L""
+  };
+  BOOLEAN  Locked;
+  UINTN    Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, L"Boot00##"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, L"Boot##01"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, L"Boot####"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, L"Boot0002"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, L"Boot00#1"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, L"Boot00#1"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid1, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid2, L"Boot0001"));
+  UT_ASSERT_NOT_EFI_ERROR (AddPolicy (&mTestGuid2, L"BootOrder"));
+  UT_ASSERT_STATUS_EQUAL (AddPolicy (&mTestGuid2, L"BootOrder"), EFI_ALREADY_STARTED);
+
+  for (Locked = FALSE; ; Locked = TRUE) {
+    for (Index = 0; Index < ARRAY_SIZE (Names); Index++) {
+      UT_ASSERT_TRUE (PolicyMatches (Names[Index], &mTestGuid1));
+      UT_ASSERT_TRUE (PolicyMatches (Names[Index], &mTestGuid2));
+      UT_ASSERT_TRUE (PolicyMatches (Names[Index], &mTestGuid3));
+    }
+
+    if (Locked) {
+      break;
+    }
+
+    UT_ASSERT_NOT_EFI_ERROR (LockVariablePolicy ());
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Random variables must get the same policies from the policy index as from a
+  walk of the policy table.
+
+  @param[in] Context  The table size.
+
+  @retval UNIT_TEST_PASSED             The expected policies were applied.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Another policy was applied.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexShouldMatchTableWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  POLICY_INDEX_TEST_CONTEXT  *TestContext;
+
+  TestContext = (POLICY_INDEX_TEST_CONTEXT *)Context;
+  AddRandomPolicies (TestContext->PolicyCount);
+  UT_ASSERT_TRUE (AllPoliciesMatch (TestContext->LookUpCount));
+  UT_ASSERT_NOT_EFI_ERROR (LockVariablePolicy ());
+  UT_ASSERT_TRUE (AllPoliciesMatch (TestContext->LookUpCount));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reports the time taken by ValidateSetVariable() before and after the policies
+  are indexed. Speed is not asserted since it depends on the host.
+
+  @param[in] Context  The table size.
+
+  @retval UNIT_TEST_PASSED             Lookups were timed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The interface could not be locked.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ValidationBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  POLICY_INDEX_TEST_CONTEXT  *TestContext;
+  CHAR16                     Name[TEST_NAME_LENGTH + 1];
+  clock_t                    Elapsed[2];
+  UINTN                      Pass;
+  UINTN                      Count;
+
+  TestContext = (POLICY_INDEX_TEST_CONTEXT *)Context;
+  AddRandomPolicies (TestContext->PolicyCount);
+
+  for (Pass = 0; Pass < ARRAY_SIZE (Elapsed); Pass++) {
+    if (Pass == 1) {
+      UT_ASSERT_NOT_EFI_ERROR (LockVariablePolicy ());
+    }
+
+    mRandomSeed   = 1;
+    Elapsed[Pass] = clock ();
+    for (Count = 0; Count < TestContext->LookUpCount; Count++) {
+      RandomName (Name);
+      ValidateSetVariable (Name, mTestGuids[Random (ARRAY_SIZE (mTestGuids))], EFI_VARIABLE_NON_VOLATILE, 1, Name);
+    }
+
+    Elapsed[Pass] = clock () - Elapsed[Pass];
+  }
+
+  UT_LOG_INFO (
+    "%d policies, %d validations: table walk %d us, index %d us\n",
+    (INT32)mPolicyCount,
+    (INT32)TestContext->LookUpCount,
+    (INT32)((UINT64)Elapsed[0] * 1000000 / CLOCKS_PER_SEC),
+    (INT32)((UINT64)Elapsed[1] * 1000000 / CLOCKS_PER_SEC)
+    );
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  policy index and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "Variable Policy Index Tests", "VarPolicyIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "The index should follow the precedence rules", "Precedence", IndexShouldFollowPrecedenceRules, LibInitSetup, LibCleanup, &mSmallTableContext);
+  AddTestCase (IndexTests, "The index should match the table walk", "Small", IndexShouldMatchTableWalk, LibInitSetup, LibCleanup, &mSmallTableContext);
+  AddTestCase (IndexTests, "A large index should match the table walk", "Large", IndexShouldMatchTableWalk, LibInitSetup, LibCleanup, &mLargeTableContext);
+  AddTestCase (IndexTests, "Validation timing", "Benchmark", ValidationBenchmark, LibInitSetup, LibCleanup, &mLargeTableContext);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
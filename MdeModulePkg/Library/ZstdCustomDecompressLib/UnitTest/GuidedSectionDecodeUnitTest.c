@@ -0,0 +1,1231 @@
+/** @file
+  This is a host-based unit test for the guided section extraction.
+
+  The section data below was produced from the data of GenerateTestData(),
+  every codec must decode it to that data. The
+  Zstandard decoder must reject any truncation of its frames and any frame
+  whose content checksum does not match. The codecs with a stream decode
+  handler must return the same data when the section data is read in parts of
+  any size, both straight into an output buffer with only the scratch buffer of
+  the regular handler, and in parts of their window buffer, which for LZMA wraps
+  around when the dictionary is smaller than the data.
+
+  The decode throughput of each codec is reported for the FV images given on
+  the command line, each FV image must be compressed beforehand next to it:
+
+    TianoCompress -e -o FvImage.tiano FvImage
+    LzmaCompress -e -o FvImage.lzma FvImage
+    LzmaCompress -e --multi-stream 0x10000 -o FvImage.lzms FvImage
+    BrotliCompress -e -o FvImage.br FvImage
+    ZstdCompress -e -o FvImage.zst FvImage
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include <PiPei.h>
+#include <Guid/LzmaDecompress.h>
+#include <Guid/ZstdDecompress.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
+#include <Library/ExtractGuidedSectionStreamLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "Guided Section Decode Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_TEXT_SIZE     SIZE_4KB
+#define TEST_PATTERN_SIZE  (300 * SIZE_1KB)
+#define TEST_DATA_SIZE     (TEST_TEXT_SIZE + TEST_PATTERN_SIZE)
+
+//
+// The smallest amount of time and of iterations a throughput is measured over.
+//
+#define BENCHMARK_MIN_CLOCKS      (CLOCKS_PER_SEC / 2)
+#define BENCHMARK_MIN_ITERATIONS  5
+
+//
+// The size of the parts the section data is read in when the throughput of a
+// stream decode handler is measured, as DxeIpl reads it.
+//
+#define BENCHMARK_CHUNK_SIZE  SIZE_64KB
+
+typedef struct {
+  CONST CHAR8    *Name;
+  EFI_GUID       *Guid;
+  CONST CHAR8    *Extension;
+  CONST UINT8    *Data;
+  UINTN          DataSize;
+} GUIDED_SECTION_CODEC;
+
+typedef struct {
+  CONST UINT8    *Data;
+  UINTN          DataSize;
+  UINTN          ChunkSize;
+  UINTN          Offset;
+  CONST UINT8    *Window;
+  UINTN          WindowSize;
+  UINT8          *Output;
+  UINTN          OutputSize;
+  UINTN          OutputEnd;
+} STREAM_TEST_CONTEXT;
+
+/**
+  Runs the constructors of the libraries linked in, the custom decompress
+  libraries register their handlers there.
+
+**/
+VOID
+EFIAPI
+ProcessLibraryConstructorList (
+  VOID
+  );
+
+/// === TEST DATA ==================================================================================
+
+//
+// The data of GenerateTestData() compressed by LzmaCompress -e.
+//
+STATIC CONST UINT8  mLzmaData[] = {
+  0x5D, 0x00, 0x00, 0x00, 0x01, 0x00, 0xC0, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2B, 0x1B,
+  0xC9, 0x87, 0x88, 0xE0, 0x18, 0xAE, 0x50, 0xA0, 0x37, 0xA2, 0xB1, 0x38, 0xD1, 0x29, 0x76, 0x14,
+  0x89, 0x27, 0xE5, 0xEC, 0x3D, 0x5C, 0xA7, 0xFD, 0xB2, 0x96, 0x76, 0x59, 0xC0, 0x55, 0xAB, 0x84,
+  0xAF, 0xDD, 0x00, 0xE2, 0xFA, 0xC8, 0xE2, 0x4A, 0xB0, 0xBF, 0x14, 0xD4, 0x26, 0x13, 0x27, 0x14,
+  0xBF, 0x29, 0xBE, 0x77, 0x53, 0x0E, 0x64, 0xA8, 0xBC, 0xD6, 0x1C, 0x78, 0x62, 0x0F, 0xDB, 0x40,
+  0x0D, 0x84, 0x45, 0x84, 0x1C, 0xD1, 0xF7, 0x5E, 0x6D, 0x90, 0xB8, 0x14, 0x36, 0xA2, 0x79, 0xFF,
+  0xA9, 0x4B, 0x22, 0x07, 0x36, 0xA1, 0xC6, 0x6C, 0x83, 0x3C, 0x82, 0x42, 0x71, 0x99, 0x99, 0x75,
+  0xC1, 0xFD, 0x0B, 0xCE, 0xA2, 0xD5, 0x9A, 0xE4, 0x37, 0x10, 0xDB, 0x58, 0xCF, 0x48, 0x74, 0x17,
+  0x37, 0x0C, 0x1E, 0x7E, 0x62, 0xDE, 0x13, 0xBE, 0xDD, 0x3B, 0xD9, 0xC3, 0x11, 0xAA, 0x56, 0x4E,
+  0xD1, 0x22, 0x9C, 0xFA, 0xFF, 0x91, 0xCA, 0xA4, 0x6E, 0x4E, 0xAD, 0xD8, 0xC0, 0xA0, 0xE5, 0x50,
+  0x5B, 0x7E, 0x27, 0x4B, 0x1A, 0x38, 0x62, 0x1B, 0xB9, 0xB2, 0xE1, 0xDD, 0xF3, 0x50, 0x80, 0xEA,
+  0x20, 0x82, 0x2E, 0xB2, 0x97, 0x92, 0xCD, 0x93, 0x95, 0xAD, 0x42, 0xA4, 0x24, 0x6C, 0x31, 0xEA,
+  0x98, 0x1B, 0xB9, 0x1A, 0xB4, 0x24, 0x80, 0xC3, 0xDE, 0xE9, 0xFF, 0x0D, 0xE0, 0xAD, 0x7C, 0xF9,
+  0x4C, 0x26, 0x94, 0x6C, 0x67, 0x76, 0x65, 0x0A, 0xE9, 0x76, 0x1C, 0x48, 0xBC, 0x9D, 0x9A, 0x8A,
+  0xEE, 0xA9, 0xF2, 0xD4, 0xBA, 0x77, 0x63, 0x2B, 0xB8, 0x87, 0xFD, 0xCA, 0x39, 0xF5, 0x4E, 0xF0,
+  0x56, 0x70, 0xD3, 0x3B, 0xBF, 0x76, 0x90, 0x96, 0x2F, 0x07, 0x14, 0x6B, 0x77, 0x09, 0x65, 0x91,
+  0x5F, 0x84, 0xB0, 0xAD, 0x17, 0x5C, 0x03, 0xA0, 0x0A, 0x5A, 0xD1, 0x07, 0xBF, 0x08, 0xF4, 0x34,
+  0x9C, 0x99, 0x3B, 0x75, 0xE8, 0x77, 0xB4, 0xA6, 0xAB, 0x87, 0x26, 0x80, 0xCB, 0xC2, 0x4F, 0xAE,
+  0x6B, 0x3B, 0x07, 0xD9, 0x53, 0xF8, 0x64, 0xB9, 0x26, 0x37, 0x9C, 0x18, 0x63, 0x47, 0xFB, 0x22,
+  0x98, 0xCD, 0xF4, 0x74, 0x8D, 0x61, 0xE2, 0x4D, 0xD4, 0x51, 0x95, 0x86, 0x10, 0xB5, 0x41, 0xB6,
+  0xBD, 0x75, 0xB4, 0xE7, 0xB0, 0x7D, 0x3C, 0x0F, 0x5D, 0x4F, 0x22, 0x01, 0xC0, 0x1E, 0x92, 0xE5,
+  0xF7, 0xBD, 0x49, 0x5D, 0x79, 0x01, 0x67, 0x82, 0xB4, 0x81, 0xBB, 0x33, 0xE5, 0xA4, 0xEE, 0x45,
+  0xA3, 0x73, 0x41, 0x0E, 0xA0, 0xE1, 0x75, 0xD7, 0x6F, 0x1A, 0xD7, 0x4C, 0xE8, 0x76, 0xCB, 0xAE,
+  0xDC, 0xE7, 0xB3, 0x43, 0x64, 0xB6, 0x32, 0x81, 0x92, 0x85, 0xA4, 0x8F, 0x57, 0xCE, 0x7F, 0xE9,
+  0x0E, 0x1F, 0x08, 0x71, 0x66, 0xD7, 0x0F, 0xCC, 0x46, 0xFB, 0x4F, 0xC7, 0x38, 0x9B, 0xC1, 0x2B,
+  0xC7, 0xB1, 0x09, 0x60, 0x00, 0x54, 0x52, 0x9C, 0x64, 0x61, 0xB0, 0x08, 0xE4, 0xC9, 0x0A, 0xF0,
+  0xC7, 0xF1, 0x4A, 0xB3, 0x3A, 0x87, 0x40, 0x9F, 0x19, 0x44, 0x36, 0x03, 0xCE, 0x37, 0x96, 0x13,
+  0xF3, 0x3C, 0x91, 0x3F, 0xF6, 0x7F, 0x16, 0xA9, 0xFA, 0x2A, 0xA2, 0xF0, 0x70, 0xDC, 0x1E, 0x7F,
+  0xBF, 0xB9, 0x96, 0xF6, 0x4C, 0xD5, 0xC4, 0x2E, 0xF2, 0x05, 0x3D, 0x85, 0xFB, 0xF7, 0x23, 0x12,
+  0xB0, 0xF1, 0xD3, 0x2A, 0xFF, 0x7F, 0x91, 0x4F, 0xBB, 0x4B, 0x7F, 0x8A, 0x70, 0xB2, 0x49, 0x86,
+  0xB7, 0x97, 0xBF, 0x72, 0x38, 0xF2, 0xB1, 0x15, 0x89, 0x6A, 0x51, 0x93, 0xF9, 0x3E, 0xBA, 0x72,
+  0x66, 0xDD, 0xC7, 0x31, 0xC6, 0x7D, 0x14, 0x93, 0x4E, 0x8C, 0xBF, 0xB0, 0xD4, 0xA8, 0xEF, 0x9B,
+  0x2D, 0xBE, 0xEA, 0x05, 0xD3, 0xDF, 0x3C, 0xF1, 0x3C, 0xDF, 0xE4, 0xE4, 0x5A, 0x0F, 0x1C, 0x1E,
+  0xBA, 0xBA, 0xA4, 0x61, 0xE6, 0xFF, 0x0A, 0x87, 0x92, 0x2B, 0x36, 0x42, 0x09, 0xE4, 0x52, 0xFF,
+  0xB0, 0xAD, 0xF9, 0xD3, 0xC4, 0x45, 0xE0, 0x07, 0x73, 0xB0, 0xE7, 0x55, 0x93, 0x31, 0x0E, 0x89,
+  0x7C, 0xF6, 0x2F, 0x92, 0xEF, 0xBB, 0xF7, 0x17, 0xED, 0x52, 0x25, 0x87, 0xF7, 0x43, 0x21, 0xDB,
+  0x87, 0x08, 0xF8, 0xB1, 0xEF, 0xD8, 0x3D, 0x4F, 0x11, 0xF5, 0xC9, 0x7F, 0x7A, 0xFA, 0x63, 0x27,
+  0xD8, 0x30, 0xDB, 0x29, 0x0F, 0x44, 0x20, 0x74, 0xAD, 0xE1, 0xDF, 0xD2, 0x52, 0xDC, 0x1E, 0x76,
+  0xD7, 0x56, 0x92, 0xB7, 0x1E, 0xE5, 0xA3, 0x59, 0xAD, 0xDF, 0xFA, 0x51, 0xDE, 0x4B, 0x2B, 0xF4,
+  0x30, 0x8B, 0x1A, 0x72, 0x1D, 0x1D, 0xBF, 0xDB, 0x04, 0xBA, 0x1D, 0x42, 0x8B, 0x6F, 0x0C, 0x5A,
+  0x92, 0x38, 0x79, 0x1F, 0x11, 0x3A, 0x70, 0x14, 0xF3, 0x68, 0x3F, 0xDF, 0x60, 0xD6, 0x19, 0x12,
+  0xF3, 0xF6, 0xD2, 0xE7, 0x92, 0xB8, 0xAF, 0xE7, 0x08, 0xB4, 0x83, 0xFA, 0x7A, 0x57, 0x89, 0x93,
+  0x81, 0x63, 0x7F, 0x4A, 0x38, 0x9E, 0x88, 0xC8, 0x03, 0xDF, 0xCC, 0x4C, 0x44, 0xEB, 0x36, 0x2A,
+  0xC6, 0xC9, 0x57, 0x03, 0x79, 0xA8, 0x57, 0xEC, 0x4D, 0x3F, 0x9A, 0xC5, 0x23, 0xC1, 0x58, 0x2C,
+  0xBF, 0x90, 0x59, 0x97, 0x6D, 0xDC, 0x6E, 0x14, 0xF7, 0x68, 0x5A, 0x6C, 0xE3, 0x22, 0x11, 0x96,
+  0x07, 0x8B, 0x03, 0x2D, 0xCA, 0x8B, 0x64, 0xB5, 0xFD, 0x12, 0xE2, 0xD3, 0x33, 0xA1, 0xE9, 0xD1,
+  0xEB, 0x2E, 0x54, 0x3C, 0x2C, 0x2B, 0x74, 0xCD, 0x1E, 0x5B, 0x20, 0x42, 0xF9, 0xDD, 0x53, 0x3D,
+  0xF8, 0x1F, 0xF0, 0xB2, 0xE7, 0x00, 0x00
+};
+
+//
+// The data of GenerateTestData() compressed by
+// LzmaCompress -e --multi-stream 0x10000, five streams.
+//
+STATIC CONST UINT8  mLzmaMultiStreamData[] = {
+  0x4C, 0x5A, 0x4D, 0x53, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0xC0, 0x04, 0x00,
+  0x24, 0x00, 0x00, 0x00, 0x0C, 0x03, 0x00, 0x00, 0x90, 0x03, 0x00, 0x00, 0x14, 0x04, 0x00, 0x00,
+  0x98, 0x04, 0x00, 0x00, 0xE8, 0x02, 0x00, 0x02, 0x98, 0x58, 0x4E, 0xEE, 0x14, 0x39, 0x59, 0x42,
+  0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF, 0x18, 0x00, 0x01, 0x00, 0x5D, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2B, 0x1B, 0xC9, 0x87, 0x88, 0xE0,
+  0x18, 0xAE, 0x50, 0xA0, 0x37, 0xA2, 0xB1, 0x38, 0xD1, 0x29, 0x76, 0x14, 0x89, 0x27, 0xE5, 0xEC,
+  0x3D, 0x5C, 0xA7, 0xFD, 0xB2, 0x96, 0x76, 0x59, 0xC0, 0x55, 0xAB, 0x84, 0xAF, 0xDD, 0x00, 0xE2,
+  0xFA, 0xC8, 0xE2, 0x4A, 0xB0, 0xBF, 0x14, 0xD4, 0x26, 0x13, 0x27, 0x14, 0xBF, 0x29, 0xBE, 0x77,
+  0x53, 0x0E, 0x64, 0xA8, 0xBC, 0xD6, 0x1C, 0x78, 0x62, 0x0F, 0xDB, 0x40, 0x0D, 0x84, 0x45, 0x84,
+  0x1C, 0xD1, 0xF7, 0x5E, 0x6D, 0x90, 0xB8, 0x14, 0x36, 0xA2, 0x79, 0xFF, 0xA9, 0x4B, 0x22, 0x07,
+  0x36, 0xA1, 0xC6, 0x6C, 0x83, 0x3C, 0x82, 0x42, 0x71, 0x99, 0x99, 0x75, 0xC1, 0xFD, 0x0B, 0xCE,
+  0xA2, 0xD5, 0x9A, 0xE4, 0x37, 0x10, 0xDB, 0x58, 0xCF, 0x48, 0x74, 0x17, 0x37, 0x0C, 0x1E, 0x7E,
+  0x62, 0xDE, 0x13, 0xBE, 0xDD, 0x3B, 0xD9, 0xC3, 0x11, 0xAA, 0x56, 0x4E, 0xD1, 0x22, 0x9C, 0xFA,
+  0xFF, 0x91, 0xCA, 0xA4, 0x6E, 0x4E, 0xAD, 0xD8, 0xC0, 0xA0, 0xE5, 0x50, 0x5B, 0x7E, 0x27, 0x4B,
+  0x1A, 0x38, 0x62, 0x1B, 0xB9, 0xB2, 0xE1, 0xDD, 0xF3, 0x50, 0x80, 0xEA, 0x20, 0x82, 0x2E, 0xB2,
+  0x97, 0x92, 0xCD, 0x93, 0x95, 0xAD, 0x42, 0xA4, 0x24, 0x6C, 0x31, 0xEA, 0x98, 0x1B, 0xB9, 0x1A,
+  0xB4, 0x24, 0x80, 0xC3, 0xDE, 0xE9, 0xFF, 0x0D, 0xE0, 0xAD, 0x7C, 0xF9, 0x4C, 0x26, 0x94, 0x6C,
+  0x67, 0x76, 0x65, 0x0A, 0xE9, 0x76, 0x1C, 0x48, 0xBC, 0x9D, 0x9A, 0x8A, 0xEE, 0xA9, 0xF2, 0xD4,
+  0xBA, 0x77, 0x63, 0x2B, 0xB8, 0x87, 0xFD, 0xCA, 0x39, 0xF5, 0x4E, 0xF0, 0x56, 0x70, 0xD3, 0x3B,
+  0xBF, 0x76, 0x90, 0x96, 0x2F, 0x07, 0x14, 0x6B, 0x77, 0x09, 0x65, 0x91, 0x5F, 0x84, 0xB0, 0xAD,
+  0x17, 0x5C, 0x03, 0xA0, 0x0A, 0x5A, 0xD1, 0x07, 0xBF, 0x08, 0xF4, 0x34, 0x9C, 0x99, 0x3B, 0x75,
+  0xE8, 0x77, 0xB4, 0xA6, 0xAB, 0x87, 0x26, 0x80, 0xCB, 0xC2, 0x4F, 0xAE, 0x6B, 0x3B, 0x07, 0xD9,
+  0x53, 0xF8, 0x64, 0xB9, 0x26, 0x37, 0x9C, 0x18, 0x63, 0x47, 0xFB, 0x22, 0x98, 0xCD, 0xF4, 0x74,
+  0x8D, 0x61, 0xE2, 0x4D, 0xD4, 0x51, 0x95, 0x86, 0x10, 0xB5, 0x41, 0xB6, 0xBD, 0x75, 0xB4, 0xE7,
+  0xB0, 0x7D, 0x3C, 0x0F, 0x5D, 0x4F, 0x22, 0x01, 0xC0, 0x1E, 0x92, 0xE5, 0xF7, 0xBD, 0x49, 0x5D,
+  0x79, 0x01, 0x67, 0x82, 0xB4, 0x81, 0xBB, 0x33, 0xE5, 0xA4, 0xEE, 0x45, 0xA3, 0x73, 0x41, 0x0E,
+  0xA0, 0xE1, 0x75, 0xD7, 0x6F, 0x1A, 0xD7, 0x4C, 0xE8, 0x76, 0xCB, 0xAE, 0xDC, 0xE7, 0xB3, 0x43,
+  0x64, 0xB6, 0x32, 0x81, 0x92, 0x85, 0xA4, 0x8F, 0x57, 0xCE, 0x7F, 0xE9, 0x0E, 0x1F, 0x08, 0x71,
+  0x66, 0xD7, 0x0F, 0xCC, 0x46, 0xFB, 0x4F, 0xC7, 0x38, 0x9B, 0xC1, 0x2B, 0xC7, 0xB1, 0x09, 0x60,
+  0x00, 0x54, 0x52, 0x9C, 0x64, 0x61, 0xB0, 0x08, 0xE4, 0xC9, 0x0A, 0xF0, 0xC7, 0xF1, 0x4A, 0xB3,
+  0x3A, 0x87, 0x40, 0x9F, 0x19, 0x44, 0x36, 0x03, 0xCE, 0x37, 0x96, 0x13, 0xF3, 0x3C, 0x91, 0x3F,
+  0xF6, 0x7F, 0x16, 0xA9, 0xFA, 0x2A, 0xA2, 0xF0, 0x70, 0xDC, 0x1E, 0x7F, 0xBF, 0xB9, 0x96, 0xF6,
+  0x4C, 0xD5, 0xC4, 0x2E, 0xF2, 0x05, 0x3D, 0x85, 0xFB, 0xF7, 0x23, 0x12, 0xB0, 0xF1, 0xD3, 0x2A,
+  0xFF, 0x7F, 0x91, 0x4F, 0xBB, 0x4B, 0x7F, 0x8A, 0x70, 0xB2, 0x49, 0x86, 0xB7, 0x97, 0xBF, 0x72,
+  0x38, 0xF2, 0xB1, 0x15, 0x89, 0x6A, 0x51, 0x93, 0xF9, 0x3E, 0xBA, 0x72, 0x66, 0xDD, 0xC7, 0x31,
+  0xC6, 0x7D, 0x14, 0x93, 0x4E, 0x8C, 0xBF, 0xB0, 0xD4, 0xA8, 0xEF, 0x9B, 0x2D, 0xBE, 0xEA, 0x05,
+  0xD3, 0xDF, 0x3C, 0xF1, 0x3C, 0xDF, 0xE4, 0xE4, 0x5A, 0x0F, 0x1C, 0x1E, 0xBA, 0xBA, 0xA4, 0x61,
+  0xE6, 0xFF, 0x0A, 0x87, 0x92, 0x2B, 0x36, 0x42, 0x09, 0xE4, 0x52, 0xFF, 0xB0, 0xAD, 0xF9, 0xD3,
+  0xC4, 0x45, 0xE0, 0x07, 0x73, 0xB0, 0xE7, 0x55, 0x93, 0x31, 0x0E, 0x89, 0x7C, 0xF6, 0x2F, 0x92,
+  0xEF, 0xBB, 0xF7, 0x17, 0xED, 0x52, 0x25, 0x87, 0xF7, 0x43, 0x21, 0xDB, 0x87, 0x08, 0xF8, 0xB1,
+  0xEF, 0xD8, 0x3D, 0x4F, 0x11, 0xF5, 0xC9, 0x7F, 0x7A, 0xFA, 0x63, 0x27, 0xD8, 0x30, 0xDB, 0x29,
+  0x0F, 0x44, 0x20, 0x74, 0xAD, 0xE1, 0xDF, 0xD2, 0x52, 0xDC, 0x1E, 0x76, 0xD7, 0x56, 0x92, 0xB7,
+  0x1E, 0xE5, 0xA3, 0x59, 0xAD, 0xDF, 0xFA, 0x51, 0xDE, 0x4B, 0x2B, 0xF4, 0x30, 0x8B, 0x1A, 0x72,
+  0x1D, 0x1D, 0xBF, 0xDB, 0x04, 0xBA, 0x1D, 0x42, 0x8B, 0x6F, 0x0C, 0x5A, 0x92, 0x38, 0x79, 0x1F,
+  0x11, 0x3A, 0x70, 0x14, 0xF3, 0x68, 0x3F, 0xDF, 0x60, 0xD6, 0x19, 0x12, 0xF3, 0xF6, 0xD2, 0xE7,
+  0x92, 0xB8, 0xAF, 0xE7, 0x08, 0xB4, 0x83, 0xFA, 0x7A, 0x57, 0x89, 0x93, 0x81, 0x63, 0x7F, 0x4A,
+  0x38, 0x9E, 0x88, 0xC8, 0x03, 0xDF, 0xCC, 0x4C, 0x44, 0xEB, 0x36, 0x2A, 0xC6, 0xC9, 0x57, 0x03,
+  0x79, 0xA8, 0x57, 0xEC, 0x4D, 0x3F, 0x9A, 0xC5, 0x23, 0xC1, 0x58, 0x2C, 0xBF, 0x90, 0x59, 0x97,
+  0x6D, 0xDC, 0x6E, 0x14, 0xF7, 0x68, 0x5A, 0x6C, 0x58, 0xD7, 0x95, 0x41, 0x82, 0x00, 0x00, 0x02,
+  0x98, 0x58, 0x4E, 0xEE, 0x14, 0x39, 0x59, 0x42, 0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF,
+  0x18, 0x00, 0x01, 0x00, 0x5D, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x20, 0x90, 0x84, 0x76, 0xBA, 0x8A, 0x75, 0xCF, 0xB4, 0x0D, 0xB2, 0xE8, 0x9F, 0x13,
+  0x87, 0xF8, 0x24, 0x34, 0x06, 0x66, 0x52, 0x69, 0x47, 0x5C, 0xB0, 0xAB, 0xEF, 0x75, 0x42, 0x32,
+  0x02, 0x40, 0x67, 0x0C, 0x71, 0x17, 0x9B, 0x60, 0x77, 0xF0, 0xD3, 0x5F, 0x7B, 0xA7, 0xB4, 0x35,
+  0x3D, 0x65, 0x2A, 0xAF, 0x79, 0x49, 0x11, 0xD8, 0x8E, 0x6F, 0xDB, 0x4F, 0x56, 0x1E, 0xE4, 0x5F,
+  0x74, 0x11, 0xAC, 0xAD, 0x96, 0x95, 0x98, 0x42, 0x9B, 0x5F, 0x0B, 0x9D, 0xC1, 0x61, 0xFA, 0x11,
+  0x8E, 0x80, 0x63, 0x30, 0xF7, 0x48, 0x6E, 0xD3, 0xAE, 0xAE, 0x89, 0xE2, 0xE5, 0xDE, 0x00, 0x00,
+  0x82, 0x00, 0x00, 0x02, 0x98, 0x58, 0x4E, 0xEE, 0x14, 0x39, 0x59, 0x42, 0x9D, 0x6E, 0xDC, 0x7B,
+  0xD7, 0x94, 0x03, 0xCF, 0x18, 0x00, 0x01, 0x00, 0x5D, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x90, 0x84, 0x76, 0xBA, 0x8A, 0x75, 0xCF, 0xB4, 0x0D,
+  0xB2, 0xE8, 0x9F, 0x13, 0x87, 0xF8, 0x24, 0x34, 0x06, 0x66, 0x52, 0x69, 0x47, 0x5C, 0xB0, 0xAB,
+  0xEF, 0x75, 0x42, 0x32, 0x02, 0x40, 0x67, 0x0C, 0x71, 0x17, 0x9B, 0x60, 0x77, 0xF0, 0xD3, 0x5F,
+  0x7B, 0xA7, 0xB4, 0x35, 0x3D, 0x65, 0x2A, 0xAF, 0x79, 0x49, 0x11, 0xD8, 0x8E, 0x6F, 0xDB, 0x4F,
+  0x56, 0x1E, 0xE4, 0x5F, 0x74, 0x11, 0xAC, 0xAD, 0x96, 0x95, 0x98, 0x42, 0x9B, 0x5F, 0x0B, 0x9D,
+  0xC1, 0x61, 0xFA, 0x11, 0x8E, 0x80, 0x63, 0x30, 0xF7, 0x48, 0x6E, 0xD3, 0xAE, 0xAE, 0x89, 0xE2,
+  0xE5, 0xDE, 0x00, 0x00, 0x82, 0x00, 0x00, 0x02, 0x98, 0x58, 0x4E, 0xEE, 0x14, 0x39, 0x59, 0x42,
+  0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF, 0x18, 0x00, 0x01, 0x00, 0x5D, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x90, 0x84, 0x76, 0xBA, 0x8A,
+  0x75, 0xCF, 0xB4, 0x0D, 0xB2, 0xE8, 0x9F, 0x13, 0x87, 0xF8, 0x24, 0x34, 0x06, 0x66, 0x52, 0x69,
+  0x47, 0x5C, 0xB0, 0xAB, 0xEF, 0x75, 0x42, 0x32, 0x02, 0x40, 0x67, 0x0C, 0x71, 0x17, 0x9B, 0x60,
+  0x77, 0xF0, 0xD3, 0x5F, 0x7B, 0xA7, 0xB4, 0x35, 0x3D, 0x65, 0x2A, 0xAF, 0x79, 0x49, 0x11, 0xD8,
+  0x8E, 0x6F, 0xDB, 0x4F, 0x56, 0x1E, 0xE4, 0x5F, 0x74, 0x11, 0xAC, 0xAD, 0x96, 0x95, 0x98, 0x42,
+  0x9B, 0x5F, 0x0B, 0x9D, 0xC1, 0x61, 0xFA, 0x11, 0x8E, 0x80, 0x63, 0x30, 0xF7, 0x48, 0x6E, 0xD3,
+  0xAE, 0xAE, 0x89, 0xE2, 0xE5, 0xDE, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x02, 0x98, 0x58, 0x4E, 0xEE,
+  0x14, 0x39, 0x59, 0x42, 0x9D, 0x6E, 0xDC, 0x7B, 0xD7, 0x94, 0x03, 0xCF, 0x18, 0x00, 0x01, 0x00,
+  0x5D, 0x00, 0x00, 0x00, 0x01, 0x00, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x90,
+  0x84, 0x76, 0xBA, 0x8A, 0x75, 0xCF, 0xB4, 0x0D, 0xB2, 0xE8, 0x9F, 0x13, 0x87, 0xF8, 0x24, 0x34,
+  0x06, 0x66, 0x52, 0x69, 0x47, 0x5C, 0xB0, 0xAB, 0xEF, 0x75, 0x42, 0x32, 0x02, 0x40, 0x67, 0x0C,
+  0x71, 0x17, 0x9B, 0x60, 0x77, 0xF0, 0xD3, 0x5F, 0x7B, 0xA7, 0xB4, 0x35, 0x3D, 0x65, 0x2A, 0xAF,
+  0x79, 0x49, 0x11, 0xD8, 0x8E, 0x6F, 0xDB, 0x4F, 0x56, 0x1E, 0xE4, 0x5F, 0x74, 0x11, 0xAC, 0xAD,
+  0x96, 0x95, 0x98, 0x42, 0x9B, 0x5F, 0x0B, 0x9D, 0xC1, 0x61, 0xFA, 0x11, 0x8E, 0x80, 0x63, 0x30,
+  0xF7, 0x46, 0x1E, 0xF9, 0xFD, 0x00
+};
+
+//
+// The data of GenerateTestData() compressed by BrotliCompress -e.
+//
+STATIC CONST UINT8  mBrotliData[] = {
+  0x00, 0xC0, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x77, 0x76, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x55, 0xFF, 0xBF, 0x04, 0x40, 0x6C, 0x34, 0x44, 0x7D, 0x8C, 0x8A, 0x90, 0x1C, 0x6C, 0x09, 0x3F,
+  0xDA, 0x9D, 0xAA, 0x0A, 0x97, 0xAA, 0x35, 0xF9, 0xE7, 0xED, 0xE2, 0x0B, 0xB0, 0xED, 0x23, 0xB7,
+  0xEA, 0x88, 0x0C, 0x0E, 0xD9, 0x24, 0xAF, 0xEC, 0x56, 0x96, 0x3A, 0x6D, 0x7B, 0xB0, 0x88, 0xD7,
+  0x80, 0x97, 0x7F, 0x7E, 0xEF, 0x75, 0xFA, 0x59, 0xDC, 0x5E, 0x16, 0x59, 0x88, 0xC1, 0xEF, 0x8F,
+  0xDF, 0x3E, 0xFF, 0xF9, 0xF2, 0xFC, 0x48, 0x8F, 0xAF, 0xEA, 0xD7, 0xFE, 0xAF, 0xA7, 0x4F, 0x9F,
+  0x7E, 0x3D, 0xFF, 0x7E, 0xA4, 0xFF, 0xF4, 0x70, 0xC5, 0x85, 0x1B, 0xBE, 0xC5, 0xB6, 0x8B, 0x6F,
+  0xFC, 0xF1, 0xBE, 0xE4, 0x26, 0x9F, 0xBA, 0x97, 0xDE, 0xF4, 0xB3, 0xF5, 0xB2, 0x9B, 0xFD, 0x80,
+  0x6A, 0xBB, 0xFC, 0xEE, 0x7F, 0x97, 0xF3, 0x70, 0x77, 0x0D, 0x2F, 0x21, 0xD3, 0xF4, 0xD2, 0x59,
+  0xCB, 0xCB, 0xDE, 0x15, 0x8F, 0x0F, 0x0C, 0x9E, 0xE2, 0x00, 0x6B, 0x4C, 0x31, 0xE0, 0x58, 0x15,
+  0x03, 0x1E, 0x54, 0x0C, 0xF8, 0x78, 0xC5, 0x40, 0x30, 0x15, 0x49, 0x8C, 0x9A, 0x49, 0xD2, 0xCC,
+  0x24, 0xD3, 0x66, 0x90, 0x73, 0x95, 0x41, 0x59, 0x95, 0x41, 0xAD, 0x94, 0x41, 0xF3, 0x28, 0x83,
+  0x2E, 0x51, 0x06, 0xBD, 0xA9, 0x0C, 0xC6, 0x5B, 0x99, 0xCC, 0xD9, 0x24, 0xAB, 0x30, 0xC9, 0xD6,
+  0x32, 0xC1, 0x09, 0x2A, 0xE0, 0xE2, 0x2A, 0xE0, 0x3E, 0x76, 0xF9, 0xAE, 0xFF, 0x40, 0x2A, 0x0B,
+  0xBE, 0x4D, 0x05, 0x82, 0x5A, 0x05, 0x42, 0xAE, 0x0A, 0x45, 0xA8, 0x49, 0xD1, 0x65, 0x52, 0xEC,
+  0x63, 0x42, 0x42, 0x54, 0x21, 0x35, 0x55, 0x21, 0x63, 0xAB, 0x42, 0x0E, 0xAB, 0x42, 0x9E, 0x50,
+  0x85, 0xC2, 0x52, 0x85, 0x32, 0xA8, 0x52, 0xA5, 0x9B, 0x54, 0x33, 0x26, 0xD5, 0x25, 0x13, 0x9A,
+  0x4D, 0x0D, 0xDA, 0x5A, 0x0D, 0x3A, 0xAF, 0x1A, 0xF4, 0x52, 0x35, 0xE8, 0x5B, 0x6A, 0x30, 0x7C,
+  0xD4, 0x60, 0x5C, 0xD4, 0x68, 0x2A, 0x4D, 0x9A, 0xB5, 0x4D, 0x5A, 0xC4, 0x26, 0x2C, 0x09, 0x75,
+  0x58, 0xBE, 0xD4, 0x61, 0x35, 0xD4, 0x61, 0x6D, 0x57, 0x87, 0x4D, 0xA3, 0x0E, 0x5B, 0x49, 0x1D,
+  0x76, 0x98, 0x3A, 0xED, 0x6E, 0x93, 0xF6, 0xBE, 0x26, 0x1D, 0xA8, 0x09, 0x47, 0x4B, 0x03, 0x4E,
+  0x1C, 0x0D, 0x38, 0x23, 0x1A, 0x70, 0x4E, 0x6A, 0xC0, 0xC5, 0xD6, 0x80, 0x6B, 0xAC, 0x01, 0x37,
+  0x43, 0x83, 0xEE, 0x2C, 0x93, 0xEE, 0x85, 0xE9, 0x04, 0x62, 0x6F, 0x76, 0x00, 0xD9, 0xD4, 0xEC,
+  0x00, 0x2A, 0xAA, 0xD9, 0x01, 0xB4, 0xAC, 0x66, 0x07, 0xD0, 0xED, 0x9A, 0x1D, 0x00, 0xBE, 0x35,
+  0x3B, 0x00, 0xAE, 0x35, 0x3B, 0x00, 0x55, 0x9A, 0x9D, 0x80, 0x75, 0xCC, 0x4E, 0x60, 0x12, 0x4B,
+  0x62, 0x49, 0x0B, 0xB0, 0x6F, 0x5B, 0x01, 0x37, 0xDB, 0x0A, 0x78, 0x87, 0xAD, 0x40, 0x68, 0xD9,
+  0x0A, 0x44, 0x61, 0x2B, 0x90, 0x70, 0x5B, 0x81, 0xF4, 0xD8, 0x8A, 0xE4, 0x90, 0x85, 0x14, 0x66,
+  0x21, 0xD5, 0xB6, 0x80, 0xC6, 0xF5, 0x00, 0x05, 0x1D, 0xED, 0x01, 0x0A, 0x7A, 0xAA, 0x07, 0x28,
+  0x18, 0x4E, 0x0F, 0x50, 0x30, 0x93, 0x1E, 0xA0, 0x60, 0x99, 0x3D, 0x40, 0xC1, 0x66, 0xF7, 0x00,
+  0x45, 0xBB, 0xDC, 0x12, 0x9D, 0xC3, 0x12, 0xDD, 0x96, 0x25, 0x79, 0xC1, 0x06, 0xF2, 0xE5, 0x36,
+  0x90, 0xDF, 0xB1, 0xC1, 0x6B, 0xC8, 0x6F, 0xE9, 0x06, 0x0A, 0xB7, 0xB5, 0x81, 0xA2, 0xDA, 0x06,
+  0x8A, 0x75, 0x6D, 0xC0, 0x24, 0xB5, 0x60, 0x4A, 0x59, 0x30, 0xFD, 0x58, 0x28, 0x5B, 0x6C, 0x4C,
+  0xB9, 0xD3, 0xC6, 0x5E, 0x8B, 0xFE, 0x5A, 0xFF, 0x43, 0xF5, 0x94, 0x80, 0xB9, 0x67, 0xED, 0x73,
+  0x5F, 0xBC, 0x7C, 0xF5, 0xFA, 0xCD, 0xDB, 0x77, 0xEF, 0x9F, 0x3E, 0x9C, 0x03
+};
+
+//
+// A frame of TEST_TEXT_SIZE bytes of text, a skippable frame and a frame of
+// TEST_PATTERN_SIZE bytes of pattern, made by the zstd tool from the parts of
+// the data of GenerateTestData(). The two data frames have a content checksum.
+//
+STATIC CONST UINT8  mZstdFrames[] = {
+  0x28, 0xB5, 0x2F, 0xFD, 0x64, 0x00, 0x0F, 0xF5, 0x12, 0x00, 0x76, 0x6A, 0x5F, 0x1C, 0x70, 0x49,
+  0x92, 0x36, 0x00, 0x51, 0xC6, 0x47, 0x3E, 0xF9, 0x4B, 0x87, 0x53, 0xDC, 0x69, 0x8D, 0x90, 0xD4,
+  0xAF, 0xEC, 0xEE, 0xDE, 0x09, 0x20, 0xF4, 0xFF, 0xEE, 0xE1, 0x60, 0x00, 0x56, 0x00, 0x52, 0x00,
+  0xB5, 0xBC, 0x09, 0xC1, 0xF7, 0xF2, 0x6E, 0x37, 0x7B, 0x95, 0x57, 0x9D, 0xB0, 0xA0, 0xCF, 0x90,
+  0xF9, 0x09, 0xFC, 0x9D, 0xE5, 0x97, 0x4E, 0xBD, 0x15, 0x44, 0xBA, 0xC6, 0x80, 0xA6, 0xC2, 0xF3,
+  0xB4, 0xCC, 0x1F, 0x3C, 0x65, 0x1B, 0x41, 0xAE, 0x87, 0xB1, 0x91, 0xBB, 0xEB, 0xC8, 0xA6, 0xFB,
+  0x9E, 0x52, 0xF2, 0x38, 0xD0, 0x73, 0x57, 0x62, 0xCC, 0xB2, 0xAE, 0xA2, 0x42, 0x54, 0xE4, 0xCC,
+  0xB0, 0xBF, 0xC6, 0x06, 0xD0, 0x05, 0x2D, 0x24, 0x18, 0x24, 0x38, 0x38, 0x08, 0x50, 0x68, 0x01,
+  0x01, 0x42, 0x81, 0x04, 0x02, 0x06, 0x02, 0x0A, 0x2D, 0x18, 0x1C, 0x50, 0x60, 0x00, 0x61, 0x40,
+  0x37, 0xF3, 0xB0, 0x15, 0xB1, 0x1A, 0xDD, 0x64, 0xCD, 0x4B, 0xB0, 0x5E, 0xC8, 0x95, 0x31, 0xAD,
+  0x3A, 0x56, 0x65, 0xC4, 0x07, 0xAA, 0xCA, 0x62, 0x8A, 0x88, 0xBC, 0xA6, 0x40, 0xD7, 0x47, 0xB5,
+  0x5C, 0x1F, 0x49, 0x6D, 0x81, 0x64, 0xC3, 0x70, 0x54, 0x86, 0x46, 0xE4, 0x2A, 0x1A, 0xE2, 0x24,
+  0xFA, 0x11, 0x43, 0xFE, 0x70, 0x6A, 0x39, 0x93, 0x21, 0x95, 0x6A, 0x8C, 0x39, 0x44, 0x14, 0x9C,
+  0xC9, 0x71, 0x73, 0x3A, 0x1B, 0x17, 0x53, 0xD3, 0xD1, 0xA3, 0xB1, 0x2A, 0x33, 0xD5, 0xF1, 0xA1,
+  0xC1, 0x3C, 0x63, 0xD3, 0xB9, 0x03, 0x1D, 0x3F, 0x5D, 0x6E, 0x67, 0xC7, 0xDD, 0x34, 0xBB, 0x13,
+  0x6B, 0x6E, 0x44, 0xEA, 0x7D, 0x38, 0xC4, 0x36, 0x7C, 0xDA, 0x85, 0x36, 0x9B, 0xB0, 0xB7, 0x07,
+  0xAD, 0xA8, 0x8F, 0x45, 0x6A, 0x23, 0x65, 0x5D, 0x9C, 0xAA, 0xF3, 0xFE, 0x1A, 0xCF, 0x2E, 0xEE,
+  0x4A, 0x06, 0x3B, 0x3B, 0xAC, 0xAB, 0x17, 0x1D, 0x15, 0x17, 0x73, 0x83, 0xC4, 0xEF, 0x33, 0xF8,
+  0x4C, 0x5C, 0xAF, 0x49, 0x69, 0x46, 0x26, 0xD0, 0xAA, 0x28, 0x67, 0x34, 0x86, 0xD9, 0xD4, 0x95,
+  0xBD, 0x44, 0xE6, 0xA1, 0x65, 0xAC, 0x56, 0x02, 0x9F, 0xD2, 0xF4, 0xB1, 0x60, 0x6F, 0xCF, 0xC0,
+  0x2C, 0x61, 0x88, 0x96, 0x83, 0xE7, 0xA2, 0xA2, 0x99, 0x0A, 0x72, 0xE5, 0x19, 0x79, 0xE4, 0x97,
+  0xDD, 0xD8, 0x9D, 0xBB, 0x3B, 0x14, 0x66, 0x9B, 0x11, 0xAB, 0xCB, 0x69, 0x59, 0x22, 0x65, 0xD8,
+  0xB9, 0xDB, 0xF5, 0x2F, 0xCA, 0xEA, 0x32, 0x54, 0xB5, 0x88, 0x45, 0xB5, 0xA9, 0x9A, 0x16, 0xE1,
+  0x7A, 0x29, 0x09, 0x72, 0x87, 0x06, 0x6A, 0xFD, 0xA3, 0x4C, 0x13, 0x61, 0xD6, 0x74, 0x69, 0xC4,
+  0x58, 0xD6, 0x98, 0x4A, 0xBA, 0xA1, 0x1C, 0x1A, 0x4F, 0x3E, 0x81, 0x6D, 0xA8, 0x11, 0x80, 0xD5,
+  0xDE, 0xFF, 0x0D, 0xC1, 0x67, 0x54, 0x3A, 0x11, 0x8C, 0x20, 0x61, 0xE9, 0x03, 0x81, 0x13, 0x89,
+  0x5A, 0x49, 0x24, 0x81, 0xAA, 0xA4, 0x72, 0xA9, 0x92, 0xE5, 0xA2, 0x4A, 0x96, 0x4B, 0x95, 0x54,
+  0x2E, 0x55, 0xB2, 0x5C, 0x54, 0xC9, 0x72, 0xA9, 0x92, 0xCA, 0xA5, 0x4A, 0x96, 0x8B, 0x2A, 0x45,
+  0x36, 0x85, 0x3E, 0x79, 0xB1, 0xC2, 0xE1, 0x8A, 0x5D, 0x1C, 0xC1, 0x1F, 0x26, 0x62, 0x37, 0x5C,
+  0x88, 0xE9, 0x10, 0x10, 0xB3, 0xE1, 0x3E, 0x4C, 0x87, 0x78, 0x98, 0x0D, 0xD7, 0x61, 0x3A, 0x84,
+  0xC3, 0x6C, 0xB8, 0x0D, 0xD3, 0x21, 0x1A, 0x66, 0xC3, 0x65, 0x98, 0x0E, 0xC1, 0x30, 0x1B, 0xEE,
+  0xC2, 0x74, 0x88, 0x85, 0xD9, 0x70, 0x15, 0xA6, 0x43, 0x28, 0xCC, 0x7C, 0x80, 0x0D, 0x16, 0x51,
+  0xF0, 0xFD, 0x03, 0x3F, 0x94, 0x60, 0xF1, 0xE7, 0x0F, 0xD8, 0x60, 0x21, 0x0A, 0xDF, 0x3F, 0xE0,
+  0x47, 0x09, 0x16, 0xFE, 0xFC, 0x80, 0x0D, 0x2C, 0xE6, 0xA1, 0x01, 0x08, 0x7E, 0x94, 0x20, 0x37,
+  0x0D, 0x58, 0xB8, 0xC3, 0x62, 0x1E, 0x34, 0x80, 0xE0, 0x87, 0x12, 0x72, 0xD3, 0x00, 0x8B, 0x3B,
+  0x2C, 0xCC, 0x43, 0x03, 0x08, 0xFC, 0x28, 0x21, 0x37, 0x1A, 0xB0, 0xB8, 0x83, 0x6A, 0x1F, 0xF8,
+  0xA1, 0x04, 0x8B, 0x3F, 0x7E, 0xC0, 0x06, 0x0B, 0x51, 0xF8, 0xFE, 0x01, 0x3F, 0x4A, 0xB0, 0x6C,
+  0x26, 0xE9, 0xFB, 0x0C, 0x0E, 0x52, 0xF9, 0xA3, 0x03, 0xF3, 0xC1, 0x19, 0x0A, 0x6D, 0x21, 0xC4,
+  0x25, 0x56, 0x77, 0xE4, 0x32, 0x00, 0x69, 0x15, 0xEE, 0xC1, 0x52, 0x7E, 0x5E, 0x2A, 0x4D, 0x18,
+  0x04, 0x00, 0x00, 0x00, 0x45, 0x44, 0x4B, 0x32, 0x28, 0xB5, 0x2F, 0xFD, 0xA4, 0x00, 0xB0, 0x04,
+  0x00, 0xC4, 0x00, 0x00, 0x80, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B,
+  0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x01, 0x00, 0xDA, 0xFF, 0x27, 0x9F, 0x4B, 0x44, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0xFD, 0xFF, 0x93, 0x4F, 0x20, 0x45, 0x00, 0x00, 0x00, 0x01, 0x00, 0xFD, 0x2F, 0x1D,
+  0x00, 0x01, 0xD5, 0x83, 0x44, 0xB6
+};
+
+//
+// Truncating mZstdFrames at the end of one of its frames leaves valid data.
+//
+STATIC CONST UINTN  mZstdFrameEnds[] = { 620, 632 };
+
+//
+// The offsets of the last byte of the content checksum of each data frame.
+//
+STATIC CONST UINTN  mZstdChecksumEnds[] = { 619, 693 };
+
+STATIC GUIDED_SECTION_CODEC  mCodecs[] = {
+  { "Tiano",             &gTianoCustomDecompressGuid,           "tiano", NULL,                 0                              },
+  { "LZMA",              &gLzmaCustomDecompressGuid,            "lzma",  mLzmaData,            sizeof (mLzmaData)             },
+  { "LZMA multi-stream", &gLzmaMultiStreamCustomDecompressGuid, "lzms",  mLzmaMultiStreamData, sizeof (mLzmaMultiStreamData) },
+  { "Brotli",            &gBrotliCustomDecompressGuid,          "br",    mBrotliData,          sizeof (mBrotliData)           },
+  { "Zstandard",         &gZstdCustomDecompressGuid,            "zst",   mZstdFrames,          sizeof (mZstdFrames)           }
+};
+
+//
+// The sizes of the parts the section data is read in by the stream decode
+// test, the smallest ones split the headers of the codecs.
+//
+STATIC CONST UINTN  mStreamChunkSizes[] = { 1, 13, SIZE_4KB, SIZE_64KB };
+
+STATIC CHAR8  **mFvImages;
+STATIC UINTN  mFvImageCount;
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Generates the data the section data of mCodecs was compressed from.
+
+  @param[out] Buffer  Receives TEST_DATA_SIZE bytes.
+
+**/
+STATIC
+VOID
+GenerateTestData (
+  OUT UINT8  *Buffer
+  )
+{
+  CHAR8  Line[64];
+  UINTN  Offset;
+  UINTN  Length;
+  UINTN  Index;
+
+  Offset = 0;
+  for (Index = 0; Offset < TEST_TEXT_SIZE; Index++) {
+    //
+    // The line ends in a bare \n, PrintLib would print a \n of the format as \r\n.
+    //
+    Length         = AsciiSPrint (Line, sizeof (Line) - 1, "Volume %u Section %u Offset 0x%X", (UINT32)(Index % 7), (UINT32)Index, (UINT32)(Index * 0x35));
+    Line[Length++] = '\n';
+    Length = MIN (Length, TEST_TEXT_SIZE - Offset);
+    CopyMem (Buffer + Offset, Line, Length);
+    Offset += Length;
+  }
+
+  for (Index = 0; Index < TEST_PATTERN_SIZE; Index++) {
+    Buffer[Offset + Index] = (UINT8)((Index & 0xF) + 'A');
+  }
+}
+
+/**
+  Wraps data in a GUIDed section the way GenFds does.
+
+  @param[in] Guid      The section definition GUID.
+  @param[in] Data      The section data.
+  @param[in] DataSize  Size, in bytes, of the section data.
+
+  @return The allocated GUIDed section, or NULL if out of memory.
+
+**/
+STATIC
+VOID *
+BuildGuidedSection (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *Data,
+  IN UINTN           DataSize
+  )
+{
+  EFI_GUID_DEFINED_SECTION   *Section;
+  EFI_GUID_DEFINED_SECTION2  *Section2;
+  UINTN                      HeaderSize;
+
+  HeaderSize = sizeof (EFI_GUID_DEFINED_SECTION);
+  if (HeaderSize + DataSize >= 0xFFFFFF) {
+    HeaderSize = sizeof (EFI_GUID_DEFINED_SECTION2);
+  }
+
+  Section = AllocatePool (HeaderSize + DataSize);
+  if (Section == NULL) {
+    return NULL;
+  }
+
+  if (HeaderSize == sizeof (EFI_GUID_DEFINED_SECTION)) {
+    Section->CommonHeader.Type    = EFI_SECTION_GUID_DEFINED;
+    Section->CommonHeader.Size[0] = (UINT8)(HeaderSize + DataSize);
+    Section->CommonHeader.Size[1] = (UINT8)((HeaderSize + DataSize) >> 8);
+    Section->CommonHeader.Size[2] = (UINT8)((HeaderSize + DataSize) >> 16);
+    CopyGuid (&Section->SectionDefinitionGuid, Guid);
+    Section->DataOffset = (UINT16)HeaderSize;
+    Section->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+  } else {
+    Section2                            = (EFI_GUID_DEFINED_SECTION2 *)Section;
+    Section2->CommonHeader.Type         = EFI_SECTION_GUID_DEFINED;
+    Section2->CommonHeader.Size[0]      = 0xFF;
+    Section2->CommonHeader.Size[1]      = 0xFF;
+    Section2->CommonHeader.Size[2]      = 0xFF;
+    Section2->CommonHeader.ExtendedSize = (UINT32)(HeaderSize + DataSize);
+    CopyGuid (&Section2->SectionDefinitionGuid, Guid);
+    Section2->DataOffset = (UINT16)HeaderSize;
+    Section2->Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED;
+  }
+
+  CopyMem ((UINT8 *)Section + HeaderSize, Data, DataSize);
+  return Section;
+}
+
+/**
+  Decodes a GUIDed section through the registered handler.
+
+  @param[in]  Section     The GUIDed section.
+  @param[out] Output      Receives the allocated decoded data.
+  @param[out] OutputSize  Receives the size, in bytes, of the decoded data.
+
+  @retval RETURN_SUCCESS  The section was decoded into Output.
+  @retval Others          The section could not be decoded, Output is NULL.
+
+**/
+STATIC
+RETURN_STATUS
+DecodeGuidedSection (
+  IN  CONST VOID  *Section,
+  OUT UINT8       **Output,
+  OUT UINT32      *OutputSize
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         ScratchSize;
+  UINT16         Attributes;
+  VOID           *Scratch;
+  VOID           *Buffer;
+  UINT32         AuthenticationStatus;
+
+  *Output = NULL;
+  Status  = ExtractGuidedSectionGetInfo (Section, OutputSize, &ScratchSize, &Attributes);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Buffer  = AllocatePool (MAX (*OutputSize, 1));
+  Scratch = AllocatePool (MAX (ScratchSize, 1));
+  if ((Buffer == NULL) || (Scratch == NULL)) {
+    Status = RETURN_OUT_OF_RESOURCES;
+  } else {
+    *Output = Buffer;
+    Status  = ExtractGuidedSectionDecode (Section, (VOID **)Output, Scratch, &AuthenticationStatus);
+  }
+
+  if (Scratch != NULL) {
+    FreePool (Scratch);
+  }
+
+  if (RETURN_ERROR (Status) && (Buffer != NULL)) {
+    FreePool (Buffer);
+    *Output = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Returns the next part of the section data of a stream decode.
+
+  @param[in]  Context  The STREAM_TEST_CONTEXT.
+  @param[out] Buffer   Receives a pointer to the next part.
+  @param[out] Size     Receives the size, in bytes, of the next part.
+
+  @retval RETURN_SUCCESS  The next part was returned.
+
+**/
+STATIC
+RETURN_STATUS
+EFIAPI
+ReadTestChunk (
+  IN  VOID        *Context,
+  OUT CONST VOID  **Buffer,
+  OUT UINTN       *Size
+  )
+{
+  STREAM_TEST_CONTEXT  *Stream;
+
+  Stream          = (STREAM_TEST_CONTEXT *)Context;
+  *Buffer         = Stream->Data + Stream->Offset;
+  *Size           = MIN (Stream->ChunkSize, Stream->DataSize - Stream->Offset);
+  Stream->Offset += *Size;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Appends a decoded part of a stream decode to the output, after checking
+  that it lies in the window buffer of the stream decode handler.
+
+  @param[in] Context  The STREAM_TEST_CONTEXT.
+  @param[in] Buffer   The decoded part.
+  @param[in] Size     The size, in bytes, of the decoded part.
+
+  @retval RETURN_SUCCESS  The part was appended to the output.
+  @retval RETURN_ABORTED  The part is not in the window buffer, or it does
+                          not fit in the output.
+
+**/
+STATIC
+RETURN_STATUS
+EFIAPI
+WriteTestChunk (
+  IN VOID        *Context,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Size
+  )
+{
+  STREAM_TEST_CONTEXT  *Stream;
+
+  Stream = (STREAM_TEST_CONTEXT *)Context;
+  if (((CONST UINT8 *)Buffer < Stream->Window) ||
+      ((CONST UINT8 *)Buffer + Size > Stream->Window + Stream->WindowSize) ||
+      (Size > Stream->OutputSize - Stream->OutputEnd))
+  {
+    return RETURN_ABORTED;
+  }
+
+  CopyMem (Stream->Output + Stream->OutputEnd, Buffer, Size);
+  Stream->OutputEnd += Size;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decodes a GUIDed section through the registered stream decode handler,
+  reading the section data in parts of the same size.
+
+  @param[in]  Section     The GUIDed section.
+  @param[in]  DataSize    Size, in bytes, of the section data that can be read.
+  @param[in]  ChunkSize   Size, in bytes, of the parts the section data is read in.
+  @param[in]  IntoOutput  TRUE to decode straight into Output with the scratch buffer
+                          of the regular handler, FALSE to decode through the window
+                          buffer of the stream handler.
+  @param[out] Output      Receives the allocated decoded data.
+  @param[out] OutputSize  Receives the size, in bytes, of the decoded data.
+  @param[out] WindowSize  Receives the size, in bytes, of the work buffer.
+
+  @retval RETURN_SUCCESS    The section was decoded into Output.
+  @retval RETURN_NOT_FOUND  No stream decode handler is registered for the section.
+  @retval Others            The section could not be decoded, Output is NULL.
+
+**/
+STATIC
+RETURN_STATUS
+DecodeGuidedSectionStream (
+  IN  CONST VOID  *Section,
+  IN  UINTN       DataSize,
+  IN  UINTN       ChunkSize,
+  IN  BOOLEAN     IntoOutput,
+  OUT UINT8       **Output,
+  OUT UINT32      *OutputSize,
+  OUT UINT32      *WindowSize
+  )
+{
+  RETURN_STATUS                                   Status;
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler;
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler;
+  UINT16                                          Attributes;
+  VOID                                            *Window;
+  UINT32                                          AuthenticationStatus;
+  STREAM_TEST_CONTEXT                             Stream;
+
+  *Output = NULL;
+  if (IS_SECTION2 (Section)) {
+    Status      = ExtractGuidedSectionGetStreamHandler (&((EFI_GUID_DEFINED_SECTION2 *)Section)->SectionDefinitionGuid, &StreamGetInfoHandler, &StreamDecodeHandler);
+    Stream.Data = (CONST UINT8 *)Section + ((EFI_GUID_DEFINED_SECTION2 *)Section)->DataOffset;
+  } else {
+    Status      = ExtractGuidedSectionGetStreamHandler (&((EFI_GUID_DEFINED_SECTION *)Section)->SectionDefinitionGuid, &StreamGetInfoHandler, &StreamDecodeHandler);
+    Stream.Data = (CONST UINT8 *)Section + ((EFI_GUID_DEFINED_SECTION *)Section)->DataOffset;
+  }
+
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = StreamGetInfoHandler (Section, OutputSize, WindowSize, &Attributes);
+  if (!RETURN_ERROR (Status) && IntoOutput) {
+    Status = ExtractGuidedSectionGetInfo (Section, OutputSize, WindowSize, &Attributes);
+  }
+
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Window            = AllocatePool (MAX (*WindowSize, 1));
+  Stream.DataSize   = DataSize;
+  Stream.ChunkSize  = ChunkSize;
+  Stream.Offset     = 0;
+  Stream.Window     = Window;
+  Stream.WindowSize = *WindowSize;
+  Stream.Output     = AllocatePool (MAX (*OutputSize, 1));
+  Stream.OutputSize = *OutputSize;
+  Stream.OutputEnd  = 0;
+  if ((Stream.Output == NULL) || (Window == NULL)) {
+    Status = RETURN_OUT_OF_RESOURCES;
+  } else {
+    Status = StreamDecodeHandler (
+               Section,
+               ReadTestChunk,
+               IntoOutput ? NULL : WriteTestChunk,
+               &Stream,
+               IntoOutput ? Stream.Output : NULL,
+               Window,
+               *WindowSize,
+               &AuthenticationStatus
+               );
+    //
+    // Every decoded byte must have been passed to WriteTestChunk().
+    //
+    if (!RETURN_ERROR (Status) && !IntoOutput && (Stream.OutputEnd != *OutputSize)) {
+      Status = RETURN_ABORTED;
+    }
+  }
+
+  if (Window != NULL) {
+    FreePool (Window);
+  }
+
+  if (!RETURN_ERROR (Status)) {
+    *Output = Stream.Output;
+  } else if (Stream.Output != NULL) {
+    FreePool (Stream.Output);
+  }
+
+  return Status;
+}
+
+/**
+  Reads a whole file.
+
+  @param[in]  FileName  The name of the file.
+  @param[out] Size      Receives the size, in bytes, of the file.
+
+  @return The allocated content of the file, or NULL if it can not be read.
+
+**/
+STATIC
+UINT8 *
+ReadHostFile (
+  IN  CONST CHAR8  *FileName,
+  OUT UINTN        *Size
+  )
+{
+  FILE   *File;
+  long   FileSize;
+  UINT8  *Buffer;
+
+  File = fopen (FileName, "rb");
+  if (File == NULL) {
+    return NULL;
+  }
+
+  Buffer   = NULL;
+  FileSize = -1;
+  if (fseek (File, 0, SEEK_END) == 0) {
+    FileSize = ftell (File);
+  }
+
+  if ((FileSize > 0) && (fseek (File, 0, SEEK_SET) == 0)) {
+    Buffer = AllocatePool ((UINTN)FileSize);
+    if ((Buffer != NULL) && (fread (Buffer, 1, (size_t)FileSize, File) != (size_t)FileSize)) {
+      FreePool (Buffer);
+      Buffer = NULL;
+    }
+
+    *Size = (UINTN)FileSize;
+  }
+
+  fclose (File);
+  return Buffer;
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  Decodes the section data of every codec of mCodecs through the registered
+  handlers.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The section data decoded to the data it was made of.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The section data of a codec did not decode.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SectionDataShouldDecode (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   *Expected;
+  UINTN   CodecIndex;
+  VOID    *Section;
+  UINT8   *Output;
+  UINT32  OutputSize;
+
+  Expected = AllocatePool (TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Expected);
+  GenerateTestData (Expected);
+
+  for (CodecIndex = 0; CodecIndex < ARRAY_SIZE (mCodecs); CodecIndex++) {
+    if (mCodecs[CodecIndex].Data == NULL) {
+      continue;
+    }
+
+    UT_LOG_INFO ("%a\n", mCodecs[CodecIndex].Name);
+    Section = BuildGuidedSection (mCodecs[CodecIndex].Guid, mCodecs[CodecIndex].Data, mCodecs[CodecIndex].DataSize);
+    UT_ASSERT_NOT_NULL (Section);
+
+    UT_ASSERT_NOT_EFI_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize));
+    UT_ASSERT_EQUAL (OutputSize, TEST_DATA_SIZE);
+    UT_ASSERT_MEM_EQUAL (Output, Expected, OutputSize);
+
+    FreePool (Output);
+    FreePool (Section);
+  }
+
+  FreePool (Expected);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes every truncation of mZstdFrames that does not end at a frame.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             All the truncated frames were rejected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A truncated frame was decoded.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TruncatedZstdFramesShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID    *Section;
+  UINT8   *Output;
+  UINT32  OutputSize;
+  UINTN   Length;
+  UINTN   Index;
+
+  for (Length = 0; Length < sizeof (mZstdFrames); Length++) {
+    for (Index = 0; Index < ARRAY_SIZE (mZstdFrameEnds); Index++) {
+      if (Length == mZstdFrameEnds[Index]) {
+        break;
+      }
+    }
+
+    if (Index < ARRAY_SIZE (mZstdFrameEnds)) {
+      continue;
+    }
+
+    Section = BuildGuidedSection (&gZstdCustomDecompressGuid, mZstdFrames, Length);
+    UT_ASSERT_NOT_NULL (Section);
+    UT_ASSERT_TRUE (RETURN_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize)));
+    FreePool (Section);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes mZstdFrames with the content checksum of one of its data frames
+  changed.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             All the frames with a wrong checksum were rejected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A frame with a wrong checksum was decoded.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ZstdChecksumMismatchShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8   *Frames;
+  VOID    *Section;
+  UINT8   *Output;
+  UINT32  OutputSize;
+  UINTN   Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mZstdChecksumEnds); Index++) {
+    Frames = AllocateCopyPool (sizeof (mZstdFrames), mZstdFrames);
+    UT_ASSERT_NOT_NULL (Frames);
+    Frames[mZstdChecksumEnds[Index]] ^= 0x01;
+
+    Section = BuildGuidedSection (&gZstdCustomDecompressGuid, Frames, sizeof (mZstdFrames));
+    UT_ASSERT_NOT_NULL (Section);
+    UT_ASSERT_TRUE (RETURN_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize)));
+
+    FreePool (Section);
+    FreePool (Frames);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes the section data of every codec of mCodecs that has a stream decode
+  handler, in parts of each size of mStreamChunkSizes, and decodes the first
+  half of it, which must fail.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The stream decode handlers returned the data
+                                       and rejected the truncated data.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A stream decode handler did not return the data.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamDecodeShouldMatchData (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8                                           *Expected;
+  UINTN                                           CodecIndex;
+  UINTN                                           Index;
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler;
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler;
+  VOID                                            *Section;
+  UINT8                                           *Output;
+  UINT32                                          OutputSize;
+  UINT32                                          WindowSize;
+
+  Expected = AllocatePool (TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Expected);
+  GenerateTestData (Expected);
+
+  for (CodecIndex = 0; CodecIndex < ARRAY_SIZE (mCodecs); CodecIndex++) {
+    if ((mCodecs[CodecIndex].Data == NULL) ||
+        RETURN_ERROR (ExtractGuidedSectionGetStreamHandler (mCodecs[CodecIndex].Guid, &StreamGetInfoHandler, &StreamDecodeHandler)))
+    {
+      continue;
+    }
+
+    UT_LOG_INFO ("%a\n", mCodecs[CodecIndex].Name);
+    Section = BuildGuidedSection (mCodecs[CodecIndex].Guid, mCodecs[CodecIndex].Data, mCodecs[CodecIndex].DataSize);
+    UT_ASSERT_NOT_NULL (Section);
+
+    for (Index = 0; Index < ARRAY_SIZE (mStreamChunkSizes); Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (DecodeGuidedSectionStream (Section, mCodecs[CodecIndex].DataSize, mStreamChunkSizes[Index], FALSE, &Output, &OutputSize, &WindowSize));
+      UT_ASSERT_EQUAL (OutputSize, TEST_DATA_SIZE);
+      UT_ASSERT_MEM_EQUAL (Output, Expected, TEST_DATA_SIZE);
+      FreePool (Output);
+
+      UT_ASSERT_TRUE (RETURN_ERROR (DecodeGuidedSectionStream (Section, mCodecs[CodecIndex].DataSize / 2, mStreamChunkSizes[Index], FALSE, &Output, &OutputSize, &WindowSize)));
+    }
+
+    FreePool (Section);
+  }
+
+  FreePool (Expected);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes the section data of every codec of mCodecs that has a stream decode
+  handler straight into an output buffer, in parts of each size of
+  mStreamChunkSizes, with only the scratch buffer of the regular handler as the
+  work buffer, and decodes the first half of it, which must fail.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The stream decode handlers decoded the data into
+                                       the output buffer and rejected the truncated data.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A stream decode handler did not decode the data, or
+                                       needed more than the window buffer as scratch buffer.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamDecodeIntoOutputShouldMatchData (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8                                           *Expected;
+  UINTN                                           CodecIndex;
+  UINTN                                           Index;
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler;
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler;
+  VOID                                            *Section;
+  UINT8                                           *Output;
+  UINT32                                          OutputSize;
+  UINT32                                          ScratchSize;
+  UINT32                                          WindowSize;
+  UINT16                                          Attributes;
+
+  Expected = AllocatePool (TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Expected);
+  GenerateTestData (Expected);
+
+  for (CodecIndex = 0; CodecIndex < ARRAY_SIZE (mCodecs); CodecIndex++) {
+    if ((mCodecs[CodecIndex].Data == NULL) ||
+        RETURN_ERROR (ExtractGuidedSectionGetStreamHandler (mCodecs[CodecIndex].Guid, &StreamGetInfoHandler, &StreamDecodeHandler)))
+    {
+      continue;
+    }
+
+    UT_LOG_INFO ("%a\n", mCodecs[CodecIndex].Name);
+    Section = BuildGuidedSection (mCodecs[CodecIndex].Guid, mCodecs[CodecIndex].Data, mCodecs[CodecIndex].DataSize);
+    UT_ASSERT_NOT_NULL (Section);
+    UT_ASSERT_NOT_EFI_ERROR (StreamGetInfoHandler (Section, &OutputSize, &WindowSize, &Attributes));
+
+    for (Index = 0; Index < ARRAY_SIZE (mStreamChunkSizes); Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (DecodeGuidedSectionStream (Section, mCodecs[CodecIndex].DataSize, mStreamChunkSizes[Index], TRUE, &Output, &OutputSize, &ScratchSize));
+      UT_ASSERT_EQUAL (OutputSize, TEST_DATA_SIZE);
+      UT_ASSERT_TRUE (ScratchSize <= WindowSize);
+      UT_ASSERT_MEM_EQUAL (Output, Expected, TEST_DATA_SIZE);
+      FreePool (Output);
+
+      UT_ASSERT_TRUE (RETURN_ERROR (DecodeGuidedSectionStream (Section, mCodecs[CodecIndex].DataSize / 2, mStreamChunkSizes[Index], TRUE, &Output, &OutputSize, &ScratchSize)));
+    }
+
+    FreePool (Section);
+  }
+
+  FreePool (Expected);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decodes mLzmaData with the dictionary size in its properties set to 4KB,
+  which is what LzmaCompress -e d 12 produces for the data of
+  GenerateTestData(). The window buffer must be smaller than the data, so the
+  dictionary wraps around many times while the data is passed on.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The data was returned through the small window buffer.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The window buffer was not smaller than the data,
+                                       or the data was not returned.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamDecodeShouldWrapLzmaWindow (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8                                           *Expected;
+  UINT8                                           *Data;
+  UINTN                                           Index;
+  EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler;
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler;
+  VOID                                            *Section;
+  UINT8                                           *Output;
+  UINT32                                          OutputSize;
+  UINT32                                          WindowSize;
+
+  if (RETURN_ERROR (ExtractGuidedSectionGetStreamHandler (&gLzmaCustomDecompressGuid, &StreamGetInfoHandler, &StreamDecodeHandler))) {
+    return UNIT_TEST_SKIPPED;
+  }
+
+  Expected = AllocatePool (TEST_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Expected);
+  GenerateTestData (Expected);
+
+  Data = AllocateCopyPool (sizeof (mLzmaData), mLzmaData);
+  UT_ASSERT_NOT_NULL (Data);
+  WriteUnaligned32 ((UINT32 *)(Data + 1), SIZE_4KB);
+
+  Section = BuildGuidedSection (&gLzmaCustomDecompressGuid, Data, sizeof (mLzmaData));
+  UT_ASSERT_NOT_NULL (Section);
+
+  for (Index = 0; Index < ARRAY_SIZE (mStreamChunkSizes); Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (DecodeGuidedSectionStream (Section, sizeof (mLzmaData), mStreamChunkSizes[Index], FALSE, &Output, &OutputSize, &WindowSize));
+    UT_ASSERT_EQUAL (OutputSize, TEST_DATA_SIZE);
+    UT_ASSERT_TRUE (WindowSize < TEST_DATA_SIZE);
+    UT_ASSERT_MEM_EQUAL (Output, Expected, TEST_DATA_SIZE);
+    FreePool (Output);
+  }
+
+  FreePool (Section);
+  FreePool (Data);
+  FreePool (Expected);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reports the decode throughput of every codec on the FV images given on the
+  command line, read from the files the FV images were compressed to, see
+  the header of this file. Speed is not asserted since it depends on the
+  host. The codecs with a stream decode handler are also measured with the
+  section data read in parts of BENCHMARK_CHUNK_SIZE bytes and decoded
+  straight into the output buffer, as DxeIpl does.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The FV images decoded with every codec they were
+                                       compressed with.
+  @retval UNIT_TEST_SKIPPED            No FV image was given.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A codec did not decode an FV image, or an FV
+                                       image was not compressed with any codec.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DecodeThroughputBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN    ImageIndex;
+  UINTN    CodecIndex;
+  UINTN    MeasuredCount;
+  CHAR8    FileName[1024];
+  UINT8    *FvImage;
+  UINTN    FvImageSize;
+  UINT8    *Data;
+  UINTN    DataSize;
+  VOID     *Section;
+  UINT8    *Output;
+  UINT32   OutputSize;
+  UINT32   WindowSize;
+  UINTN    Iterations;
+  clock_t  Start;
+  clock_t  Elapsed;
+
+  if (mFvImageCount == 0) {
+    UT_LOG_WARNING ("No FV image given, run %a FvImage...\n", gEfiCallerBaseName);
+    return UNIT_TEST_SKIPPED;
+  }
+
+  for (ImageIndex = 0; ImageIndex < mFvImageCount; ImageIndex++) {
+    FvImage = ReadHostFile (mFvImages[ImageIndex], &FvImageSize);
+    UT_ASSERT_NOT_NULL (FvImage);
+
+    MeasuredCount = 0;
+    for (CodecIndex = 0; CodecIndex < ARRAY_SIZE (mCodecs); CodecIndex++) {
+      AsciiSPrint (FileName, sizeof (FileName), "%a.%a", mFvImages[ImageIndex], mCodecs[CodecIndex].Extension);
+      Data = ReadHostFile (FileName, &DataSize);
+      if (Data == NULL) {
+        UT_LOG_WARNING ("%a: %a is not measured, %a can not be read\n", mFvImages[ImageIndex], mCodecs[CodecIndex].Name, FileName);
+        continue;
+      }
+
+      Section = BuildGuidedSection (mCodecs[CodecIndex].Guid, Data, DataSize);
+      FreePool (Data);
+      UT_ASSERT_NOT_NULL (Section);
+
+      UT_ASSERT_NOT_EFI_ERROR (DecodeGuidedSection (Section, &Output, &OutputSize));
+      UT_ASSERT_EQUAL (OutputSize, FvImageSize);
+      UT_ASSERT_MEM_EQUAL (Output, FvImage, FvImageSize);
+      FreePool (Output);
+
+      Iterations = 0;
+      Start      = clock ();
+      do {
+        DecodeGuidedSection (Section, &Output, &OutputSize);
+        FreePool (Output);
+        Iterations++;
+        Elapsed = clock () - Start;
+      } while ((Elapsed < BENCHMARK_MIN_CLOCKS) || (Iterations < BENCHMARK_MIN_ITERATIONS));
+
+      UT_LOG_INFO (
+        "%a: %a %d -> %d bytes, %d MB/s\n",
+        mFvImages[ImageIndex],
+        mCodecs[CodecIndex].Name,
+        (INT32)FvImageSize,
+        (INT32)DataSize,
+        (INT32)DivU64x64Remainder ((UINT64)FvImageSize * Iterations * CLOCKS_PER_SEC, (UINT64)MAX (Elapsed, 1) * SIZE_1MB, NULL)
+        );
+
+      if (DecodeGuidedSectionStream (Section, DataSize, BENCHMARK_CHUNK_SIZE, TRUE, &Output, &OutputSize, &WindowSize) != RETURN_NOT_FOUND) {
+        UT_ASSERT_NOT_NULL (Output);
+        UT_ASSERT_EQUAL (OutputSize, FvImageSize);
+        UT_ASSERT_MEM_EQUAL (Output, FvImage, FvImageSize);
+        FreePool (Output);
+
+        Iterations = 0;
+        Start      = clock ();
+        do {
+          DecodeGuidedSectionStream (Section, DataSize, BENCHMARK_CHUNK_SIZE, TRUE, &Output, &OutputSize, &WindowSize);
+          FreePool (Output);
+          Iterations++;
+          Elapsed = clock () - Start;
+        } while ((Elapsed < BENCHMARK_MIN_CLOCKS) || (Iterations < BENCHMARK_MIN_ITERATIONS));
+
+        UT_LOG_INFO (
+          "%a: %a read in %d byte parts into the output with a %d byte scratch buffer, %d MB/s\n",
+          mFvImages[ImageIndex],
+          mCodecs[CodecIndex].Name,
+          (INT32)BENCHMARK_CHUNK_SIZE,
+          (INT32)WindowSize,
+          (INT32)DivU64x64Remainder ((UINT64)FvImageSize * Iterations * CLOCKS_PER_SEC, (UINT64)MAX (Elapsed, 1) * SIZE_1MB, NULL)
+          );
+      }
+
+      FreePool (Section);
+      MeasuredCount++;
+    }
+
+    FreePool (FvImage);
+    UT_ASSERT_NOT_EQUAL (MeasuredCount, 0);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  guided section decoders and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      DecodeTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&DecodeTests, Framework, "Guided Section Decode Tests", "Decode", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DecodeTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (DecodeTests, "Section data of every codec should decode", "Decode", SectionDataShouldDecode, NULL, NULL, NULL);
+  AddTestCase (DecodeTests, "Truncated Zstandard frames should fail", "ZstdTruncated", TruncatedZstdFramesShouldFail, NULL, NULL, NULL);
+  AddTestCase (DecodeTests, "Zstandard frames with a wrong checksum should fail", "ZstdChecksum", ZstdChecksumMismatchShouldFail, NULL, NULL, NULL);
+  AddTestCase (DecodeTests, "Stream decode should return the data", "Stream", StreamDecodeShouldMatchData, NULL, NULL, NULL);
+  AddTestCase (DecodeTests, "Stream decode into the output buffer should return the data", "StreamOutput", StreamDecodeIntoOutputShouldMatchData, NULL, NULL, NULL);
+  AddTestCase (DecodeTests, "Stream decode should wrap a small LZMA window", "StreamWindow", StreamDecodeShouldWrapLzmaWindow, NULL, NULL, NULL);
+  AddTestCase (DecodeTests, "Decode throughput of the codecs on FV images", "Benchmark", DecodeThroughputBenchmark, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments, the FV images to benchmark
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  mFvImages     = Argv + 1;
+  mFvImageCount = (UINTN)(Argc - 1);
+
+  ProcessLibraryConstructorList ();
+  UnitTestMain ();
+  return 0;
+}
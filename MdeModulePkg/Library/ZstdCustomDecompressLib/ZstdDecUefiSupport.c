@@ -0,0 +1,83 @@
+/** @file
+  Implements for functions declared in ZstdDecUefiSupport.h
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include <ZstdDecUefiSupport.h>
+
+/**
+  Copies a buffer for the Zstandard decoder.
+**/
+void *
+memcpy (
+  void        *Destination,
+  const void  *Source,
+  size_t      Length
+  )
+{
+  return CopyMem (Destination, Source, Length);
+}
+
+/**
+  Copies a possibly overlapping buffer for the Zstandard decoder.
+**/
+void *
+memmove (
+  void        *Destination,
+  const void  *Source,
+  size_t      Length
+  )
+{
+  return CopyMem (Destination, Source, Length);
+}
+
+/**
+  Fills a buffer for the Zstandard decoder.
+**/
+void *
+memset (
+  void    *Buffer,
+  int     Value,
+  size_t  Length
+  )
+{
+  return SetMem (Buffer, Length, (UINT8)Value);
+}
+
+/**
+  Dummy malloc function for compiler.
+**/
+VOID *
+ZstdDummyMalloc (
+  IN size_t  Size
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Dummy calloc function for compiler.
+**/
+VOID *
+ZstdDummyCalloc (
+  IN size_t  Count,
+  IN size_t  Size
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Dummy free function for compiler.
+**/
+VOID
+ZstdDummyFree (
+  IN VOID  *Ptr
+  )
+{
+  ASSERT (FALSE);
+}
@@ -0,0 +1,82 @@
+/** @file
+  Zstandard UEFI header file for definitions
+
+  Allows the Zstandard decoder to build under UEFI (edk2) build environment
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __ZSTD_DECOMPRESS_UEFI_SUP_H__
+#define __ZSTD_DECOMPRESS_UEFI_SUP_H__
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+
+#define malloc(Size)          ZstdDummyMalloc (Size)
+#define calloc(Count, Size)   ZstdDummyCalloc (Count, Size)
+#define free(Ptr)             ZstdDummyFree (Ptr)
+#define offsetof(Type, Field)  OFFSET_OF (Type, Field)
+
+#define INT_MAX   MAX_INT32
+#define UINT_MAX  MAX_UINT32
+#define CHAR_BIT  8
+#define SIZE_MAX  MAX_UINTN
+
+typedef INT8    int8_t;
+typedef INT16   int16_t;
+typedef INT32   int32_t;
+typedef INT64   int64_t;
+typedef UINT8   uint8_t;
+typedef UINT16  uint16_t;
+typedef UINT32  uint32_t;
+typedef UINT64  uint64_t;
+typedef INTN    intptr_t;
+typedef UINTN   uintptr_t;
+typedef INTN    ptrdiff_t;
+typedef UINTN   size_t;
+
+//
+// The decoder copies with the compiler builtins, which fall back to these
+// for sizes that are not known at compile time.
+//
+void *
+memcpy (
+  void        *Destination,
+  const void  *Source,
+  size_t      Length
+  );
+
+void *
+memmove (
+  void        *Destination,
+  const void  *Source,
+  size_t      Length
+  );
+
+void *
+memset (
+  void    *Buffer,
+  int     Value,
+  size_t  Length
+  );
+
+VOID *
+ZstdDummyMalloc (
+  IN size_t  Size
+  );
+
+VOID *
+ZstdDummyCalloc (
+  IN size_t  Count,
+  IN size_t  Size
+  );
+
+VOID
+ZstdDummyFree (
+  IN VOID  *Ptr
+  );
+
+#endif
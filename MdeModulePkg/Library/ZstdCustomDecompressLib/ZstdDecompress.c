@@ -0,0 +1,159 @@
+/** @file
+  Zstandard Decompress interfaces
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include "ZstdDecompressLibInternal.h"
+
+/**
+  Gets the size of the data of all the frames of a Zstandard compressed buffer.
+
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size of source buffer.
+  @param  Size        Receives the size of the uncompressed data.
+
+  @retval RETURN_SUCCESS            The size of the uncompressed data was returned.
+  @retval RETURN_INVALID_PARAMETER  The source data is empty or not Zstandard
+                                    frames, a frame does not carry its content
+                                    size or the uncompressed data does not fit
+                                    in 4GB.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdGetDecompressedSize (
+  IN  CONST VOID  *Source,
+  IN  UINTN       SourceSize,
+  OUT UINT32      *Size
+  )
+{
+  UINT64  DecompressedSize;
+
+  if (SourceSize == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // The frames must carry their content size, the destination buffer is
+  // allocated before any of them is decoded.
+  //
+  DecompressedSize = ZSTD_findDecompressedSize (Source, SourceSize);
+  if ((DecompressedSize == ZSTD_CONTENTSIZE_UNKNOWN) ||
+      (DecompressedSize == ZSTD_CONTENTSIZE_ERROR) ||
+      (DecompressedSize > MAX_UINT32))
+  {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  *Size = (UINT32)DecompressedSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Given a Zstandard compressed source buffer, this function retrieves the size of
+  the uncompressed buffer and the size of the scratch buffer required
+  to decompress the compressed source buffer.
+
+  The scratch buffer holds the decoder context, the frames are decoded
+  straight into the destination buffer.
+
+  @param  Source           The source buffer containing the compressed data.
+  @param  SourceSize       The size of source buffer.
+  @param  DestinationSize  The size of destination buffer.
+  @param  ScratchSize      The size of scratch buffer.
+
+  @retval RETURN_SUCCESS            The size of the uncompressed data was returned
+                                    in DestinationSize and the size of the scratch
+                                    buffer was returned in ScratchSize.
+  @retval RETURN_INVALID_PARAMETER  The source data is not Zstandard frames that
+                                    all carry their content size.
+
+**/
+RETURN_STATUS
+EFIAPI
+ZstdUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  RETURN_STATUS  Status;
+
+  ASSERT (Source != NULL);
+  ASSERT (DestinationSize != NULL);
+  ASSERT (ScratchSize != NULL);
+
+  Status = ZstdGetDecompressedSize (Source, SourceSize, DestinationSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *ScratchSize = (UINT32)ZSTD_estimateDCtxSize ();
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompresses Zstandard compressed source buffer.
+
+  Extracts decompressed data to its original form.
+  If the compressed source data specified by Source is successfully decompressed
+  into Destination, then RETURN_SUCCESS is returned. If the compressed source data
+  specified by Source is not in a valid compressed data format, a frame refers
+  to a dictionary or the checksum of a frame does not match its data, then
+  RETURN_INVALID_PARAMETER is returned.
+
+  @param  Source       The source buffer containing the compressed data.
+  @param  SourceSize   The size of source buffer.
+  @param  Destination  The destination buffer to store the decompressed data.
+  @param  Scratch      A temporary scratch buffer that is used to perform the
+                       decompression.
+
+  @retval RETURN_SUCCESS            Decompression completed successfully, and
+                                    the uncompressed buffer is returned in Destination.
+  @retval RETURN_INVALID_PARAMETER  The source buffer specified by Source is corrupted
+                                    (not in a valid compressed format).
+
+**/
+RETURN_STATUS
+EFIAPI
+ZstdUefiDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         DestinationSize;
+  ZSTD_DCtx      *DecoderContext;
+  size_t         Result;
+
+  ASSERT (Source != NULL);
+  ASSERT (Destination != NULL);
+  ASSERT (Scratch != NULL);
+
+  Status = ZstdGetDecompressedSize (Source, SourceSize, &DestinationSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  DecoderContext = ZSTD_initStaticDCtx (Scratch, ZSTD_estimateDCtxSize ());
+  if (DecoderContext == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Result = ZSTD_decompressDCtx (DecoderContext, Destination, DestinationSize, Source, SourceSize);
+  if (ZSTD_isError (Result)) {
+    DEBUG ((DEBUG_ERROR, "Zstandard decompression failed - %a\n", ZSTD_getErrorName (Result)));
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Result != DestinationSize) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
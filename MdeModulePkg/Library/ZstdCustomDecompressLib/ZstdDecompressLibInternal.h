@@ -0,0 +1,72 @@
+/** @file
+  Zstandard decompress internal header file.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __ZSTD_DECOMPRESS_INTERNAL_H__
+#define __ZSTD_DECOMPRESS_INTERNAL_H__
+
+#include <PiPei.h>
+#include <Guid/ZstdDecompress.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd/lib/zstd.h>
+
+/**
+  Given a Zstandard compressed source buffer, this function retrieves the size of
+  the uncompressed buffer and the size of the scratch buffer required
+  to decompress the compressed source buffer.
+
+  @param  Source           The source buffer containing the compressed data.
+  @param  SourceSize       The size of source buffer.
+  @param  DestinationSize  The size of destination buffer.
+  @param  ScratchSize      The size of scratch buffer.
+
+  @retval RETURN_SUCCESS            The size of the uncompressed data was returned
+                                    in DestinationSize and the size of the scratch
+                                    buffer was returned in ScratchSize.
+  @retval RETURN_INVALID_PARAMETER  The source data is not Zstandard frames that
+                                    all carry their content size.
+
+**/
+RETURN_STATUS
+EFIAPI
+ZstdUefiDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  );
+
+/**
+  Decompresses Zstandard compressed source buffer.
+
+  @param  Source       The source buffer containing the compressed data.
+  @param  SourceSize   The size of source buffer.
+  @param  Destination  The destination buffer to store the decompressed data.
+  @param  Scratch      A temporary scratch buffer that is used to perform the
+                       decompression.
+
+  @retval RETURN_SUCCESS            Decompression completed successfully, and
+                                    the uncompressed buffer is returned in Destination.
+  @retval RETURN_INVALID_PARAMETER  The source buffer specified by Source is corrupted
+                                    (not in a valid compressed format).
+
+**/
+RETURN_STATUS
+EFIAPI
+ZstdUefiDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  );
+
+#endif
@@ -0,0 +1,26 @@
+/** @file
+  Include file to support building the third-party zstd.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __ZSTD_STRING_H__
+#define __ZSTD_STRING_H__
+
+#include <ZstdDecUefiSupport.h>
+
+//
+// Only the zstd sources include this file, through zstd_deps.h. They define
+// these macros for their own use.
+//
+#undef BIT0
+#undef BIT1
+#undef BIT4
+#undef BIT5
+#undef BIT6
+#undef BIT7
+#undef RETURN_ERROR
+
+#endif
@@ -0,0 +1,375 @@
+/** @file
+  Host instance of the ExtractGuidedSection and ExtractGuidedSectionStream
+  Libraries.
+
+  The handlers are kept in fixed tables, there is no memory allocation and no
+  configuration table to install on the host.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
+#include <Library/ExtractGuidedSectionStreamLib.h>
+
+#define EXTRACT_HANDLER_TABLE_SIZE  0x10
+
+UINT32                                          mNumberOfExtractHandler = 0;
+GUID                                            mExtractHandlerGuidTable[EXTRACT_HANDLER_TABLE_SIZE];
+EXTRACT_GUIDED_SECTION_DECODE_HANDLER           mExtractDecodeHandlerTable[EXTRACT_HANDLER_TABLE_SIZE];
+EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER         mExtractGetInfoHandlerTable[EXTRACT_HANDLER_TABLE_SIZE];
+UINT32                                          mNumberOfStreamHandler = 0;
+GUID                                            mStreamHandlerGuidTable[EXTRACT_HANDLER_TABLE_SIZE];
+EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  mStreamGetInfoHandlerTable[EXTRACT_HANDLER_TABLE_SIZE];
+EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    mStreamDecodeHandlerTable[EXTRACT_HANDLER_TABLE_SIZE];
+
+/**
+  Finds the registered handlers of a GUIDed section type.
+
+  @param[in]  SectionGuid  The GUID of the GUIDed section type.
+
+  @return The index of the handlers in the tables, or mNumberOfExtractHandler
+          if no handler is registered for SectionGuid.
+
+**/
+STATIC
+UINT32
+FindExtractHandler (
+  IN CONST GUID  *SectionGuid
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < mNumberOfExtractHandler; Index++) {
+    if (CompareGuid (&mExtractHandlerGuidTable[Index], SectionGuid)) {
+      break;
+    }
+  }
+
+  return Index;
+}
+
+/**
+  Gets the GUID of a GUIDed section.
+
+  @param[in]  InputSection  A pointer to a GUIDed section of an FFS formatted file.
+
+  @return The section definition GUID of InputSection.
+
+**/
+STATIC
+CONST GUID *
+GetSectionDefinitionGuid (
+  IN CONST VOID  *InputSection
+  )
+{
+  if (IS_SECTION2 (InputSection)) {
+    return &(((EFI_GUID_DEFINED_SECTION2 *)InputSection)->SectionDefinitionGuid);
+  }
+
+  return &(((EFI_GUID_DEFINED_SECTION *)InputSection)->SectionDefinitionGuid);
+}
+
+/**
+  Retrieve the list GUIDs that have been registered through ExtractGuidedSectionRegisterHandlers().
+
+  @param[out]  ExtractHandlerGuidTable  A pointer to the array of GUIDs that have been registered through
+                                        ExtractGuidedSectionRegisterHandlers().
+
+  @return The number of the supported extract guided Handler.
+
+**/
+UINTN
+EFIAPI
+ExtractGuidedSectionGetGuidList (
+  OUT  GUID  **ExtractHandlerGuidTable
+  )
+{
+  ASSERT (ExtractHandlerGuidTable != NULL);
+
+  *ExtractHandlerGuidTable = mExtractHandlerGuidTable;
+  return mNumberOfExtractHandler;
+}
+
+/**
+  Registers handlers of type EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER and EXTRACT_GUIDED_SECTION_DECODE_HANDLER
+  for a specific GUID section type.
+
+  @param[in]  SectionGuid    A pointer to the GUID associated with the handlers
+                             of the GUIDed section type being registered.
+  @param[in]  GetInfoHandler The pointer to a function that examines a GUIDed section and returns the
+                             size of the decoded buffer and the size of an optional scratch buffer
+                             required to actually decode the data in a GUIDed section.
+  @param[in]  DecodeHandler  The pointer to a function that decodes a GUIDed section into a caller
+                             allocated output buffer.
+
+  @retval  RETURN_SUCCESS           The handlers were registered.
+  @retval  RETURN_OUT_OF_RESOURCES  The handler table is full.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterHandlers (
+  IN CONST  GUID                                     *SectionGuid,
+  IN        EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER  GetInfoHandler,
+  IN        EXTRACT_GUIDED_SECTION_DECODE_HANDLER    DecodeHandler
+  )
+{
+  UINT32  Index;
+
+  ASSERT (SectionGuid != NULL);
+  ASSERT (GetInfoHandler != NULL);
+  ASSERT (DecodeHandler != NULL);
+
+  Index = FindExtractHandler (SectionGuid);
+  if (Index == mNumberOfExtractHandler) {
+    if (mNumberOfExtractHandler >= EXTRACT_HANDLER_TABLE_SIZE) {
+      return RETURN_OUT_OF_RESOURCES;
+    }
+
+    CopyGuid (&mExtractHandlerGuidTable[Index], SectionGuid);
+    mNumberOfExtractHandler++;
+  }
+
+  mExtractDecodeHandlerTable[Index]  = DecodeHandler;
+  mExtractGetInfoHandlerTable[Index] = GetInfoHandler;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Retrieves a GUID from a GUIDed section and uses that GUID to select an associated handler of type
+  EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER that was registered with ExtractGuidedSectionRegisterHandlers().
+
+  @param[in]  InputSection       A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBufferSize   A pointer to the size, in bytes, of an output buffer required if the buffer
+                                 specified by InputSection were decoded.
+  @param[out] ScratchBufferSize  A pointer to the size, in bytes, required as scratch space if the buffer specified by
+                                 InputSection were decoded.
+  @param[out] SectionAttribute   A pointer to the attributes of the GUIDed section.
+
+  @retval  RETURN_SUCCESS      Successfully obtained the required information.
+  @retval  RETURN_UNSUPPORTED  No handler is registered for the GUID of InputSection.
+  @retval  Others              The return status from the handler.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionGetInfo (
+  IN  CONST VOID    *InputSection,
+  OUT       UINT32  *OutputBufferSize,
+  OUT       UINT32  *ScratchBufferSize,
+  OUT       UINT16  *SectionAttribute
+  )
+{
+  UINT32  Index;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBufferSize != NULL);
+  ASSERT (ScratchBufferSize != NULL);
+  ASSERT (SectionAttribute != NULL);
+
+  Index = FindExtractHandler (GetSectionDefinitionGuid (InputSection));
+  if (Index == mNumberOfExtractHandler) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  return mExtractGetInfoHandlerTable[Index](
+                                            InputSection,
+                                            OutputBufferSize,
+                                            ScratchBufferSize,
+                                            SectionAttribute
+                                            );
+}
+
+/**
+  Retrieves the GUID from a GUIDed section and uses that GUID to select an associated handler of type
+  EXTRACT_GUIDED_SECTION_DECODE_HANDLER that was registered with ExtractGuidedSectionRegisterHandlers().
+
+  @param[in]  InputSection   A pointer to a GUIDed section of an FFS formatted file.
+  @param[out] OutputBuffer   A pointer to a buffer that contains the result of a decode operation.
+  @param[in]  ScratchBuffer  A caller allocated buffer that may be required by this function as a scratch buffer to perform the decode operation.
+  @param[out] AuthenticationStatus
+                             A pointer to the authentication status of the decoded output buffer.
+
+  @retval  RETURN_SUCCESS      The buffer specified by InputSection was decoded.
+  @retval  RETURN_UNSUPPORTED  No handler is registered for the GUID of InputSection.
+  @retval  Others              The return status from the handler.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionDecode (
+  IN  CONST VOID    *InputSection,
+  OUT       VOID    **OutputBuffer,
+  IN        VOID    *ScratchBuffer         OPTIONAL,
+  OUT       UINT32  *AuthenticationStatus
+  )
+{
+  UINT32  Index;
+
+  ASSERT (InputSection != NULL);
+  ASSERT (OutputBuffer != NULL);
+  ASSERT (AuthenticationStatus != NULL);
+
+  Index = FindExtractHandler (GetSectionDefinitionGuid (InputSection));
+  if (Index == mNumberOfExtractHandler) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  return mExtractDecodeHandlerTable[Index](
+                                           InputSection,
+                                           OutputBuffer,
+                                           ScratchBuffer,
+                                           AuthenticationStatus
+                                           );
+}
+
+/**
+  Retrieves handlers of type EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER and
+  EXTRACT_GUIDED_SECTION_DECODE_HANDLER for a specific GUID section type.
+
+  @param[in]  SectionGuid    A pointer to the GUID associated with the handlers of the GUIDed
+                             section type being retrieved.
+  @param[out] GetInfoHandler Pointer to the registered get info handler. Optional.
+  @param[out] DecodeHandler  Pointer to the registered decode handler. Optional.
+
+  @retval  RETURN_SUCCESS     The handlers were retrieved.
+  @retval  RETURN_NOT_FOUND   No handlers have been registered with the specified GUID.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionGetHandlers (
+  IN CONST   GUID                                     *SectionGuid,
+  OUT        EXTRACT_GUIDED_SECTION_GET_INFO_HANDLER  *GetInfoHandler   OPTIONAL,
+  OUT        EXTRACT_GUIDED_SECTION_DECODE_HANDLER    *DecodeHandler    OPTIONAL
+  )
+{
+  UINT32  Index;
+
+  ASSERT (SectionGuid != NULL);
+
+  Index = FindExtractHandler (SectionGuid);
+  if (Index == mNumberOfExtractHandler) {
+    return RETURN_NOT_FOUND;
+  }
+
+  if (GetInfoHandler != NULL) {
+    *GetInfoHandler = mExtractGetInfoHandlerTable[Index];
+  }
+
+  if (DecodeHandler != NULL) {
+    *DecodeHandler = mExtractDecodeHandlerTable[Index];
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Finds the registered stream handlers of a GUIDed section type.
+
+  @param[in]  SectionGuid  The GUID of the GUIDed section type.
+
+  @return The index of the handlers in the tables, or mNumberOfStreamHandler
+          if no stream decode handler is registered for SectionGuid.
+
+**/
+STATIC
+UINT32
+FindStreamHandler (
+  IN CONST GUID  *SectionGuid
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < mNumberOfStreamHandler; Index++) {
+    if (CompareGuid (&mStreamHandlerGuidTable[Index], SectionGuid)) {
+      break;
+    }
+  }
+
+  return Index;
+}
+
+/**
+  Registers a handler of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and a handler
+  of type EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being registered.
+  @param[in]  StreamGetInfoHandler  The pointer to the stream get info handler.
+  @param[in]  StreamDecodeHandler   The pointer to the stream decode handler.
+
+  @retval  RETURN_SUCCESS           The handlers were registered.
+  @retval  RETURN_OUT_OF_RESOURCES  The handler table is full.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionRegisterStreamHandler (
+  IN CONST  GUID                                            *SectionGuid,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  StreamGetInfoHandler,
+  IN        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    StreamDecodeHandler
+  )
+{
+  UINT32  Index;
+
+  ASSERT (SectionGuid != NULL);
+  ASSERT (StreamGetInfoHandler != NULL);
+  ASSERT (StreamDecodeHandler != NULL);
+
+  Index = FindStreamHandler (SectionGuid);
+  if (Index == mNumberOfStreamHandler) {
+    if (mNumberOfStreamHandler >= EXTRACT_HANDLER_TABLE_SIZE) {
+      return RETURN_OUT_OF_RESOURCES;
+    }
+
+    CopyGuid (&mStreamHandlerGuidTable[Index], SectionGuid);
+    mNumberOfStreamHandler++;
+  }
+
+  mStreamGetInfoHandlerTable[Index] = StreamGetInfoHandler;
+  mStreamDecodeHandlerTable[Index]  = StreamDecodeHandler;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Retrieves the handlers of type EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER and
+  EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER for a specific GUID section type.
+
+  @param[in]  SectionGuid           A pointer to the GUID associated with the handlers
+                                    of the GUIDed section type being retrieved.
+  @param[out] StreamGetInfoHandler  Pointer to the registered stream get info handler.
+  @param[out] StreamDecodeHandler   Pointer to the registered stream decode handler.
+
+  @retval  RETURN_SUCCESS     The handlers were retrieved.
+  @retval  RETURN_NOT_FOUND   No stream decode handler has been registered with the specified GUID.
+
+**/
+RETURN_STATUS
+EFIAPI
+ExtractGuidedSectionGetStreamHandler (
+  IN CONST   GUID                                            *SectionGuid,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_GET_INFO_HANDLER  *StreamGetInfoHandler,
+  OUT        EXTRACT_GUIDED_SECTION_STREAM_DECODE_HANDLER    *StreamDecodeHandler
+  )
+{
+  UINT32  Index;
+
+  ASSERT (SectionGuid != NULL);
+  ASSERT (StreamGetInfoHandler != NULL);
+  ASSERT (StreamDecodeHandler != NULL);
+
+  Index = FindStreamHandler (SectionGuid);
+  if (Index == mNumberOfStreamHandler) {
+    return RETURN_NOT_FOUND;
+  }
+
+  *StreamGetInfoHandler = mStreamGetInfoHandlerTable[Index];
+  *StreamDecodeHandler  = mStreamDecodeHandlerTable[Index];
+  return RETURN_SUCCESS;
+}
@@ -331,6 +331,10 @@ FtwWrite (
   UINT8                               *MyBuffer;
   UINTN                               SpareBufferSize;
   UINT8                               *SpareBuffer;
+  BOOLEAN                             *EraseList;
+  UINTN                               NumberOfSpareWriteBlocks;
+  UINTN                               StaleSpareBlocks;
+  BOOLEAN                             FullSpare;
   UINTN                               Index;
   UINT8                               *Ptr;
   EFI_PHYSICAL_ADDRESS                FvbPhysicalAddress;
@@ -429,14 +433,30 @@ FtwWrite (
   //
   // Set BootBlockUpdate FLAG if it's updating boot block.
   //
+  FullSpare = FALSE;
   if (IsBootBlock (FtwDevice, Fvb)) {
     Record->BootBlockUpdate = FTW_VALID_STATE;
+    FullSpare               = TRUE;
     //
     // Boot Block and Spare Block should have same block size and block numbers.
     //
     ASSERT ((BlockSize == FtwDevice->SpareBlockSize) && (NumberOfWriteBlocks == FtwDevice->NumberOfSpareBlock));
   }
 
+  //
+  // The working block and the boot block are updated with the whole spare area,
+  // other targets only with the spare blocks that receive the data.
+  //
+  if (IsWorkingBlock (FtwDevice, Fvb, Lba)) {
+    FullSpare = TRUE;
+  }
+
+  if (FullSpare) {
+    NumberOfSpareWriteBlocks = FtwDevice->NumberOfSpareBlock;
+  } else {
+    NumberOfSpareWriteBlocks = FTW_BLOCKS (WriteLength, FtwDevice->SpareBlockSize);
+  }
+
   //
   // Write the record to the work space.
   //
@@ -498,17 +518,19 @@ FtwWrite (
 
   //
   // Try to keep the content of spare block
-  // Save spare block into a spare backup memory buffer (Sparebuffer)
+  // Save the used spare blocks into a spare backup memory buffer (Sparebuffer)
   //
-  SpareBufferSize = FtwDevice->SpareAreaLength;
-  SpareBuffer     = AllocatePool (SpareBufferSize);
+  SpareBufferSize = NumberOfSpareWriteBlocks * FtwDevice->SpareBlockSize;
+  SpareBuffer     = AllocatePool (SpareBufferSize + NumberOfSpareWriteBlocks * sizeof (BOOLEAN));
   if (SpareBuffer == NULL) {
     FreePool (MyBuffer);
     return EFI_OUT_OF_RESOURCES;
   }
 
+  EraseList = (BOOLEAN *)(SpareBuffer + SpareBufferSize);
+
   Ptr = SpareBuffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
+  for (Index = 0; Index < NumberOfSpareWriteBlocks; Index += 1) {
     MyLength = FtwDevice->SpareBlockSize;
     Status   = FtwDevice->FtwBackupFvb->Read (
                                           FtwDevice->FtwBackupFvb,
@@ -523,14 +545,20 @@ FtwWrite (
       return EFI_ABORTED;
     }
 
-    Ptr += MyLength;
+    //
+    // A spare block that is already erased does not need another erase cycle.
+    //
+    EraseList[Index] = !IsErasedFlashBuffer (Ptr, MyLength);
+    Ptr             += MyLength;
   }
 
   //
   // Write the memory buffer to spare block
   // Do not assume Spare Block and Target Block have same block size
   //
-  Status = FtwEraseSpareBlock (FtwDevice);
+  StaleSpareBlocks            = FtwDevice->StaleSpareBlocks;
+  FtwDevice->StaleSpareBlocks = 0;
+  Status                      = FtwEraseSpareBlockList (FtwDevice, EraseList, NumberOfSpareWriteBlocks);
   if (EFI_ERROR (Status)) {
     FreePool (MyBuffer);
     FreePool (SpareBuffer);
@@ -597,31 +625,61 @@ FtwWrite (
 
   //
   // Restore spare backup buffer into spare block , if no failure happened during FtwWrite.
-  //
-  Status = FtwEraseSpareBlock (FtwDevice);
+  // After an update of the working block or the boot block, the whole spare area is
+  // restored. Otherwise, a spare block is only restored if it held data other than
+  // the data of a completed write. The other blocks are left as they are and only
+  // erased when the next write needs them, which saves one erase cycle per block.
+  //
+  for (Index = 0; Index < NumberOfSpareWriteBlocks; Index += 1) {
+    if (FullSpare) {
+      EraseList[Index] = TRUE;
+    } else {
+      EraseList[Index] = (BOOLEAN)((Index >= StaleSpareBlocks) &&
+                                   !IsErasedFlashBuffer (SpareBuffer + Index * FtwDevice->SpareBlockSize, FtwDevice->SpareBlockSize));
+    }
+  }
+
+  Status = FtwEraseSpareBlockList (FtwDevice, EraseList, NumberOfSpareWriteBlocks);
   if (EFI_ERROR (Status)) {
     FreePool (SpareBuffer);
     return EFI_ABORTED;
   }
 
   Ptr = SpareBuffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
+  for (Index = 0; Index < NumberOfSpareWriteBlocks; Index += 1) {
     MyLength = FtwDevice->SpareBlockSize;
-    Status   = FtwDevice->FtwBackupFvb->Write (
+    if (EraseList[Index] && !IsErasedFlashBuffer (Ptr, MyLength)) {
+      Status = FtwDevice->FtwBackupFvb->Write (
                                           FtwDevice->FtwBackupFvb,
                                           FtwDevice->FtwSpareLba + Index,
                                           0,
                                           &MyLength,
                                           Ptr
                                           );
-    if (EFI_ERROR (Status)) {
-      FreePool (SpareBuffer);
-      return EFI_ABORTED;
+      if (EFI_ERROR (Status)) {
+        FreePool (SpareBuffer);
+        return EFI_ABORTED;
+      }
     }
 
     Ptr += MyLength;
   }
 
+  //
+  // The leading spare blocks that were not restored hold the data of this write.
+  //
+  if (!FullSpare) {
+    StaleSpareBlocks = MAX (StaleSpareBlocks, NumberOfSpareWriteBlocks);
+    for (Index = 0; Index < NumberOfSpareWriteBlocks; Index += 1) {
+      if (EraseList[Index]) {
+        StaleSpareBlocks = Index;
+        break;
+      }
+    }
+  }
+
+  FtwDevice->StaleSpareBlocks = StaleSpareBlocks;
+
   //
   // All success.
   //
@@ -78,6 +78,10 @@ typedef struct {
   EFI_LBA                                    FtwWorkSpaceLbaInSpare;  // Start LBA of working space in spare block.
   UINTN                                      FtwWorkSpaceBaseInSpare; // Offset into the FtwWorkSpaceLbaInSpare block.
   UINT8                                      *FtwWorkSpace;           // Point to Work Space in memory buffer
+  UINTN                                      StaleSpareBlocks;        // Number of leading spare blocks only holding data of completed writes.
+  UINTN                                      SpareEraseCount;         // Number of spare blocks erased.
+  UINTN                                      SpareEraseSkipCount;     // Number of spare block erases skipped because the block was erased.
+  UINTN                                      BlockEraseCount;         // Number of working and target blocks erased.
   //
   // Following a buffer of FtwWorkSpace[FTW_WORK_SPACE_SIZE],
   // Allocated with EFI_FTW_DEVICE.
@@ -295,6 +299,36 @@ FtwEraseSpareBlock (
   IN EFI_FTW_DEVICE  *FtwDevice
   );
 
+/**
+  Erase the spare blocks selected by a list. Consecutive selected blocks are
+  erased by a single request.
+
+  @param FtwDevice        The private data of FTW driver
+  @param EraseList        EraseList[Index] is TRUE if the spare block Index is erased.
+  @param NumberOfBlocks   The number of entries in EraseList
+
+  @retval EFI_SUCCESS           The erase request was successfully completed.
+  @retval Others                An error occurred, some blocks may have been erased.
+
+**/
+EFI_STATUS
+FtwEraseSpareBlockList (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN BOOLEAN         *EraseList,
+  IN UINTN           NumberOfBlocks
+  );
+
+/**
+  Report the flash erases done by FTW so far in this boot.
+
+  @param FtwDevice        The private data of FTW driver
+
+**/
+VOID
+FtwLogEraseStatistics (
+  IN EFI_FTW_DEVICE  *FtwDevice
+  );
+
 /**
   Retrieve the proper FVB protocol interface by HANDLE.
 
@@ -25,6 +25,10 @@
   Then copy the write buffer data into the spare memory buffer.
   Then write the spare memory buffer into the spare block.
   Final copy the data from the spare block to the target block.
+  Unless the working block or the boot block is updated, only the spare blocks
+  receiving the write buffer are used. Spare blocks that are already erased are
+  not erased again, and spare blocks only holding the data of completed writes
+  are not restored, so they are erased once per write instead of twice.
 
   To make this drive work well, the following conditions must be satisfied:
   1. The write NumBytes data must be fit within Spare area.
@@ -198,6 +202,30 @@ FvbNotificationEvent (
   return;
 }
 
+/**
+  Notification function of EVT_GROUP_READY_TO_BOOT event group.
+
+  Reports the flash erases done by FTW before the OS boots.
+
+  @param[in] Event    Event whose notification function is being invoked.
+  @param[in] Context  Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+FtwOnReadyToBoot (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  FtwLogEraseStatistics ((EFI_FTW_DEVICE *)Context);
+
+  //
+  // ReadyToBoot may be signaled again when a boot option returns.
+  //
+  gBS->CloseEvent (Event);
+}
+
 /**
   This function is the entry point of the Fault Tolerant Write driver.
 
@@ -218,6 +246,7 @@ FaultTolerantWriteInitialize (
 {
   EFI_STATUS      Status;
   EFI_FTW_DEVICE  *FtwDevice;
+  EFI_EVENT       ReadyToBootEvent;
 
   FtwDevice = NULL;
 
@@ -240,6 +269,14 @@ FaultTolerantWriteInitialize (
     &mFvbRegistration
     );
 
+  Status = EfiCreateEventReadyToBootEx (
+             TPL_CALLBACK,
+             FtwOnReadyToBoot,
+             (VOID *)FtwDevice,
+             &ReadyToBootEvent
+             );
+  ASSERT_EFI_ERROR (Status);
+
   return EFI_SUCCESS;
 }
 
@@ -25,6 +25,10 @@
   Then copy the write buffer data into the spare memory buffer.
   Then write the spare memory buffer into the spare block.
   Final copy the data from the spare block to the target block.
+  Unless the working block or the boot block is updated, only the spare blocks
+  receiving the write buffer are used. Spare blocks that are already erased are
+  not erased again, and spare blocks only holding the data of completed writes
+  are not restored, so they are erased once per write instead of twice.
 
   To make this drive work well, the following conditions must be satisfied:
   1. The write NumBytes data must be fit within Spare area.
@@ -55,6 +59,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "FaultTolerantWrite.h"
 #include "FaultTolerantWriteSmmCommon.h"
 #include <Protocol/MmEndOfDxe.h>
+#include <Guid/EventGroup.h>
 
 VOID            *mFvbRegistration = NULL;
 EFI_FTW_DEVICE  *mFtwDevice       = NULL;
@@ -600,6 +605,44 @@ MmEndOfDxeCallback (
   return EFI_SUCCESS;
 }
 
+/**
+  MMI handler for the ReadyToBoot event, which the MM core raises when the
+  event group is signaled in DXE.
+
+  Reports the flash erases done by FTW before the OS boots.
+
+  @param[in]     DispatchHandle  The unique handle assigned to this handler by MmiHandlerRegister().
+  @param[in]     Context         Points to an optional handler context which was specified when the
+                                 handler was registered.
+  @param[in,out] CommBuffer      A pointer to a collection of data in memory that will
+                                 be conveyed from a non-MM environment into an MM environment.
+  @param[in,out] CommBufferSize  The size of the CommBuffer.
+
+  @retval EFI_SUCCESS            The handler ran successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+MmReadyToBootHandler (
+  IN     EFI_HANDLE  DispatchHandle,
+  IN     CONST VOID  *Context        OPTIONAL,
+  IN OUT VOID        *CommBuffer     OPTIONAL,
+  IN OUT UINTN       *CommBufferSize OPTIONAL
+  )
+{
+  STATIC BOOLEAN  mInReadyToBoot = FALSE;
+
+  //
+  // ReadyToBoot may be signaled again when a boot option returns.
+  //
+  if (!mInReadyToBoot) {
+    FtwLogEraseStatistics (mFtwDevice);
+  }
+
+  mInReadyToBoot = TRUE;
+  return EFI_SUCCESS;
+}
+
 /**
   Shared entry point of the module
 
@@ -614,6 +657,7 @@ MmFaultTolerantWriteInitialize (
 {
   EFI_STATUS  Status;
   VOID        *MmEndOfDxeRegistration;
+  EFI_HANDLE  MmReadyToBootHandle;
 
   //
   // Allocate private data structure for SMM FTW protocol and do some initialization
@@ -633,6 +677,16 @@ MmFaultTolerantWriteInitialize (
                     );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Register the ReadyToBoot handler to report the erases once per boot.
+  //
+  Status = gMmst->MmiHandlerRegister (
+                    MmReadyToBootHandler,
+                    &gEfiEventReadyToBootGuid,
+                    &MmReadyToBootHandle
+                    );
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Register FvbNotificationEvent () notify function.
   //
@@ -62,6 +62,7 @@ FtwEraseBlock (
   UINTN                               NumberOfBlocks
   )
 {
+  FtwDevice->BlockEraseCount += NumberOfBlocks;
   return FvBlock->EraseBlocks (
                     FvBlock,
                     Lba,
@@ -92,6 +93,11 @@ FtwEraseSpareBlock (
   IN EFI_FTW_DEVICE  *FtwDevice
   )
 {
+  //
+  // The caller either leaves the spare area erased or writes new content to it.
+  //
+  FtwDevice->StaleSpareBlocks = 0;
+  FtwDevice->SpareEraseCount += FtwDevice->NumberOfSpareBlock;
   return FtwDevice->FtwBackupFvb->EraseBlocks (
                                     FtwDevice->FtwBackupFvb,
                                     FtwDevice->FtwSpareLba,
@@ -100,6 +106,77 @@ FtwEraseSpareBlock (
                                     );
 }
 
+/**
+  Erase the spare blocks selected by a list. Consecutive selected blocks are
+  erased by a single request.
+
+  @param FtwDevice        The private data of FTW driver
+  @param EraseList        EraseList[Index] is TRUE if the spare block Index is erased.
+  @param NumberOfBlocks   The number of entries in EraseList
+
+  @retval EFI_SUCCESS           The erase request was successfully completed.
+  @retval Others                An error occurred, some blocks may have been erased.
+
+**/
+EFI_STATUS
+FtwEraseSpareBlockList (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN BOOLEAN         *EraseList,
+  IN UINTN           NumberOfBlocks
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       EndIndex;
+
+  ASSERT (NumberOfBlocks <= FtwDevice->NumberOfSpareBlock);
+
+  for (Index = 0; Index < NumberOfBlocks; Index = EndIndex) {
+    EndIndex = Index + 1;
+    if (!EraseList[Index]) {
+      FtwDevice->SpareEraseSkipCount += 1;
+      continue;
+    }
+
+    while ((EndIndex < NumberOfBlocks) && EraseList[EndIndex]) {
+      EndIndex += 1;
+    }
+
+    FtwDevice->SpareEraseCount += EndIndex - Index;
+    Status                      = FtwDevice->FtwBackupFvb->EraseBlocks (
+                                                             FtwDevice->FtwBackupFvb,
+                                                             FtwDevice->FtwSpareLba + Index,
+                                                             EndIndex - Index,
+                                                             EFI_LBA_LIST_TERMINATOR
+                                                             );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Report the flash erases done by FTW so far in this boot.
+
+  @param FtwDevice        The private data of FTW driver
+
+**/
+VOID
+FtwLogEraseStatistics (
+  IN EFI_FTW_DEVICE  *FtwDevice
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "Ftw: Erase cycles, spare blocks: 0x%x (0x%x skipped), working and target blocks: 0x%x\n",
+    FtwDevice->SpareEraseCount,
+    FtwDevice->SpareEraseSkipCount,
+    FtwDevice->BlockEraseCount
+    ));
+}
+
 /**
 
   Is it in working block?
@@ -489,11 +566,17 @@ FlushSpareBlockToTargetBlock (
   UINTN       Count;
   UINT8       *Ptr;
   UINTN       Index;
+  UINTN       NumberOfSpareBlocks;
 
   if ((FtwDevice == NULL) || (FvBlock == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
+  NumberOfSpareBlocks = FTW_BLOCKS (NumberOfBlocks * BlockSize, FtwDevice->SpareBlockSize);
+  if (NumberOfSpareBlocks > FtwDevice->NumberOfSpareBlock) {
+    return EFI_INVALID_PARAMETER;
+  }
+
   //
   // Allocate a memory buffer
   //
@@ -504,10 +587,10 @@ FlushSpareBlockToTargetBlock (
   }
 
   //
-  // Read all content of spare block to memory buffer
+  // Read the spare blocks holding the content of the target blocks to memory buffer
   //
   Ptr = Buffer;
-  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
+  for (Index = 0; Index < NumberOfSpareBlocks; Index += 1) {
     Count  = FtwDevice->SpareBlockSize;
     Status = FtwDevice->FtwBackupFvb->Read (
                                         FtwDevice->FtwBackupFvb,
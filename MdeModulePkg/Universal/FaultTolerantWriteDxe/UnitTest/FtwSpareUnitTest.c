@@ -0,0 +1,769 @@
+/** @file
+  Host-based unit tests of the use of the spare area by FtwWrite(). The flash
+  is a buffer behind a mock FVB protocol that counts the erases and programs
+  of every block. Programming only clears bits, so a block that is written
+  without being erased first ends up with corrupted content.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../FaultTolerantWrite.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "FTW Spare Area Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// The flash holds the work space in LBA 0, the spare area in LBA 4 to 7 and
+// the blocks updated by the tests from LBA 8 on.
+//
+#define TEST_BLOCK_SIZE             SIZE_4KB
+#define TEST_NUMBER_OF_BLOCKS       16
+#define TEST_WORK_SPACE_LBA         0
+#define TEST_SPARE_LBA              4
+#define TEST_NUMBER_OF_SPARE_BLOCK  4
+#define TEST_TARGET_LBA             8
+#define TEST_FLASH_SIZE             (TEST_NUMBER_OF_BLOCKS * TEST_BLOCK_SIZE)
+
+/// === TEST DATA ==================================================================================
+
+UINT8                               *mFlash;
+UINTN                               mEraseCount[TEST_NUMBER_OF_BLOCKS];
+UINTN                               mProgramCount[TEST_NUMBER_OF_BLOCKS];
+UINTN                               mSpareEraseRequestCount;
+EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  mFvb;
+EFI_FTW_DEVICE                      *mFtwDevice;
+
+/// === STUBS ======================================================================================
+
+/**
+  Returns the attributes of the mock FV.
+
+  @param[in]  This        The FVB protocol.
+  @param[out] Attributes  The attributes of the FV.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbGetAttributes (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  OUT       EFI_FVB_ATTRIBUTES_2                 *Attributes
+  )
+{
+  *Attributes = EFI_FVB2_READ_STATUS | EFI_FVB2_WRITE_STATUS | EFI_FVB2_ERASE_POLARITY;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the base address of the mock FV.
+
+  @param[in]  This     The FVB protocol.
+  @param[out] Address  The base address of the FV.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbGetPhysicalAddress (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  OUT       EFI_PHYSICAL_ADDRESS                 *Address
+  )
+{
+  *Address = (EFI_PHYSICAL_ADDRESS)(UINTN)mFlash;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the size of the blocks of the mock FV.
+
+  @param[in]  This            The FVB protocol.
+  @param[in]  Lba             The block.
+  @param[out] BlockSize       The size of the block.
+  @param[out] NumberOfBlocks  The number of blocks from Lba on.
+
+  @retval EFI_SUCCESS            The block is in the FV.
+  @retval EFI_INVALID_PARAMETER  The block is past the end of the FV.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbGetBlockSize (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  IN        EFI_LBA                              Lba,
+  OUT       UINTN                                *BlockSize,
+  OUT       UINTN                                *NumberOfBlocks
+  )
+{
+  if (Lba >= TEST_NUMBER_OF_BLOCKS) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *BlockSize      = TEST_BLOCK_SIZE;
+  *NumberOfBlocks = TEST_NUMBER_OF_BLOCKS - (UINTN)Lba;
+  return EFI_SUCCESS;
+}
+
+/**
+  Reads from a block of the mock FV.
+
+  @param[in]      This      The FVB protocol.
+  @param[in]      Lba       The block.
+  @param[in]      Offset    The offset in the block.
+  @param[in, out] NumBytes  The number of bytes to read.
+  @param[out]     Buffer    The data read.
+
+  @retval EFI_SUCCESS            The data is read.
+  @retval EFI_INVALID_PARAMETER  The read is not within the block.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbRead (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  IN        EFI_LBA                              Lba,
+  IN        UINTN                                Offset,
+  IN OUT    UINTN                                *NumBytes,
+  OUT       UINT8                                *Buffer
+  )
+{
+  if ((Lba >= TEST_NUMBER_OF_BLOCKS) || (Offset + *NumBytes > TEST_BLOCK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CopyMem (Buffer, mFlash + (UINTN)Lba * TEST_BLOCK_SIZE + Offset, *NumBytes);
+  return EFI_SUCCESS;
+}
+
+/**
+  Programs a block of the mock FV. Like a flash, programming only clears bits.
+
+  @param[in]      This      The FVB protocol.
+  @param[in]      Lba       The block.
+  @param[in]      Offset    The offset in the block.
+  @param[in, out] NumBytes  The number of bytes to write.
+  @param[in]      Buffer    The data to write.
+
+  @retval EFI_SUCCESS            The data is written.
+  @retval EFI_INVALID_PARAMETER  The write is not within the block.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbWrite (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  IN        EFI_LBA                              Lba,
+  IN        UINTN                                Offset,
+  IN OUT    UINTN                                *NumBytes,
+  IN        UINT8                                *Buffer
+  )
+{
+  UINT8  *Ptr;
+  UINTN  Index;
+
+  if ((Lba >= TEST_NUMBER_OF_BLOCKS) || (Offset + *NumBytes > TEST_BLOCK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Ptr = mFlash + (UINTN)Lba * TEST_BLOCK_SIZE + Offset;
+  for (Index = 0; Index < *NumBytes; Index++) {
+    Ptr[Index] &= Buffer[Index];
+  }
+
+  mProgramCount[Lba]++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Erases runs of blocks of the mock FV.
+
+  @param[in] This  The FVB protocol.
+  @param[in] ...   Pairs of start LBA and number of blocks, ended by
+                   EFI_LBA_LIST_TERMINATOR.
+
+  @retval EFI_SUCCESS            The blocks are erased.
+  @retval EFI_INVALID_PARAMETER  A run is not within the FV.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbEraseBlocks (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  ...
+  )
+{
+  VA_LIST  Args;
+  EFI_LBA  Lba;
+  UINTN    NumberOfBlocks;
+  UINTN    Index;
+
+  VA_START (Args, This);
+  for (Lba = VA_ARG (Args, EFI_LBA); Lba != EFI_LBA_LIST_TERMINATOR; Lba = VA_ARG (Args, EFI_LBA)) {
+    NumberOfBlocks = VA_ARG (Args, UINTN);
+    if ((NumberOfBlocks == 0) || (Lba + NumberOfBlocks > TEST_NUMBER_OF_BLOCKS)) {
+      VA_END (Args);
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if ((Lba >= TEST_SPARE_LBA) && (Lba < TEST_SPARE_LBA + TEST_NUMBER_OF_SPARE_BLOCK)) {
+      mSpareEraseRequestCount++;
+    }
+
+    SetMem (mFlash + (UINTN)Lba * TEST_BLOCK_SIZE, NumberOfBlocks * TEST_BLOCK_SIZE, FTW_ERASED_BYTE);
+    for (Index = 0; Index < NumberOfBlocks; Index++) {
+      mEraseCount[Lba + Index]++;
+    }
+  }
+
+  VA_END (Args);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the VariableFlashInfoLib GetVariableFlashFtwSpareInfo().
+
+  @param[out] BaseAddress  The base address of the spare area.
+  @param[out] Length       The length of the spare area.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+GetVariableFlashFtwSpareInfo (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  *BaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)(mFlash + TEST_SPARE_LBA * TEST_BLOCK_SIZE);
+  *Length      = TEST_NUMBER_OF_SPARE_BLOCK * TEST_BLOCK_SIZE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the VariableFlashInfoLib GetVariableFlashFtwWorkingInfo().
+
+  @param[out] BaseAddress  The base address of the work space.
+  @param[out] Length       The length of the work space.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+GetVariableFlashFtwWorkingInfo (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  *BaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)(mFlash + TEST_WORK_SPACE_LBA * TEST_BLOCK_SIZE);
+  *Length      = TEST_BLOCK_SIZE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the driver FtwGetFvbByHandle(). The handle of the mock FVB is its
+  address.
+
+  @param[in]  FvBlockHandle  The handle.
+  @param[out] FvBlock        The FVB protocol.
+
+  @retval EFI_SUCCESS      FvBlockHandle is the handle of the mock FVB.
+  @retval EFI_UNSUPPORTED  FvBlockHandle is another handle.
+
+**/
+EFI_STATUS
+FtwGetFvbByHandle (
+  IN  EFI_HANDLE                          FvBlockHandle,
+  OUT EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  **FvBlock
+  )
+{
+  if (FvBlockHandle != (EFI_HANDLE)&mFvb) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *FvBlock = &mFvb;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the driver FtwGetSarProtocol(). There is no boot block to swap.
+
+  @param[out] SarProtocol  Unused.
+
+  @retval EFI_NOT_FOUND  Always.
+
+**/
+EFI_STATUS
+FtwGetSarProtocol (
+  OUT VOID  **SarProtocol
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of the driver GetFvbCountAndBuffer(). The only FVB is the mock FVB.
+
+  @param[out] NumberHandles  The number of handles.
+  @param[out] Buffer         The handles.
+
+  @retval EFI_SUCCESS           The handle is returned.
+  @retval EFI_OUT_OF_RESOURCES  Out of memory.
+
+**/
+EFI_STATUS
+GetFvbCountAndBuffer (
+  OUT UINTN       *NumberHandles,
+  OUT EFI_HANDLE  **Buffer
+  )
+{
+  *Buffer = AllocatePool (sizeof (EFI_HANDLE));
+  if (*Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  (*Buffer)[0]   = (EFI_HANDLE)&mFvb;
+  *NumberHandles = 1;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the driver FtwCalculateCrc32().
+
+  @param[in] Buffer  The data.
+  @param[in] Length  The size of the data.
+
+  @return The CRC32 of the data.
+
+**/
+UINT32
+FtwCalculateCrc32 (
+  IN  VOID   *Buffer,
+  IN  UINTN  Length
+  )
+{
+  return CalculateCrc32 (Buffer, Length);
+}
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Brings up the FTW device on the flash, as the driver does at boot, and
+  clears the erase and program counts.
+
+  @retval EFI_SUCCESS  The FTW device is ready.
+  @retval Others       The FTW device could not be initialized.
+
+**/
+EFI_STATUS
+StartFtwDevice (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = InitFtwDevice (&mFtwDevice);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = InitFtwProtocol (mFtwDevice);
+  if (EFI_ERROR (Status)) {
+    FreePool (mFtwDevice);
+    mFtwDevice = NULL;
+    return Status;
+  }
+
+  //
+  // Only count the erases of the tests, not those of the work space set up.
+  //
+  ZeroMem (mEraseCount, sizeof (mEraseCount));
+  ZeroMem (mProgramCount, sizeof (mProgramCount));
+  mSpareEraseRequestCount         = 0;
+  mFtwDevice->SpareEraseCount     = 0;
+  mFtwDevice->SpareEraseSkipCount = 0;
+  mFtwDevice->BlockEraseCount     = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Updates blocks through the FTW protocol with a byte pattern, and checks the
+  blocks hold the pattern afterwards.
+
+  @param[in] Lba      The first block to update.
+  @param[in] Offset   The offset in the first block.
+  @param[in] Length   The number of bytes to update.
+  @param[in] Pattern  The byte written.
+
+  @retval TRUE   The update succeeded.
+  @retval FALSE  The update failed or the blocks do not hold the pattern.
+
+**/
+BOOLEAN
+FtwWritePattern (
+  IN EFI_LBA  Lba,
+  IN UINTN    Offset,
+  IN UINTN    Length,
+  IN UINT8    Pattern
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Buffer;
+  UINT8       *Target;
+  UINTN       Index;
+
+  Buffer = AllocatePool (Length);
+  if (Buffer == NULL) {
+    return FALSE;
+  }
+
+  SetMem (Buffer, Length, Pattern);
+  Status = mFtwDevice->FtwInstance.Write (&mFtwDevice->FtwInstance, Lba, Offset, Length, NULL, (EFI_HANDLE)&mFvb, Buffer);
+  FreePool (Buffer);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  Target = mFlash + (UINTN)Lba * TEST_BLOCK_SIZE + Offset;
+  for (Index = 0; Index < Length; Index++) {
+    if (Target[Index] != Pattern) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks that a spare block holds a byte pattern.
+
+  @param[in] Index    The spare block.
+  @param[in] Pattern  The byte expected.
+
+  @retval TRUE   The spare block holds the pattern.
+  @retval FALSE  The spare block holds other data.
+
+**/
+BOOLEAN
+IsSpareBlockPattern (
+  IN UINTN  Index,
+  IN UINT8  Pattern
+  )
+{
+  UINT8  *Block;
+  UINTN  Offset;
+
+  Block = mFlash + (TEST_SPARE_LBA + Index) * TEST_BLOCK_SIZE;
+  for (Offset = 0; Offset < TEST_BLOCK_SIZE; Offset++) {
+    if (Block[Offset] != Pattern) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Erases the flash and brings up the FTW device on it.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The FTW device is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The FTW device could not be initialized.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mFlash = AllocateAlignedPages (EFI_SIZE_TO_PAGES (TEST_FLASH_SIZE), TEST_BLOCK_SIZE);
+  if (mFlash == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  SetMem (mFlash, TEST_FLASH_SIZE, FTW_ERASED_BYTE);
+
+  ZeroMem (&mFvb, sizeof (mFvb));
+  mFvb.GetAttributes      = StubFvbGetAttributes;
+  mFvb.GetPhysicalAddress = StubFvbGetPhysicalAddress;
+  mFvb.GetBlockSize       = StubFvbGetBlockSize;
+  mFvb.Read               = StubFvbRead;
+  mFvb.Write              = StubFvbWrite;
+  mFvb.EraseBlocks        = StubFvbEraseBlocks;
+
+  if (EFI_ERROR (StartFtwDevice ())) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the FTW device and the flash.
+
+  @param[in] Context  Unused.
+
+**/
+VOID
+EFIAPI
+FtwCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mFtwDevice != NULL) {
+    FreePool (mFtwDevice);
+    mFtwDevice = NULL;
+  }
+
+  if (mFlash != NULL) {
+    FreeAlignedPages (mFlash, EFI_SIZE_TO_PAGES (TEST_FLASH_SIZE));
+    mFlash = NULL;
+  }
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  A write of two blocks must only use the first two spare blocks. As they are
+  erased, they must not be erased again, and after the write they must be left
+  holding its data.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The expected blocks were erased and written.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Other blocks were erased or written.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+WriteShouldOnlyUseTheSpareBlocksItNeeds (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_TRUE (FtwWritePattern (TEST_TARGET_LBA, 0x100, TEST_BLOCK_SIZE, 0x5A));
+
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA], 0);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 1], 0);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 2], 0);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 3], 0);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_SPARE_LBA], 1);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_SPARE_LBA + 1], 1);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_SPARE_LBA + 2], 0);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_SPARE_LBA + 3], 0);
+  UT_ASSERT_EQUAL (mSpareEraseRequestCount, 0);
+
+  UT_ASSERT_EQUAL (mEraseCount[TEST_TARGET_LBA], 1);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_TARGET_LBA + 1], 1);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_TARGET_LBA + 2], 0);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_TARGET_LBA], 1);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_TARGET_LBA + 1], 1);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_TARGET_LBA + 2], 0);
+
+  UT_ASSERT_EQUAL (mFtwDevice->SpareEraseCount, 0);
+  UT_ASSERT_EQUAL (mFtwDevice->SpareEraseSkipCount, 4);
+  UT_ASSERT_EQUAL (mFtwDevice->StaleSpareBlocks, 2);
+  UT_ASSERT_FALSE (IsSpareBlockPattern (0, FTW_ERASED_BYTE));
+  UT_ASSERT_TRUE (IsSpareBlockPattern (2, FTW_ERASED_BYTE));
+  UT_ASSERT_TRUE (IsSpareBlockPattern (3, FTW_ERASED_BYTE));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A spare block left holding the data of a completed write must be erased
+  once by the next write, and must not be restored after it.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The stale spare block was erased once per write.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The stale spare block was erased more often.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StaleSpareBlockShouldBeErasedOncePerWrite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < 5; Index++) {
+    UT_ASSERT_TRUE (FtwWritePattern (TEST_TARGET_LBA + Index, 0, TEST_BLOCK_SIZE, (UINT8)(0x10 + Index)));
+    UT_ASSERT_EQUAL (mFtwDevice->StaleSpareBlocks, 1);
+    UT_ASSERT_TRUE (IsSpareBlockPattern (0, (UINT8)(0x10 + Index)));
+  }
+
+  //
+  // The first write found the spare block erased.
+  //
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA], 4);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_SPARE_LBA], 5);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 1], 0);
+  UT_ASSERT_EQUAL (mProgramCount[TEST_SPARE_LBA + 1], 0);
+  UT_ASSERT_EQUAL (mFtwDevice->SpareEraseCount, 4);
+  UT_ASSERT_EQUAL (mFtwDevice->SpareEraseSkipCount, 6);
+
+  for (Index = 0; Index < 5; Index++) {
+    UT_ASSERT_EQUAL (mEraseCount[TEST_TARGET_LBA + Index], 1);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Spare blocks holding other data must be erased in one request per run of
+  blocks, and restored after the write.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The spare content was restored.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The spare content was lost or erased block by block.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SpareContentShouldBeRestored (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SetMem (mFlash + (TEST_SPARE_LBA + 1) * TEST_BLOCK_SIZE, 2 * TEST_BLOCK_SIZE, 0xC3);
+
+  UT_ASSERT_TRUE (FtwWritePattern (TEST_TARGET_LBA, 0, 3 * TEST_BLOCK_SIZE, 0x3C));
+
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA], 0);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 1], 2);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 2], 2);
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA + 3], 0);
+  UT_ASSERT_EQUAL (mSpareEraseRequestCount, 2);
+
+  UT_ASSERT_TRUE (IsSpareBlockPattern (0, 0x3C));
+  UT_ASSERT_TRUE (IsSpareBlockPattern (1, 0xC3));
+  UT_ASSERT_TRUE (IsSpareBlockPattern (2, 0xC3));
+  UT_ASSERT_TRUE (IsSpareBlockPattern (3, FTW_ERASED_BYTE));
+  UT_ASSERT_EQUAL (mFtwDevice->StaleSpareBlocks, 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  After a reset, the content of the spare area is not known to be stale, so
+  the next write must restore it.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The spare content was restored.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The spare content was lost.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SpareContentShouldBeRestoredAfterReset (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_TRUE (FtwWritePattern (TEST_TARGET_LBA, 0, TEST_BLOCK_SIZE, 0x11));
+  UT_ASSERT_EQUAL (mFtwDevice->StaleSpareBlocks, 1);
+
+  FreePool (mFtwDevice);
+  mFtwDevice = NULL;
+  UT_ASSERT_NOT_EFI_ERROR (StartFtwDevice ());
+  UT_ASSERT_EQUAL (mFtwDevice->StaleSpareBlocks, 0);
+
+  UT_ASSERT_TRUE (FtwWritePattern (TEST_TARGET_LBA + 1, 0, TEST_BLOCK_SIZE, 0x22));
+  UT_ASSERT_EQUAL (mEraseCount[TEST_SPARE_LBA], 2);
+  UT_ASSERT_TRUE (IsSpareBlockPattern (0, 0x11));
+  UT_ASSERT_EQUAL (mFtwDevice->StaleSpareBlocks, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the use of the
+  spare area by FtwWrite() and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SpareTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SpareTests, Framework, "FTW Spare Area Tests", "FtwSpare", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SpareTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (SpareTests, "A write should only use the spare blocks it needs", "PartialSpare", WriteShouldOnlyUseTheSpareBlocksItNeeds, FtwSetup, FtwCleanup, NULL);
+  AddTestCase (SpareTests, "A stale spare block should be erased once per write", "StaleSpare", StaleSpareBlockShouldBeErasedOncePerWrite, FtwSetup, FtwCleanup, NULL);
+  AddTestCase (SpareTests, "Spare content should be restored", "RestoreSpare", SpareContentShouldBeRestored, FtwSetup, FtwCleanup, NULL);
+  AddTestCase (SpareTests, "Spare content should be restored after a reset", "RestoreSpareAfterReset", SpareContentShouldBeRestoredAfterReset, FtwSetup, FtwCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define FtwSpareUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+FtwSpareUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -0,0 +1,271 @@
+/** @file
+  Lets the APs allocate and free pool through the boot services table.
+
+  The pool lists of the DXE Core are protected by a lock that raises the TPL
+  and therefore may only be taken by the BSP. Once the MP Services protocol is
+  installed, this driver reserves PcdMpPoolDxeSize bytes of EfiBootServicesData
+  memory, lets MpPoolLib manage it, and replaces the AllocatePool() and
+  FreePool() services of the boot services table. Calls made on the BSP are
+  passed to the previous services, calls made on an AP are served from the
+  magazine of that AP without taking any lock or raising the TPL.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiDxe.h>
+#include <Protocol/MpService.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MpPoolLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+STATIC EFI_MP_SERVICES_PROTOCOL  *mMpServices;
+STATIC MP_POOL                   *mMpPool;
+STATIC UINTN                     mBspNumber;
+STATIC UINTN                     mMpPoolBase;
+STATIC UINTN                     mMpPoolLimit;
+STATIC UINTN                     mBspStackBase;
+STATIC UINTN                     mBspStackLimit;
+STATIC EFI_ALLOCATE_POOL         mBootServicesAllocatePool;
+STATIC EFI_FREE_POOL             mBootServicesFreePool;
+
+/**
+  Returns the number of the calling processor.
+
+  The stack of the BSP is described by a memory allocation HOB and no AP ever
+  runs on it, so a caller whose stack lies in that range is the BSP and the
+  MP Services protocol only has to be asked on the APs.
+
+  @return The processor number of the caller, as returned by WhoAmI().
+
+**/
+STATIC
+UINTN
+GetProcessorNumber (
+  VOID
+  )
+{
+  UINTN       ProcessorNumber;
+  EFI_STATUS  Status;
+
+  ProcessorNumber = (UINTN)&ProcessorNumber;
+  if ((ProcessorNumber >= mBspStackBase) && (ProcessorNumber < mBspStackLimit)) {
+    return mBspNumber;
+  }
+
+  Status = mMpServices->WhoAmI (mMpServices, &ProcessorNumber);
+  if (EFI_ERROR (Status)) {
+    return mBspNumber;
+  }
+
+  return ProcessorNumber;
+}
+
+/**
+  Allocates pool from the pool lists of the DXE Core on the BSP, and from the
+  magazine of the caller on an AP.
+
+  Only EfiBootServicesData allocations of at most MP_POOL_MAX_ALLOCATION_SIZE
+  bytes can be served on an AP, other requests made on an AP fail.
+
+  @param  PoolType               Type of pool to allocate
+  @param  Size                   The amount of pool to allocate
+  @param  Buffer                 The address to return a pointer to the allocated
+                                 pool
+
+  @retval EFI_SUCCESS            Pool successfully allocated.
+  @retval EFI_INVALID_PARAMETER  Buffer is NULL, or PoolType is not valid.
+  @retval EFI_OUT_OF_RESOURCES   Size exceeds max pool size or allocation failed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MpPoolDxeAllocatePool (
+  IN  EFI_MEMORY_TYPE  PoolType,
+  IN  UINTN            Size,
+  OUT VOID             **Buffer
+  )
+{
+  UINTN  ProcessorNumber;
+
+  ProcessorNumber = GetProcessorNumber ();
+  if (ProcessorNumber == mBspNumber) {
+    return mBootServicesAllocatePool (PoolType, Size, Buffer);
+  }
+
+  if (Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Buffer = NULL;
+  if (PoolType == EfiBootServicesData) {
+    *Buffer = MpPoolAllocate (mMpPool, ProcessorNumber, Size);
+  }
+
+  return (*Buffer != NULL) ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+}
+
+/**
+  Frees pool. Blocks of the AP pool go back to the magazine of the caller,
+  other blocks to the pool lists of the DXE Core.
+
+  @param  Buffer                 The allocated pool entry to free
+
+  @retval EFI_INVALID_PARAMETER  Buffer is not a valid value, or an AP tries
+                                 to free a block of the pool lists.
+  @retval EFI_SUCCESS            Pool successfully freed.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MpPoolDxeFreePool (
+  IN VOID  *Buffer
+  )
+{
+  UINTN    ProcessorNumber;
+  EFI_TPL  OldTpl;
+
+  ProcessorNumber = GetProcessorNumber ();
+  if (((UINTN)Buffer < mMpPoolBase) || ((UINTN)Buffer >= mMpPoolLimit)) {
+    if (ProcessorNumber != mBspNumber) {
+      //
+      // The pool lists are only ever taken by the BSP
+      //
+      ASSERT (FALSE);
+      return EFI_INVALID_PARAMETER;
+    }
+
+    return mBootServicesFreePool (Buffer);
+  }
+
+  if (ProcessorNumber != mBspNumber) {
+    MpPoolFree (mMpPool, ProcessorNumber, Buffer);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // A notification function interrupting the BSP must not see its magazine
+  // half updated
+  //
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  MpPoolFree (mMpPool, ProcessorNumber, Buffer);
+  gBS->RestoreTPL (OldTpl);
+  return EFI_SUCCESS;
+}
+
+/**
+  Finds the stack of the BSP in the memory allocation HOBs.
+
+**/
+STATIC
+VOID
+FindBspStack (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+
+  Hob.Raw = GetHobList ();
+  while ((Hob.Raw = GetNextHob (EFI_HOB_TYPE_MEMORY_ALLOCATION, Hob.Raw)) != NULL) {
+    if (CompareGuid (&gEfiHobMemoryAllocStackGuid, &Hob.MemoryAllocation->AllocDescriptor.Name)) {
+      mBspStackBase  = (UINTN)Hob.MemoryAllocation->AllocDescriptor.MemoryBaseAddress;
+      mBspStackLimit = mBspStackBase + (UINTN)Hob.MemoryAllocation->AllocDescriptor.MemoryLength;
+      return;
+    }
+
+    Hob.Raw = GET_NEXT_HOB (Hob);
+  }
+}
+
+/**
+  Reserves the AP pool and installs the pool services that serve the APs.
+
+  @param  ImageHandle            The firmware allocated handle for the EFI image.
+  @param  SystemTable            A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS            The AP pool services are installed.
+  @retval EFI_UNSUPPORTED        PcdMpPoolDxeSize is zero or there is a single processor.
+  @retval Others                 The AP pool could not be set up.
+
+**/
+EFI_STATUS
+EFIAPI
+MpPoolDxeEntryPoint (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS            Status;
+  RETURN_STATUS         RStatus;
+  UINTN                 NumberOfProcessors;
+  UINTN                 NumberOfEnabledProcessors;
+  UINTN                 Pages;
+  EFI_PHYSICAL_ADDRESS  Memory;
+  EFI_TPL               OldTpl;
+
+  if (PcdGet32 (PcdMpPoolDxeSize) == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = gBS->LocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **)&mMpServices);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = mMpServices->GetNumberOfProcessors (mMpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (NumberOfProcessors < 2) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = mMpServices->WhoAmI (mMpServices, &mBspNumber);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Pages  = EFI_SIZE_TO_PAGES (MpPoolGetOverheadSize (NumberOfProcessors) + PcdGet32 (PcdMpPoolDxeSize));
+  Status = gBS->AllocatePages (AllocateAnyPages, EfiBootServicesData, Pages, &Memory);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "MpPool: Failed to allocate 0x%Lx pages - %r\n", (UINT64)Pages, Status));
+    return Status;
+  }
+
+  RStatus = MpPoolInitialize ((VOID *)(UINTN)Memory, EFI_PAGES_TO_SIZE (Pages), NumberOfProcessors, &mMpPool);
+  if (RETURN_ERROR (RStatus)) {
+    gBS->FreePages (Memory, Pages);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mMpPoolBase  = (UINTN)Memory;
+  mMpPoolLimit = mMpPoolBase + EFI_PAGES_TO_SIZE (Pages);
+  FindBspStack ();
+
+  OldTpl                    = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  mBootServicesAllocatePool = gBS->AllocatePool;
+  mBootServicesFreePool     = gBS->FreePool;
+  gBS->AllocatePool         = MpPoolDxeAllocatePool;
+  gBS->FreePool             = MpPoolDxeFreePool;
+  gBS->Hdr.CRC32            = 0;
+  gBS->CalculateCrc32 ((UINT8 *)&gBS->Hdr, gBS->Hdr.HeaderSize, &gBS->Hdr.CRC32);
+  gBS->RestoreTPL (OldTpl);
+
+  DEBUG ((
+    DEBUG_INFO,
+    "MpPool: 0x%Lx pages at 0x%Lx for %Lu processors\n",
+    (UINT64)Pages,
+    Memory,
+    (UINT64)NumberOfProcessors
+    ));
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,995 @@
+/** @file
+  This is a host-based unit test for the lookup index of the PEI variable driver.
+
+  The variables of a non-volatile store are read and enumerated by walking
+  the store, then the lookup index is built and every read and enumeration
+  must return the same variable as the walk did.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../Variable.h"
+
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "PEI Variable Lookup Index Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_VARIABLE_ATTRIBUTES  (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)
+#define TEST_VARIABLE_NAME_SIZE   32
+#define TEST_NV_STORAGE_SIZE      SIZE_64KB
+#define TEST_HOB_LIST_SIZE        SIZE_4KB
+
+//
+// Variables written to the store, names looked up but never written, and
+// the two names whose hashes collide.
+//
+#define TEST_VARIABLE_COUNT  300
+#define TEST_MISSING_COUNT   10
+#define TEST_NAME_COUNT      (TEST_VARIABLE_COUNT + TEST_MISSING_COUNT + 2)
+
+typedef struct {
+  EFI_STATUS    Status;
+  UINT32        Data;
+} LOOKUP_RESULT;
+
+typedef struct {
+  CHAR16      Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  EFI_GUID    Guid;
+} ENUMERATED_VARIABLE;
+
+/// === TEST DATA ==================================================================================
+
+//
+// Test GUID 1 {A2A4CBB5-8C66-4C0B-92F6-6AC53C0A1B10}
+//
+EFI_GUID  mTestGuid1 = {
+  0xa2a4cbb5, 0x8c66, 0x4c0b, { 0x92, 0xf6, 0x6a, 0xc5, 0x3c, 0x0a, 0x1b, 0x10 }
+};
+
+//
+// Test GUID 2 {676CDA19-6862-44C6-9367-DA04F1B1A164}
+//
+EFI_GUID  mTestGuid2 = {
+  0x676cda19, 0x6862, 0x44c6, { 0x93, 0x67, 0xda, 0x04, 0xf1, 0xb1, 0xa1, 0x64 }
+};
+
+//
+// Test GUID 3 {3C5E0F7D-1B69-4E34-A0D5-7F3A9E2B6C81}
+//
+EFI_GUID  mTestGuid3 = {
+  0x3c5e0f7d, 0x1b69, 0x4e34, { 0xa0, 0xd5, 0x7f, 0x3a, 0x9e, 0x2b, 0x6c, 0x81 }
+};
+
+EFI_GUID  *mTestGuids[] = { &mTestGuid1, &mTestGuid2, &mTestGuid3 };
+
+//
+// Names with the same GetVariableHash() state before the GUID is hashed, so
+// they collide with every vendor GUID.
+//
+CHAR16  *mCollidingNames[] = { L"Col310607", L"Col1675080" };
+
+//
+// The flash NV storage, the variable store in it, and the variables written.
+//
+UINT8                  *mNvStorage;
+VARIABLE_STORE_HEADER  *mStore;
+UINTN                  mStoreFreeOffset;
+UINTN                  mVariableOffsets[2 * TEST_VARIABLE_COUNT + 8];
+UINTN                  mVariableCount;
+
+//
+// The HOB list and the pages allocated through the PEI services.
+//
+UINT64  mHobList[TEST_HOB_LIST_SIZE / sizeof (UINT64)];
+UINTN   mHobFreeOffset;
+UINTN   mAllocatedPages;
+
+//
+// What the walk of the store returned.
+//
+LOOKUP_RESULT        mWalkLookUps[TEST_NAME_COUNT][ARRAY_SIZE (mTestGuids)];
+ENUMERATED_VARIABLE  mWalkEnumeration[2 * TEST_VARIABLE_COUNT + 8];
+UINTN                mWalkEnumerationCount;
+
+/// === STUBS ======================================================================================
+
+/**
+  Terminates the HOB list after the last HOB built.
+
+**/
+VOID
+EndHobList (
+  VOID
+  )
+{
+  EFI_HOB_GENERIC_HEADER  *Hob;
+
+  Hob            = (EFI_HOB_GENERIC_HEADER *)((UINT8 *)mHobList + mHobFreeOffset);
+  Hob->HobType   = EFI_HOB_TYPE_END_OF_HOB_LIST;
+  Hob->HobLength = sizeof (EFI_HOB_GENERIC_HEADER);
+  Hob->Reserved  = 0;
+}
+
+/**
+  Stub of BuildGuidHob() appending to mHobList.
+
+  @param  Guid        The GUID to tag the customized HOB.
+  @param  DataLength  The size of the data payload for the GUID HOB.
+
+  @return The start address of GUID HOB data, or NULL if mHobList is full.
+
+**/
+VOID *
+EFIAPI
+BuildGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN UINTN           DataLength
+  )
+{
+  EFI_HOB_GUID_TYPE  *Hob;
+  UINTN              HobLength;
+
+  HobLength = ALIGN_VALUE (sizeof (EFI_HOB_GUID_TYPE) + DataLength, sizeof (UINT64));
+  if (mHobFreeOffset + HobLength + sizeof (EFI_HOB_GENERIC_HEADER) > sizeof (mHobList)) {
+    return NULL;
+  }
+
+  Hob                   = (EFI_HOB_GUID_TYPE *)((UINT8 *)mHobList + mHobFreeOffset);
+  Hob->Header.HobType   = EFI_HOB_TYPE_GUID_EXTENSION;
+  Hob->Header.HobLength = (UINT16)HobLength;
+  Hob->Header.Reserved  = 0;
+  CopyGuid (&Hob->Name, Guid);
+
+  mHobFreeOffset += HobLength;
+  EndHobList ();
+  return Hob + 1;
+}
+
+/**
+  Stub of GetNextGuidHob() searching mHobList.
+
+  @param  Guid      The GUID to match with in the HOB list.
+  @param  HobStart  A pointer to a Guid.
+
+  @return The next instance of the matched GUID HOB from the starting HOB, or NULL.
+
+**/
+VOID *
+EFIAPI
+GetNextGuidHob (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST VOID      *HobStart
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+
+  for (Hob.Raw = (UINT8 *)HobStart; !END_OF_HOB_LIST (Hob); Hob.Raw = GET_NEXT_HOB (Hob)) {
+    if ((GET_HOB_TYPE (Hob) == EFI_HOB_TYPE_GUID_EXTENSION) && CompareGuid (Guid, &Hob.Guid->Name)) {
+      return Hob.Raw;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Stub of GetFirstGuidHob() searching mHobList.
+
+  @param  Guid  The GUID to match with in the HOB list.
+
+  @return The first instance of the matched GUID HOB, or NULL.
+
+**/
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return GetNextGuidHob (Guid, mHobList);
+}
+
+/**
+  Stub of PeiServicesAllocatePages() counting the pages allocated.
+
+  @param  MemoryType  The type of memory to allocate.
+  @param  Pages       The number of contiguous 4 KB pages to allocate.
+  @param  Memory      Pointer to a physical address.
+
+  @retval EFI_SUCCESS           The memory range was successfully allocated.
+  @retval EFI_OUT_OF_RESOURCES  The pages could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+PeiServicesAllocatePages (
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Pages,
+  OUT EFI_PHYSICAL_ADDRESS  *Memory
+  )
+{
+  VOID  *Buffer;
+
+  Buffer = AllocatePages (Pages);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mAllocatedPages += Pages;
+  *Memory          = (EFI_PHYSICAL_ADDRESS)(UINTN)Buffer;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of PeiServicesFreePages() counting the pages freed.
+
+  @param  Memory  The base physical address of the pages to be freed.
+  @param  Pages   The number of contiguous 4 KB pages to free.
+
+  @retval EFI_SUCCESS  The requested pages were freed.
+
+**/
+EFI_STATUS
+EFIAPI
+PeiServicesFreePages (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 Pages
+  )
+{
+  FreePages ((VOID *)(UINTN)Memory, Pages);
+  mAllocatedPages -= Pages;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of PeiServicesInstallPpi().
+
+  @param  PpiList  A pointer to the list of interfaces that the caller shall install.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+PeiServicesInstallPpi (
+  IN CONST EFI_PEI_PPI_DESCRIPTOR  *PpiList
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of PeiServicesNotifyPpi(). The tests call the notification functions.
+
+  @param  NotifyList  A pointer to the list of notification interfaces.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+PeiServicesNotifyPpi (
+  IN CONST EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyList
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of GetVariableFlashNvStorageInfo() returning mNvStorage.
+
+  @param[out] BaseAddress  The base address of the variable store.
+  @param[out] Length       The length in bytes of the variable store.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+GetVariableFlashNvStorageInfo (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  *BaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)mNvStorage;
+  *Length      = TEST_NV_STORAGE_SIZE;
+  return EFI_SUCCESS;
+}
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Builds the name of test variable Number. The last two names collide.
+
+  @param[out] Name    Buffer of TEST_VARIABLE_NAME_SIZE bytes.
+  @param[in]  Number  The variable number, below TEST_NAME_COUNT.
+
+**/
+VOID
+TestVariableName (
+  OUT CHAR16  *Name,
+  IN  UINTN   Number
+  )
+{
+  if (Number < TEST_VARIABLE_COUNT + TEST_MISSING_COUNT) {
+    UnicodeSPrint (Name, TEST_VARIABLE_NAME_SIZE, L"Var%04u", Number);
+  } else {
+    StrCpyS (Name, TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16), mCollidingNames[Number - TEST_VARIABLE_COUNT - TEST_MISSING_COUNT]);
+  }
+}
+
+/**
+  Returns the first variable of the store.
+
+  @return The first variable header.
+
+**/
+VARIABLE_HEADER *
+FirstVariable (
+  VOID
+  )
+{
+  return (VARIABLE_HEADER *)HEADER_ALIGN (mStore + 1);
+}
+
+/**
+  Appends a variable to the store. Its data is its offset in the store.
+
+  @param[in] Name   The variable name.
+  @param[in] Guid   The vendor GUID.
+  @param[in] State  The variable state.
+
+  @return Offset of the variable in the store, or 0 if the store is full.
+
+**/
+UINTN
+AppendVariable (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Guid,
+  IN UINT8     State
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  UINT8            *NamePtr;
+  UINTN            NameSize;
+  UINT32           Data;
+
+  NameSize = StrSize (Name);
+  if ((mStoreFreeOffset + sizeof (VARIABLE_HEADER) + NameSize + GET_PAD_SIZE (NameSize) + sizeof (Data) > mStore->Size) ||
+      (mVariableCount == ARRAY_SIZE (mVariableOffsets)))
+  {
+    return 0;
+  }
+
+  Variable = (VARIABLE_HEADER *)((UINT8 *)mStore + mStoreFreeOffset);
+  ZeroMem (Variable, sizeof (VARIABLE_HEADER));
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = State;
+  Variable->Attributes = TEST_VARIABLE_ATTRIBUTES;
+  Variable->NameSize   = (UINT32)NameSize;
+  Variable->DataSize   = sizeof (Data);
+  CopyGuid (&Variable->VendorGuid, Guid);
+
+  NamePtr = (UINT8 *)(Variable + 1);
+  Data    = (UINT32)mStoreFreeOffset;
+  CopyMem (NamePtr, Name, NameSize);
+  CopyMem (NamePtr + NameSize + GET_PAD_SIZE (NameSize), &Data, sizeof (Data));
+
+  mVariableOffsets[mVariableCount++] = mStoreFreeOffset;
+  mStoreFreeOffset                   = HEADER_ALIGN (NamePtr + NameSize + GET_PAD_SIZE (NameSize) + sizeof (Data)) - (UINTN)mStore;
+  return Data;
+}
+
+/**
+  Changes the state of a variable of the store.
+
+  @param[in] Offset  Offset of the variable in the store.
+  @param[in] State   The state bits to clear.
+
+**/
+VOID
+ClearVariableState (
+  IN UINTN  Offset,
+  IN UINT8  State
+  )
+{
+  ((VARIABLE_HEADER *)((UINT8 *)mStore + Offset))->State &= State;
+}
+
+/**
+  Fills the store with variables in every state the PEI variable driver
+  handles: updated, deleted, interrupted updates and interrupted deletes,
+  and variables whose hashes collide.
+
+**/
+VOID
+PopulateStore (
+  VOID
+  )
+{
+  CHAR16  Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN   Number;
+  UINTN   Offset;
+
+  for (Number = 0; Number < TEST_VARIABLE_COUNT; Number++) {
+    TestVariableName (Name, Number);
+    Offset = AppendVariable (Name, mTestGuids[Number % ARRAY_SIZE (mTestGuids)], VAR_ADDED);
+    if (Number % 5 == 0) {
+      //
+      // Completed update.
+      //
+      ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+      AppendVariable (Name, mTestGuids[Number % ARRAY_SIZE (mTestGuids)], VAR_ADDED);
+      ClearVariableState (Offset, VAR_DELETED);
+    } else if (Number % 7 == 0) {
+      //
+      // Update interrupted before the old copy was deleted.
+      //
+      ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+      AppendVariable (Name, mTestGuids[Number % ARRAY_SIZE (mTestGuids)], VAR_ADDED);
+    } else if (Number % 11 == 0) {
+      ClearVariableState (Offset, VAR_DELETED);
+    } else if (Number % 13 == 0) {
+      //
+      // Update interrupted before the new copy was written.
+      //
+      ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+    }
+  }
+
+  //
+  // Only the first colliding name exists with GUID 1. With GUID 2, both
+  // exist and the second one is in an interrupted update.
+  //
+  AppendVariable (mCollidingNames[0], &mTestGuid1, VAR_ADDED);
+  Offset = AppendVariable (mCollidingNames[1], &mTestGuid2, VAR_ADDED);
+  ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+  AppendVariable (mCollidingNames[0], &mTestGuid2, VAR_ADDED);
+  AppendVariable (mCollidingNames[1], &mTestGuid2, VAR_ADDED);
+}
+
+/**
+  Reads a variable through the PPI.
+
+  @param[in]  Name    The variable name.
+  @param[in]  Guid    The vendor GUID.
+  @param[out] Result  The status and the data, the offset of the variable.
+
+**/
+VOID
+LookUp (
+  IN  CHAR16         *Name,
+  IN  EFI_GUID       *Guid,
+  OUT LOOKUP_RESULT  *Result
+  )
+{
+  UINTN  DataSize;
+
+  DataSize       = sizeof (Result->Data);
+  Result->Data   = MAX_UINT32;
+  Result->Status = PeiGetVariable (NULL, Name, Guid, NULL, &DataSize, &Result->Data);
+}
+
+/**
+  Enumerates the variables through the PPI.
+
+  @param[out] List  Buffer of ARRAY_SIZE (mWalkEnumeration) variables.
+
+  @return The number of variables enumerated.
+
+**/
+UINTN
+Enumerate (
+  OUT ENUMERATED_VARIABLE  *List
+  )
+{
+  ENUMERATED_VARIABLE  Variable;
+  UINTN                NameSize;
+  UINTN                Count;
+
+  ZeroMem (&Variable, sizeof (Variable));
+  for (Count = 0; Count < ARRAY_SIZE (mWalkEnumeration); Count++) {
+    NameSize = sizeof (Variable.Name);
+    if (PeiGetNextVariableName (NULL, &NameSize, Variable.Name, &Variable.Guid) != EFI_SUCCESS) {
+      break;
+    }
+
+    CopyMem (&List[Count], &Variable, sizeof (Variable));
+  }
+
+  return Count;
+}
+
+/**
+  Records what reads and an enumeration of the store return.
+
+**/
+VOID
+RecordWalk (
+  VOID
+  )
+{
+  CHAR16  Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN   Number;
+  UINTN   GuidIndex;
+
+  for (Number = 0; Number < TEST_NAME_COUNT; Number++) {
+    TestVariableName (Name, Number);
+    for (GuidIndex = 0; GuidIndex < ARRAY_SIZE (mTestGuids); GuidIndex++) {
+      LookUp (Name, mTestGuids[GuidIndex], &mWalkLookUps[Number][GuidIndex]);
+    }
+  }
+
+  mWalkEnumerationCount = Enumerate (mWalkEnumeration);
+}
+
+/**
+  Checks that every read returns what the walk returned.
+
+  @retval TRUE   All reads match the walk.
+  @retval FALSE  At least one read differs.
+
+**/
+BOOLEAN
+LookUpsMatchWalk (
+  VOID
+  )
+{
+  CHAR16         Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN          Number;
+  UINTN          GuidIndex;
+  LOOKUP_RESULT  Result;
+  LOOKUP_RESULT  *Walk;
+
+  for (Number = 0; Number < TEST_NAME_COUNT; Number++) {
+    TestVariableName (Name, Number);
+    for (GuidIndex = 0; GuidIndex < ARRAY_SIZE (mTestGuids); GuidIndex++) {
+      LookUp (Name, mTestGuids[GuidIndex], &Result);
+      Walk = &mWalkLookUps[Number][GuidIndex];
+      if ((Result.Status != Walk->Status) || (Result.Data != Walk->Data)) {
+        UT_LOG_ERROR ("%s %g: %r 0x%x, walk %r 0x%x\n", Name, mTestGuids[GuidIndex], Result.Status, Result.Data, Walk->Status, Walk->Data);
+        return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks that an enumeration returns what the walk returned.
+
+  @retval TRUE   The enumeration matches the walk.
+  @retval FALSE  It differs.
+
+**/
+BOOLEAN
+EnumerationMatchesWalk (
+  VOID
+  )
+{
+  ENUMERATED_VARIABLE  List[ARRAY_SIZE (mWalkEnumeration)];
+  UINTN                Count;
+
+  Count = Enumerate (List);
+  if ((Count != mWalkEnumerationCount) || (CompareMem (List, mWalkEnumeration, Count * sizeof (List[0])) != 0)) {
+    UT_LOG_ERROR ("%d variables enumerated, walk %d\n", (INT32)Count, (INT32)mWalkEnumerationCount);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Returns the lookup index HOB.
+
+  @return The lookup index, or NULL if it was not built.
+
+**/
+VARIABLE_LOOKUP_INDEX *
+GetLookupIndex (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE  *GuidHob;
+
+  GuidHob = GetFirstGuidHob (&gEdkiiVariableLookupIndexGuid);
+  return (GuidHob == NULL) ? NULL : GET_GUID_HOB_DATA (GuidHob);
+}
+
+/**
+  Formats the NV storage, populates it and records what the walk returns.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The store is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  Out of memory.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StoreSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+
+  mNvStorage = AllocatePool (TEST_NV_STORAGE_SIZE);
+  if (mNvStorage == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  SetMem (mNvStorage, TEST_NV_STORAGE_SIZE, 0xFF);
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)mNvStorage;
+  ZeroMem (FvHeader, sizeof (EFI_FIRMWARE_VOLUME_HEADER) + sizeof (EFI_FV_BLOCK_MAP_ENTRY));
+  CopyGuid (&FvHeader->FileSystemGuid, &gEfiSystemNvDataFvGuid);
+  FvHeader->FvLength              = TEST_NV_STORAGE_SIZE;
+  FvHeader->Signature             = EFI_FVH_SIGNATURE;
+  FvHeader->HeaderLength          = sizeof (EFI_FIRMWARE_VOLUME_HEADER) + sizeof (EFI_FV_BLOCK_MAP_ENTRY);
+  FvHeader->Revision              = EFI_FVH_REVISION;
+  FvHeader->BlockMap[0].NumBlocks = TEST_NV_STORAGE_SIZE / SIZE_4KB;
+  FvHeader->BlockMap[0].Length    = SIZE_4KB;
+
+  mStore = (VARIABLE_STORE_HEADER *)(mNvStorage + FvHeader->HeaderLength);
+  CopyGuid (&mStore->Signature, &gEfiVariableGuid);
+  mStore->Size      = TEST_NV_STORAGE_SIZE - FvHeader->HeaderLength;
+  mStore->Format    = VARIABLE_STORE_FORMATTED;
+  mStore->State     = VARIABLE_STORE_HEALTHY;
+  mStore->Reserved  = 0;
+  mStore->Reserved1 = 0;
+  mStoreFreeOffset  = (UINTN)FirstVariable () - (UINTN)mStore;
+  mVariableCount    = 0;
+
+  mHobFreeOffset  = 0;
+  mAllocatedPages = 0;
+  EndHobList ();
+
+  PopulateStore ();
+  RecordWalk ();
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the lookup index and the NV storage.
+
+  @param[in] Context  Unused.
+
+**/
+VOID
+EFIAPI
+StoreCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VariableEndOfPeiNotify (NULL, NULL, NULL);
+  if (mNvStorage != NULL) {
+    FreePool (mNvStorage);
+    mNvStorage = NULL;
+  }
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  Reads and enumerations through the lookup index must return what the walk
+  of the store returned.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The index matches the walk.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A read or the enumeration differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexedLookUpsShouldMatchWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_LOOKUP_INDEX  *LookupIndex;
+
+  UT_ASSERT_NOT_EQUAL (mWalkEnumerationCount, 0);
+
+  VariableMemoryDiscoveredNotify (NULL, NULL, NULL);
+  LookupIndex = GetLookupIndex ();
+  UT_ASSERT_NOT_NULL (LookupIndex);
+  UT_ASSERT_EQUAL (LookupIndex->StoreBase, (UINTN)mStore);
+  UT_ASSERT_EQUAL (LookupIndex->VisibleCount, mWalkEnumerationCount);
+
+  UT_ASSERT_TRUE (LookUpsMatchWalk ());
+  UT_ASSERT_TRUE (EnumerationMatchesWalk ());
+
+  //
+  // The enumeration followed the cursor to the last variable.
+  //
+  UT_ASSERT_EQUAL (LookupIndex->Cursor, LookupIndex->VisibleCount - 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An enumeration restarted from any variable must continue with the variable
+  the walk returned after it, the cursor pointing elsewhere.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             Every restart matches the walk.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A restart differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RestartedEnumerationShouldMatchWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ENUMERATED_VARIABLE  Variable;
+  UINTN                NameSize;
+  UINTN                Index;
+  EFI_STATUS           Status;
+
+  VariableMemoryDiscoveredNotify (NULL, NULL, NULL);
+  UT_ASSERT_NOT_NULL (GetLookupIndex ());
+
+  for (Index = mWalkEnumerationCount; Index > 0; Index--) {
+    CopyMem (&Variable, &mWalkEnumeration[Index - 1], sizeof (Variable));
+    NameSize = sizeof (Variable.Name);
+    Status   = PeiGetNextVariableName (NULL, &NameSize, Variable.Name, &Variable.Guid);
+    if (Index == mWalkEnumerationCount) {
+      UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_FOUND);
+    } else {
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      UT_ASSERT_MEM_EQUAL (&Variable, &mWalkEnumeration[Index], sizeof (Variable));
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  FindVariableInLookupIndex() must tell apart the variables whose hashes
+  collide, and GetNextEnumeratedVariable() must skip from any variable to the
+  next one enumerated.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The index functions match the walk.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A result differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexFunctionsShouldMatchWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_STORE_INFO     StoreInfo;
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  VARIABLE_LOOKUP_INDEX   *LookupIndex;
+  VARIABLE_HEADER         *Variable;
+  VARIABLE_HEADER         *Expected;
+  UINT32                  *Visible;
+  LOOKUP_RESULT           *Walk;
+  UINTN                   NameIndex;
+  UINTN                   GuidIndex;
+  UINTN                   Index;
+  UINTN                   Next;
+  EFI_STATUS              Status;
+
+  UT_ASSERT_EQUAL (
+    GetVariableHash (mCollidingNames[0], MAX_UINTN, &mTestGuid1),
+    GetVariableHash (mCollidingNames[1], MAX_UINTN, &mTestGuid1)
+    );
+
+  VariableMemoryDiscoveredNotify (NULL, NULL, NULL);
+  UT_ASSERT_EQUAL ((UINTN)GetVariableStore (VariableStoreTypeNv, &StoreInfo), (UINTN)mStore);
+  UT_ASSERT_NOT_NULL (StoreInfo.LookupIndex);
+  LookupIndex = StoreInfo.LookupIndex;
+
+  for (NameIndex = 0; NameIndex < ARRAY_SIZE (mCollidingNames); NameIndex++) {
+    for (GuidIndex = 0; GuidIndex < ARRAY_SIZE (mTestGuids); GuidIndex++) {
+      ZeroMem (&PtrTrack, sizeof (PtrTrack));
+      PtrTrack.StartPtr = FirstVariable ();
+      Status            = FindVariableInLookupIndex (&StoreInfo, mCollidingNames[NameIndex], mTestGuids[GuidIndex], &PtrTrack);
+      Walk              = &mWalkLookUps[TEST_VARIABLE_COUNT + TEST_MISSING_COUNT + NameIndex][GuidIndex];
+      UT_ASSERT_STATUS_EQUAL (Status, Walk->Status);
+      if (!EFI_ERROR (Status)) {
+        UT_ASSERT_EQUAL ((UINTN)PtrTrack.CurrPtr - (UINTN)mStore, Walk->Data);
+      }
+    }
+  }
+
+  //
+  // The variables the index enumerates are the ones the walk returned.
+  //
+  Visible = (UINT32 *)(UINTN)LookupIndex->Visible;
+  UT_ASSERT_EQUAL (LookupIndex->VisibleCount, mWalkEnumerationCount);
+  for (Index = 0; Index < LookupIndex->VisibleCount; Index++) {
+    Variable = (VARIABLE_HEADER *)((UINTN)FirstVariable () + Visible[Index]);
+    UT_ASSERT_MEM_EQUAL (Variable + 1, mWalkEnumeration[Index].Name, Variable->NameSize);
+    UT_ASSERT_MEM_EQUAL (&Variable->VendorGuid, &mWalkEnumeration[Index].Guid, sizeof (EFI_GUID));
+  }
+
+  //
+  // From every variable of the store, in reverse so that the cursor never
+  // points at it, the next variable is the first one enumerated after it.
+  //
+  Next = LookupIndex->VisibleCount;
+  for (Index = mVariableCount; Index > 0; Index--) {
+    Variable = (VARIABLE_HEADER *)((UINT8 *)mStore + mVariableOffsets[Index - 1]);
+    while ((Next > 0) && ((UINTN)FirstVariable () + Visible[Next - 1] > (UINTN)Variable)) {
+      Next--;
+    }
+
+    if (Next < LookupIndex->VisibleCount) {
+      Expected = (VARIABLE_HEADER *)((UINTN)FirstVariable () + Visible[Next]);
+    } else {
+      Expected = (VARIABLE_HEADER *)((UINT8 *)mStore + mStore->Size);
+    }
+
+    UT_ASSERT_EQUAL ((UINTN)GetNextEnumeratedVariable (&StoreInfo, Variable, Variable), (UINTN)Expected);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The end of PEI must free the lookup index, and the reads and enumerations
+  made afterwards must still return what the walk returned.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The index is freed and reads match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The index is left or a read differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EndOfPeiShouldFreeLookupIndex (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_STORE_INFO    StoreInfo;
+  VARIABLE_LOOKUP_INDEX  *LookupIndex;
+
+  VariableMemoryDiscoveredNotify (NULL, NULL, NULL);
+  UT_ASSERT_NOT_EQUAL (mAllocatedPages, 0);
+
+  VariableEndOfPeiNotify (NULL, NULL, NULL);
+  UT_ASSERT_EQUAL (mAllocatedPages, 0);
+  LookupIndex = GetLookupIndex ();
+  UT_ASSERT_NOT_NULL (LookupIndex);
+  UT_ASSERT_EQUAL (LookupIndex->StoreBase, 0);
+  UT_ASSERT_EQUAL (LookupIndex->Entries, 0);
+
+  GetVariableStore (VariableStoreTypeNv, &StoreInfo);
+  UT_ASSERT_TRUE (StoreInfo.LookupIndex == NULL);
+
+  UT_ASSERT_TRUE (LookUpsMatchWalk ());
+  UT_ASSERT_TRUE (EnumerationMatchesWalk ());
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  When the lookup index HOB cannot be built, the pages allocated for the
+  index must be freed, and the reads and enumerations must still return what
+  the walk returned.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The pages are freed and reads match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  Pages are leaked or a read differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FullHobListShouldNotLeakPages (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  //
+  // Fill the HOB list up so that no other GUID HOB fits.
+  //
+  UT_ASSERT_NOT_NULL (
+    BuildGuidHob (
+      &mTestGuid1,
+      sizeof (mHobList) - mHobFreeOffset - sizeof (EFI_HOB_GUID_TYPE) - sizeof (EFI_HOB_GENERIC_HEADER)
+      )
+    );
+
+  VariableMemoryDiscoveredNotify (NULL, NULL, NULL);
+  UT_ASSERT_TRUE (GetLookupIndex () == NULL);
+  UT_ASSERT_EQUAL (mAllocatedPages, 0);
+
+  UT_ASSERT_TRUE (LookUpsMatchWalk ());
+  UT_ASSERT_TRUE (EnumerationMatchesWalk ());
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  lookup index of the PEI variable driver and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      LookupIndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&LookupIndexTests, Framework, "PEI Variable Lookup Index Tests", "PeiVarIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for LookupIndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (LookupIndexTests, "Indexed lookups should match the walk of the store", "LookUps", IndexedLookUpsShouldMatchWalk, StoreSetup, StoreCleanup, NULL);
+  AddTestCase (LookupIndexTests, "Restarted enumerations should match the walk of the store", "Restart", RestartedEnumerationShouldMatchWalk, StoreSetup, StoreCleanup, NULL);
+  AddTestCase (LookupIndexTests, "The index functions should match the walk of the store", "Functions", IndexFunctionsShouldMatchWalk, StoreSetup, StoreCleanup, NULL);
+  AddTestCase (LookupIndexTests, "The end of PEI should free the lookup index", "EndOfPei", EndOfPeiShouldFreeLookupIndex, StoreSetup, StoreCleanup, NULL);
+  AddTestCase (LookupIndexTests, "A full HOB list should not leak the index pages", "FullHobList", FullHobListShouldNotLeakPages, StoreSetup, StoreCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
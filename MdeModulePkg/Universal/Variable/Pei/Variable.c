@@ -24,6 +24,19 @@ EFI_PEI_PPI_DESCRIPTOR  mPpiListVariable = {
   &mVariablePpi
 };
 
+EFI_PEI_NOTIFY_DESCRIPTOR  mNotifyList[] = {
+  {
+    EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK,
+    &gEfiPeiMemoryDiscoveredPpiGuid,
+    VariableMemoryDiscoveredNotify
+  },
+  {
+    (EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST),
+    &gEfiEndOfPeiSignalPpiGuid,
+    VariableEndOfPeiNotify
+  }
+};
+
 /**
   Provide the functionality of the variable services.
 
@@ -41,6 +54,11 @@ PeimInitializeVariableServices (
   IN CONST EFI_PEI_SERVICES     **PeiServices
   )
 {
+  EFI_STATUS  Status;
+
+  Status = PeiServicesNotifyPpi (mNotifyList);
+  ASSERT_EFI_ERROR (Status);
+
   return PeiServicesInstallPpi (&mPpiListVariable);
 }
 
@@ -578,6 +596,7 @@ GetVariableStore (
   UINT32                                BackUpOffset;
 
   StoreInfo->IndexTable       = NULL;
+  StoreInfo->LookupIndex      = NULL;
   StoreInfo->FtwLastWriteData = NULL;
   StoreInfo->AuthFlag         = FALSE;
   VariableStoreHeader         = NULL;
@@ -645,6 +664,18 @@ GetVariableStore (
 
         StoreInfo->AuthFlag = (BOOLEAN)(CompareGuid (&VariableStoreHeader->Signature, &gEfiAuthenticatedVariableGuid));
 
+        GuidHob = GetFirstGuidHob (&gEdkiiVariableLookupIndexGuid);
+        if (GuidHob != NULL) {
+          StoreInfo->LookupIndex = GET_GUID_HOB_DATA (GuidHob);
+          if ((StoreInfo->LookupIndex->StoreBase == (EFI_PHYSICAL_ADDRESS)(UINTN)VariableStoreHeader) &&
+              (StoreInfo->FtwLastWriteData == NULL))
+          {
+            break;
+          }
+
+          StoreInfo->LookupIndex = NULL;
+        }
+
         GuidHob = GetFirstGuidHob (&gEfiVariableIndexTableGuid);
         if (GuidHob != NULL) {
           StoreInfo->IndexTable = GET_GUID_HOB_DATA (GuidHob);
@@ -798,6 +829,78 @@ GetVariableNameOrData (
   CopyMem (Buffer, NameOrData, Size);
 }
 
+/**
+  Find the variable with the lookup index of the variable store.
+
+  The entries with the same hash are sorted by offset, so the result is the
+  one of the walk done by FindVariableEx(): the first added variable, or else
+  the last one in delete transition.
+
+  @param  StoreInfo           Pointer to the store info structure, with a lookup index.
+  @param  VariableName        Name of the variable to be found, not an empty string.
+  @param  VendorGuid          Vendor GUID to be found.
+  @param  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+
+  @retval  EFI_SUCCESS            Variable found successfully
+  @retval  EFI_NOT_FOUND          Variable not found
+
+**/
+EFI_STATUS
+FindVariableInLookupIndex (
+  IN VARIABLE_STORE_INFO      *StoreInfo,
+  IN CONST CHAR16             *VariableName,
+  IN CONST EFI_GUID           *VendorGuid,
+  OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_LOOKUP_INDEX        *LookupIndex;
+  VARIABLE_LOOKUP_INDEX_ENTRY  *Entries;
+  UINT32                       Hash;
+  UINTN                        Low;
+  UINTN                        High;
+  UINTN                        Middle;
+  VARIABLE_HEADER              *Variable;
+  VARIABLE_HEADER              *VariableHeader;
+  VARIABLE_HEADER              *InDeletedVariable;
+
+  LookupIndex = StoreInfo->LookupIndex;
+  Entries     = (VARIABLE_LOOKUP_INDEX_ENTRY *)(UINTN)LookupIndex->Entries;
+  Hash        = GetVariableHash (VariableName, MAX_UINTN, VendorGuid);
+
+  Low  = 0;
+  High = LookupIndex->EntryCount;
+  while (Low < High) {
+    Middle = (Low + High) / 2;
+    if (Entries[Middle].Hash < Hash) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  InDeletedVariable = NULL;
+  for ( ; Low < LookupIndex->EntryCount && Entries[Low].Hash == Hash; Low++) {
+    Variable = (VARIABLE_HEADER *)((UINTN)PtrTrack->StartPtr + Entries[Low].Offset);
+    if (!GetVariableHeader (StoreInfo, Variable, &VariableHeader)) {
+      continue;
+    }
+
+    if ((VariableHeader->State == VAR_ADDED) || (VariableHeader->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      if (CompareWithValidVariable (StoreInfo, Variable, VariableHeader, VariableName, VendorGuid, PtrTrack) == EFI_SUCCESS) {
+        if (VariableHeader->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+          InDeletedVariable = PtrTrack->CurrPtr;
+        } else {
+          return EFI_SUCCESS;
+        }
+      }
+    }
+  }
+
+  PtrTrack->CurrPtr = InDeletedVariable;
+
+  return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
 /**
   Find the variable in the specified variable store.
 
@@ -848,6 +951,10 @@ FindVariableEx (
   PtrTrack->StartPtr = GetStartPointer (VariableStoreHeader);
   PtrTrack->EndPtr   = GetEndPointer (VariableStoreHeader);
 
+  if ((StoreInfo->LookupIndex != NULL) && (VariableName[0] != 0)) {
+    return FindVariableInLookupIndex (StoreInfo, VariableName, VendorGuid, PtrTrack);
+  }
+
   InDeletedVariable = NULL;
 
   //
@@ -990,6 +1097,66 @@ FindVariable (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Get the variable that follows Variable when the variables are enumerated.
+
+  With a lookup index, this skips the variables that PeiGetNextVariableName()
+  never returns and, when Variable is the one returned last, costs no search.
+
+  @param  StoreInfo       Pointer to variable store info structure.
+  @param  Variable        Pointer to the Variable Header.
+  @param  VariableHeader  Pointer to the Variable Header that has consecutive content.
+
+  @return  The next variable to consider, or the end of the store.
+
+**/
+VARIABLE_HEADER *
+GetNextEnumeratedVariable (
+  IN VARIABLE_STORE_INFO  *StoreInfo,
+  IN VARIABLE_HEADER      *Variable,
+  IN VARIABLE_HEADER      *VariableHeader
+  )
+{
+  VARIABLE_LOOKUP_INDEX  *LookupIndex;
+  VARIABLE_HEADER        *StartPtr;
+  UINT32                 *Visible;
+  UINTN                  Offset;
+  UINTN                  Low;
+  UINTN                  High;
+  UINTN                  Middle;
+
+  LookupIndex = StoreInfo->LookupIndex;
+  if (LookupIndex == NULL) {
+    return GetNextVariablePtr (StoreInfo, Variable, VariableHeader);
+  }
+
+  StartPtr = GetStartPointer (StoreInfo->VariableStoreHeader);
+  Visible  = (UINT32 *)(UINTN)LookupIndex->Visible;
+  Offset   = (UINTN)Variable - (UINTN)StartPtr;
+
+  if ((LookupIndex->Cursor < LookupIndex->VisibleCount) && (Visible[LookupIndex->Cursor] == Offset)) {
+    Low = LookupIndex->Cursor + 1;
+  } else {
+    Low  = 0;
+    High = LookupIndex->VisibleCount;
+    while (Low < High) {
+      Middle = (Low + High) / 2;
+      if (Visible[Middle] <= Offset) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+  }
+
+  if (Low >= LookupIndex->VisibleCount) {
+    return GetEndPointer (StoreInfo->VariableStoreHeader);
+  }
+
+  LookupIndex->Cursor = (UINT32)Low;
+  return (VARIABLE_HEADER *)((UINTN)StartPtr + Visible[Low]);
+}
+
 /**
   This service retrieves a variable's value using its name and GUID.
 
@@ -1144,7 +1311,7 @@ PeiGetNextVariableName (
     // If variable name is not NULL, get next variable
     //
     GetVariableHeader (&StoreInfo, Variable.CurrPtr, &VariableHeader);
-    Variable.CurrPtr = GetNextVariablePtr (&StoreInfo, Variable.CurrPtr, VariableHeader);
+    Variable.CurrPtr = GetNextEnumeratedVariable (&StoreInfo, Variable.CurrPtr, VariableHeader);
   }
 
   VariableStoreHeader[VariableStoreTypeHob] = GetVariableStore (VariableStoreTypeHob, &StoreInfoForHob);
@@ -1203,7 +1370,7 @@ PeiGetNextVariableName (
                    &VariablePtrTrack
                    );
         if (!EFI_ERROR (Status) && (VariablePtrTrack.CurrPtr != Variable.CurrPtr)) {
-          Variable.CurrPtr = GetNextVariablePtr (&StoreInfo, Variable.CurrPtr, VariableHeader);
+          Variable.CurrPtr = GetNextEnumeratedVariable (&StoreInfo, Variable.CurrPtr, VariableHeader);
           continue;
         }
       }
@@ -1222,7 +1389,7 @@ PeiGetNextVariableName (
                    &VariableInHob
                    );
         if (!EFI_ERROR (Status)) {
-          Variable.CurrPtr = GetNextVariablePtr (&StoreInfo, Variable.CurrPtr, VariableHeader);
+          Variable.CurrPtr = GetNextEnumeratedVariable (&StoreInfo, Variable.CurrPtr, VariableHeader);
           continue;
         }
       }
@@ -1246,7 +1413,219 @@ PeiGetNextVariableName (
       //
       return Status;
     } else {
-      Variable.CurrPtr = GetNextVariablePtr (&StoreInfo, Variable.CurrPtr, VariableHeader);
+      Variable.CurrPtr = GetNextEnumeratedVariable (&StoreInfo, Variable.CurrPtr, VariableHeader);
     }
   }
 }
+
+/**
+  Compare two lookup index entries by hash and then by offset.
+
+  @param  Buffer1  Pointer to the first VARIABLE_LOOKUP_INDEX_ENTRY.
+  @param  Buffer2  Pointer to the second VARIABLE_LOOKUP_INDEX_ENTRY.
+
+  @retval <0  Buffer1 sorts before Buffer2.
+  @retval 0   The entries are equal.
+  @retval >0  Buffer1 sorts after Buffer2.
+
+**/
+INTN
+EFIAPI
+CompareLookupIndexEntry (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST VARIABLE_LOOKUP_INDEX_ENTRY  *Entry1;
+  CONST VARIABLE_LOOKUP_INDEX_ENTRY  *Entry2;
+
+  Entry1 = (CONST VARIABLE_LOOKUP_INDEX_ENTRY *)Buffer1;
+  Entry2 = (CONST VARIABLE_LOOKUP_INDEX_ENTRY *)Buffer2;
+  if (Entry1->Hash != Entry2->Hash) {
+    return (Entry1->Hash < Entry2->Hash) ? -1 : 1;
+  }
+
+  if (Entry1->Offset != Entry2->Offset) {
+    return (Entry1->Offset < Entry2->Offset) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+/**
+  Builds the lookup index of the non-volatile variable store once permanent
+  memory is available.
+
+  @param  PeiServices       An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  NotifyDescriptor  Address of the notification descriptor data structure.
+  @param  Ppi               Address of the PPI that was installed.
+
+  @retval EFI_SUCCESS  Always. Lookups walk the store if the index cannot be built.
+
+**/
+EFI_STATUS
+EFIAPI
+VariableMemoryDiscoveredNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  EFI_STATUS                   Status;
+  VARIABLE_STORE_INFO          StoreInfo;
+  VARIABLE_STORE_HEADER        *VariableStoreHeader;
+  VARIABLE_HEADER              *StartPtr;
+  VARIABLE_HEADER              *Variable;
+  VARIABLE_HEADER              *VariableHeader;
+  VARIABLE_POINTER_TRACK       PtrTrack;
+  VARIABLE_LOOKUP_INDEX        *LookupIndex;
+  VARIABLE_LOOKUP_INDEX_ENTRY  *Entries;
+  VARIABLE_LOOKUP_INDEX_ENTRY  Entry;
+  UINT32                       *Visible;
+  UINT32                       EntryCount;
+  UINT32                       VisibleCount;
+  EFI_PHYSICAL_ADDRESS         Address;
+
+  if (GetFirstGuidHob (&gEdkiiVariableLookupIndexGuid) != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // A store partly backed up in the spare block is left to the walk, which
+  // knows how to follow the variables across the two blocks.
+  //
+  VariableStoreHeader = GetVariableStore (VariableStoreTypeNv, &StoreInfo);
+  if ((VariableStoreHeader == NULL) || (StoreInfo.FtwLastWriteData != NULL) ||
+      (GetVariableStoreStatus (VariableStoreHeader) != EfiValid) || (~VariableStoreHeader->Size == 0))
+  {
+    return EFI_SUCCESS;
+  }
+
+  StartPtr   = GetStartPointer (VariableStoreHeader);
+  EntryCount = 0;
+  for (Variable = StartPtr; GetVariableHeader (&StoreInfo, Variable, &VariableHeader); Variable = GetNextVariablePtr (&StoreInfo, Variable, VariableHeader)) {
+    if ((VariableHeader->State == VAR_ADDED) || (VariableHeader->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      EntryCount++;
+    }
+  }
+
+  if (EntryCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = PeiServicesAllocatePages (
+             EfiBootServicesData,
+             EFI_SIZE_TO_PAGES (EntryCount * (sizeof (VARIABLE_LOOKUP_INDEX_ENTRY) + sizeof (UINT32))),
+             &Address
+             );
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  LookupIndex = BuildGuidHob (&gEdkiiVariableLookupIndexGuid, sizeof (VARIABLE_LOOKUP_INDEX));
+  if (LookupIndex == NULL) {
+    PeiServicesFreePages (
+      Address,
+      EFI_SIZE_TO_PAGES (EntryCount * (sizeof (VARIABLE_LOOKUP_INDEX_ENTRY) + sizeof (UINT32)))
+      );
+    return EFI_SUCCESS;
+  }
+
+  Entries    = (VARIABLE_LOOKUP_INDEX_ENTRY *)(UINTN)Address;
+  Visible    = (UINT32 *)(Entries + EntryCount);
+  EntryCount = 0;
+  for (Variable = StartPtr; GetVariableHeader (&StoreInfo, Variable, &VariableHeader); Variable = GetNextVariablePtr (&StoreInfo, Variable, VariableHeader)) {
+    if ((VariableHeader->State == VAR_ADDED) || (VariableHeader->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      Entries[EntryCount].Hash = GetVariableHash (
+                                   GetVariableNamePtr (Variable, StoreInfo.AuthFlag),
+                                   NameSizeOfVariable (VariableHeader, StoreInfo.AuthFlag),
+                                   GetVendorGuidPtr (VariableHeader, StoreInfo.AuthFlag)
+                                   );
+      Entries[EntryCount].Offset = (UINT32)((UINTN)Variable - (UINTN)StartPtr);
+      EntryCount++;
+    }
+  }
+
+  QuickSort (Entries, EntryCount, sizeof (VARIABLE_LOOKUP_INDEX_ENTRY), CompareLookupIndexEntry, &Entry);
+
+  LookupIndex->StoreBase    = (EFI_PHYSICAL_ADDRESS)(UINTN)VariableStoreHeader;
+  LookupIndex->EntryCount   = EntryCount;
+  LookupIndex->VisibleCount = 0;
+  LookupIndex->Entries      = (EFI_PHYSICAL_ADDRESS)(UINTN)Entries;
+  LookupIndex->Visible      = (EFI_PHYSICAL_ADDRESS)(UINTN)Visible;
+  LookupIndex->Cursor       = 0;
+  LookupIndex->Reserved     = 0;
+  StoreInfo.LookupIndex     = LookupIndex;
+
+  //
+  // A variable in delete transition is only enumerated when it has no added
+  // copy and is the one FindVariableEx() returns.
+  //
+  VisibleCount = 0;
+  for (Variable = StartPtr; GetVariableHeader (&StoreInfo, Variable, &VariableHeader); Variable = GetNextVariablePtr (&StoreInfo, Variable, VariableHeader)) {
+    if (VariableHeader->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      Status = FindVariableEx (
+                 &StoreInfo,
+                 GetVariableNamePtr (Variable, StoreInfo.AuthFlag),
+                 GetVendorGuidPtr (VariableHeader, StoreInfo.AuthFlag),
+                 &PtrTrack
+                 );
+      if (EFI_ERROR (Status) || (PtrTrack.CurrPtr != Variable)) {
+        continue;
+      }
+    } else if (VariableHeader->State != VAR_ADDED) {
+      continue;
+    }
+
+    Visible[VisibleCount++] = (UINT32)((UINTN)Variable - (UINTN)StartPtr);
+  }
+
+  LookupIndex->VisibleCount = VisibleCount;
+
+  DEBUG ((DEBUG_INFO, "PeiVariable: Lookup index of %d variables, %d enumerated\n", EntryCount, VisibleCount));
+  return EFI_SUCCESS;
+}
+
+/**
+  Frees the lookup index of the non-volatile variable store at the end of PEI.
+
+  The index is private to this driver, the DXE variable driver indexes its own
+  copy of the store. Lookups made after the end of PEI walk the store again.
+
+  @param  PeiServices       An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  NotifyDescriptor  Address of the notification descriptor data structure.
+  @param  Ppi               Address of the PPI that was installed.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+VariableEndOfPeiNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  EFI_HOB_GUID_TYPE      *GuidHob;
+  VARIABLE_LOOKUP_INDEX  *LookupIndex;
+
+  GuidHob = GetFirstGuidHob (&gEdkiiVariableLookupIndexGuid);
+  if (GuidHob == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  LookupIndex = GET_GUID_HOB_DATA (GuidHob);
+  if (LookupIndex->Entries != 0) {
+    PeiServicesFreePages (
+      LookupIndex->Entries,
+      EFI_SIZE_TO_PAGES (LookupIndex->EntryCount * (sizeof (VARIABLE_LOOKUP_INDEX_ENTRY) + sizeof (UINT32)))
+      );
+  }
+
+  //
+  // No store is at address 0, so GetVariableStore() no longer uses the index
+  //
+  ZeroMem (LookupIndex, sizeof (VARIABLE_LOOKUP_INDEX));
+  return EFI_SUCCESS;
+}
@@ -12,7 +12,10 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <PiPei.h>
 #include <Ppi/ReadOnlyVariable2.h>
+#include <Ppi/MemoryDiscovered.h>
+#include <Ppi/EndOfPeiPhase.h>
 
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/PeimEntryPoint.h>
 #include <Library/HobLib.h>
@@ -25,9 +28,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Guid/VariableFormat.h>
 #include <Guid/VariableIndexTable.h>
+#include <Guid/VariableLookupIndex.h>
 #include <Guid/SystemNvDataGuid.h>
 #include <Guid/FaultTolerantWrite.h>
 
+#include "../RuntimeDxe/VariableHash.h"
+
 typedef enum {
   VariableStoreTypeHob,
   VariableStoreTypeNv,
@@ -38,6 +44,11 @@ typedef struct {
   VARIABLE_STORE_HEADER                   *VariableStoreHeader;
   VARIABLE_INDEX_TABLE                    *IndexTable;
   //
+  // Index of all the variables of the store, used instead of IndexTable
+  // once permanent memory is available.
+  //
+  VARIABLE_LOOKUP_INDEX                   *LookupIndex;
+  //
   // If it is not NULL, it means there may be an inconsecutive variable whose
   // partial content is still in NV storage, but another partial content is backed up
   // in spare block.
@@ -50,6 +61,101 @@ typedef struct {
 // Functions
 //
 
+/**
+  Builds the lookup index of the non-volatile variable store once permanent
+  memory is available.
+
+  @param  PeiServices       An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  NotifyDescriptor  Address of the notification descriptor data structure.
+  @param  Ppi               Address of the PPI that was installed.
+
+  @retval EFI_SUCCESS  Always. Lookups walk the store if the index cannot be built.
+
+**/
+EFI_STATUS
+EFIAPI
+VariableMemoryDiscoveredNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  );
+
+/**
+  Frees the lookup index of the non-volatile variable store at the end of PEI.
+
+  @param  PeiServices       An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  NotifyDescriptor  Address of the notification descriptor data structure.
+  @param  Ppi               Address of the PPI that was installed.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+VariableEndOfPeiNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  );
+
+/**
+  Return the variable store header and the store info based on the Index.
+
+  @param Type       The type of the variable store.
+  @param StoreInfo  Return the store info.
+
+  @return  Pointer to the variable store header.
+**/
+VARIABLE_STORE_HEADER *
+GetVariableStore (
+  IN VARIABLE_STORE_TYPE   Type,
+  OUT VARIABLE_STORE_INFO  *StoreInfo
+  );
+
+/**
+  Find the variable with the lookup index of the variable store.
+
+  The entries with the same hash are sorted by offset, so the result is the
+  one of the walk done by FindVariableEx(): the first added variable, or else
+  the last one in delete transition.
+
+  @param  StoreInfo           Pointer to the store info structure, with a lookup index.
+  @param  VariableName        Name of the variable to be found, not an empty string.
+  @param  VendorGuid          Vendor GUID to be found.
+  @param  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+
+  @retval  EFI_SUCCESS            Variable found successfully
+  @retval  EFI_NOT_FOUND          Variable not found
+
+**/
+EFI_STATUS
+FindVariableInLookupIndex (
+  IN VARIABLE_STORE_INFO      *StoreInfo,
+  IN CONST CHAR16             *VariableName,
+  IN CONST EFI_GUID           *VendorGuid,
+  OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  );
+
+/**
+  Get the variable that follows Variable when the variables are enumerated.
+
+  With a lookup index, this skips the variables that PeiGetNextVariableName()
+  never returns and, when Variable is the one returned last, costs no search.
+
+  @param  StoreInfo       Pointer to variable store info structure.
+  @param  Variable        Pointer to the Variable Header.
+  @param  VariableHeader  Pointer to the Variable Header that has consecutive content.
+
+  @return  The next variable to consider, or the end of the store.
+
+**/
+VARIABLE_HEADER *
+GetNextEnumeratedVariable (
+  IN VARIABLE_STORE_INFO  *StoreInfo,
+  IN VARIABLE_HEADER      *Variable,
+  IN VARIABLE_HEADER      *VariableHeader
+  );
+
 /**
   Provide the functionality of the variable services.
 
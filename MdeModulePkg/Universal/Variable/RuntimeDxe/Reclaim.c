@@ -92,8 +92,16 @@ GetLbaAndOffsetByAddress (
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  If PcdVariableIncrementalReclaim is TRUE, the leading blocks that already
+  hold the content of the buffer are not written. The write starts at the
+  first block that differs and still ends at the end of the store, so it
+  remains a single fault tolerant write of the high part of the NV storage,
+  which the FTW recovery in PEI and DXE already handles.
+
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
+  @param  BytesWritten   Return the number of bytes written through FTW.
+  @param  BlocksWritten  Return the number of flash blocks written through FTW.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -102,16 +110,26 @@ GetLbaAndOffsetByAddress (
 **/
 EFI_STATUS
 FtwVariableSpace (
-  IN EFI_PHYSICAL_ADDRESS   VariableBase,
-  IN VARIABLE_STORE_HEADER  *VariableBuffer
+  IN  EFI_PHYSICAL_ADDRESS   VariableBase,
+  IN  VARIABLE_STORE_HEADER  *VariableBuffer,
+  OUT UINTN                  *BytesWritten,
+  OUT UINTN                  *BlocksWritten
   )
 {
-  EFI_STATUS                         Status;
-  EFI_HANDLE                         FvbHandle;
-  EFI_LBA                            VarLba;
-  UINTN                              VarOffset;
-  UINTN                              FtwBufferSize;
-  EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
+  EFI_STATUS                          Status;
+  EFI_HANDLE                          FvbHandle;
+  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
+  EFI_LBA                             VarLba;
+  UINTN                               VarOffset;
+  UINTN                               FtwBufferSize;
+  UINTN                               BlockSize;
+  UINTN                               NumberOfBlocks;
+  UINTN                               Offset;
+  UINTN                               NextOffset;
+  EFI_FAULT_TOLERANT_WRITE_PROTOCOL   *FtwProtocol;
+
+  *BytesWritten  = 0;
+  *BlocksWritten = 0;
 
   //
   // Locate fault tolerant write protocol.
@@ -124,7 +142,7 @@ FtwVariableSpace (
   //
   // Locate Fvb handle by address.
   //
-  Status = GetFvbInfoByAddress (VariableBase, &FvbHandle, NULL);
+  Status = GetFvbInfoByAddress (VariableBase, &FvbHandle, &Fvb);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -137,21 +155,54 @@ FtwVariableSpace (
     return EFI_ABORTED;
   }
 
+  Status = Fvb->GetBlockSize (Fvb, VarLba, &BlockSize, &NumberOfBlocks);
+  if (EFI_ERROR (Status) || (BlockSize == 0)) {
+    return EFI_ABORTED;
+  }
+
   FtwBufferSize = ((VARIABLE_STORE_HEADER *)((UINTN)VariableBase))->Size;
   ASSERT (FtwBufferSize == VariableBuffer->Size);
 
+  //
+  // Skip the blocks that are unchanged. Reclaim keeps the order of the
+  // variables, so these are the variables that were not updated since the
+  // store was last compacted. The comparison reads the memory mapped flash.
+  //
+  Offset = 0;
+  if (FeaturePcdGet (PcdVariableIncrementalReclaim)) {
+    while (Offset < FtwBufferSize) {
+      NextOffset = MIN (FtwBufferSize, ((VarOffset + Offset) / BlockSize + 1) * BlockSize - VarOffset);
+      if (CompareMem ((UINT8 *)(UINTN)VariableBase + Offset, (UINT8 *)VariableBuffer + Offset, NextOffset - Offset) != 0) {
+        break;
+      }
+
+      Offset = NextOffset;
+    }
+
+    if (Offset == FtwBufferSize) {
+      return EFI_SUCCESS;
+    }
+
+    VarLba   += (VarOffset + Offset) / BlockSize;
+    VarOffset = (VarOffset + Offset) % BlockSize;
+  }
+
   //
   // FTW write record.
   //
   Status = FtwProtocol->Write (
                           FtwProtocol,
-                          VarLba,                // LBA
-                          VarOffset,             // Offset
-                          FtwBufferSize,         // NumBytes
-                          NULL,                  // PrivateData NULL
-                          FvbHandle,             // Fvb Handle
-                          (VOID *)VariableBuffer // write buffer
+                          VarLba,                                    // LBA
+                          VarOffset,                                 // Offset
+                          FtwBufferSize - Offset,                    // NumBytes
+                          NULL,                                      // PrivateData NULL
+                          FvbHandle,                                 // Fvb Handle
+                          (VOID *)((UINT8 *)VariableBuffer + Offset) // write buffer
                           );
+  if (!EFI_ERROR (Status)) {
+    *BytesWritten  = FtwBufferSize - Offset;
+    *BlocksWritten = (VarOffset + *BytesWritten + BlockSize - 1) / BlockSize;
+  }
 
   return Status;
 }
@@ -0,0 +1,686 @@
+/** @file
+  This is a host-based unit test for the variable store hash index.
+
+  Every lookup is run against two identical variable stores, one of them
+  indexed, and FindVariableEx() must return the same variable for both.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "../VariableParsing.h"
+#include "../VariableIndex.h"
+
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "Variable Store Index Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_VARIABLE_ATTRIBUTES  (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)
+#define TEST_VARIABLE_NAME_SIZE   16
+
+typedef struct {
+  BOOLEAN    AuthFormat;
+  UINT32     StoreSize;
+  UINTN      VariableCount;
+  UINT32     DataSize;
+} VARIABLE_INDEX_TEST_CONTEXT;
+
+/// === TEST DATA ==================================================================================
+
+//
+// Test GUID 1 {A2A4CBB5-8C66-4C0B-92F6-6AC53C0A1B10}
+//
+EFI_GUID  mTestGuid1 = {
+  0xa2a4cbb5, 0x8c66, 0x4c0b, { 0x92, 0xf6, 0x6a, 0xc5, 0x3c, 0x0a, 0x1b, 0x10 }
+};
+
+//
+// Test GUID 2 {676CDA19-6862-44C6-9367-DA04F1B1A164}
+//
+EFI_GUID  mTestGuid2 = {
+  0x676cda19, 0x6862, 0x44c6, { 0x93, 0x67, 0xda, 0x04, 0xf1, 0xb1, 0xa1, 0x64 }
+};
+
+//
+// Test GUID 3 {3C5E0F7D-1B69-4E34-A0D5-7F3A9E2B6C81}
+//
+EFI_GUID  mTestGuid3 = {
+  0x3c5e0f7d, 0x1b69, 0x4e34, { 0xa0, 0xd5, 0x7f, 0x3a, 0x9e, 0x2b, 0x6c, 0x81 }
+};
+
+EFI_GUID  *mTestGuids[] = { &mTestGuid1, &mTestGuid2, &mTestGuid3 };
+
+VARIABLE_INDEX_TEST_CONTEXT  mAuthStoreContext = { TRUE, SIZE_512KB, 2000, sizeof (UINT32) };
+
+//
+// Variables smaller than VARIABLE_INDEX_AVERAGE_VARIABLE_SIZE, so the index
+// fills up before the store does.
+//
+VARIABLE_INDEX_TEST_CONTEXT  mFullIndexStoreContext = { FALSE, SIZE_4KB, 200, 0 };
+
+//
+// The indexed store and its unindexed twin.
+//
+VARIABLE_STORE_HEADER  *mIndexedStore;
+VARIABLE_STORE_HEADER  *mLinearStore;
+UINTN                  mStoreFreeOffset;
+BOOLEAN                mAuthFormat;
+UINT32                 mDataSize;
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Stub of the variable driver AtRuntime().
+
+  @retval FALSE  Always at boot time.
+
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+  Builds the name of test variable Number.
+
+  @param[out] Name    Buffer of TEST_VARIABLE_NAME_SIZE bytes.
+  @param[in]  Number  The variable number.
+
+**/
+VOID
+TestVariableName (
+  OUT CHAR16  *Name,
+  IN  UINTN   Number
+  )
+{
+  UnicodeSPrint (Name, TEST_VARIABLE_NAME_SIZE, L"Var%04u", Number);
+}
+
+/**
+  Erases both stores and formats them.
+
+  @param[in] Context  The store layout.
+
+**/
+VOID
+FormatStores (
+  IN VARIABLE_INDEX_TEST_CONTEXT  *Context
+  )
+{
+  SetMem (mIndexedStore, Context->StoreSize, 0xFF);
+  CopyGuid (&mIndexedStore->Signature, Context->AuthFormat ? &gEfiAuthenticatedVariableGuid : &gEfiVariableGuid);
+  mIndexedStore->Size      = Context->StoreSize;
+  mIndexedStore->Format    = VARIABLE_STORE_FORMATTED;
+  mIndexedStore->State     = VARIABLE_STORE_HEALTHY;
+  mIndexedStore->Reserved  = 0;
+  mIndexedStore->Reserved1 = 0;
+  CopyMem (mLinearStore, mIndexedStore, Context->StoreSize);
+
+  mStoreFreeOffset = (UINTN)GetStartPointer (mIndexedStore) - (UINTN)mIndexedStore;
+  mAuthFormat      = Context->AuthFormat;
+  mDataSize        = Context->DataSize;
+}
+
+/**
+  Appends a variable to both stores.
+
+  @param[in] Name   The variable name.
+  @param[in] Guid   The vendor GUID.
+  @param[in] State  The variable state.
+
+  @return Offset of the variable in the stores, or 0 if the stores are full.
+
+**/
+UINTN
+AppendVariable (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Guid,
+  IN UINT8     State
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  UINTN            Offset;
+  UINTN            NameSize;
+  UINT32           Data;
+
+  NameSize = StrSize (Name);
+  Data     = (UINT32)mStoreFreeOffset;
+  if (mStoreFreeOffset + GetVariableHeaderSize (mAuthFormat) + NameSize + mDataSize + 2 * HEADER_ALIGNMENT > mIndexedStore->Size) {
+    return 0;
+  }
+
+  Offset   = mStoreFreeOffset;
+  Variable = (VARIABLE_HEADER *)((UINTN)mIndexedStore + Offset);
+  ZeroMem (Variable, GetVariableHeaderSize (mAuthFormat));
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = State;
+  Variable->Attributes = TEST_VARIABLE_ATTRIBUTES;
+  SetNameSizeOfVariable (Variable, NameSize, mAuthFormat);
+  SetDataSizeOfVariable (Variable, mDataSize, mAuthFormat);
+  CopyGuid (GetVendorGuidPtr (Variable, mAuthFormat), Guid);
+  CopyMem (GetVariableNamePtr (Variable, mAuthFormat), Name, NameSize);
+  CopyMem (GetVariableDataPtr (Variable, mAuthFormat), &Data, MIN (mDataSize, sizeof (Data)));
+
+  mStoreFreeOffset = (UINTN)GetNextVariablePtr (Variable, mAuthFormat) - (UINTN)mIndexedStore;
+  CopyMem ((UINT8 *)mLinearStore + Offset, Variable, mStoreFreeOffset - Offset);
+  return Offset;
+}
+
+/**
+  Changes the state of a variable in both stores.
+
+  @param[in] Offset  Offset of the variable in the stores.
+  @param[in] State   The state bits to clear.
+
+**/
+VOID
+ClearVariableState (
+  IN UINTN  Offset,
+  IN UINT8  State
+  )
+{
+  ((VARIABLE_HEADER *)((UINTN)mIndexedStore + Offset))->State &= State;
+  ((VARIABLE_HEADER *)((UINTN)mLinearStore + Offset))->State  &= State;
+}
+
+/**
+  Looks a variable up in a store.
+
+  @param[in]  Store     The variable store.
+  @param[in]  Name      The variable name.
+  @param[in]  Guid      The vendor GUID.
+  @param[out] PtrTrack  The lookup result.
+
+  @return The status returned by FindVariableEx().
+
+**/
+EFI_STATUS
+LookUp (
+  IN  VARIABLE_STORE_HEADER   *Store,
+  IN  CHAR16                  *Name,
+  IN  EFI_GUID                *Guid,
+  OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  ZeroMem (PtrTrack, sizeof (*PtrTrack));
+  PtrTrack->StartPtr = GetStartPointer (Store);
+  PtrTrack->EndPtr   = GetEndPointer (Store);
+  return FindVariableEx (Name, Guid, FALSE, PtrTrack, mAuthFormat);
+}
+
+/**
+  Converts a variable pointer to an offset in its store.
+
+  @param[in] Store     The variable store.
+  @param[in] Variable  A variable of Store, or NULL.
+
+  @return The offset, or MAX_UINTN for NULL.
+
+**/
+UINTN
+OffsetOf (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN VARIABLE_HEADER        *Variable
+  )
+{
+  return (Variable == NULL) ? MAX_UINTN : (UINTN)Variable - (UINTN)Store;
+}
+
+/**
+  Checks that a variable is found at the same place in both stores.
+
+  @param[in] Name  The variable name.
+  @param[in] Guid  The vendor GUID.
+
+  @retval TRUE   The indexed and the linear lookups agree.
+  @retval FALSE  They differ.
+
+**/
+BOOLEAN
+LookUpsMatch (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Guid
+  )
+{
+  EFI_STATUS              IndexedStatus;
+  EFI_STATUS              LinearStatus;
+  VARIABLE_POINTER_TRACK  Indexed;
+  VARIABLE_POINTER_TRACK  Linear;
+
+  IndexedStatus = LookUp (mIndexedStore, Name, Guid, &Indexed);
+  LinearStatus  = LookUp (mLinearStore, Name, Guid, &Linear);
+  if (IndexedStatus != LinearStatus) {
+    UT_LOG_ERROR ("%s %g: indexed %r, linear %r\n", Name, Guid, IndexedStatus, LinearStatus);
+    return FALSE;
+  }
+
+  if (EFI_ERROR (IndexedStatus)) {
+    return TRUE;
+  }
+
+  if ((OffsetOf (mIndexedStore, Indexed.CurrPtr) != OffsetOf (mLinearStore, Linear.CurrPtr)) ||
+      (OffsetOf (mIndexedStore, Indexed.InDeletedTransitionPtr) != OffsetOf (mLinearStore, Linear.InDeletedTransitionPtr)))
+  {
+    UT_LOG_ERROR (
+      "%s %g: indexed 0x%lx/0x%lx, linear 0x%lx/0x%lx\n",
+      Name,
+      Guid,
+      (UINT64)OffsetOf (mIndexedStore, Indexed.CurrPtr),
+      (UINT64)OffsetOf (mIndexedStore, Indexed.InDeletedTransitionPtr),
+      (UINT64)OffsetOf (mLinearStore, Linear.CurrPtr),
+      (UINT64)OffsetOf (mLinearStore, Linear.InDeletedTransitionPtr)
+      );
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks every test variable name against every test GUID.
+
+  @param[in] VariableCount  Number of test variable names.
+
+  @retval TRUE   All indexed lookups match the linear ones.
+  @retval FALSE  At least one lookup differs.
+
+**/
+BOOLEAN
+AllLookUpsMatch (
+  IN UINTN  VariableCount
+  )
+{
+  CHAR16  Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN   Number;
+  UINTN   GuidIndex;
+
+  for (Number = 0; Number < VariableCount; Number++) {
+    TestVariableName (Name, Number);
+    for (GuidIndex = 0; GuidIndex < ARRAY_SIZE (mTestGuids); GuidIndex++) {
+      if (!LookUpsMatch (Name, mTestGuids[GuidIndex])) {
+        return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Fills the stores with variables in every state FindVariableEx() handles:
+  updated, deleted, interrupted updates and interrupted deletes.
+
+  @param[in] VariableCount  Number of test variable names.
+
+**/
+VOID
+PopulateStores (
+  IN UINTN  VariableCount
+  )
+{
+  CHAR16  Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN   Number;
+  UINTN   Offset;
+  UINTN   NewOffset;
+
+  for (Number = 0; Number < VariableCount; Number++) {
+    TestVariableName (Name, Number);
+    Offset = AppendVariable (Name, mTestGuids[Number % ARRAY_SIZE (mTestGuids)], VAR_ADDED);
+    if (Offset == 0) {
+      return;
+    }
+
+    if (Number % 5 == 0) {
+      //
+      // Completed update.
+      //
+      ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+      NewOffset = AppendVariable (Name, mTestGuids[Number % ARRAY_SIZE (mTestGuids)], VAR_ADDED);
+      if (NewOffset != 0) {
+        ClearVariableState (Offset, VAR_DELETED);
+      }
+    } else if (Number % 7 == 0) {
+      //
+      // Update interrupted before the old copy was deleted.
+      //
+      ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+      AppendVariable (Name, mTestGuids[Number % ARRAY_SIZE (mTestGuids)], VAR_ADDED);
+    } else if (Number % 11 == 0) {
+      ClearVariableState (Offset, VAR_DELETED);
+    } else if (Number % 13 == 0) {
+      //
+      // Update interrupted before the new copy was written.
+      //
+      ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+    }
+  }
+}
+
+/**
+  Allocates the test stores.
+
+  @param[in] Context  The store layout.
+
+  @retval UNIT_TEST_PASSED                      The stores are ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  Out of memory.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StoresSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_INDEX_TEST_CONTEXT  *TestContext;
+
+  TestContext   = (VARIABLE_INDEX_TEST_CONTEXT *)Context;
+  mIndexedStore = AllocatePool (TestContext->StoreSize);
+  mLinearStore  = AllocatePool (TestContext->StoreSize);
+  if ((mIndexedStore == NULL) || (mLinearStore == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  FormatStores (TestContext);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the test stores and their index.
+
+  @param[in] Context  The store layout.
+
+**/
+VOID
+EFIAPI
+StoresCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mIndexedStore != NULL) {
+    VariableIndexUnregister (mIndexedStore);
+    FreePool (mIndexedStore);
+    mIndexedStore = NULL;
+  }
+
+  if (mLinearStore != NULL) {
+    FreePool (mLinearStore);
+    mLinearStore = NULL;
+  }
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  Indexed lookups of a populated store must return what the linear search
+  returns, including the variables in delete transition.
+
+  @param[in] Context  The store layout.
+
+  @retval UNIT_TEST_PASSED             Lookups match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexedLookUpsShouldMatchLinearSearch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_INDEX_TEST_CONTEXT  *TestContext;
+
+  TestContext = (VARIABLE_INDEX_TEST_CONTEXT *)Context;
+  PopulateStores (TestContext->VariableCount);
+  UT_ASSERT_NOT_EFI_ERROR (VariableIndexRegister (mIndexedStore, mAuthFormat));
+
+  UT_ASSERT_TRUE (AllLookUpsMatch (TestContext->VariableCount));
+
+  //
+  // Second pass through the pruned index.
+  //
+  UT_ASSERT_TRUE (AllLookUpsMatch (TestContext->VariableCount));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Variables appended and deleted after the index was built must be found,
+  including the ones following a partially written variable.
+
+  @param[in] Context  The store layout.
+
+  @retval UNIT_TEST_PASSED             Lookups match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexShouldFollowStoreUpdates (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16  Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN   Offset;
+  UINTN   Partial;
+
+  UT_ASSERT_NOT_EFI_ERROR (VariableIndexRegister (mIndexedStore, mAuthFormat));
+
+  TestVariableName (Name, 1);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid1));
+  Offset = AppendVariable (Name, &mTestGuid1, VAR_ADDED);
+  UT_ASSERT_NOT_EQUAL (Offset, 0);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid1));
+
+  //
+  // Update it.
+  //
+  ClearVariableState (Offset, VAR_IN_DELETED_TRANSITION);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid1));
+  UT_ASSERT_NOT_EQUAL (AppendVariable (Name, &mTestGuid1, VAR_ADDED), 0);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid1));
+  ClearVariableState (Offset, VAR_DELETED);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid1));
+
+  //
+  // A variable whose header is written but not its data stops the indexing,
+  // the variables behind it must still be found.
+  //
+  TestVariableName (Name, 2);
+  Partial = AppendVariable (Name, &mTestGuid2, VAR_HEADER_VALID_ONLY);
+  UT_ASSERT_NOT_EQUAL (Partial, 0);
+  TestVariableName (Name, 3);
+  UT_ASSERT_NOT_EQUAL (AppendVariable (Name, &mTestGuid3, VAR_ADDED), 0);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid3));
+  TestVariableName (Name, 2);
+  UT_ASSERT_TRUE (LookUpsMatch (Name, &mTestGuid2));
+
+  ClearVariableState (Partial, VAR_ADDED);
+  UT_ASSERT_TRUE (AllLookUpsMatch (4));
+
+  ClearVariableState (Partial, VAR_DELETED);
+  UT_ASSERT_TRUE (AllLookUpsMatch (4));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  After the variables of the store moved and the index was invalidated, the
+  lookups must find the variables at their new place.
+
+  @param[in] Context  The store layout.
+
+  @retval UNIT_TEST_PASSED             Lookups match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+InvalidatedIndexShouldBeRebuilt (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_INDEX_TEST_CONTEXT  *TestContext;
+  CHAR16                       Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINTN                        Number;
+
+  TestContext = (VARIABLE_INDEX_TEST_CONTEXT *)Context;
+  PopulateStores (TestContext->VariableCount);
+  UT_ASSERT_NOT_EFI_ERROR (VariableIndexRegister (mIndexedStore, mAuthFormat));
+  UT_ASSERT_TRUE (AllLookUpsMatch (TestContext->VariableCount));
+
+  //
+  // Reclaim: rewrite the store with the variables in reverse order.
+  //
+  FormatStores (TestContext);
+  for (Number = TestContext->VariableCount; Number > 0; Number--) {
+    TestVariableName (Name, Number - 1);
+    if (AppendVariable (Name, mTestGuids[(Number - 1) % ARRAY_SIZE (mTestGuids)], VAR_ADDED) == 0) {
+      break;
+    }
+  }
+
+  VariableIndexInvalidate (mIndexedStore);
+  UT_ASSERT_TRUE (AllLookUpsMatch (TestContext->VariableCount));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reports the time taken by indexed and linear lookups. Speed is not asserted
+  since it depends on the host.
+
+  @param[in] Context  The store layout.
+
+  @retval UNIT_TEST_PASSED             Lookups match.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookUpBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_INDEX_TEST_CONTEXT  *TestContext;
+  CHAR16                       Name[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  VARIABLE_POINTER_TRACK       PtrTrack;
+  VARIABLE_STORE_HEADER        *Stores[2];
+  clock_t                      Elapsed[2];
+  UINTN                        StoreIndex;
+  UINTN                        Number;
+  UINTN                        GuidIndex;
+
+  TestContext = (VARIABLE_INDEX_TEST_CONTEXT *)Context;
+  PopulateStores (TestContext->VariableCount);
+  UT_ASSERT_NOT_EFI_ERROR (VariableIndexRegister (mIndexedStore, mAuthFormat));
+  UT_ASSERT_TRUE (AllLookUpsMatch (TestContext->VariableCount));
+
+  Stores[0] = mIndexedStore;
+  Stores[1] = mLinearStore;
+  for (StoreIndex = 0; StoreIndex < ARRAY_SIZE (Stores); StoreIndex++) {
+    Elapsed[StoreIndex] = clock ();
+    for (Number = 0; Number < TestContext->VariableCount; Number++) {
+      TestVariableName (Name, Number);
+      for (GuidIndex = 0; GuidIndex < ARRAY_SIZE (mTestGuids); GuidIndex++) {
+        LookUp (Stores[StoreIndex], Name, mTestGuids[GuidIndex], &PtrTrack);
+      }
+    }
+
+    Elapsed[StoreIndex] = clock () - Elapsed[StoreIndex];
+  }
+
+  UT_LOG_INFO (
+    "%d lookups: indexed %d us, linear %d us\n",
+    (INT32)(TestContext->VariableCount * ARRAY_SIZE (mTestGuids)),
+    (INT32)((UINT64)Elapsed[0] * 1000000 / CLOCKS_PER_SEC),
+    (INT32)((UINT64)Elapsed[1] * 1000000 / CLOCKS_PER_SEC)
+    );
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  variable store index and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "Variable Store Index Tests", "VarIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Indexed lookups should match the linear search", "LookUps", IndexedLookUpsShouldMatchLinearSearch, StoresSetup, StoresCleanup, &mAuthStoreContext);
+  AddTestCase (IndexTests, "Lookups past a full index should match the linear search", "FullIndex", IndexedLookUpsShouldMatchLinearSearch, StoresSetup, StoresCleanup, &mFullIndexStoreContext);
+  AddTestCase (IndexTests, "The index should follow variable writes", "Updates", IndexShouldFollowStoreUpdates, StoresSetup, StoresCleanup, &mAuthStoreContext);
+  AddTestCase (IndexTests, "An invalidated index should be rebuilt", "Reclaim", InvalidatedIndexShouldBeRebuilt, StoresSetup, StoresCleanup, &mAuthStoreContext);
+  AddTestCase (IndexTests, "Indexed and linear lookup timing", "Benchmark", LookUpBenchmark, StoresSetup, StoresCleanup, &mAuthStoreContext);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
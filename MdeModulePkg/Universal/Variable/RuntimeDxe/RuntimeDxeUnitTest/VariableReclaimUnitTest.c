@@ -0,0 +1,425 @@
+/** @file
+  This is a host-based unit test for the write of the reclaimed variable store.
+
+  With PcdVariableIncrementalReclaim, FtwVariableSpace() must skip the leading
+  blocks of the store that the reclaim did not change, and write the rest of
+  the store through a single fault tolerant write.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../Variable.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "Variable Reclaim Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_BLOCK_SIZE         SIZE_4KB
+#define TEST_NUMBER_OF_BLOCKS   8
+#define TEST_FV_HEADER_LENGTH   (sizeof (EFI_FIRMWARE_VOLUME_HEADER) + sizeof (EFI_FV_BLOCK_MAP_ENTRY))
+#define TEST_STORE_SIZE         (TEST_BLOCK_SIZE * TEST_NUMBER_OF_BLOCKS - TEST_FV_HEADER_LENGTH)
+#define TEST_STORE_UNCHANGED    MAX_UINTN
+
+typedef struct {
+  //
+  // Offset in the store of the byte the reclaim changes, or TEST_STORE_UNCHANGED.
+  //
+  UINTN      ChangeOffset;
+  //
+  // The expected start of the fault tolerant write, and the number of blocks
+  // it covers.
+  //
+  EFI_LBA    Lba;
+  UINTN      Offset;
+  UINTN      BlocksWritten;
+} RECLAIM_TEST_CONTEXT;
+
+/// === TEST DATA ==================================================================================
+
+RECLAIM_TEST_CONTEXT  mUnchangedContext   = { TEST_STORE_UNCHANGED, 0, 0, 0 };
+RECLAIM_TEST_CONTEXT  mFirstBlockContext  = { sizeof (VARIABLE_STORE_HEADER), 0, TEST_FV_HEADER_LENGTH, TEST_NUMBER_OF_BLOCKS };
+RECLAIM_TEST_CONTEXT  mMiddleBlockContext = { 3 * TEST_BLOCK_SIZE - TEST_FV_HEADER_LENGTH, 3, 0, TEST_NUMBER_OF_BLOCKS - 3 };
+RECLAIM_TEST_CONTEXT  mLastBlockContext   = { TEST_STORE_SIZE - 1, TEST_NUMBER_OF_BLOCKS - 1, 0, 1 };
+
+//
+// The flash of the NV storage FV, and the store the reclaim rebuilt.
+//
+UINT8                  *mFlash;
+VARIABLE_STORE_HEADER  *mReclaimedStore;
+
+//
+// The fault tolerant writes made.
+//
+UINTN    mFtwWriteCount;
+EFI_LBA  mFtwWriteLba;
+UINTN    mFtwWriteOffset;
+UINTN    mFtwWriteLength;
+
+EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  mFvb;
+EFI_FAULT_TOLERANT_WRITE_PROTOCOL   mFtw;
+
+/// === STUBS ======================================================================================
+
+/**
+  Returns the base address of the FV.
+
+  @param[in]  This     The FVB protocol.
+  @param[out] Address  The base address of the FV.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbGetPhysicalAddress (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  OUT       EFI_PHYSICAL_ADDRESS                 *Address
+  )
+{
+  *Address = (EFI_PHYSICAL_ADDRESS)(UINTN)mFlash;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the size of the blocks of the FV.
+
+  @param[in]  This            The FVB protocol.
+  @param[in]  Lba             The block.
+  @param[out] BlockSize       The size of the block.
+  @param[out] NumberOfBlocks  The number of blocks from Lba on.
+
+  @retval EFI_SUCCESS            The block is in the FV.
+  @retval EFI_INVALID_PARAMETER  The block is past the end of the FV.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFvbGetBlockSize (
+  IN CONST  EFI_FIRMWARE_VOLUME_BLOCK2_PROTOCOL  *This,
+  IN        EFI_LBA                              Lba,
+  OUT       UINTN                                *BlockSize,
+  OUT       UINTN                                *NumberOfBlocks
+  )
+{
+  if (Lba >= TEST_NUMBER_OF_BLOCKS) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *BlockSize      = TEST_BLOCK_SIZE;
+  *NumberOfBlocks = TEST_NUMBER_OF_BLOCKS - (UINTN)Lba;
+  return EFI_SUCCESS;
+}
+
+/**
+  Records a fault tolerant write and applies it to the flash.
+
+  @param[in] This         The FTW protocol.
+  @param[in] Lba          The first block to write.
+  @param[in] Offset       The offset in the first block.
+  @param[in] Length       The number of bytes to write.
+  @param[in] PrivateData  Unused.
+  @param[in] FvbHandle    The handle of the FVB protocol.
+  @param[in] Buffer       The data to write.
+
+  @retval EFI_SUCCESS            The data is written.
+  @retval EFI_INVALID_PARAMETER  The write is not within the FV.
+
+**/
+EFI_STATUS
+EFIAPI
+StubFtwWrite (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  IN EFI_LBA                            Lba,
+  IN UINTN                              Offset,
+  IN UINTN                              Length,
+  IN VOID                               *PrivateData,
+  IN EFI_HANDLE                         FvbHandle,
+  IN VOID                               *Buffer
+  )
+{
+  if ((FvbHandle != (EFI_HANDLE)&mFvb) || (Offset >= TEST_BLOCK_SIZE) ||
+      ((UINTN)Lba * TEST_BLOCK_SIZE + Offset + Length > TEST_NUMBER_OF_BLOCKS * TEST_BLOCK_SIZE))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  mFtwWriteCount++;
+  mFtwWriteLba    = Lba;
+  mFtwWriteOffset = Offset;
+  mFtwWriteLength = Length;
+  CopyMem (mFlash + (UINTN)Lba * TEST_BLOCK_SIZE + Offset, Buffer, Length);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the variable driver GetFtwProtocol().
+
+  @param[out] FtwProtocol  The FTW protocol.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+GetFtwProtocol (
+  OUT VOID  **FtwProtocol
+  )
+{
+  *FtwProtocol = &mFtw;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the variable driver GetFvbInfoByAddress().
+
+  @param[in]  Address      The flash address.
+  @param[out] FvbHandle    The handle of the FVB protocol.
+  @param[out] FvbProtocol  The FVB protocol.
+
+  @retval EFI_SUCCESS    Address is in the FV.
+  @retval EFI_NOT_FOUND  Address is outside the FV.
+
+**/
+EFI_STATUS
+GetFvbInfoByAddress (
+  IN  EFI_PHYSICAL_ADDRESS                Address,
+  OUT EFI_HANDLE                          *FvbHandle OPTIONAL,
+  OUT EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  **FvbProtocol OPTIONAL
+  )
+{
+  if ((Address < (UINTN)mFlash) || (Address >= (UINTN)mFlash + TEST_NUMBER_OF_BLOCKS * TEST_BLOCK_SIZE)) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (FvbHandle != NULL) {
+    *FvbHandle = (EFI_HANDLE)&mFvb;
+  }
+
+  if (FvbProtocol != NULL) {
+    *FvbProtocol = &mFvb;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Formats the flash with a store full of data, and copies the store to the
+  reclaimed store.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The flash is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  Out of memory.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FlashSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  VARIABLE_STORE_HEADER       *Store;
+  UINTN                       Index;
+
+  mFlash          = AllocatePool (TEST_NUMBER_OF_BLOCKS * TEST_BLOCK_SIZE);
+  mReclaimedStore = AllocatePool (TEST_STORE_SIZE);
+  if ((mFlash == NULL) || (mReclaimedStore == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)mFlash;
+  ZeroMem (FvHeader, TEST_FV_HEADER_LENGTH);
+  CopyGuid (&FvHeader->FileSystemGuid, &gEfiSystemNvDataFvGuid);
+  FvHeader->FvLength              = TEST_NUMBER_OF_BLOCKS * TEST_BLOCK_SIZE;
+  FvHeader->Signature             = EFI_FVH_SIGNATURE;
+  FvHeader->HeaderLength          = TEST_FV_HEADER_LENGTH;
+  FvHeader->Revision              = EFI_FVH_REVISION;
+  FvHeader->BlockMap[0].NumBlocks = TEST_NUMBER_OF_BLOCKS;
+  FvHeader->BlockMap[0].Length    = TEST_BLOCK_SIZE;
+
+  Store = (VARIABLE_STORE_HEADER *)(mFlash + TEST_FV_HEADER_LENGTH);
+  for (Index = sizeof (VARIABLE_STORE_HEADER); Index < TEST_STORE_SIZE; Index++) {
+    ((UINT8 *)Store)[Index] = (UINT8)(Index * 7);
+  }
+
+  CopyGuid (&Store->Signature, &gEfiVariableGuid);
+  Store->Size      = TEST_STORE_SIZE;
+  Store->Format    = VARIABLE_STORE_FORMATTED;
+  Store->State     = VARIABLE_STORE_HEALTHY;
+  Store->Reserved  = 0;
+  Store->Reserved1 = 0;
+  CopyMem (mReclaimedStore, Store, TEST_STORE_SIZE);
+
+  ZeroMem (&mFvb, sizeof (mFvb));
+  mFvb.GetPhysicalAddress = StubFvbGetPhysicalAddress;
+  mFvb.GetBlockSize       = StubFvbGetBlockSize;
+  ZeroMem (&mFtw, sizeof (mFtw));
+  mFtw.Write = StubFtwWrite;
+
+  mFtwWriteCount  = 0;
+  mFtwWriteLba    = 0;
+  mFtwWriteOffset = 0;
+  mFtwWriteLength = 0;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the flash and the reclaimed store.
+
+  @param[in] Context  Unused.
+
+**/
+VOID
+EFIAPI
+FlashCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (mFlash != NULL) {
+    FreePool (mFlash);
+    mFlash = NULL;
+  }
+
+  if (mReclaimedStore != NULL) {
+    FreePool (mReclaimedStore);
+    mReclaimedStore = NULL;
+  }
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  The write of the reclaimed store must start at the block holding the first
+  change, end at the end of the store, and leave the flash holding the
+  reclaimed store. Nothing is written if nothing changed.
+
+  @param[in] Context  The change made by the reclaim and the expected write.
+
+  @retval UNIT_TEST_PASSED             The expected blocks were written.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The write differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ReclaimShouldOnlyWriteChangedBlocks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  RECLAIM_TEST_CONTEXT  *TestContext;
+  UINTN                 BytesWritten;
+  UINTN                 BlocksWritten;
+
+  UT_ASSERT_TRUE (FeaturePcdGet (PcdVariableIncrementalReclaim));
+
+  TestContext = (RECLAIM_TEST_CONTEXT *)Context;
+  if (TestContext->ChangeOffset != TEST_STORE_UNCHANGED) {
+    ((UINT8 *)mReclaimedStore)[TestContext->ChangeOffset] ^= 0xFF;
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (
+    FtwVariableSpace ((EFI_PHYSICAL_ADDRESS)(UINTN)(mFlash + TEST_FV_HEADER_LENGTH), mReclaimedStore, &BytesWritten, &BlocksWritten)
+    );
+  UT_ASSERT_MEM_EQUAL (mFlash + TEST_FV_HEADER_LENGTH, mReclaimedStore, TEST_STORE_SIZE);
+  UT_ASSERT_EQUAL (BlocksWritten, TestContext->BlocksWritten);
+
+  if (TestContext->ChangeOffset == TEST_STORE_UNCHANGED) {
+    UT_ASSERT_EQUAL (mFtwWriteCount, 0);
+    UT_ASSERT_EQUAL (BytesWritten, 0);
+    return UNIT_TEST_PASSED;
+  }
+
+  UT_ASSERT_EQUAL (mFtwWriteCount, 1);
+  UT_ASSERT_EQUAL (mFtwWriteLba, TestContext->Lba);
+  UT_ASSERT_EQUAL (mFtwWriteOffset, TestContext->Offset);
+  UT_ASSERT_EQUAL (mFtwWriteLength, TEST_NUMBER_OF_BLOCKS * TEST_BLOCK_SIZE - ((UINTN)TestContext->Lba * TEST_BLOCK_SIZE + TestContext->Offset));
+  UT_ASSERT_EQUAL (BytesWritten, mFtwWriteLength);
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the write of
+  the reclaimed variable store and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ReclaimTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ReclaimTests, Framework, "Variable Reclaim Tests", "VarReclaim", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ReclaimTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ReclaimTests, "An unchanged store should not be written", "Unchanged", ReclaimShouldOnlyWriteChangedBlocks, FlashSetup, FlashCleanup, &mUnchangedContext);
+  AddTestCase (ReclaimTests, "A change in the first block should write the whole store", "FirstBlock", ReclaimShouldOnlyWriteChangedBlocks, FlashSetup, FlashCleanup, &mFirstBlockContext);
+  AddTestCase (ReclaimTests, "A change in a middle block should write from that block on", "MiddleBlock", ReclaimShouldOnlyWriteChangedBlocks, FlashSetup, FlashCleanup, &mMiddleBlockContext);
+  AddTestCase (ReclaimTests, "A change in the last block should only write that block", "LastBlock", ReclaimShouldOnlyWriteChangedBlocks, FlashSetup, FlashCleanup, &mLastBlockContext);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
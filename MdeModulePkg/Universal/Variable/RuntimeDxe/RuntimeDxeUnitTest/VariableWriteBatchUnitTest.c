@@ -0,0 +1,661 @@
+/** @file
+  This is a host-based unit test for the variable write batches.
+
+  The NV variable cache is updated the way UpdateVariable() does while a batch
+  is open, then the batch is committed to a simulated flash that can only
+  clear bits. Every prefix of the flash writes, i.e. every point a power
+  failure could hit, must leave each variable either updated or unchanged.
+
+  Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "../VariableParsing.h"
+#include "../VariableRuntimeCache.h"
+#include "../VariableWriteBatch.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "Variable Write Batch Unit Test"
+#define UNIT_TEST_VERSION  "1.0"
+
+#define TEST_STORE_SIZE           SIZE_4KB
+#define TEST_MAX_WRITES           64
+#define TEST_VARIABLE_NAME_SIZE   32
+#define TEST_VARIABLE_ATTRIBUTES  (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)
+
+///
+/// One write to the simulated flash.
+///
+typedef struct {
+  UINTN    Offset;
+  UINTN    Size;
+  UINT8    Data[TEST_STORE_SIZE];
+} FLASH_WRITE;
+
+///
+/// The values a variable may hold after a power failure during the commit.
+/// A value of 0 stands for a deleted variable.
+///
+typedef struct {
+  CHAR16    *Name;
+  UINT32    OldValue;
+  UINT32    NewValue;
+} EXPECTED_VARIABLE;
+
+/// === TEST DATA ==================================================================================
+
+//
+// Test GUID {D4B0C7A8-5E2F-4B61-9C3D-1A7E6F8B2C90}
+//
+EFI_GUID  mTestGuid = {
+  0xd4b0c7a8, 0x5e2f, 0x4b61, { 0x9c, 0x3d, 0x1a, 0x7e, 0x6f, 0x8b, 0x2c, 0x90 }
+};
+
+//
+// Globals of the variable driver used by the write batch.
+//
+VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
+VARIABLE_STORE_HEADER   *mNvVariableCache;
+
+//
+// The simulated flash, its content before the commit and the writes it got.
+//
+UINT8        *mFlash;
+UINT8        *mFlashBefore;
+FLASH_WRITE  *mFlashWrites;
+UINTN        mFlashWriteCount;
+UINTN        mFlashWritesUntilFailure;
+BOOLEAN      mFlashBitSet;
+BOOLEAN      mReclaimCalled;
+
+EXPECTED_VARIABLE  mExpectedVariables[] = {
+  { L"Updated",      1, 3 },
+  { L"Deleted",      1, 0 },
+  { L"Unchanged",    1, 1 },
+  { L"Added",        0, 1 },
+  { L"AddedDeleted", 0, 0 }
+};
+
+/// === HELPER FUNCTIONS ===========================================================================
+
+/**
+  Stub of the variable driver AtRuntime().
+
+  @retval FALSE  Always at boot time.
+
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the variable driver AcquireLockOnlyAtBootTime().
+
+  @param[in] Lock  The lock.
+
+**/
+VOID
+AcquireLockOnlyAtBootTime (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+/**
+  Stub of the variable driver ReleaseLockOnlyAtBootTime().
+
+  @param[in] Lock  The lock.
+
+**/
+VOID
+ReleaseLockOnlyAtBootTime (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+/**
+  Stub of SynchronizeRuntimeVariableCache(). There is no runtime cache.
+
+  @param[in] VariableRuntimeCache  The runtime cache.
+  @param[in] Offset                Offset of the update.
+  @param[in] Length                Length of the update.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCache (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  UINTN                   Offset,
+  IN  UINTN                   Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of Reclaim() that only reloads the NV variable cache from flash.
+
+  @param[in]      VariableBase        Base address of the variable store.
+  @param[out]     LastVariableOffset  Unused.
+  @param[in]      IsVolatile          Unused.
+  @param[in, out] UpdatingPtrTrack    Unused.
+  @param[in]      NewVariable         Unused.
+  @param[in]      NewVariableSize     Unused.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+Reclaim (
+  IN     EFI_PHYSICAL_ADDRESS    VariableBase,
+  OUT    UINTN                   *LastVariableOffset,
+  IN     BOOLEAN                 IsVolatile,
+  IN OUT VARIABLE_POINTER_TRACK  *UpdatingPtrTrack,
+  IN     VARIABLE_HEADER         *NewVariable,
+  IN     UINTN                   NewVariableSize
+  )
+{
+  mReclaimCalled = TRUE;
+  CopyMem (mNvVariableCache, mFlash, TEST_STORE_SIZE);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of UpdateVariableStore() writing the simulated flash. Like the real
+  one, it does not write while a write batch is open.
+
+  @param[in] Global        Pointer to VARAIBLE_GLOBAL structure.
+  @param[in] Volatile      Must be FALSE.
+  @param[in] SetByIndex    TRUE if target pointer is given as index.
+  @param[in] Fvb           Unused.
+  @param[in] DataPtrIndex  Pointer to the data, or its offset in the store.
+  @param[in] DataSize      Size of data to be written.
+  @param[in] Buffer        Pointer to the buffer from which data is written.
+
+  @retval EFI_SUCCESS       The data was written.
+  @retval EFI_DEVICE_ERROR  The write failure injected by the test.
+
+**/
+EFI_STATUS
+UpdateVariableStore (
+  IN  VARIABLE_GLOBAL                     *Global,
+  IN  BOOLEAN                             Volatile,
+  IN  BOOLEAN                             SetByIndex,
+  IN  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb,
+  IN  UINTN                               DataPtrIndex,
+  IN  UINT32                              DataSize,
+  IN  UINT8                               *Buffer
+  )
+{
+  FLASH_WRITE  *Write;
+  UINTN        Index;
+
+  if (VariableWriteBatchIsActive ()) {
+    return EFI_SUCCESS;
+  }
+
+  if (mFlashWritesUntilFailure != 0) {
+    mFlashWritesUntilFailure--;
+    if (mFlashWritesUntilFailure == 0) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  if (mFlashWriteCount == TEST_MAX_WRITES) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Write         = &mFlashWrites[mFlashWriteCount++];
+  Write->Offset = SetByIndex ? DataPtrIndex : DataPtrIndex - (UINTN)mFlash;
+  Write->Size   = DataSize;
+  CopyMem (Write->Data, Buffer, DataSize);
+
+  for (Index = 0; Index < DataSize; Index++) {
+    if ((mFlash[Write->Offset + Index] & Buffer[Index]) != Buffer[Index]) {
+      mFlashBitSet = TRUE;
+    }
+
+    mFlash[Write->Offset + Index] &= Buffer[Index];
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Appends a variable to the NV variable cache.
+
+  @param[in] Name   The variable name.
+  @param[in] Value  The variable data.
+
+  @return The variable in the NV variable cache.
+
+**/
+VARIABLE_HEADER *
+AppendVariable (
+  IN CHAR16  *Name,
+  IN UINT32  Value
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  BOOLEAN          AuthFormat;
+  UINTN            NameSize;
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  NameSize   = StrSize (Name);
+  Variable   = (VARIABLE_HEADER *)((UINTN)mNvVariableCache + mVariableModuleGlobal->NonVolatileLastVariableOffset);
+  ZeroMem (Variable, GetVariableHeaderSize (AuthFormat));
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = VAR_ADDED;
+  Variable->Attributes = TEST_VARIABLE_ATTRIBUTES;
+  SetNameSizeOfVariable (Variable, NameSize, AuthFormat);
+  SetDataSizeOfVariable (Variable, sizeof (Value), AuthFormat);
+  CopyGuid (GetVendorGuidPtr (Variable, AuthFormat), &mTestGuid);
+  CopyMem (GetVariableNamePtr (Variable, AuthFormat), Name, NameSize);
+  CopyMem (GetVariableDataPtr (Variable, AuthFormat), &Value, sizeof (Value));
+
+  mVariableModuleGlobal->NonVolatileLastVariableOffset = (UINTN)GetNextVariablePtr (Variable, AuthFormat) - (UINTN)mNvVariableCache;
+  return Variable;
+}
+
+/**
+  Looks a variable up in a variable store.
+
+  @param[in] Store  The variable store.
+  @param[in] Name   The variable name.
+
+  @return The variable data, or 0 if the variable is not found.
+
+**/
+UINT32
+GetValue (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN CHAR16                 *Name
+  )
+{
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  BOOLEAN                 AuthFormat;
+  CHAR16                  VariableName[TEST_VARIABLE_NAME_SIZE / sizeof (CHAR16)];
+  UINT32                  Value;
+
+  //
+  // FindVariableEx() compares as many bytes as the name of each variable in
+  // the store holds, so the name is padded.
+  //
+  ZeroMem (VariableName, sizeof (VariableName));
+  CopyMem (VariableName, Name, StrSize (Name));
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  ZeroMem (&PtrTrack, sizeof (PtrTrack));
+  PtrTrack.StartPtr = GetStartPointer (Store);
+  PtrTrack.EndPtr   = GetEndPointer (Store);
+  if (EFI_ERROR (FindVariableEx (VariableName, &mTestGuid, FALSE, &PtrTrack, AuthFormat))) {
+    return 0;
+  }
+
+  CopyMem (&Value, GetVariableDataPtr (PtrTrack.CurrPtr, AuthFormat), sizeof (Value));
+  return Value;
+}
+
+/**
+  Updates the NV variable cache the way UpdateVariable() does while a write
+  batch is open, going from the old to the new values of mExpectedVariables.
+
+**/
+VOID
+UpdateVariables (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Original;
+  VARIABLE_HEADER  *Updated;
+  VARIABLE_HEADER  *Deleted;
+  VARIABLE_HEADER  *AddedDeleted;
+
+  Original = GetStartPointer (mNvVariableCache);
+  Deleted  = GetNextVariablePtr (Original, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+
+  //
+  // Updated twice, the intermediate copy is only ever in the cache.
+  //
+  Original->State &= VAR_IN_DELETED_TRANSITION;
+  Updated          = AppendVariable (L"Updated", 2);
+  Original->State &= VAR_DELETED;
+  Updated->State  &= VAR_IN_DELETED_TRANSITION;
+  AppendVariable (L"Updated", 3);
+  Updated->State &= VAR_DELETED;
+
+  Deleted->State &= VAR_DELETED;
+
+  AppendVariable (L"Added", 1);
+  AddedDeleted         = AppendVariable (L"AddedDeleted", 1);
+  AddedDeleted->State &= VAR_DELETED;
+}
+
+/**
+  Checks the variables of a store against mExpectedVariables.
+
+  @param[in] Store           The variable store.
+  @param[in] AllowOldValues  TRUE if the variables may still hold their old values.
+
+  @retval TRUE   Each variable holds an expected value.
+  @retval FALSE  A variable holds another value.
+
+**/
+BOOLEAN
+VariablesMatch (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN BOOLEAN                AllowOldValues
+  )
+{
+  UINTN   Index;
+  UINT32  Value;
+
+  for (Index = 0; Index < ARRAY_SIZE (mExpectedVariables); Index++) {
+    Value = GetValue (Store, mExpectedVariables[Index].Name);
+    if ((Value != mExpectedVariables[Index].NewValue) &&
+        (!AllowOldValues || (Value != mExpectedVariables[Index].OldValue)))
+    {
+      UT_LOG_ERROR ("%s: unexpected value %d\n", mExpectedVariables[Index].Name, Value);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Formats the NV variable cache, adds the variables with their old values and
+  copies the cache to the simulated flash.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED                      The stores are ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  Out of memory.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StoresSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mVariableModuleGlobal = AllocateZeroPool (sizeof (*mVariableModuleGlobal));
+  mNvVariableCache      = AllocatePool (TEST_STORE_SIZE);
+  mFlash                = AllocatePool (TEST_STORE_SIZE);
+  mFlashBefore          = AllocatePool (TEST_STORE_SIZE);
+  mFlashWrites          = AllocatePool (TEST_MAX_WRITES * sizeof (FLASH_WRITE));
+  if ((mVariableModuleGlobal == NULL) || (mNvVariableCache == NULL) || (mFlash == NULL) ||
+      (mFlashBefore == NULL) || (mFlashWrites == NULL))
+  {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  SetMem (mNvVariableCache, TEST_STORE_SIZE, 0xFF);
+  CopyGuid (&mNvVariableCache->Signature, &gEfiAuthenticatedVariableGuid);
+  mNvVariableCache->Size      = TEST_STORE_SIZE;
+  mNvVariableCache->Format    = VARIABLE_STORE_FORMATTED;
+  mNvVariableCache->State     = VARIABLE_STORE_HEALTHY;
+  mNvVariableCache->Reserved  = 0;
+  mNvVariableCache->Reserved1 = 0;
+
+  mVariableModuleGlobal->VariableGlobal.AuthFormat              = TRUE;
+  mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase = (EFI_PHYSICAL_ADDRESS)(UINTN)mFlash;
+  mVariableModuleGlobal->NonVolatileLastVariableOffset          = (UINTN)GetStartPointer (mNvVariableCache) - (UINTN)mNvVariableCache;
+
+  AppendVariable (L"Updated", 1);
+  AppendVariable (L"Deleted", 1);
+  AppendVariable (L"Unchanged", 1);
+
+  CopyMem (mFlash, mNvVariableCache, TEST_STORE_SIZE);
+  CopyMem (mFlashBefore, mFlash, TEST_STORE_SIZE);
+  mFlashWriteCount         = 0;
+  mFlashWritesUntilFailure = 0;
+  mFlashBitSet             = FALSE;
+  mReclaimCalled           = FALSE;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the stores.
+
+  @param[in] Context  Unused.
+
+**/
+VOID
+EFIAPI
+StoresCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (VariableWriteBatchIsActive ()) {
+    VariableWriteBatchCommit (NULL);
+  }
+
+  FreePool (mVariableModuleGlobal);
+  FreePool (mNvVariableCache);
+  FreePool (mFlash);
+  FreePool (mFlashBefore);
+  FreePool (mFlashWrites);
+}
+
+/// === TEST CASES =================================================================================
+
+/**
+  Updates made during a write batch must reach the flash on commit only.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The flash holds the cache content.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The flash differs.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CommitShouldWriteTheCacheToFlash (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchBegin (NULL));
+  UpdateVariables ();
+  UT_ASSERT_TRUE (VariablesMatch ((VARIABLE_STORE_HEADER *)mFlash, TRUE));
+  UT_ASSERT_EQUAL (mFlashWriteCount, 0);
+
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchCommit (NULL));
+  UT_ASSERT_FALSE (VariableWriteBatchIsActive ());
+  UT_ASSERT_FALSE (mFlashBitSet);
+  UT_ASSERT_MEM_EQUAL (mFlash, mNvVariableCache, TEST_STORE_SIZE);
+  UT_ASSERT_TRUE (VariablesMatch (mNvVariableCache, FALSE));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A power failure between any two flash writes of a commit must leave each
+  variable with its old or its new value.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             Every intermediate flash content is valid.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A variable holds another value.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CommitShouldSurvivePowerFailures (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  WriteCount;
+  UINTN  Index;
+  UINTN  Byte;
+
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchBegin (NULL));
+  UpdateVariables ();
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchCommit (NULL));
+  UT_ASSERT_NOT_EQUAL (mFlashWriteCount, 0);
+
+  for (WriteCount = 0; WriteCount <= mFlashWriteCount; WriteCount++) {
+    CopyMem (mFlash, mFlashBefore, TEST_STORE_SIZE);
+    for (Index = 0; Index < WriteCount; Index++) {
+      for (Byte = 0; Byte < mFlashWrites[Index].Size; Byte++) {
+        mFlash[mFlashWrites[Index].Offset + Byte] &= mFlashWrites[Index].Data[Byte];
+      }
+    }
+
+    UT_LOG_INFO ("Power failure after %d of %d writes\n", (INT32)WriteCount, (INT32)mFlashWriteCount);
+    UT_ASSERT_TRUE (VariablesMatch ((VARIABLE_STORE_HEADER *)mFlash, WriteCount < mFlashWriteCount));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A failed flash write must end the batch and bring the cache back in sync
+  with the flash.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The batch was ended and the store reclaimed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The batch is still open.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FailedCommitShouldEndTheBatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchBegin (NULL));
+  UpdateVariables ();
+  mFlashWritesUntilFailure = 2;
+  UT_ASSERT_STATUS_EQUAL (VariableWriteBatchCommit (NULL), EFI_DEVICE_ERROR);
+  UT_ASSERT_FALSE (VariableWriteBatchIsActive ());
+  UT_ASSERT_TRUE (mReclaimCalled);
+  UT_ASSERT_MEM_EQUAL (mFlash, mNvVariableCache, TEST_STORE_SIZE);
+  UT_ASSERT_TRUE (VariablesMatch (mNvVariableCache, TRUE));
+  UT_ASSERT_STATUS_EQUAL (VariableWriteBatchCommit (NULL), EFI_NOT_STARTED);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Begin() and Commit() must only be accepted in the right order, and Begin()
+  must be refused once the batches are ended for the OS. This test case must
+  run last.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The calls returned the expected status.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A call returned another status.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BeginAndCommitShouldBePaired (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_STATUS_EQUAL (VariableWriteBatchCommit (NULL), EFI_NOT_STARTED);
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchBegin (NULL));
+  UT_ASSERT_TRUE (VariableWriteBatchIsActive ());
+  UT_ASSERT_STATUS_EQUAL (VariableWriteBatchBegin (NULL), EFI_ALREADY_STARTED);
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchCommit (NULL));
+  UT_ASSERT_STATUS_EQUAL (VariableWriteBatchCommit (NULL), EFI_NOT_STARTED);
+
+  UT_ASSERT_NOT_EFI_ERROR (VariableWriteBatchBegin (NULL));
+  UpdateVariables ();
+  VariableWriteBatchEndForOs ();
+  UT_ASSERT_FALSE (VariableWriteBatchIsActive ());
+  UT_ASSERT_MEM_EQUAL (mFlash, mNvVariableCache, TEST_STORE_SIZE);
+  UT_ASSERT_STATUS_EQUAL (VariableWriteBatchBegin (NULL), EFI_UNSUPPORTED);
+  return UNIT_TEST_PASSED;
+}
+
+/// === TEST ENGINE ================================================================================
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  variable write batches and run the unit tests.
+
+**/
+VOID
+EFIAPI
+UnitTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      WriteBatchTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&WriteBatchTests, Framework, "Variable Write Batch Tests", "VarWriteBatch", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for WriteBatchTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (WriteBatchTests, "Commit should write the cache to flash", "Commit", CommitShouldWriteTheCacheToFlash, StoresSetup, StoresCleanup, NULL);
+  AddTestCase (WriteBatchTests, "Commit should survive power failures", "PowerFailure", CommitShouldSurvivePowerFailures, StoresSetup, StoresCleanup, NULL);
+  AddTestCase (WriteBatchTests, "A failed commit should end the batch", "WriteFailure", FailedCommitShouldEndTheBatch, StoresSetup, StoresCleanup, NULL);
+  AddTestCase (WriteBatchTests, "Begin and commit should be paired", "Pairing", BeginAndCommitShouldBePaired, StoresSetup, StoresCleanup, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define Main  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+Main (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestMain ();
+  return 0;
+}
@@ -28,7 +28,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "Variable.h"
 #include "VariableNonVolatile.h"
 #include "VariableParsing.h"
+#include "VariableIndex.h"
 #include "VariableRuntimeCache.h"
+#include "VariableWriteBatch.h"
 
 VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 
@@ -168,6 +170,14 @@ UpdateVariableStore (
     if ((DataPtr + DataSize) > (FvVolHdr + mNvFvHeaderCache->FvLength)) {
       return EFI_OUT_OF_RESOURCES;
     }
+
+    if (VariableWriteBatchIsActive ()) {
+      //
+      // The caller updates the NV variable cache, and VariableWriteBatchFlush ()
+      // writes it to flash later.
+      //
+      return EFI_SUCCESS;
+    }
   } else {
     //
     // Data Pointer should point to the actual Address where data is to be
@@ -545,7 +555,23 @@ Reclaim (
   VARIABLE_HEADER        *UpdatingVariable;
   VARIABLE_HEADER        *UpdatingInDeletedTransition;
   BOOLEAN                AuthFormat;
+  UINT64                 StartTicks;
+  UINT64                 Time;
+  UINTN                  BytesWritten;
+  UINTN                  BlocksWritten;
+
+  if (!IsVolatile && VariableWriteBatchIsActive ()) {
+    //
+    // The variables are read from flash below, so write the staged updates
+    // there first.
+    //
+    Status = VariableWriteBatchFlush ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
 
+  StartTicks                  = GetPerformanceCounter ();
   AuthFormat                  = mVariableModuleGlobal->VariableGlobal.AuthFormat;
   UpdatingVariable            = NULL;
   UpdatingInDeletedTransition = NULL;
@@ -760,13 +786,29 @@ Reclaim (
     //
     Status = FtwVariableSpace (
                VariableBase,
-               (VARIABLE_STORE_HEADER *)ValidBuffer
+               (VARIABLE_STORE_HEADER *)ValidBuffer,
+               &BytesWritten,
+               &BlocksWritten
                );
     if (!EFI_ERROR (Status)) {
       *LastVariableOffset                                = (UINTN)CurrPtr - (UINTN)ValidBuffer;
       mVariableModuleGlobal->HwErrVariableTotalSize      = HwErrVariableTotalSize;
       mVariableModuleGlobal->CommonVariableTotalSize     = CommonVariableTotalSize;
       mVariableModuleGlobal->CommonUserVariableTotalSize = CommonUserVariableTotalSize;
+
+      Time = GetTimeInNanoSecond (GetPerformanceCounter () - StartTicks);
+      mVariableModuleGlobal->ReclaimStatistics.Count++;
+      mVariableModuleGlobal->ReclaimStatistics.Time          += Time;
+      mVariableModuleGlobal->ReclaimStatistics.BytesWritten  += BytesWritten;
+      mVariableModuleGlobal->ReclaimStatistics.BlocksWritten += BlocksWritten;
+      DEBUG ((
+        DEBUG_INFO,
+        "Variable: Reclaim wrote 0x%Lx of 0x%x bytes (%Lu blocks) in %Lu us\n",
+        (UINT64)BytesWritten,
+        VariableStoreHeader->Size,
+        (UINT64)BlocksWritten,
+        DivU64x32 (Time, 1000)
+        ));
     } else {
       mVariableModuleGlobal->HwErrVariableTotalSize      = 0;
       mVariableModuleGlobal->CommonVariableTotalSize     = 0;
@@ -792,6 +834,13 @@ Reclaim (
   }
 
 Done:
+  //
+  // The variables have moved, so the index of the store and of its runtime
+  // cache copy must be rebuilt.
+  //
+  VariableIndexInvalidate (IsVolatile ? (VARIABLE_STORE_HEADER *)(UINTN)VariableBase : mNvVariableCache);
+  mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingReclaim = TRUE;
+
   DoneStatus = EFI_SUCCESS;
   if (IsVolatile || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     DoneStatus = SynchronizeRuntimeVariableCache (
@@ -3258,6 +3307,15 @@ ReclaimForOS (
                );
     ASSERT_EFI_ERROR (Status);
   }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Variable: %u reclaims this boot, %Lu us, 0x%Lx bytes in %Lu blocks written\n",
+    mVariableModuleGlobal->ReclaimStatistics.Count,
+    DivU64x32 (mVariableModuleGlobal->ReclaimStatistics.Time, 1000),
+    mVariableModuleGlobal->ReclaimStatistics.BytesWritten,
+    mVariableModuleGlobal->ReclaimStatistics.BlocksWritten
+    ));
 }
 
 /**
@@ -3410,6 +3468,7 @@ FlushHobVariableToFlash (
         *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.HobFlushComplete) = TRUE;
       }
 
+      VariableIndexUnregister (VariableStoreHeader);
       if (!AtRuntime ()) {
         FreePool ((VOID *)VariableStoreHeader);
       }
@@ -3809,6 +3868,15 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved  = 0;
   VolatileVariableStore->Reserved1 = 0;
 
+  //
+  // Index the variable stores. A store without an index is searched linearly.
+  //
+  VariableIndexRegister (VolatileVariableStore, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  VariableIndexRegister (mNvVariableCache, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  if (mVariableModuleGlobal->VariableGlobal.HobVariableBase != 0) {
+    VariableIndexRegister ((VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+  }
+
   return EFI_SUCCESS;
 }
 
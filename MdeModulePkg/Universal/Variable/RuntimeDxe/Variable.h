@@ -33,6 +33,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/VarCheckLib.h>
 #include <Library/VariableFlashInfoLib.h>
 #include <Library/SafeIntLib.h>
+#include <Library/TimerLib.h>
 #include <Guid/GlobalVariable.h>
 #include <Guid/EventGroup.h>
 #include <Guid/VariableFormat.h>
@@ -71,6 +72,8 @@ typedef struct {
   BOOLEAN                   *ReadLock;
   BOOLEAN                   *PendingUpdate;
   BOOLEAN                   *HobFlushComplete;
+  UINT32                    *ReclaimCount;
+  BOOLEAN                   PendingReclaim;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeHobCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeNvCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeVolatileCache;
@@ -102,6 +105,17 @@ typedef struct {
   BOOLEAN                           EmuNvMode;
 } VARIABLE_GLOBAL;
 
+///
+/// Cost of the reclaims of the non-volatile variable store in this boot.
+/// It is only reported through DEBUG messages.
+///
+typedef struct {
+  UINT32    Count;         ///< Number of reclaims written to flash.
+  UINT64    Time;          ///< Time spent in these reclaims, in nanoseconds.
+  UINT64    BytesWritten;  ///< Bytes written through FTW.
+  UINT64    BlocksWritten; ///< Flash blocks written through FTW.
+} VARIABLE_RECLAIM_STATISTICS;
+
 typedef struct {
   VARIABLE_GLOBAL                       VariableGlobal;
   UINTN                                 VolatileLastVariableOffset;
@@ -121,6 +135,7 @@ typedef struct {
   CHAR8                                 *PlatformLang;
   CHAR8                                 Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL    *FvbInstance;
+  VARIABLE_RECLAIM_STATISTICS           ReclaimStatistics;
 } VARIABLE_MODULE_GLOBAL;
 
 /**
@@ -145,6 +160,8 @@ FlushHobVariableToFlash (
 
   @param  VariableBase   Base address of the variable to write.
   @param  VariableBuffer Point to the variable data buffer.
+  @param  BytesWritten   Return the number of bytes written through FTW.
+  @param  BlocksWritten  Return the number of flash blocks written through FTW.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -153,8 +170,10 @@ FlushHobVariableToFlash (
 **/
 EFI_STATUS
 FtwVariableSpace (
-  IN EFI_PHYSICAL_ADDRESS   VariableBase,
-  IN VARIABLE_STORE_HEADER  *VariableBuffer
+  IN  EFI_PHYSICAL_ADDRESS   VariableBase,
+  IN  VARIABLE_STORE_HEADER  *VariableBuffer,
+  OUT UINTN                  *BytesWritten,
+  OUT UINTN                  *BlocksWritten
   );
 
 /**
@@ -377,6 +396,65 @@ ReclaimForOS (
   VOID
   );
 
+/**
+
+  This function writes data to the FWH at the correct LBA even if the LBAs
+  are fragmented.
+
+  @param Global                  Pointer to VARAIBLE_GLOBAL structure.
+  @param Volatile                Point out the Variable is Volatile or Non-Volatile.
+  @param SetByIndex              TRUE if target pointer is given as index.
+                                 FALSE if target pointer is absolute.
+  @param Fvb                     Pointer to the writable FVB protocol.
+  @param DataPtrIndex            Pointer to the Data from the end of VARIABLE_STORE_HEADER
+                                 structure.
+  @param DataSize                Size of data to be written.
+  @param Buffer                  Pointer to the buffer from which data is written.
+
+  @retval EFI_INVALID_PARAMETER  Parameters not valid.
+  @retval EFI_UNSUPPORTED        Fvb is a NULL for Non-Volatile variable update.
+  @retval EFI_OUT_OF_RESOURCES   The remaining size is not enough.
+  @retval EFI_SUCCESS            Variable store successfully updated.
+
+**/
+EFI_STATUS
+UpdateVariableStore (
+  IN  VARIABLE_GLOBAL                     *Global,
+  IN  BOOLEAN                             Volatile,
+  IN  BOOLEAN                             SetByIndex,
+  IN  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb,
+  IN  UINTN                               DataPtrIndex,
+  IN  UINT32                              DataSize,
+  IN  UINT8                               *Buffer
+  );
+
+/**
+
+  Variable store garbage collection and reclaim operation.
+
+  @param[in]      VariableBase            Base address of variable store.
+  @param[out]     LastVariableOffset      Offset of last variable.
+  @param[in]      IsVolatile              The variable store is volatile or not;
+                                          if it is non-volatile, need FTW.
+  @param[in, out] UpdatingPtrTrack        Pointer to updating variable pointer track structure.
+  @param[in]      NewVariable             Pointer to new variable.
+  @param[in]      NewVariableSize         New variable size.
+
+  @return EFI_SUCCESS                  Reclaim operation has finished successfully.
+  @return EFI_OUT_OF_RESOURCES         No enough memory resources or variable space.
+  @return Others                       Unexpect error happened during reclaim operation.
+
+**/
+EFI_STATUS
+Reclaim (
+  IN     EFI_PHYSICAL_ADDRESS    VariableBase,
+  OUT    UINTN                   *LastVariableOffset,
+  IN     BOOLEAN                 IsVolatile,
+  IN OUT VARIABLE_POINTER_TRACK  *UpdatingPtrTrack,
+  IN     VARIABLE_HEADER         *NewVariable,
+  IN     UINTN                   NewVariableSize
+  );
+
 /**
   Get maximum variable size, covering both non-volatile and volatile variables.
 
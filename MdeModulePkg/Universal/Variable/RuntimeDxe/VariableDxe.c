@@ -11,6 +11,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
 #include "Variable.h"
+#include "VariableIndex.h"
+#include "VariableWriteBatch.h"
 
 #include <Protocol/VariablePolicy.h>
 #include <Library/VariablePolicyLib.h>
@@ -41,6 +43,11 @@ EDKII_VAR_CHECK_PROTOCOL        mVarCheck = {
   VarCheckVariablePropertyGet
 };
 
+EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  mVariableWriteBatch = {
+  VariableWriteBatchBegin,
+  VariableWriteBatchCommit
+};
+
 /**
   Some Secure Boot Policy Variable may update following other variable changes(SecureBoot follows PK change, etc).
   Record their initial State when variable write service is ready.
@@ -265,6 +272,7 @@ VariableClassAddressChangeEvent (
   EfiConvertPointer (0x0, (VOID **)&mVariableModuleGlobal);
   EfiConvertPointer (0x0, (VOID **)&mNvVariableCache);
   EfiConvertPointer (0x0, (VOID **)&mNvFvHeaderCache);
+  VariableIndexConvertPointers (EfiConvertPointer);
 
   if (mAuthContextOut.AddressPointer != NULL) {
     for (Index = 0; Index < mAuthContextOut.AddressPointerCount; Index++) {
@@ -315,6 +323,7 @@ OnReadyToBoot (
     InitializeVariableQuota ();
   }
 
+  VariableWriteBatchEndForOs ();
   ReclaimForOS ();
   if (FeaturePcdGet (PcdVariableCollectStatistics)) {
     if (mVariableModuleGlobal->VariableGlobal.AuthFormat) {
@@ -327,6 +336,27 @@ OnReadyToBoot (
   gBS->CloseEvent (Event);
 }
 
+/**
+  Notification function of EVT_SIGNAL_EXIT_BOOT_SERVICES event group.
+
+  This is a notification function registered on EVT_SIGNAL_EXIT_BOOT_SERVICES event group.
+  It checks that no variable update is still staged in memory. The write batch is
+  committed at ReadyToBoot, when FTW can still write to flash.
+
+  @param  Event        Event whose notification function is being invoked.
+  @param  Context      Pointer to the notification function's context.
+
+**/
+VOID
+EFIAPI
+OnExitBootServices (
+  EFI_EVENT  Event,
+  VOID       *Context
+  )
+{
+  ASSERT (!VariableWriteBatchIsActive ());
+}
+
 /**
   Notification function of EFI_END_OF_DXE_EVENT_GROUP_GUID event group.
 
@@ -394,6 +424,14 @@ VariableWriteServiceInitializeDxe (
                   NULL
                   );
   ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &mHandle,
+                  &gEdkiiVariableWriteBatchProtocolGuid,
+                  &mVariableWriteBatch,
+                  NULL
+                  );
+  ASSERT_EFI_ERROR (Status);
 }
 
 /**
@@ -540,6 +578,7 @@ VariableServiceInitialize (
 {
   EFI_STATUS  Status;
   EFI_EVENT   ReadyToBootEvent;
+  EFI_EVENT   ExitBootServicesEvent;
   EFI_EVENT   EndOfDxeEvent;
 
   Status = VariableCommonInitialize ();
@@ -616,6 +655,19 @@ VariableServiceInitialize (
              );
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Register the event handling function to check no variable update is still staged.
+  //
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  OnExitBootServices,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &ExitBootServicesEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Register the event handling function to set the End Of DXE flag.
   //
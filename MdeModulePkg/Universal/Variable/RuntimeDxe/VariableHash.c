@@ -0,0 +1,49 @@
+/** @file
+  Hash of the name and vendor GUID of a variable. The PEI variable driver
+  builds this file too, so that both drivers hash variables the same way.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableHash.h"
+
+#define FNV_OFFSET_BASIS  0x811C9DC5
+#define FNV_PRIME         0x01000193
+
+/**
+  Hashes a variable name and vendor GUID with FNV-1a: the characters of the
+  name up to the null terminator, followed by the bytes of the GUID.
+
+  @param[in] Name      The variable name.
+  @param[in] NameSize  Maximum size of Name in bytes. The hash stops at the
+                       first null character.
+  @param[in] Guid      The vendor GUID.
+
+  @return The hash value.
+
+**/
+UINT32
+GetVariableHash (
+  IN CONST CHAR16    *Name,
+  IN UINTN           NameSize,
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32       Hash;
+  UINTN        Index;
+  CONST UINT8  *Bytes;
+
+  Hash = FNV_OFFSET_BASIS;
+  for (Index = 0; Index < NameSize / sizeof (CHAR16) && Name[Index] != 0; Index++) {
+    Hash = (Hash ^ Name[Index]) * FNV_PRIME;
+  }
+
+  Bytes = (CONST UINT8 *)Guid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Bytes[Index]) * FNV_PRIME;
+  }
+
+  return Hash;
+}
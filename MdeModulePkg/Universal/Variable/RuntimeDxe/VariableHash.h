@@ -0,0 +1,34 @@
+/** @file
+  Hash of the name and vendor GUID of a variable, shared by the PEI and the
+  DXE variable drivers to index their variable stores.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VARIABLE_HASH_H_
+#define _VARIABLE_HASH_H_
+
+#include <Uefi/UefiBaseType.h>
+
+/**
+  Hashes a variable name and vendor GUID with FNV-1a: the characters of the
+  name up to the null terminator, followed by the bytes of the GUID.
+
+  @param[in] Name      The variable name.
+  @param[in] NameSize  Maximum size of Name in bytes. The hash stops at the
+                       first null character.
+  @param[in] Guid      The vendor GUID.
+
+  @return The hash value.
+
+**/
+UINT32
+GetVariableHash (
+  IN CONST CHAR16    *Name,
+  IN UINTN           NameSize,
+  IN CONST EFI_GUID  *Guid
+  );
+
+#endif
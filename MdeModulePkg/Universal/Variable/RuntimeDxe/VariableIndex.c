@@ -0,0 +1,433 @@
+/** @file
+  Hash index of the variables in a variable store.
+
+  Caution: This module requires additional review when modified.
+  This driver will have external input - variable data. They may be input in SMM mode.
+  This external input must be validated carefully to avoid security issue like
+  buffer overflow, integer overflow.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableParsing.h"
+#include "VariableIndex.h"
+
+typedef struct {
+  ///
+  /// Offset of the variable header from the start of the store
+  ///
+  UINT32    Offset;
+  UINT32    Hash;
+  ///
+  /// Index + 1 of the next entry of the bucket or of the free list, 0 ends the list
+  ///
+  UINT32    Next;
+} VARIABLE_INDEX_ENTRY;
+
+typedef struct {
+  VARIABLE_STORE_HEADER    *Store;
+  VARIABLE_INDEX_ENTRY     *Entries;
+  UINT32                   *Buckets;
+  UINT32                   BucketMask;
+  UINT32                   EntryCount;
+  ///
+  /// Number of entries handed out since the index was last invalidated
+  ///
+  UINT32                   UsedCount;
+  UINT32                   FreeList;
+  ///
+  /// Offset from the start of the store of the first header that is not indexed
+  ///
+  UINT32                   IndexedEnd;
+} VARIABLE_INDEX;
+
+//
+// One index per store type is all a variable module needs.
+//
+VARIABLE_INDEX  mVariableIndexTable[VariableStoreTypeMax];
+
+/**
+  Returns the index of the store that starts at StartPtr.
+
+  @param[in] StartPtr  The first variable of the store.
+
+  @return The index, or NULL if the store has none.
+
+**/
+VARIABLE_INDEX *
+VariableIndexGet (
+  IN VARIABLE_HEADER  *StartPtr
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mVariableIndexTable); Index++) {
+    if ((mVariableIndexTable[Index].Store != NULL) &&
+        (GetStartPointer (mVariableIndexTable[Index].Store) == StartPtr))
+    {
+      return &mVariableIndexTable[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Indexes the variables appended to the store since the last call.
+
+  The walk stops at the first variable that has not been completely added,
+  since its name may still change, and when the index is full. Variables from
+  that point on are left to the linear search.
+
+  @param[in] Index       The index to update.
+  @param[in] EndPtr      The end of the store.
+  @param[in] AuthFormat  TRUE indicates authenticated variables are used.
+                         FALSE indicates authenticated variables are not used.
+
+**/
+VOID
+VariableIndexUpdate (
+  IN VARIABLE_INDEX   *Index,
+  IN VARIABLE_HEADER  *EndPtr,
+  IN BOOLEAN          AuthFormat
+  )
+{
+  VARIABLE_HEADER  *StartPtr;
+  VARIABLE_HEADER  *Variable;
+  UINT32           EntryIndex;
+  UINT32           Hash;
+
+  StartPtr = GetStartPointer (Index->Store);
+  Variable = (VARIABLE_HEADER *)((UINTN)StartPtr + Index->IndexedEnd);
+
+  while (IsValidVariableHeader (Variable, EndPtr)) {
+    if ((Variable->State & VAR_ADDED) != Variable->State) {
+      break;
+    }
+
+    if ((Variable->State == VAR_ADDED) ||
+        (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)))
+    {
+      if (Index->FreeList != 0) {
+        EntryIndex      = Index->FreeList - 1;
+        Index->FreeList = Index->Entries[EntryIndex].Next;
+      } else if (Index->UsedCount < Index->EntryCount) {
+        EntryIndex = Index->UsedCount++;
+      } else {
+        break;
+      }
+
+      Hash = GetVariableHash (
+               GetVariableNamePtr (Variable, AuthFormat),
+               NameSizeOfVariable (Variable, AuthFormat),
+               GetVendorGuidPtr (Variable, AuthFormat)
+               );
+      Index->Entries[EntryIndex].Offset        = (UINT32)((UINTN)Variable - (UINTN)StartPtr);
+      Index->Entries[EntryIndex].Hash          = Hash;
+      Index->Entries[EntryIndex].Next          = Index->Buckets[Hash & Index->BucketMask];
+      Index->Buckets[Hash & Index->BucketMask] = EntryIndex + 1;
+    }
+
+    Variable          = GetNextVariablePtr (Variable, AuthFormat);
+    Index->IndexedEnd = (UINT32)((UINTN)Variable - (UINTN)StartPtr);
+  }
+}
+
+/**
+  Checks whether a variable is visible and has the given name and GUID, the
+  same way FindVariableEx() does.
+
+  @param[in] Variable       The variable to check.
+  @param[in] VariableName   Name of the variable to be found.
+  @param[in] VendorGuid     Vendor GUID to be found.
+  @param[in] IgnoreRtCheck  Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                            check at runtime when searching variable.
+  @param[in] AuthFormat     TRUE indicates authenticated variables are used.
+                            FALSE indicates authenticated variables are not used.
+
+  @retval TRUE   The variable matches.
+  @retval FALSE  The variable does not match.
+
+**/
+BOOLEAN
+VariableIndexMatch (
+  IN VARIABLE_HEADER  *Variable,
+  IN CHAR16           *VariableName,
+  IN EFI_GUID         *VendorGuid,
+  IN BOOLEAN          IgnoreRtCheck,
+  IN BOOLEAN          AuthFormat
+  )
+{
+  if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+    return FALSE;
+  }
+
+  if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat))) {
+    return FALSE;
+  }
+
+  ASSERT (NameSizeOfVariable (Variable, AuthFormat) != 0);
+  return (BOOLEAN)(CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSizeOfVariable (Variable, AuthFormat)) == 0);
+}
+
+/**
+  Creates the index of a variable store and indexes the variables it holds.
+  If the store already has an index, that index is rebuilt.
+
+  @param[in] Store       The variable store.
+  @param[in] AuthFormat  TRUE indicates authenticated variables are used.
+                         FALSE indicates authenticated variables are not used.
+
+  @retval EFI_SUCCESS           The index was created.
+  @retval EFI_INVALID_PARAMETER Store is NULL.
+  @retval EFI_OUT_OF_RESOURCES  No index slot or memory is left. The store is
+                                searched linearly.
+
+**/
+EFI_STATUS
+VariableIndexRegister (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN BOOLEAN                AuthFormat
+  )
+{
+  VARIABLE_INDEX  *Index;
+  UINTN           Slot;
+  UINT32          EntryCount;
+  UINT32          BucketCount;
+
+  if (Store == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Index = VariableIndexGet (GetStartPointer (Store));
+  if (Index == NULL) {
+    for (Slot = 0; Slot < ARRAY_SIZE (mVariableIndexTable); Slot++) {
+      if (mVariableIndexTable[Slot].Store == NULL) {
+        Index = &mVariableIndexTable[Slot];
+        break;
+      }
+    }
+
+    if (Index == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    EntryCount  = MAX (Store->Size / VARIABLE_INDEX_AVERAGE_VARIABLE_SIZE, 1);
+    BucketCount = GetPowerOfTwo32 (EntryCount);
+
+    Index->Entries = AllocateRuntimeZeroPool (EntryCount * sizeof (VARIABLE_INDEX_ENTRY));
+    Index->Buckets = AllocateRuntimeZeroPool (BucketCount * sizeof (UINT32));
+    if ((Index->Entries == NULL) || (Index->Buckets == NULL)) {
+      if (Index->Entries != NULL) {
+        FreePool (Index->Entries);
+      }
+
+      if (Index->Buckets != NULL) {
+        FreePool (Index->Buckets);
+      }
+
+      ZeroMem (Index, sizeof (VARIABLE_INDEX));
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Index->Store      = Store;
+    Index->EntryCount = EntryCount;
+    Index->BucketMask = BucketCount - 1;
+  }
+
+  VariableIndexInvalidate (Store);
+  VariableIndexUpdate (Index, GetEndPointer (Store), AuthFormat);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Deletes the index of a variable store.
+
+  @param[in] Store  The variable store.
+
+**/
+VOID
+VariableIndexUnregister (
+  IN VARIABLE_STORE_HEADER  *Store
+  )
+{
+  VARIABLE_INDEX  *Index;
+
+  if (Store == NULL) {
+    return;
+  }
+
+  Index = VariableIndexGet (GetStartPointer (Store));
+  if (Index == NULL) {
+    return;
+  }
+
+  //
+  // Pool cannot be freed at runtime. The slot is cleared either way.
+  //
+  if (!AtRuntime ()) {
+    FreePool (Index->Entries);
+    FreePool (Index->Buckets);
+  }
+
+  ZeroMem (Index, sizeof (VARIABLE_INDEX));
+}
+
+/**
+  Forgets the content of the index of a variable store, which is rebuilt by
+  the next lookup. Must be called whenever variables of the store are moved.
+
+  @param[in] Store  The variable store, or NULL for all stores.
+
+**/
+VOID
+VariableIndexInvalidate (
+  IN VARIABLE_STORE_HEADER  *Store  OPTIONAL
+  )
+{
+  UINTN           Slot;
+  VARIABLE_INDEX  *Index;
+
+  for (Slot = 0; Slot < ARRAY_SIZE (mVariableIndexTable); Slot++) {
+    Index = &mVariableIndexTable[Slot];
+    if ((Index->Store == NULL) || ((Store != NULL) && (Index->Store != Store))) {
+      continue;
+    }
+
+    ZeroMem (Index->Buckets, (Index->BucketMask + 1) * sizeof (UINT32));
+    Index->UsedCount  = 0;
+    Index->FreeList   = 0;
+    Index->IndexedEnd = 0;
+  }
+}
+
+/**
+  Converts the pointers of all indexes for the virtual address map.
+
+  @param[in] ConvertPointer  Function converting one pointer, EfiConvertPointer().
+
+**/
+VOID
+VariableIndexConvertPointers (
+  IN VARIABLE_INDEX_CONVERT_POINTER  ConvertPointer
+  )
+{
+  UINTN  Slot;
+
+  for (Slot = 0; Slot < ARRAY_SIZE (mVariableIndexTable); Slot++) {
+    if (mVariableIndexTable[Slot].Store != NULL) {
+      ConvertPointer (0x0, (VOID **)&mVariableIndexTable[Slot].Store);
+      ConvertPointer (0x0, (VOID **)&mVariableIndexTable[Slot].Entries);
+      ConvertPointer (0x0, (VOID **)&mVariableIndexTable[Slot].Buckets);
+    }
+  }
+}
+
+/**
+  Looks up a variable in the indexed part of a variable store.
+
+  @param[in]       VariableName        Name of the variable to be found, not an empty string.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+  @param[out]      InDeletedVariable   The last matching variable in delete transition
+                                       that was found in the indexed part of the store.
+  @param[out]      ScanStart           The first variable that is not indexed. It is
+                                       PtrTrack->StartPtr if the store has no index.
+
+  @retval EFI_SUCCESS    An added variable was found. PtrTrack->CurrPtr and
+                         PtrTrack->InDeletedTransitionPtr are set as FindVariableEx() does.
+  @retval EFI_NOT_FOUND  No added variable was found in the indexed part of the store.
+
+**/
+EFI_STATUS
+VariableIndexFind (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat,
+  OUT    VARIABLE_HEADER         **InDeletedVariable,
+  OUT    VARIABLE_HEADER         **ScanStart
+  )
+{
+  VARIABLE_INDEX   *Index;
+  UINT32           Hash;
+  UINT32           *Link;
+  UINT32           EntryIndex;
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *Added;
+  VARIABLE_HEADER  *InDeleted;
+
+  *InDeletedVariable = NULL;
+  *ScanStart         = PtrTrack->StartPtr;
+
+  Index = VariableIndexGet (PtrTrack->StartPtr);
+  if (Index == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  VariableIndexUpdate (Index, PtrTrack->EndPtr, AuthFormat);
+
+  //
+  // Of the matching variables, FindVariableEx() returns the first added one,
+  // along with the last one in delete transition that precedes it.
+  //
+  Hash      = GetVariableHash (VariableName, MAX_UINTN, VendorGuid);
+  Added     = NULL;
+  InDeleted = NULL;
+  Link      = &Index->Buckets[Hash & Index->BucketMask];
+  while (*Link != 0) {
+    EntryIndex = *Link - 1;
+    Variable   = (VARIABLE_HEADER *)((UINTN)PtrTrack->StartPtr + Index->Entries[EntryIndex].Offset);
+    if ((Variable->State != VAR_ADDED) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      //
+      // Deleted since it was indexed, it can never match again.
+      //
+      *Link                           = Index->Entries[EntryIndex].Next;
+      Index->Entries[EntryIndex].Next = Index->FreeList;
+      Index->FreeList                 = EntryIndex + 1;
+      continue;
+    }
+
+    if ((Index->Entries[EntryIndex].Hash == Hash) &&
+        VariableIndexMatch (Variable, VariableName, VendorGuid, IgnoreRtCheck, AuthFormat))
+    {
+      if (Variable->State == VAR_ADDED) {
+        if ((Added == NULL) || (Variable < Added)) {
+          Added = Variable;
+        }
+      }
+    }
+
+    Link = &Index->Entries[EntryIndex].Next;
+  }
+
+  for (EntryIndex = Index->Buckets[Hash & Index->BucketMask]; EntryIndex != 0; EntryIndex = Index->Entries[EntryIndex - 1].Next) {
+    Variable = (VARIABLE_HEADER *)((UINTN)PtrTrack->StartPtr + Index->Entries[EntryIndex - 1].Offset);
+    if ((Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) &&
+        ((Added == NULL) || (Variable < Added)) &&
+        ((InDeleted == NULL) || (Variable > InDeleted)) &&
+        (Index->Entries[EntryIndex - 1].Hash == Hash) &&
+        VariableIndexMatch (Variable, VariableName, VendorGuid, IgnoreRtCheck, AuthFormat))
+    {
+      InDeleted = Variable;
+    }
+  }
+
+  if (Added != NULL) {
+    PtrTrack->CurrPtr                = Added;
+    PtrTrack->InDeletedTransitionPtr = InDeleted;
+    return EFI_SUCCESS;
+  }
+
+  *InDeletedVariable = InDeleted;
+  *ScanStart         = (VARIABLE_HEADER *)((UINTN)PtrTrack->StartPtr + Index->IndexedEnd);
+  return EFI_NOT_FOUND;
+}
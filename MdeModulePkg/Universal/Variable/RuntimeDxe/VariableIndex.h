@@ -0,0 +1,135 @@
+/** @file
+  Hash index of the variables in a variable store.
+
+  An index maps the name and GUID of the variables in one store to their
+  offsets, so FindVariableEx() does not have to walk the whole store. Variables
+  are only ever appended to a store or moved to a later state between two
+  reclaims, so the index is brought up to date lazily: every lookup first
+  indexes the headers appended since the previous lookup and drops entries
+  whose variable has been deleted. Whoever rewrites a store, i.e. Reclaim(),
+  must call VariableIndexInvalidate().
+
+  The index is only a shortcut. Every candidate is checked against the store
+  content, and the part of the store that has not been indexed (when the index
+  is full or a variable is only partially written) is searched linearly.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VARIABLE_INDEX_H_
+#define _VARIABLE_INDEX_H_
+
+#include "Variable.h"
+#include "VariableHash.h"
+
+///
+/// Typical variable size used to size the index of a store. Variables past the
+/// capacity of the index are found by a linear search.
+///
+#define VARIABLE_INDEX_AVERAGE_VARIABLE_SIZE  64
+
+/**
+  Pointer conversion function used by VariableIndexConvertPointers(). It
+  matches EfiConvertPointer().
+
+  @param[in]      DebugDisposition  Supplies type information for the pointer being converted.
+  @param[in, out] Address           The pointer to a pointer that is to be fixed.
+
+  @retval EFI_SUCCESS  The pointer was converted.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *VARIABLE_INDEX_CONVERT_POINTER)(
+  IN     UINTN  DebugDisposition,
+  IN OUT VOID   **Address
+  );
+
+/**
+  Creates the index of a variable store and indexes the variables it holds.
+  If the store already has an index, that index is rebuilt.
+
+  @param[in] Store       The variable store.
+  @param[in] AuthFormat  TRUE indicates authenticated variables are used.
+                         FALSE indicates authenticated variables are not used.
+
+  @retval EFI_SUCCESS           The index was created.
+  @retval EFI_INVALID_PARAMETER Store is NULL.
+  @retval EFI_OUT_OF_RESOURCES  No index slot or memory is left. The store is
+                                searched linearly.
+
+**/
+EFI_STATUS
+VariableIndexRegister (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN BOOLEAN                AuthFormat
+  );
+
+/**
+  Deletes the index of a variable store.
+
+  @param[in] Store  The variable store.
+
+**/
+VOID
+VariableIndexUnregister (
+  IN VARIABLE_STORE_HEADER  *Store
+  );
+
+/**
+  Forgets the content of the index of a variable store, which is rebuilt by
+  the next lookup. Must be called whenever variables of the store are moved.
+
+  @param[in] Store  The variable store, or NULL for all stores.
+
+**/
+VOID
+VariableIndexInvalidate (
+  IN VARIABLE_STORE_HEADER  *Store  OPTIONAL
+  );
+
+/**
+  Converts the pointers of all indexes for the virtual address map.
+
+  @param[in] ConvertPointer  Function converting one pointer, EfiConvertPointer().
+
+**/
+VOID
+VariableIndexConvertPointers (
+  IN VARIABLE_INDEX_CONVERT_POINTER  ConvertPointer
+  );
+
+/**
+  Looks up a variable in the indexed part of a variable store.
+
+  @param[in]       VariableName        Name of the variable to be found, not an empty string.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+  @param[out]      InDeletedVariable   The last matching variable in delete transition
+                                       that was found in the indexed part of the store.
+  @param[out]      ScanStart           The first variable that is not indexed. It is
+                                       PtrTrack->StartPtr if the store has no index.
+
+  @retval EFI_SUCCESS    An added variable was found. PtrTrack->CurrPtr and
+                         PtrTrack->InDeletedTransitionPtr are set as FindVariableEx() does.
+  @retval EFI_NOT_FOUND  No added variable was found in the indexed part of the store.
+
+**/
+EFI_STATUS
+VariableIndexFind (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat,
+  OUT    VARIABLE_HEADER         **InDeletedVariable,
+  OUT    VARIABLE_HEADER         **ScanStart
+  );
+
+#endif
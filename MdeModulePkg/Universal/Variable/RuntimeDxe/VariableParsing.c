@@ -8,6 +8,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
 
 #include "VariableParsing.h"
+#include "VariableIndex.h"
 
 /**
 
@@ -469,6 +470,7 @@ FindVariableEx (
   )
 {
   VARIABLE_HEADER  *InDeletedVariable;
+  VARIABLE_HEADER  *ScanStart;
   VOID             *Point;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
@@ -477,8 +479,18 @@ FindVariableEx (
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
   InDeletedVariable = NULL;
+  ScanStart         = PtrTrack->StartPtr;
 
-  for ( PtrTrack->CurrPtr = PtrTrack->StartPtr
+  //
+  // Only the part of the store that is not covered by its index is walked.
+  //
+  if (VariableName[0] != 0) {
+    if (!EFI_ERROR (VariableIndexFind (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, AuthFormat, &InDeletedVariable, &ScanStart))) {
+      return EFI_SUCCESS;
+    }
+  }
+
+  for ( PtrTrack->CurrPtr = ScanStart
         ; IsValidVariableHeader (PtrTrack->CurrPtr, PtrTrack->EndPtr)
         ; PtrTrack->CurrPtr = GetNextVariablePtr (PtrTrack->CurrPtr, AuthFormat)
         )
@@ -88,6 +88,15 @@ FlushPendingRuntimeVariableCacheUpdates (
     VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = 0;
     VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
     *(VariableRuntimeCacheContext->PendingUpdate)                                 = FALSE;
+
+    //
+    // Tell the runtime driver to rebuild the index of its caches.
+    //
+    if (VariableRuntimeCacheContext->PendingReclaim && (VariableRuntimeCacheContext->ReclaimCount != NULL)) {
+      (*(VariableRuntimeCacheContext->ReclaimCount))++;
+    }
+
+    VariableRuntimeCacheContext->PendingReclaim = FALSE;
   }
 
   return EFI_SUCCESS;
@@ -33,6 +33,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "Variable.h"
 #include "VariableParsing.h"
 #include "VariableRuntimeCache.h"
+#include "VariableWriteBatch.h"
 
 extern VARIABLE_STORE_HEADER  *mNvVariableCache;
 
@@ -710,11 +711,13 @@ SmmVariableHandler (
         InitializeVariableQuota ();
       }
 
+      VariableWriteBatchEndForOs ();
       ReclaimForOS ();
       Status = EFI_SUCCESS;
       break;
 
     case SMM_VARIABLE_FUNCTION_EXIT_BOOT_SERVICE:
+      ASSERT (!VariableWriteBatchIsActive ());
       mAtRuntime = TRUE;
       Status     = EFI_SUCCESS;
       break;
@@ -924,6 +927,17 @@ SmmVariableHandler (
         goto EXIT;
       }
 
+      if ((RuntimeVariableCacheContext->ReclaimCount != NULL) &&
+          !VariableSmmIsBufferOutsideSmmValid (
+             (UINTN)RuntimeVariableCacheContext->ReclaimCount,
+             sizeof (*(RuntimeVariableCacheContext->ReclaimCount))
+             ))
+      {
+        DEBUG ((DEBUG_ERROR, "InitRuntimeVariableCacheContext: Runtime cache reclaim count buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
       VariableCacheContext                                     = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
       VariableCacheContext->VariableRuntimeHobCache.Store      = RuntimeVariableCacheContext->RuntimeHobCache;
       VariableCacheContext->VariableRuntimeVolatileCache.Store = RuntimeVariableCacheContext->RuntimeVolatileCache;
@@ -931,6 +945,7 @@ SmmVariableHandler (
       VariableCacheContext->PendingUpdate                      = RuntimeVariableCacheContext->PendingUpdate;
       VariableCacheContext->ReadLock                           = RuntimeVariableCacheContext->ReadLock;
       VariableCacheContext->HobFlushComplete                   = RuntimeVariableCacheContext->HobFlushComplete;
+      VariableCacheContext->ReclaimCount                       = RuntimeVariableCacheContext->ReclaimCount;
 
       // Set up the intial pending request since the RT cache needs to be in sync with SMM cache
       VariableCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
@@ -962,6 +977,12 @@ SmmVariableHandler (
     case SMM_VARIABLE_FUNCTION_SYNC_RUNTIME_CACHE:
       Status = FlushPendingRuntimeVariableCacheUpdates ();
       break;
+    case SMM_VARIABLE_FUNCTION_BEGIN_WRITE_BATCH:
+      Status = VariableWriteBatchBegin (NULL);
+      break;
+    case SMM_VARIABLE_FUNCTION_COMMIT_WRITE_BATCH:
+      Status = VariableWriteBatchCommit (NULL);
+      break;
     case SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO:
       if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO)) {
         DEBUG ((DEBUG_ERROR, "GetRuntimeCacheInfo: SMM communication buffer size invalid!\n"));
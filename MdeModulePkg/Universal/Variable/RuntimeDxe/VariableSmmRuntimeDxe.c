@@ -25,6 +25,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/SmmVariable.h>
 #include <Protocol/VariableLock.h>
 #include <Protocol/VarCheck.h>
+#include <Protocol/VariableWriteBatch.h>
 
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
@@ -42,6 +43,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "PrivilegePolymorphic.h"
 #include "VariableParsing.h"
+#include "VariableIndex.h"
 
 EFI_HANDLE                      mHandle                              = NULL;
 EFI_SMM_VARIABLE_PROTOCOL       *mSmmVariable                        = NULL;
@@ -62,10 +64,14 @@ BOOLEAN                         mVariableRuntimeCachePendingUpdate;
 BOOLEAN                         mVariableRuntimeCacheReadLock;
 BOOLEAN                         mVariableAuthFormat;
 BOOLEAN                         mHobFlushComplete;
+UINT32                          mVariableRuntimeCacheReclaimCount;
+UINT32                          mVariableIndexReclaimCount;
 EFI_LOCK                        mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL    mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL        mVarCheck;
 
+EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  mVariableWriteBatch;
+
 /**
   The logic to initialize the VariablePolicy engine is in its own file.
 
@@ -537,6 +543,78 @@ Done:
   return Status;
 }
 
+/**
+  Sends a write batch request to SMM.
+
+  @param[in] Function  SMM_VARIABLE_FUNCTION_BEGIN_WRITE_BATCH or
+                       SMM_VARIABLE_FUNCTION_COMMIT_WRITE_BATCH.
+
+  @return The status returned by the SMM variable driver.
+
+**/
+EFI_STATUS
+SendWriteBatchRequest (
+  IN UINTN  Function
+  )
+{
+  EFI_STATUS  Status;
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+
+  //
+  // Init the communicate buffer. The buffer data size is:
+  // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE.
+  //
+  Status = InitCommunicateBuffer (NULL, 0, Function);
+  if (!EFI_ERROR (Status)) {
+    //
+    // Send data to SMM.
+    //
+    Status = SendCommunicateBuffer (0);
+  }
+
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+  return Status;
+}
+
+/**
+  Start staging the updates of non-volatile variables in memory.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS          The batch was started.
+  @retval EFI_ALREADY_STARTED  A batch is already started.
+  @retval EFI_UNSUPPORTED      EFI_EVENT_GROUP_READY_TO_BOOT has already been signaled,
+                               or the non-volatile variables are not stored in flash.
+**/
+EFI_STATUS
+EFIAPI
+VariableWriteBatchBegin (
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  )
+{
+  return SendWriteBatchRequest (SMM_VARIABLE_FUNCTION_BEGIN_WRITE_BATCH);
+}
+
+/**
+  Write the updates staged since Begin() to flash and end the batch.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS      The updates were written to flash.
+  @retval EFI_NOT_STARTED  No batch is started.
+  @retval Others           Writing to flash failed. The batch is ended and the
+                           variables hold the content of the flash.
+**/
+EFI_STATUS
+EFIAPI
+VariableWriteBatchCommit (
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  )
+{
+  return SendWriteBatchRequest (SMM_VARIABLE_FUNCTION_COMMIT_WRITE_BATCH);
+}
+
 /**
   Signals SMM to synchronize any pending variable updates with the runtime cache(s).
 
@@ -576,10 +654,19 @@ CheckForRuntimeCacheSync (
 
   ASSERT (!mVariableRuntimeCachePendingUpdate);
 
+  //
+  // A reclaim in SMM has moved the variables of the caches
+  //
+  if (mVariableIndexReclaimCount != mVariableRuntimeCacheReclaimCount) {
+    VariableIndexInvalidate (NULL);
+    mVariableIndexReclaimCount = mVariableRuntimeCacheReclaimCount;
+  }
+
   //
   // The HOB variable data may have finished being flushed in the runtime cache sync update
   //
   if (mHobFlushComplete && (mVariableRuntimeHobCacheBuffer != NULL)) {
+    VariableIndexUnregister (mVariableRuntimeHobCacheBuffer);
     if (!EfiAtRuntime ()) {
       FreePages (mVariableRuntimeHobCacheBuffer, EFI_SIZE_TO_PAGES (mVariableRuntimeHobCacheBufferSize));
     }
@@ -1361,6 +1448,7 @@ VariableAddressChangeEvent (
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableRuntimeHobCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableRuntimeNvCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableRuntimeVolatileCacheBuffer);
+  VariableIndexConvertPointers (EfiConvertPointer);
 }
 
 /**
@@ -1570,6 +1658,7 @@ SendRuntimeVariableCacheContextToSmm (
   SmmRuntimeVarCacheContext->PendingUpdate        = &mVariableRuntimeCachePendingUpdate;
   SmmRuntimeVarCacheContext->ReadLock             = &mVariableRuntimeCacheReadLock;
   SmmRuntimeVarCacheContext->HobFlushComplete     = &mHobFlushComplete;
+  SmmRuntimeVarCacheContext->ReclaimCount         = &mVariableRuntimeCacheReclaimCount;
 
   //
   // Request to unblock this region to be accessible from inside MM environment
@@ -1599,6 +1688,14 @@ SendRuntimeVariableCacheContextToSmm (
     goto Done;
   }
 
+  Status = MmUnblockMemoryRequest (
+             (EFI_PHYSICAL_ADDRESS)ALIGN_VALUE ((UINTN)SmmRuntimeVarCacheContext->ReclaimCount - EFI_PAGE_SIZE + 1, EFI_PAGE_SIZE),
+             EFI_SIZE_TO_PAGES (sizeof (mVariableRuntimeCacheReclaimCount))
+             );
+  if ((Status != EFI_UNSUPPORTED) && EFI_ERROR (Status)) {
+    goto Done;
+  }
+
   //
   // Send data to SMM.
   //
@@ -1678,6 +1775,11 @@ SmmVariableReady (
             Status = SendRuntimeVariableCacheContextToSmm ();
             if (!EFI_ERROR (Status)) {
               SyncRuntimeCache ();
+              VariableIndexRegister (mVariableRuntimeVolatileCacheBuffer, mVariableAuthFormat);
+              VariableIndexRegister (mVariableRuntimeNvCacheBuffer, mVariableAuthFormat);
+              if (mVariableRuntimeHobCacheBuffer != NULL) {
+                VariableIndexRegister (mVariableRuntimeHobCacheBuffer, mVariableAuthFormat);
+              }
             }
           }
         }
@@ -1773,6 +1875,16 @@ SmmVariableWriteReady (
                   );
   ASSERT_EFI_ERROR (Status);
 
+  mVariableWriteBatch.Begin  = VariableWriteBatchBegin;
+  mVariableWriteBatch.Commit = VariableWriteBatchCommit;
+  Status                     = gBS->InstallMultipleProtocolInterfaces (
+                                      &mHandle,
+                                      &gEdkiiVariableWriteBatchProtocolGuid,
+                                      &mVariableWriteBatch,
+                                      NULL
+                                      );
+  ASSERT_EFI_ERROR (Status);
+
   gBS->CloseEvent (Event);
 }
 
@@ -0,0 +1,389 @@
+/** @file
+  Write batches of non-volatile variable updates.
+
+  UpdateVariable() keeps the NV variable cache (mNvVariableCache) identical to
+  the flash. While a write batch is open, UpdateVariableStore() does not write
+  the flash for non-volatile variables, so the cache alone holds the updates.
+  VariableWriteBatchFlush() then writes the difference between the cache and
+  the flash in the order UpdateVariable() uses for a single variable:
+
+  1. The variables appended since the last flush, in a single write, with the
+     visible ones still marked as not fully written.
+  2. The variables deleted or replaced since the last flush are marked
+     VAR_IN_DELETED_TRANSITION.
+  3. The appended variables are marked valid.
+  4. The variables deleted or replaced since the last flush are marked
+     deleted, and the other bytes updated in place are written.
+
+  A power failure at any point leaves each variable either updated or as it
+  was before the batch.
+
+  Caution: This module requires additional review when modified.
+  This driver will have external input - variable data. They may be input in SMM mode.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableParsing.h"
+#include "VariableRuntimeCache.h"
+#include "VariableWriteBatch.h"
+
+///
+/// State bit that is cleared when a variable becomes valid (VAR_ADDED).
+///
+#define VARIABLE_WRITE_BATCH_ADDED_BIT  ((UINT8)(VAR_HEADER_VALID_ONLY & ~VAR_ADDED))
+
+BOOLEAN  mVariableWriteBatchActive   = FALSE;
+BOOLEAN  mVariableWriteBatchDisabled = FALSE;
+
+/**
+  Checks whether non-volatile variable updates are staged in the NV variable
+  cache instead of being written to flash.
+
+  @retval TRUE   A write batch is open.
+  @retval FALSE  No write batch is open.
+
+**/
+BOOLEAN
+VariableWriteBatchIsActive (
+  VOID
+  )
+{
+  return mVariableWriteBatchActive;
+}
+
+/**
+  Checks whether a variable state makes the variable visible.
+
+  @param[in] State  State of the variable.
+
+  @retval TRUE   The variable is added, possibly in delete transition.
+  @retval FALSE  The variable is not fully written or is deleted.
+
+**/
+STATIC
+BOOLEAN
+IsVisibleVariableState (
+  IN UINT8  State
+  )
+{
+  return (BOOLEAN)((State == VAR_ADDED) || (State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)));
+}
+
+/**
+  Writes part of the NV variable cache to flash.
+
+  @param[in] Buffer  Start of the part, in the NV variable cache.
+  @param[in] Size    Size of the part.
+
+  @return The status of UpdateVariableStore().
+
+**/
+STATIC
+EFI_STATUS
+WriteNvVariableCache (
+  IN VOID   *Buffer,
+  IN UINTN  Size
+  )
+{
+  return UpdateVariableStore (
+           &mVariableModuleGlobal->VariableGlobal,
+           FALSE,
+           TRUE,
+           mVariableModuleGlobal->FvbInstance,
+           (UINTN)Buffer - (UINTN)mNvVariableCache,
+           (UINT32)Size,
+           (UINT8 *)Buffer
+           );
+}
+
+/**
+  Writes the updated bytes of a variable that was already in flash.
+
+  @param[in] Variable       The variable in the NV variable cache.
+  @param[in] FlashVariable  The same variable in flash.
+  @param[in] Size           Size of the variable.
+
+  @return The status of UpdateVariableStore().
+
+**/
+STATIC
+EFI_STATUS
+WriteUpdatedBytes (
+  IN VARIABLE_HEADER  *Variable,
+  IN VARIABLE_HEADER  *FlashVariable,
+  IN UINTN            Size
+  )
+{
+  UINT8  *Cache;
+  UINT8  *Flash;
+  UINTN  First;
+  UINTN  Last;
+
+  Cache = (UINT8 *)Variable;
+  Flash = (UINT8 *)FlashVariable;
+  for (First = 0; First < Size && Cache[First] == Flash[First]; First++) {
+  }
+
+  if (First == Size) {
+    return EFI_SUCCESS;
+  }
+
+  for (Last = Size - 1; Cache[Last] == Flash[Last]; Last--) {
+  }
+
+  return WriteNvVariableCache (Cache + First, Last - First + 1);
+}
+
+/**
+  Writes the updates staged in the NV variable cache to flash.
+
+  @retval EFI_SUCCESS  The flash holds the content of the NV variable cache.
+  @retval Others       Writing to flash failed.
+
+**/
+STATIC
+EFI_STATUS
+WriteStagedVariables (
+  VOID
+  )
+{
+  EFI_STATUS       Status;
+  BOOLEAN          AuthFormat;
+  UINTN            FlashBase;
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  VARIABLE_HEADER  *FlashVariable;
+  VARIABLE_HEADER  *AppendStart;
+  VARIABLE_HEADER  *AppendEnd;
+  UINT8            State;
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  FlashBase  = (UINTN)mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase;
+  AppendEnd  = (VARIABLE_HEADER *)((UINTN)mNvVariableCache + mVariableModuleGlobal->NonVolatileLastVariableOffset);
+
+  //
+  // The flash is erased past the variables it holds, so the appended
+  // variables start at the first one that has no header in flash.
+  //
+  AppendStart = GetStartPointer (mNvVariableCache);
+  while (IsValidVariableHeader (AppendStart, AppendEnd)) {
+    FlashVariable = (VARIABLE_HEADER *)(FlashBase + ((UINTN)AppendStart - (UINTN)mNvVariableCache));
+    if (FlashVariable->StartId != VARIABLE_DATA) {
+      break;
+    }
+
+    AppendStart = GetNextVariablePtr (AppendStart, AuthFormat);
+  }
+
+  //
+  // Step 1: Write the appended variables with the visible ones not marked
+  // valid yet.
+  //
+  if (AppendStart < AppendEnd) {
+    for (Variable = AppendStart; IsValidVariableHeader (Variable, AppendEnd); Variable = GetNextVariablePtr (Variable, AuthFormat)) {
+      if (IsVisibleVariableState (Variable->State)) {
+        Variable->State |= VARIABLE_WRITE_BATCH_ADDED_BIT;
+      }
+    }
+
+    Status = WriteNvVariableCache (AppendStart, (UINTN)AppendEnd - (UINTN)AppendStart);
+
+    //
+    // The cache never holds variables that are not fully written, so every
+    // variable whose state is visible without the bit had it cleared.
+    //
+    for (Variable = AppendStart; IsValidVariableHeader (Variable, AppendEnd); Variable = GetNextVariablePtr (Variable, AuthFormat)) {
+      if (IsVisibleVariableState ((UINT8)(Variable->State & ~VARIABLE_WRITE_BATCH_ADDED_BIT))) {
+        Variable->State &= (UINT8)~VARIABLE_WRITE_BATCH_ADDED_BIT;
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  //
+  // Step 2: Mark the deleted or replaced variables in delete transition. They
+  // stay visible until the variables replacing them are valid.
+  //
+  for (Variable = GetStartPointer (mNvVariableCache); Variable < AppendStart; Variable = GetNextVariablePtr (Variable, AuthFormat)) {
+    FlashVariable = (VARIABLE_HEADER *)(FlashBase + ((UINTN)Variable - (UINTN)mNvVariableCache));
+    State         = FlashVariable->State & VAR_IN_DELETED_TRANSITION;
+    if ((Variable->State != FlashVariable->State) && (State != FlashVariable->State)) {
+      Status = UpdateVariableStore (
+                 &mVariableModuleGlobal->VariableGlobal,
+                 FALSE,
+                 FALSE,
+                 mVariableModuleGlobal->FvbInstance,
+                 (UINTN)&FlashVariable->State,
+                 sizeof (UINT8),
+                 &State
+                 );
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+  }
+
+  //
+  // Step 3: Mark the appended variables valid.
+  //
+  for (Variable = AppendStart; IsValidVariableHeader (Variable, AppendEnd); Variable = GetNextVariablePtr (Variable, AuthFormat)) {
+    if (IsVisibleVariableState (Variable->State)) {
+      Status = WriteNvVariableCache (&Variable->State, sizeof (UINT8));
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+  }
+
+  //
+  // Step 4: Mark the deleted or replaced variables deleted, and write the
+  // bytes updated in place. The state in flash may have more bits cleared
+  // than in the cache after step 2, and the cache follows the flash.
+  //
+  for (Variable = GetStartPointer (mNvVariableCache); Variable < AppendStart; Variable = NextVariable) {
+    NextVariable    = GetNextVariablePtr (Variable, AuthFormat);
+    FlashVariable   = (VARIABLE_HEADER *)(FlashBase + ((UINTN)Variable - (UINTN)mNvVariableCache));
+    Variable->State = Variable->State & FlashVariable->State;
+    Status          = WriteUpdatedBytes (Variable, FlashVariable, (UINTN)NextVariable - (UINTN)Variable);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Writes the updates staged in the NV variable cache to flash. The write batch
+  stays open if it succeeds.
+
+  The caller must hold the variable services lock.
+
+  @retval EFI_SUCCESS  The flash holds the content of the NV variable cache.
+  @retval Others       Writing to flash failed. The write batch is ended and
+                       the NV variable cache is reloaded from flash.
+
+**/
+EFI_STATUS
+VariableWriteBatchFlush (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if (!mVariableWriteBatchActive) {
+    return EFI_SUCCESS;
+  }
+
+  mVariableWriteBatchActive = FALSE;
+  Status                    = WriteStagedVariables ();
+  if (EFI_ERROR (Status)) {
+    //
+    // The cache no longer matches the flash. Reclaim rebuilds the store, the
+    // cache and the runtime cache from the variables that did reach the flash,
+    // and reloads the cache from flash even if it fails.
+    //
+    DEBUG ((DEBUG_ERROR, "Variable: Write batch flush failed - %r\n", Status));
+    Reclaim (
+      mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
+      &mVariableModuleGlobal->NonVolatileLastVariableOffset,
+      FALSE,
+      NULL,
+      NULL,
+      0
+      );
+    return Status;
+  }
+
+  mVariableWriteBatchActive = TRUE;
+  return SynchronizeRuntimeVariableCache (
+           &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
+           0,
+           mNvVariableCache->Size
+           );
+}
+
+/**
+  Commits the open write batch, if any, and refuses new ones. Called when
+  EFI_EVENT_GROUP_READY_TO_BOOT is signaled, so that no update is left
+  staged when FTW can no longer be used at ExitBootServices.
+
+**/
+VOID
+VariableWriteBatchEndForOs (
+  VOID
+  )
+{
+  VariableWriteBatchCommit (NULL);
+  mVariableWriteBatchDisabled = TRUE;
+}
+
+/**
+  Start staging the updates of non-volatile variables in memory.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS          The batch was started.
+  @retval EFI_ALREADY_STARTED  A batch is already started.
+  @retval EFI_UNSUPPORTED      EFI_EVENT_GROUP_READY_TO_BOOT has already been signaled,
+                               or the non-volatile variables are not stored in flash.
+**/
+EFI_STATUS
+EFIAPI
+VariableWriteBatchBegin (
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  )
+{
+  EFI_STATUS  Status;
+
+  if (mVariableWriteBatchDisabled || AtRuntime () || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
+    return EFI_UNSUPPORTED;
+  }
+
+  AcquireLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
+  if (mVariableWriteBatchActive) {
+    Status = EFI_ALREADY_STARTED;
+  } else {
+    mVariableWriteBatchActive = TRUE;
+    Status                    = EFI_SUCCESS;
+  }
+
+  ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
+  return Status;
+}
+
+/**
+  Write the updates staged since Begin() to flash and end the batch.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS      The updates were written to flash.
+  @retval EFI_NOT_STARTED  No batch is started.
+  @retval Others           Writing to flash failed. The batch is ended and the
+                           variables hold the content of the flash.
+**/
+EFI_STATUS
+EFIAPI
+VariableWriteBatchCommit (
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  )
+{
+  EFI_STATUS  Status;
+
+  AcquireLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
+  if (!mVariableWriteBatchActive) {
+    Status = EFI_NOT_STARTED;
+  } else {
+    Status                    = VariableWriteBatchFlush ();
+    mVariableWriteBatchActive = FALSE;
+  }
+
+  ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
+  return Status;
+}
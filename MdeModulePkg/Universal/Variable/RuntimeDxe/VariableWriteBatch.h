@@ -0,0 +1,89 @@
+/** @file
+  Write batches of non-volatile variable updates, shared by the DXE_RUNTIME
+  variable module and the SMM variable module.
+
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VARIABLE_WRITE_BATCH_H_
+#define _VARIABLE_WRITE_BATCH_H_
+
+#include "Variable.h"
+
+#include <Protocol/VariableWriteBatch.h>
+
+/**
+  Checks whether non-volatile variable updates are staged in the NV variable
+  cache instead of being written to flash.
+
+  @retval TRUE   A write batch is open.
+  @retval FALSE  No write batch is open.
+
+**/
+BOOLEAN
+VariableWriteBatchIsActive (
+  VOID
+  );
+
+/**
+  Writes the updates staged in the NV variable cache to flash. The write batch
+  stays open if it succeeds.
+
+  The caller must hold the variable services lock.
+
+  @retval EFI_SUCCESS  The flash holds the content of the NV variable cache.
+  @retval Others       Writing to flash failed. The write batch is ended and
+                       the NV variable cache is reloaded from flash.
+
+**/
+EFI_STATUS
+VariableWriteBatchFlush (
+  VOID
+  );
+
+/**
+  Commits the open write batch, if any, and refuses new ones. Called when
+  EFI_EVENT_GROUP_READY_TO_BOOT is signaled, so that no update is left
+  staged when FTW can no longer be used at ExitBootServices.
+
+**/
+VOID
+VariableWriteBatchEndForOs (
+  VOID
+  );
+
+/**
+  Start staging the updates of non-volatile variables in memory.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS          The batch was started.
+  @retval EFI_ALREADY_STARTED  A batch is already started.
+  @retval EFI_UNSUPPORTED      EFI_EVENT_GROUP_READY_TO_BOOT has already been signaled,
+                               or the non-volatile variables are not stored in flash.
+**/
+EFI_STATUS
+EFIAPI
+VariableWriteBatchBegin (
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  );
+
+/**
+  Write the updates staged since Begin() to flash and end the batch.
+
+  @param[in] This  The EDKII_VARIABLE_WRITE_BATCH_PROTOCOL instance.
+
+  @retval EFI_SUCCESS      The updates were written to flash.
+  @retval EFI_NOT_STARTED  No batch is started.
+  @retval Others           Writing to flash failed. The batch is ended and the
+                           variables hold the content of the flash.
+**/
+EFI_STATUS
+EFIAPI
+VariableWriteBatchCommit (
+  IN CONST EDKII_VARIABLE_WRITE_BATCH_PROTOCOL  *This
+  );
+
+#endif